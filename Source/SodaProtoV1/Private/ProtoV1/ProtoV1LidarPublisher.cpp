@@ -88,33 +88,40 @@ bool UProtoV1LidarPublisher::Publish(float DeltaTime, const FSensorDataHeader& H
 	Msg.device_timestamp = soda::RawTimestamp<std::chrono::milliseconds>(Header.Timestamp);
 	Msg.scan_id = ScanID++;
 	Msg.block_id = 0;
-	Msg.block_count = (Scan.Points.Num() / PointsPerDatagram) + ((Scan.Points.Num() % PointsPerDatagram) ? 1 : 0);
 
-	const bool bIsSizeOk = Scan.Size.IsSet() && Scan.Size->X > 0 && Scan.Size->Y > 0;
+	int PointsNum = 0;
+	Scan.ForEachReturn(ReturnMode, [&PointsNum](const soda::FLidarScanPoint&, int, int) { ++PointsNum; });
+	Msg.block_count = (PointsNum / PointsPerDatagram) + ((PointsNum % PointsPerDatagram) ? 1 : 0);
 
-	for (int k = 0; k < Scan.Points.Num(); )
+	Msg.points.clear();
+	Msg.points.reserve(FMath::Min(PointsNum, PointsPerDatagram));
+	Scan.ForEachReturn(ReturnMode, [&](const soda::FLidarScanPoint& Src, int Beam, int Echo)
 	{
-		int BlockSize = Scan.Points.Num() - k;
-		if (BlockSize > PointsPerDatagram) BlockSize = PointsPerDatagram;
+		soda::sim::proto_v1::LidarScanPoint& Dst = Msg.points.emplace_back();
+		Dst.coords.x = Src.Location.X / 100;
+		Dst.coords.y = -Src.Location.Y / 100;
+		Dst.coords.z = Src.Location.Z / 100;
+		Dst.layer = Scan.GetRing(Beam);
+		Dst.echo = Echo;
+		if (Scan.bIntensitieIsValid)
+		{
+			Dst.reflectivity = FMath::Clamp(FMath::RoundToInt(Src.Intensitie * soda::sim::proto_v1::LidarScanPoint::MaximumDiffuseReflectivity), 0, int(soda::sim::proto_v1::LidarScanPoint::MaximumDiffuseReflectivity));
+		}
+		Dst.properties = (Src.Status == soda::ELidarPointStatus::Valid
+			? soda::sim::proto_v1::LidarScanPoint::Properties::Valid
+			: soda::sim::proto_v1::LidarScanPoint::Properties::None);
 
-		Msg.points.resize(BlockSize);
-		for (int i = 0; i < BlockSize; ++i)
+		if (int(Msg.points.size()) == PointsPerDatagram)
 		{
-			auto& Src = Scan.Points[k + i];
-			auto& Dst = Msg.points[i];
-
-			Dst.coords.x = Src.Location.X / 100;
-			Dst.coords.y = -Src.Location.Y / 100;
-			Dst.coords.z = Src.Location.Z / 100;
-			Dst.layer = bIsSizeOk ? Scan.Points.Num() / Scan.Size->X : -1;
-			Dst.properties = (Src.Status == soda::ELidarPointStatus::Valid 
-				? soda::sim::proto_v1::LidarScanPoint::Properties::Valid 
-				: soda::sim::proto_v1::LidarScanPoint::Properties::None);
+			Publish(Msg);
+			Msg.points.clear();
+			++Msg.block_id;
 		}
-		
+	});
+
+	if (Msg.points.size())
+	{
 		Publish(Msg);
-		k += BlockSize;
-		++Msg.block_id;
 	}
 	return true;
 }
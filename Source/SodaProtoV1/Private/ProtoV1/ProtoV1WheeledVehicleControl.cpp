@@ -10,6 +10,8 @@
 
 bool UProtoV1WheeledVehicleControl::StartListen(UVehicleBaseComponent* Parent)
 {
+	ResetMailbox();
+
 	FIPv4Endpoint Endpoint(FIPv4Address(0, 0, 0, 0), RecvPort);
 	ListenSocket = FUdpSocketBuilder(TEXT("UProtoV1WheeledVehicleControl"))
 		.AsNonBlocking()
@@ -45,19 +47,17 @@ void UProtoV1WheeledVehicleControl::StopListen()
 
 void UProtoV1WheeledVehicleControl::Recv(const FArrayReaderPtr& ArrayReaderPtr, const FIPv4Endpoint& EndPt)
 {
-	if (ArrayReaderPtr->Num() == sizeof(Msg))
-	{
-		::memcpy(&Msg, ArrayReaderPtr->GetData(), ArrayReaderPtr->Num());
-		RecvTimestamp = SodaApp.GetRealtimeTimestamp();
-	}
-	else
+	soda::sim::proto_v1::GenericVehicleControlMode1 Msg;
+
+	if (ArrayReaderPtr->Num() != sizeof(Msg))
 	{
 		UE_LOG(LogSoda, Error, TEXT("UProtoV1WheeledVehicleControl::Recv(); Got %i bytes, expected %i"), ArrayReaderPtr->Num(), sizeof(Msg));
+		return;
 	}
-}
 
-bool UProtoV1WheeledVehicleControl::GetControl(soda::FGenericWheeledVehiclControl& Control) const
-{
+	::memcpy(&Msg, ArrayReaderPtr->GetData(), ArrayReaderPtr->Num());
+
+	soda::FGenericWheeledVehiclControl Control;
 	Control.SteerReq.ByRatio = -Msg.steer_req.by_ratio;
 	Control.DriveEffortReq.ByRatio = Msg.drive_effort_req.by_ratio;
 	Control.TargetSpeedReq = Msg.target_speed_req * 100.0;
@@ -69,14 +69,14 @@ bool UProtoV1WheeledVehicleControl::GetControl(soda::FGenericWheeledVehiclContro
 	Control.bSteeringAngleVelocitySet = false;
 	Control.SteerReqMode = soda::FGenericWheeledVehiclControl::ESteerReqMode(Msg.steer_req_mode);
 	Control.DriveEffortReqMode = soda::FGenericWheeledVehiclControl::EDriveEffortReqMode(Msg.drive_effort_req_mode);
-	Control.Timestamp = RecvTimestamp;
 
 	if (Control.DriveEffortReqMode == soda::FGenericWheeledVehiclControl::EDriveEffortReqMode::ByAcc)
 	{
 		Control.DriveEffortReq.ByAcc *= 100;
 	}
 
-	return true;
+	// GenericVehicleControlMode1 doesn't carry the sender timestamp
+	PushControl(Control);
 }
 
 FString UProtoV1WheeledVehicleControl::GetRemark() const
@@ -90,22 +90,31 @@ void UProtoV1WheeledVehicleControl::DrawDebug(UCanvas* Canvas, float& YL, float&
 
 	UFont* RenderFont = GEngine->GetSmallFont();
 
-	const uint64 dt = std::chrono::duration_cast<std::chrono::milliseconds>(SodaApp.GetRealtimeTimestamp() - RecvTimestamp).count();
+	soda::TControlMailbox<soda::FGenericWheeledVehiclControl>::FLetter Letter;
+	if (!Mailbox.Read(Letter))
+	{
+		Canvas->SetDrawColor(FColor::White);
+		YPos += Canvas->DrawText(RenderFont, TEXT("dtime: no data"), 16, YPos);
+		return;
+	}
+
+	const soda::FGenericWheeledVehiclControl& Control = Letter.Value;
+	const uint64 dt = std::chrono::duration_cast<std::chrono::milliseconds>(soda::Now() - Letter.RecvTimestamp).count();
 
 	Canvas->SetDrawColor(FColor::White);
-	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("steer_req: %.2f"), Msg.steer_req.by_ratio), 16, YPos);
-	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("drive_effort_req: %.2f"), Msg.drive_effort_req.by_ratio), 16, YPos);
-	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("gear_state_req: %d"), (int)Msg.gear_state_req), 16, YPos);
-	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("gear_num_req: %d"), (int)Msg.gear_num_req), 16, YPos);
-	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("steer_req_mode: %d"), (int)Msg.steer_req_mode), 16, YPos);
-	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("drive_effort_req_mode: %d"), (int)Msg.drive_effort_req_mode), 16, YPos);
-
-	if (dt > 10000)
+	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("steer_req: %.2f"), -Control.SteerReq.ByRatio), 16, YPos);
+	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("drive_effort_req: %.2f"), Control.DriveEffortReq.ByRatio), 16, YPos);
+	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("gear_state_req: %d"), (int)Control.GearStateReq), 16, YPos);
+	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("gear_num_req: %d"), (int)Control.GearNumReq), 16, YPos);
+	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("steer_req_mode: %d"), (int)Control.SteerReqMode), 16, YPos);
+	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("drive_effort_req_mode: %d"), (int)Control.DriveEffortReqMode), 16, YPos);
+
+	if (IsControlTimeout())
 	{
-		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("dtime: timeout")), 16, YPos);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("dtime: timeout (%dms)"), dt), 16, YPos);
 	}
 	else
 	{
 		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("dtime: %dms"), dt), 16, YPos);
 	}
-}
\ No newline at end of file
+}
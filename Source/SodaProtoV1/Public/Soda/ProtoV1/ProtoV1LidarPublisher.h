@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Soda/GenericPublishers/GenericLidarPublisher.h"
+#include "Soda/VehicleComponents/Sensors/Base/LidarSensor.h"
 #include "soda/sim/proto-v1/lidar.hpp"
 #include "Soda/Misc/Time.h"
 #include "Soda/Misc/UDPAsyncTask.h"
@@ -46,6 +47,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Publisher, SaveGame, meta = (EditInRuntime))
 	int DeviceID = 0;
 
+	/** Echoes sent for the multi-return scans */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Publisher, SaveGame, meta = (EditInRuntime))
+	ELidarReturnMode ReturnMode = ELidarReturnMode::Strongest;
+
 public:
 	virtual bool Advertise(UVehicleBaseComponent* Parent) override;
 	virtual void Shutdown() override;
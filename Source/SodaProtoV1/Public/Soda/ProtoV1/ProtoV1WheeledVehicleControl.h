@@ -29,7 +29,6 @@ public:
 	virtual void StopListen() override;
 	virtual bool IsOk() const { return !!ListenSocket; }
 	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
-	virtual bool GetControl(soda::FGenericWheeledVehiclControl& Control) const override;
 	virtual FString GetRemark() const override;
 
 protected:
@@ -38,8 +37,6 @@ protected:
 protected:
 	FSocket* ListenSocket = nullptr;
 	FUdpSocketReceiver* UDPReceiver = nullptr;
-	soda::sim::proto_v1::GenericVehicleControlMode1 Msg;
-	TTimestamp RecvTimestamp;
 };
 
 
@@ -0,0 +1,420 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/Actors/ExternalOverlay.h"
+#include "Soda/UnrealSoda.h"
+#include "Soda/LevelState.h"
+#include "Common/UdpSocketBuilder.h"
+#include "Components/LineBatchComponent.h"
+#include "Components/TextRenderComponent.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+DECLARE_STATS_GROUP(TEXT("ExternalOverlay"), STATGROUP_ExternalOverlay, STATGROUP_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Parse message"), STAT_ParseMessage, STATGROUP_ExternalOverlay);
+DECLARE_CYCLE_STAT(TEXT("Build layer"), STAT_BuildLayer, STATGROUP_ExternalOverlay);
+
+static const int MaxFragments = 1024;
+
+namespace soda
+{
+namespace overlay
+{
+
+class FReader
+{
+public:
+	FReader(const uint8* InData, int InSize) : Data(InData), Size(InSize) {}
+
+	template <typename T>
+	bool Read(T& Out)
+	{
+		if (Pos + int(sizeof(T)) > Size) return false;
+		FMemory::Memcpy(&Out, Data + Pos, sizeof(T));
+		Pos += sizeof(T);
+		return true;
+	}
+
+	bool CanRead(uint64 Bytes) const
+	{
+		return uint64(Pos) + Bytes <= uint64(Size);
+	}
+
+	bool ReadVectors(TArray<FVector>& Out, uint32 Num)
+	{
+		if (!CanRead(uint64(Num) * 3 * sizeof(double))) return false;
+		Out.SetNumUninitialized(Num);
+		for (uint32 i = 0; i < Num; ++i)
+		{
+			double V[3];
+			FMemory::Memcpy(V, Data + Pos, sizeof(V));
+			Pos += sizeof(V);
+			Out[i] = FVector(V[0], V[1], V[2]);
+		}
+		return true;
+	}
+
+	bool ReadString(FString& Out, uint32 Len)
+	{
+		if (uint64(Pos) + Len > uint64(Size)) return false;
+		FUTF8ToTCHAR Converter((const ANSICHAR*)(Data + Pos), Len);
+		Out = FString(Converter.Length(), Converter.Get());
+		Pos += Len;
+		return true;
+	}
+
+private:
+	const uint8* Data;
+	int Size;
+	int Pos = 0;
+};
+
+bool FMessage::Parse(const uint8* Data, int Size)
+{
+	Primitives.Reset();
+
+	FReader Reader(Data, Size);
+	uint32 PrimitiveNum;
+	if (!Reader.Read(PrimitiveNum))
+	{
+		return false;
+	}
+
+	for (uint32 i = 0; i < PrimitiveNum; ++i)
+	{
+		uint8 Type, Flags;
+		uint16 Reserved;
+		uint8 Color[4];
+		float PrimitiveSize;
+		uint32 Count;
+		if (!Reader.Read(Type) || !Reader.Read(Flags) || !Reader.Read(Reserved) || !Reader.Read(Color) || !Reader.Read(PrimitiveSize) || !Reader.Read(Count))
+		{
+			return false;
+		}
+		if (Type > uint8(EPrimitiveType::Text))
+		{
+			return false;
+		}
+
+		FPrimitive& Primitive = Primitives.AddDefaulted_GetRef();
+		Primitive.Type = EPrimitiveType(Type);
+		Primitive.Flags = Flags;
+		Primitive.Color = FColor(Color[0], Color[1], Color[2], Color[3]);
+		Primitive.Size = PrimitiveSize;
+
+		switch (Primitive.Type)
+		{
+		case EPrimitiveType::Polyline:
+		case EPrimitiveType::Points:
+			if (!Reader.ReadVectors(Primitive.Vertices, Count)) return false;
+			break;
+
+		case EPrimitiveType::Boxes:
+			if (!Reader.CanRead(uint64(Count) * 7 * sizeof(double))) return false;
+			Primitive.Vertices.SetNum(Count);
+			Primitive.Extents.SetNum(Count);
+			Primitive.Yaws.SetNum(Count);
+			for (uint32 k = 0; k < Count; ++k)
+			{
+				double Box[7];
+				if (!Reader.Read(Box)) return false;
+				Primitive.Vertices[k] = FVector(Box[0], Box[1], Box[2]);
+				Primitive.Extents[k] = FVector(Box[3], Box[4], Box[5]);
+				Primitive.Yaws[k] = Box[6];
+			}
+			break;
+
+		case EPrimitiveType::Text:
+			if (!Reader.ReadVectors(Primitive.Vertices, 1) || !Reader.ReadString(Primitive.Text, Count)) return false;
+			break;
+		}
+	}
+
+	return true;
+}
+
+} // namespace overlay
+} // namespace soda
+
+AExternalOverlay::AExternalOverlay()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bTickEvenWhenPaused = true;
+
+	RootComponent = CreateDefaultSubobject< USceneComponent >(TEXT("RootComponent"));
+}
+
+void AExternalOverlay::BeginPlay()
+{
+	Super::BeginPlay();
+
+	FIPv4Endpoint Endpoint(FIPv4Address(0, 0, 0, 0), Port);
+
+	ListenSocket = FUdpSocketBuilder(TEXT("ExternalOverlay"))
+		.AsNonBlocking()
+		.AsReusable()
+		.BoundToEndpoint(Endpoint)
+		.WithReceiveBufferSize(0xFFFFF);
+
+	if (ListenSocket == nullptr)
+	{
+		UE_LOG(LogSoda, Error, TEXT("AExternalOverlay::BeginPlay() Can't create socket"));
+		return;
+	}
+
+	UDPReceiver = new FUdpSocketReceiver(ListenSocket, FTimespan::FromMilliseconds(100), TEXT("ExternalOverlay"));
+	UDPReceiver->OnDataReceived().BindUObject(this, &AExternalOverlay::Recv);
+	UDPReceiver->Start();
+}
+
+void AExternalOverlay::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	if (UDPReceiver)
+	{
+		UDPReceiver->Stop();
+		delete UDPReceiver;
+		UDPReceiver = nullptr;
+	}
+
+	if (ListenSocket)
+	{
+		ListenSocket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(ListenSocket);
+		ListenSocket = nullptr;
+	}
+
+	ClearAllLayers();
+}
+
+AExternalOverlay::FLayerBuffer& AExternalOverlay::FindOrAddLayerBuffer(uint16 Layer)
+{
+	FScopeLock ScopeLock(&LayersLock);
+	TUniquePtr<FLayerBuffer>& Buffer = LayerBuffers.FindOrAdd(Layer);
+	if (!Buffer)
+	{
+		Buffer = MakeUnique<FLayerBuffer>();
+	}
+	return *Buffer;
+}
+
+void AExternalOverlay::Recv(const FArrayReaderPtr& ArrayReaderPtr, const FIPv4Endpoint& EndPt)
+{
+	const uint8* Data = ArrayReaderPtr->GetData();
+	const int Size = ArrayReaderPtr->Num();
+
+	soda::overlay::FHeader Header;
+	if (Size < int(sizeof(Header)))
+	{
+		return;
+	}
+	FMemory::Memcpy(&Header, Data, sizeof(Header));
+	if (Header.Magic != soda::overlay::Magic || Header.Version != soda::overlay::Version ||
+		Header.FragmentCount == 0 || Header.FragmentCount > MaxFragments || Header.FragmentIndex >= Header.FragmentCount)
+	{
+		return;
+	}
+
+	FLayerBuffer& Buffer = FindOrAddLayerBuffer(Header.Layer);
+
+	const uint8* Payload = Data + sizeof(Header);
+	const int PayloadSize = Size - sizeof(Header);
+
+	if (Header.FragmentCount > 1)
+	{
+		// Fragments of the older message are dropped as soon as the fragment of a new message is received
+		if (Buffer.Sequence != Header.Sequence || Buffer.Fragments.Num() != Header.FragmentCount)
+		{
+			Buffer.Sequence = Header.Sequence;
+			Buffer.ReceivedFragments = 0;
+			Buffer.Fragments.Reset();
+			Buffer.Fragments.SetNum(Header.FragmentCount);
+		}
+
+		TArray<uint8>& Fragment = Buffer.Fragments[Header.FragmentIndex];
+		if (Fragment.Num() == 0)
+		{
+			Fragment.Append(Payload, PayloadSize);
+			++Buffer.ReceivedFragments;
+		}
+		if (Buffer.ReceivedFragments < Header.FragmentCount)
+		{
+			return;
+		}
+
+		TArray<uint8> Message;
+		for (const TArray<uint8>& It : Buffer.Fragments)
+		{
+			Message.Append(It);
+		}
+		Buffer.Fragments.Reset();
+		Buffer.ReceivedFragments = 0;
+
+		SCOPE_CYCLE_COUNTER(STAT_ParseMessage);
+		soda::overlay::FMessage& Out = Buffer.Messages.GetWriteBuffer();
+		Out.Sequence = Header.Sequence;
+		if (Out.Parse(Message.GetData(), Message.Num()))
+		{
+			Buffer.Messages.SwapWriteBuffers();
+		}
+	}
+	else
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ParseMessage);
+		soda::overlay::FMessage& Out = Buffer.Messages.GetWriteBuffer();
+		Out.Sequence = Header.Sequence;
+		if (Out.Parse(Payload, PayloadSize))
+		{
+			Buffer.Messages.SwapWriteBuffers();
+		}
+	}
+}
+
+void AExternalOverlay::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	FScopeLock ScopeLock(&LayersLock);
+	for (auto& [Layer, Buffer] : LayerBuffers)
+	{
+		if (Buffer->Messages.IsDirty())
+		{
+			Buffer->Messages.SwapReadBuffers();
+			BuildLayerView(LayerViews.FindOrAdd(Layer), Buffer->Messages.Read());
+		}
+	}
+}
+
+void AExternalOverlay::SetLayer(uint16 Layer, const soda::overlay::FMessage& Message)
+{
+	BuildLayerView(LayerViews.FindOrAdd(Layer), Message);
+}
+
+void AExternalOverlay::ClearAllLayers()
+{
+	for (auto& [Layer, View] : LayerViews)
+	{
+		if (View.LineBatch)
+		{
+			View.LineBatch->DestroyComponent();
+		}
+		for (UTextRenderComponent* Text : View.Texts)
+		{
+			Text->DestroyComponent();
+		}
+	}
+	LayerViews.Empty();
+}
+
+void AExternalOverlay::BuildLayerView(FLayerView& View, const soda::overlay::FMessage& Message)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BuildLayer);
+
+	const uint8 DepthPriority = bForeground ? SDPG_Foreground : SDPG_World;
+
+	if (!View.LineBatch)
+	{
+		View.LineBatch = NewObject<ULineBatchComponent>(this);
+		View.LineBatch->RegisterComponent();
+	}
+
+	ULineBatchComponent* LineBatch = View.LineBatch;
+	LineBatch->BatchedLines.Reset();
+	LineBatch->BatchedPoints.Reset();
+
+	ALevelState* LevelState = ALevelState::Get();
+	int TextNum = 0;
+
+	for (const soda::overlay::FPrimitive& Primitive : Message.Primitives)
+	{
+		// Convert all vertices of the primitive at once
+		const TArray<FVector>* Vertices = &Primitive.Vertices;
+		if ((Primitive.Flags & soda::overlay::LonLat) && LevelState)
+		{
+			ConvertBuffer.SetNum(Primitive.Vertices.Num(), false);
+			LevelState->GetLLConverter().LLA2UE(Primitive.Vertices, ConvertBuffer, MaxLinearError);
+			Vertices = &ConvertBuffer;
+		}
+
+		const FLinearColor Color(Primitive.Color);
+		const float Size = Primitive.Size > 0 ? Primitive.Size : 10.f;
+
+		switch (Primitive.Type)
+		{
+		case soda::overlay::EPrimitiveType::Polyline:
+			LineBatch->BatchedLines.Reserve(LineBatch->BatchedLines.Num() + Vertices->Num());
+			for (int i = 0; i < Vertices->Num() - 1; ++i)
+			{
+				LineBatch->BatchedLines.Emplace((*Vertices)[i], (*Vertices)[i + 1], Color, 0, Size, DepthPriority);
+			}
+			break;
+
+		case soda::overlay::EPrimitiveType::Points:
+			LineBatch->BatchedPoints.Reserve(LineBatch->BatchedPoints.Num() + Vertices->Num());
+			for (const FVector& Vertex : *Vertices)
+			{
+				LineBatch->BatchedPoints.Emplace(Vertex, Color, Size, 0, DepthPriority);
+			}
+			break;
+
+		case soda::overlay::EPrimitiveType::Boxes:
+			for (int i = 0; i < Vertices->Num(); ++i)
+			{
+				const FTransform Transform(FRotator(0, Primitive.Yaws[i], 0), (*Vertices)[i]);
+				const FVector& E = Primitive.Extents[i];
+				FVector Corners[8];
+				for (int k = 0; k < 8; ++k)
+				{
+					Corners[k] = Transform.TransformPosition(FVector((k & 1) ? E.X : -E.X, (k & 2) ? E.Y : -E.Y, (k & 4) ? E.Z : -E.Z));
+				}
+				static const int Edges[12][2] = { {0, 1}, {1, 3}, {3, 2}, {2, 0}, {4, 5}, {5, 7}, {7, 6}, {6, 4}, {0, 4}, {1, 5}, {2, 6}, {3, 7} };
+				for (const auto& Edge : Edges)
+				{
+					LineBatch->BatchedLines.Emplace(Corners[Edge[0]], Corners[Edge[1]], Color, 0, Size, DepthPriority);
+				}
+			}
+			break;
+
+		case soda::overlay::EPrimitiveType::Text:
+			if (Vertices->Num() > 0)
+			{
+				if (View.Texts.Num() <= TextNum)
+				{
+					UTextRenderComponent* Text = NewObject<UTextRenderComponent>(this);
+					Text->SetHorizontalAlignment(EHTA_Center);
+					Text->SetMobility(EComponentMobility::Movable);
+					Text->RegisterComponent();
+					View.Texts.Add(Text);
+				}
+				UTextRenderComponent* Text = View.Texts[TextNum++];
+				Text->SetWorldLocation((*Vertices)[0]);
+				Text->SetText(FText::FromString(Primitive.Text));
+				Text->SetTextRenderColor(Primitive.Color);
+				Text->SetWorldSize(Primitive.Size > 0 ? Primitive.Size : 50.f);
+				Text->SetVisibility(true);
+			}
+			break;
+		}
+	}
+
+	for (int i = TextNum; i < View.Texts.Num(); ++i)
+	{
+		View.Texts[i]->SetVisibility(false);
+	}
+
+	LineBatch->MarkRenderStateDirty();
+}
+
+const FSodaActorDescriptor* AExternalOverlay::GenerateActorDescriptor() const
+{
+	static FSodaActorDescriptor Desc{
+		TEXT("External Overlay"), /*DisplayName*/
+		TEXT("Tools"), /*Category*/
+		TEXT("Experimental"), /*SubCategory*/
+		TEXT("SodaIcons.Path"), /*Icon*/
+		false, /*bAllowTransform*/
+		true, /*bAllowSpawn*/
+		FVector(0, 0, 0), /*SpawnOffset*/
+	};
+	return &Desc;
+}
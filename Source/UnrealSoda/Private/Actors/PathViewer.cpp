@@ -60,30 +60,50 @@ void APathViewer::TickActor(float DeltaTime, enum ELevelTick TickType, FActorTic
 {
 	Super::TickActor(DeltaTime, TickType, ThisTickFunction);
 
+	const auto & Conv = ALevelState::GetChecked()->GetLLConverter();
+
 	mutex.lock();
-	DrawBuf = Buf;
+	const bool bIsLanLongChanged = bIsLanLong && (PointsVersion != BufVersion || !bPointsIsLanLong || PointsMaxLinearError != MaxLinearError || !PointsConverter.IsSameOrign(Conv));
+	if (!bIsLanLong || bIsLanLongChanged)
+	{
+		DrawBuf = Buf;
+		PointsVersion = BufVersion;
+	}
 	mutex.unlock();
 
 	auto World = GetWorld();
 	FVector WorldLoc = RootComponent->GetComponentLocation();
-	const auto & Conv = ALevelState::GetChecked()->GetLLConverter();
+	const int Num = (int)DrawBuf.size() / 2;
 
-	for (int i = 0; i < (int)DrawBuf.size() / 2 - 1; i++)
+	if (bIsLanLong)
 	{
-		FVector Pt1;
-		FVector Pt2;
-		if(bIsLanLong)
+		if (bIsLanLongChanged)
 		{
-			Conv.LLA2UE(Pt1, DrawBuf[i * 2 + 0], DrawBuf[i * 2 + 1], 0);
-			Conv.LLA2UE(Pt2, DrawBuf[i * 2 + 2], DrawBuf[i * 2 + 3], 0);
-			Pt1.Z = Pt2.Z = WorldLoc.Z;
+			LonLatAlt.SetNum(Num, false);
+			for (int i = 0; i < Num; i++)
+			{
+				LonLatAlt[i] = FVector(DrawBuf[i * 2 + 0], DrawBuf[i * 2 + 1], 0);
+			}
+			Points.SetNum(Num, false);
+			Conv.LLA2UE(LonLatAlt, Points, MaxLinearError);
+			bPointsIsLanLong = true;
+			PointsMaxLinearError = MaxLinearError;
+			PointsConverter = Conv;
 		}
-		else
+	}
+	else
+	{
+		Points.SetNum(Num, false);
+		for (int i = 0; i < Num; i++)
 		{
-			Pt1 = FVector(DrawBuf[i * 2 + 0] * ScaleX + DX, DrawBuf[i * 2 + 1] * ScaleY + DY, WorldLoc.Z);
-			Pt2 = FVector(DrawBuf[i * 2 + 2] * ScaleX + DX, DrawBuf[i * 2 + 3] * ScaleY + DY, WorldLoc.Z);
+			Points[i] = FVector(DrawBuf[i * 2 + 0] * ScaleX + DX, DrawBuf[i * 2 + 1] * ScaleY + DY, 0);
 		}
-		DrawDebugLine(World, Pt1, Pt2, Color, false, -1.f, 0, Thickness);
+		bPointsIsLanLong = false;
+	}
+
+	for (int i = 0; i < Points.Num() - 1; i++)
+	{
+		DrawDebugLine(World, FVector(Points[i].X, Points[i].Y, WorldLoc.Z), FVector(Points[i + 1].X, Points[i + 1].Y, WorldLoc.Z), Color, false, -1.f, 0, Thickness);
 	}
 }
 
@@ -93,6 +113,7 @@ void APathViewer::Recv(const FArrayReaderPtr& ArrayReaderPtr, const FIPv4Endpoin
 	mutex.lock();
 	Buf.resize(ArrayReaderPtr->Num() / sizeof(double));
 	::memcpy(Buf.data(), ArrayReaderPtr->GetData(), ArrayReaderPtr->Num() / sizeof(double) * sizeof(double));
+	++BufVersion;
 	mutex.unlock();
 
 	//UE_LOG(LogSoda, Error, TEXT("PathViwer::Recv %d "), ArrayReaderPtr->Num());
@@ -4,10 +4,33 @@
 #include "MassSpawnerSubsystem.h"
 #include "MassSimulationSubsystem.h"
 #include "Components/PrimitiveComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "MassEntitySubsystem.h"
+#include "MassEntityManager.h"
+#include "Soda/Mass/SodaTrafficSubsystem.h"
+#include "Soda/Misc/NoiseEngine.h"
+#include "Soda/LevelState.h"
+#include "Soda/UnrealSoda.h"
+#include "Soda/Vehicles/SodaVehicle.h"
+#include "Misc/Crc.h"
 
 ASodaMassSpawner::ASodaMassSpawner()
 {
 	PrimaryActorTick.bCanEverTick = true;
+
+	InstancedMesh = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("InstancedMesh"));
+	InstancedMesh->SetMobility(EComponentMobility::Movable);
+	InstancedMesh->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	InstancedMesh->SetCollisionResponseToAllChannels(ECR_Block);
+	InstancedMesh->SetCanEverAffectNavigation(false);
+	if (RootComponent)
+	{
+		InstancedMesh->SetupAttachment(RootComponent);
+	}
+	else
+	{
+		SetRootComponent(InstancedMesh);
+	}
 }
 
 void ASodaMassSpawner::BeginPlay()
@@ -18,6 +41,7 @@ void ASodaMassSpawner::BeginPlay()
 
 void ASodaMassSpawner::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+	DespawnNativeTraffic();
 	Super::EndPlay(EndPlayReason);
 }
 
@@ -33,14 +57,119 @@ void ASodaMassSpawner::ToggleSpawnTraffic()
 
 void ASodaMassSpawner::SpawnTraffic()
 {
-	DoSpawning();
+	if (bNativeTraffic)
+	{
+		SpawnNativeTraffic();
+	}
+	else
+	{
+		DoSpawning();
+	}
 }
 
 void ASodaMassSpawner::DespawnTraffic()
 {
+	DespawnNativeTraffic();
 	DoDespawning();
 }
 
+void ASodaMassSpawner::SpawnNativeTraffic()
+{
+	DespawnNativeTraffic();
+
+	USodaTrafficSubsystem* Traffic = UWorld::GetSubsystem<USodaTrafficSubsystem>(GetWorld());
+	UMassEntitySubsystem* EntitySubsystem = UWorld::GetSubsystem<UMassEntitySubsystem>(GetWorld());
+	if (!Traffic || !EntitySubsystem)
+	{
+		return;
+	}
+
+	Traffic->SetConfig(NativeTraffic);
+	if (!Traffic->RebuildLaneGraph())
+	{
+		UE_LOG(LogSoda, Warning, TEXT("ASodaMassSpawner::SpawnNativeTraffic(); There are no navigation routes allowed for vehicles"));
+		return;
+	}
+
+	InstancedMesh->SetStaticMesh(NativeTraffic.Mesh);
+	Traffic->SetInstancedMesh(InstancedMesh);
+
+	// Spread the agents evenly along the lanes
+	const TArray<soda::FTrafficLane>& Lanes = Traffic->GetLanes();
+	float TotalLength = 0;
+	for (const soda::FTrafficLane& Lane : Lanes)
+	{
+		TotalLength += Lane.Length;
+	}
+	const float Spacing = FMath::Max(TotalLength / FMath::Max(Count, 1), NativeTraffic.VehicleLength + NativeTraffic.MinGap * 100.f);
+
+	TArray<TPair<int32, float>> Placements;
+	for (int32 i = 0; i < Lanes.Num() && Placements.Num() < Count; ++i)
+	{
+		for (float Distance = Spacing * 0.5f; Distance < Lanes[i].Length && Placements.Num() < Count; Distance += Spacing)
+		{
+			Placements.Add({ i, Distance });
+		}
+	}
+
+	FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+	const FMassArchetypeHandle Archetype = EntityManager.CreateArchetype({ FSodaTrafficAgentFragment::StaticStruct(), FSodaTrafficPromotionFragment::StaticStruct() });
+	EntityManager.BatchCreateEntities(Archetype, Placements.Num(), NativeEntities);
+
+	uint32 Seed = 0;
+	if (ALevelState* LevelState = ALevelState::Get())
+	{
+		Seed = uint32(LevelState->NoiseSeed);
+	}
+	const uint32 SpawnerId = FCrc::StrCrc32(*GetName());
+	const soda::FNoiseStream Stream(soda::FNoiseStream::MakeKey(Seed, SpawnerId));
+
+	for (int32 i = 0; i < NativeEntities.Num(); ++i)
+	{
+		float Random[2];
+		Stream.Uniform(0, 0, i * 2, Random, 2);
+
+		FSodaTrafficAgentFragment& Agent = EntityManager.GetFragmentDataChecked<FSodaTrafficAgentFragment>(NativeEntities[i]);
+		Agent.Lane = Placements[i].Key;
+		Agent.Distance = Placements[i].Value;
+		Agent.DesiredSpeed = NativeTraffic.DesiredSpeed / 3.6f * (1.f + NativeTraffic.DesiredSpeedSpread * (2.f * Random[0] - 1.f));
+		Agent.Speed = Agent.DesiredSpeed * 0.5f;
+		Agent.LaneChangeTimer = NativeTraffic.LaneChangeCheckPeriod * Random[1];
+		Agent.Seed = HashCombine(SpawnerId ^ Seed, uint32(i));
+	}
+
+	UE_LOG(LogSoda, Log, TEXT("ASodaMassSpawner::SpawnNativeTraffic(); Spawned %i agents"), NativeEntities.Num());
+}
+
+void ASodaMassSpawner::DespawnNativeTraffic()
+{
+	if (NativeEntities.Num() == 0)
+	{
+		return;
+	}
+
+	if (UMassEntitySubsystem* EntitySubsystem = UWorld::GetSubsystem<UMassEntitySubsystem>(GetWorld()))
+	{
+		FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+		NativeEntities.RemoveAll([&EntityManager](const FMassEntityHandle& Entity) { return !EntityManager.IsEntityValid(Entity); });
+		for (const FMassEntityHandle& Entity : NativeEntities)
+		{
+			if (ASodaVehicle* Vehicle = EntityManager.GetFragmentDataChecked<FSodaTrafficPromotionFragment>(Entity).Vehicle.Get())
+			{
+				Vehicle->Destroy();
+			}
+		}
+		EntityManager.BatchDestroyEntities(NativeEntities);
+	}
+	NativeEntities.Reset();
+
+	if (USodaTrafficSubsystem* Traffic = UWorld::GetSubsystem<USodaTrafficSubsystem>(GetWorld()))
+	{
+		Traffic->GetPromotedVehicles().Reset();
+		Traffic->UpdateInstances({});
+	}
+}
+
 const FSodaActorDescriptor* ASodaMassSpawner::GenerateActorDescriptor() const
 {
 	static FSodaActorDescriptor Desc{
@@ -2,6 +2,7 @@
 
 #include "Soda/Actors/WeatherSystem.h"
 #include "Soda/UnrealSoda.h"
+#include "Soda/SodaSensorEnvironment.h"
 #include "Components/ExponentialHeightFogComponent.h"
 #include "Components/SkyLightComponent.h"
 #include "Components/VolumetricCloudComponent.h"
@@ -27,6 +28,16 @@ void AWeatherSystem::BeginPlay()
 	UpdateWeather();
 }
 
+void AWeatherSystem::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	if (USodaSensorEnvironment* SensorEnvironment = GetWorld()->GetSubsystem<USodaSensorEnvironment>())
+	{
+		SensorEnvironment->SetWeather(soda::FSensorWeather{});
+	}
+}
+
 void AWeatherSystem::Serialize(FArchive& Ar)
 {
 	Super::Serialize(Ar);
@@ -89,6 +100,13 @@ void AWeatherSystem::UpdateWeather()
 	{
 		SkyLight->GetLightComponent()->RecaptureSky();
 	}
+	if (USodaSensorEnvironment* SensorEnvironment = GetWorld() ? GetWorld()->GetSubsystem<USodaSensorEnvironment>() : nullptr)
+	{
+		RainRate = FMath::Max(RainRate, 0.f);
+		SnowRate = FMath::Max(SnowRate, 0.f);
+		FogVisibility = FMath::Max(FogVisibility, 0.f);
+		SensorEnvironment->SetWeather(soda::FSensorWeather{ RainRate, SnowRate, FogVisibility });
+	}
 }
 
 
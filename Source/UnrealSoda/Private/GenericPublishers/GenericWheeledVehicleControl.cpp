@@ -0,0 +1,82 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/GenericPublishers/GenericWheeledVehicleControl.h"
+#include "Soda/UnrealSoda.h"
+#include "Engine/Engine.h"
+#include "Engine/Canvas.h"
+
+bool UGenericWheeledVehicleControlListener::GetControl(soda::FGenericWheeledVehiclControl& Control) const
+{
+	soda::TControlMailbox<soda::FGenericWheeledVehiclControl>::FLetter Letter;
+	if (!Mailbox.Read(Letter))
+	{
+		return false;
+	}
+
+	if (LastReadVersion.exchange(Letter.Version, std::memory_order_relaxed) != Letter.Version)
+	{
+		DeliveryLatency.Add(soda::Now() - Letter.RecvTimestamp);
+	}
+
+	Control = Letter.Value;
+	Control.Timestamp = Letter.RecvTimestamp;
+	return true;
+}
+
+bool UGenericWheeledVehicleControlListener::IsControlTimeout() const
+{
+	soda::TControlMailbox<soda::FGenericWheeledVehiclControl>::FLetter Letter;
+	bool bTimeout = true;
+	if (Mailbox.Read(Letter))
+	{
+		bTimeout = std::chrono::duration<double>(soda::Now() - Letter.RecvTimestamp).count() > WatchdogTimeout;
+	}
+
+	if (bTimeout && Letter.Version != 0 && !bTimeoutReported.exchange(true, std::memory_order_relaxed))
+	{
+		TimeoutsNum.fetch_add(1, std::memory_order_relaxed);
+	}
+	else if (!bTimeout)
+	{
+		bTimeoutReported.store(false, std::memory_order_relaxed);
+	}
+
+	return bTimeout;
+}
+
+void UGenericWheeledVehicleControlListener::PushControl(const soda::FGenericWheeledVehiclControl& Control, const TTimestamp& SenderTimestamp)
+{
+	const TTimestamp RecvTimestamp = soda::Now();
+	Mailbox.Write(Control, SenderTimestamp, RecvTimestamp);
+	TransportLatency.Add(RecvTimestamp - SenderTimestamp);
+}
+
+void UGenericWheeledVehicleControlListener::PushControl(const soda::FGenericWheeledVehiclControl& Control)
+{
+	const TTimestamp RecvTimestamp = soda::Now();
+	Mailbox.Write(Control, RecvTimestamp, RecvTimestamp);
+}
+
+void UGenericWheeledVehicleControlListener::ResetMailbox()
+{
+	Mailbox.Reset();
+	TransportLatency.Reset();
+	DeliveryLatency.Reset();
+	LastReadVersion.store(0, std::memory_order_relaxed);
+	TimeoutsNum.store(0, std::memory_order_relaxed);
+	bTimeoutReported.store(false, std::memory_order_relaxed);
+}
+
+void UGenericWheeledVehicleControlListener::DrawDebug(UCanvas* Canvas, float& YL, float& YPos)
+{
+	Super::DrawDebug(Canvas, YL, YPos);
+
+	UFont* RenderFont = GEngine->GetSmallFont();
+
+	Canvas->SetDrawColor(FColor::White);
+	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Received: %llu; Timeouts: %llu"), Mailbox.GetVersion(), TimeoutsNum.load(std::memory_order_relaxed)), 16, YPos);
+	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Transport latency: mean %.0fus; p99 < %lldus; max %lldus"),
+		TransportLatency.GetMeanUs(), TransportLatency.GetPercentileUs(0.99), TransportLatency.GetMaxUs()), 16, YPos);
+	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Delivery latency: mean %.0fus; p99 < %lldus; max %lldus"),
+		DeliveryLatency.GetMeanUs(), DeliveryLatency.GetPercentileUs(0.99), DeliveryLatency.GetMaxUs()), 16, YPos);
+}
@@ -0,0 +1,422 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/GenericPublishers/RecordingPublishers.h"
+#include "Soda/UnrealSoda.h"
+#include "Soda/VehicleComponents/Sensors/Base/CameraSensor.h"
+#include "Soda/VehicleComponents/Sensors/Base/LidarSensor.h"
+#include "Soda/VehicleComponents/Sensors/Base/NavSensor.h"
+#include "Soda/VehicleComponents/Sensors/Base/RacingSensor.h"
+#include "Soda/VehicleComponents/Sensors/Base/RadarSensor.h"
+#include "Soda/VehicleComponents/Sensors/Base/UltrasonicSensor.h"
+#include "Soda/VehicleComponents/Sensors/Base/V2XSensor.h"
+#include "Soda/VehicleComponents/Sensors/Generic/GenericWheeledVehicleSensor.h"
+#include "Soda/VehicleComponents/Mechanicles/VehicleGearBoxComponent.h"
+#include "Soda/VehicleComponents/VehicleDriverComponent.h"
+#include "Soda/Vehicles/SodaWheeledVehicle.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+#include "Misc/Paths.h"
+#include "Engine/Canvas.h"
+#include "Engine/Engine.h"
+
+namespace soda
+{
+
+/***********************************************************************************************
+	FSensorRecordStream
+***********************************************************************************************/
+bool FSensorRecordStream::Open(const FSensorRecordSettings& Settings, const UVehicleBaseComponent* Parent, ESensorRecordPayload InPayload)
+{
+	Close();
+
+	FString FileName = Settings.FileName;
+	if (FPaths::IsRelative(FileName))
+	{
+		FileName = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("SensorRecords"), FileName);
+	}
+
+	Writer = FSensorRecordWriter::GetShared(FileName, FMath::Max(Settings.ChunkSizeMB, 1));
+	if (!Writer)
+	{
+		return false;
+	}
+
+	Name = Settings.StreamName;
+	if (Name.IsEmpty() && Parent)
+	{
+		Name = Parent->GetOwner() ? Parent->GetOwner()->GetName() + TEXT(".") + Parent->GetName() : Parent->GetName();
+	}
+	Payload = InPayload;
+	StreamId = Writer->AddStream(Name, Payload);
+	Frames = 0;
+	return true;
+}
+
+void FSensorRecordStream::Close()
+{
+	Writer.Reset();
+}
+
+bool FSensorRecordStream::Write(const FSensorDataHeader& Header, float DeltaTime, TFunctionRef<void(FArchive&)> Serializer)
+{
+	if (!Writer)
+	{
+		return false;
+	}
+
+	if (!Writer->Write(StreamId, Payload, Header, DeltaTime, Serializer))
+	{
+		return false;
+	}
+
+	++Frames;
+	return true;
+}
+
+FString FSensorRecordStream::GetRemark() const
+{
+	return Writer ? FPaths::GetCleanFilename(Writer->GetFileName()) : TEXT("");
+}
+
+void FSensorRecordStream::DrawDebug(UCanvas* Canvas, float& YL, float& YPos)
+{
+	UFont* RenderFont = GEngine->GetSmallFont();
+	Canvas->SetDrawColor(FColor::White);
+
+	if (!Writer)
+	{
+		YPos += Canvas->DrawText(RenderFont, TEXT("Recording: closed"), 16, YPos);
+		return;
+	}
+
+	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Recording: \"%s\" %s"), *Name, ToString(Payload)), 16, YPos);
+	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Frames: %lld"), int64(Frames)), 16, YPos);
+	YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("File: %.1f MB; dropped frames: %lld"),
+		Writer->GetWrittenBytes() / (1024.0 * 1024.0), Writer->GetDroppedFrames()), 16, YPos);
+}
+
+/***********************************************************************************************
+	Payloads
+***********************************************************************************************/
+static void SerializeStruct(FArchive& Ar, UScriptStruct* Struct, void* Data)
+{
+	FObjectAndNameAsStringProxyArchive ProxyAr(Ar, false);
+	Struct->SerializeBin(ProxyAr, Data);
+}
+
+template <class T>
+static void SerializeStructArray(FArchive& Ar, TArray<T>& Array)
+{
+	int32 Num = Array.Num();
+	Ar << Num;
+	if (Ar.IsLoading())
+	{
+		Array.SetNum(Num);
+	}
+	for (auto& It : Array)
+	{
+		SerializeStruct(Ar, T::StaticStruct(), &It);
+	}
+}
+
+template <class T>
+static bool SerializeBulk(FArchive& Ar, TArray<T>& Array)
+{
+	int32 Num = Array.Num();
+	int32 ElementSize = sizeof(T);
+	Ar << Num << ElementSize;
+	if (Ar.IsLoading())
+	{
+		if (ElementSize != sizeof(T) || Num < 0)
+		{
+			Ar.SetError();
+			return false;
+		}
+		Array.SetNumUninitialized(Num);
+	}
+	Ar.Serialize(Array.GetData(), int64(Num) * sizeof(T));
+	return true;
+}
+
+void SerializeRecord(FArchive& Ar, FCameraFrame& CameraFrame, TArray<FColor>& BGRA8, uint32& ImageStride)
+{
+	uint8 Shader = uint8(CameraFrame.GetShader());
+	Ar << CameraFrame.Width << CameraFrame.Height << CameraFrame.MaxDepthDistance << Shader << ImageStride;
+	if (Ar.IsLoading())
+	{
+		CameraFrame.SetShader(ECameraSensorShader(Shader));
+	}
+	SerializeBulk(Ar, BGRA8);
+}
+
+void SerializeRecord(FArchive& Ar, FLidarSensorData& Scan)
+{
+	Ar << Scan.HorizontalAngleMin << Scan.HorizontalAngleMax << Scan.VerticalAngleMin << Scan.VerticalAngleMax;
+	Ar << Scan.RangeMin << Scan.RangeMax << Scan.bIntensitieIsValid << Scan.bTimeOffsetIsValid << Scan.ScanDuration << Scan.ReturnsNum;
+
+	bool bHasSize = Scan.Size.IsSet();
+	FUintVector2 Size = Scan.Size.Get(FUintVector2::ZeroValue);
+	Ar << bHasSize << Size.X << Size.Y;
+	if (Ar.IsLoading())
+	{
+		Scan.Size = bHasSize ? TOptional<FUintVector2>(Size) : TOptional<FUintVector2>();
+	}
+
+	if (!SerializeBulk(Ar, Scan.Points))
+	{
+		UE_LOG(LogSoda, Error, TEXT("soda::SerializeRecord(); The lidar points are recorded by the other build"));
+	}
+}
+
+void SerializeRecord(FArchive& Ar, FTransform& RelativeTransform, FPhysBodyKinematic& VehicleKinematic, FImuNoiseParams& Covariance)
+{
+	Ar << RelativeTransform << VehicleKinematic;
+	SerializeStruct(Ar, FImuNoiseParams::StaticStruct(), &Covariance);
+}
+
+void SerializeRecord(FArchive& Ar, FRacingSensorData& SensorData)
+{
+	Ar << SensorData.LeftBorderOffset << SensorData.RightBorderOffset << SensorData.CenterLineYaw;
+	Ar << SensorData.LapCaunter << SensorData.CoveredDistanceCurrentLap << SensorData.CoveredDistanceFull;
+	Ar << SensorData.bBorderIsValid << SensorData.bLapCounterIsValid;
+	Ar << SensorData.StartTimestemp << SensorData.LapTimestemp;
+}
+
+void SerializeRecord(FArchive& Ar, TArray<FRadarParams>& Params, FRadarClusters& Clusters, FRadarObjects& Objects)
+{
+	SerializeStructArray(Ar, Params);
+
+	int32 ClustersNum = Clusters.Clusters.Num();
+	Ar << Clusters.MaxDistDiff << ClustersNum;
+	if (Ar.IsLoading())
+	{
+		Clusters.Clusters.SetNum(ClustersNum);
+	}
+	for (auto& Cluster : Clusters.Clusters)
+	{
+		Ar << Cluster.Azimuth << Cluster.Distance << Cluster.RCS << Cluster.Lat << Cluster.Lon << Cluster.HitPosition << Cluster.LocalHitPosition;
+	}
+
+	int32 ObjectsNum = Objects.Objects.Num();
+	Ar << Objects.ObjectsMaxNum << ObjectsNum;
+	if (Ar.IsLoading())
+	{
+		Objects.Objects.Reset();
+		for (int32 i = 0; i < ObjectsNum; ++i)
+		{
+			uint32 Key = 0;
+			Ar << Key;
+			Objects.Objects.Add(Key);
+		}
+	}
+	else
+	{
+		for (auto& It : Objects.Objects)
+		{
+			Ar << It.Key;
+		}
+	}
+	for (auto& It : Objects.Objects)
+	{
+		FRadarObject& Object = It.Value;
+		uint8 ObjectCategory = uint8(Object.ObjectCategory);
+		FTrackingObjectData& Tracking = Object.TrackingData;
+		Ar << Object.RCS << Object.Lat << Object.Lon << ObjectCategory << Object.ObjectActorId << Object.LocalBounds << Object.RadarObjectId;
+		Ar << Tracking.RadarObjectId << Tracking.PrevVelocity << Tracking.Acceleration << Tracking.PrevUpdatedTimestamp << Tracking.ProbabilityCounter << Tracking.LifeCyclesCounter;
+		Ar << Object.BoundCenterActorLocal << Object.bUpdated << Object.CachedDistance << Object.CachedAzimuth << Object.CachedObjectPoint;
+		if (Ar.IsLoading())
+		{
+			Object.ObjectCategory = ESegmObjectLabel(ObjectCategory);
+		}
+	}
+}
+
+void SerializeRecord(FArchive& Ar, TArray<FUltrasonicEchos>& EchoCollections)
+{
+	SerializeStructArray(Ar, EchoCollections);
+}
+
+static void SaveRecord(FArchive& Ar, const TArray<UV2XMarkerSensor*>& Transmitters)
+{
+	int32 Num = Transmitters.Num();
+	Ar << Num;
+	for (const UV2XMarkerSensor* Transmitter : Transmitters)
+	{
+		int32 ID = Transmitter->ID;
+		FTransform Transform = Transmitter->GetV2XTransform();
+		FVector Velocity = Transmitter->GetV2XWorldVelocity();
+		FVector AngularVelocity = Transmitter->GetV2XWorldAngVelocity();
+		FBox Bound = Transmitter->Bound;
+		Ar << ID << Transform << Velocity << AngularVelocity << Bound;
+	}
+}
+
+static void SaveRecord(FArchive& Ar, const FWheeledVehicleSensorData& VehicleState)
+{
+	FTransform RelativeTransform = VehicleState.RelativeTransform;
+	bool bHasKinematic = !!VehicleState.BodyKinematic;
+	FPhysBodyKinematic Kinematic = bHasKinematic ? *VehicleState.BodyKinematic : FPhysBodyKinematic();
+	uint8 GearState = uint8(VehicleState.GearBox ? VehicleState.GearBox->GetGearState() : EGearState::Neutral);
+	int32 GearNum = VehicleState.GearBox ? VehicleState.GearBox->GetGearNum() : 0;
+	uint8 DriveMode = uint8(VehicleState.VehicleDriver ? VehicleState.VehicleDriver->GetDriveMode() : ESodaVehicleDriveMode::Manual);
+	Ar << RelativeTransform << bHasKinematic << Kinematic << GearState << GearNum << DriveMode;
+
+	int32 WheelsNum = VehicleState.WheeledVehicle ? VehicleState.WheeledVehicle->GetWheelsSorted().Num() : 0;
+	Ar << WheelsNum;
+	for (int32 i = 0; i < WheelsNum; ++i)
+	{
+		const USodaVehicleWheelComponent* Wheel = VehicleState.WheeledVehicle->GetWheelsSorted()[i];
+		float Steer = Wheel->Steer;
+		float AngularVelocity = Wheel->AngularVelocity;
+		float ReqTorq = Wheel->ReqTorq;
+		float ReqBrakeTorque = Wheel->ReqBrakeTorque;
+		Ar << Steer << AngularVelocity << ReqTorq << ReqBrakeTorque;
+	}
+}
+
+} // namespace soda
+
+/***********************************************************************************************
+	Recording publishers
+***********************************************************************************************/
+static bool AdvertiseRecording(soda::FSensorRecordStream& Stream, const FSensorRecordSettings& Settings, UVehicleBaseComponent* Parent, soda::ESensorRecordPayload Payload, UGenericPublisher* Forward)
+{
+	bool bOk = Stream.Open(Settings, Parent, Payload);
+	if (IsValid(Forward))
+	{
+		bOk &= Forward->Advertise(Parent);
+	}
+	return bOk;
+}
+
+static void ShutdownRecording(soda::FSensorRecordStream& Stream, UGenericPublisher* Forward)
+{
+	Stream.Close();
+	if (IsValid(Forward))
+	{
+		Forward->Shutdown();
+	}
+}
+
+static void DrawDebugRecording(soda::FSensorRecordStream& Stream, UGenericPublisher* Forward, UCanvas* Canvas, float& YL, float& YPos)
+{
+	Stream.DrawDebug(Canvas, YL, YPos);
+	if (IsValid(Forward))
+	{
+		Forward->DrawDebug(Canvas, YL, YPos);
+	}
+}
+
+#define IMPLEMENT_RECORDING_PUBLISHER_COMMON(ClassName, Payload) \
+	bool ClassName::Advertise(UVehicleBaseComponent* Parent) { return AdvertiseRecording(Stream, Recording, Parent, Payload, Forward); } \
+	void ClassName::Shutdown() { ShutdownRecording(Stream, Forward); } \
+	bool ClassName::IsInitializing() const { return IsValid(Forward) && Forward->IsInitializing(); } \
+	bool ClassName::IsOk() const { return Stream.IsOpen(); } \
+	void ClassName::DrawDebug(UCanvas* Canvas, float& YL, float& YPos) { DrawDebugRecording(Stream, Forward, Canvas, YL, YPos); } \
+	FString ClassName::GetRemark() const { return Stream.GetRemark(); }
+
+IMPLEMENT_RECORDING_PUBLISHER_COMMON(URecordingCameraPublisher, soda::ESensorRecordPayload::Camera)
+IMPLEMENT_RECORDING_PUBLISHER_COMMON(URecordingLidarPublisher, soda::ESensorRecordPayload::Lidar)
+IMPLEMENT_RECORDING_PUBLISHER_COMMON(URecordingNavPublisher, soda::ESensorRecordPayload::Nav)
+IMPLEMENT_RECORDING_PUBLISHER_COMMON(URecordingRacingPublisher, soda::ESensorRecordPayload::Racing)
+IMPLEMENT_RECORDING_PUBLISHER_COMMON(URecordingRadarPublisher, soda::ESensorRecordPayload::Radar)
+IMPLEMENT_RECORDING_PUBLISHER_COMMON(URecordingUltrasoncHubPublisher, soda::ESensorRecordPayload::Ultrasonic)
+IMPLEMENT_RECORDING_PUBLISHER_COMMON(URecordingV2XPublisher, soda::ESensorRecordPayload::V2X)
+IMPLEMENT_RECORDING_PUBLISHER_COMMON(URecordingWheeledVehiclePublisher, soda::ESensorRecordPayload::WheeledVehicle)
+
+#undef IMPLEMENT_RECORDING_PUBLISHER_COMMON
+
+bool URecordingCameraPublisher::Publish(float DeltaTime, const FSensorDataHeader& Header, const FCameraFrame& CameraFrame, const TArray<FColor>& BGRA8, uint32 ImageStride)
+{
+	if (IsValid(Forward) && Forward->IsOk())
+	{
+		Forward->Publish(DeltaTime, Header, CameraFrame, BGRA8, ImageStride);
+	}
+	return Stream.Write(Header, DeltaTime, [&](FArchive& Ar)
+	{
+		soda::SerializeRecord(Ar, const_cast<FCameraFrame&>(CameraFrame), const_cast<TArray<FColor>&>(BGRA8), ImageStride);
+	});
+}
+
+bool URecordingLidarPublisher::Publish(float DeltaTime, const FSensorDataHeader& Header, const soda::FLidarSensorData& Scan)
+{
+	if (IsValid(Forward) && Forward->IsOk())
+	{
+		Forward->Publish(DeltaTime, Header, Scan);
+	}
+	return Stream.Write(Header, DeltaTime, [&](FArchive& Ar)
+	{
+		soda::SerializeRecord(Ar, const_cast<soda::FLidarSensorData&>(Scan));
+	});
+}
+
+bool URecordingNavPublisher::Publish(float DeltaTime, const FSensorDataHeader& Header, const FTransform& RelativeTransform, const FPhysBodyKinematic& VehicleKinematic, const FImuNoiseParams& Covariance)
+{
+	if (IsValid(Forward) && Forward->IsOk())
+	{
+		Forward->Publish(DeltaTime, Header, RelativeTransform, VehicleKinematic, Covariance);
+	}
+	return Stream.Write(Header, DeltaTime, [&](FArchive& Ar)
+	{
+		soda::SerializeRecord(Ar, const_cast<FTransform&>(RelativeTransform), const_cast<FPhysBodyKinematic&>(VehicleKinematic), const_cast<FImuNoiseParams&>(Covariance));
+	});
+}
+
+bool URecordingRacingPublisher::Publish(float DeltaTime, const FSensorDataHeader& Header, const soda::FRacingSensorData& SensorData)
+{
+	if (IsValid(Forward) && Forward->IsOk())
+	{
+		Forward->Publish(DeltaTime, Header, SensorData);
+	}
+	return Stream.Write(Header, DeltaTime, [&](FArchive& Ar)
+	{
+		soda::SerializeRecord(Ar, const_cast<soda::FRacingSensorData&>(SensorData));
+	});
+}
+
+bool URecordingRadarPublisher::Publish(float DeltaTime, const FSensorDataHeader& Header, const TArray<FRadarParams>& Params, const FRadarClusters& Clusters, const FRadarObjects& Objects)
+{
+	if (IsValid(Forward) && Forward->IsOk())
+	{
+		Forward->Publish(DeltaTime, Header, Params, Clusters, Objects);
+	}
+	return Stream.Write(Header, DeltaTime, [&](FArchive& Ar)
+	{
+		soda::SerializeRecord(Ar, const_cast<TArray<FRadarParams>&>(Params), const_cast<FRadarClusters&>(Clusters), const_cast<FRadarObjects&>(Objects));
+	});
+}
+
+bool URecordingUltrasoncHubPublisher::Publish(float DeltaTime, const FSensorDataHeader& Header, const TArray<FUltrasonicEchos>& InEchoCollections)
+{
+	if (IsValid(Forward) && Forward->IsOk())
+	{
+		Forward->Publish(DeltaTime, Header, InEchoCollections);
+	}
+	return Stream.Write(Header, DeltaTime, [&](FArchive& Ar)
+	{
+		soda::SerializeRecord(Ar, const_cast<TArray<FUltrasonicEchos>&>(InEchoCollections));
+	});
+}
+
+bool URecordingV2XPublisher::Publish(float DeltaTime, const FSensorDataHeader& Header, const TArray<UV2XMarkerSensor*>& Transmitters)
+{
+	if (IsValid(Forward) && Forward->IsOk())
+	{
+		Forward->Publish(DeltaTime, Header, Transmitters);
+	}
+	return Stream.Write(Header, DeltaTime, [&](FArchive& Ar)
+	{
+		soda::SaveRecord(Ar, Transmitters);
+	});
+}
+
+bool URecordingWheeledVehiclePublisher::Publish(float DeltaTime, const FSensorDataHeader& Header, const FWheeledVehicleSensorData& VehicleState)
+{
+	if (IsValid(Forward) && Forward->IsOk())
+	{
+		Forward->Publish(DeltaTime, Header, VehicleState);
+	}
+	return Stream.Write(Header, DeltaTime, [&](FArchive& Ar)
+	{
+		soda::SaveRecord(Ar, VehicleState);
+	});
+}
@@ -3,6 +3,7 @@
 #include "Soda/LevelState.h"
 #include "Soda/UnrealSoda.h"
 #include "Soda/SodaApp.h"
+#include "Soda/SodaSimulationClock.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetSystemLibrary.h"
 #include "GameFramework/GameModeBase.h"
@@ -20,6 +21,14 @@
 #include "Soda/SodaSubsystem.h"
 #include "Soda/FileDatabaseManager.h"
 #include "Soda/SodaDelegates.h"
+#include "Soda/ISodaActor.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Components/PrimitiveComponent.h"
+
+DECLARE_STATS_GROUP(TEXT("LevelState"), STATGROUP_LevelState, STATGROUP_Advanced);
+DECLARE_CYCLE_STAT(TEXT("TakeSnapshot"), STAT_TakeSnapshot, STATGROUP_LevelState);
+DECLARE_CYCLE_STAT(TEXT("RestoreSnapshot"), STAT_RestoreSnapshot, STATGROUP_LevelState);
 
 
 void ULevelSaveGame::Serialize(FArchive& Ar)
@@ -330,6 +339,120 @@ void ALevelState::ClearLevel()
 	}
 }
 
+static void GetSnapshotActors(UWorld* World, TArray<AActor*>& OutActors, TArray<FString>& OutNames)
+{
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		if (IsValid(*It) && It->GetClass()->ImplementsInterface(USodaActor::StaticClass()))
+		{
+			OutActors.Add(*It);
+			OutNames.Add(It->GetName());
+		}
+	}
+}
+
+static void SerializeActorSnapshot(FArchive& Ar, AActor* Actor)
+{
+	UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Actor->GetRootComponent());
+	const bool bSimulatePhysics = Primitive && Primitive->IsSimulatingPhysics();
+
+	FTransform Transform = Actor->GetActorTransform();
+	FVector LinearVelocity = bSimulatePhysics ? Primitive->GetPhysicsLinearVelocity() : FVector::ZeroVector;
+	FVector AngularVelocity = bSimulatePhysics ? Primitive->GetPhysicsAngularVelocityInRadians() : FVector::ZeroVector;
+	Ar << Transform << LinearVelocity << AngularVelocity;
+
+	if (Ar.IsLoading())
+	{
+		Actor->SetActorTransform(Transform, false, nullptr, ETeleportType::TeleportPhysics);
+		if (bSimulatePhysics)
+		{
+			Primitive->SetPhysicsLinearVelocity(LinearVelocity);
+			Primitive->SetPhysicsAngularVelocityInRadians(AngularVelocity);
+		}
+	}
+
+	if (ISodaActor* SodaActor = Cast<ISodaActor>(Actor))
+	{
+		SodaActor->SerializeSnapshot(Ar);
+	}
+}
+
+bool ALevelState::TakeSnapshot(FLevelSnapshot& OutSnapshot) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_TakeSnapshot);
+
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return false;
+	}
+
+	TArray<AActor*> Actors;
+	TArray<FString> Names;
+	GetSnapshotActors(World, Actors, Names);
+
+	OutSnapshot.Version = FLevelSnapshot::CurrentVersion;
+	OutSnapshot.World = World;
+	OutSnapshot.WorldTime = World->GetTimeSeconds();
+	const USodaSimulationClock* Clock = World->GetSubsystem<USodaSimulationClock>();
+	OutSnapshot.SimulatedSeconds = Clock ? Clock->GetSimulatedSeconds() : 0;
+	OutSnapshot.Data.Reset();
+
+	FMemoryWriter Ar(OutSnapshot.Data);
+	soda::SerializeSnapshotBlocks(Ar, Names, [&Actors](int32 Index, FArchive& BlockAr)
+	{
+		SerializeActorSnapshot(BlockAr, Actors[Index]);
+	});
+
+	if (Ar.IsError())
+	{
+		UE_LOG(LogSoda, Error, TEXT("ALevelState::TakeSnapshot(); Serialization failed"));
+		OutSnapshot.Version = 0;
+		return false;
+	}
+
+	return true;
+}
+
+bool ALevelState::RestoreSnapshot(const FLevelSnapshot& Snapshot)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RestoreSnapshot);
+
+	if (!Snapshot.IsValid() || Snapshot.World.Get() != GetWorld())
+	{
+		UE_LOG(LogSoda, Error, TEXT("ALevelState::RestoreSnapshot(); The snapshot isn't valid for this world"));
+		return false;
+	}
+
+	TArray<AActor*> Actors;
+	TArray<FString> Names;
+	GetSnapshotActors(GetWorld(), Actors, Names);
+
+	FMemoryReader Ar(Snapshot.Data);
+	soda::SerializeSnapshotBlocks(Ar, Names, [&Actors](int32 Index, FArchive& BlockAr)
+	{
+		SerializeActorSnapshot(BlockAr, Actors[Index]);
+	});
+
+	if (Ar.IsError())
+	{
+		UE_LOG(LogSoda, Error, TEXT("ALevelState::RestoreSnapshot(); Deserialization failed"));
+		return false;
+	}
+
+	// The timers and the sensors timestamps continue from the snapshot time
+	UWorld* World = GetWorld();
+	const double TimeShift = Snapshot.WorldTime - World->TimeSeconds;
+	World->TimeSeconds = Snapshot.WorldTime;
+	World->UnpausedTimeSeconds += TimeShift;
+	if (USodaSimulationClock* Clock = World->GetSubsystem<USodaSimulationClock>())
+	{
+		Clock->SetSimulatedSeconds(Snapshot.SimulatedSeconds);
+	}
+
+	return true;
+}
+
 bool ALevelState::SerializeSlotDescriptor(const FString& LevelName, FString& OutJsonString)
 {
 	TSharedPtr<FJsonObject> JsonObject = MakeShared<FJsonObject>();
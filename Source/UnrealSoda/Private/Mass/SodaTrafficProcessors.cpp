@@ -0,0 +1,380 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/Mass/SodaTrafficProcessors.h"
+#include "Soda/Mass/SodaTrafficSubsystem.h"
+#include "Soda/Misc/NoiseEngine.h"
+#include "Soda/Vehicles/SodaVehicle.h"
+#include "Soda/SodaSubsystem.h"
+#include "MassExecutionContext.h"
+#include "MassEntityManager.h"
+#include "Components/PrimitiveComponent.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_STATS_GROUP(TEXT("SodaTraffic"), STATGROUP_SodaTraffic, STATGROUP_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Occupancy"), STAT_TrafficOccupancy, STATGROUP_SodaTraffic);
+DECLARE_CYCLE_STAT(TEXT("Drive"), STAT_TrafficDrive, STATGROUP_SodaTraffic);
+DECLARE_CYCLE_STAT(TEXT("Representation"), STAT_TrafficRepresentation, STATGROUP_SodaTraffic);
+
+/**
+ * Find the leader of the agent at the Distance on the Lane, looks one lane ahead through the successor.
+ * OutGap [m] is the gap between the bumpers, MAX_FLT if there is no leader.
+ */
+static void FindLeader(const TArray<soda::FTrafficLane>& Lanes, int32 LaneIndex, float Distance, float Length, int32 SelfId, float& OutGap, float& OutSpeed, const soda::FTrafficSlot*& OutFollower)
+{
+	const soda::FTrafficLane& Lane = Lanes[LaneIndex];
+	const soda::FTrafficSlot* Leader;
+	Lane.FindNeighbours(Distance, SelfId, Leader, OutFollower);
+
+	float Offset = 0;
+	if (!Leader && Lane.Successor != INDEX_NONE && Lanes[Lane.Successor].Slots.Num())
+	{
+		Leader = &Lanes[Lane.Successor].Slots[0];
+		Offset = Lane.Length;
+	}
+
+	if (Leader && (Leader->AgentId != SelfId || SelfId == INDEX_NONE))
+	{
+		OutGap = (Leader->Distance + Offset - Distance - (Leader->Length + Length) * 0.5f) * 0.01f;
+		OutSpeed = Leader->Speed;
+	}
+	else
+	{
+		OutGap = MAX_FLT;
+		OutSpeed = 0;
+	}
+}
+
+/** Gap [m] of the follower to the leader behind which it will be if the agent between them leaves, Length [cm] of the leaving agent */
+static float MergeGaps(float FollowerGap, float LeaderGap, float Length)
+{
+	return LeaderGap < MAX_FLT ? FollowerGap + LeaderGap + Length * 0.01f : MAX_FLT;
+}
+
+USodaTrafficDriveProcessor::USodaTrafficDriveProcessor()
+	: EntityQuery(*this)
+{
+	ExecutionFlags = int32(EProcessorExecutionFlags::All);
+	ProcessingPhase = EMassProcessingPhase::PrePhysics;
+}
+
+void USodaTrafficDriveProcessor::ConfigureQueries()
+{
+	EntityQuery.AddRequirement<FSodaTrafficAgentFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FSodaTrafficPromotionFragment>(EMassFragmentAccess::ReadOnly);
+}
+
+void USodaTrafficDriveProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	USodaTrafficSubsystem* Traffic = UWorld::GetSubsystem<USodaTrafficSubsystem>(EntityManager.GetWorld());
+	if (!Traffic || Traffic->GetLanes().Num() == 0)
+	{
+		return;
+	}
+
+	TArray<soda::FTrafficLane>& Lanes = Traffic->GetLanes();
+	const FSodaTrafficConfig& Config = Traffic->GetConfig();
+	const float DeltaTime = Context.GetDeltaTimeSeconds();
+	const float Length = Config.VehicleLength;
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_TrafficOccupancy);
+
+		for (soda::FTrafficLane& Lane : Lanes)
+		{
+			Lane.Slots.Reset();
+		}
+
+		for (const auto& It : Traffic->GetExternalObstacles())
+		{
+			if (Lanes.IsValidIndex(It.Key))
+			{
+				Lanes[It.Key].Slots.Add(It.Value);
+			}
+		}
+
+		EntityQuery.ForEachEntityChunk(EntityManager, Context, [&Lanes, Length](FMassExecutionContext& ChunkContext)
+		{
+			const TConstArrayView<FSodaTrafficAgentFragment> Agents = ChunkContext.GetFragmentView<FSodaTrafficAgentFragment>();
+			for (int32 i = 0; i < ChunkContext.GetNumEntities(); ++i)
+			{
+				const FSodaTrafficAgentFragment& Agent = Agents[i];
+				if (Lanes.IsValidIndex(Agent.Lane))
+				{
+					Lanes[Agent.Lane].Slots.Add({ Agent.Distance, Agent.Speed, Agent.DesiredSpeed, Length, ChunkContext.GetEntity(i).Index });
+				}
+			}
+		});
+
+		ParallelFor(Lanes.Num(), [&Lanes](int32 i)
+		{
+			Lanes[i].Slots.Sort([](const soda::FTrafficSlot& A, const soda::FTrafficSlot& B) { return A.Distance < B.Distance; });
+		});
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_TrafficDrive);
+
+	// The lanes are read only from here, every agent writes only its own fragment
+	EntityQuery.ParallelForEachEntityChunk(EntityManager, Context, [Traffic, &Lanes, &Config, DeltaTime, Length](FMassExecutionContext& ChunkContext)
+	{
+		const TArrayView<FSodaTrafficAgentFragment> Agents = ChunkContext.GetMutableFragmentView<FSodaTrafficAgentFragment>();
+		const TConstArrayView<FSodaTrafficPromotionFragment> Promotions = ChunkContext.GetFragmentView<FSodaTrafficPromotionFragment>();
+
+		for (int32 i = 0; i < ChunkContext.GetNumEntities(); ++i)
+		{
+			FSodaTrafficAgentFragment& Agent = Agents[i];
+			if (!Lanes.IsValidIndex(Agent.Lane) || Promotions[i].Vehicle.IsValid())
+			{
+				// The promoted agents are moved by their vehicles, see USodaTrafficRepresentationProcessor
+				continue;
+			}
+
+			const int32 SelfId = ChunkContext.GetEntity(i).Index;
+			const soda::FTrafficLane& Lane = Lanes[Agent.Lane];
+
+			float Gap, LeaderSpeed;
+			const soda::FTrafficSlot* Follower;
+			FindLeader(Lanes, Agent.Lane, Agent.Distance, Length, SelfId, Gap, LeaderSpeed, Follower);
+			Agent.Acceleration = Traffic->CalcAcceleration(Agent.Speed, Agent.DesiredSpeed, Gap, LeaderSpeed);
+
+			// MOBIL
+			Agent.LaneChangeTimer -= DeltaTime;
+			if (Agent.LaneChangeTimer <= 0 && Agent.LaneChangeAlpha >= 1)
+			{
+				Agent.LaneChangeTimer = Config.LaneChangeCheckPeriod;
+
+				float OldFollowerGain = 0;
+				if (Follower && Follower->DesiredSpeed > 0)
+				{
+					const float FollowerGap = (Agent.Distance - Follower->Distance - (Follower->Length + Length) * 0.5f) * 0.01f;
+					OldFollowerGain =
+						Traffic->CalcAcceleration(Follower->Speed, Follower->DesiredSpeed, MergeGaps(FollowerGap, Gap, Length), LeaderSpeed) -
+						Traffic->CalcAcceleration(Follower->Speed, Follower->DesiredSpeed, FollowerGap, Agent.Speed);
+				}
+
+				int32 BestLane = INDEX_NONE;
+				float BestIncentive = Config.LaneChangeThreshold;
+				float BestAcceleration = 0;
+				for (const int32 TargetLane : { Lane.Left, Lane.Right })
+				{
+					if (!Lanes.IsValidIndex(TargetLane))
+					{
+						continue;
+					}
+
+					const float TargetDistance = Lane.MapDistance(Agent.Distance, Lanes[TargetLane]);
+					float NewGap, NewLeaderSpeed;
+					const soda::FTrafficSlot* NewFollower;
+					FindLeader(Lanes, TargetLane, TargetDistance, Length, SelfId, NewGap, NewLeaderSpeed, NewFollower);
+					if (NewGap < Config.MinGap)
+					{
+						continue;
+					}
+
+					float NewFollowerGain = 0;
+					if (NewFollower)
+					{
+						const float FollowerGap = (TargetDistance - NewFollower->Distance - (NewFollower->Length + Length) * 0.5f) * 0.01f;
+						if (FollowerGap < Config.MinGap)
+						{
+							continue;
+						}
+						if (NewFollower->DesiredSpeed > 0)
+						{
+							const float NewFollowerAcceleration = Traffic->CalcAcceleration(NewFollower->Speed, NewFollower->DesiredSpeed, FollowerGap, Agent.Speed);
+							if (NewFollowerAcceleration < -Config.SafeDeceleration)
+							{
+								continue;
+							}
+							NewFollowerGain = NewFollowerAcceleration -
+								Traffic->CalcAcceleration(NewFollower->Speed, NewFollower->DesiredSpeed, MergeGaps(FollowerGap, NewGap, Length), NewLeaderSpeed);
+						}
+					}
+
+					const float NewAcceleration = Traffic->CalcAcceleration(Agent.Speed, Agent.DesiredSpeed, NewGap, NewLeaderSpeed);
+					const float Incentive = NewAcceleration - Agent.Acceleration + Config.Politeness * (NewFollowerGain + OldFollowerGain);
+					if (Incentive > BestIncentive)
+					{
+						BestIncentive = Incentive;
+						BestLane = TargetLane;
+						BestAcceleration = NewAcceleration;
+					}
+				}
+
+				if (BestLane != INDEX_NONE)
+				{
+					Agent.Distance = Lane.MapDistance(Agent.Distance, Lanes[BestLane]);
+					Agent.PrevLane = Agent.Lane;
+					Agent.Lane = BestLane;
+					Agent.LaneChangeAlpha = 0;
+					Agent.Acceleration = BestAcceleration;
+				}
+			}
+
+			if (Agent.LaneChangeAlpha < 1)
+			{
+				Agent.LaneChangeAlpha = FMath::Min(1.f, Agent.LaneChangeAlpha + DeltaTime / FMath::Max(Config.LaneChangeDuration, KINDA_SMALL_NUMBER));
+			}
+
+			// Ballistic update, the agents never move backward
+			const float NewSpeed = FMath::Max(0.f, Agent.Speed + Agent.Acceleration * DeltaTime);
+			Agent.Distance += (Agent.Speed + NewSpeed) * 0.5f * DeltaTime * 100.f;
+			Agent.Speed = NewSpeed;
+
+			while (Agent.Distance > Lanes[Agent.Lane].Length)
+			{
+				const soda::FTrafficLane& CurrentLane = Lanes[Agent.Lane];
+				Agent.LaneChangeAlpha = 1;
+				if (CurrentLane.Successor != INDEX_NONE)
+				{
+					Agent.Distance -= CurrentLane.Length;
+					Agent.Lane = CurrentLane.Successor;
+				}
+				else
+				{
+					// Dead end, recycle the agent to the start of the random lane
+					float Random;
+					soda::FNoiseStream(Agent.Seed).Uniform(Agent.RecycleCount++, 0, 0, &Random, 1);
+					Agent.Lane = Traffic->PickLane(Random);
+					Agent.Distance = 0;
+					break;
+				}
+			}
+		}
+	});
+}
+
+USodaTrafficRepresentationProcessor::USodaTrafficRepresentationProcessor()
+	: EntityQuery(*this)
+{
+	ExecutionFlags = int32(EProcessorExecutionFlags::All);
+	ProcessingPhase = EMassProcessingPhase::PrePhysics;
+	ExecutionOrder.ExecuteAfter.Add(USodaTrafficDriveProcessor::StaticClass()->GetFName());
+	bRequiresGameThreadExecution = true;
+}
+
+void USodaTrafficRepresentationProcessor::ConfigureQueries()
+{
+	EntityQuery.AddRequirement<FSodaTrafficAgentFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FSodaTrafficPromotionFragment>(EMassFragmentAccess::ReadWrite);
+}
+
+void USodaTrafficRepresentationProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TrafficRepresentation);
+
+	UWorld* World = EntityManager.GetWorld();
+	USodaTrafficSubsystem* Traffic = UWorld::GetSubsystem<USodaTrafficSubsystem>(World);
+	if (!Traffic || Traffic->GetLanes().Num() == 0)
+	{
+		return;
+	}
+
+	const TArray<soda::FTrafficLane>& Lanes = Traffic->GetLanes();
+	const FSodaTrafficConfig& Config = Traffic->GetConfig();
+
+	TSet<TObjectKey<AActor>>& Promoted = Traffic->GetPromotedVehicles();
+	for (auto It = Promoted.CreateIterator(); It; ++It)
+	{
+		if (!It->ResolveObjectPtr())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	// The ego vehicle is the external obstacle for the agents and the center of the promotion area
+	bool bHasEgo = false;
+	FVector EgoLocation = FVector::ZeroVector;
+	Traffic->GetExternalObstacles().Reset();
+	USodaSubsystem* SodaSubsystem = USodaSubsystem::Get();
+	ASodaVehicle* EgoVehicle = SodaSubsystem ? SodaSubsystem->GetActiveVehicle() : nullptr;
+	if (EgoVehicle && !Traffic->IsPromotedVehicle(EgoVehicle))
+	{
+		bHasEgo = true;
+		EgoLocation = EgoVehicle->GetActorLocation();
+
+		int32 EgoLane;
+		float EgoDistance;
+		if (Traffic->FindNearestLane(EgoLocation, EgoVehicle->GetActorForwardVector(), Config.VehicleLength, EgoLane, EgoDistance))
+		{
+			Traffic->GetExternalObstacles().Add({ EgoLane, soda::FTrafficSlot{ EgoDistance, float(EgoVehicle->GetVelocity().Size()) * 0.01f, 0, Config.VehicleLength, INDEX_NONE } });
+		}
+	}
+
+	const bool bCanPromote = bHasEgo && Config.PromotedVehicleClass;
+	const float PromotionDistanceSq = FMath::Square(Config.PromotionDistance);
+	const float DemotionDistanceSq = FMath::Square(FMath::Max(Config.DemotionDistance, Config.PromotionDistance));
+
+	Transforms.Reset();
+	EntityQuery.ForEachEntityChunk(EntityManager, Context, [&](FMassExecutionContext& ChunkContext)
+	{
+		const TArrayView<FSodaTrafficAgentFragment> Agents = ChunkContext.GetMutableFragmentView<FSodaTrafficAgentFragment>();
+		const TArrayView<FSodaTrafficPromotionFragment> Promotions = ChunkContext.GetMutableFragmentView<FSodaTrafficPromotionFragment>();
+
+		for (int32 i = 0; i < ChunkContext.GetNumEntities(); ++i)
+		{
+			FSodaTrafficAgentFragment& Agent = Agents[i];
+			FSodaTrafficPromotionFragment& Promotion = Promotions[i];
+			if (!Lanes.IsValidIndex(Agent.Lane))
+			{
+				continue;
+			}
+
+			if (ASodaVehicle* Vehicle = Promotion.Vehicle.Get())
+			{
+				// Track the vehicle on the lane graph, so the agents around see its actual state
+				const FVector VehicleLocation = Vehicle->GetActorLocation();
+				const soda::FTrafficLane& Lane = Lanes[Agent.Lane];
+				Agent.Speed = Vehicle->GetVelocity().Size() * 0.01f;
+				Agent.Distance = Lane.Project(VehicleLocation, Agent.Distance, Config.VehicleLength * 2);
+				if (Agent.Distance >= Lane.Length && Lane.Successor != INDEX_NONE)
+				{
+					Agent.Lane = Lane.Successor;
+					Agent.Distance = Lanes[Agent.Lane].Project(VehicleLocation, 0, Config.VehicleLength * 2);
+				}
+
+				if (bHasEgo && FVector::DistSquared(VehicleLocation, EgoLocation) < DemotionDistanceSq)
+				{
+					continue;
+				}
+
+				Promoted.Remove(Vehicle);
+				Vehicle->Destroy();
+				Promotion.Vehicle.Reset();
+			}
+
+			const soda::FTrafficLane& Lane = Lanes[Agent.Lane];
+			FVector Location, Direction;
+			Lane.GetLocation(Agent.Distance, Location, Direction);
+			if (Agent.LaneChangeAlpha < 1 && Lanes.IsValidIndex(Agent.PrevLane))
+			{
+				const soda::FTrafficLane& PrevLane = Lanes[Agent.PrevLane];
+				FVector PrevLocation, PrevDirection;
+				PrevLane.GetLocation(Lane.MapDistance(Agent.Distance, PrevLane), PrevLocation, PrevDirection);
+				const float Alpha = FMath::SmoothStep(0.f, 1.f, Agent.LaneChangeAlpha);
+				Location = FMath::Lerp(PrevLocation, Location, Alpha);
+				Direction = FMath::Lerp(PrevDirection, Direction, Alpha).GetSafeNormal();
+			}
+			const FTransform Transform(FRotationMatrix::MakeFromX(Direction).ToQuat(), Location);
+
+			if (bCanPromote && Promoted.Num() < Config.MaxPromoted && FVector::DistSquared(Location, EgoLocation) < PromotionDistanceSq)
+			{
+				FActorSpawnParameters SpawnParameters;
+				SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+				if (ASodaVehicle* Vehicle = World->SpawnActor<ASodaVehicle>(Config.PromotedVehicleClass, Transform, SpawnParameters))
+				{
+					if (UPrimitiveComponent* Root = Cast<UPrimitiveComponent>(Vehicle->GetRootComponent()))
+					{
+						Root->SetPhysicsLinearVelocity(Direction * Agent.Speed * 100.f);
+					}
+					Promotion.Vehicle = Vehicle;
+					Promoted.Add(Vehicle);
+					continue;
+				}
+			}
+
+			Transforms.Add(Transform);
+		}
+	});
+
+	Traffic->UpdateInstances(Transforms);
+}
@@ -0,0 +1,296 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/Mass/SodaTrafficSubsystem.h"
+#include "Soda/Actors/NavigationRoute.h"
+#include "Soda/UnrealSoda.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Algo/BinarySearch.h"
+#include "Async/ParallelFor.h"
+#include "EngineUtils.h"
+
+namespace soda
+{
+
+void FTrafficLane::GetLocation(float Distance, FVector& OutLocation, FVector& OutDirection) const
+{
+	const float Key = FMath::Clamp(Distance / SampleStep, 0.f, float(Locations.Num() - 1));
+	const int32 Index = FMath::Min(int32(Key), Locations.Num() - 2);
+	const float Alpha = Key - Index;
+	OutLocation = FMath::Lerp(Locations[Index], Locations[Index + 1], Alpha);
+	OutDirection = FMath::Lerp(Directions[Index], Directions[Index + 1], Alpha).GetSafeNormal();
+}
+
+float FTrafficLane::Project(const FVector& Location, float Guess, float Window, float* OutSqDist) const
+{
+	const int32 Begin = FMath::Clamp(int32((Guess - Window) / SampleStep), 0, Locations.Num() - 2);
+	const int32 End = FMath::Clamp(int32((Guess + Window) / SampleStep) + 1, Begin + 1, Locations.Num() - 1);
+
+	int32 BestIndex = Begin;
+	float BestAlpha = 0;
+	float BestSqDist = MAX_FLT;
+	for (int32 i = Begin; i < End; ++i)
+	{
+		const FVector Segment = Locations[i + 1] - Locations[i];
+		const float Alpha = FMath::Clamp(float((Location - Locations[i]) | Segment) / FMath::Max(float(Segment.SizeSquared()), KINDA_SMALL_NUMBER), 0.f, 1.f);
+		const float SqDist = FVector::DistSquared(Locations[i] + Segment * Alpha, Location);
+		if (SqDist < BestSqDist)
+		{
+			BestSqDist = SqDist;
+			BestIndex = i;
+			BestAlpha = Alpha;
+		}
+	}
+
+	if (OutSqDist)
+	{
+		*OutSqDist = BestSqDist;
+	}
+	return FMath::Min((BestIndex + BestAlpha) * SampleStep, Length);
+}
+
+void FTrafficLane::FindNeighbours(float Distance, int32 SelfId, const FTrafficSlot*& OutLeader, const FTrafficSlot*& OutFollower) const
+{
+	OutLeader = nullptr;
+	OutFollower = nullptr;
+
+	int32 Index = Algo::UpperBoundBy(Slots, Distance, &FTrafficSlot::Distance);
+	if (Index < Slots.Num())
+	{
+		OutLeader = &Slots[Index];
+	}
+	for (--Index; Index >= 0; --Index)
+	{
+		if (Slots[Index].AgentId != SelfId || SelfId == INDEX_NONE)
+		{
+			OutFollower = &Slots[Index];
+			break;
+		}
+	}
+}
+
+void BuildTrafficLanes(const UWorld* World, float SampleStep, TArray<FTrafficLane>& OutLanes)
+{
+	OutLanes.Empty();
+
+	TMap<const ANavigationRoute*, int32> RouteToLane;
+	for (TActorIterator<ANavigationRoute> It(World); It; ++It)
+	{
+		ANavigationRoute* Route = *It;
+		if (!Route->bAllowForVehicles || Route->bDriveBackvard || !Route->Spline)
+		{
+			continue;
+		}
+
+		const float Length = Route->Spline->GetSplineLength();
+		if (Length < SampleStep)
+		{
+			continue;
+		}
+
+		FTrafficLane& Lane = OutLanes.AddDefaulted_GetRef();
+		Lane.Route = Route;
+		Lane.Length = Length;
+		Lane.Probability = Route->Probability;
+
+		const int32 SamplesNum = FMath::CeilToInt(Length / SampleStep) + 1;
+		Lane.SampleStep = Length / (SamplesNum - 1);
+		Lane.Locations.SetNum(SamplesNum);
+		Lane.Directions.SetNum(SamplesNum);
+		for (int32 i = 0; i < SamplesNum; ++i)
+		{
+			const float Distance = i * Lane.SampleStep;
+			Lane.Locations[i] = Route->Spline->GetLocationAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World);
+			Lane.Directions[i] = Route->Spline->GetDirectionAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World);
+			Lane.Bounds += Lane.Locations[i];
+		}
+
+		RouteToLane.Add(Route, OutLanes.Num() - 1);
+	}
+
+	for (FTrafficLane& Lane : OutLanes)
+	{
+		const ANavigationRoute* Route = Lane.Route.Get();
+		auto FindLane = [&RouteToLane](const TSoftObjectPtr<ANavigationRoute>& Ptr)
+		{
+			const int32* Index = RouteToLane.Find(Ptr.Get());
+			return Index ? *Index : INDEX_NONE;
+		};
+		Lane.Left = FindLane(Route->LeftRoute);
+		Lane.Right = FindLane(Route->RightRoute);
+		Lane.Successor = FindLane(Route->SuccessorRoute);
+	}
+}
+
+void BuildTrafficCrossings(TArray<FTrafficLane>& Lanes, float MaxHeightDelta)
+{
+	// Every lane writes only its own crossings
+	ParallelFor(Lanes.Num(), [&Lanes, MaxHeightDelta](int32 LaneIndex)
+	{
+		FTrafficLane& Lane = Lanes[LaneIndex];
+		Lane.Crossings.Reset();
+
+		for (int32 OtherIndex = 0; OtherIndex < Lanes.Num(); ++OtherIndex)
+		{
+			const FTrafficLane& Other = Lanes[OtherIndex];
+			if (OtherIndex == LaneIndex || OtherIndex == Lane.Left || OtherIndex == Lane.Right || !Lane.Bounds.ExpandBy(MaxHeightDelta).Intersect(Other.Bounds))
+			{
+				continue;
+			}
+
+			const float EndMargin = 2.f * FMath::Max(Lane.SampleStep, Other.SampleStep);
+			const FBox OtherBounds = Other.Bounds.ExpandBy(MaxHeightDelta);
+
+			for (int32 i = 0; i + 1 < Lane.Locations.Num(); ++i)
+			{
+				const FVector& A0 = Lane.Locations[i];
+				const FVector& A1 = Lane.Locations[i + 1];
+				if (!FBox(A0.ComponentMin(A1), A0.ComponentMax(A1)).Intersect(OtherBounds))
+				{
+					continue;
+				}
+
+				for (int32 j = 0; j + 1 < Other.Locations.Num(); ++j)
+				{
+					const FVector& B0 = Other.Locations[j];
+					const FVector& B1 = Other.Locations[j + 1];
+					FVector Point;
+					if (!FMath::SegmentIntersection2D(A0, A1, B0, B1, Point))
+					{
+						continue;
+					}
+
+					const float Alpha = FMath::Clamp(float(FVector::Dist2D(A0, Point) / FMath::Max(FVector::Dist2D(A0, A1), double(KINDA_SMALL_NUMBER))), 0.f, 1.f);
+					const float Beta = FMath::Clamp(float(FVector::Dist2D(B0, Point) / FMath::Max(FVector::Dist2D(B0, B1), double(KINDA_SMALL_NUMBER))), 0.f, 1.f);
+					if (FMath::Abs(FMath::Lerp(A0.Z, A1.Z, Alpha) - FMath::Lerp(B0.Z, B1.Z, Beta)) > MaxHeightDelta)
+					{
+						continue;
+					}
+
+					const float Distance = (i + Alpha) * Lane.SampleStep;
+					const float OtherDistance = (j + Beta) * Other.SampleStep;
+					const bool bLaneEnd = Distance < EndMargin || Distance > Lane.Length - EndMargin;
+					const bool bOtherEnd = OtherDistance < EndMargin || OtherDistance > Other.Length - EndMargin;
+					if (bLaneEnd && bOtherEnd)
+					{
+						continue;
+					}
+
+					// The neighbour segments share the samples, so the same crossing can be found twice
+					if (Lane.Crossings.Num() && Lane.Crossings.Last().OtherLane == OtherIndex && FMath::Abs(Lane.Crossings.Last().Distance - Distance) < Lane.SampleStep)
+					{
+						continue;
+					}
+
+					Lane.Crossings.Add({ Distance, OtherIndex, OtherDistance });
+				}
+			}
+		}
+
+		Lane.Crossings.Sort([](const FTrafficCrossing& A, const FTrafficCrossing& B) { return A.Distance < B.Distance; });
+	});
+}
+
+bool FindNearestTrafficLane(const TArray<FTrafficLane>& Lanes, const FVector& Location, const FVector& Direction, float MaxDistance, int32& OutLane, float& OutDistance)
+{
+	OutLane = INDEX_NONE;
+	float BestSqDist = FMath::Square(MaxDistance);
+	for (int32 i = 0; i < Lanes.Num(); ++i)
+	{
+		const FTrafficLane& Lane = Lanes[i];
+		if (!Lane.Bounds.ExpandBy(MaxDistance).IsInsideOrOn(Location))
+		{
+			continue;
+		}
+
+		float SqDist;
+		const float Distance = Lane.Project(Location, 0, Lane.Length, &SqDist);
+		if (SqDist < BestSqDist)
+		{
+			FVector LaneLocation, LaneDirection;
+			Lane.GetLocation(Distance, LaneLocation, LaneDirection);
+			if (Direction.IsZero() || (LaneDirection | Direction) > 0)
+			{
+				BestSqDist = SqDist;
+				OutLane = i;
+				OutDistance = Distance;
+			}
+		}
+	}
+	return OutLane != INDEX_NONE;
+}
+
+} // namespace soda
+
+bool USodaTrafficSubsystem::RebuildLaneGraph()
+{
+	soda::BuildTrafficLanes(GetWorld(), Config.LaneSampleStep, Lanes);
+
+	LaneWeights.Empty();
+	float Weight = 0;
+	for (const soda::FTrafficLane& Lane : Lanes)
+	{
+		Weight += Lane.Length * FMath::Max(Lane.Probability, 0.f);
+		LaneWeights.Add(Weight);
+	}
+
+	UE_LOG(LogSoda, Log, TEXT("USodaTrafficSubsystem::RebuildLaneGraph(); %i lanes"), Lanes.Num());
+
+	return Lanes.Num() > 0;
+}
+
+bool USodaTrafficSubsystem::FindNearestLane(const FVector& Location, const FVector& Direction, float MaxDistance, int32& OutLane, float& OutDistance) const
+{
+	return soda::FindNearestTrafficLane(Lanes, Location, Direction, MaxDistance, OutLane, OutDistance);
+}
+
+int32 USodaTrafficSubsystem::PickLane(float Random) const
+{
+	if (LaneWeights.Num() == 0 || LaneWeights.Last() <= 0)
+	{
+		return Lanes.Num() ? 0 : INDEX_NONE;
+	}
+	return FMath::Min(Algo::UpperBound(LaneWeights, Random * LaneWeights.Last()), LaneWeights.Num() - 1);
+}
+
+float USodaTrafficSubsystem::CalcAcceleration(float Speed, float DesiredSpeed, float Gap, float LeaderSpeed) const
+{
+	const float FreeRoad = 1.f - FMath::Square(FMath::Square(Speed / FMath::Max(DesiredSpeed, 0.1f)));
+	float Interaction = 0;
+	if (Gap < MAX_FLT)
+	{
+		const float DesiredGap = Config.MinGap + FMath::Max(0.f, Speed * Config.TimeHeadway + Speed * (Speed - LeaderSpeed) / (2.f * FMath::Sqrt(Config.MaxAcceleration * Config.ComfortDeceleration)));
+		Interaction = FMath::Square(DesiredGap / FMath::Max(Gap, 0.1f));
+	}
+	// Limit the deceleration by the physical one, the IDM gives arbitrary large values for the overlapped agents
+	return FMath::Max(Config.MaxAcceleration * (FreeRoad - Interaction), -9.f);
+}
+
+void USodaTrafficSubsystem::UpdateInstances(const TArray<FTransform>& Transforms)
+{
+	UInstancedStaticMeshComponent* Mesh = InstancedMesh.Get();
+	if (!Mesh)
+	{
+		return;
+	}
+
+	// Instances aren't bound to the agents, all of them are rewritten every frame
+	const int32 InstanceNum = Mesh->GetInstanceCount();
+	if (InstanceNum > Transforms.Num())
+	{
+		TArray<int32> Removed;
+		for (int32 i = Transforms.Num(); i < InstanceNum; ++i)
+		{
+			Removed.Add(i);
+		}
+		Mesh->RemoveInstances(Removed);
+	}
+	else if (InstanceNum < Transforms.Num())
+	{
+		Mesh->AddInstances(TArray<FTransform>(Transforms.GetData() + InstanceNum, Transforms.Num() - InstanceNum), false, true);
+	}
+
+	if (Transforms.Num())
+	{
+		Mesh->BatchUpdateInstancesTransforms(0, Transforms, true, true, true);
+	}
+}
@@ -0,0 +1,694 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/Misc/BinaryActorArchive.h"
+#include "Soda/Misc/JsonArchive.h"
+#include "Soda/Misc/SerializationHelpers.h"
+#include "Soda/UnrealSodaVersion.h"
+#include "Soda/UnrealSoda.h"
+#include "JsonObjectConverter.h"
+#include "Async/Async.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/SerializedPropertyScope.h"
+#include "GameFramework/Actor.h"
+#include "Components/SceneComponent.h"
+
+namespace
+{
+	/** Temporary initialized value of the property, used by the JSON bridge */
+	struct FScopedPropertyValue
+	{
+		explicit FScopedPropertyValue(const FProperty* InProperty)
+			: Property(InProperty)
+		{
+			Memory = (uint8*)FMemory::Malloc(Property->GetSize(), Property->GetMinAlignment());
+			Property->InitializeValue(Memory);
+		}
+
+		~FScopedPropertyValue()
+		{
+			Property->DestroyValue(Memory);
+			FMemory::Free(Memory);
+		}
+
+		const FProperty* Property;
+		uint8* Memory;
+	};
+
+	TSharedPtr<FJsonValue> PropertyToJsonValue(FProperty* Property, const uint8* Value)
+	{
+		if (Property->ArrayDim == 1)
+		{
+			return FJsonObjectConverter::UPropertyToJsonValue(Property, Value, CPF_SaveGame, 0);
+		}
+
+		TArray<TSharedPtr<FJsonValue>> Array;
+		for (int32 i = 0; i < Property->ArrayDim; ++i)
+		{
+			if (TSharedPtr<FJsonValue> Item = FJsonObjectConverter::UPropertyToJsonValue(Property, Value + i * Property->ElementSize, CPF_SaveGame, 0))
+			{
+				Array.Add(Item);
+			}
+		}
+		return MakeShared<FJsonValueArray>(Array);
+	}
+
+	bool JsonValueToProperty(const TSharedPtr<FJsonValue>& JsonValue, FProperty* Property, uint8* Value)
+	{
+		if (Property->ArrayDim == 1)
+		{
+			return FJsonObjectConverter::JsonValueToUProperty(JsonValue, Property, Value, CPF_SaveGame, 0);
+		}
+
+		const TArray<TSharedPtr<FJsonValue>>* Array;
+		if (!JsonValue->TryGetArray(Array))
+		{
+			return false;
+		}
+		const int32 Num = FMath::Min(Property->ArrayDim, Array->Num());
+		for (int32 i = 0; i < Num; ++i)
+		{
+			if (!FJsonObjectConverter::JsonValueToUProperty((*Array)[i], Property, Value + i * Property->ElementSize, CPF_SaveGame, 0))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <typename T>
+	bool TryGetJsonStruct(const TSharedPtr<FJsonObject>& JsonObject, const TCHAR* FieldName, T& OutStruct)
+	{
+		const TSharedPtr<FJsonObject>* FieldObject;
+		if (!JsonObject->TryGetObjectField(FieldName, FieldObject))
+		{
+			return false;
+		}
+		return FJsonObjectConverter::JsonObjectToUStruct(FieldObject->ToSharedRef(), &OutStruct);
+	}
+
+	TSharedPtr<FJsonObject> ObjectDataToJson(const FBinaryObjectData& ObjectData)
+	{
+		UClass* Class = FBinaryActorArchive::GetObjectClass(ObjectData);
+		if (!Class)
+		{
+			UE_LOG(LogSoda, Error, TEXT("FBinaryActorArchive::ExportJson(); Can't find class \"%s\""), *ObjectData.ClassPath);
+			return TSharedPtr<FJsonObject>();
+		}
+
+		TSharedRef<FJsonObject> JsonObject = MakeShared<FJsonObject>();
+		soda::FPropertyLayout::Get(Class)->ForEachValue(ObjectData.Data, [&JsonObject](const soda::FPropertyLayout::FEntry* Entry, const TArray<uint8>& Value)
+		{
+			if (!Entry)
+			{
+				return;
+			}
+			FScopedPropertyValue PropertyValue(Entry->Property);
+			if (soda::FPropertyLayout::LoadValue(*Entry, PropertyValue.Memory, Value))
+			{
+				if (TSharedPtr<FJsonValue> JsonValue = PropertyToJsonValue(Entry->Property, PropertyValue.Memory))
+				{
+					JsonObject->SetField(FJsonObjectConverter::StandardizeCase(Entry->Name), JsonValue);
+				}
+			}
+		});
+
+		JsonObject->SetStringField(TEXT("__class__"), ObjectData.ClassPath);
+		JsonObject->SetStringField(TEXT("__name__"), ObjectData.Name);
+		if (ObjectData.bHasTransform)
+		{
+			JsonObject->SetObjectField(TEXT("__location__"), FJsonObjectConverter::UStructToJsonObject(ObjectData.Location));
+			JsonObject->SetObjectField(TEXT("__rotation__"), FJsonObjectConverter::UStructToJsonObject(ObjectData.Rotation));
+			JsonObject->SetObjectField(TEXT("__scale3D__"), FJsonObjectConverter::UStructToJsonObject(ObjectData.Scale3D));
+		}
+		return JsonObject;
+	}
+
+	bool JsonToObjectData(FJsonActorArchive& JsonAr, const TSharedPtr<FJsonObject>& JsonObject, FBinaryObjectData& OutObjectData)
+	{
+		UClass* Class = JsonAr.GetObjectClass(JsonObject);
+		if (!Class)
+		{
+			UE_LOG(LogSoda, Error, TEXT("FBinaryActorArchive::ImportJson(); Can't find class \"%s\""), *JsonObject->GetStringField(TEXT("__class__")));
+			return false;
+		}
+
+		OutObjectData.ClassPath = Class->GetPathName();
+		OutObjectData.Name = JsonAr.GetObjectName(JsonObject);
+		OutObjectData.bHasTransform =
+			TryGetJsonStruct(JsonObject, TEXT("__location__"), OutObjectData.Location) &&
+			TryGetJsonStruct(JsonObject, TEXT("__rotation__"), OutObjectData.Rotation) &&
+			TryGetJsonStruct(JsonObject, TEXT("__scale3D__"), OutObjectData.Scale3D);
+
+		soda::FPropertyLayout::Get(Class)->SaveValues([&JsonObject](const soda::FPropertyLayout::FEntry& Entry, TArray<uint8>& OutValue)
+		{
+			TSharedPtr<FJsonValue> JsonValue = JsonObject->TryGetField(FJsonObjectConverter::StandardizeCase(Entry.Name));
+			if (!JsonValue)
+			{
+				return false;
+			}
+			FScopedPropertyValue PropertyValue(Entry.Property);
+			if (!JsonValueToProperty(JsonValue, Entry.Property, PropertyValue.Memory))
+			{
+				UE_LOG(LogSoda, Warning, TEXT("FBinaryActorArchive::ImportJson(); Can't convert \"%s\" property"), *Entry.Name);
+				return false;
+			}
+			soda::FPropertyLayout::SaveValue(Entry, PropertyValue.Memory, OutValue);
+			return true;
+		}, OutObjectData.Data);
+
+		return true;
+	}
+}
+
+/******************************************************************
+* soda::FPropertyLayout
+*******************************************************************/
+namespace soda
+{
+
+TSharedRef<const FPropertyLayout> FPropertyLayout::Get(const UStruct* Struct)
+{
+	check(Struct);
+
+	static FCriticalSection LayoutsMutex;
+	static TMap<TWeakObjectPtr<const UStruct>, TSharedRef<const FPropertyLayout>> Layouts;
+
+	FScopeLock ScopeLock(&LayoutsMutex);
+	if (const TSharedRef<const FPropertyLayout>* Layout = Layouts.Find(Struct))
+	{
+		return *Layout;
+	}
+	return Layouts.Add(Struct, MakeShared<FPropertyLayout>(Struct));
+}
+
+bool FPropertyLayout::IsPlainValue(const FProperty* Property)
+{
+	// CPF_IsPlainOldData is also set for the object pointers and the names, they must go through SerializeItem().
+	// Bitfield booleans share the byte with the neighbours and can't be copied as is
+	if (Property->IsA<FNumericProperty>() || Property->IsA<FEnumProperty>())
+	{
+		return true;
+	}
+
+	if (const FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+	{
+		const UScriptStruct* Struct = StructProperty->Struct;
+		if (!Struct || !(Struct->StructFlags & STRUCT_IsPlainOldData))
+		{
+			return false;
+		}
+		for (TFieldIterator<FProperty> It(Struct); It; ++It)
+		{
+			if (!IsPlainValue(*It))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	return false;
+}
+
+FPropertyLayout::FPropertyLayout(const UStruct* Struct)
+{
+	for (TFieldIterator<FProperty> It(Struct); It; ++It)
+	{
+		FProperty* Property = *It;
+		if (!Property->HasAnyPropertyFlags(CPF_SaveGame))
+		{
+			continue;
+		}
+
+		FEntry Entry;
+		Entry.Property = Property;
+		Entry.Name = Property->GetName();
+		// The type is a part of the hash, so the value of the changed type is skipped instead of misread
+		Entry.NameHash = FCrc::StrCrc32(*FString::Printf(TEXT("%s:%s"), *Entry.Name, *Property->GetCPPType()));
+		Entry.bPlainOldData = IsPlainValue(Property);
+
+		if (EntryByHash.Contains(Entry.NameHash))
+		{
+			UE_LOG(LogSoda, Warning, TEXT("FPropertyLayout::FPropertyLayout(); Hash collision of the \"%s\" property in \"%s\", skipped"), *Entry.Name, *Struct->GetName());
+			continue;
+		}
+
+		LayoutHash = HashCombine(LayoutHash, HashCombine(Entry.NameHash, GetTypeHash(Property->GetSize())));
+		EntryByHash.Add(Entry.NameHash, Entries.Num());
+		Entries.Add(MoveTemp(Entry));
+	}
+}
+
+const FPropertyLayout::FEntry* FPropertyLayout::FindEntry(uint32 NameHash) const
+{
+	const int32* Index = EntryByHash.Find(NameHash);
+	return Index ? &Entries[*Index] : nullptr;
+}
+
+void FPropertyLayout::SaveObject(const void* Container, TArray<uint8>& OutData) const
+{
+	SaveValues([Container](const FEntry& Entry, TArray<uint8>& OutValue)
+	{
+		SaveValue(Entry, Entry.Property->ContainerPtrToValuePtr<void>(Container), OutValue);
+		return true;
+	}, OutData);
+}
+
+void FPropertyLayout::SaveValues(TFunctionRef<bool(const FEntry& Entry, TArray<uint8>& OutValue)> Func, TArray<uint8>& OutData) const
+{
+	OutData.Reset();
+	FMemoryWriter Writer(OutData);
+
+	uint32 Hash = LayoutHash;
+	int32 Num = 0;
+	Writer << Hash;
+	const int64 NumPos = Writer.Tell();
+	Writer << Num;
+
+	TArray<uint8> Value;
+	for (const FEntry& Entry : Entries)
+	{
+		Value.Reset();
+		if (Func(Entry, Value))
+		{
+			uint32 NameHash = Entry.NameHash;
+			Writer << NameHash << Value;
+			++Num;
+		}
+	}
+
+	const int64 EndPos = Writer.Tell();
+	Writer.Seek(NumPos);
+	Writer << Num;
+	Writer.Seek(EndPos);
+}
+
+bool FPropertyLayout::LoadObject(void* Container, const TArray<uint8>& Data) const
+{
+	return ForEachValue(Data, [Container](const FEntry* Entry, const TArray<uint8>& Value)
+	{
+		if (Entry && !LoadValue(*Entry, Entry->Property->ContainerPtrToValuePtr<void>(Container), Value))
+		{
+			UE_LOG(LogSoda, Warning, TEXT("FPropertyLayout::LoadObject(); Can't load \"%s\" property"), *Entry->Name);
+		}
+	});
+}
+
+bool FPropertyLayout::ForEachValue(const TArray<uint8>& Data, TFunctionRef<void(const FEntry* Entry, const TArray<uint8>& Value)> Func) const
+{
+	FMemoryReader Reader(Data);
+
+	uint32 StoredHash = 0;
+	int32 Num = 0;
+	Reader << StoredHash << Num;
+	if (Reader.IsError() || Num < 0)
+	{
+		return false;
+	}
+
+	// Fast path: the object was saved with the same layout, the values are in the order of the entries
+	const bool bSameLayout = (StoredHash == LayoutHash) && (Num == Entries.Num());
+
+	TArray<uint8> Value;
+	for (int32 i = 0; i < Num; ++i)
+	{
+		uint32 NameHash = 0;
+		Reader << NameHash << Value;
+		if (Reader.IsError())
+		{
+			return false;
+		}
+		Func((bSameLayout && Entries[i].NameHash == NameHash) ? &Entries[i] : FindEntry(NameHash), Value);
+	}
+
+	return true;
+}
+
+void FPropertyLayout::SaveValue(const FEntry& Entry, const void* ValuePtr, TArray<uint8>& OutValue)
+{
+	FProperty* Property = Entry.Property;
+
+	if (Entry.bPlainOldData)
+	{
+		OutValue.SetNumUninitialized(Property->GetSize());
+		FMemory::Memcpy(OutValue.GetData(), ValuePtr, Property->GetSize());
+		return;
+	}
+
+	FMemoryWriter Writer(OutValue);
+	FSaveExtensionArchive Ar(Writer, false);
+	FSerializedPropertyScope SerializedProperty(Ar, Property);
+	for (int32 i = 0; i < Property->ArrayDim; ++i)
+	{
+		Property->SerializeItem(FStructuredArchiveFromArchive(Ar).GetSlot(), (uint8*)ValuePtr + i * Property->ElementSize);
+	}
+}
+
+bool FPropertyLayout::LoadValue(const FEntry& Entry, void* ValuePtr, const TArray<uint8>& Value)
+{
+	FProperty* Property = Entry.Property;
+
+	if (Entry.bPlainOldData)
+	{
+		if (Value.Num() != Property->GetSize())
+		{
+			return false;
+		}
+		FMemory::Memcpy(ValuePtr, Value.GetData(), Value.Num());
+		return true;
+	}
+
+	FMemoryReader Reader(Value);
+	FSaveExtensionArchive Ar(Reader, true);
+	FSerializedPropertyScope SerializedProperty(Ar, Property);
+	for (int32 i = 0; i < Property->ArrayDim; ++i)
+	{
+		Property->SerializeItem(FStructuredArchiveFromArchive(Ar).GetSlot(), (uint8*)ValuePtr + i * Property->ElementSize);
+	}
+	return !Reader.IsError();
+}
+
+} // namespace soda
+
+/******************************************************************
+* FBinaryObjectData
+*******************************************************************/
+FArchive& operator<<(FArchive& Ar, FBinaryObjectData& ObjectData)
+{
+	Ar << ObjectData.ClassPath;
+	Ar << ObjectData.Name;
+	Ar << ObjectData.bHasTransform;
+	if (ObjectData.bHasTransform)
+	{
+		Ar << ObjectData.Location;
+		Ar << ObjectData.Rotation;
+		Ar << ObjectData.Scale3D;
+	}
+	Ar << ObjectData.Data;
+	return Ar;
+}
+
+/******************************************************************
+* FBinaryActorArchive
+*******************************************************************/
+bool FBinaryActorArchive::SerializeObject(const UObject* Object, FBinaryObjectData& OutObjectData)
+{
+	if (!IsValid(Object))
+	{
+		return false;
+	}
+
+	OutObjectData.ClassPath = Object->GetClass()->GetPathName();
+	OutObjectData.Name = Object->GetName();
+
+	const USceneComponent* SceneComponent = nullptr;
+	if (const AActor* Actor = Cast<AActor>(Object))
+	{
+		SceneComponent = Actor->GetRootComponent();
+	}
+	else
+	{
+		SceneComponent = Cast<USceneComponent>(Object);
+	}
+	OutObjectData.bHasTransform = !!SceneComponent;
+	if (SceneComponent)
+	{
+		OutObjectData.Location = SceneComponent->GetRelativeLocation();
+		OutObjectData.Rotation = SceneComponent->GetRelativeRotation();
+		OutObjectData.Scale3D = SceneComponent->GetRelativeScale3D();
+	}
+
+	soda::FPropertyLayout::Get(Object->GetClass())->SaveObject(Object, OutObjectData.Data);
+	return true;
+}
+
+bool FBinaryActorArchive::DeserializeObject(const FBinaryObjectData& ObjectData, UObject* Object, bool bTransform)
+{
+	if (!IsValid(Object))
+	{
+		return false;
+	}
+
+	if (!soda::FPropertyLayout::Get(Object->GetClass())->LoadObject(Object, ObjectData.Data))
+	{
+		UE_LOG(LogSoda, Error, TEXT("FBinaryActorArchive::DeserializeObject(); Broken data of \"%s\""), *ObjectData.Name);
+		return false;
+	}
+
+	if (bTransform && ObjectData.bHasTransform)
+	{
+		USceneComponent* SceneComponent = nullptr;
+		if (AActor* Actor = Cast<AActor>(Object))
+		{
+			SceneComponent = Actor->GetRootComponent();
+		}
+		else
+		{
+			SceneComponent = Cast<USceneComponent>(Object);
+			if (SceneComponent && SceneComponent->GetOwner() && SceneComponent->GetOwner()->GetRootComponent() == SceneComponent)
+			{
+				SceneComponent = nullptr;
+			}
+		}
+		if (SceneComponent)
+		{
+			SceneComponent->SetRelativeLocation(ObjectData.Location, false, nullptr, ETeleportType::ResetPhysics);
+			SceneComponent->SetRelativeRotation(ObjectData.Rotation, false, nullptr, ETeleportType::ResetPhysics);
+			SceneComponent->SetRelativeScale3D(ObjectData.Scale3D);
+		}
+	}
+
+	return true;
+}
+
+bool FBinaryActorArchive::SerializeActor(const AActor* Actor, bool bWithComponents)
+{
+	Components.Reset();
+	ComponentIndices.Reset();
+
+	if (!SerializeObject(Actor, ActorData))
+	{
+		return false;
+	}
+
+	if (bWithComponents)
+	{
+		for (const UActorComponent* Component : Actor->GetComponents())
+		{
+			SerializeActorComponent(Component);
+		}
+	}
+
+	return true;
+}
+
+bool FBinaryActorArchive::DeserializeActor(AActor* Actor, bool bWithComponents) const
+{
+	if (!DeserializeObject(ActorData, Actor, false))
+	{
+		return false;
+	}
+
+	if (bWithComponents)
+	{
+		for (UActorComponent* Component : Actor->GetComponents())
+		{
+			DeserializeComponent(Component);
+		}
+	}
+
+	return true;
+}
+
+bool FBinaryActorArchive::SerializeActorComponent(const UActorComponent* ActorComponent)
+{
+	FBinaryObjectData ComponentData;
+	if (!SerializeObject(ActorComponent, ComponentData))
+	{
+		return false;
+	}
+
+	if (const int32* Index = ComponentIndices.Find(ComponentData.Name))
+	{
+		Components[*Index] = MoveTemp(ComponentData);
+	}
+	else
+	{
+		ComponentIndices.Add(ComponentData.Name, Components.Num());
+		Components.Add(MoveTemp(ComponentData));
+	}
+	return true;
+}
+
+bool FBinaryActorArchive::DeserializeComponent(UActorComponent* ActorComponent) const
+{
+	if (const FBinaryObjectData* ComponentData = FindComponent(ActorComponent->GetName()))
+	{
+		return DeserializeObject(*ComponentData, ActorComponent, true);
+	}
+	return false;
+}
+
+UClass* FBinaryActorArchive::GetObjectClass(const FBinaryObjectData& ObjectData)
+{
+	check(IsInGameThread());
+	return FSoftClassPath(ObjectData.ClassPath).TryLoadClass<UObject>();
+}
+
+const FBinaryObjectData* FBinaryActorArchive::FindComponent(const FString& Name) const
+{
+	const int32* Index = ComponentIndices.Find(Name);
+	return Index ? &Components[*Index] : nullptr;
+}
+
+bool FBinaryActorArchive::SaveToMemory(TArray<uint8>& OutData) const
+{
+	FMemoryWriter Writer(OutData, true);
+
+	uint32 FileMagic = Magic;
+	int32 Version = CurrentVersion;
+	FString SodaVersion = UNREALSODA_VERSION_STRING;
+	Writer << FileMagic << Version << SodaVersion;
+	Writer << const_cast<FBinaryObjectData&>(ActorData);
+	Writer << const_cast<TArray<FBinaryObjectData>&>(Components);
+
+	return !Writer.IsError();
+}
+
+bool FBinaryActorArchive::LoadFromMemory(const TArray<uint8>& Data)
+{
+	if (!IsBinaryArchive(Data))
+	{
+		UE_LOG(LogSoda, Error, TEXT("FBinaryActorArchive::LoadFromMemory(); Wrong magic"));
+		return false;
+	}
+
+	FMemoryReader Reader(Data, true);
+
+	uint32 FileMagic = 0;
+	int32 Version = 0;
+	FString SodaVersion;
+	Reader << FileMagic << Version << SodaVersion;
+	if (Version < MinVersion || Version > CurrentVersion)
+	{
+		UE_LOG(LogSoda, Error, TEXT("FBinaryActorArchive::LoadFromMemory(); Unsupported version %i, saved by UnrealSoda %s"), Version, *SodaVersion);
+		return false;
+	}
+
+	Reader << ActorData;
+	Reader << Components;
+	if (Reader.IsError())
+	{
+		UE_LOG(LogSoda, Error, TEXT("FBinaryActorArchive::LoadFromMemory(); Broken data"));
+		return false;
+	}
+
+	ComponentIndices.Reset();
+	for (int32 i = 0; i < Components.Num(); ++i)
+	{
+		ComponentIndices.Add(Components[i].Name, i);
+	}
+
+	return true;
+}
+
+bool FBinaryActorArchive::SaveToFile(const FString& FileName) const
+{
+	TArray<uint8> Data;
+	if (!SaveToMemory(Data))
+	{
+		return false;
+	}
+
+	if (!FFileHelper::SaveArrayToFile(Data, *FileName))
+	{
+		UE_LOG(LogSoda, Error, TEXT("FBinaryActorArchive::SaveToFile(); Can't write to '%s' file"), *FileName);
+		return false;
+	}
+	return true;
+}
+
+bool FBinaryActorArchive::LoadFromFile(const FString& FileName)
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *FileName))
+	{
+		UE_LOG(LogSoda, Warning, TEXT("FBinaryActorArchive::LoadFromFile(); Can't read '%s' file"), *FileName);
+		return false;
+	}
+	return LoadFromMemory(Data);
+}
+
+bool FBinaryActorArchive::IsBinaryArchive(const TArray<uint8>& Data)
+{
+	uint32 FileMagic = 0;
+	if (Data.Num() < sizeof(FileMagic))
+	{
+		return false;
+	}
+	FMemory::Memcpy(&FileMagic, Data.GetData(), sizeof(FileMagic));
+	return FileMagic == Magic;
+}
+
+TFuture<TSharedPtr<FBinaryActorArchive>> FBinaryActorArchive::LoadFromFileAsync(const FString& FileName)
+{
+	return Async(EAsyncExecution::ThreadPool, [FileName]()
+	{
+		TSharedPtr<FBinaryActorArchive> Ar = MakeShared<FBinaryActorArchive>();
+		return Ar->LoadFromFile(FileName) ? Ar : TSharedPtr<FBinaryActorArchive>();
+	});
+}
+
+bool FBinaryActorArchive::ImportJson(FJsonActorArchive& JsonAr)
+{
+	Components.Reset();
+	ComponentIndices.Reset();
+
+	if (!JsonAr.RootJsonObject || !JsonToObjectData(JsonAr, JsonAr.RootJsonObject, ActorData))
+	{
+		return false;
+	}
+
+	if (JsonAr.Components)
+	{
+		for (auto& It : JsonAr.Components->Values)
+		{
+			TSharedPtr<FJsonObject> ComponentObject = It.Value->AsObject();
+			FBinaryObjectData ComponentData;
+			if (ComponentObject && JsonToObjectData(JsonAr, ComponentObject, ComponentData))
+			{
+				ComponentData.Name = It.Key;
+				ComponentIndices.Add(It.Key, Components.Num());
+				Components.Add(MoveTemp(ComponentData));
+			}
+		}
+	}
+
+	return true;
+}
+
+bool FBinaryActorArchive::ExportJson(FJsonActorArchive& JsonAr) const
+{
+	TSharedPtr<FJsonObject> RootJsonObject = ObjectDataToJson(ActorData);
+	if (!RootJsonObject)
+	{
+		return false;
+	}
+
+	JsonAr.RootJsonObject = RootJsonObject;
+	JsonAr.Components = MakeShared<FJsonObject>();
+	RootJsonObject->SetStringField(TEXT("__unreal_soda_ver__"), UNREALSODA_VERSION_STRING);
+	RootJsonObject->SetObjectField(TEXT("__components__"), JsonAr.Components);
+
+	for (const FBinaryObjectData& ComponentData : Components)
+	{
+		if (TSharedPtr<FJsonObject> ComponentObject = ObjectDataToJson(ComponentData))
+		{
+			JsonAr.Components->SetObjectField(ComponentData.Name, ComponentObject);
+		}
+	}
+
+	return true;
+}
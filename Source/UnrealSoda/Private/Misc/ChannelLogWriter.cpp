@@ -0,0 +1,261 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/Misc/ChannelLogWriter.h"
+#include "Soda/UnrealSoda.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+/** [bytes] The formatted text is compressed and written by the blocks of this size */
+static constexpr int32 TextBlockSize = 1024 * 1024;
+
+/** [ms] */
+static constexpr uint32 WorkerPeriodMs = 100;
+
+namespace soda
+{
+
+FChannelLogWriter::~FChannelLogWriter()
+{
+	Close();
+}
+
+bool FChannelLogWriter::Open(const FString& InFileName, EChannelLogFormat InFormat, const TArray<FColumn>& Columns)
+{
+	Close();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(InFileName));
+	File = PlatformFile.OpenWrite(*InFileName);
+	if (!File)
+	{
+		UE_LOG(LogSoda, Error, TEXT("FChannelLogWriter::Open(); Can't open \"%s\""), *InFileName);
+		return false;
+	}
+
+	FileName = InFileName;
+	Format = InFormat;
+	ColumnsNum = Columns.Num();
+	Values.SetNumZeroed(Capacity * ColumnsNum);
+	Timestamps.SetNumZeroed(Capacity);
+	Head = 0;
+	Tail = 0;
+	WrittenRows = 0;
+	DroppedRows = 0;
+	WrittenBytes = 0;
+
+	if (!WriteSchema(Columns))
+	{
+		UE_LOG(LogSoda, Warning, TEXT("FChannelLogWriter::Open(); Can't write the schema of \"%s\""), *FileName);
+	}
+
+	Text.Reset(TextBlockSize + 4096);
+	auto AppendText = [this](const FString& Str)
+	{
+		FTCHARToUTF8 UTF8(*Str);
+		Text.Append(UTF8.Get(), UTF8.Length());
+	};
+	AppendText(TEXT("timestamp_ns"));
+	for (const auto& Column : Columns)
+	{
+		AppendText(Column.Name.Contains(TEXT(",")) ? TEXT(",\"") + Column.Name + TEXT("\"") : TEXT(",") + Column.Name);
+	}
+	Text.Add('\n');
+
+	bStopping = false;
+	WakeUpEvent = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("ChannelLogWriter"), 0, TPri_BelowNormal);
+
+	return true;
+}
+
+bool FChannelLogWriter::WriteSchema(const TArray<FColumn>& Columns) const
+{
+	TSharedRef<FJsonObject> Schema = MakeShared<FJsonObject>();
+	Schema->SetStringField(TEXT("format"), Format == EChannelLogFormat::CSVGzip ? TEXT("csv.gz") : TEXT("csv"));
+
+	TArray<TSharedPtr<FJsonValue>> JsonColumns;
+	TSharedRef<FJsonObject> TimestampColumn = MakeShared<FJsonObject>();
+	TimestampColumn->SetStringField(TEXT("name"), TEXT("timestamp_ns"));
+	TimestampColumn->SetStringField(TEXT("type"), TEXT("int64"));
+	JsonColumns.Add(MakeShared<FJsonValueObject>(TimestampColumn));
+	for (const auto& Column : Columns)
+	{
+		TSharedRef<FJsonObject> JsonColumn = MakeShared<FJsonObject>();
+		JsonColumn->SetStringField(TEXT("name"), Column.Name);
+		JsonColumn->SetStringField(TEXT("type"), TEXT("float64"));
+		JsonColumn->SetStringField(TEXT("source"), Column.Source);
+		JsonColumns.Add(MakeShared<FJsonValueObject>(JsonColumn));
+	}
+	Schema->SetArrayField(TEXT("columns"), JsonColumns);
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	return FJsonSerializer::Serialize(Schema, Writer) && FFileHelper::SaveStringToFile(Json, *(FileName + TEXT(".schema.json")));
+}
+
+void FChannelLogWriter::Close()
+{
+	if (Thread)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (WakeUpEvent)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeUpEvent);
+		WakeUpEvent = nullptr;
+	}
+
+	if (File)
+	{
+		delete File;
+		File = nullptr;
+
+		UE_LOG(LogSoda, Log, TEXT("FChannelLogWriter::Close(); \"%s\": %lld rows, %lld bytes, %lld rows dropped"),
+			*FileName, int64(WrittenRows), int64(WrittenBytes), int64(DroppedRows));
+	}
+
+	Values.Empty();
+	Timestamps.Empty();
+	Text.Empty();
+	Compressed.Empty();
+}
+
+double* FChannelLogWriter::BeginRow(const TTimestamp& Timestamp)
+{
+	if (!Thread)
+	{
+		return nullptr;
+	}
+
+	const uint64 Row = Head;
+	if (Row - Tail >= uint64(Capacity))
+	{
+		++DroppedRows;
+		return nullptr;
+	}
+
+	const int32 Slot = int32(Row % Capacity);
+	Timestamps[Slot] = RawTimestamp<std::chrono::nanoseconds>(Timestamp);
+	return &Values[Slot * ColumnsNum];
+}
+
+void FChannelLogWriter::CommitRow()
+{
+	const uint64 Row = Head + 1;
+	Head = Row;
+
+	// Wake up the worker before the ring is full; it also wakes up by itself every WorkerPeriodMs
+	if (Row % FMath::Max(Capacity / 4, 1) == 0)
+	{
+		WakeUpEvent->Trigger();
+	}
+}
+
+void FChannelLogWriter::FormatRow(uint64 Row)
+{
+	const int32 Slot = int32(Row % Capacity);
+	const double* RowValues = &Values[Slot * ColumnsNum];
+
+	// The widest "%.9g" is 16 characters + the separator
+	const int32 Offset = Text.AddUninitialized(24 + ColumnsNum * 24);
+	ANSICHAR* Dst = Text.GetData() + Offset;
+	ANSICHAR* const Begin = Dst;
+
+	Dst += FCStringAnsi::Sprintf(Dst, "%lld", Timestamps[Slot]);
+	for (int32 i = 0; i < ColumnsNum; ++i)
+	{
+		Dst += FCStringAnsi::Sprintf(Dst, ",%.9g", RowValues[i]);
+	}
+	*Dst++ = '\n';
+
+	Text.SetNum(Offset + int32(Dst - Begin), false);
+}
+
+void FChannelLogWriter::FlushText()
+{
+	if (!Text.Num())
+	{
+		return;
+	}
+
+	const uint8* Data = reinterpret_cast<const uint8*>(Text.GetData());
+	int32 Size = Text.Num();
+
+	if (Format == EChannelLogFormat::CSVGzip)
+	{
+		int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Gzip, Size);
+		Compressed.SetNumUninitialized(CompressedSize, false);
+		if (FCompression::CompressMemory(NAME_Gzip, Compressed.GetData(), CompressedSize, Data, Size))
+		{
+			Data = Compressed.GetData();
+			Size = CompressedSize;
+		}
+		else
+		{
+			UE_LOG(LogSoda, Error, TEXT("FChannelLogWriter::FlushText(); Can't compress the block of \"%s\""), *FileName);
+			Size = 0;
+		}
+	}
+
+	if (Size && File->Write(Data, Size))
+	{
+		WrittenBytes += Size;
+	}
+	Text.Reset();
+}
+
+uint32 FChannelLogWriter::Run()
+{
+	while (true)
+	{
+		WakeUpEvent->Wait(WorkerPeriodMs);
+		const bool bStop = bStopping;
+
+		const uint64 Available = Head;
+		uint64 Row = Tail;
+		for (; Row < Available; ++Row)
+		{
+			FormatRow(Row);
+
+			// Release the slot as soon as it is formatted
+			Tail = Row + 1;
+			++WrittenRows;
+
+			if (Text.Num() >= TextBlockSize)
+			{
+				FlushText();
+			}
+		}
+
+		if (bStop)
+		{
+			FlushText();
+			File->Flush();
+			break;
+		}
+	}
+
+	return 0;
+}
+
+void FChannelLogWriter::Stop()
+{
+	bStopping = true;
+	if (WakeUpEvent)
+	{
+		WakeUpEvent->Trigger();
+	}
+}
+
+} // namespace soda
@@ -3,6 +3,8 @@
 #include "Soda/Misc/LLConverter.h"
 #include "Soda/Misc/Utils.h"
 #include "Math/RotationMatrix.h"
+#include "Soda/UnrealSoda.h"
+#include "proj.h"
 
 #define _DEG2RAD(a) ((a) / (180.0 / M_PI))
 #define _RAD2DEG(a) ((a) * (180.0 / M_PI))
@@ -180,3 +182,222 @@ void FLLConverter::EnuToEcef(double xEast, double yNorth, double zUp, double & x
 	y = yd + y0;
 	z = zd + z0;
 }
+
+FVector FLLConverter::EnuToUEDir(double xEast, double yNorth, double zUp) const
+{
+	FVector Dir = FVector(-xEast, yNorth, zUp) * 100.0;
+	if (OrignDYaw != 0) Dir = Dir.RotateAngleAxis(OrignDYaw, FVector(0, 0, 1));
+	return Dir;
+}
+
+bool FLLConverter::IsSameOrign(const FLLConverter& Other) const
+{
+	return OrignLat == Other.OrignLat && OrignLon == Other.OrignLon && OrignAltitude == Other.OrignAltitude && OrignShift == Other.OrignShift && OrignDYaw == Other.OrignDYaw;
+}
+
+void FLLConverter::LLA2UE(TArrayView<const FVector> InLonLatAlt, TArrayView<FVector> OutPositions, double MaxLinearError) const
+{
+	check(InLonLatAlt.Num() == OutPositions.Num());
+
+	const int Num = InLonLatAlt.Num();
+	if (Num == 0)
+	{
+		return;
+	}
+
+	if (MaxLinearError > 0)
+	{
+		FVector Min = InLonLatAlt[0];
+		FVector Max = InLonLatAlt[0];
+		for (const FVector& Pt : InLonLatAlt)
+		{
+			Min = Min.ComponentMin(Pt);
+			Max = Max.ComponentMax(Pt);
+		}
+		const FVector Ref = (Min + Max) * 0.5;
+		const FVector HalfExtent = (Max - Min) * 0.5;
+
+		const double Lat = _DEG2RAD(Ref.Y);
+		const double Lon = _DEG2RAD(Ref.X);
+		const double SinLat = std::sin(Lat);
+		const double CosLat = std::cos(Lat);
+		const double SinLon = std::sin(Lon);
+		const double CosLon = std::cos(Lon);
+		const double W = 1 - earth_e_sq * SinLat * SinLat;
+		const double N = earth_a / std::sqrt(W);
+		const double M = earth_a * (1 - earth_e_sq) / (W * std::sqrt(W));
+
+		// Second order terms of the geodetic-to-tangent-plane map: the curvature of the meridian and the prime vertical,
+		// the convergence of the meridians and the scale change with the altitude
+		const double DNorth = _DEG2RAD(HalfExtent.Y) * (M + Ref.Z);
+		const double DEast = _DEG2RAD(HalfExtent.X) * (N + Ref.Z) * CosLat;
+		const double D = std::sqrt(DNorth * DNorth + DEast * DEast);
+		const double ErrorBound = (D * D * (1 + std::abs(SinLat / CosLat)) + 2 * D * HalfExtent.Z) / (2 * earth_b * earth_b / earth_a) * 100;
+
+		if (ErrorBound < MaxLinearError)
+		{
+			FVector RefPos;
+			LLA2UE(RefPos, Ref.X, Ref.Y, Ref.Z);
+
+			// Columns of the Jacobian: the local East, North and Up axes at Ref expressed in the origin ENU frame
+			auto ToOriginEnu = [this](double x, double y, double z)
+			{
+				double e, n, u;
+				EcefToEnu(x + x0, y + y0, z + z0, e, n, u);
+				return EnuToUEDir(e, n, u);
+			};
+			const FVector DLon = ToOriginEnu(-SinLon, CosLon, 0) * ((N + Ref.Z) * CosLat * _DEG2RAD(1.0));
+			const FVector DLat = ToOriginEnu(-SinLat * CosLon, -SinLat * SinLon, CosLat) * ((M + Ref.Z) * _DEG2RAD(1.0));
+			const FVector DAlt = ToOriginEnu(CosLat * CosLon, CosLat * SinLon, SinLat);
+
+			for (int i = 0; i < Num; ++i)
+			{
+				const FVector Delta = InLonLatAlt[i] - Ref;
+				OutPositions[i] = RefPos + DLon * Delta.X + DLat * Delta.Y + DAlt * Delta.Z;
+			}
+			return;
+		}
+	}
+
+	const double CosYaw = std::cos(_DEG2RAD(OrignDYaw));
+	const double SinYaw = std::sin(_DEG2RAD(OrignDYaw));
+
+	for (int i = 0; i < Num; ++i)
+	{
+		const FVector& In = InLonLatAlt[i];
+		double x, y, z;
+		GeodeticToEcef(In.Y, In.X, In.Z, x, y, z);
+		double xEast, yNorth, zUp;
+		EcefToEnu(x, y, z, xEast, yNorth, zUp);
+
+		const double X = -xEast * 100.0;
+		const double Y = yNorth * 100.0;
+		OutPositions[i] = FVector(X * CosYaw - Y * SinYaw, X * SinYaw + Y * CosYaw, zUp * 100.0) + OrignShift;
+	}
+}
+
+void FLLConverter::UE2LLA(TArrayView<const FVector> InPositions, TArrayView<FVector> OutLonLatAlt) const
+{
+	check(InPositions.Num() == OutLonLatAlt.Num());
+
+	const double CosYaw = std::cos(_DEG2RAD(OrignDYaw));
+	const double SinYaw = std::sin(_DEG2RAD(OrignDYaw));
+
+	for (int i = 0; i < InPositions.Num(); ++i)
+	{
+		const FVector Pos = InPositions[i] - OrignShift;
+		const double X = Pos.X * CosYaw + Pos.Y * SinYaw;
+		const double Y = -Pos.X * SinYaw + Pos.Y * CosYaw;
+
+		double x, y, z;
+		EnuToEcef(-X / 100.0, Y / 100.0, Pos.Z / 100.0, x, y, z);
+
+		double Lat, Lon, Alt;
+		EcefToGeodeticVermeille(x, y, z, Lat, Lon, Alt);
+		OutLonLatAlt[i] = FVector(Lon, Lat, Alt);
+	}
+}
+
+void FLLConverter::EcefToGeodeticVermeille(double x, double y, double z, double & lat, double & lon, double & h)
+{
+	static const double e4 = earth_e_sq * earth_e_sq;
+
+	const double p = (x * x + y * y) / (earth_a * earth_a);
+	const double q = (1 - earth_e_sq) / (earth_a * earth_a) * z * z;
+	const double r = (p + q - e4) / 6;
+	const double s = e4 * p * q / (4 * r * r * r);
+	const double t = std::cbrt(1 + s + std::sqrt(s * (2 + s)));
+	const double u = r * (1 + t + 1 / t);
+	const double v = std::sqrt(u * u + e4 * q);
+	const double w = earth_e_sq * (u + v - q) / (2 * v);
+	const double k = std::sqrt(u + v + w * w) - w;
+	const double xy = std::sqrt(x * x + y * y);
+	const double D = k * xy / (k + earth_e_sq);
+	const double Dz = std::sqrt(D * D + z * z);
+
+	lat = _RAD2DEG(2 * std::atan2(z, D + Dz));
+	lon = _RAD2DEG(std::atan2(y, x));
+	h = (k + earth_e_sq - 1) / k * Dz;
+}
+
+FUTMConverter::~FUTMConverter()
+{
+	Reset();
+}
+
+void FUTMConverter::Reset()
+{
+	if (Proj)
+	{
+		proj_destroy(Proj);
+		Proj = nullptr;
+	}
+}
+
+bool FUTMConverter::Init(int Zone, bool bNorth)
+{
+	Reset();
+
+	if (Zone < 1 || Zone > 60)
+	{
+		UE_LOG(LogSoda, Error, TEXT("FUTMConverter::Init(); Wrong UTM zone %i"), Zone);
+		return false;
+	}
+
+	// Pipeline from the proj-string doesn't need proj.db
+	const FString Definition = FString::Printf(
+		TEXT("+proj=pipeline +step +proj=unitconvert +xy_in=deg +xy_out=rad +step +proj=utm +zone=%i%s +ellps=WGS84"),
+		Zone, bNorth ? TEXT("") : TEXT(" +south"));
+
+	Proj = proj_create(PJ_DEFAULT_CTX, TCHAR_TO_UTF8(*Definition));
+	if (!Proj)
+	{
+		UE_LOG(LogSoda, Error, TEXT("FUTMConverter::Init(); Can't create \"%s\": %s"), *Definition, UTF8_TO_TCHAR(proj_errno_string(proj_context_errno(PJ_DEFAULT_CTX))));
+		return false;
+	}
+	return true;
+}
+
+int FUTMConverter::GetZone(double Lon)
+{
+	return FMath::Clamp(int(FMath::FloorToDouble((Lon + 180.0) / 6.0)) + 1, 1, 60);
+}
+
+bool FUTMConverter::LLA2UTM(TArrayView<const FVector> InLonLatAlt, TArrayView<FVector> OutUTM) const
+{
+	return Transform(InLonLatAlt, OutUTM, true);
+}
+
+bool FUTMConverter::UTM2LLA(TArrayView<const FVector> InUTM, TArrayView<FVector> OutLonLatAlt) const
+{
+	return Transform(InUTM, OutLonLatAlt, false);
+}
+
+bool FUTMConverter::Transform(TArrayView<const FVector> In, TArrayView<FVector> Out, bool bForward) const
+{
+	check(In.Num() == Out.Num());
+	static_assert(sizeof(FVector) == 3 * sizeof(double), "FVector must be double precision");
+
+	if (!Proj)
+	{
+		return false;
+	}
+	if (Out.Num() == 0)
+	{
+		return true;
+	}
+
+	if (In.GetData() != Out.GetData())
+	{
+		FMemory::Memcpy(Out.GetData(), In.GetData(), In.Num() * sizeof(FVector));
+	}
+
+	// Transform in place, the coordinates are strided by FVector
+	const size_t Num = Out.Num();
+	const size_t Transformed = proj_trans_generic(Proj, bForward ? PJ_FWD : PJ_INV,
+		&Out[0].X, sizeof(FVector), Num,
+		&Out[0].Y, sizeof(FVector), Num,
+		nullptr, 0, 0,
+		nullptr, 0, 0);
+	return Transformed == Num;
+}
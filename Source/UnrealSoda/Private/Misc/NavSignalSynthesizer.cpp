@@ -0,0 +1,144 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/Misc/NavSignalSynthesizer.h"
+#include "Misc/ScopeLock.h"
+
+namespace soda
+{
+
+void FNavSignalSynthesizer::Reset(int InCapacity)
+{
+	FScopeLock ScopeLock(&Lock);
+	Knots.SetNum(FMath::Max(InCapacity, 2));
+	Head = 0;
+	Num = 0;
+	Origin = TTimestamp{};
+}
+
+void FNavSignalSynthesizer::Push(const TTimestamp& Timestamp, int64 FrameIndex, const FPhysBodyKinematic& VehicleKinematic)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (Knots.Num() == 0)
+	{
+		return;
+	}
+
+	if (Num == 0)
+	{
+		Origin = Timestamp;
+	}
+
+	const double Time = std::chrono::duration<double>(Timestamp - Origin).count();
+	if (Num > 0 && Time <= GetKnot(Num - 1).Time)
+	{
+		return;
+	}
+
+	FKnot& Knot = Knots[Head];
+	Knot.Time = Time;
+	Knot.FrameIndex = FrameIndex;
+	Knot.Location = VehicleKinematic.Curr.GlobalPose.GetTranslation();
+	Knot.Velocity = VehicleKinematic.Curr.GetGlobalVelocityAtLocalPoint(FVector::ZeroVector);
+	Knot.Rotation = VehicleKinematic.Curr.GlobalPose.GetRotation();
+	CenterOfMassLocal = VehicleKinematic.Curr.CenterOfMassLocal;
+
+	Head = (Head + 1) % Knots.Num();
+	Num = FMath::Min(Num + 1, Knots.Num());
+}
+
+bool FNavSignalSynthesizer::GetTimeRange(double& OutBegin, double& OutEnd) const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (Num < 2)
+	{
+		return false;
+	}
+	OutBegin = GetKnot(0).Time;
+	OutEnd = GetKnot(Num - 1).Time;
+	return true;
+}
+
+bool FNavSignalSynthesizer::Sample(double Time, FNavSynthState& Out) const
+{
+	FScopeLock ScopeLock(&Lock);
+	return SampleLocked(Time, Out);
+}
+
+bool FNavSignalSynthesizer::SampleLocked(double Time, FNavSynthState& Out) const
+{
+	if (Num < 2 || Time < GetKnot(0).Time || Time > GetKnot(Num - 1).Time)
+	{
+		return false;
+	}
+
+	// Samples are requested close to the newest knot, so search from the end
+	int i = Num - 2;
+	while (i > 0 && GetKnot(i).Time > Time)
+	{
+		--i;
+	}
+
+	const FKnot& K0 = GetKnot(i);
+	const FKnot& K1 = GetKnot(i + 1);
+	const double Dt = K1.Time - K0.Time;
+	const double S = (Time - K0.Time) / Dt;
+	const double S2 = S * S;
+	const double S3 = S2 * S;
+
+	const double H00 = 2 * S3 - 3 * S2 + 1;
+	const double H10 = S3 - 2 * S2 + S;
+	const double H01 = -2 * S3 + 3 * S2;
+	const double H11 = S3 - S2;
+	Out.Location = K0.Location * H00 + K0.Velocity * (H10 * Dt) + K1.Location * H01 + K1.Velocity * (H11 * Dt);
+
+	const double D00 = 6 * S2 - 6 * S;
+	const double D10 = 3 * S2 - 4 * S + 1;
+	const double D01 = -6 * S2 + 6 * S;
+	const double D11 = 3 * S2 - 2 * S;
+	Out.Velocity = (K0.Location * D00 + K1.Location * D01) / Dt + K0.Velocity * D10 + K1.Velocity * D11;
+
+	Out.Rotation = FQuat::Slerp(K0.Rotation, K1.Rotation, S).GetNormalized();
+	Out.Time = Time;
+	Out.Timestamp = Origin + std::chrono::duration_cast<TTimestamp::duration>(std::chrono::duration<double>(Time));
+	Out.FrameIndex = S < 1 ? K0.FrameIndex : K1.FrameIndex;
+	return true;
+}
+
+bool FNavSignalSynthesizer::MakeKinematic(double T0, double T1, FPhysBodyKinematic& Out, FNavSynthState& OutState) const
+{
+	FNavSynthState S0, S1;
+	FVector CenterOfMass;
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (T1 <= T0 || !SampleLocked(T0, S0) || !SampleLocked(T1, S1))
+		{
+			return false;
+		}
+		CenterOfMass = CenterOfMassLocal;
+	}
+
+	const double Dt = T1 - T0;
+	const FVector AngularVelocity = QLog((S0.Rotation.Inverse() * S1.Rotation).GetNormalized()) / Dt;
+
+	auto ToState = [&CenterOfMass, &AngularVelocity](const FNavSynthState& S, FPhysBodyKinematic::FState& State)
+	{
+		State.GlobalPose = FTransform(S.Rotation, S.Location, FVector(1.0));
+		State.CenterOfMassLocal = CenterOfMass;
+		State.AngularVelocity = AngularVelocity;
+		// Knot velocities are of the reference point, move them to the center of mass
+		State.GlobalVelocityOfCenterMass = S.Velocity + S.Rotation.RotateVector(AngularVelocity ^ CenterOfMass);
+	};
+
+	ToState(S0, Out.Prev);
+	ToState(S1, Out.Curr);
+	Out.Curr.GlobalAcceleration = (S1.Velocity - S0.Velocity) / Dt;
+	Out.Prev.GlobalAcceleration = Out.Curr.GlobalAcceleration;
+	Out.Deltatime = Dt;
+
+	OutState = S1;
+	return true;
+}
+
+} // namespace soda
@@ -0,0 +1,100 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/Misc/NoiseEngine.h"
+#include "Soda/LevelState.h"
+#include "Components/ActorComponent.h"
+#include "GameFramework/Actor.h"
+#include "Misc/Crc.h"
+
+namespace soda
+{
+
+/** Map uint32 to (0, 1), never returns 0 so it is safe for log() */
+static FORCEINLINE float ToUnitFloat(uint32 Value)
+{
+	return float(Value >> 8) * (1.f / 16777216.f) + (0.5f / 16777216.f);
+}
+
+uint64 FNoiseStream::MakeKey(const UActorComponent* Sensor)
+{
+	uint32 Seed = 0;
+	if (ALevelState* LevelState = ALevelState::Get())
+	{
+		Seed = uint32(LevelState->NoiseSeed);
+	}
+
+	uint32 SensorId = 0;
+	if (Sensor)
+	{
+		if (const AActor* Owner = Sensor->GetOwner())
+		{
+			SensorId = FCrc::StrCrc32(*Owner->GetName());
+		}
+		SensorId = FCrc::StrCrc32(*Sensor->GetName(), SensorId);
+	}
+
+	return MakeKey(Seed, SensorId);
+}
+
+uint64 FNoiseStream::MakeKey(uint32 Seed, uint32 SensorId)
+{
+	// Whiten the key so that close seeds and IDs give unrelated streams
+	uint32 Out[4];
+	FPhilox4x32::Generate(0x5EED5EED5EED5EEDull, { Seed, SensorId, 0, 0 }, Out);
+	return (uint64(Out[1]) << 32) | Out[0];
+}
+
+void FNoiseStream::Gaussian(uint64 Frame, uint32 Channel, uint32 Index, float* Out, int Num, float StdDev) const
+{
+	// Every Philox block gives two Box-Muller pairs, i.e. samples [4 * Block, 4 * Block + 4)
+	uint32 Block = Index >> 2;
+	int Skip = Index & 3;
+	int Written = 0;
+	while (Written < Num)
+	{
+		uint32 Bits[4];
+		FPhilox4x32::Generate(Key, { Block, Channel, uint32(Frame), uint32(Frame >> 32) }, Bits);
+
+		float Normals[4];
+		for (int i = 0; i < 4; i += 2)
+		{
+			const float R = FMath::Sqrt(-2.f * FMath::Loge(ToUnitFloat(Bits[i]))) * StdDev;
+			float S, C;
+			FMath::SinCos(&S, &C, ToUnitFloat(Bits[i + 1]) * TWO_PI);
+			Normals[i] = R * C;
+			Normals[i + 1] = R * S;
+		}
+
+		const int Count = FMath::Min(4 - Skip, Num - Written);
+		for (int i = 0; i < Count; ++i)
+		{
+			Out[Written + i] = Normals[Skip + i];
+		}
+		Written += Count;
+		Skip = 0;
+		++Block;
+	}
+}
+
+void FNoiseStream::Uniform(uint64 Frame, uint32 Channel, uint32 Index, float* Out, int Num) const
+{
+	uint32 Block = Index >> 2;
+	int Skip = Index & 3;
+	int Written = 0;
+	while (Written < Num)
+	{
+		uint32 Bits[4];
+		FPhilox4x32::Generate(Key, { Block, Channel, uint32(Frame), uint32(Frame >> 32) }, Bits);
+
+		const int Count = FMath::Min(4 - Skip, Num - Written);
+		for (int i = 0; i < Count; ++i)
+		{
+			Out[Written + i] = ToUnitFloat(Bits[Skip + i]);
+		}
+		Written += Count;
+		Skip = 0;
+		++Block;
+	}
+}
+
+} // namespace soda
@@ -0,0 +1,161 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/Misc/RouteTracker.h"
+#include "Components/SplineComponent.h"
+
+FRouteTracker::FRouteTracker(float InStep)
+	: Step(FMath::Max(InStep, 1.f))
+{
+}
+
+void FRouteTracker::Reset()
+{
+	Samples.Reset();
+	TrackedOffset = 0;
+	Carry = 0;
+}
+
+void FRouteTracker::AddPoint(const FVector& Point)
+{
+	if (Samples.Num() == 0)
+	{
+		Samples.Add(Point);
+		LastPoint = Point;
+		Carry = Step;
+		return;
+	}
+
+	const FVector Segment = Point - LastPoint;
+	const float Length = Segment.Size();
+	if (Length < KINDA_SMALL_NUMBER)
+	{
+		return;
+	}
+
+	float At = Carry;
+	for (; At <= Length; At += Step)
+	{
+		Samples.Add(LastPoint + Segment * (At / Length));
+	}
+	Carry = At - Length;
+	LastPoint = Point;
+}
+
+void FRouteTracker::AddSpline(const USplineComponent* Spline, float StartDistance)
+{
+	check(Spline);
+
+	// Sample the spline twice as dense as the route, so the chords are close to the arc
+	const float Length = Spline->GetSplineLength();
+	for (float Distance = FMath::Max(StartDistance, 0.f); Distance < Length; Distance += Step * 0.5f)
+	{
+		AddPoint(Spline->GetLocationAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World));
+	}
+	AddPoint(Spline->GetLocationAtDistanceAlongSpline(Length, ESplineCoordinateSpace::World));
+}
+
+void FRouteTracker::Track(const FVector& Location)
+{
+	if (IsEmpty())
+	{
+		return;
+	}
+
+	auto SqDistToSegment = [this, &Location](int32 Index, float& OutAlpha)
+	{
+		const FVector& Start = Samples[Index];
+		const FVector Segment = Samples[Index + 1] - Start;
+		OutAlpha = FMath::Clamp(float((Location - Start) | Segment) / FMath::Max(float(Segment.SizeSquared()), KINDA_SMALL_NUMBER), 0.f, 1.f);
+		return float(FVector::DistSquared(Start + Segment * OutAlpha, Location));
+	};
+
+	int32 Index = GetTrackedIndex();
+	float Alpha;
+	float BestSqDist = SqDistToSegment(Index, Alpha);
+
+	// The vehicle moves only a few samples per tick, so the local search from the previous segment is enough
+	while (Index + 2 < Samples.Num())
+	{
+		float NextAlpha;
+		const float SqDist = SqDistToSegment(Index + 1, NextAlpha);
+		if (SqDist > BestSqDist)
+		{
+			break;
+		}
+		BestSqDist = SqDist;
+		Alpha = NextAlpha;
+		++Index;
+	}
+	while (Index > 0)
+	{
+		float PrevAlpha;
+		const float SqDist = SqDistToSegment(Index - 1, PrevAlpha);
+		if (SqDist >= BestSqDist)
+		{
+			break;
+		}
+		BestSqDist = SqDist;
+		Alpha = PrevAlpha;
+		--Index;
+	}
+
+	TrackedOffset = (Index + Alpha) * Step;
+
+	const int32 PopNum = Index - KeepBehind;
+	if (PopNum > 0)
+	{
+		Samples.PopFront(PopNum);
+		TrackedOffset -= PopNum * Step;
+	}
+}
+
+int32 FRouteTracker::Locate(float Ahead, float& OutAlpha) const
+{
+	const float Key = FMath::Clamp((TrackedOffset + Ahead) / Step, 0.f, float(Samples.Num() - 1));
+	const int32 Index = FMath::Min(int32(Key), Samples.Num() - 2);
+	OutAlpha = Key - Index;
+	return Index;
+}
+
+FVector FRouteTracker::GetLocationAhead(float Ahead) const
+{
+	if (IsEmpty())
+	{
+		return Samples.Num() ? Samples.First() : FVector::ZeroVector;
+	}
+
+	float Alpha;
+	const int32 Index = Locate(Ahead, Alpha);
+	return FMath::Lerp(Samples[Index], Samples[Index + 1], Alpha);
+}
+
+FVector FRouteTracker::GetDirectionAhead(float Ahead) const
+{
+	if (IsEmpty())
+	{
+		return FVector::ForwardVector;
+	}
+
+	// Central differences at the samples blended along the segment, so the direction is continuous
+	auto SampleDirection = [this](int32 Index)
+	{
+		return (Samples[FMath::Min(Index + 1, Samples.Num() - 1)] - Samples[FMath::Max(Index - 1, 0)]).GetSafeNormal();
+	};
+
+	float Alpha;
+	const int32 Index = Locate(Ahead, Alpha);
+	return FMath::Lerp(SampleDirection(Index), SampleDirection(Index + 1), Alpha).GetSafeNormal();
+}
+
+float FRouteTracker::GetTurnAngleAhead(float Ahead) const
+{
+	if (Samples.Num() < 3)
+	{
+		return 0;
+	}
+
+	const int32 Index = FMath::Clamp(FMath::RoundToInt((TrackedOffset + Ahead) / Step), 1, Samples.Num() - 2);
+	const FVector In = Samples[Index] - Samples[Index - 1];
+	const FVector Out = Samples[Index + 1] - Samples[Index];
+	return FMath::Acos(FMath::Clamp(float(In.CosineAngle2D(Out)), -1.f, 1.f));
+}
@@ -0,0 +1,406 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/Misc/SensorRecord.h"
+#include "Soda/UnrealSoda.h"
+#include "Soda/VehicleComponents/VehicleBaseComponent.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include "Async/MappedFileHandle.h"
+#include "Serialization/MemoryWriter.h"
+#include "Misc/Paths.h"
+#include "Algo/BinarySearch.h"
+
+/** [ms] The partially filled chunk is written to the file at least with this period */
+static constexpr uint32 FlushPeriodMs = 1000;
+
+/** Number of the written chunks kept for the reuse */
+static constexpr int32 MaxFreeChunks = 2;
+
+namespace soda
+{
+
+const TCHAR* ToString(ESensorRecordPayload Payload)
+{
+	switch (Payload)
+	{
+	case ESensorRecordPayload::Camera: return TEXT("Camera");
+	case ESensorRecordPayload::Lidar: return TEXT("Lidar");
+	case ESensorRecordPayload::Nav: return TEXT("Nav");
+	case ESensorRecordPayload::Racing: return TEXT("Racing");
+	case ESensorRecordPayload::Radar: return TEXT("Radar");
+	case ESensorRecordPayload::Ultrasonic: return TEXT("Ultrasonic");
+	case ESensorRecordPayload::V2X: return TEXT("V2X");
+	case ESensorRecordPayload::WheeledVehicle: return TEXT("WheeledVehicle");
+	}
+	return TEXT("Unknown");
+}
+
+/***********************************************************************************************
+	FSensorRecordWriter
+***********************************************************************************************/
+FSensorRecordWriter::FSensorRecordWriter(int32 InChunkSize, int32 InMaxPendingChunks)
+	: ChunkSize(FMath::Max(InChunkSize, 64 * 1024))
+	, MaxPendingChunks(FMath::Max(InMaxPendingChunks, 1))
+{
+}
+
+FSensorRecordWriter::~FSensorRecordWriter()
+{
+	Close();
+}
+
+TSharedPtr<FSensorRecordWriter> FSensorRecordWriter::GetShared(const FString& InFileName, int32 ChunkSizeMB)
+{
+	static FCriticalSection SharedLock;
+	static TMap<FString, TWeakPtr<FSensorRecordWriter>> SharedWriters;
+
+	const FString FullFileName = FPaths::ConvertRelativePathToFull(InFileName);
+
+	FScopeLock ScopeLock(&SharedLock);
+
+	if (TSharedPtr<FSensorRecordWriter> Writer = SharedWriters.FindRef(FullFileName).Pin())
+	{
+		return Writer;
+	}
+
+	TSharedPtr<FSensorRecordWriter> Writer = MakeShared<FSensorRecordWriter>(ChunkSizeMB * 1024 * 1024);
+	if (!Writer->Open(FullFileName))
+	{
+		return nullptr;
+	}
+	SharedWriters.Add(FullFileName, Writer);
+	return Writer;
+}
+
+bool FSensorRecordWriter::Open(const FString& InFileName)
+{
+	Close();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(InFileName));
+	File = PlatformFile.OpenWrite(*InFileName);
+	if (!File)
+	{
+		UE_LOG(LogSoda, Error, TEXT("FSensorRecordWriter::Open(); Can't open \"%s\""), *InFileName);
+		return false;
+	}
+
+	FileName = InFileName;
+	WrittenBytes = 0;
+	RecordedFrames = 0;
+	DroppedFrames = 0;
+	Streams.Reset();
+
+	Chunk.Reset(ChunkSize);
+	FSensorRecordFileHeader FileHeader;
+	Chunk.Append(reinterpret_cast<const uint8*>(&FileHeader), sizeof(FileHeader));
+
+	bStopping = false;
+	WakeUpEvent = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("SensorRecordWriter"), 0, TPri_BelowNormal);
+
+	UE_LOG(LogSoda, Log, TEXT("FSensorRecordWriter::Open(); Recording to \"%s\""), *FileName);
+
+	return true;
+}
+
+void FSensorRecordWriter::Close()
+{
+	if (Thread)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (WakeUpEvent)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeUpEvent);
+		WakeUpEvent = nullptr;
+	}
+
+	if (File)
+	{
+		delete File;
+		File = nullptr;
+
+		UE_LOG(LogSoda, Log, TEXT("FSensorRecordWriter::Close(); \"%s\": %lld frames, %lld bytes, %lld frames dropped"),
+			*FileName, int64(RecordedFrames), int64(WrittenBytes), int64(DroppedFrames));
+	}
+
+	Chunk.Empty();
+	PendingChunks.Empty();
+	FreeChunks.Empty();
+}
+
+int32 FSensorRecordWriter::AddStream(const FString& Name, ESensorRecordPayload Payload)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	const FString Key = Name + TEXT(":") + ToString(Payload);
+	if (const int32* StreamId = Streams.Find(Key))
+	{
+		return *StreamId;
+	}
+
+	const int32 StreamId = Streams.Num();
+	check(StreamId <= int32(MAX_uint16));
+	Streams.Add(Key, StreamId);
+
+	FSensorRecordHeader RecordHeader;
+	RecordHeader.StreamId = uint16(StreamId);
+	RecordHeader.Kind = ESensorRecordKind::Stream;
+	RecordHeader.Payload = Payload;
+	FTCHARToUTF8 NameUTF8(*Name);
+	AppendRecord(RecordHeader, [&NameUTF8](FArchive& Ar)
+	{
+		Ar.Serialize(const_cast<ANSICHAR*>(NameUTF8.Get()), NameUTF8.Length());
+	});
+
+	return StreamId;
+}
+
+bool FSensorRecordWriter::Write(int32 StreamId, ESensorRecordPayload Payload, const FSensorDataHeader& Header, float DeltaTime, TFunctionRef<void(FArchive&)> Serializer)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (!Thread || (Chunk.Num() >= ChunkSize && !RotateChunk()))
+	{
+		++DroppedFrames;
+		return false;
+	}
+
+	FSensorRecordHeader RecordHeader;
+	RecordHeader.StreamId = uint16(StreamId);
+	RecordHeader.Kind = ESensorRecordKind::Frame;
+	RecordHeader.Payload = Payload;
+	RecordHeader.Timestamp = RawTimestamp<std::chrono::nanoseconds>(Header.Timestamp);
+	RecordHeader.FrameIndex = Header.FrameIndex;
+	RecordHeader.DeltaTime = DeltaTime;
+	AppendRecord(RecordHeader, Serializer);
+
+	++RecordedFrames;
+	return true;
+}
+
+void FSensorRecordWriter::AppendRecord(const FSensorRecordHeader& RecordHeader, TFunctionRef<void(FArchive&)> Serializer)
+{
+	const int32 HeaderOffset = Chunk.AddUninitialized(sizeof(FSensorRecordHeader));
+
+	FMemoryWriter Writer(Chunk, true, true);
+	Serializer(Writer);
+
+	FSensorRecordHeader FinalHeader = RecordHeader;
+	FinalHeader.Size = uint32(Chunk.Num() - HeaderOffset - sizeof(FSensorRecordHeader));
+	FMemory::Memcpy(Chunk.GetData() + HeaderOffset, &FinalHeader, sizeof(FinalHeader));
+}
+
+bool FSensorRecordWriter::RotateChunk()
+{
+	if (PendingChunks.Num() >= MaxPendingChunks)
+	{
+		return false;
+	}
+
+	PendingChunks.Add(MoveTemp(Chunk));
+	TakeFreeChunk();
+	WakeUpEvent->Trigger();
+	return true;
+}
+
+void FSensorRecordWriter::TakeFreeChunk()
+{
+	if (FreeChunks.Num())
+	{
+		Chunk = FreeChunks.Pop(false);
+	}
+	Chunk.Reset(ChunkSize);
+}
+
+uint32 FSensorRecordWriter::Run()
+{
+	TArray<TArray<uint8>> ToWrite;
+	bool bWriteFailed = false;
+
+	while (true)
+	{
+		const bool bTimeout = !WakeUpEvent->Wait(FlushPeriodMs);
+		const bool bStop = bStopping;
+
+		{
+			FScopeLock ScopeLock(&Lock);
+			if ((bTimeout || bStop) && Chunk.Num())
+			{
+				PendingChunks.Add(MoveTemp(Chunk));
+				TakeFreeChunk();
+			}
+			Swap(ToWrite, PendingChunks);
+		}
+
+		for (auto& It : ToWrite)
+		{
+			if (File->Write(It.GetData(), It.Num()))
+			{
+				WrittenBytes += It.Num();
+			}
+			else if (!bWriteFailed)
+			{
+				UE_LOG(LogSoda, Error, TEXT("FSensorRecordWriter::Run(); Can't write to \"%s\""), *FileName);
+				bWriteFailed = true;
+			}
+		}
+
+		if (bTimeout || bStop)
+		{
+			File->Flush();
+		}
+
+		{
+			FScopeLock ScopeLock(&Lock);
+			for (auto& It : ToWrite)
+			{
+				if (FreeChunks.Num() < MaxFreeChunks)
+				{
+					It.Reset();
+					FreeChunks.Add(MoveTemp(It));
+				}
+			}
+		}
+		ToWrite.Reset();
+
+		if (bStop)
+		{
+			break;
+		}
+	}
+
+	return 0;
+}
+
+void FSensorRecordWriter::Stop()
+{
+	bStopping = true;
+	if (WakeUpEvent)
+	{
+		WakeUpEvent->Trigger();
+	}
+}
+
+/***********************************************************************************************
+	FSensorRecordReader
+***********************************************************************************************/
+bool FSensorRecordReader::Open(const FString& FileName)
+{
+	Close();
+
+	MappedFile = FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FileName);
+	if (!MappedFile)
+	{
+		UE_LOG(LogSoda, Error, TEXT("FSensorRecordReader::Open(); Can't map \"%s\""), *FileName);
+		return false;
+	}
+
+	const int64 FileSize = MappedFile->GetFileSize();
+	if (FileSize < int64(sizeof(FSensorRecordFileHeader)))
+	{
+		UE_LOG(LogSoda, Error, TEXT("FSensorRecordReader::Open(); \"%s\" is empty"), *FileName);
+		Close();
+		return false;
+	}
+
+	MappedRegion = MappedFile->MapRegion(0, FileSize);
+	if (!MappedRegion)
+	{
+		UE_LOG(LogSoda, Error, TEXT("FSensorRecordReader::Open(); Can't map region of \"%s\""), *FileName);
+		Close();
+		return false;
+	}
+
+	const uint8* Data = MappedRegion->GetMappedPtr();
+	FSensorRecordFileHeader FileHeader;
+	FMemory::Memcpy(&FileHeader, Data, sizeof(FileHeader));
+	if (FileHeader.Magic != FSensorRecordFileHeader::MagicValue || FileHeader.Version != FSensorRecordFileHeader::VersionValue)
+	{
+		UE_LOG(LogSoda, Error, TEXT("FSensorRecordReader::Open(); \"%s\" isn't the sensor record of the version %d"), *FileName, FSensorRecordFileHeader::VersionValue);
+		Close();
+		return false;
+	}
+
+	int64 Offset = sizeof(FSensorRecordFileHeader);
+	while (Offset + int64(sizeof(FSensorRecordHeader)) <= FileSize)
+	{
+		FSensorRecordHeader RecordHeader;
+		FMemory::Memcpy(&RecordHeader, Data + Offset, sizeof(RecordHeader));
+		const int64 PayloadOffset = Offset + sizeof(FSensorRecordHeader);
+		if (PayloadOffset + RecordHeader.Size > FileSize)
+		{
+			UE_LOG(LogSoda, Warning, TEXT("FSensorRecordReader::Open(); \"%s\" is truncated at %lld"), *FileName, Offset);
+			break;
+		}
+
+		if (RecordHeader.Kind == ESensorRecordKind::Stream)
+		{
+			if (Streams.Num() <= RecordHeader.StreamId)
+			{
+				Streams.SetNum(RecordHeader.StreamId + 1);
+			}
+			FStream& Stream = Streams[RecordHeader.StreamId];
+			Stream.Payload = RecordHeader.Payload;
+			Stream.Name = FString(FUTF8ToTCHAR(reinterpret_cast<const ANSICHAR*>(Data + PayloadOffset), RecordHeader.Size));
+		}
+		else if (RecordHeader.StreamId < Streams.Num())
+		{
+			FFrame& Frame = Frames.AddDefaulted_GetRef();
+			Frame.StreamId = RecordHeader.StreamId;
+			Frame.Timestamp = ChronoTimestamp(RecordHeader.Timestamp);
+			Frame.FrameIndex = RecordHeader.FrameIndex;
+			Frame.DeltaTime = RecordHeader.DeltaTime;
+			Frame.Data = Data + PayloadOffset;
+			Frame.Size = RecordHeader.Size;
+		}
+
+		Offset = PayloadOffset + RecordHeader.Size;
+	}
+
+	// The frames of the different sensors may be published slightly out of the order (e.g. the camera is read back with the delay)
+	Frames.StableSort([](const FFrame& A, const FFrame& B) { return A.Timestamp < B.Timestamp; });
+
+	UE_LOG(LogSoda, Log, TEXT("FSensorRecordReader::Open(); \"%s\": %d streams, %d frames, %.1f s"), *FileName, Streams.Num(), Frames.Num(), GetDuration());
+
+	return true;
+}
+
+void FSensorRecordReader::Close()
+{
+	Frames.Empty();
+	Streams.Empty();
+
+	delete MappedRegion;
+	MappedRegion = nullptr;
+
+	delete MappedFile;
+	MappedFile = nullptr;
+}
+
+double FSensorRecordReader::GetDuration() const
+{
+	if (Frames.Num() < 2)
+	{
+		return 0;
+	}
+	return std::chrono::duration<double>(Frames.Last().Timestamp - Frames[0].Timestamp).count();
+}
+
+int32 FSensorRecordReader::FindFrame(double Seconds) const
+{
+	if (!Frames.Num())
+	{
+		return 0;
+	}
+	const TTimestamp Timestamp = AddSeconds(Frames[0].Timestamp, Seconds);
+	return Algo::LowerBoundBy(Frames, Timestamp, [](const FFrame& Frame) { return Frame.Timestamp; });
+}
+
+} // namespace soda
@@ -0,0 +1,206 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/Misc/SensorWeather.h"
+#include "Soda/VehicleComponents/Sensors/Base/LidarSensor.h"
+#include "Async/ParallelFor.h"
+
+/** [dB/km] -> [1/m] */
+static constexpr float DBPerKmToExtinction = 0.2303e-3f;
+
+/** Samples are processed by the blocks of this size, the noise of the block is generated at once on the stack */
+static constexpr int LidarBlockSize = 256;
+
+/** Noise channels of the degradation; the sensor's own noise uses the low channels of the same key */
+static constexpr uint32 DetectionChannel = 0x100;
+static constexpr uint32 BackscatterChannel = 0x101;
+static constexpr uint32 BackscatterRangeChannel = 0x102;
+
+static constexpr int CameraBlockSize = 16384;
+
+namespace soda
+{
+
+float FSensorWeather::GetOpticalExtinction(float WavelengthNm) const
+{
+	float Extinction = GetPrecipitationExtinction(WavelengthNm);
+
+	if (FogVisibility > 0)
+	{
+		// Kim, Mcarthur, Korevaar, "Comparison of laser beam propagation at 785 nm and 1550 nm in fog and haze"
+		const float VisibilityKm = FogVisibility * 0.001f;
+		float Q = 0;
+		if (VisibilityKm > 50) Q = 1.6f;
+		else if (VisibilityKm > 6) Q = 1.3f;
+		else if (VisibilityKm > 1) Q = 0.16f * VisibilityKm + 0.34f;
+		else if (VisibilityKm > 0.5f) Q = VisibilityKm - 0.5f;
+		Extinction += 3.912f / FogVisibility * FMath::Pow(WavelengthNm / 550.f, -Q);
+	}
+
+	return Extinction;
+}
+
+float FSensorWeather::GetPrecipitationExtinction(float WavelengthNm) const
+{
+	float Extinction = 0;
+
+	if (RainRate > 0)
+	{
+		// Carbonneau, the rain extinction is almost independent of the wavelength in the near infrared
+		Extinction += 1.076f * FMath::Pow(RainRate, 0.67f) * DBPerKmToExtinction;
+	}
+
+	if (SnowRate > 0)
+	{
+		// Kim, dry snow
+		const float A = 5.42e-5f * WavelengthNm + 5.4958776f;
+		Extinction += A * FMath::Pow(SnowRate, 1.38f) * DBPerKmToExtinction;
+	}
+
+	return Extinction;
+}
+
+float FSensorWeather::GetRadarAttenuation() const
+{
+	float Attenuation = 0;
+
+	if (RainRate > 0)
+	{
+		// ITU-R P.838 coefficients near 77 GHz
+		Attenuation += 1.06f * FMath::Pow(RainRate, 0.73f);
+	}
+
+	if (SnowRate > 0)
+	{
+		// Dry snow is almost transparent for the millimeter waves
+		Attenuation += 0.2f * SnowRate;
+	}
+
+	if (FogVisibility > 0)
+	{
+		// Liquid water content from the visibility (Eldridge) [g/m^3] * specific attenuation at 77 GHz
+		const float WaterContent = FMath::Pow(0.024f / (FogVisibility * 0.001f), 1.54f);
+		Attenuation += 3.f * WaterContent;
+	}
+
+	return Attenuation;
+}
+
+void DegradeLidarScan(const FLidarWeatherDegradation& Degradation, uint64 Frame, const TArray<FVector>& Rays, FLidarSensorData& Scan)
+{
+	if (!Degradation.IsEnabled())
+	{
+		return;
+	}
+
+	const int BeamsNum = Scan.GetBeamsNum();
+	const int ReturnsNum = FMath::Max(Scan.ReturnsNum, 1);
+	const float TwoWayExtinction = 2.f * Degradation.Extinction * 0.01f; // [1/cm]
+	const float Threshold = FMath::Max(Degradation.DetectionThreshold, KINDA_SMALL_NUMBER);
+
+	float Detect[LidarBlockSize];
+	for (int Echo = 0; Echo < ReturnsNum; ++Echo)
+	{
+		for (int Begin = 0; Begin < BeamsNum; Begin += LidarBlockSize)
+		{
+			const int Num = FMath::Min(LidarBlockSize, BeamsNum - Begin);
+			FLidarScanPoint* Points = &Scan.Points[Echo * BeamsNum + Begin];
+			Degradation.Noise.Uniform(Frame, DetectionChannel, Echo * BeamsNum + Begin, Detect, Num);
+
+			for (int i = 0; i < Num; ++i)
+			{
+				FLidarScanPoint& Point = Points[i];
+				if (Point.Status == ELidarPointStatus::Invalid)
+				{
+					continue;
+				}
+
+				const float Transmission = FMath::Exp(-TwoWayExtinction * Point.Depth);
+				const float Returned = (Scan.bIntensitieIsValid ? Point.Intensitie : 1.f) * Transmission;
+				if (Scan.bIntensitieIsValid)
+				{
+					Point.Intensitie = Returned;
+				}
+
+				// The detection probability grows linearly up to the threshold
+				if (Detect[i] * Threshold > Returned)
+				{
+					Point.Status = ELidarPointStatus::Invalid;
+				}
+			}
+		}
+	}
+
+	if (Degradation.BackscatterProbability <= 0 || Rays.Num() != BeamsNum)
+	{
+		return;
+	}
+
+	float Fire[LidarBlockSize];
+	float Range[LidarBlockSize];
+	for (int Begin = 0; Begin < BeamsNum; Begin += LidarBlockSize)
+	{
+		const int Num = FMath::Min(LidarBlockSize, BeamsNum - Begin);
+		Degradation.Noise.Uniform(Frame, BackscatterChannel, Begin, Fire, Num);
+		Degradation.Noise.Uniform(Frame, BackscatterRangeChannel, Begin, Range, Num);
+
+		for (int i = 0; i < Num; ++i)
+		{
+			if (Fire[i] >= Degradation.BackscatterProbability)
+			{
+				continue;
+			}
+
+			const int Beam = Begin + i;
+			const float Depth = -Degradation.BackscatterRange * FMath::Loge(FMath::Max(1.f - Range[i], SMALL_NUMBER));
+			const FLidarScanPoint& First = Scan.Points[Beam];
+			if (Depth < Scan.RangeMin || Depth > Scan.RangeMax || (First.Status != ELidarPointStatus::Invalid && Depth >= First.Depth))
+			{
+				continue;
+			}
+
+			// The false point becomes the first echo, the rest are shifted and the last one is lost
+			const float TimeOffset = First.TimeOffset;
+			for (int Echo = ReturnsNum - 1; Echo > 0; --Echo)
+			{
+				Scan.Points[Echo * BeamsNum + Beam] = Scan.Points[(Echo - 1) * BeamsNum + Beam];
+			}
+
+			FLidarScanPoint& Point = Scan.Points[Beam];
+			Point.Location = Rays[Beam] * Depth;
+			Point.Depth = Depth;
+			Point.Intensitie = Threshold;
+			Point.TimeOffset = TimeOffset;
+			Point.Status = ELidarPointStatus::Valid;
+		}
+	}
+}
+
+void DegradeCameraImage(float Transmission, const FColor& Airlight, TArrayView<FColor> Pixels)
+{
+	const uint32 Q = uint32(FMath::Clamp(Transmission, 0.f, 1.f) * 256.f + 0.5f);
+	if (Q >= 256)
+	{
+		return;
+	}
+
+	const uint32 AirB = uint32(Airlight.B) * (256 - Q);
+	const uint32 AirG = uint32(Airlight.G) * (256 - Q);
+	const uint32 AirR = uint32(Airlight.R) * (256 - Q);
+
+	const int BlocksNum = FMath::DivideAndRoundUp(Pixels.Num(), CameraBlockSize);
+	ParallelFor(BlocksNum, [&](int Block)
+	{
+		const int Begin = Block * CameraBlockSize;
+		const int End = FMath::Min(Begin + CameraBlockSize, Pixels.Num());
+		FColor* Data = Pixels.GetData();
+		for (int i = Begin; i < End; ++i)
+		{
+			FColor& Pixel = Data[i];
+			Pixel.B = uint8((Pixel.B * Q + AirB) >> 8);
+			Pixel.G = uint8((Pixel.G * Q + AirG) >> 8);
+			Pixel.R = uint8((Pixel.R * Q + AirR) >> 8);
+		}
+	});
+}
+
+} // namespace soda
@@ -6,85 +6,6 @@
 #include "Serialization/MemoryWriter.h"
 #include "UObject/UObjectGlobals.h"
 
-//TODO: See to FConcertSyncObjectWriter and FConcertSyncObjectReader
-
-struct FSaveExtensionArchive : public FObjectAndNameAsStringProxyArchive 
-{
-	FSaveExtensionArchive(FArchive &InInnerArchive, bool bInLoadIfFindFails) : FObjectAndNameAsStringProxyArchive(InInnerArchive, bInLoadIfFindFails) 
-	{
-		ArIsSaveGame = true;
-    	ArNoDelta = true;
-	}
-
-	virtual FArchive &operator<<(struct FSoftObjectPtr &Value) override
-	{
-		*this << Value.GetUniqueID();
-		return *this;
-	}
-
-	virtual FArchive &operator<<(struct FSoftObjectPath &Value) override
-	{
-		FString Path = Value.ToString();
-		*this << Path;
-		if (IsLoading())
-		{
-			Value.SetPath(MoveTemp(Path));
-		}
-		return *this;
-	}
-	
-	virtual FArchive& operator<<(UObject*& Obj) override
-	{
-		FProperty* SerializingProperty = GetSerializedProperty();
-		const bool bHasInstancedValue = SerializingProperty && SerializingProperty->HasAnyPropertyFlags(CPF_PersistentInstance);
-
-		if (IsSaveGame() && bHasInstancedValue)
-		{
-			if (IsLoading())
-			{
-				UObject* Outer = SerializingProperty->GetOwnerUObject();
-				if (!Outer)
-				{
-					Outer = GetTransientPackage();
-				}
-
-				//FObjectProperty* ObjectProperty = CastField<FObjectProperty>(SerializingProperty);
-				//UClass* PropertyClass = ObjectProperty->PropertyClass;
-
-				// load the path name to the object
-				FString ClassString;
-				InnerArchive << ClassString;
-
-				if (!ClassString.IsEmpty())
-				{
-					UClass* FoundClass = FPackageName::IsShortPackageName(ClassString) ? FindFirstObject<UClass>(*ClassString) : UClass::TryFindTypeSlow<UClass>(ClassString);
-					if (FoundClass)
-					{
-						Obj = StaticAllocateObject(FoundClass, Outer, NAME_None, EObjectFlags::RF_NoFlags, EInternalObjectFlags::None, false);
-						(*FoundClass->ClassConstructor)(FObjectInitializer(Obj, FoundClass, EObjectInitializerOptions::None));
-						Obj->Serialize(*this);
-					}
-				}
-			}
-			else if (Obj)
-			{
-				// save out the fully qualified object name
-				FString ClassString(Obj->GetClass()->GetPathName());
-				InnerArchive << ClassString;
-				Obj->Serialize(*this);
-			}
-			else
-			{
-				// for null pointer, output empty string
-				FString ClassString;
-				InnerArchive << ClassString;
-			}
-		}
-		return *this;
-	}
-	
-};
-
 /******************************************************************
 * FObjectRecord
 *******************************************************************/
@@ -308,4 +229,43 @@ void USaveGameActor::Serialize(FArchive& Ar)
 {
 	Super::Serialize(Ar);
 	Ar << ActorRecord;
-}
\ No newline at end of file
+}
+/******************************************************************
+* SerializeSnapshotBlocks
+*******************************************************************/
+void soda::SerializeSnapshotBlocks(FArchive& Ar, TArrayView<const FString> Names, TFunctionRef<void(int32 Index, FArchive& BlockAr)> Serializer)
+{
+	if (Ar.IsSaving())
+	{
+		int32 Num = Names.Num();
+		Ar << Num;
+		TArray<uint8> Block;
+		for (int32 Index = 0; Index < Names.Num(); ++Index)
+		{
+			FString Name = Names[Index];
+			Block.Reset();
+			FMemoryWriter BlockAr(Block);
+			Serializer(Index, BlockAr);
+			Ar << Name << Block;
+		}
+	}
+	else if (Ar.IsLoading())
+	{
+		int32 Num = 0;
+		Ar << Num;
+		FString Name;
+		TArray<uint8> Block;
+		for (int32 i = 0; i < Num && !Ar.IsError(); ++i)
+		{
+			Ar << Name << Block;
+			const int32 Index = Names.IndexOfByKey(Name);
+			if (Index == INDEX_NONE)
+			{
+				UE_LOG(LogSoda, Warning, TEXT("soda::SerializeSnapshotBlocks(); Skip the unmatched block \"%s\""), *Name);
+				continue;
+			}
+			FMemoryReader BlockAr(Block);
+			Serializer(Index, BlockAr);
+		}
+	}
+}
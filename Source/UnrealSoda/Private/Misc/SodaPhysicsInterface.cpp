@@ -19,6 +19,7 @@ float DebugLineLifetime_ = 2.f;
 
 #include "Physics/Experimental/ChaosInterfaceWrapper.h"
 #include "PBDRigidsSolver.h"
+#include <atomic>
 
 namespace ECAQueryMode
 {
@@ -559,6 +560,103 @@ bool TSceneCastCommon(const UWorld* World, TArray<typename Traits::TOutHits> & O
 	}
 }
 
+template <typename Traits>
+bool TRaycastMultiFlatImp(const UWorld* World, TArray<FHitResult>& OutHits, TArray<int32>& OutHitsNum, int32 MaxHitsPerRay, const TArray<FVector>& Start, const TArray<FVector>& End, ECollisionChannel TraceChannel, const struct FCollisionQueryParams& Params, const struct FCollisionResponseParams& ResponseParams, const struct FCollisionObjectQueryParams& ObjectParams)
+{
+	using namespace ChaosInterface;
+
+	FScopeCycleCounter Counter(Params.StatId);
+
+	const int Num = FMath::Min(Start.Num(), End.Num());
+	OutHits.SetNum(Num * MaxHitsPerRay, false);
+	OutHitsNum.SetNum(Num, false);
+
+	std::atomic<bool> bHaveBlockingHit{ false };
+
+	FPhysScene& PhysScene = *World->GetPhysicsScene();
+	FScopedSceneReadLock SceneLocks(PhysScene);
+
+	ParallelFor(Num, [&](int i)
+	{
+		OutHitsNum[i] = 0;
+
+		const FVector& StartRef = Start[i];
+		const FVector& EndRef = End[i];
+		const FVector Delta = EndRef - StartRef;
+		const float DeltaSize = Delta.Size();
+		const float DeltaMag = FMath::IsNearlyZero(DeltaSize) ? 0.f : DeltaSize;
+		if (DeltaMag <= 0.f)
+		{
+			return;
+		}
+
+		FCollisionFilterData Filter = CreateQueryFilterData(TraceChannel, Params.bTraceComplex, ResponseParams.CollisionResponse, Params, ObjectParams, true);
+		FCollisionQueryFilterCallback QueryCallback(Params, false);
+
+		// The hit buffer keeps its hits in the inline storage
+		typename Traits::THitBuffer HitBufferSync;
+		const FVector Dir = Delta / DeltaMag;
+		const FTransform StartTM(StartRef);
+		{
+			FScopedSQHitchRepeater<decltype(HitBufferSync)> HitchRepeater(HitBufferSync, QueryCallback, FHitchDetectionInfo(StartRef, EndRef, TraceChannel, Params));
+			do
+			{
+				Traits::SceneTrace(PhysScene, FRaycastSQAdditionalInputs(), Dir, DeltaMag, StartTM, HitchRepeater.GetBuffer(), Traits::GetHitFlags(), Traits::GetQueryFlags(), Filter, Params, &QueryCallback);
+			} while (HitchRepeater.RepeatOnHitch());
+		}
+
+		const int32 NumHits = Traits::GetNumHits(HitBufferSync);
+		if (NumHits == 0)
+		{
+			return;
+		}
+
+		const auto* Hits = Traits::GetHits(HitBufferSync);
+		float MinBlockingDistance = DeltaMag;
+		if (GetHasBlock(HitBufferSync))
+		{
+			MinBlockingDistance = GetDistance(Hits[NumHits - 1]);
+			bHaveBlockingHit = true;
+		}
+
+		// Pick the nearest hits in place, MaxHitsPerRay is small, so the selection is cheaper than the sorting
+		float LastDistance = -1.f;
+		int32 LastIndex = INDEX_NONE;
+		int32 Picked = 0;
+		for (; Picked < MaxHitsPerRay; ++Picked)
+		{
+			int32 Best = INDEX_NONE;
+			float BestDistance = 0;
+			for (int32 h = 0; h < NumHits; ++h)
+			{
+				const float Distance = GetDistance(Hits[h]);
+				if (Distance > MinBlockingDistance || Distance < LastDistance || (Distance == LastDistance && h <= LastIndex))
+				{
+					continue;
+				}
+				if (Best == INDEX_NONE || Distance < BestDistance)
+				{
+					Best = h;
+					BestDistance = Distance;
+				}
+			}
+			if (Best == INDEX_NONE)
+			{
+				break;
+			}
+
+			FHitResult& OutHit = OutHits[i * MaxHitsPerRay + Picked];
+			OutHit = FHitResult(StartRef, EndRef);
+			ConvertQueryImpactHit(World, Hits[Best], OutHit, DeltaMag, Filter, StartRef, EndRef, nullptr, StartTM, Params.bReturnFaceIndex, Params.bReturnPhysicalMaterial);
+			LastDistance = BestDistance;
+			LastIndex = Best;
+		}
+		OutHitsNum[i] = Picked;
+	});
+
+	return bHaveBlockingHit;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // RAYCAST
 
@@ -582,6 +680,28 @@ bool FSodaPhysicsInterface::RaycastMultiScope(const UWorld* World, TArray<TArray
 	return TSceneCastCommon<TCastTraits, TPTCastTraits>(World, OutHits, FRaycastSQAdditionalInputs(), Start, End, TraceChannel, Params, ResponseParams, ObjectParams);
 }
 
+bool FSodaPhysicsInterface::RaycastMultiScope(const UWorld* World, TArray<struct FHitResult>& OutHits, TArray<int32>& OutHitsNum, int32 MaxHitsPerRay, const TArray<FVector>& Start, const TArray<FVector>& End, ECollisionChannel TraceChannel, const struct FCollisionQueryParams& Params, const struct FCollisionResponseParams& ResponseParams, const struct FCollisionObjectQueryParams& ObjectParams)
+{
+	using namespace ChaosInterface;
+
+	check(MaxHitsPerRay > 0);
+	if ((World == NULL) || (World->GetPhysicsScene() == NULL))
+	{
+		return false;
+	}
+
+	using TCastTraits = TSQTraits<FHitRaycast, ESweepOrRay::Raycast, ESingleMultiOrTest::Multi>;
+	using TPTCastTraits = TSQTraits<FPTRaycastHit, ESweepOrRay::Raycast, ESingleMultiOrTest::Multi>;
+	if (GetThreadQueryContext(*World->GetPhysicsScene()->GetSolver()) == EThreadQueryContext::GTData)
+	{
+		return TRaycastMultiFlatImp<TCastTraits>(World, OutHits, OutHitsNum, MaxHitsPerRay, Start, End, TraceChannel, Params, ResponseParams, ObjectParams);
+	}
+	else
+	{
+		return TRaycastMultiFlatImp<TPTCastTraits>(World, OutHits, OutHitsNum, MaxHitsPerRay, Start, End, TraceChannel, Params, ResponseParams, ObjectParams);
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 // GEOM SWEEP
 
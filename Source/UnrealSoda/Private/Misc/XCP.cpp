@@ -6,72 +6,6 @@
 namespace xcp
 {
 
-enum SlaveToMasterPID: uint8
-{
-	SERV = 0xFC,
-	EV = 0xFD,
-	ERR = 0xFE,
-    RES = 0xFF,
-};
-
-enum MasterToSlavePID : uint8
-{
-    //Standard Commands:
-    CONNECT = 0xFF,
-    DISCONNECT = 0xFE,
-    GET_STATUS = 0xFD,
-    SYNCH = 0xFC,
-    GET_COMM_MODE_INFO = 0xFB,
-    GET_ID = 0xFA,
-    SET_REQUEST = 0xF9,
-    GET_SEED = 0xF8,
-    UNLOCK = 0xF7,
-    SET_MTA = 0xF6,
-    UPLOAD = 0xF5,
-    SHORT_UPLOAD = 0xF4,
-    BUILD_CHECKSUM = 0xF3,
-    TRANSPORT_LAYER_CMD = 0xF2,
-    USER_CMD = 0xF1,
-
-    //Calibration commands:
-	DOWNLOAD = 0xF0,
-	DOWNLOAD_NEXT = 0xEF,
-	DOWNLOAD_MAX = 0xEE,
-	SHORT_DOWNLOAD = 0xED,
-	MODIFY_BITS = 0xEC,
-
-    //Page switching commands:
-
-    //Basic data acquisition and stimulation commands:
-    SET_DAQ_PTR = 0xE2,
-    WRITE_DAQ = 0xE1,
-    SET_DAQ_LIST_MODE = 0xE0,
-    START_STOP_DAQ_LIST = 0xDE,
-    START_STOP_SYNCH = 0xDD,
-    WRITE_DAQ_MULTIPLE = 0xC7,
-    READ_DAQ = 0xDB,
-    GET_DAQ_CLOCK = 0xDC,
-    GET_DAQ_PROCESSOR_INFO = 0xDA,
-    GET_DAQ_RESOLUTION_INFO = 0xD9,
-    GET_DAQ_LIST_MODE = 0xDF,
-    GET_DAQ_EVENT_INFO = 0xD7,
-    DTO_CTR_PROPERTIES = 0xC5,
-
-    //Static data acquisition and stim commands:
-    CLEAR_DAQ_LIST = 0xE3,
-    GET_DAQ_LIST_INFO = 0xD8,
-
-    //Dynamic data acquisition and stim commands:
-    FREE_DAQ = 0xD6,
-    ALLOC_DAQ = 0xD5,
-    ALLOC_ODT = 0xD4,
-    ALLOC_ODT_ENTRY = 0xD3,
-
-    //Non-volatile memory programming commands:
-
-    //Time sync commands:
-};
-
 FPacket::FPacket(uint8 CMD)
 {
 	Data[0] = CMD;
@@ -197,12 +131,12 @@ bool FMaster::Connect(uint8 mode)
 		return false;
 	}
 
-	ConnectionInfo.Resource = Response.Data[0];
-	ConnectionInfo.CommModeBasic = Response.Data[1];
-	ConnectionInfo.MaxCto = Response.Data[2];
-	ConnectionInfo.MaxDto = *(uint16*)&Response.Data[3];
-	ConnectionInfo.ProtocolLayerVersion = Response.Data[5];
-	ConnectionInfo.TransportLayerVersion = Response.Data[6];
+	ConnectionInfo.Resource = Response.Data[1];
+	ConnectionInfo.CommModeBasic = Response.Data[2];
+	ConnectionInfo.MaxCto = Response.Data[3];
+	ConnectionInfo.MaxDto = *(uint16*)&Response.Data[4];
+	ConnectionInfo.ProtocolLayerVersion = Response.Data[6];
+	ConnectionInfo.TransportLayerVersion = Response.Data[7];
 
 	bIsLittleEndian = ((ConnectionInfo.CommModeBasic & (uint8)EConnCommModeBasicBits::BYTE_ORDER_) == 0);
 	ConnectionInfo.MaxDto = WordSwap(ConnectionInfo.MaxDto);
@@ -223,7 +157,6 @@ bool FMaster::Connect(uint8 mode)
 
 bool FMaster::Disconnect()
 {
-	bIsConnected = false;
 	if (!Transport->IsValid())
 	{
 		return false;
@@ -233,13 +166,14 @@ bool FMaster::Disconnect()
 	{
 		return true;
 	}
-	return Transport->Request(FPacket(MasterToSlavePID::DISCONNECT));;
+	bIsConnected = false;
+	return Transport->Request(FPacket(MasterToSlavePID::DISCONNECT));
 }
 
 bool FMaster::GetStatus(FConnectionStatus& ConnectionStatus)
 {
 	FPacket Response;
-	if (Transport->Request(FPacket(MasterToSlavePID::GET_STATUS), Response))
+	if (!Transport->Request(FPacket(MasterToSlavePID::GET_STATUS), Response))
 	{
 		return false;
 	}
@@ -249,10 +183,10 @@ bool FMaster::GetStatus(FConnectionStatus& ConnectionStatus)
 		return false;
 	}
 
-	ConnectionStatus.GetCurrentSessionStatus = Response.Data[0];
-	ConnectionStatus.GetCurrentResourceProtection = Response.Data[1];
-	ConnectionStatus.GetStateNumber = Response.Data[2];
-	ConnectionStatus.GetSessionConfigurationId = WordSwap(*(uint16*)&Response.Data[3]);
+	ConnectionStatus.GetCurrentSessionStatus = Response.Data[1];
+	ConnectionStatus.GetCurrentResourceProtection = Response.Data[2];
+	ConnectionStatus.GetStateNumber = Response.Data[3];
+	ConnectionStatus.GetSessionConfigurationId = WordSwap(*(uint16*)&Response.Data[4]);
 
 	return true;
 }
@@ -0,0 +1,883 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/Misc/XCPSlave.h"
+#include "Soda/UnrealSoda.h"
+#include "Common/UdpSocketBuilder.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+#include "Algo/BinarySearch.h"
+
+DECLARE_STATS_GROUP(TEXT("XCP"), STATGROUP_XCP, STATGROUP_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Event"), STAT_XCP_Event, STATGROUP_XCP);
+DECLARE_CYCLE_STAT(TEXT("SendDto"), STAT_XCP_SendDto, STATGROUP_XCP);
+
+namespace xcp
+{
+
+static constexpr uint8 MtaExtString = 0xFF;
+
+static constexpr uint8 DaqListModeSelected = 0x01;
+static constexpr uint8 DaqListModeDirection = 0x02;
+static constexpr uint8 DaqListModeTimestamp = 0x10;
+static constexpr uint8 DaqListModePidOff = 0x20;
+static constexpr uint8 DaqListModeRunning = 0x40;
+
+static constexpr uint8 MaxPid = 0xFB;
+static constexpr int EthHeaderSize = 4;
+static constexpr int MaxDatagramSize = 1472;
+
+static inline uint16 Get16(const uint8* Data) { return uint16(Data[0]) | (uint16(Data[1]) << 8); }
+static inline uint32 Get32(const uint8* Data) { return uint32(Get16(Data)) | (uint32(Get16(Data + 2)) << 16); }
+static inline void Put16(uint8* Data, uint16 Value) { Data[0] = uint8(Value); Data[1] = uint8(Value >> 8); }
+static inline void Put32(uint8* Data, uint32 Value) { Put16(Data, uint16(Value)); Put16(Data + 2, uint16(Value >> 16)); }
+
+static inline uint32 DaqClock(const TTimestamp& Timestamp)
+{
+	return uint32(soda::RawTimestamp<std::chrono::microseconds>(Timestamp));
+}
+
+static uint8 DataTypeSize(EDataType Type)
+{
+	switch (Type)
+	{
+	case EDataType::UByte: case EDataType::SByte: return 1;
+	case EDataType::UWord: case EDataType::SWord: return 2;
+	case EDataType::ULong: case EDataType::SLong: case EDataType::Float32: return 4;
+	default: return 8;
+	}
+}
+
+/***********************************************************************************************
+	FSymbolTable
+***********************************************************************************************/
+
+bool FSymbolTable::AddSymbol(const FString& Name, void* Ptr, EDataType Type, bool bWritable)
+{
+	if (!Ptr)
+	{
+		return false;
+	}
+
+	FSymbol& Symbol = Symbols.AddDefaulted_GetRef();
+	Symbol.Name = Name;
+	Symbol.Type = Type;
+	Symbol.Size = DataTypeSize(Type);
+	Symbol.Address = Align(NextAddress, Symbol.Size);
+	Symbol.Ptr = (uint8*)Ptr;
+	Symbol.bWritable = bWritable;
+	NextAddress = Symbol.Address + Symbol.Size;
+	return true;
+}
+
+void FSymbolTable::AddStructProperties(const UStruct* Struct, void* Container, const FString& Prefix, int Depth, int& Added)
+{
+	for (TFieldIterator<FProperty> It(Struct); It; ++It)
+	{
+		FProperty* Property = *It;
+		if (Property->ArrayDim != 1)
+		{
+			continue;
+		}
+
+		void* Ptr = Property->ContainerPtrToValuePtr<void>(Container);
+		const FString Name = Prefix + TEXT(".") + Property->GetName();
+		const bool bWritable = Property->HasAnyPropertyFlags(CPF_Edit) && !Property->HasAnyPropertyFlags(CPF_EditConst);
+
+		if (FEnumProperty* EnumProperty = CastField<FEnumProperty>(Property))
+		{
+			Property = EnumProperty->GetUnderlyingProperty();
+		}
+
+		TOptional<EDataType> Type;
+		if (Property->IsA<FFloatProperty>()) Type = EDataType::Float32;
+		else if (Property->IsA<FDoubleProperty>()) Type = EDataType::Float64;
+		else if (Property->IsA<FByteProperty>()) Type = EDataType::UByte;
+		else if (Property->IsA<FInt8Property>()) Type = EDataType::SByte;
+		else if (Property->IsA<FUInt16Property>()) Type = EDataType::UWord;
+		else if (Property->IsA<FInt16Property>()) Type = EDataType::SWord;
+		else if (Property->IsA<FUInt32Property>()) Type = EDataType::ULong;
+		else if (Property->IsA<FIntProperty>()) Type = EDataType::SLong;
+		else if (Property->IsA<FUInt64Property>()) Type = EDataType::UInt64;
+		else if (Property->IsA<FInt64Property>()) Type = EDataType::Int64;
+		else if (FBoolProperty* BoolProperty = CastField<FBoolProperty>(Property))
+		{
+			if (BoolProperty->IsNativeBool()) Type = EDataType::UByte;
+		}
+		else if (FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+		{
+			if (Depth < 2)
+			{
+				AddStructProperties(StructProperty->Struct, Ptr, Name, Depth + 1, Added);
+			}
+			continue;
+		}
+
+		if (Type && AddSymbol(Name, Ptr, *Type, bWritable))
+		{
+			++Added;
+		}
+	}
+}
+
+int FSymbolTable::AddObjectProperties(UObject* Object, const FString& Prefix)
+{
+	int Added = 0;
+	if (IsValid(Object))
+	{
+		AddStructProperties(Object->GetClass(), Object, Prefix, 0, Added);
+	}
+	return Added;
+}
+
+const FSymbol* FSymbolTable::Find(uint32 Address) const
+{
+	int Index = Algo::UpperBoundBy(Symbols, Address, &FSymbol::Address) - 1;
+	if (Index >= 0 && Address < Symbols[Index].Address + Symbols[Index].Size)
+	{
+		return &Symbols[Index];
+	}
+	return nullptr;
+}
+
+uint8* FSymbolTable::Resolve(uint32 Address, uint8 Size, bool bForWrite) const
+{
+	const FSymbol* Symbol = Find(Address);
+	if (Symbol && Address + Size <= Symbol->Address + Symbol->Size && (!bForWrite || Symbol->bWritable))
+	{
+		return Symbol->Ptr + (Address - Symbol->Address);
+	}
+	return nullptr;
+}
+
+void FSymbolTable::Read(uint32 Address, uint8* Out, int Size) const
+{
+	for (int i = 0; i < Size; ++i)
+	{
+		const FSymbol* Symbol = Find(Address + i);
+		Out[i] = Symbol ? Symbol->Ptr[Address + i - Symbol->Address] : 0;
+	}
+}
+
+bool FSymbolTable::ExportA2L(const FString& FileName, const FString& ModuleName) const
+{
+	static const TCHAR* TypeNames[] = { TEXT("UBYTE"), TEXT("SBYTE"), TEXT("UWORD"), TEXT("SWORD"), TEXT("ULONG"), TEXT("SLONG"), TEXT("A_UINT64"), TEXT("A_INT64"), TEXT("FLOAT32_IEEE"), TEXT("FLOAT64_IEEE") };
+	static const TCHAR* Limits[] = { TEXT("0 255"), TEXT("-128 127"), TEXT("0 65535"), TEXT("-32768 32767"), TEXT("0 4294967295"), TEXT("-2147483648 2147483647"),
+		TEXT("0 1.8446744073709552e19"), TEXT("-9.2233720368547758e18 9.2233720368547758e18"), TEXT("-3.4e38 3.4e38"), TEXT("-1.7e308 1.7e308") };
+
+	FString Out;
+	Out += TEXT("ASAP2_VERSION 1 71\n");
+	Out += FString::Printf(TEXT("/begin PROJECT %s \"\"\n/begin MODULE %s \"\"\n"), *ModuleName, *ModuleName);
+	for (const FSymbol& Symbol : Symbols)
+	{
+		Out += FString::Printf(TEXT("/begin MEASUREMENT %s \"\" %s NO_COMPU_METHOD 0 0 %s\n  ECU_ADDRESS 0x%X\n%s/end MEASUREMENT\n"),
+			*Symbol.Name.Replace(TEXT(" "), TEXT("_")),
+			TypeNames[int(Symbol.Type)],
+			Limits[int(Symbol.Type)],
+			Symbol.Address,
+			Symbol.bWritable ? TEXT("  READ_WRITE\n") : TEXT(""));
+	}
+	Out += TEXT("/end MODULE\n/end PROJECT\n");
+
+	return FFileHelper::SaveStringToFile(Out, *FileName);
+}
+
+void FSymbolTable::Reset()
+{
+	Symbols.Empty();
+	NextAddress = BaseAddress;
+}
+
+/***********************************************************************************************
+	FDtoSendAsyncTask
+***********************************************************************************************/
+
+class FDtoSendAsyncTask : public soda::FAsyncTask
+{
+public:
+	FDtoSendAsyncTask(FSlave* InSlave) : Slave(InSlave) {}
+
+	virtual FString ToString() const override { return "FDtoSendAsyncTask"; }
+	virtual bool IsDone() const override { return bIsDone; }
+	virtual bool WasSuccessful() const override { return true; }
+	virtual void Tick() override
+	{
+		SCOPE_CYCLE_COUNTER(STAT_XCP_SendDto);
+
+		int Size = 0;
+		Slave->DrainDto([this, &Size](const uint8* Data, int Len)
+		{
+			if (Size + EthHeaderSize + Len > MaxDatagramSize)
+			{
+				Slave->SendFrames(Datagram, Size);
+				Size = 0;
+			}
+			Put16(Datagram + Size, uint16(Len));
+			Put16(Datagram + Size + 2, Slave->SendCounter.fetch_add(1, std::memory_order_relaxed));
+			FMemory::Memcpy(Datagram + Size + EthHeaderSize, Data, Len);
+			Size += EthHeaderSize + Len;
+		});
+		if (Size)
+		{
+			Slave->SendFrames(Datagram, Size);
+		}
+	}
+
+	bool bIsDone = false;
+
+private:
+	FSlave* Slave;
+	uint8 Datagram[MaxDatagramSize];
+};
+
+/***********************************************************************************************
+	FSlave
+***********************************************************************************************/
+
+FSlave::FSlave()
+{
+	DtoQueue.Init(DtoQueueSize);
+	WriteQueue.Init(256);
+}
+
+FSlave::~FSlave()
+{
+	Stop();
+}
+
+uint16 FSlave::AddEvent(const FString& Name, uint8 TimeCycle, uint8 TimeUnit)
+{
+	FEventChannel& Event = Events.AddDefaulted_GetRef();
+	Event.Name = Name;
+	Event.TimeCycle = TimeCycle;
+	Event.TimeUnit = TimeUnit;
+	return uint16(Events.Num() - 1);
+}
+
+bool FSlave::Start(int Port, soda::FAsyncTaskManager& InTaskManager)
+{
+	Stop();
+
+	TaskManager = &InTaskManager;
+
+	if (Port >= 0)
+	{
+		FIPv4Endpoint Endpoint(FIPv4Address(0, 0, 0, 0), Port);
+		Socket = FUdpSocketBuilder(TEXT("XCPSlave"))
+			.AsNonBlocking()
+			.AsReusable()
+			.BoundToEndpoint(Endpoint)
+			.WithReceiveBufferSize(0xFFFF)
+			.WithSendBufferSize(0xFFFFF);
+		if (!Socket)
+		{
+			UE_LOG(LogSoda, Error, TEXT("xcp::FSlave::Start(); Can't create socket on port %i"), Port);
+			return false;
+		}
+
+		UDPReceiver = new FUdpSocketReceiver(Socket, FTimespan::FromMilliseconds(100), TEXT("XCPSlave"));
+		UDPReceiver->OnDataReceived().BindRaw(this, &FSlave::OnRecv);
+		UDPReceiver->Start();
+	}
+
+	TSharedPtr<FDtoSendAsyncTask> Task = MakeShared<FDtoSendAsyncTask>(this);
+	SendTask = Task;
+	TaskManager->AddTask(SendTask);
+
+	return true;
+}
+
+void FSlave::Stop()
+{
+	if (SendTask)
+	{
+		StaticCastSharedPtr<FDtoSendAsyncTask>(SendTask)->bIsDone = true;
+		TaskManager->RemoteTask(SendTask);
+		SendTask.Reset();
+	}
+
+	if (UDPReceiver)
+	{
+		UDPReceiver->Stop();
+		delete UDPReceiver;
+		UDPReceiver = nullptr;
+	}
+
+	if (Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+
+	{
+		FScopeLock ScopeLock(&CommandLock);
+		StopAllDaq();
+		DaqLists.Empty();
+		bConnected = false;
+	}
+
+	DrainDto([](const uint8*, int) {});
+	ApplyPendingWrites();
+}
+
+void FSlave::Event(uint16 EventChannel, const TTimestamp& Timestamp)
+{
+	SCOPE_CYCLE_COUNTER(STAT_XCP_Event);
+
+	ActiveSamplers.fetch_add(1);
+	FDaqSnapshot* Snapshot = ActiveSnapshot.load();
+	bool bSampled = false;
+
+	if (Snapshot && EventChannel < Snapshot->ListsByEvent.Num())
+	{
+		const uint32 Clock = DaqClock(Timestamp);
+		for (int ListIndex : Snapshot->ListsByEvent[EventChannel])
+		{
+			FDaqSnapshot::FList& List = Snapshot->Lists[ListIndex];
+			if (++List.PrescalerCounter < List.Prescaler)
+			{
+				continue;
+			}
+			List.PrescalerCounter = 0;
+
+			for (const FDaqSnapshot::FOdt& Odt : List.Odts)
+			{
+				const bool bOk = DtoQueue.Enqueue([&Odt, Clock](FDto& Dto)
+				{
+					uint8* Ptr = Dto.Data;
+					*Ptr++ = Odt.Pid;
+					if (Odt.bTimestamp)
+					{
+						Put32(Ptr, Clock);
+						Ptr += 4;
+					}
+					for (const FOdtEntry& Entry : Odt.Entries)
+					{
+						FMemory::Memcpy(Ptr, Entry.Ptr, Entry.Size);
+						Ptr += Entry.Size;
+					}
+					Dto.Len = uint16(Ptr - Dto.Data);
+				});
+
+				if (bOk)
+				{
+					DtoNum.fetch_add(1, std::memory_order_relaxed);
+					bSampled = true;
+				}
+				else
+				{
+					OverrunNum.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		}
+	}
+
+	ActiveSamplers.fetch_sub(1);
+
+	if (bSampled && TaskManager)
+	{
+		TaskManager->Trigger();
+	}
+}
+
+void FSlave::ResetSymbolTable(TFunctionRef<void(FSymbolTable& SymbolTable)> Fill)
+{
+	FScopeLock ScopeLock(&CommandLock);
+
+	if (DaqLists.Num())
+	{
+		UE_LOG(LogSoda, Warning, TEXT("xcp::FSlave::ResetSymbolTable(); DAQ lists are freed"));
+	}
+
+	StopAllDaq();
+	DaqLists.Empty();
+	DaqPtrList = DaqPtrOdt = DaqPtrEntry = -1;
+	while (WriteQueue.Dequeue([](FWrite&) {})) {}
+
+	SymbolTable.Reset();
+	Fill(SymbolTable);
+}
+
+void FSlave::ApplyPendingWrites()
+{
+	while (WriteQueue.Dequeue([](FWrite& Write) { FMemory::Memcpy(Write.Ptr, Write.Data, Write.Size); })) {}
+}
+
+int FSlave::DrainDto(TFunctionRef<void(const uint8* Data, int Len)> Consume)
+{
+	int Num = 0;
+	while (DtoQueue.Dequeue([&Consume](FDto& Dto) { Consume(Dto.Data, Dto.Len); }))
+	{
+		++Num;
+	}
+	return Num;
+}
+
+void FSlave::StopAllDaq()
+{
+	for (FDaqList& List : DaqLists)
+	{
+		List.bRunning = false;
+		List.bSelected = false;
+	}
+	RebuildSnapshot();
+}
+
+int FSlave::GetOdtSize(const FOdt& Odt) const
+{
+	int Size = 0;
+	for (const FOdtEntry& Entry : Odt.Entries)
+	{
+		Size += Entry.Size;
+	}
+	return Size;
+}
+
+void FSlave::RebuildSnapshot()
+{
+	FDaqSnapshot* Snapshot = nullptr;
+	bool bAnyRunning = false;
+
+	for (const FDaqList& List : DaqLists)
+	{
+		bAnyRunning |= List.bRunning;
+	}
+
+	if (bAnyRunning)
+	{
+		Snapshot = new FDaqSnapshot;
+		Snapshot->ListsByEvent.SetNum(Events.Num());
+		for (const FDaqList& List : DaqLists)
+		{
+			if (!List.bRunning || List.EventChannel >= Events.Num())
+			{
+				continue;
+			}
+
+			FDaqSnapshot::FList& OutList = Snapshot->Lists.AddDefaulted_GetRef();
+			OutList.Prescaler = FMath::Max<uint8>(List.Prescaler, 1);
+			for (int OdtIndex = 0; OdtIndex < List.Odts.Num(); ++OdtIndex)
+			{
+				FDaqSnapshot::FOdt& OutOdt = OutList.Odts.AddDefaulted_GetRef();
+				OutOdt.Pid = List.FirstPid + OdtIndex;
+				OutOdt.bTimestamp = OdtIndex == 0 && (List.Mode & DaqListModeTimestamp);
+				for (const FOdtEntry& Entry : List.Odts[OdtIndex].Entries)
+				{
+					if (Entry.Ptr && Entry.Size)
+					{
+						OutOdt.Entries.Add(Entry);
+					}
+				}
+			}
+			Snapshot->ListsByEvent[List.EventChannel].Add(Snapshot->Lists.Num() - 1);
+		}
+	}
+
+	FDaqSnapshot* PrevSnapshot = ActiveSnapshot.exchange(Snapshot);
+	bDaqRunning = bAnyRunning;
+
+	if (PrevSnapshot)
+	{
+		// Samplers which could see the previous snapshot have entered Event() before the exchange
+		while (ActiveSamplers.load() != 0)
+		{
+			FPlatformProcess::YieldThread();
+		}
+		delete PrevSnapshot;
+	}
+}
+
+void FSlave::ReadMta(uint8 AddressExt, uint32 Address, uint8* Out, int Size) const
+{
+	if (AddressExt == MtaExtString)
+	{
+		for (int i = 0; i < Size; ++i)
+		{
+			Out[i] = int(Address) + i < MtaString.Num() ? MtaString[Address + i] : 0;
+		}
+	}
+	else
+	{
+		SymbolTable.Read(Address, Out, Size);
+	}
+}
+
+int FSlave::Error(uint8 Code, uint8(&Res)[MaxCto])
+{
+	Res[0] = SlaveToMasterPID::ERR;
+	Res[1] = Code;
+	return 2;
+}
+
+int FSlave::ProcessCommand(const uint8* Cmd, int CmdLen, uint8(&Res)[MaxCto])
+{
+	FScopeLock ScopeLock(&CommandLock);
+
+	if (CmdLen < 1)
+	{
+		return 0;
+	}
+
+	if (!bConnected && Cmd[0] != MasterToSlavePID::CONNECT)
+	{
+		return 0;
+	}
+
+	auto CheckLen = [CmdLen](int Len) { return CmdLen >= Len; };
+	auto GetList = [this](uint16 Index) { return Index < DaqLists.Num() ? &DaqLists[Index] : nullptr; };
+
+	FMemory::Memzero(Res);
+	Res[0] = SlaveToMasterPID::RES;
+
+	switch (Cmd[0])
+	{
+	case MasterToSlavePID::CONNECT:
+		bConnected = true;
+		Res[1] = uint8(EConnResourceParameterBits::CAL_PG) | uint8(EConnResourceParameterBits::DAQ);
+		Res[2] = uint8(EConnCommModeBasicBits::OPTIONAL_);
+		Res[3] = MaxCto;
+		Put16(&Res[4], MaxDto);
+		Res[6] = 1;
+		Res[7] = 1;
+		return 8;
+
+	case MasterToSlavePID::DISCONNECT:
+		StopAllDaq();
+		bConnected = false;
+		return 1;
+
+	case MasterToSlavePID::GET_STATUS:
+		Res[1] = bDaqRunning ? uint8(ECurrentSessionStatusBits::DAQ_RUNNING) : 0;
+		return 6;
+
+	case MasterToSlavePID::SYNCH:
+		return Error(ERR_CMD_SYNCH, Res);
+
+	case MasterToSlavePID::GET_COMM_MODE_INFO:
+		Res[7] = 0x10;
+		return 8;
+
+	case MasterToSlavePID::GET_ID:
+	{
+		const FTCHARToUTF8 Utf8(*Id);
+		MtaString.SetNum(0, false);
+		MtaString.Append((const uint8*)Utf8.Get(), Utf8.Length());
+		MtaExt = MtaExtString;
+		Mta = 0;
+		Put32(&Res[4], MtaString.Num());
+		return 8;
+	}
+
+	case MasterToSlavePID::SET_MTA:
+		if (!CheckLen(8)) return Error(ERR_CMD_SYNTAX, Res);
+		MtaExt = Cmd[3];
+		Mta = Get32(&Cmd[4]);
+		return 1;
+
+	case MasterToSlavePID::UPLOAD:
+	{
+		if (!CheckLen(2)) return Error(ERR_CMD_SYNTAX, Res);
+		const uint8 Num = Cmd[1];
+		if (Num > MaxCto - 1) return Error(ERR_OUT_OF_RANGE, Res);
+		ReadMta(MtaExt, Mta, &Res[1], Num);
+		Mta += Num;
+		return 1 + Num;
+	}
+
+	case MasterToSlavePID::SHORT_UPLOAD:
+	{
+		if (!CheckLen(8)) return Error(ERR_CMD_SYNTAX, Res);
+		const uint8 Num = Cmd[1];
+		if (Num > MaxCto - 1) return Error(ERR_OUT_OF_RANGE, Res);
+		MtaExt = Cmd[3];
+		Mta = Get32(&Cmd[4]);
+		ReadMta(MtaExt, Mta, &Res[1], Num);
+		Mta += Num;
+		return 1 + Num;
+	}
+
+	case MasterToSlavePID::DOWNLOAD:
+	{
+		if (!CheckLen(2) || !CheckLen(2 + Cmd[1])) return Error(ERR_CMD_SYNTAX, Res);
+		const uint8 Num = Cmd[1];
+		if (MtaExt != 0) return Error(ERR_WRITE_PROTECTED, Res);
+		uint8* Ptr = SymbolTable.Resolve(Mta, Num, true);
+		if (!Ptr) return Error(ERR_ACCESS_DENIED, Res);
+		const bool bQueued = WriteQueue.Enqueue([&](FWrite& Write)
+		{
+			Write.Ptr = Ptr;
+			Write.Size = Num;
+			FMemory::Memcpy(Write.Data, &Cmd[2], Num);
+		});
+		if (!bQueued) return Error(ERR_MEMORY_OVERFLOW, Res);
+		Mta += Num;
+		return 1;
+	}
+
+	case MasterToSlavePID::FREE_DAQ:
+		StopAllDaq();
+		DaqLists.Empty();
+		DaqPtrList = DaqPtrOdt = DaqPtrEntry = -1;
+		return 1;
+
+	case MasterToSlavePID::ALLOC_DAQ:
+		if (!CheckLen(4)) return Error(ERR_CMD_SYNTAX, Res);
+		if (bDaqRunning) return Error(ERR_DAQ_ACTIVE, Res);
+		if (DaqLists.Num() > 0) return Error(ERR_SEQUENCE, Res);
+		DaqLists.SetNum(Get16(&Cmd[2]));
+		return 1;
+
+	case MasterToSlavePID::ALLOC_ODT:
+	{
+		if (!CheckLen(5)) return Error(ERR_CMD_SYNTAX, Res);
+		FDaqList* List = GetList(Get16(&Cmd[2]));
+		if (!List) return Error(ERR_OUT_OF_RANGE, Res);
+		if (bDaqRunning) return Error(ERR_DAQ_ACTIVE, Res);
+		int Pid = 0;
+		for (FDaqList& It : DaqLists)
+		{
+			if (&It == List) break;
+			Pid += It.Odts.Num();
+		}
+		if (Pid + Cmd[4] > MaxPid + 1) return Error(ERR_MEMORY_OVERFLOW, Res);
+		List->FirstPid = uint8(Pid);
+		List->Odts.SetNum(Cmd[4]);
+		return 1;
+	}
+
+	case MasterToSlavePID::ALLOC_ODT_ENTRY:
+	{
+		if (!CheckLen(6)) return Error(ERR_CMD_SYNTAX, Res);
+		FDaqList* List = GetList(Get16(&Cmd[2]));
+		if (!List || Cmd[4] >= List->Odts.Num()) return Error(ERR_OUT_OF_RANGE, Res);
+		if (bDaqRunning) return Error(ERR_DAQ_ACTIVE, Res);
+		List->Odts[Cmd[4]].Entries.SetNum(Cmd[5]);
+		return 1;
+	}
+
+	case MasterToSlavePID::SET_DAQ_PTR:
+	{
+		if (!CheckLen(6)) return Error(ERR_CMD_SYNTAX, Res);
+		const uint16 ListIndex = Get16(&Cmd[2]);
+		FDaqList* List = GetList(ListIndex);
+		if (!List || Cmd[4] >= List->Odts.Num() || Cmd[5] >= List->Odts[Cmd[4]].Entries.Num()) return Error(ERR_OUT_OF_RANGE, Res);
+		DaqPtrList = ListIndex;
+		DaqPtrOdt = Cmd[4];
+		DaqPtrEntry = Cmd[5];
+		return 1;
+	}
+
+	case MasterToSlavePID::WRITE_DAQ:
+	{
+		if (!CheckLen(8)) return Error(ERR_CMD_SYNTAX, Res);
+		FDaqList* List = GetList(DaqPtrList);
+		if (!List || DaqPtrOdt < 0 || DaqPtrEntry < 0) return Error(ERR_SEQUENCE, Res);
+		// ALLOC_ODT and ALLOC_ODT_ENTRY after SET_DAQ_PTR can shrink the list
+		if (DaqPtrOdt >= List->Odts.Num() || DaqPtrEntry >= List->Odts[DaqPtrOdt].Entries.Num()) return Error(ERR_OUT_OF_RANGE, Res);
+		if (List->bRunning) return Error(ERR_DAQ_ACTIVE, Res);
+		const uint8 Size = Cmd[2];
+		if (Cmd[1] != 0xFF || Size == 0 || Size > 8 || Cmd[3] != 0) return Error(ERR_OUT_OF_RANGE, Res);
+		const uint32 Address = Get32(&Cmd[4]);
+		uint8* Ptr = SymbolTable.Resolve(Address, Size);
+		if (!Ptr) return Error(ERR_ACCESS_DENIED, Res);
+
+		FOdt& Odt = List->Odts[DaqPtrOdt];
+		FOdtEntry& Entry = Odt.Entries[DaqPtrEntry];
+		const int MaxOdtSize = MaxDto - 1 - (DaqPtrOdt == 0 ? 4 : 0);
+		if (GetOdtSize(Odt) - Entry.Size + Size > MaxOdtSize) return Error(ERR_DAQ_CONFIG, Res);
+		Entry.Address = Address;
+		Entry.Size = Size;
+		Entry.Ptr = Ptr;
+		++DaqPtrEntry;
+		return 1;
+	}
+
+	case MasterToSlavePID::SET_DAQ_LIST_MODE:
+	{
+		if (!CheckLen(8)) return Error(ERR_CMD_SYNTAX, Res);
+		FDaqList* List = GetList(Get16(&Cmd[2]));
+		if (!List) return Error(ERR_OUT_OF_RANGE, Res);
+		if (List->bRunning) return Error(ERR_DAQ_ACTIVE, Res);
+		const uint8 Mode = Cmd[1];
+		if (Mode & (DaqListModeDirection | DaqListModePidOff)) return Error(ERR_MODE_NOT_VALID, Res);
+		const uint16 EventChannel = Get16(&Cmd[4]);
+		if (EventChannel >= Events.Num()) return Error(ERR_OUT_OF_RANGE, Res);
+		List->Mode = Mode;
+		List->EventChannel = EventChannel;
+		List->Prescaler = FMath::Max<uint8>(Cmd[6], 1);
+		List->Priority = Cmd[7];
+		return 1;
+	}
+
+	case MasterToSlavePID::GET_DAQ_LIST_MODE:
+	{
+		if (!CheckLen(4)) return Error(ERR_CMD_SYNTAX, Res);
+		FDaqList* List = GetList(Get16(&Cmd[2]));
+		if (!List) return Error(ERR_OUT_OF_RANGE, Res);
+		Res[1] = (List->Mode & DaqListModeTimestamp) | (List->bSelected ? DaqListModeSelected : 0) | (List->bRunning ? DaqListModeRunning : 0);
+		Put16(&Res[4], List->EventChannel);
+		Res[6] = List->Prescaler;
+		Res[7] = List->Priority;
+		return 8;
+	}
+
+	case MasterToSlavePID::START_STOP_DAQ_LIST:
+	{
+		if (!CheckLen(4)) return Error(ERR_CMD_SYNTAX, Res);
+		FDaqList* List = GetList(Get16(&Cmd[2]));
+		if (!List) return Error(ERR_OUT_OF_RANGE, Res);
+		switch (Cmd[1])
+		{
+		case 0: List->bRunning = false; RebuildSnapshot(); break;
+		case 1: List->bRunning = true; RebuildSnapshot(); break;
+		case 2: List->bSelected = true; break;
+		default: return Error(ERR_MODE_NOT_VALID, Res);
+		}
+		Res[1] = List->FirstPid;
+		return 2;
+	}
+
+	case MasterToSlavePID::START_STOP_SYNCH:
+	{
+		if (!CheckLen(2)) return Error(ERR_CMD_SYNTAX, Res);
+		if (Cmd[1] > 2) return Error(ERR_MODE_NOT_VALID, Res);
+		for (FDaqList& List : DaqLists)
+		{
+			if (Cmd[1] == 0)
+			{
+				List.bRunning = false;
+			}
+			else if (List.bSelected)
+			{
+				List.bRunning = Cmd[1] == 1;
+			}
+			List.bSelected = false;
+		}
+		RebuildSnapshot();
+		return 1;
+	}
+
+	case MasterToSlavePID::GET_DAQ_CLOCK:
+		Put32(&Res[4], DaqClock(soda::Now()));
+		return 8;
+
+	case MasterToSlavePID::GET_DAQ_PROCESSOR_INFO:
+		Res[1] = 0x13; // DAQ_CONFIG_TYPE dynamic, PRESCALER_SUPPORTED, TIMESTAMP_SUPPORTED
+		Put16(&Res[2], MaxPid + 1);
+		Put16(&Res[4], Events.Num());
+		Res[6] = 0;
+		Res[7] = 0;
+		return 8;
+
+	case MasterToSlavePID::GET_DAQ_RESOLUTION_INFO:
+		Res[1] = 1;
+		Res[2] = 8;
+		Res[3] = 1;
+		Res[4] = 8;
+		Res[5] = 0x34; // DWORD timestamp, 1us unit
+		Put16(&Res[6], 1);
+		return 8;
+
+	case MasterToSlavePID::GET_DAQ_EVENT_INFO:
+	{
+		if (!CheckLen(4)) return Error(ERR_CMD_SYNTAX, Res);
+		const uint16 EventChannel = Get16(&Cmd[2]);
+		if (EventChannel >= Events.Num()) return Error(ERR_OUT_OF_RANGE, Res);
+		const FEventChannel& Event = Events[EventChannel];
+		const FTCHARToUTF8 Utf8(*Event.Name);
+		MtaString.SetNum(0, false);
+		MtaString.Append((const uint8*)Utf8.Get(), Utf8.Length());
+		MtaExt = MtaExtString;
+		Mta = 0;
+		Res[1] = 0x04; // DAQ
+		Res[2] = 0xFF;
+		Res[3] = uint8(FMath::Min(MtaString.Num(), 255));
+		Res[4] = Event.TimeCycle;
+		Res[5] = Event.TimeUnit;
+		Res[6] = 0;
+		return 7;
+	}
+
+	default:
+		return Error(ERR_CMD_UNKNOWN, Res);
+	}
+}
+
+void FSlave::OnRecv(const FArrayReaderPtr& ArrayReaderPtr, const FIPv4Endpoint& EndPt)
+{
+	const uint8* Data = ArrayReaderPtr->GetData();
+	const int Num = ArrayReaderPtr->Num();
+
+	uint8 Frame[EthHeaderSize + MaxCto];
+	for (int Offset = 0; Offset + EthHeaderSize <= Num;)
+	{
+		const int Len = Get16(Data + Offset);
+		if (Offset + EthHeaderSize + Len > Num)
+		{
+			UE_LOG(LogSoda, Warning, TEXT("xcp::FSlave::OnRecv(); Truncated frame from %s"), *EndPt.ToString());
+			break;
+		}
+
+		const uint8* Cmd = Data + Offset + EthHeaderSize;
+		Offset += EthHeaderSize + Len;
+
+		if (Len > 0 && Cmd[0] == MasterToSlavePID::CONNECT)
+		{
+			FScopeLock ScopeLock(&MasterAddrLock);
+			MasterAddr = EndPt.ToInternetAddr();
+		}
+
+		uint8 Res[MaxCto];
+		const int ResLen = ProcessCommand(Cmd, Len, Res);
+		if (ResLen > 0)
+		{
+			Put16(Frame, uint16(ResLen));
+			Put16(Frame + 2, SendCounter.fetch_add(1, std::memory_order_relaxed));
+			FMemory::Memcpy(Frame + EthHeaderSize, Res, ResLen);
+			SendFrames(Frame, EthHeaderSize + ResLen);
+		}
+	}
+}
+
+void FSlave::SendFrames(const uint8* Data, int Len)
+{
+	TSharedPtr<FInternetAddr> Addr;
+	{
+		FScopeLock ScopeLock(&MasterAddrLock);
+		Addr = MasterAddr;
+	}
+
+	if (Socket && Addr)
+	{
+		int32 BytesSent = 0;
+		if (!Socket->SendTo(Data, Len, BytesSent, *Addr))
+		{
+			UE_LOG(LogSoda, Warning, TEXT("xcp::FSlave::SendFrames(); Can't send %i bytes"), Len);
+		}
+	}
+}
+
+/***********************************************************************************************
+	FLoopbackTransport
+***********************************************************************************************/
+
+bool FLoopbackTransport::Send(const FPacket& Packet)
+{
+	TSharedPtr<FSlave> SlavePtr = Slave.Pin();
+	if (!SlavePtr)
+	{
+		return false;
+	}
+
+	uint8 Res[FSlave::MaxCto];
+	const int ResLen = SlavePtr->ProcessCommand(Packet.Data, Packet.Length, Res);
+	if (ResLen > 0)
+	{
+		ProcessResponse(FPacket(Res, ResLen), CounterReceived + 1, soda::Now());
+	}
+	return true;
+}
+
+} // xcp
@@ -53,13 +53,7 @@ void AScenarioAction::Tick(float DeltaTime)
 
 	if (USodaSubsystem::Get()->IsScenarioRunning())
 	{
-		for (auto& It : ScenarioBlocks)
-		{
-			for (auto& EventIt : It->Events)
-			{
-				EventIt->Tick(DeltaTime);
-			}
-		}
+		Graph.Tick(DeltaTime);
 	}
 }
 
@@ -111,6 +105,8 @@ void AScenarioAction::ScenarioBegin()
 			EventIt->ScenarioBegin();
 		}
 	}
+
+	Graph.Compile(ScenarioBlocks);
 }
 
 void AScenarioAction::ScenarioEnd()
@@ -123,6 +119,8 @@ void AScenarioAction::ScenarioEnd()
 			EventIt->EventDelegate.Unbind();
 		}
 	}
+
+	Graph.Reset();
 }
 
 TSharedPtr<SWidget> AScenarioAction::GenerateToolBar()
@@ -152,6 +152,20 @@ bool UScenarioActionBlock::ExecuteConditionMatrix()
 	return !ThereIsCell;
 }
 
+void UScenarioActionBlock::CompileConditions()
+{
+	for (auto& Row : ConditionMatrix)
+	{
+		for (auto& Col : Row.ScenarioConditiones)
+		{
+			if (IsValid(Col))
+			{
+				Col->Compile();
+			}
+		}
+	}
+}
+
 bool UScenarioActionBlock::ExecuteBlock()
 {
 	if (GetActionBlockMode() == EScenarioActionBlockMode::MultipleExecute || ExexuteCounter == 0)
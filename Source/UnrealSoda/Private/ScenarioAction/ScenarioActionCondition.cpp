@@ -5,8 +5,21 @@
 #include "RuntimePropertyEditor/IStructureDetailsView.h"
 #include "RuntimeMetaData.h"
 #include "Soda/ScenarioAction/ScenarioActionUtils.h"
+#include "Soda/ScenarioAction/ScenarioActionConditionFunctionLibrary.h"
 #include "Modules/ModuleManager.h"
 
+FScenarioConditionThunks& FScenarioConditionThunks::Get()
+{
+	static FScenarioConditionThunks Instance;
+	static bool bRegistered = false;
+	if (!bRegistered)
+	{
+		bRegistered = true;
+		UScenarioActionConditionFunctionLibrary::RegisterConditionThunks(Instance);
+	}
+	return Instance;
+}
+
 UScenarioActionCondition::UScenarioActionCondition(const FObjectInitializer& InInitializer)
 	: Super(InInitializer)
 {
@@ -61,16 +74,50 @@ TSharedRef< SWidget > UScenarioActionConditionFunction::MakeWidget()
 	return SNullWidget::NullWidget;
 }
 
+void UScenarioActionConditionFunction::Compile()
+{
+	bCompiled = true;
+	CachedResult.Reset();
+	CompiledFunction = Function.Get();
+	CompiledOwner = FunctionOwner.IsValid() ? FunctionOwner.Get()->GetDefaultObject() : nullptr;
+	CompiledThunk = CompiledFunction ? FScenarioConditionThunks::Get().Find(CompiledFunction) : nullptr;
+}
+
 bool UScenarioActionConditionFunction::Execute()
 {
+	if (CachedResult.IsSet())
+	{
+		return CachedResult.GetValue();
+	}
+
+	if (!bCompiled)
+	{
+		Compile();
+	}
+
+	if (!StructOnScope.IsValid() || !CompiledFunction)
+	{
+		return false;
+	}
+
+	if (CompiledThunk)
+	{
+		const bool bResult = CompiledThunk->Call(StructOnScope->GetStructMemory());
+		if (CompiledThunk->bPure)
+		{
+			CachedResult = bResult;
+		}
+		return bResult;
+	}
+
 	//FScopedScriptExceptionHandler ExceptionHandler([](ELogVerbosity::Type Verbosity, const TCHAR* ExceptionMessage, const TCHAR* StackMessage) {});
 	FEditorScriptExecutionGuard ScriptGuard;
 
-	if (Function && StructOnScope.IsValid() && FunctionOwner.IsValid())
+	if (CompiledOwner)
 	{
-		if (FProperty* RetProperty = Function->GetReturnProperty())
+		if (FProperty* RetProperty = CompiledFunction->GetReturnProperty())
 		{
-			FunctionOwner.Get()->GetDefaultObject()->ProcessEvent(Function.Get(), StructOnScope->GetStructMemory());
+			CompiledOwner->ProcessEvent(CompiledFunction, StructOnScope->GetStructMemory());
 			bool* ReValue = RetProperty->ContainerPtrToValuePtr<bool>(StructOnScope->GetStructMemory());
 			if (ReValue)
 			{
@@ -87,6 +134,8 @@ void UScenarioActionConditionFunction::SetFunction(UFunction* InFunction, UClass
 
 	Function = InFunction;
 	FunctionOwner = InOwnerClass;
+	bCompiled = false;
+	CachedResult.Reset();
 
 	StructOnScope = MakeShared< FStructOnScope>(Function.Get());
 	if (StructOnScope.IsValid())
@@ -1,6 +1,7 @@
 // Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
 
 #include "Soda/ScenarioAction/ScenarioActionConditionFunctionLibrary.h"
+#include "Soda/ScenarioAction/ScenarioActionCondition.h"
 
 UScenarioActionConditionFunctionLibraryBase::UScenarioActionConditionFunctionLibraryBase(const FObjectInitializer& InInitializer)
 	: Super(InInitializer)
@@ -30,4 +31,13 @@ bool UScenarioActionConditionFunctionLibrary::TestFunction3(bool Param1, int Par
 bool UScenarioActionConditionFunctionLibrary::TestFunction4(const FVector& Param1, const FRotator& Param2)
 {
 	return false;
-}
\ No newline at end of file
+}
+
+void UScenarioActionConditionFunctionLibrary::RegisterConditionThunks(FScenarioConditionThunks& Thunks)
+{
+	UClass* Class = StaticClass();
+	Thunks.Register(Class, GET_FUNCTION_NAME_CHECKED(UScenarioActionConditionFunctionLibrary, TestFunction1), &TestFunction1, true);
+	Thunks.Register(Class, GET_FUNCTION_NAME_CHECKED(UScenarioActionConditionFunctionLibrary, TestFunction2), &TestFunction2, true);
+	Thunks.Register(Class, GET_FUNCTION_NAME_CHECKED(UScenarioActionConditionFunctionLibrary, TestFunction3), &TestFunction3, true);
+	Thunks.Register(Class, GET_FUNCTION_NAME_CHECKED(UScenarioActionConditionFunctionLibrary, TestFunction4), &TestFunction4, true);
+}
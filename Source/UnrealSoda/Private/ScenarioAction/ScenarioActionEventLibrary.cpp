@@ -5,6 +5,7 @@
 #include "Soda/Actors/ScenarioTriggerActors.h"
 #include "Components/ShapeComponent.h"
 #include "Soda/SodaStatics.h"
+#include "Soda/ScenarioAction/ScenarioActionGraph.h"
 
 //-------------------------------------------------------------------------------------------------
 UEventAtScenarioBegin::UEventAtScenarioBegin(const FObjectInitializer& InInitializer)
@@ -66,6 +67,29 @@ void UEventOverlapTrigger::Tick(float DeltaTime)
 	}
 }
 
+bool UEventOverlapTrigger::Compile(FScenarioActorSnapshot& Snapshot, TArray<int32>& OutDependencies)
+{
+	// The overlap can change only if the actor or the trigger moves
+	ActorSlot = Snapshot.AddActor(Actor.Get());
+	const int32 TriggerSlot = Snapshot.AddActor(Trigger.Get());
+	if (ActorSlot == INDEX_NONE || TriggerSlot == INDEX_NONE)
+	{
+		return false;
+	}
+	OutDependencies.Add(ActorSlot);
+	OutDependencies.Add(TriggerSlot);
+	return true;
+}
+
+bool UEventOverlapTrigger::Evaluate(const FScenarioActorSnapshot& Snapshot)
+{
+	if (Snapshot[ActorSlot].bValid && Trigger.Get())
+	{
+		return Trigger->GetCollisionComponent()->IsOverlappingActor(Actor.Get());
+	}
+	return false;
+}
+
 //-------------------------------------------------------------------------------------------------
 UEventRelativeDistance::UEventRelativeDistance(const FObjectInitializer& InInitializer)
 	: Super(InInitializer)
@@ -86,66 +110,91 @@ void UEventRelativeDistance::Tick(float DeltaTime)
 {
 	if (FromActor.IsValid() && ToActor.IsValid())
 	{
-		float CurDistance = MAX_FLT;
-		if (OverlapEstimation == EScenarioEventOverlapEstimation::Position)
+		if (Check(CalcDistance(FromActor->GetTransform(), ToActor->GetTransform())))
+		{
+			EventDelegate.ExecuteIfBound();
+		}
+	}
+}
+
+bool UEventRelativeDistance::Compile(FScenarioActorSnapshot& Snapshot, TArray<int32>& OutDependencies)
+{
+	const bool bNeedExtent = OverlapEstimation == EScenarioEventOverlapEstimation::ClosesPoint;
+	FromSlot = Snapshot.AddActor(FromActor.Get(), bNeedExtent);
+	ToSlot = Snapshot.AddActor(ToActor.Get(), bNeedExtent);
+	if (FromSlot == INDEX_NONE || ToSlot == INDEX_NONE)
+	{
+		return false;
+	}
+	OutDependencies.Add(FromSlot);
+	OutDependencies.Add(ToSlot);
+	if (bNeedExtent)
+	{
+		FromActorExtent = Snapshot[FromSlot].Extent;
+		ToActorExtent = Snapshot[ToSlot].Extent;
+	}
+	return true;
+}
+
+bool UEventRelativeDistance::Evaluate(const FScenarioActorSnapshot& Snapshot)
+{
+	const FScenarioActorState& From = Snapshot[FromSlot];
+	const FScenarioActorState& To = Snapshot[ToSlot];
+	return From.bValid && To.bValid && Check(CalcDistance(From.Transform, To.Transform));
+}
+
+float UEventRelativeDistance::CalcDistance(const FTransform& FromActorTransform, const FTransform& ToActorTransform) const
+{
+	if (OverlapEstimation == EScenarioEventOverlapEstimation::Position)
+	{
+		if (DistanceEstimation == EScenarioEventDistanceEstimation::Longotude)
 		{
-			if (DistanceEstimation == EScenarioEventDistanceEstimation::Longotude)
-			{
-				CurDistance = FromActor.Get()->GetTransform().InverseTransformPositionNoScale(ToActor.Get()->GetActorLocation()).X;
-			}
-			else // EScenarioEventDistanceEstimation::Euclidean
-			{
-				CurDistance = (FromActor.Get()->GetActorLocation() - ToActor.Get()->GetActorLocation()).Size();
-			}
+			return FromActorTransform.InverseTransformPositionNoScale(ToActorTransform.GetLocation()).X;
 		}
-		else // EScenarioEventOverlapEstimation::ClosesPoint
+		else // EScenarioEventDistanceEstimation::Euclidean
 		{
-			const FTransform& ToActorTransform = ToActor->GetTransform();
-			const FTransform& FromActorTransform = FromActor->GetTransform();
-
-			FVector Vertices[8];
-			ToActorExtent.GetVertices(Vertices);
-
-			FBox NewBox(ForceInit);
-			for (int32 VertexIndex = 0; VertexIndex < UE_ARRAY_COUNT(Vertices); VertexIndex++)
-			{
-				FVector ProjectedVertex = FromActorTransform.InverseTransformPosition(ToActorTransform.TransformPosition(Vertices[VertexIndex]));
-				NewBox += ProjectedVertex;
-			}
-
-			//DrawDebugBox(GetWorld(), FromActorExtent.GetCenter(), FromActorExtent.GetExtent(), FQuat::Identity, FColor::Red, false, -1.f, 0, 1.f);
-			//DrawDebugBox(GetWorld(), NewBox.GetCenter(), NewBox.GetExtent(), FQuat::Identity, FColor::Green, false, -1.f, 0, 1.f);
-
-			if (DistanceEstimation == EScenarioEventDistanceEstimation::Longotude)
-			{
-				CurDistance = NewBox.Min.X - FromActorExtent.Max.X;
-			}
-			else // EScenarioEventDistanceEstimation::Euclidean
-			{
-				CurDistance = FMath::Sqrt(FromActorExtent.ComputeSquaredDistanceToBox(NewBox));
-			}
+			return (FromActorTransform.GetLocation() - ToActorTransform.GetLocation()).Size();
 		}
+	}
+	else // EScenarioEventOverlapEstimation::ClosesPoint
+	{
+		FVector Vertices[8];
+		ToActorExtent.GetVertices(Vertices);
 
-		//UE_LOG(LogSoda, Warning, TEXT("*** %f"), CurDistance);
+		// Project the box of the ToActor to the FromActor space by the one relative transform
+		const FTransform RelativeTransform = ToActorTransform.GetRelativeTransform(FromActorTransform);
+		FBox NewBox(ForceInit);
+		for (int32 VertexIndex = 0; VertexIndex < UE_ARRAY_COUNT(Vertices); VertexIndex++)
+		{
+			NewBox += RelativeTransform.TransformPosition(Vertices[VertexIndex]);
+		}
 
-		switch (Conditional)
+		//DrawDebugBox(GetWorld(), FromActorExtent.GetCenter(), FromActorExtent.GetExtent(), FQuat::Identity, FColor::Red, false, -1.f, 0, 1.f);
+		//DrawDebugBox(GetWorld(), NewBox.GetCenter(), NewBox.GetExtent(), FQuat::Identity, FColor::Green, false, -1.f, 0, 1.f);
+
+		if (DistanceEstimation == EScenarioEventDistanceEstimation::Longotude)
+		{
+			return NewBox.Min.X - FromActorExtent.Max.X;
+		}
+		else // EScenarioEventDistanceEstimation::Euclidean
 		{
-		case EScenarioEventConditional::LessThan:
-			if (CurDistance < Distance)
-			{
-				EventDelegate.ExecuteIfBound();
-			}
-			break;
-		case EScenarioEventConditional::GreaterThan:
-			if (CurDistance > Distance)
-			{
-				EventDelegate.ExecuteIfBound();
-			}
-			break;
+			return FMath::Sqrt(FromActorExtent.ComputeSquaredDistanceToBox(NewBox));
 		}
 	}
 }
 
+bool UEventRelativeDistance::Check(float CurDistance) const
+{
+	switch (Conditional)
+	{
+	case EScenarioEventConditional::LessThan:
+		return CurDistance < Distance;
+	case EScenarioEventConditional::GreaterThan:
+		return CurDistance > Distance;
+	}
+	return false;
+}
+
 //-------------------------------------------------------------------------------------------------
 UEventRelativeSpeed::UEventRelativeSpeed(const FObjectInitializer& InInitializer)
 	: Super(InInitializer)
@@ -157,28 +206,45 @@ void UEventRelativeSpeed::Tick(float DeltaTime)
 {
 	if (FromActor.IsValid() && ToActor.IsValid())
 	{
-		const FVector FromActorVelocity = FromActor->GetTransform().InverseTransformVectorNoScale(FromActor->GetVelocity());
-		const FVector ToActorVelocity = FromActor->GetTransform().InverseTransformVectorNoScale(ToActor->GetVelocity());
-		const float CurrVel = FromActor->GetTransform().InverseTransformVectorNoScale(FromActor->GetVelocity() - ToActor->GetVelocity()).X;
-
-		switch (Conditional)
+		if (Check(FromActor->GetTransform(), FromActor->GetVelocity(), ToActor->GetVelocity()))
 		{
-		case EScenarioEventConditional::LessThan:
-			if (CurrVel < Speed)
-			{
-				EventDelegate.ExecuteIfBound();
-			}
-			break;
-		case EScenarioEventConditional::GreaterThan:
-			if (CurrVel > Speed)
-			{
-				EventDelegate.ExecuteIfBound();
-			}
-			break;
+			EventDelegate.ExecuteIfBound();
 		}
+	}
+}
+
+bool UEventRelativeSpeed::Compile(FScenarioActorSnapshot& Snapshot, TArray<int32>& OutDependencies)
+{
+	FromSlot = Snapshot.AddActor(FromActor.Get());
+	ToSlot = Snapshot.AddActor(ToActor.Get());
+	if (FromSlot == INDEX_NONE || ToSlot == INDEX_NONE)
+	{
+		return false;
+	}
+	OutDependencies.Add(FromSlot);
+	OutDependencies.Add(ToSlot);
+	return true;
+}
 
-		UE_LOG(LogSoda, Warning, TEXT("V %f"), CurrVel);
+bool UEventRelativeSpeed::Evaluate(const FScenarioActorSnapshot& Snapshot)
+{
+	const FScenarioActorState& From = Snapshot[FromSlot];
+	const FScenarioActorState& To = Snapshot[ToSlot];
+	return From.bValid && To.bValid && Check(From.Transform, From.Velocity, To.Velocity);
+}
+
+bool UEventRelativeSpeed::Check(const FTransform& FromTransform, const FVector& FromVelocity, const FVector& ToVelocity) const
+{
+	const float CurrVel = FromTransform.InverseTransformVectorNoScale(FromVelocity - ToVelocity).X;
+
+	switch (Conditional)
+	{
+	case EScenarioEventConditional::LessThan:
+		return CurrVel < Speed;
+	case EScenarioEventConditional::GreaterThan:
+		return CurrVel > Speed;
 	}
+	return false;
 }
 
 //-------------------------------------------------------------------------------------------------
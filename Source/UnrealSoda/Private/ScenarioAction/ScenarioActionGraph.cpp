@@ -0,0 +1,133 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/ScenarioAction/ScenarioActionGraph.h"
+#include "Soda/ScenarioAction/ScenarioActionBlock.h"
+#include "Soda/ScenarioAction/ScenarioActionEvent.h"
+#include "Soda/SodaStatics.h"
+#include "GameFramework/Actor.h"
+
+DECLARE_STATS_GROUP(TEXT("ScenarioAction"), STATGROUP_ScenarioAction, STATGROUP_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Snapshot"), STAT_ScenarioSnapshot, STATGROUP_ScenarioAction);
+DECLARE_CYCLE_STAT(TEXT("Events"), STAT_ScenarioEvents, STATGROUP_ScenarioAction);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Evaluated events"), STAT_ScenarioEvaluatedEvents, STATGROUP_ScenarioAction);
+
+int32 FScenarioActorSnapshot::AddActor(AActor* Actor, bool bNeedExtent)
+{
+	if (!Actor)
+	{
+		return INDEX_NONE;
+	}
+
+	int32& Slot = ActorSlots.FindOrAdd(Actor, INDEX_NONE);
+	if (Slot == INDEX_NONE)
+	{
+		Slot = States.Num();
+		FScenarioActorState& State = States.AddDefaulted_GetRef();
+		State.Actor = Actor;
+	}
+
+	FScenarioActorState& State = States[Slot];
+	if (bNeedExtent && !State.Extent.IsValid)
+	{
+		State.Extent = USodaStatics::CalculateActorExtent(Actor);
+	}
+	return Slot;
+}
+
+void FScenarioActorSnapshot::Update()
+{
+	for (FScenarioActorState& State : States)
+	{
+		const AActor* Actor = State.Actor.Get();
+		const bool bValid = IsValid(Actor);
+		if (bValid)
+		{
+			const FTransform& Transform = Actor->GetActorTransform();
+			const FVector Velocity = Actor->GetVelocity();
+			State.bDirty = !State.bValid || !Transform.Equals(State.Transform, KINDA_SMALL_NUMBER) || !Velocity.Equals(State.Velocity, KINDA_SMALL_NUMBER);
+			State.Transform = Transform;
+			State.Velocity = Velocity;
+		}
+		else
+		{
+			State.bDirty = State.bValid;
+		}
+		State.bValid = bValid;
+	}
+}
+
+void FScenarioActorSnapshot::Reset()
+{
+	States.Empty();
+	ActorSlots.Empty();
+}
+
+void FScenarioActionGraph::Compile(const TArray<UScenarioActionBlock*>& Blocks)
+{
+	Reset();
+
+	for (UScenarioActionBlock* Block : Blocks)
+	{
+		if (!IsValid(Block))
+		{
+			continue;
+		}
+		Block->CompileConditions();
+		for (UScenarioActionEvent* Event : Block->Events)
+		{
+			if (!IsValid(Event))
+			{
+				continue;
+			}
+			FEventNode& Node = EventNodes.AddDefaulted_GetRef();
+			Node.Event = Event;
+			TArray<int32> Dependencies;
+			Node.bCompiled = Event->Compile(Snapshot, Dependencies);
+			Node.Dependencies = Dependencies;
+		}
+	}
+}
+
+void FScenarioActionGraph::Reset()
+{
+	Snapshot.Reset();
+	EventNodes.Empty();
+}
+
+void FScenarioActionGraph::Tick(float DeltaTime)
+{
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ScenarioSnapshot);
+		Snapshot.Update();
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ScenarioEvents);
+
+	for (FEventNode& Node : EventNodes)
+	{
+		if (!Node.bCompiled)
+		{
+			Node.Event->Tick(DeltaTime);
+			continue;
+		}
+
+		bool bDirty = !Node.bEvaluated;
+		for (int32 Slot : Node.Dependencies)
+		{
+			bDirty |= Snapshot.IsDirty(Slot);
+		}
+
+		if (bDirty)
+		{
+			INC_DWORD_STAT(STAT_ScenarioEvaluatedEvents);
+			Node.bResult = Node.Event->Evaluate(Snapshot);
+			Node.bEvaluated = true;
+		}
+
+		// The events are level triggered, the block is executed every frame while the result is true
+		if (Node.bResult)
+		{
+			Node.Event->EventDelegate.ExecuteIfBound();
+		}
+	}
+}
@@ -3,6 +3,7 @@
 #include "Soda/SodaApp.h"
 #include "Soda/UnrealSoda.h"
 #include "Soda/SodaSubsystem.h"
+#include "Soda/SodaSimulationClock.h"
 #include "Soda/Vehicles/SodaVehicle.h"
 #include "Soda/SodaCommonSettings.h"
 #include "Soda/DBC/Serialization.h"
@@ -141,11 +142,9 @@ void FSodaApp::OnPreTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
 	if (GameWorld == World && TickType == ELevelTick::LEVELTICK_All)
 	{
 		++FrameIndex;
+		SimulationTimestamp = World->GetSubsystem<USodaSimulationClock>()->AdvanceFrame(DeltaSeconds);
 		if(bSynchronousMode)
 		{
-			TotalTime += DeltaSeconds;
-			SimulationTimestamp = soda::ChronoTimestamp<std::chrono::system_clock, std::chrono::duration<double>>(TotalTime);
-
 			while (bSynchronousMode && TickCuesReceived <= 0)
 			{
 				std::this_thread::sleep_for(std::chrono::milliseconds(1));
@@ -156,7 +155,7 @@ void FSodaApp::OnPreTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
 		}
 		else
 		{
-			RealtimeTimestamp = SimulationTimestamp = std::chrono::system_clock::now();
+			RealtimeTimestamp = std::chrono::system_clock::now();
 		}
 	}
 }
@@ -176,6 +175,10 @@ void FSodaApp::SetSynchronousMode(bool bEnable, double DeltaSeconds)
 
 	if (IsValid(GameWorld))
 	{
+		// The vehicles pick up the new timeline when they are respawned
+		GameWorld->GetSubsystem<USodaSimulationClock>()->Reset(bEnable);
+		SimulationTimestamp = GameWorld->GetSubsystem<USodaSimulationClock>()->GetSimulationTimestamp();
+
 		TArray<AActor*> FoundVehicles;
 		UGameplayStatics::GetAllActorsOfClass(GameWorld, ASodaVehicle::StaticClass(), FoundVehicles);
 
@@ -0,0 +1,591 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/SodaBatchRunner.h"
+#include "Soda/UnrealSoda.h"
+#include "Soda/SodaApp.h"
+#include "Soda/SodaSubsystem.h"
+#include "Soda/SodaStatics.h"
+#include "Soda/SodaSpectator.h"
+#include "Soda/LevelState.h"
+#include "Soda/FileDatabaseManager.h"
+#include "Soda/Vehicles/SodaVehicle.h"
+#include "Soda/ISodaVehicleComponent.h"
+#include "Kismet/GameplayStatics.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "PropertyPathHelpers.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Engine/Engine.h"
+#include "EngineUtils.h"
+
+USodaBatchRunner::FBatch USodaBatchRunner::Batch;
+
+bool USodaBatchRunner::IsBatchMode()
+{
+	FString FileName;
+	return FParse::Value(FCommandLine::Get(), TEXT("SodaBatch="), FileName);
+}
+
+bool USodaBatchRunner::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return IsBatchMode() && Super::ShouldCreateSubsystem(Outer);
+}
+
+void USodaBatchRunner::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (InWorld.WorldType != EWorldType::Game && InWorld.WorldType != EWorldType::PIE)
+	{
+		return;
+	}
+
+	if (!Batch.bLoaded)
+	{
+		FString FileName;
+		FParse::Value(FCommandLine::Get(), TEXT("SodaBatch="), FileName);
+		Batch.bLoaded = true;
+		if (!LoadBatch(FileName))
+		{
+			UE_LOG(LogSoda, Error, TEXT("USodaBatchRunner::OnWorldBeginPlay(); Can't load the batch file \"%s\""), *FileName);
+			State = EState::Finished;
+			// No run is started yet, so nothing has to be stopped; the non-zero exit code fails the CI job
+			FPlatformMisc::RequestExitWithStatus(false, 1);
+			return;
+		}
+	}
+
+	if (USodaSubsystem* SodaSubsystem = USodaSubsystem::Get())
+	{
+		SodaSubsystem->OnScenarioStop.AddUniqueDynamic(this, &USodaBatchRunner::OnScenarioStop);
+	}
+
+	if (Batch.bSlotPreloaded)
+	{
+		// The level state is already loaded from the slot of the current run by the level reload
+		Batch.bSlotPreloaded = false;
+		State = EState::Restore;
+	}
+	else
+	{
+		State = EState::StartNextRun;
+	}
+
+	bBegunPlay = true;
+}
+
+void USodaBatchRunner::Deinitialize()
+{
+	FCoreUObjectDelegates::GetPostGarbageCollect().RemoveAll(this);
+
+	if (ASodaVehicle* Vehicle = EgoVehicle.Get())
+	{
+		Vehicle->OnActorHit.RemoveDynamic(this, &USodaBatchRunner::OnVehicleHit);
+	}
+
+	if (USodaSubsystem* SodaSubsystem = USodaSubsystem::Get())
+	{
+		SodaSubsystem->OnScenarioStop.RemoveDynamic(this, &USodaBatchRunner::OnScenarioStop);
+	}
+
+	bBegunPlay = false;
+
+	Super::Deinitialize();
+}
+
+TStatId USodaBatchRunner::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USodaBatchRunner, STATGROUP_Tickables);
+}
+
+void USodaBatchRunner::Tick(float DeltaTime)
+{
+	switch (State)
+	{
+	case EState::StartNextRun:
+		StartNextRun();
+		break;
+
+	case EState::Restore:
+		RestoreLevel();
+		break;
+
+	case EState::Running:
+		SimTime += DeltaTime;
+		UpdateKPI(DeltaTime);
+		if (SimTime >= Batch.Runs[Batch.CurrentRun].Duration)
+		{
+			EndRun(TEXT("Timeout"));
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+static const TCHAR* ResultsHeader = TEXT("Index,Slot,Label,Params,StopReason,SimTime,LapTime,Collisions,MinTTC\n");
+
+bool USodaBatchRunner::LoadBatch(const FString& FileName)
+{
+	FString JsonString;
+	if (!FFileHelper::LoadFileToString(JsonString, *FileName))
+	{
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> JsonObject;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JsonString);
+	if (!FJsonSerializer::Deserialize(Reader, JsonObject) || !JsonObject.IsValid())
+	{
+		return false;
+	}
+
+	int32 ShardIndex = 0;
+	int32 ShardNum = 1;
+	FString Shard;
+	if (FParse::Value(FCommandLine::Get(), TEXT("SodaBatchShard="), Shard))
+	{
+		FString Index, Num;
+		if (Shard.Split(TEXT("/"), &Index, &Num))
+		{
+			ShardIndex = FCString::Atoi(*Index);
+			ShardNum = FMath::Max(FCString::Atoi(*Num), 1);
+		}
+	}
+
+	Batch.bQuit = true;
+	JsonObject->TryGetBoolField(TEXT("Quit"), Batch.bQuit);
+
+	if (!JsonObject->TryGetStringField(TEXT("Results"), Batch.ResultsFile) || Batch.ResultsFile.IsEmpty())
+	{
+		Batch.ResultsFile = FPaths::ProjectSavedDir() / TEXT("Batch") / TEXT("Results.csv");
+	}
+	else if (FPaths::IsRelative(Batch.ResultsFile))
+	{
+		Batch.ResultsFile = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), Batch.ResultsFile);
+	}
+	if (ShardNum > 1)
+	{
+		// Every process writes its own file
+		Batch.ResultsFile = FPaths::GetPath(Batch.ResultsFile) / FString::Printf(TEXT("%s.%d.%s"),
+			*FPaths::GetBaseFilename(Batch.ResultsFile), ShardIndex, *FPaths::GetExtension(Batch.ResultsFile));
+	}
+
+	const TArray<TSharedPtr<FJsonValue>>* JsonRuns;
+	if (!JsonObject->TryGetArrayField(TEXT("Runs"), JsonRuns))
+	{
+		return false;
+	}
+
+	int32 RunIndex = 0;
+	for (const TSharedPtr<FJsonValue>& JsonRunValue : *JsonRuns)
+	{
+		const TSharedPtr<FJsonObject>* JsonRun;
+		if (!JsonRunValue->TryGetObject(JsonRun))
+		{
+			UE_LOG(LogSoda, Error, TEXT("USodaBatchRunner::LoadBatch(); The run must be an object"));
+			continue;
+		}
+
+		FRun Run;
+		if (!ResolveSlot((*JsonRun)->GetStringField(TEXT("Slot")), Run.Slot, Run.SlotLabel))
+		{
+			UE_LOG(LogSoda, Error, TEXT("USodaBatchRunner::LoadBatch(); Can't find the slot \"%s\""), *(*JsonRun)->GetStringField(TEXT("Slot")));
+			continue;
+		}
+
+		double Duration = Run.Duration;
+		(*JsonRun)->TryGetNumberField(TEXT("Duration"), Duration);
+		Run.Duration = Duration;
+
+		// Cartesian product of the sweep values
+		TArray<TArray<TPair<FString, FString>>> Combinations;
+		Combinations.AddDefaulted();
+		const TSharedPtr<FJsonObject>* JsonSweep;
+		if ((*JsonRun)->TryGetObjectField(TEXT("Sweep"), JsonSweep))
+		{
+			for (const auto& [Key, Values] : (*JsonSweep)->Values)
+			{
+				const TArray<TSharedPtr<FJsonValue>>* JsonValues;
+				if (!Values->TryGetArray(JsonValues) || JsonValues->Num() == 0)
+				{
+					UE_LOG(LogSoda, Error, TEXT("USodaBatchRunner::LoadBatch(); The sweep \"%s\" must be a non-empty array"), *Key);
+					continue;
+				}
+
+				TArray<TArray<TPair<FString, FString>>> Expanded;
+				for (const TArray<TPair<FString, FString>>& Combination : Combinations)
+				{
+					for (const TSharedPtr<FJsonValue>& Value : *JsonValues)
+					{
+						TArray<TPair<FString, FString>>& New = Expanded.Add_GetRef(Combination);
+						New.Emplace(Key, Value->AsString());
+					}
+				}
+				Combinations = MoveTemp(Expanded);
+			}
+		}
+
+		for (TArray<TPair<FString, FString>>& Combination : Combinations)
+		{
+			if (RunIndex++ % ShardNum != ShardIndex)
+			{
+				continue;
+			}
+			FRun& NewRun = Batch.Runs.Add_GetRef(Run);
+			NewRun.Index = RunIndex - 1;
+			NewRun.Params = MoveTemp(Combination);
+		}
+	}
+
+	// The results of the previous batch are overwritten, WriteResult() appends the runs of this batch
+	if (!FFileHelper::SaveStringToFile(ResultsHeader, *Batch.ResultsFile, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+	{
+		UE_LOG(LogSoda, Error, TEXT("USodaBatchRunner::LoadBatch(); Can't write \"%s\""), *Batch.ResultsFile);
+		return false;
+	}
+
+	UE_LOG(LogSoda, Log, TEXT("USodaBatchRunner::LoadBatch(); %d runs of %d are loaded, shard %d/%d"), Batch.Runs.Num(), RunIndex, ShardIndex, ShardNum);
+
+	return true;
+}
+
+bool USodaBatchRunner::ResolveSlot(const FString& SlotName, FGuid& OutGuid, FString& OutLabel)
+{
+	auto& Database = SodaApp.GetFileDatabaseManager();
+
+	soda::FFileDatabaseSlotInfo SlotInfo;
+	if (FGuid::Parse(SlotName, OutGuid) && Database.GetSlot(OutGuid, SlotInfo))
+	{
+		OutLabel = SlotInfo.Label;
+		return true;
+	}
+
+	for (auto& [Guid, Info] : Database.GetSlots(soda::EFileSlotType::Level))
+	{
+		if (Info->Label == SlotName)
+		{
+			OutGuid = Guid;
+			OutLabel = Info->Label;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void USodaBatchRunner::StartNextRun()
+{
+	USodaSubsystem* SodaSubsystem = USodaSubsystem::Get();
+	ALevelState* LevelState = ALevelState::Get();
+	if (!SodaSubsystem || !LevelState)
+	{
+		return;
+	}
+
+	++Batch.CurrentRun;
+	if (Batch.CurrentRun >= Batch.Runs.Num())
+	{
+		UE_LOG(LogSoda, Log, TEXT("USodaBatchRunner::StartNextRun(); The batch is finished, results: \"%s\""), *Batch.ResultsFile);
+		State = EState::Finished;
+		if (Batch.bQuit)
+		{
+			SodaSubsystem->RequestQuit(true);
+		}
+		return;
+	}
+
+	const FRun& Run = Batch.Runs[Batch.CurrentRun];
+	UE_LOG(LogSoda, Log, TEXT("USodaBatchRunner::StartNextRun(); Run %d/%d, slot \"%s\""), Batch.CurrentRun + 1, Batch.Runs.Num(), *Run.SlotLabel);
+
+	soda::FFileDatabaseSlotInfo SlotInfo;
+	PendingSaveGame = ALevelState::LoadSaveGameFromSlot(Run.Slot, SlotInfo);
+	if (!PendingSaveGame)
+	{
+		WriteResult(TEXT("SlotLoadFailed"));
+		return;
+	}
+
+	if (PendingSaveGame->LevelName != UGameplayStatics::GetCurrentLevelName(this, true))
+	{
+		// The run is continued by the runner of the new world
+		PendingSaveGame = nullptr;
+		Batch.bSlotPreloaded = true;
+		State = EState::Finished;
+		if (!SodaSubsystem->LoadLevelFromSlot(Run.Slot))
+		{
+			Batch.bSlotPreloaded = false;
+			WriteResult(TEXT("SlotLoadFailed"));
+			State = EState::StartNextRun;
+		}
+		return;
+	}
+
+	// Same level, restore the actors without the level reload
+	LevelState->ClearLevel();
+	State = EState::WaitGarbageCollect;
+	FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &USodaBatchRunner::OnPostGarbageCollect);
+	GEngine->ForceGarbageCollection(true);
+}
+
+void USodaBatchRunner::OnPostGarbageCollect()
+{
+	FCoreUObjectDelegates::GetPostGarbageCollect().RemoveAll(this);
+	State = EState::Restore;
+}
+
+void USodaBatchRunner::RestoreLevel()
+{
+	ALevelState* LevelState = ALevelState::Get();
+	if (!LevelState)
+	{
+		return;
+	}
+
+	if (PendingSaveGame)
+	{
+		PendingSaveGame->LevelDataRecord.DeserializeActor(LevelState, false);
+		LevelState->SpawnSavedActors();
+		PendingSaveGame = nullptr;
+	}
+
+	for (const auto& [Key, Value] : Batch.Runs[Batch.CurrentRun].Params)
+	{
+		if (!ApplyParam(Key, Value))
+		{
+			UE_LOG(LogSoda, Error, TEXT("USodaBatchRunner::RestoreLevel(); Can't apply \"%s\" = \"%s\""), *Key, *Value);
+		}
+	}
+
+	BeginRun();
+}
+
+bool USodaBatchRunner::ApplyParam(const FString& Key, const FString& Value)
+{
+	FString Target, PropertyPath;
+	if (!Key.Split(TEXT(":"), &Target, &PropertyPath))
+	{
+		return false;
+	}
+
+	FString ActorName, ComponentName;
+	if (!Target.Split(TEXT("/"), &ActorName, &ComponentName))
+	{
+		ActorName = Target;
+	}
+
+	AActor* Actor = nullptr;
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		if (It->GetName() == ActorName)
+		{
+			Actor = *It;
+			break;
+		}
+	}
+	if (!Actor)
+	{
+		return false;
+	}
+
+	UObject* Object = Actor;
+	if (!ComponentName.IsEmpty())
+	{
+		Object = nullptr;
+		for (UActorComponent* Component : Actor->GetComponents())
+		{
+			if (Component && Component->GetName() == ComponentName)
+			{
+				Object = Component;
+				break;
+			}
+		}
+		if (!Object)
+		{
+			return false;
+		}
+	}
+
+	if (!PropertyPathHelpers::SetPropertyValueFromString(Object, PropertyPath, Value))
+	{
+		return false;
+	}
+
+	// Reactivate the vehicle component so the new value is taken into account
+	if (ISodaVehicleComponent* VehicleComponent = Cast<ISodaVehicleComponent>(Object))
+	{
+		if (VehicleComponent->IsVehicleComponentActiveted())
+		{
+			VehicleComponent->DeactivateVehicleComponent();
+			VehicleComponent->ActivateVehicleComponent();
+		}
+	}
+
+	return true;
+}
+
+void USodaBatchRunner::BeginRun()
+{
+	USodaSubsystem* SodaSubsystem = USodaSubsystem::Get();
+	check(SodaSubsystem);
+
+	SimTime = 0;
+	LapTime = -1;
+	Collisions = 0;
+	MinTTC = MAX_FLT;
+	LastHitActor.Reset();
+	LastHitTime = -1;
+	ActorRadiuses.Reset();
+
+	EgoVehicle = SodaSubsystem->GetActiveVehicle();
+	if (ASodaVehicle* Vehicle = EgoVehicle.Get())
+	{
+		Vehicle->OnActorHit.AddUniqueDynamic(this, &USodaBatchRunner::OnVehicleHit);
+		EgoRadius = USodaStatics::CalculateActorExtent(Vehicle).GetExtent().X;
+	}
+	else
+	{
+		UE_LOG(LogSoda, Warning, TEXT("USodaBatchRunner::BeginRun(); No active vehicle, only the lap time is measured"));
+	}
+
+	State = EState::Running;
+
+	if (!SodaSubsystem->ScenarioPlay())
+	{
+		EndRun(TEXT("ScenarioPlayFailed"));
+	}
+}
+
+void USodaBatchRunner::EndRun(const FString& Reason)
+{
+	if (State != EState::Running)
+	{
+		return;
+	}
+
+	// Set before ScenarioStop(), which calls OnScenarioStop() back
+	State = EState::StartNextRun;
+
+	if (ASodaVehicle* Vehicle = EgoVehicle.Get())
+	{
+		Vehicle->OnActorHit.RemoveDynamic(this, &USodaBatchRunner::OnVehicleHit);
+	}
+	EgoVehicle.Reset();
+
+	WriteResult(Reason);
+
+	if (USodaSubsystem* SodaSubsystem = USodaSubsystem::Get())
+	{
+		if (SodaSubsystem->IsScenarioRunning())
+		{
+			SodaSubsystem->ScenarioStop(EScenarioStopReason::UserRequest, EScenarioStopMode::StopSiganalOnly);
+		}
+	}
+}
+
+void USodaBatchRunner::UpdateKPI(float DeltaTime)
+{
+	const ASodaVehicle* Vehicle = EgoVehicle.Get();
+	if (!Vehicle)
+	{
+		return;
+	}
+
+	const USodaSubsystem* SodaSubsystem = USodaSubsystem::Get();
+	const AActor* Spectator = SodaSubsystem ? SodaSubsystem->GetSpectatorActor() : nullptr;
+	const FVector EgoLocation = Vehicle->GetActorLocation();
+	const FVector EgoVelocity = Vehicle->GetVelocity();
+
+	for (TActorIterator<APawn> It(GetWorld()); It; ++It)
+	{
+		APawn* Pawn = *It;
+		if (Pawn == Vehicle || Pawn == Spectator)
+		{
+			continue;
+		}
+
+		const FVector RelLocation = Pawn->GetActorLocation() - EgoLocation;
+		const FVector RelVelocity = Pawn->GetVelocity() - EgoVelocity;
+		const float Distance = RelLocation.Size();
+		const float ClosingSpeed = -(RelLocation | RelVelocity) / FMath::Max(Distance, KINDA_SMALL_NUMBER);
+		if (ClosingSpeed <= KINDA_SMALL_NUMBER)
+		{
+			continue;
+		}
+
+		// Both actors are approximated by the circles of the half length
+		float& Radius = ActorRadiuses.FindOrAdd(Pawn, -1);
+		if (Radius < 0)
+		{
+			Radius = USodaStatics::CalculateActorExtent(Pawn).GetExtent().X;
+		}
+
+		const float Gap = FMath::Max(Distance - Radius - EgoRadius, 0.f);
+		MinTTC = FMath::Min(MinTTC, Gap / ClosingSpeed);
+	}
+}
+
+void USodaBatchRunner::WriteResult(const FString& Reason)
+{
+	const FRun& Run = Batch.Runs[Batch.CurrentRun];
+
+	FString Params;
+	for (const auto& [Key, Value] : Run.Params)
+	{
+		if (!Params.IsEmpty())
+		{
+			Params += TEXT(";");
+		}
+		Params += Key + TEXT("=") + Value;
+	}
+
+	const FString Line = FString::Printf(TEXT("%d,%s,\"%s\",\"%s\",%s,%.3f,%.3f,%d,%.3f\n"),
+		Run.Index,
+		*Run.Slot.ToString(),
+		*Run.SlotLabel.Replace(TEXT("\""), TEXT("\"\"")),
+		*Params.Replace(TEXT("\""), TEXT("\"\"")),
+		*Reason,
+		SimTime,
+		LapTime,
+		Collisions,
+		MinTTC == MAX_FLT ? -1.f : MinTTC);
+
+	if (!FFileHelper::SaveStringToFile(Line, *Batch.ResultsFile, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append))
+	{
+		UE_LOG(LogSoda, Error, TEXT("USodaBatchRunner::WriteResult(); Can't write \"%s\""), *Batch.ResultsFile);
+	}
+}
+
+void USodaBatchRunner::OnScenarioStop(EScenarioStopReason Reason)
+{
+	if (State != EState::Running)
+	{
+		return;
+	}
+
+	if (Reason == EScenarioStopReason::ScenarioStopTrigger)
+	{
+		LapTime = SimTime;
+	}
+	EndRun(StaticEnum<EScenarioStopReason>()->GetNameStringByValue(int64(Reason)));
+}
+
+void USodaBatchRunner::OnVehicleHit(AActor* SelfActor, AActor* OtherActor, FVector NormalImpulse, const FHitResult& Hit)
+{
+	// Ignore the contacts with the ground
+	if (Hit.ImpactNormal.Z > 0.7)
+	{
+		return;
+	}
+
+	// Debounce the continuous contact with the same actor
+	const bool bSameContact = LastHitActor.Get() == OtherActor && SimTime - LastHitTime < 1.0;
+	LastHitActor = OtherActor;
+	LastHitTime = SimTime;
+	if (!bSameContact)
+	{
+		++Collisions;
+	}
+}
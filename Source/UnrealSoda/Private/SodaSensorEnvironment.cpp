@@ -0,0 +1,44 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/SodaSensorEnvironment.h"
+#include "Engine/World.h"
+
+void USodaSensorEnvironment::SetWeather(const soda::FSensorWeather& Weather)
+{
+	check(IsInGameThread());
+
+	Sequence.Store(Sequence.Load() + 1);
+	FPlatformMisc::MemoryBarrier();
+	Snapshot = Weather;
+	FPlatformMisc::MemoryBarrier();
+	Sequence.Store(Sequence.Load() + 1);
+}
+
+soda::FSensorWeather USodaSensorEnvironment::GetWeather() const
+{
+	while (true)
+	{
+		const uint32 Begin = Sequence.Load();
+		if (Begin & 1)
+		{
+			FPlatformProcess::Yield();
+			continue;
+		}
+
+		FPlatformMisc::MemoryBarrier();
+		const soda::FSensorWeather Weather = Snapshot;
+		FPlatformMisc::MemoryBarrier();
+
+		if (Sequence.Load() == Begin)
+		{
+			return Weather;
+		}
+	}
+}
+
+soda::FSensorWeather USodaSensorEnvironment::GetWeather(const UObject* Object)
+{
+	const UWorld* World = Object ? Object->GetWorld() : nullptr;
+	const USodaSensorEnvironment* Environment = World ? World->GetSubsystem<USodaSensorEnvironment>() : nullptr;
+	return Environment ? Environment->GetWeather() : soda::FSensorWeather{};
+}
@@ -0,0 +1,319 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/SodaSensorScheduler.h"
+#include "Soda/UnrealSoda.h"
+#include "Soda/SodaApp.h"
+#include "Soda/Misc/Time.h"
+#include "Soda/VehicleComponents/VehicleSensorComponent.h"
+#include "Engine/World.h"
+
+DECLARE_STATS_GROUP(TEXT("SodaSensorScheduler"), STATGROUP_SodaSensorScheduler, STATGROUP_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Plan Frame"), STAT_SensorSchedulerPlanFrame, STATGROUP_SodaSensorScheduler);
+DECLARE_CYCLE_STAT(TEXT("Rebalance"), STAT_SensorSchedulerRebalance, STATGROUP_SodaSensorScheduler);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Due Sensors"), STAT_SensorSchedulerDue, STATGROUP_SodaSensorScheduler);
+
+static constexpr int64 NsPerSecond = 1000000000;
+
+/** Upper limit of the frames per second the load is balanced for */
+static constexpr int MaxBinsNum = 240;
+
+void USodaSensorScheduler::Deinitialize()
+{
+	Report(true);
+	Entries.Empty();
+	Super::Deinitialize();
+}
+
+void USodaSensorScheduler::Register(USensorComponent* Sensor)
+{
+	check(Sensor);
+
+	FEntry* Entry = FindEntry(Sensor);
+	if (!Entry)
+	{
+		Entry = &Entries.AddDefaulted_GetRef();
+		Entry->Sensor = Sensor;
+	}
+
+	Entry->Setup = Sensor->Schedule;
+	Entry->Period = FMath::Max(int64(double(NsPerSecond) / FMath::Clamp(Entry->Setup.Rate, 1.f, 1000.f) + 0.5), int64(1));
+	Entry->bDue = false;
+	Entry->Stats = FSensorScheduleStats{};
+	Entry->ReportedMisses = 0;
+	Entry->ReportedDrops = 0;
+	Entry->DroppedFramesBase = Sensor->GetDroppedFrames();
+
+	bNeedRebalance = true;
+}
+
+void USodaSensorScheduler::Unregister(USensorComponent* Sensor)
+{
+	for (int i = 0; i < Entries.Num(); ++i)
+	{
+		if (Entries[i].Sensor.Get() == Sensor)
+		{
+			const FSensorScheduleStats& Stats = Entries[i].Stats;
+			UE_LOG(LogSoda, Log, TEXT("USodaSensorScheduler::Unregister(); \"%s\": %lld captures, drift mean %.2f ms, max %.2f ms, %lld missed triggers, %lld dropped frames"),
+				*Sensor->GetName(), Stats.Captures, Stats.DriftMean, Stats.DriftMax, Stats.MissedTriggers, Stats.DroppedFrames);
+			Entries.RemoveAt(i);
+			bNeedRebalance = true;
+			return;
+		}
+	}
+}
+
+bool USodaSensorScheduler::IsDue(const USensorComponent* Sensor)
+{
+	check(IsInGameThread());
+
+	if (PlannedFrame != SodaApp.GetFrameIndex())
+	{
+		PlanFrame();
+	}
+
+	const FEntry* Entry = FindEntry(Sensor);
+	return !Entry || Entry->bDue;
+}
+
+const FSensorScheduleStats* USodaSensorScheduler::GetStats(const USensorComponent* Sensor) const
+{
+	const FEntry* Entry = Entries.FindByPredicate([Sensor](const FEntry& It) { return It.Sensor.Get() == Sensor; });
+	return Entry ? &Entry->Stats : nullptr;
+}
+
+USodaSensorScheduler::FEntry* USodaSensorScheduler::FindEntry(const USensorComponent* Sensor)
+{
+	return Entries.FindByPredicate([Sensor](const FEntry& It) { return It.Sensor.Get() == Sensor; });
+}
+
+int64 USodaSensorScheduler::CountTriggers(const FEntry& Entry, int64 Time)
+{
+	const int64 Second = Time / NsPerSecond;
+	const int64 InSecond = Time % NsPerSecond;
+	const int64 Count = InSecond < Entry.Phase ? 0 : FMath::Min((InSecond - Entry.Phase) / Entry.Period + 1, Entry.TriggersPerSecond);
+	return Second * Entry.TriggersPerSecond + Count;
+}
+
+int64 USodaSensorScheduler::GetLastTrigger(const FEntry& Entry, int64 Time)
+{
+	const int64 Second = Time / NsPerSecond;
+	const int64 InSecond = Time % NsPerSecond;
+	if (InSecond < Entry.Phase)
+	{
+		return (Second - 1) * NsPerSecond + Entry.Phase + (Entry.TriggersPerSecond - 1) * Entry.Period;
+	}
+	const int64 Index = FMath::Min((InSecond - Entry.Phase) / Entry.Period, Entry.TriggersPerSecond - 1);
+	return Second * NsPerSecond + Entry.Phase + Index * Entry.Period;
+}
+
+void USodaSensorScheduler::PlanFrame()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SensorSchedulerPlanFrame);
+
+	PlannedFrame = SodaApp.GetFrameIndex();
+	const int64 Now = soda::RawTimestamp<std::chrono::nanoseconds>(SodaApp.GetSimulationTimestamp());
+
+	if (PrevFrameTime == 0 || Now < PrevFrameTime)
+	{
+		// The first frame or the simulation clock is restarted
+		PrevFrameTime = Now - int64(double(GetWorld()->GetDeltaSeconds()) * NsPerSecond);
+		NextReportTime = Now + int64(double(ReportPeriod) * NsPerSecond);
+	}
+
+	AverageFrameTime = FMath::Lerp(AverageFrameTime, FMath::Max(float(double(Now - PrevFrameTime) / NsPerSecond), KINDA_SMALL_NUMBER), 0.05f);
+
+	if (Entries.RemoveAll([](const FEntry& Entry) { return !Entry.Sensor.IsValid(); }))
+	{
+		bNeedRebalance = true;
+	}
+
+	// Hysteresis, so the phases aren't reassigned by the small frame rate jitter
+	const int NewBinsNum = FMath::Clamp(FMath::RoundToInt(1.f / AverageFrameTime), 1, MaxBinsNum);
+	if (FMath::Abs(NewBinsNum - BinsNum) > BinsNum / 10)
+	{
+		bNeedRebalance = true;
+	}
+
+	if (bNeedRebalance)
+	{
+		Rebalance();
+	}
+
+	int DueNum = 0;
+	for (auto& Entry : Entries)
+	{
+		const int64 Triggers = CountTriggers(Entry, Now) - CountTriggers(Entry, PrevFrameTime);
+		Entry.bDue = Triggers > 0;
+
+		FSensorScheduleStats& Stats = Entry.Stats;
+		if (Entry.bDue)
+		{
+			++DueNum;
+			++Stats.Captures;
+			Stats.MissedTriggers += Triggers - 1;
+			const float Drift = float(double(Now - GetLastTrigger(Entry, Now)) * 1e-6);
+			Stats.DriftMean += (Drift - Stats.DriftMean) / Stats.Captures;
+			Stats.DriftMax = FMath::Max(Stats.DriftMax, Drift);
+		}
+		Stats.DroppedFrames = Entry.Sensor->GetDroppedFrames() - Entry.DroppedFramesBase;
+	}
+	SET_DWORD_STAT(STAT_SensorSchedulerDue, DueNum);
+
+	PrevFrameTime = Now;
+
+	if (Now >= NextReportTime)
+	{
+		Report(false);
+		NextReportTime = Now + int64(double(ReportPeriod) * NsPerSecond);
+	}
+}
+
+void USodaSensorScheduler::Rebalance()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SensorSchedulerRebalance);
+
+	bNeedRebalance = false;
+	BinsNum = FMath::Clamp(FMath::RoundToInt(1.f / AverageFrameTime), 1, MaxBinsNum);
+
+	// Sensors of one sync group are placed together
+	struct FUnit
+	{
+		TArray<int32, TInlineAllocator<4>> Members;
+		float Cost = 0;
+		int64 FixedPhase = -1;
+		int64 MinPeriod = NsPerSecond;
+		FString Name;
+	};
+
+	TArray<FUnit> Units;
+	TMap<FName, int32> Groups;
+	for (int32 i = 0; i < Entries.Num(); ++i)
+	{
+		const FEntry& Entry = Entries[i];
+		int32 UnitIndex;
+		if (Entry.Setup.SyncGroup.IsNone())
+		{
+			UnitIndex = Units.AddDefaulted();
+		}
+		else if (const int32* Found = Groups.Find(Entry.Setup.SyncGroup))
+		{
+			UnitIndex = *Found;
+		}
+		else
+		{
+			UnitIndex = Groups.Add(Entry.Setup.SyncGroup, Units.AddDefaulted());
+		}
+
+		FUnit& Unit = Units[UnitIndex];
+		Unit.Members.Add(i);
+		Unit.Cost += FMath::Max(Entry.Setup.Cost, 0.f);
+		Unit.MinPeriod = FMath::Min(Unit.MinPeriod, Entry.Period);
+		if (Unit.FixedPhase < 0 && Entry.Setup.Phase >= 0)
+		{
+			Unit.FixedPhase = int64(double(Entry.Setup.Phase) * NsPerSecond);
+		}
+		if (Unit.Name.IsEmpty())
+		{
+			Unit.Name = Entry.Sensor->GetPathName();
+		}
+	}
+
+	// The fixed phases first, then the heaviest sensors get the emptiest frames; the names make the order reproducible
+	Units.Sort([](const FUnit& A, const FUnit& B)
+	{
+		if ((A.FixedPhase >= 0) != (B.FixedPhase >= 0)) return A.FixedPhase >= 0;
+		if (A.Cost != B.Cost) return A.Cost > B.Cost;
+		return A.Name < B.Name;
+	});
+
+	TArray<float> Load;
+	Load.SetNumZeroed(BinsNum);
+	TArray<float> CandidateLoad;
+
+	auto AddLoad = [this](const FEntry& Entry, int64 Phase, TArray<float>& InOutLoad)
+	{
+		for (int64 Trigger = Phase % Entry.Period; Trigger < NsPerSecond; Trigger += Entry.Period)
+		{
+			InOutLoad[int(Trigger * BinsNum / NsPerSecond)] += FMath::Max(Entry.Setup.Cost, 0.f);
+		}
+	};
+
+	const int64 BinTime = NsPerSecond / BinsNum;
+	for (const FUnit& Unit : Units)
+	{
+		int64 Phase = Unit.FixedPhase;
+		if (Phase < 0)
+		{
+			// Minimize the peak frame load, then the sum of squares to keep the sensors apart below the peak
+			Phase = 0;
+			float BestPeak = TNumericLimits<float>::Max();
+			float BestSquares = TNumericLimits<float>::Max();
+			for (int64 Candidate = 0; Candidate < Unit.MinPeriod; Candidate += BinTime)
+			{
+				CandidateLoad = Load;
+				for (int32 Member : Unit.Members)
+				{
+					AddLoad(Entries[Member], Candidate, CandidateLoad);
+				}
+
+				float Peak = 0;
+				float Squares = 0;
+				for (float It : CandidateLoad)
+				{
+					Peak = FMath::Max(Peak, It);
+					Squares += It * It;
+				}
+
+				if (Peak < BestPeak || (Peak == BestPeak && Squares < BestSquares))
+				{
+					BestPeak = Peak;
+					BestSquares = Squares;
+					Phase = Candidate;
+				}
+			}
+		}
+
+		for (int32 Member : Unit.Members)
+		{
+			FEntry& Entry = Entries[Member];
+			Entry.Phase = Phase % Entry.Period;
+			Entry.TriggersPerSecond = (NsPerSecond - 1 - Entry.Phase) / Entry.Period + 1;
+			Entry.Stats.Phase = float(double(Entry.Phase) / NsPerSecond);
+			AddLoad(Entry, Entry.Phase, Load);
+		}
+	}
+
+	float Peak = 0;
+	for (float It : Load)
+	{
+		Peak = FMath::Max(Peak, It);
+	}
+	UE_LOG(LogSoda, Log, TEXT("USodaSensorScheduler::Rebalance(); %d sensors, %d frames per second, peak frame cost %.2f ms"), Entries.Num(), BinsNum, Peak);
+}
+
+void USodaSensorScheduler::Report(bool bFinal)
+{
+	for (auto& Entry : Entries)
+	{
+		const FSensorScheduleStats& Stats = Entry.Stats;
+		const bool bChanged = Stats.MissedTriggers != Entry.ReportedMisses || Stats.DroppedFrames != Entry.ReportedDrops;
+		if (!Entry.Sensor.IsValid() || (!bFinal && !bChanged))
+		{
+			continue;
+		}
+
+		if (bChanged)
+		{
+			UE_LOG(LogSoda, Warning, TEXT("USodaSensorScheduler::Report(); \"%s\": %lld captures, drift mean %.2f ms, max %.2f ms, %lld missed triggers, %lld dropped frames"),
+				*Entry.Sensor->GetName(), Stats.Captures, Stats.DriftMean, Stats.DriftMax, Stats.MissedTriggers, Stats.DroppedFrames);
+		}
+		else
+		{
+			UE_LOG(LogSoda, Log, TEXT("USodaSensorScheduler::Report(); \"%s\": %lld captures, drift mean %.2f ms, max %.2f ms"),
+				*Entry.Sensor->GetName(), Stats.Captures, Stats.DriftMean, Stats.DriftMax);
+		}
+
+		Entry.ReportedMisses = Stats.MissedTriggers;
+		Entry.ReportedDrops = Stats.DroppedFrames;
+	}
+}
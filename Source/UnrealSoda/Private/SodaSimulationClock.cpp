@@ -0,0 +1,180 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/SodaSimulationClock.h"
+#include "Soda/UnrealSoda.h"
+#include "Soda/SodaApp.h"
+#include "GameFramework/WorldSettings.h"
+#include "Kismet/GameplayStatics.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "PBDRigidsSolver.h"
+#include "Misc/CommandLine.h"
+
+DECLARE_STATS_GROUP(TEXT("SodaClock"), STATGROUP_SodaClock, STATGROUP_Advanced);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Real time factor"), STAT_SodaClockRealTimeFactor, STATGROUP_SodaClock);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Simulated seconds"), STAT_SodaClockSimulatedSeconds, STATGROUP_SodaClock);
+
+/** [s] If the synchronous mode falls behind the target RTF more than this, the lost time isn't caught up */
+static constexpr double MaxPacingLag = 0.25;
+
+void USodaSimulationClock::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	float CmdRealTimeFactor;
+	if (FParse::Value(FCommandLine::Get(), TEXT("SodaRTF="), CmdRealTimeFactor))
+	{
+		RealTimeFactor = FMath::Max(CmdRealTimeFactor, 0.f);
+	}
+
+	float CmdPhysicsHz;
+	if (FParse::Value(FCommandLine::Get(), TEXT("SodaPhysicsHz="), CmdPhysicsHz) && CmdPhysicsHz > 0)
+	{
+		PhysicsStep = 1.f / CmdPhysicsHz;
+	}
+}
+
+void USodaSimulationClock::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (InWorld.WorldType != EWorldType::Game && InWorld.WorldType != EWorldType::PIE)
+	{
+		return;
+	}
+
+	Reset(SodaApp.IsSynchronousMode());
+	ApplyPhysicsStep();
+}
+
+void USodaSimulationClock::Deinitialize()
+{
+	if (SavedMaxPhysicsDeltaTime >= 0)
+	{
+		UPhysicsSettings::Get()->MaxPhysicsDeltaTime = SavedMaxPhysicsDeltaTime;
+		SavedMaxPhysicsDeltaTime = -1;
+	}
+
+	Super::Deinitialize();
+}
+
+void USodaSimulationClock::SetRealTimeFactor(float InRealTimeFactor)
+{
+	RealTimeFactor = FMath::Max(InRealTimeFactor, 0.f);
+	PacingWallSeconds = FPlatformTime::Seconds();
+	PacingSimulatedSeconds = SimulatedSeconds;
+
+	if (GetWorld()->HasBegunPlay())
+	{
+		ApplyRealTimeFactor();
+	}
+}
+
+void USodaSimulationClock::SetPhysicsStep(float InPhysicsStep)
+{
+	PhysicsStep = FMath::Max(InPhysicsStep, 0.f);
+
+	if (GetWorld()->HasBegunPlay())
+	{
+		ApplyPhysicsStep();
+	}
+}
+
+void USodaSimulationClock::ApplyRealTimeFactor()
+{
+	// The synchronous mode has the fixed frame delta, the RTF is applied by the pacing in AdvanceFrame()
+	const float Dilation = (SodaApp.IsSynchronousMode() || RealTimeFactor <= 0) ? 1.f : RealTimeFactor;
+	UGameplayStatics::SetGlobalTimeDilation(GetWorld(), Dilation);
+
+	// Let the physics advance by the whole dilated frame, otherwise the vehicles fall behind the clock.
+	// The settings object is shared by all worlds and the editor, so the project value is restored in Deinitialize()
+	UPhysicsSettings* PhysicsSettings = UPhysicsSettings::Get();
+	if (SavedMaxPhysicsDeltaTime < 0)
+	{
+		SavedMaxPhysicsDeltaTime = PhysicsSettings->MaxPhysicsDeltaTime;
+	}
+	PhysicsSettings->MaxPhysicsDeltaTime = SavedMaxPhysicsDeltaTime * FMath::Max(Dilation, 1.f);
+}
+
+void USodaSimulationClock::ApplyPhysicsStep()
+{
+	FPhysScene* PhysScene = GetWorld()->GetPhysicsScene();
+	Chaos::FPhysicsSolver* Solver = PhysScene ? PhysScene->GetSolver() : nullptr;
+	if (!Solver)
+	{
+		UE_LOG(LogSoda, Warning, TEXT("USodaSimulationClock::ApplyPhysicsStep(); The world has no physics solver"));
+		return;
+	}
+
+	if (PhysicsStep > 0)
+	{
+		Solver->EnableAsyncMode(PhysicsStep);
+	}
+	else if (!UPhysicsSettings::Get()->bTickPhysicsAsync)
+	{
+		Solver->DisableAsyncMode();
+	}
+	else
+	{
+		Solver->EnableAsyncMode(UPhysicsSettings::Get()->AsyncFixedTimeStepSize);
+	}
+}
+
+void USodaSimulationClock::Reset(bool bSynchronousMode)
+{
+	Epoch = bSynchronousMode ? TTimestamp{} : soda::Now();
+	SimulatedSeconds = 0;
+	MeasuredRealTimeFactor = 1;
+	LastWallSeconds = PacingWallSeconds = FPlatformTime::Seconds();
+	PacingSimulatedSeconds = 0;
+
+	ApplyRealTimeFactor();
+}
+
+void USodaSimulationClock::SetSimulatedSeconds(double InSimulatedSeconds)
+{
+	SimulatedSeconds = InSimulatedSeconds;
+	LastWallSeconds = PacingWallSeconds = FPlatformTime::Seconds();
+	PacingSimulatedSeconds = SimulatedSeconds;
+}
+
+TTimestamp USodaSimulationClock::ToTimestamp(double InSimulatedSeconds) const
+{
+	return soda::AddSeconds(Epoch, InSimulatedSeconds);
+}
+
+TTimestamp USodaSimulationClock::AdvanceFrame(float DeltaSeconds)
+{
+	// The same delta the world is going to be ticked with
+	AWorldSettings* WorldSettings = GetWorld()->GetWorldSettings();
+	const float SimulatedDelta = WorldSettings ? WorldSettings->FixupDeltaSeconds(DeltaSeconds * WorldSettings->GetEffectiveTimeDilation(), DeltaSeconds) : DeltaSeconds;
+	SimulatedSeconds += SimulatedDelta;
+
+	if (SodaApp.IsSynchronousMode() && RealTimeFactor > 0)
+	{
+		const double TargetWallSeconds = PacingWallSeconds + (SimulatedSeconds - PacingSimulatedSeconds) / RealTimeFactor;
+		const double WallSeconds = FPlatformTime::Seconds();
+		if (WallSeconds > TargetWallSeconds + MaxPacingLag)
+		{
+			PacingWallSeconds = WallSeconds;
+			PacingSimulatedSeconds = SimulatedSeconds;
+		}
+		else if (WallSeconds < TargetWallSeconds)
+		{
+			FPlatformProcess::Sleep(float(TargetWallSeconds - WallSeconds));
+		}
+	}
+
+	const double WallSeconds = FPlatformTime::Seconds();
+	const double WallDelta = WallSeconds - LastWallSeconds;
+	LastWallSeconds = WallSeconds;
+	if (WallDelta > SMALL_NUMBER)
+	{
+		MeasuredRealTimeFactor = FMath::Lerp(MeasuredRealTimeFactor, float(SimulatedDelta / WallDelta), 0.05f);
+	}
+
+	SET_FLOAT_STAT(STAT_SodaClockRealTimeFactor, MeasuredRealTimeFactor);
+	SET_FLOAT_STAT(STAT_SodaClockSimulatedSeconds, SimulatedSeconds);
+
+	return GetSimulationTimestamp();
+}
@@ -448,12 +448,17 @@ bool USodaStatics::SavePathToFile(USplineComponent* SplineComponent, float Dista
 		else
 		{
 			OutFile << "Lon,Lat,Alt\n";
+			TArray<FVector> Points;
 			for (int i = 0; i < SplineLength / Distance; ++i)
 			{
-				FVector Pt = SplineComponent->GetLocationAtDistanceAlongSpline(i * Distance, ESplineCoordinateSpace::World);
-				double Lon, Lat, Alt;
-				LevelState->GetLLConverter().UE2LLA(Pt, Lon, Lat, Alt);
-				OutFile << Lon << "," << Lat << "," << Alt << "\n";
+				Points.Add(SplineComponent->GetLocationAtDistanceAlongSpline(i * Distance, ESplineCoordinateSpace::World));
+			}
+			TArray<FVector> LonLatAlt;
+			LonLatAlt.SetNum(Points.Num());
+			LevelState->GetLLConverter().UE2LLA(Points, LonLatAlt);
+			for (const FVector& Pt : LonLatAlt)
+			{
+				OutFile << Pt.X << "," << Pt.Y << "," << Pt.Z << "\n";
 			}
 		}
 	}
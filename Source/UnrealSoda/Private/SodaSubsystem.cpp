@@ -33,6 +33,7 @@
 #include "Framework/Notifications/NotificationManager.h"
 #include "Widgets/Notifications/SNotificationList.h"
 #include "Soda/SodaCommonSettings.h"
+#include "Soda/SodaBatchRunner.h"
 #include "UObject/UObjectIterator.h"
 #include "Async/Async.h"
 #include "Soda/SodaActorFactory.h"
@@ -324,7 +325,7 @@ void USodaSubsystem::OnWorldBeginPlay(UWorld& World)
 	RestoreLevelTransientData();
 
 	static bool bWasShown = false;
-	if (GetDefault<USodaCommonSettings>()->bShowQuickStartAtStartUp && !bWasShown)
+	if (GetDefault<USodaCommonSettings>()->bShowQuickStartAtStartUp && !bWasShown && !USodaBatchRunner::IsBatchMode())
 	{
 		bWasShown = true;
 		OpenWindow("Quick Start", SNew(soda::SQuickStartWindow));
@@ -0,0 +1,411 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/SodaTrafficAwareness.h"
+#include "Soda/UnrealSoda.h"
+#include "Soda/Actors/NavigationRoute.h"
+#include "Soda/Actors/GhostVehicle/GhostVehicle.h"
+#include "Soda/Actors/GhostPedestrian.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/Character.h"
+#include "Algo/BinarySearch.h"
+#include "Async/ParallelFor.h"
+#include "EngineUtils.h"
+
+DECLARE_STATS_GROUP(TEXT("SodaTraffic"), STATGROUP_SodaTraffic, STATGROUP_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Awareness Placement"), STAT_AwarenessPlacement, STATGROUP_SodaTraffic);
+DECLARE_CYCLE_STAT(TEXT("Awareness Queries"), STAT_AwarenessQueries, STATGROUP_SodaTraffic);
+DECLARE_CYCLE_STAT(TEXT("Awareness Build Lanes"), STAT_AwarenessBuildLanes, STATGROUP_SodaTraffic);
+
+void USodaTrafficAwareness::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+	bBegunPlay = true;
+}
+
+TStatId USodaTrafficAwareness::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USodaTrafficAwareness, STATGROUP_Tickables);
+}
+
+void USodaTrafficAwareness::Watch(const AActor* Actor)
+{
+	if (Actor)
+	{
+		Watched.Add(Actor);
+	}
+}
+
+void USodaTrafficAwareness::Unwatch(const AActor* Actor)
+{
+	Watched.Remove(Actor);
+	if (const int32* Index = AgentIndices.Find(Actor))
+	{
+		Agents[*Index].bWatched = false;
+	}
+}
+
+const FTrafficAwareness* USodaTrafficAwareness::GetAwareness(const AActor* Actor) const
+{
+	const int32* Index = AgentIndices.Find(Actor);
+	if (Index && Agents[*Index].bWatched)
+	{
+		return &Agents[*Index].Awareness;
+	}
+	return nullptr;
+}
+
+const ANavigationRoute* USodaTrafficAwareness::FindNearestRoute(const FVector& Location, const FVector& Direction, float MaxDistance, float& OutDistance)
+{
+	UpdateLanes();
+
+	int32 LaneIndex;
+	if (soda::FindNearestTrafficLane(Lanes, Location, Direction, MaxDistance, LaneIndex, OutDistance))
+	{
+		// The lanes are sampled uniformly by the spline distance, so the lane distance is the spline distance
+		return Lanes[LaneIndex].Route.Get();
+	}
+	return nullptr;
+}
+
+void USodaTrafficAwareness::UpdateLanes()
+{
+	uint32 Hash = 0;
+	for (TActorIterator<ANavigationRoute> It(GetWorld()); It; ++It)
+	{
+		const ANavigationRoute* Route = *It;
+		Hash = HashCombine(Hash, GetTypeHash(Route));
+		Hash = HashCombine(Hash, GetTypeHash(Route->Spline ? Route->Spline->GetSplineGuid() : FGuid()));
+		Hash = HashCombine(Hash, GetTypeHash(Route->GetActorLocation()));
+		Hash = HashCombine(Hash, GetTypeHash(Route->GetActorRotation()));
+		Hash = HashCombine(Hash, GetTypeHash(Route->LeftRoute));
+		Hash = HashCombine(Hash, GetTypeHash(Route->RightRoute));
+		Hash = HashCombine(Hash, GetTypeHash(Route->SuccessorRoute));
+		Hash = HashCombine(Hash, uint32(Route->bAllowForVehicles) | (uint32(Route->bDriveBackvard) << 1));
+	}
+
+	if (Hash == RoutesHash)
+	{
+		return;
+	}
+	RoutesHash = Hash;
+
+	SCOPE_CYCLE_COUNTER(STAT_AwarenessBuildLanes);
+
+	// The lane indices of the previous picture aren't valid anymore
+	Agents.Reset();
+	AgentIndices.Reset();
+
+	soda::BuildTrafficLanes(GetWorld(), 100, Lanes);
+	soda::BuildTrafficCrossings(Lanes, 300);
+
+	int32 CrossingsNum = 0;
+	for (const soda::FTrafficLane& Lane : Lanes)
+	{
+		CrossingsNum += Lane.Crossings.Num();
+	}
+	UE_LOG(LogSoda, Log, TEXT("USodaTrafficAwareness::UpdateLanes(); %i lanes, %i crossings"), Lanes.Num(), CrossingsNum / 2);
+}
+
+float USodaTrafficAwareness::GetActorLength(const AActor* Actor)
+{
+	if (const float* Length = ActorLengths.Find(Actor))
+	{
+		return *Length;
+	}
+	const float Length = FMath::Max(float(Actor->CalculateComponentsBoundingBoxInLocalSpace(true).GetSize().X), 50.f);
+	ActorLengths.Add(Actor, Length);
+	return Length;
+}
+
+void USodaTrafficAwareness::CollectAgents()
+{
+	Agents.Reset();
+	AgentIndices.Reset();
+
+	auto AddAgent = [this](AActor* Actor, bool bPedestrian)
+	{
+		if (!IsValid(Actor))
+		{
+			return;
+		}
+		FAgent& Agent = Agents.AddDefaulted_GetRef();
+		Agent.Actor = Actor;
+		Agent.Location = Actor->GetActorLocation();
+		Agent.Direction = Actor->GetActorForwardVector();
+		Agent.Velocity = Actor->GetVelocity();
+		Agent.Length = GetActorLength(Actor);
+		Agent.bPedestrian = bPedestrian;
+		Agent.bWatched = Watched.Contains(Actor);
+		AgentIndices.Add(Actor, Agents.Num() - 1);
+	};
+
+	for (TActorIterator<APawn> It(GetWorld()); It; ++It)
+	{
+		AddAgent(*It, It->IsA<ACharacter>());
+	}
+	for (TActorIterator<AGhostVehicle> It(GetWorld()); It; ++It)
+	{
+		AddAgent(*It, false);
+	}
+	for (TActorIterator<AGhostPedestrian> It(GetWorld()); It; ++It)
+	{
+		AddAgent(*It, true);
+	}
+
+	// Forget the lengths of the destroyed actors
+	if (ActorLengths.Num() > Agents.Num() * 2 + 64)
+	{
+		for (auto It = ActorLengths.CreateIterator(); It; ++It)
+		{
+			if (!AgentIndices.Contains(It->Key))
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+}
+
+bool USodaTrafficAwareness::TryPlaceOnLane(FAgent& Agent, int32 LaneIndex, float Guess, float Window) const
+{
+	const soda::FTrafficLane& Lane = Lanes[LaneIndex];
+	float SqDist;
+	const float Distance = Lane.Project(Agent.Location, Guess, Window, &SqDist);
+	if (SqDist > FMath::Square(MaxLaneOffset))
+	{
+		return false;
+	}
+
+	FVector LaneLocation, LaneDirection;
+	Lane.GetLocation(Distance, LaneLocation, LaneDirection);
+	if (!Agent.bPedestrian && (LaneDirection | Agent.Direction) <= 0)
+	{
+		return false;
+	}
+
+	Agent.Lane = LaneIndex;
+	Agent.Distance = Distance;
+	Agent.Speed = (Agent.Velocity | LaneDirection) * 0.01f;
+	return true;
+}
+
+void USodaTrafficAwareness::PlaceAgent(FAgent& Agent, int32 PrevLane, float PrevDistance, float DeltaTime) const
+{
+	Agent.Lane = INDEX_NONE;
+
+	// Track the agent from its previous place, it is much cheaper than the full search
+	if (Lanes.IsValidIndex(PrevLane))
+	{
+		const soda::FTrafficLane& Lane = Lanes[PrevLane];
+		const float Travel = Agent.Velocity.Size() * DeltaTime;
+		const float Window = Travel + 2.f * Lane.SampleStep;
+		const float Guess = PrevDistance + Travel;
+
+		if (Guess - Window < Lane.Length && TryPlaceOnLane(Agent, PrevLane, Guess, Window) && Agent.Distance < Lane.Length)
+		{
+			return;
+		}
+		if (Guess + Window > Lane.Length && Lanes.IsValidIndex(Lane.Successor) && TryPlaceOnLane(Agent, Lane.Successor, Guess - Lane.Length, Window))
+		{
+			return;
+		}
+		Agent.Lane = INDEX_NONE;
+	}
+
+	int32 LaneIndex;
+	float Distance;
+	if (soda::FindNearestTrafficLane(Lanes, Agent.Location, Agent.bPedestrian ? FVector::ZeroVector : Agent.Direction, MaxLaneOffset, LaneIndex, Distance))
+	{
+		TryPlaceOnLane(Agent, LaneIndex, Distance, Lanes[LaneIndex].SampleStep);
+	}
+}
+
+void USodaTrafficAwareness::ComputeAwareness(int32 SelfId)
+{
+	FAgent& Agent = Agents[SelfId];
+	FTrafficAwareness& Awareness = Agent.Awareness;
+	Awareness = FTrafficAwareness();
+
+	if (Agent.Lane == INDEX_NONE)
+	{
+		return;
+	}
+
+	Awareness.bOnLane = true;
+	Awareness.Lane = Agent.Lane;
+	Awareness.Distance = Agent.Distance;
+
+	const soda::FTrafficLane& Lane = Lanes[Agent.Lane];
+
+	// Distances of the overlapped agents are clamped to 1 cm, 0 means no obstacle for the drivers
+	auto ClampDistance = [](float Distance) { return FMath::Max(Distance, 1.f); };
+
+	// Leader, the next slot on the lane or the first slots of the successors
+	float Offset = 0;
+	int32 LaneIndex = Agent.Lane;
+	int32 SlotIndex = Agent.Slot + 1;
+	for (int32 Hop = 0; Hop < 8 && Offset - Agent.Distance < LookoutDistance; ++Hop)
+	{
+		const soda::FTrafficLane& CurrLane = Lanes[LaneIndex];
+		if (CurrLane.Slots.IsValidIndex(SlotIndex))
+		{
+			const soda::FTrafficSlot& Leader = CurrLane.Slots[SlotIndex];
+			const float Distance = Leader.Distance + Offset - Agent.Distance - Leader.Length * 0.5f - Agent.Length * 0.5f;
+			if (Leader.AgentId != SelfId && Distance < LookoutDistance)
+			{
+				Awareness.LeaderDistance = ClampDistance(Distance);
+				Awareness.LeaderSpeed = Leader.Speed;
+				Awareness.Leader = Agents[Leader.AgentId].Actor;
+			}
+			break;
+		}
+		if (!Lanes.IsValidIndex(CurrLane.Successor))
+		{
+			break;
+		}
+		Offset += CurrLane.Length;
+		LaneIndex = CurrLane.Successor;
+		SlotIndex = 0;
+	}
+
+	// Follower
+	if (Lane.Slots.IsValidIndex(Agent.Slot - 1))
+	{
+		const soda::FTrafficSlot& Follower = Lane.Slots[Agent.Slot - 1];
+		const float Distance = Agent.Distance - Agent.Length * 0.5f - Follower.Distance - Follower.Length * 0.5f;
+		if (Distance < LookoutDistance)
+		{
+			Awareness.FollowerDistance = ClampDistance(Distance);
+			Awareness.FollowerSpeed = Follower.Speed;
+			Awareness.Follower = Agents[Follower.AgentId].Actor;
+		}
+	}
+
+	// Crossing conflicts. Who reaches the crossing first passes it first, so the both agents make the same decision
+	const float SelfSpeed = FMath::Max(Agent.Speed, 1.f);
+	for (int32 i = Algo::LowerBoundBy(Lane.Crossings, Agent.Distance, &soda::FTrafficCrossing::Distance); i < Lane.Crossings.Num(); ++i)
+	{
+		const soda::FTrafficCrossing& Crossing = Lane.Crossings[i];
+		const float ToCrossing = Crossing.Distance - Agent.Distance;
+		if (ToCrossing > LookoutDistance)
+		{
+			break;
+		}
+		if (ToCrossing - Agent.Length * 0.5f < CrossingHalfWidth)
+		{
+			// Already entered the crossing, go through it
+			continue;
+		}
+
+		const float SelfEta = ToCrossing * 0.01f / SelfSpeed;
+		const soda::FTrafficLane& Other = Lanes[Crossing.OtherLane];
+		const int32 Ahead = Algo::UpperBoundBy(Other.Slots, Crossing.OtherDistance, &soda::FTrafficSlot::Distance);
+
+		const soda::FTrafficSlot* Blocker = nullptr;
+		for (int32 k = Ahead; k < Other.Slots.Num() && !Blocker; ++k)
+		{
+			const soda::FTrafficSlot& Slot = Other.Slots[k];
+			if (Slot.Distance - Slot.Length * 0.5f > Crossing.OtherDistance + CrossingHalfWidth)
+			{
+				break;
+			}
+			Blocker = &Slot;
+		}
+		for (int32 k = Ahead - 1; k >= 0 && !Blocker; --k)
+		{
+			const soda::FTrafficSlot& Slot = Other.Slots[k];
+			const float OtherToCrossing = Crossing.OtherDistance - Slot.Distance;
+			if (OtherToCrossing - Slot.Length * 0.5f < CrossingHalfWidth)
+			{
+				Blocker = &Slot;
+				break;
+			}
+			const float OtherEta = OtherToCrossing * 0.01f / FMath::Max(Slot.Speed, 1.f);
+			if (OtherEta < CrossingTimeHorizon && (OtherEta < SelfEta || (OtherEta == SelfEta && Slot.AgentId < SelfId)))
+			{
+				Blocker = &Slot;
+			}
+			// Only the nearest approaching agent matters
+			break;
+		}
+
+		if (Blocker)
+		{
+			Awareness.ConflictDistance = ClampDistance(ToCrossing - Agent.Length * 0.5f - CrossingHalfWidth);
+			Awareness.ConflictActor = Agents[Blocker->AgentId].Actor;
+			break;
+		}
+	}
+}
+
+void USodaTrafficAwareness::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UpdateLanes();
+
+	if (Lanes.Num() == 0)
+	{
+		Agents.Reset();
+		AgentIndices.Reset();
+		return;
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_AwarenessPlacement);
+
+		TArray<FAgent> PrevAgents = MoveTemp(Agents);
+		TMap<TObjectKey<AActor>, int32> PrevIndices = MoveTemp(AgentIndices);
+
+		CollectAgents();
+
+		ParallelFor(Agents.Num(), [this, &PrevAgents, &PrevIndices, DeltaTime](int32 i)
+		{
+			FAgent& Agent = Agents[i];
+			const int32* PrevIndex = PrevIndices.Find(Agent.Actor.Get());
+			if (PrevIndex)
+			{
+				PlaceAgent(Agent, PrevAgents[*PrevIndex].Lane, PrevAgents[*PrevIndex].Distance, DeltaTime);
+			}
+			else
+			{
+				PlaceAgent(Agent, INDEX_NONE, 0, DeltaTime);
+			}
+		});
+
+		for (soda::FTrafficLane& Lane : Lanes)
+		{
+			Lane.Slots.Reset();
+		}
+		for (int32 i = 0; i < Agents.Num(); ++i)
+		{
+			const FAgent& Agent = Agents[i];
+			if (Agent.Lane != INDEX_NONE)
+			{
+				Lanes[Agent.Lane].Slots.Add({ Agent.Distance, Agent.Speed, 0, Agent.Length, i });
+			}
+		}
+
+		ParallelFor(Lanes.Num(), [this](int32 i)
+		{
+			TArray<soda::FTrafficSlot>& Slots = Lanes[i].Slots;
+			Slots.Sort([](const soda::FTrafficSlot& A, const soda::FTrafficSlot& B) { return A.Distance < B.Distance; });
+			for (int32 k = 0; k < Slots.Num(); ++k)
+			{
+				Agents[Slots[k].AgentId].Slot = k;
+			}
+		});
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_AwarenessQueries);
+
+		// The lanes are read only from here, every agent writes only its own awareness
+		ParallelFor(Agents.Num(), [this](int32 i)
+		{
+			if (Agents[i].bWatched)
+			{
+				ComputeAwareness(i);
+			}
+		});
+	}
+}
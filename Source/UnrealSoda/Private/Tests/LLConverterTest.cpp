@@ -0,0 +1,185 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/Misc/LLConverter.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+
+/** Opens the ECEF conversions of FLLConverter to the tests */
+struct FLLConverterAccess : public FLLConverter
+{
+	using FLLConverter::GeodeticToEcef;
+	using FLLConverter::EcefToGeodetic;
+	using FLLConverter::EcefToGeodeticVermeille;
+};
+
+/** Points of two rings of Radius and Radius / 2 [m] around the Center, the altitude varies by +-AltSpread [m] */
+TArray<FVector> MakePatch(const FVector& Center, double Radius, double AltSpread)
+{
+	static const double EarthRadius = 6371000;
+	TArray<FVector> Points;
+	for (int i = 0; i < 64; ++i)
+	{
+		const double Angle = 2 * PI * i / 64;
+		for (double R : { Radius, Radius / 2 })
+		{
+			Points.Add(FVector(
+				Center.X + FMath::RadiansToDegrees(R * FMath::Cos(Angle) / EarthRadius / FMath::Cos(FMath::DegreesToRadians(Center.Y))),
+				Center.Y + FMath::RadiansToDegrees(R * FMath::Sin(Angle) / EarthRadius),
+				Center.Z + AltSpread * FMath::Sin(3 * Angle)));
+		}
+	}
+	return Points;
+}
+
+} // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGeoVermeilleTest, "Soda.Geo.Vermeille", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FGeoVermeilleTest::RunTest(const FString& Parameters)
+{
+	const FLLConverterAccess Converter;
+
+	for (double Lat : { 90.0, -90.0, 89.999, -89.5, 0.0, 45.0, 59.995, -33.9 })
+	{
+		for (double Lon : { 0.0, 30.13, -179.9, 120.0 })
+		{
+			for (double Alt : { -100.0, 0.0, 10.0, 10000.0, 400000.0, 20200000.0 })
+			{
+				double x, y, z;
+				Converter.GeodeticToEcef(Lat, Lon, Alt, x, y, z);
+
+				double VLat, VLon, VAlt;
+				FLLConverterAccess::EcefToGeodeticVermeille(x, y, z, VLat, VLon, VAlt);
+
+				double ILat, ILon, IAlt;
+				Converter.EcefToGeodetic(x, y, z, ILat, ILon, IAlt);
+
+				const FString Point = FString::Printf(TEXT("(%f, %f, %f)"), Lat, Lon, Alt);
+
+				// The closed form is exact up to the rounding at any latitude and altitude
+				TestNearlyEqual(TEXT("Vermeille Lat ") + Point, VLat, Lat, 1e-9);
+				TestNearlyEqual(TEXT("Vermeille Alt ") + Point, VAlt, Alt, 1e-4);
+				if (FMath::Abs(Lat) < 90)
+				{
+					TestNearlyEqual(TEXT("Vermeille Lon ") + Point, VLon, Lon, 1e-9);
+				}
+
+				// The single step of the iterative method degrades with the altitude: ~1 mm at 400 km, ~0.25 m at the GNSS orbits
+				const bool bNearEarth = Alt <= 10000;
+				TestNearlyEqual(TEXT("Iterative Lat ") + Point, ILat, VLat, bNearEarth ? 1e-9 : 1e-6);
+				TestNearlyEqual(TEXT("Iterative Lon ") + Point, ILon, VLon, 1e-9);
+				TestNearlyEqual(TEXT("Iterative Alt ") + Point, IAlt, VAlt, bNearEarth ? 1e-3 : 0.5);
+			}
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGeoLinearizationTest, "Soda.Geo.LinearizationBound", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FGeoLinearizationTest::RunTest(const FString& Parameters)
+{
+	const double MaxLinearError = 1.0; // [cm]
+
+	// Radius [m] of the patch where the error bound allows the linearization for 1 cm; it shrinks with the latitude
+	struct FCase { double Lat; double Radius; };
+	for (const FCase& Case : { FCase{ 0, 150 }, FCase{ 59.995, 100 }, FCase{ -60, 100 }, FCase{ 85, 40 } })
+	{
+		FLLConverter Converter;
+		Converter.OrignLat = Case.Lat;
+		Converter.OrignLon = 30.13;
+		Converter.OrignAltitude = 10;
+		Converter.Init();
+
+		// The patch is 1 km north-east of the origin, so the linearization point isn't the origin
+		const FVector Center(30.13 + 0.009 / FMath::Cos(FMath::DegreesToRadians(Case.Lat)), Case.Lat + 0.009, 10);
+
+		for (const double AltSpread : { 0.0, 10.0 })
+		{
+			const FString Name = FString::Printf(TEXT("Lat %f, radius %f m, altitude +-%f m"), Case.Lat, Case.Radius, AltSpread);
+			const TArray<FVector> LonLatAlt = MakePatch(Center, Case.Radius, AltSpread);
+			TArray<FVector> Exact, Linear;
+			Exact.SetNum(LonLatAlt.Num());
+			Linear.SetNum(LonLatAlt.Num());
+			Converter.LLA2UE(LonLatAlt, Exact);
+			Converter.LLA2UE(LonLatAlt, Linear, MaxLinearError);
+
+			double MaxError = 0;
+			for (int i = 0; i < LonLatAlt.Num(); ++i)
+			{
+				MaxError = FMath::Max(MaxError, FVector::Dist(Exact[i], Linear[i]));
+			}
+			TestTrue(Name + TEXT(" is linearized"), MaxError > 0);
+			TestTrue(FString::Printf(TEXT("%s error %f cm is in the bound"), *Name, MaxError), MaxError <= MaxLinearError);
+		}
+
+		// The bound rejects the large patch, it's converted exactly
+		const TArray<FVector> LonLatAlt = MakePatch(Center, 2000, 0);
+		TArray<FVector> Exact, Linear;
+		Exact.SetNum(LonLatAlt.Num());
+		Linear.SetNum(LonLatAlt.Num());
+		Converter.LLA2UE(LonLatAlt, Exact);
+		Converter.LLA2UE(LonLatAlt, Linear, MaxLinearError);
+		TestTrue(FString::Printf(TEXT("Lat %f, radius 2 km isn't linearized"), Case.Lat), Exact == Linear);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGeoUTMZoneBoundaryTest, "Soda.Geo.UTMZoneBoundary", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FGeoUTMZoneBoundaryTest::RunTest(const FString& Parameters)
+{
+	// Zone 35 is [24, 30) deg, zone 36 is [30, 36) deg
+	TestEqual(TEXT("Zone west of 30E"), FUTMConverter::GetZone(29.9999), 35);
+	TestEqual(TEXT("Zone at 30E"), FUTMConverter::GetZone(30.0), 36);
+	TestEqual(TEXT("Zone at 180E"), FUTMConverter::GetZone(180.0), 60);
+	TestEqual(TEXT("Zone at 180W"), FUTMConverter::GetZone(-180.0), 1);
+
+	for (const double Lat : { 59.995, -33.9 })
+	{
+		const bool bNorth = Lat > 0;
+		TArray<FVector> LonLatAlt;
+		for (double Lon = 29.5; Lon <= 30.5; Lon += 0.125)
+		{
+			LonLatAlt.Add(FVector(Lon, Lat, 10));
+		}
+
+		// Both zones convert the points of the other side of the boundary too
+		for (const int Zone : { 35, 36 })
+		{
+			FUTMConverter Converter;
+			if (!TestTrue(FString::Printf(TEXT("Init zone %i"), Zone), Converter.Init(Zone, bNorth)))
+			{
+				continue;
+			}
+
+			TArray<FVector> UTM, Back;
+			UTM.SetNum(LonLatAlt.Num());
+			Back.SetNum(LonLatAlt.Num());
+			TestTrue(TEXT("LLA2UTM"), Converter.LLA2UTM(LonLatAlt, UTM));
+			TestTrue(TEXT("UTM2LLA"), Converter.UTM2LLA(UTM, Back));
+
+			for (int i = 0; i < LonLatAlt.Num(); ++i)
+			{
+				const FString Name = FString::Printf(TEXT("Zone %i, (%f, %f)"), Zone, LonLatAlt[i].X, Lat);
+				TestNearlyEqual(Name + TEXT(" Lon"), Back[i].X, LonLatAlt[i].X, 1e-9);
+				TestNearlyEqual(Name + TEXT(" Lat"), Back[i].Y, LonLatAlt[i].Y, 1e-9);
+				TestEqual(Name + TEXT(" Alt"), Back[i].Z, LonLatAlt[i].Z);
+
+				// The central meridian is 27E for zone 35 and 33E for zone 36
+				const double CentralMeridian = Zone * 6 - 183;
+				TestEqual(Name + TEXT(" Easting side"), UTM[i].X > 500000, LonLatAlt[i].X > CentralMeridian);
+			}
+		}
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,151 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/VehicleComponents/Sensors/Base/LidarMultiReturn.h"
+#include "Misc/AutomationTest.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/CollisionProfile.h"
+#include <atomic>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+
+/** Forwards to the current GMalloc and counts the allocations of all threads */
+class FCountingMalloc final : public FMalloc
+{
+public:
+	explicit FCountingMalloc(FMalloc* InInner) : Inner(InInner) {}
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		Allocations.fetch_add(1, std::memory_order_relaxed);
+		return Inner->Malloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		if (Count > 0)
+		{
+			Allocations.fetch_add(1, std::memory_order_relaxed);
+		}
+		return Inner->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override { Inner->Free(Original); }
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+	virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+	virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+	virtual const TCHAR* GetDescriptiveName() override { return TEXT("SodaCountingMalloc"); }
+
+	std::atomic<int64> Allocations{ 0 };
+
+private:
+	FMalloc* Inner;
+};
+
+/** Vertical wall of the cubes with the gaps, so the beams hit the edges and get refined */
+void SpawnWall(UWorld* World, UStaticMesh* Cube)
+{
+	for (int i = -3; i <= 3; ++i)
+	{
+		AStaticMeshActor* Actor = World->SpawnActor<AStaticMeshActor>(FVector(1000, i * 150, 0), FRotator::ZeroRotator);
+		Actor->GetStaticMeshComponent()->SetMobility(EComponentMobility::Movable);
+		Actor->GetStaticMeshComponent()->SetStaticMesh(Cube);
+		Actor->GetStaticMeshComponent()->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+		Actor->SetActorScale3D(FVector(0.2, 1, 4));
+	}
+}
+
+} // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLidarMultiReturnAllocationsTest, "Soda.Lidar.MultiReturnAllocations", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FLidarMultiReturnAllocationsTest::RunTest(const FString& Parameters)
+{
+	UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (!TestNotNull(TEXT("Cube mesh"), Cube))
+	{
+		return false;
+	}
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	SpawnWall(World, Cube);
+
+	// Let the physics scene take the new bodies to the query structure
+	for (int i = 0; i < 3; ++i)
+	{
+		World->Tick(LEVELTICK_All, 1.f / 30);
+	}
+
+	// 64 x 16 grid of the beams looking at the wall
+	const int Columns = 64;
+	const int Rows = 16;
+	TArray<FVector> Rays;
+	for (int Row = 0; Row < Rows; ++Row)
+	{
+		for (int Column = 0; Column < Columns; ++Column)
+		{
+			const float Azimuth = FMath::Lerp(-40.f, 40.f, float(Column) / (Columns - 1));
+			const float Elevation = FMath::Lerp(-15.f, 15.f, float(Row) / (Rows - 1));
+			Rays.Add(FRotator(Elevation, Azimuth, 0).Vector());
+		}
+	}
+
+	soda::FLidarMultiReturnTracer::FSetup Setup;
+	Setup.ReturnsNum = 3;
+	Setup.BeamEdgeRays = 16;
+	Setup.MinDistance = 10;
+	Setup.MaxDistance = 5000;
+
+	soda::FLidarMultiReturnTracer Tracer;
+	const FCollisionQueryParams QueryParams;
+
+	// Warm-up, the buffers reach their high-water mark
+	for (int i = 0; i < 2; ++i)
+	{
+		Tracer.Trace(World, QueryParams, FTransform::Identity, Rays, Columns, Setup);
+	}
+
+	int NumEchoes = 0;
+	for (const soda::FLidarMultiReturnTracer::FEcho& Echo : Tracer.GetEchoes())
+	{
+		NumEchoes += Echo.Energy > 0;
+	}
+	TestTrue(TEXT("The wall is hit"), NumEchoes > 0);
+	TestTrue(TEXT("The edges are refined"), Tracer.GetRefinedBeamsNum() > 0);
+
+	// After the warm-up only the constant overhead of the parallel tasks may allocate, nothing per beam or per hit
+	FMalloc* OriginalMalloc = GMalloc;
+	FCountingMalloc CountingMalloc(OriginalMalloc);
+	TArray<int64> ScanAllocations;
+	GMalloc = &CountingMalloc;
+	for (int i = 0; i < 4; ++i)
+	{
+		const int64 Before = CountingMalloc.Allocations.load();
+		Tracer.Trace(World, QueryParams, FTransform::Identity, Rays, Columns, Setup);
+		ScanAllocations.Add(CountingMalloc.Allocations.load() - Before);
+	}
+	GMalloc = OriginalMalloc;
+
+	const int64 MaxAllocationsPerScan = 64;
+	for (int i = 0; i < ScanAllocations.Num(); ++i)
+	{
+		TestTrue(FString::Printf(TEXT("Scan %d allocations (%lld) are flat"), i, ScanAllocations[i]), ScanAllocations[i] <= MaxAllocationsPerScan);
+	}
+	TestTrue(TEXT("The scan has more beams than the allowed allocations"), Rays.Num() > MaxAllocationsPerScan * 4);
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,109 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/Misc/XCPSlave.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+using namespace xcp;
+
+namespace
+{
+
+bool Command(FBaseTransport& Transport, std::initializer_list<uint8> Cmd, FPacket& Res)
+{
+	uint8 Data[FSlave::MaxCto] = {};
+	FMemory::Memcpy(Data, Cmd.begin(), Cmd.size());
+	return Transport.Request(FPacket(Data, uint8(Cmd.size())), Res);
+}
+
+uint8 CommandError(FSlave& Slave, std::initializer_list<uint8> Cmd)
+{
+	uint8 Res[FSlave::MaxCto];
+	const int Len = Slave.ProcessCommand(Cmd.begin(), int(Cmd.size()), Res);
+	return Len == 2 && Res[0] == SlaveToMasterPID::ERR ? Res[1] : 0;
+}
+
+} // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FXCPSlaveLoopbackTest, "Soda.XCP.LoopbackMaster", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FXCPSlaveLoopbackTest::RunTest(const FString& Parameters)
+{
+	float Speed = 12.5f;
+	int32 Gear = 3;
+
+	TSharedPtr<FSlave> Slave = MakeShared<FSlave>();
+	const uint16 EventChannel = Slave->AddEvent(TEXT("Test"));
+	Slave->GetSymbolTable().AddSymbol(TEXT("Speed"), &Speed, EDataType::Float32, true);
+	Slave->GetSymbolTable().AddSymbol(TEXT("Gear"), &Gear, EDataType::SLong, false);
+	const uint32 SpeedAddress = Slave->GetSymbolTable().GetSymbols()[0].Address;
+	const uint32 GearAddress = Slave->GetSymbolTable().GetSymbols()[1].Address;
+
+	TSharedPtr<FLoopbackTransport> Transport = MakeShared<FLoopbackTransport>(Slave);
+	FMaster Master(Transport);
+
+	// Connection and calibration
+	TestTrue(TEXT("Connect"), Master.Connect());
+	TestEqual(TEXT("MaxCto"), int(Master.GetConnectionInfo().MaxCto), FSlave::MaxCto);
+
+	float Value = 0;
+	TestTrue(TEXT("SetMta"), Master.SetMta(SpeedAddress));
+	TestTrue(TEXT("Upload"), Master.Upload((uint8*)&Value, sizeof(Value)));
+	TestEqual(TEXT("Uploaded value"), Value, Speed);
+
+	const float NewSpeed = 20.f;
+	TestTrue(TEXT("SetMta"), Master.SetMta(SpeedAddress));
+	TestTrue(TEXT("Download"), Master.Download((const uint8*)&NewSpeed, sizeof(NewSpeed)));
+	TestEqual(TEXT("Download is deferred"), Speed, 12.5f);
+	Slave->ApplyPendingWrites();
+	TestEqual(TEXT("Downloaded value"), Speed, NewSpeed);
+
+	TestTrue(TEXT("SetMta"), Master.SetMta(GearAddress));
+	TestEqual(TEXT("Download to the read-only symbol"), CommandError(*Slave, { DOWNLOAD, 1, 0 }), uint8(ERR_ACCESS_DENIED));
+
+	// DAQ list: one ODT with the speed and the gear
+	FPacket Res;
+	TestTrue(TEXT("FREE_DAQ"), Command(*Transport, { FREE_DAQ }, Res));
+	TestTrue(TEXT("ALLOC_DAQ"), Command(*Transport, { ALLOC_DAQ, 0, 1, 0 }, Res));
+	TestTrue(TEXT("ALLOC_ODT"), Command(*Transport, { ALLOC_ODT, 0, 0, 0, 1 }, Res));
+	TestTrue(TEXT("ALLOC_ODT_ENTRY"), Command(*Transport, { ALLOC_ODT_ENTRY, 0, 0, 0, 0, 2 }, Res));
+	TestTrue(TEXT("SET_DAQ_PTR"), Command(*Transport, { SET_DAQ_PTR, 0, 0, 0, 0, 0 }, Res));
+	TestTrue(TEXT("WRITE_DAQ speed"), Command(*Transport, { WRITE_DAQ, 0xFF, 4, 0, uint8(SpeedAddress), uint8(SpeedAddress >> 8), uint8(SpeedAddress >> 16), uint8(SpeedAddress >> 24) }, Res));
+	TestTrue(TEXT("WRITE_DAQ gear"), Command(*Transport, { WRITE_DAQ, 0xFF, 4, 0, uint8(GearAddress), uint8(GearAddress >> 8), uint8(GearAddress >> 16), uint8(GearAddress >> 24) }, Res));
+	TestTrue(TEXT("SET_DAQ_LIST_MODE"), Command(*Transport, { SET_DAQ_LIST_MODE, 0, 0, 0, uint8(EventChannel), uint8(EventChannel >> 8), 1, 0 }, Res));
+	TestTrue(TEXT("START_STOP_DAQ_LIST"), Command(*Transport, { START_STOP_DAQ_LIST, 1, 0, 0 }, Res));
+	TestTrue(TEXT("DAQ is running"), Slave->IsDaqRunning());
+
+	Slave->Event(EventChannel, soda::Now());
+	TArray<uint8> Dto;
+	TestEqual(TEXT("DTO number"), Slave->DrainDto([&Dto](const uint8* Data, int Len) { Dto.Append(Data, Len); }), 1);
+	if (TestEqual(TEXT("DTO size"), Dto.Num(), 1 + 4 + 4))
+	{
+		float SampledSpeed;
+		int32 SampledGear;
+		FMemory::Memcpy(&SampledSpeed, &Dto[1], 4);
+		FMemory::Memcpy(&SampledGear, &Dto[5], 4);
+		TestEqual(TEXT("DTO PID"), int(Dto[0]), 0);
+		TestEqual(TEXT("Sampled speed"), SampledSpeed, Speed);
+		TestEqual(TEXT("Sampled gear"), SampledGear, Gear);
+	}
+
+	// WRITE_DAQ after the ODTs are shrunk behind the DAQ pointer
+	TestTrue(TEXT("Stop DAQ"), Command(*Transport, { START_STOP_DAQ_LIST, 0, 0, 0 }, Res));
+	TestTrue(TEXT("SET_DAQ_PTR"), Command(*Transport, { SET_DAQ_PTR, 0, 0, 0, 0, 1 }, Res));
+	TestTrue(TEXT("Shrink ODTs"), Command(*Transport, { ALLOC_ODT, 0, 0, 0, 0 }, Res));
+	TestEqual(TEXT("WRITE_DAQ out of range"), CommandError(*Slave, { WRITE_DAQ, 0xFF, 4, 0, uint8(SpeedAddress), uint8(SpeedAddress >> 8), uint8(SpeedAddress >> 16), uint8(SpeedAddress >> 24) }), uint8(ERR_OUT_OF_RANGE));
+
+	// Rebuilt symbol table frees the DAQ lists, which point to the old memory
+	AddExpectedError(TEXT("DAQ lists are freed"), EAutomationExpectedErrorFlags::Contains, 1);
+	Slave->ResetSymbolTable([](FSymbolTable& SymbolTable) {});
+	TestEqual(TEXT("Symbols are reset"), Slave->GetSymbolTable().GetSymbols().Num(), 0);
+	TestEqual(TEXT("DAQ lists are freed"), CommandError(*Slave, { GET_DAQ_LIST_MODE, 0, 0, 0 }), uint8(ERR_OUT_OF_RANGE));
+
+	TestTrue(TEXT("Disconnect"), Master.Disconnect());
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -124,13 +124,12 @@ void UGenericVehicleDriverComponent::PrePhysicSimulation(float DeltaTime, const
 {
 	Super::PrePhysicSimulation(DeltaTime, VehicleKinematic, Timestamp);
 
-	static const std::chrono::nanoseconds Timeout(500000000ll); // 500ms
-
 	bVapiPing = bIsVehicleDriveDebugMode;
 
 	if (VehicleControl && VehicleControl->GetControl(Control))
 	{
-		bVapiPing = ((SodaApp.GetRealtimeTimestamp() - Control.Timestamp < Timeout));
+		// If the listener doesn't require the safe stop on the timeout, the last control is held
+		bVapiPing = !VehicleControl->IsControlTimeout() || !VehicleControl->bSafeStopOnTimeout;
 	}
 
 	UVehicleInputComponent* VehicleInput = GetWheeledVehicle()->GetActiveVehicleInput();
@@ -12,6 +12,7 @@
 #include "DrawDebugHelpers.h"
 #include "Kismet/GameplayStatics.h"
 #include "Soda/SodaStatics.h"
+#include "Soda/SodaTrafficAwareness.h"
 #include "Engine/Canvas.h"
 #include "Engine/Engine.h"
 #include "VehicleUtility.h"
@@ -26,8 +27,7 @@ DECLARE_CYCLE_STAT(TEXT("TickComponent"), STAT_AI_TickComponent, STATGROUP_UWhee
 DECLARE_CYCLE_STAT(TEXT("CalcStreeringValue"), STAT_AI_CalcStreeringValue, STATGROUP_UWheeledVehicleAIControllerComponent);
 DECLARE_CYCLE_STAT(TEXT("GetDistanceToObstacle"), STAT_AI_GetDistanceToObstacle, STATGROUP_UWheeledVehicleAIControllerComponent);
 DECLARE_CYCLE_STAT(TEXT("CalcSpeedValue"), STAT_AI_CalcSpeedValue, STATGROUP_UWheeledVehicleAIControllerComponent);
-DECLARE_CYCLE_STAT(TEXT("FindInputKeyClosestToWorldLocation"), STAT_AI_FindInputKeyClosestToWorldLocation, STATGROUP_UWheeledVehicleAIControllerComponent);
-DECLARE_CYCLE_STAT(TEXT("GetDirectionAtSplineInputKey"), STAT_AI_GetDirectionAtSplineInputKey, STATGROUP_UWheeledVehicleAIControllerComponent);
+DECLARE_CYCLE_STAT(TEXT("TrackRoute"), STAT_AI_TrackRoute, STATGROUP_UWheeledVehicleAIControllerComponent);
 
 static float GetDistanceFromLineToPoint(FVector Start, FVector End, FVector Pnt, bool LimitByLineEnd)
 {
@@ -65,12 +65,25 @@ bool UVehicleInputAIComponent::OnActivateVehicleComponent()
 
 	ResetAutopilot();
 
+	if (bUseTrafficAwareness)
+	{
+		if (USodaTrafficAwareness* TrafficAwareness = GetWorld()->GetSubsystem<USodaTrafficAwareness>())
+		{
+			TrafficAwareness->Watch(GetVehicle());
+		}
+	}
+
 	return true;
 }
 
 void UVehicleInputAIComponent::OnDeactivateVehicleComponent()
 {
 	Super::OnDeactivateVehicleComponent();
+
+	if (USodaTrafficAwareness* TrafficAwareness = GetWorld()->GetSubsystem<USodaTrafficAwareness>())
+	{
+		TrafficAwareness->Unwatch(GetVehicle());
+	}
 }
 
 void UVehicleInputAIComponent::BeginPlay()
@@ -107,7 +120,7 @@ void UVehicleInputAIComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 
 void UVehicleInputAIComponent::ResetAutopilot()
 {
-	TargetLocations.Reset(0);
+	Route.Reset();
 }
 
 bool UVehicleInputAIComponent::TryToStartRandomRoute()
@@ -159,6 +172,18 @@ bool UVehicleInputAIComponent::TryToFindNearestRoute()
 	FVector VehicleLocation = GetVehicle()->GetActorLocation();
 	FVector VehicleForwardVector = GetVehicle()->GetActorForwardVector();
 
+	// The shared lanes cover only the forward routes, otherwise look through all routes
+	USodaTrafficAwareness* TrafficAwareness = bUseTrafficAwareness ? GetWorld()->GetSubsystem<USodaTrafficAwareness>() : nullptr;
+	if (TrafficAwareness && !bDriveBackvard)
+	{
+		float Distance = 0;
+		const ANavigationRoute* Route = TrafficAwareness->FindNearestRoute(VehicleLocation, VehicleForwardVector, 200, Distance);
+		if (Route && Route->Spline->GetSplineLength() - Distance > 200)
+		{
+			return SetFixedRouteBySpline(Route->Spline, bDriveBackvard, false, Distance);
+		}
+	}
+
 	for (TActorIterator< ANavigationRoute > It(GetWorld()); It; ++It)
 	{
 		if ((*It)->bAllowForVehicles)
@@ -200,7 +225,7 @@ bool UVehicleInputAIComponent::TryToAppendRandomRoute()
 		if (RoutePlanner->bAllowForVehicles)
 		{
 			// Check if last target location is inside this route planner.
-			if (IsPointInsideBox(TargetLocations.Last(), RoutePlanner->TriggerVolume) && RoutePlanner->bDriveBackvard == bDriveBackvard)
+			if (IsPointInsideBox(Route.GetLastPoint(), RoutePlanner->TriggerVolume) && RoutePlanner->bDriveBackvard == bDriveBackvard)
 			{
 				return AssignRoute(RoutePlanner);
 			}
@@ -213,40 +238,49 @@ void UVehicleInputAIComponent::SetFixedRouteByWaypoints(const TArray< FVector >&
 {
 	if (bOverwriteCurrent)
 	{
-		TargetLocations.Reset(0);
+		Route.Reset();
 	}
 
 	bDriveBackvard = bNewDriveBackvard;
 
+	// The waypoints are smoothed by the spline, the spline starts from the end of the current route for the continuity
+	TArray< FVector > SplinePoints;
+	if (!Route.IsEmpty())
+	{
+		SplinePoints.Add(Route.GetLastPoint());
+	}
 	for (auto& Location : Locations)
 	{
-		if (TargetLocations.Num() == 0)
-			TargetLocations.Add(Location);
-		else if ((TargetLocations.Last() - Location).Size() > SamePointsDelta)
-			TargetLocations.Add(Location);
+		if (SplinePoints.Num() == 0)
+			SplinePoints.Add(Location);
+		else if ((SplinePoints.Last() - Location).Size() > SamePointsDelta)
+			SplinePoints.Add(Location);
 		else if (bDebugOutputLog)
-			if(bDebugOutputLog) UE_LOG(LogSoda, Error, TEXT("UVehicleInputAIComponent Waypoint (%f, %f, %f) purged."), Location.X, Location.Y, Location.Z);
+			UE_LOG(LogSoda, Error, TEXT("UVehicleInputAIComponent Waypoint (%f, %f, %f) purged."), Location.X, Location.Y, Location.Z);
+	}
+
+	if (SplinePoints.Num() == 1)
+	{
+		Route.AddPoint(SplinePoints[0]);
+	}
+	else if (SplinePoints.Num() > 1)
+	{
+		RouteSpline->ClearSplinePoints(false);
+		RouteSpline->SetSplinePoints(SplinePoints, ESplineCoordinateSpace::World, true);
+		Route.AddSpline(RouteSpline);
 	}
-	RouteSpline->ClearSplinePoints(false);
-	RouteSpline->SetSplinePoints(TargetLocations, ESplineCoordinateSpace::World, true);
-	CurrentSplineSegment = -1;
 }
 
 bool UVehicleInputAIComponent::SetFixedRouteBySpline(const USplineComponent* SplineRoute, bool bNewDriveBackvard, bool bOverwriteCurrent, float StartOffset)
 {
-
-	TArray< FVector > WayPoints;
-	const float Step = 50; // Points step in [cm]
-	const auto Size = (size_t)((SplineRoute->GetSplineLength() - StartOffset) / Step);
-
-	if (Size > 1)
+	if (SplineRoute->GetSplineLength() - StartOffset > Route.GetStep() * 2)
 	{
-		WayPoints.Reserve(Size);
-		for (auto i = 1; i < Size; ++i)
+		if (bOverwriteCurrent)
 		{
-			WayPoints.Add(SplineRoute->GetLocationAtDistanceAlongSpline(StartOffset + i * Step, ESplineCoordinateSpace::World));
+			Route.Reset();
 		}
-		SetFixedRouteByWaypoints(WayPoints, bNewDriveBackvard, bOverwriteCurrent);
+		bDriveBackvard = bNewDriveBackvard;
+		Route.AddSpline(SplineRoute, StartOffset);
 		return true;
 	}
 	else
@@ -263,28 +297,27 @@ void UVehicleInputAIComponent::UpdateInputStatesInner(float DeltaTime)
 	const auto Speed = Chaos::CmSToKmH(GetWheeledVehicle()->GetSimData().VehicleKinematic.Curr.GetLocalVelocity().X);
 	const auto AbsSpeed = fabsf(Speed);
 	const FVector CurrentLocation = GetWheeledVehicle()->GetSimData().VehicleKinematic.Curr.GlobalPose.GetLocation();
-	CurrentObstacleDistance = GetDistanceToObstacle();
-	const float TargetSpeed = CalcSpeedValue(CurrentObstacleDistance);
-	const FVector Forward = GetWheeledVehicle()->GetSimData().VehicleKinematic.Curr.GlobalPose.GetRotation().Rotator().Vector() *
-		(bDriveBackvard ? -1.0 : 1.0);
 
-	// Clear target locations
-	while (TargetLocations.Num() > 0 && (TargetLocations[0] - CurrentLocation).CosineAngle2D(Forward) < 0 /*&& AbsSpeed > 1.f*/)
 	{
-		TargetLocations.RemoveAt(0);
+		SCOPE_CYCLE_COUNTER(STAT_AI_TrackRoute);
+		Route.Track(CurrentLocation);
+		if (!Route.IsEmpty() && Route.GetDistanceToEnd() < Route.GetStep())
+		{
+			// Route is passed
+			Route.Reset();
+		}
+	}
+
+	if (!GetObstacleDistanceFromAwareness(CurrentObstacleDistance))
+	{
+		CurrentObstacleDistance = GetDistanceToObstacle();
 	}
+	const float TargetSpeed = CalcSpeedValue(CurrentObstacleDistance);
 
 	// Append route on the end of current spline
-	if (TargetLocations.Num() > 2)
+	if (!Route.IsEmpty())
 	{
-		auto PrevLocation = CurrentLocation;
-		float DistToRouteEnd = 0;
-		for (size_t i = 0; i < TargetLocations.Num(); ++i)
-		{
-			DistToRouteEnd += FVector::Dist(TargetLocations[i], PrevLocation);
-			PrevLocation = TargetLocations[i];
-		}
-
+		const float DistToRouteEnd = Route.GetDistanceToEnd();
 		const float RoutePreloadDistance = 10000.f; // [cm]
 		if (DistToRouteEnd < RoutePreloadDistance || DistToRouteEnd < GetSlowingDistance())
 		{
@@ -293,7 +326,7 @@ void UVehicleInputAIComponent::UpdateInputStatesInner(float DeltaTime)
 	}
 
 	// Finding new spline for route
-	if (TargetLocations.Num() == 0)
+	if (Route.IsEmpty())
 	{
 		if (!TryToStartRandomRoute())
 		{
@@ -303,7 +336,7 @@ void UVehicleInputAIComponent::UpdateInputStatesInner(float DeltaTime)
 
 	//Compute Throttle, Steering, Gear
 	Throttle = 0;
-	Steering = TargetLocations.Num() ? CalcStreeringValue(DeltaTime) : 0.0f;
+	Steering = !Route.IsEmpty() ? CalcStreeringValue(DeltaTime) : 0.0f;
 	Gear = bDriveBackvard ? EGearState::Reverse : EGearState::Drive;
 
 	if (CurrentObstacleDistance > 0.f && CurrentObstacleDistance < ObstacleStopDistance * 100 && !bDriveBackvard) // Stop if Obstacle
@@ -315,7 +348,7 @@ void UVehicleInputAIComponent::UpdateInputStatesInner(float DeltaTime)
 		Throttle = ThrottleStop(AbsSpeed);
 		Steering = 0.0f;
 	}
-	else if (TargetLocations.Num() == 0) // Route is end. Stopping...
+	else if (Route.IsEmpty()) // Route is end. Stopping...
 	{
 		Throttle = ThrottleStop(AbsSpeed);
 		Steering = 0.0f;
@@ -361,30 +394,12 @@ float UVehicleInputAIComponent::CalcStreeringValue(float DeltaTime)
 		(bDriveBackvard ? -1.0 : 1.0);
 	const auto Speed = Chaos::CmSToKmH(GetWheeledVehicle()->GetSimData().VehicleKinematic.Curr.GetLocalVelocity().X);
 
-	const auto ForvardedLocationDir = CurrentLocation + Forward.GetSafeNormal() * ForwardingDistanceDir;
-	const auto ForvardedLocationLoc = CurrentLocation + Forward.GetSafeNormal() * ForwardingDistanceLoc;
-
-	const float SplineKey = USodaStatics::FindSplineInputKeyClosestToWorldLocationFast(CurrentLocation, CurrentSplineSegment, RouteSpline);
-	const float SplineDirAtCurrentLoc = _RAD2DEG(RouteSpline->GetDirectionAtSplineInputKey(SplineKey, ESplineCoordinateSpace::World).GetUnsafeNormal().UnitCartesianToSpherical().Y);
-
-	float SplineInputKeyDir = 0;
-	float SplineInputKeyLoc = 0;
+	// The route is already tracked to the current location, so the look-ahead points are taken by the arc length
+	const float SplineDirAtCurrentLoc = _RAD2DEG(Route.GetDirectionAhead(0).UnitCartesianToSpherical().Y);
+	const FVector ForwardedSplineDirection = Route.GetDirectionAhead(ForwardingDistanceDir);
+	const FVector ForwardedSplineLocation = Route.GetLocationAhead(ForwardingDistanceLoc);
 
-	{
-		SCOPE_CYCLE_COUNTER(STAT_AI_FindInputKeyClosestToWorldLocation);
-		SplineInputKeyDir = USodaStatics::FindSplineInputKeyClosestToWorldLocationFast(ForvardedLocationDir, CurrentSplineSegment, RouteSpline);
-		SplineInputKeyLoc = USodaStatics::FindSplineInputKeyClosestToWorldLocationFast(ForvardedLocationLoc, CurrentSplineSegment, RouteSpline);
-	}
-
-	FVector ForwardedSplineDirection;
-	FVector ForwardedSplineLocation;
-	{
-		SCOPE_CYCLE_COUNTER(STAT_AI_GetDirectionAtSplineInputKey);
-		ForwardedSplineDirection = RouteSpline->GetDirectionAtSplineInputKey(SplineInputKeyDir, ESplineCoordinateSpace::World).GetUnsafeNormal();
-		ForwardedSplineLocation = RouteSpline->GetLocationAtSplineInputKey(SplineInputKeyLoc, ESplineCoordinateSpace::World);
-	}
-
-	SideError = (RouteSpline->GetLocationAtSplineInputKey(SplineKey, ESplineCoordinateSpace::World) - CurrentLocation).Size2D();
+	SideError = (Route.GetLocationAhead(0) - CurrentLocation).Size2D();
 
 	auto LocErrorVector = ForwardedSplineLocation - CurrentLocation;
 	LocErrorVector.Z = 0;
@@ -419,30 +434,22 @@ float UVehicleInputAIComponent::CalcSpeedValue(float ObstacleDistance)
 {
 	SCOPE_CYCLE_COUNTER(STAT_AI_CalcSpeedValue);
 
-	const FVector CurrentLocation = GetWheeledVehicle()->GetSimData().VehicleKinematic.Curr.GlobalPose.GetLocation();
-
-	if (TargetLocations.Num() == 0)
+	if (Route.IsEmpty())
 	{
 		return 0;
 	}
-	else if (TargetLocations.Num() == 1)
+	else if (Route.GetNumAhead() == 1)
 	{
 		return SpeedSlow;
 	}
 
-	float Dist = FVector::Dist(TargetLocations[0], CurrentLocation);
+	const float Step = Route.GetStep();
 	float DistAlongRoute = 0;
-	FVector PrevLocation = CurrentLocation;
 	float Speed = Chaos::CmSToKmH(GetWheeledVehicle()->GetSimData().VehicleKinematic.Curr.GetLocalVelocity().X);
 	float SlowingDistance = GetSlowingDistance();
 	float FusedCurvature = 0;
 
-	float DistToRouteEnd = 0;
-	for (size_t i = 0; i < TargetLocations.Num(); ++i)
-	{
-		DistToRouteEnd += FVector::Dist(TargetLocations[i], PrevLocation);
-		PrevLocation = TargetLocations[i];
-	}
+	float DistToRouteEnd = Route.GetDistanceToEnd();
 	if (!bDriveBackvard && ObstacleDistance > 0.f)
 		DistToRouteEnd = fminf(DistToRouteEnd, ObstacleDistance - ObstacleStopDistance * 100);
 
@@ -450,40 +457,33 @@ float UVehicleInputAIComponent::CalcSpeedValue(float ObstacleDistance)
 	float RetSpeed = SpeedLimit;
 
 	float DebugAngle = 0;
-	float DebugMeanCurv = 0;
 	float DebugFusedCurvature = 0;
 	float DebugCalcSpeed = 0;
-	float DebugNextTurnAngle = 0;
 	float DebugDistAlongRoute = 0;
 
-	if (TargetLocations.Num() >= 2)
+	// The route samples are equidistant, so the curvature is the turn angle at the sample divided by the step
+	const float RouteEnd = Route.GetDistanceToEnd() - Step;
+	for (float Ahead = Step; Ahead < RouteEnd && DistAlongRoute < SlowingDistance; Ahead += Step)
 	{
-		PrevLocation = TargetLocations[0];
+		DistAlongRoute = Ahead;
 
-		for (size_t i = 1; i < TargetLocations.Num() - 1 && DistAlongRoute < SlowingDistance; ++i)
+		const float Angle = Route.GetTurnAngleAhead(Ahead);
+		if (Angle > PI * 0.75f)
 		{
-			DistAlongRoute += FVector::Dist(TargetLocations[i], PrevLocation);
-			if (acos(FMath::Clamp((TargetLocations[i] - PrevLocation).CosineAngle2D(TargetLocations[i + 1] - TargetLocations[i]), -1.f, 1.f)) > PI * 0.75f || FVector::Dist(TargetLocations[i], PrevLocation) < 20.f || FVector::Dist(TargetLocations[i], TargetLocations[i + 1]) < 20.f)
-			{
-				PrevLocation = TargetLocations[i];
-				continue;
-			}
-
-			float Angle = acos(FMath::Clamp((TargetLocations[i] - PrevLocation).CosineAngle2D(TargetLocations[i + 1] - TargetLocations[i]), -1.f, 1.f));
-			float MeanCurv = Angle / FVector::Dist(TargetLocations[i], PrevLocation);
-			FusedCurvature = (1.f - CurvatreSmoothingCoef) * FusedCurvature + CurvatreSmoothingCoef * MeanCurv;
-			float CalcSpeed = fminf(MaxSpeed, fmaxf(SpeedSlow, 1.0f / (FusedCurvature * SpeedToCurvatureCoef + SideError * SideErrorSpeedCoef + 0.0001f)));
-			float NewRetSpeed = Rate * FMath::Lerp(CalcSpeed, MaxSpeed, FMath::Clamp(DistAlongRoute / SlowingDistance, 0.f, 1.f));
-			if (NewRetSpeed < RetSpeed)
-			{
-				RetSpeed = NewRetSpeed;
-				DebugAngle = Angle;
-				DebugFusedCurvature = FusedCurvature * SpeedToCurvatureCoef;
-				DebugCalcSpeed = CalcSpeed;
-				DebugDistAlongRoute = DistAlongRoute;
-			}
+			continue;
+		}
 
-			PrevLocation = TargetLocations[i];
+		float MeanCurv = Angle / Step;
+		FusedCurvature = (1.f - CurvatreSmoothingCoef) * FusedCurvature + CurvatreSmoothingCoef * MeanCurv;
+		float CalcSpeed = fminf(MaxSpeed, fmaxf(SpeedSlow, 1.0f / (FusedCurvature * SpeedToCurvatureCoef + SideError * SideErrorSpeedCoef + 0.0001f)));
+		float NewRetSpeed = Rate * FMath::Lerp(CalcSpeed, MaxSpeed, FMath::Clamp(DistAlongRoute / SlowingDistance, 0.f, 1.f));
+		if (NewRetSpeed < RetSpeed)
+		{
+			RetSpeed = NewRetSpeed;
+			DebugAngle = Angle;
+			DebugFusedCurvature = FusedCurvature * SpeedToCurvatureCoef;
+			DebugCalcSpeed = CalcSpeed;
+			DebugDistAlongRoute = DistAlongRoute;
 		}
 	}
 
@@ -561,7 +561,7 @@ float UVehicleInputAIComponent::GetDistanceToObstacle()
 {
 	SCOPE_CYCLE_COUNTER(STAT_AI_GetDistanceToObstacle);
 
-	if (TargetLocations.Num() < 2)
+	if (Route.GetNumAhead() < 2)
 		return -1.f;
 
 	float DistAlongRoute = 0;
@@ -580,7 +580,7 @@ float UVehicleInputAIComponent::GetDistanceToObstacle()
 		ActorsToCheck.Append(TempActors);
 
 		ActorsToCheck.RemoveAll([this, LookoutDistance](const AActor* Ptr) {
-			return ((Ptr->GetActorLocation() - TargetLocations[0]).Size() > LookoutDistance ||
+			return ((Ptr->GetActorLocation() - Route.GetSampleAhead(0)).Size() > LookoutDistance ||
 					 Ptr->GetName().Contains("BP_ArrivalFakeCar_C"));
 		});
 		ActorsToCheck.Remove(GetVehicle());
@@ -589,14 +589,14 @@ float UVehicleInputAIComponent::GetDistanceToObstacle()
 			return -1.f;
 	}
 
-	for (size_t i = 0; i + 1 < TargetLocations.Num() && DistAlongRoute < LookoutDistance; i++)
+	for (size_t i = 0; i + 1 < Route.GetNumAhead() && DistAlongRoute < LookoutDistance; i++)
 	{
-		float Error = GetDistanceFromLineToPoint(TargetLocations[SegmentBeginIndex], TargetLocations[SegmentBeginIndex + 1], TargetLocations[i + 1], false);
-		if (i + 2 >= TargetLocations.Num() ||
+		float Error = GetDistanceFromLineToPoint(Route.GetSampleAhead(SegmentBeginIndex), Route.GetSampleAhead(SegmentBeginIndex + 1), Route.GetSampleAhead(i + 1), false);
+		if (i + 2 >= Route.GetNumAhead() ||
 			Error > RouteSectionPointMaxSideDeviation)
 		{
-			const FVector StartCenter = TargetLocations[SegmentBeginIndex];
-			const FVector EndCenter = TargetLocations[i];
+			const FVector StartCenter = Route.GetSampleAhead(SegmentBeginIndex);
+			const FVector EndCenter = Route.GetSampleAhead(i);
 
 			float HitDistance = -1;
 			if (bUseRayCast)
@@ -609,7 +609,7 @@ float UVehicleInputAIComponent::GetDistanceToObstacle()
 
 			if (bDrawTargetLocations)
 			{
-				DrawDebugString(GetWorld(), TargetLocations[SegmentBeginIndex], *FString::Printf(TEXT("PointSideError=%f, Segment: BeginIndex=%d, EndIndex=%d"), Error, SegmentBeginIndex, i), NULL, FColor::Yellow, 0.01f, false);
+				DrawDebugString(GetWorld(), Route.GetSampleAhead(SegmentBeginIndex), *FString::Printf(TEXT("PointSideError=%f, Segment: BeginIndex=%d, EndIndex=%d"), Error, SegmentBeginIndex, i), NULL, FColor::Yellow, 0.01f, false);
 
 				DrawDebugLine(
 					GetWorld(),
@@ -622,7 +622,7 @@ float UVehicleInputAIComponent::GetDistanceToObstacle()
 
 			if (HitDistance > 0.f)
 			{
-				if (bUseRayCast && bDrawTargetLocations) DrawDebugString(GetWorld(), TargetLocations[0] + FVector(0, 0, 20.f), *FString::Printf(TEXT("Total colliders used=%d"), CollidersUsed), NULL, FColor::Green, 0.01f, false);
+				if (bUseRayCast && bDrawTargetLocations) DrawDebugString(GetWorld(), Route.GetSampleAhead(0) + FVector(0, 0, 20.f), *FString::Printf(TEXT("Total colliders used=%d"), CollidersUsed), NULL, FColor::Green, 0.01f, false);
 
 				return HitDistance + DistAlongRoute;
 			}
@@ -631,11 +631,29 @@ float UVehicleInputAIComponent::GetDistanceToObstacle()
 			DistAlongRoute += (EndCenter - StartCenter).Size();
 		}
 	}
-	if (bUseRayCast && bDrawTargetLocations) DrawDebugString(GetWorld(), TargetLocations[0] + FVector(0, 0, 20.f), *FString::Printf(TEXT("Total colliders used=%d"), CollidersUsed), NULL, FColor::Green, 0.01f, false);
+	if (bUseRayCast && bDrawTargetLocations) DrawDebugString(GetWorld(), Route.GetSampleAhead(0) + FVector(0, 0, 20.f), *FString::Printf(TEXT("Total colliders used=%d"), CollidersUsed), NULL, FColor::Green, 0.01f, false);
 
 	return -1.f;
 }
 
+bool UVehicleInputAIComponent::GetObstacleDistanceFromAwareness(float& OutDistance) const
+{
+	if (!bUseTrafficAwareness || bDriveBackvard || Route.IsEmpty())
+	{
+		return false;
+	}
+
+	const USodaTrafficAwareness* TrafficAwareness = GetWorld()->GetSubsystem<USodaTrafficAwareness>();
+	const FTrafficAwareness* Awareness = TrafficAwareness ? TrafficAwareness->GetAwareness(GetVehicle()) : nullptr;
+	if (!Awareness || !Awareness->bOnLane)
+	{
+		return false;
+	}
+
+	OutDistance = Awareness->GetObstacleDistance();
+	return true;
+}
+
 bool UVehicleInputAIComponent::IsPointInsideBox(FVector Point, UBoxComponent* BoxComponent) const
 {
 	float xmin = BoxComponent->GetComponentLocation().X - BoxComponent->GetScaledBoxExtent().X - 100;
@@ -656,10 +674,10 @@ void UVehicleInputAIComponent::DrawCurrentRoute()
 {
 	bool ModeAI = GetWheeledVehicle()->GetActiveVehicleInput() == this;
 
-	for (int j = 0, lenNumPoints = TargetLocations.Num() - 1; j < lenNumPoints; ++j)
+	for (int j = 0, lenNumPoints = Route.GetNumAhead() - 1; j < lenNumPoints; ++j)
 	{
-		const FVector p0 = TargetLocations[j + 0];
-		const FVector p1 = TargetLocations[j + 1];
+		const FVector p0 = Route.GetSampleAhead(j + 0);
+		const FVector p1 = Route.GetSampleAhead(j + 1);
 
 		static const float MinThickness = 3.f;
 		static const float MaxThickness = 15.f;
@@ -693,9 +711,23 @@ void UVehicleInputAIComponent::DrawDebug(UCanvas* Canvas, float& YL, float& YPos
 	{
 		UFont* RenderFont = GEngine->GetSmallFont();
 		Canvas->SetDrawColor(FColor::White);
-		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("TargetLocationsNum: %i"), TargetLocations.Num()), 16, YPos);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("DistanceToRouteEnd: %.1fm"), Route.GetDistanceToEnd() * 0.01f), 16, YPos);
 		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("SideError: %f"), SideError), 16, YPos);
 		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("ObstacleDistance: %f"), CurrentObstacleDistance), 16, YPos);
+
+		const USodaTrafficAwareness* TrafficAwareness = GetWorld()->GetSubsystem<USodaTrafficAwareness>();
+		if (const FTrafficAwareness* Awareness = (bUseTrafficAwareness && TrafficAwareness) ? TrafficAwareness->GetAwareness(GetVehicle()) : nullptr)
+		{
+			if (Awareness->bOnLane)
+			{
+				YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Awareness: Lane: %i; Leader: %.1fm; Follower: %.1fm; Conflict: %.1fm"),
+					Awareness->Lane, Awareness->LeaderDistance * 0.01f, Awareness->FollowerDistance * 0.01f, Awareness->ConflictDistance * 0.01f), 16, YPos);
+			}
+			else
+			{
+				YPos += Canvas->DrawText(RenderFont, TEXT("Awareness: Off lane"), 16, YPos);
+			}
+		}
 	}
 }
 
@@ -248,3 +248,21 @@ void UVehicleBrakeSystemSimpleComponent::TickComponent(float DeltaTime, enum ELe
 		}
 	}
 }
+
+void UVehicleBrakeSystemSimpleComponent::SerializeSnapshot(FArchive& Ar)
+{
+	Super::SerializeSnapshot(Ar);
+
+	Ar << PedalPos;
+
+	int32 Num = WheelBrakes.Num();
+	Ar << Num;
+	if (Num != WheelBrakes.Num())
+	{
+		return;
+	}
+	for (UWheelBrakeSimple* WheelBrake : WheelBrakes)
+	{
+		Ar << WheelBrake->CurrentBar << WheelBrake->CurrentTorque;
+	}
+}
@@ -218,3 +218,10 @@ void UVehicleEngineSimpleComponent::DrawDebug(UCanvas* Canvas, float& YL, float&
 		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Pedal Pos: %.2f"), PedalPos), 16, YPos);
 	}
 }
+
+void UVehicleEngineSimpleComponent::SerializeSnapshot(FArchive& Ar)
+{
+	Super::SerializeSnapshot(Ar);
+
+	Ar << AngularVelocity << RequestedTorque << ActualTorque << PedalPos;
+}
@@ -342,3 +342,11 @@ void UVehicleGearBoxSimpleComponent::DrawDebug(UCanvas* Canvas, float& YL, float
 		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("OutAngVel: %.2f "), OutAngularVelocity), 16, YPos);
 	}
 }
+
+void UVehicleGearBoxSimpleComponent::SerializeSnapshot(FArchive& Ar)
+{
+	Super::SerializeSnapshot(Ar);
+
+	Ar << Ratio << CurrentGearState << TargetGearState << CurrentGearNum << TargetGearNum << CurrentGearChangeTime;
+	Ar << InTorq << OutTorq << InAngularVelocity << OutAngularVelocity;
+}
@@ -0,0 +1,545 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/VehicleComponents/Mechanicles/VehiclePowertrainComponent.h"
+#include "Soda/UnrealSoda.h"
+#include "Soda/SodaApp.h"
+#include "Soda/Vehicles/SodaWheeledVehicle.h"
+#include "Soda/VehicleComponents/VehicleInputComponent.h"
+#include "Engine/Canvas.h"
+#include "Engine/Engine.h"
+#include "UObject/ConstructorHelpers.h"
+
+DECLARE_CYCLE_STAT(TEXT("Powertrain Solver"), STAT_PowertrainSolver, STATGROUP_SodaVehicle);
+
+/********************************************************************************************************/
+
+void FPowertrainSolver::Reset(const FPowertrainParams& InParams)
+{
+	Params = InParams;
+	Output = FPowertrainOutput();
+
+	EngineAngularVelocity = Params.IdleAngularVelocity;
+	GearboxAngularVelocity = 0;
+	ShaftTwist = 0;
+	ClutchEngagement = 0;
+	bClutchLocked = false;
+	GearNum = 0;
+	TargetGearNum = 0;
+	GearChangeTimer = 0;
+	LastGearRequestId = 0;
+
+	Output.EngineAngularVelocity = EngineAngularVelocity;
+	Output.MaxTorque = GetMaxTorque(EngineAngularVelocity);
+}
+
+float FPowertrainSolver::GetGearRatio(int32 Gear) const
+{
+	if (Gear > 0 && Gear <= Params.ForwardGearRatios.Num())
+	{
+		return Params.ForwardGearRatios[Gear - 1];
+	}
+	else if (Gear < 0 && -Gear <= Params.ReverseGearRatios.Num())
+	{
+		return -Params.ReverseGearRatios[-Gear - 1];
+	}
+	return 0;
+}
+
+float FPowertrainSolver::GetMaxTorque(float AngularVelocity) const
+{
+	if (Params.TorqueLUT.Num() == 0)
+	{
+		return 0;
+	}
+
+	const float X = FMath::Abs(AngularVelocity) / Params.TorqueLUTStep;
+	const int32 Index = FMath::FloorToInt(X);
+	if (Index >= Params.TorqueLUT.Num() - 1)
+	{
+		return Params.TorqueLUT.Last();
+	}
+	return FMath::Lerp(Params.TorqueLUT[Index], Params.TorqueLUT[Index + 1], X - Index);
+}
+
+void FPowertrainSolver::UpdateGear(double DeltaTime, const FPowertrainInput& Input)
+{
+	if (Input.GearRequestId != LastGearRequestId)
+	{
+		LastGearRequestId = Input.GearRequestId;
+		if (Input.RequestedGearNum != TargetGearNum)
+		{
+			TargetGearNum = Input.RequestedGearNum;
+			GearChangeTimer = Params.GearChangeTime;
+		}
+	}
+	else if (Params.bAutomaticGears && GearNum > 0 && GearNum == TargetGearNum)
+	{
+		const float RPM = FMath::Abs(GearboxAngularVelocity) * ANG2RPM;
+		if (bClutchLocked && RPM > Params.ChangeUpRPM && GearNum < Params.ForwardGearRatios.Num())
+		{
+			TargetGearNum = GearNum + 1;
+			GearChangeTimer = Params.GearChangeTime;
+		}
+		else if (RPM < Params.ChangeDownRPM && GearNum > 1)
+		{
+			TargetGearNum = GearNum - 1;
+			GearChangeTimer = Params.GearChangeTime;
+		}
+	}
+
+	if (GearNum != TargetGearNum)
+	{
+		GearChangeTimer -= DeltaTime;
+		if (GearChangeTimer <= 0)
+		{
+			GearChangeTimer = 0;
+			GearNum = TargetGearNum;
+			bClutchLocked = false;
+
+			// Synchronizer: the input shaft takes the speed of the output shaft for the new ratio
+			const float WheelAngularVelocity = (Input.WheelAngularVelocity[0] + Input.WheelAngularVelocity[1]) * 0.5f;
+			GearboxAngularVelocity = WheelAngularVelocity * Params.FinalDriveRatio * GetGearRatio(GearNum);
+			ShaftTwist = 0;
+		}
+	}
+}
+
+void FPowertrainSolver::Step(double DeltaTime, const FPowertrainInput& Input)
+{
+	const float Dt = DeltaTime;
+	if (Dt <= 0)
+	{
+		return;
+	}
+
+	UpdateGear(DeltaTime, Input);
+
+	const float GearRatio = GetGearRatio(GearNum);
+	const float PinionAngularVelocity = (Input.WheelAngularVelocity[0] + Input.WheelAngularVelocity[1]) * 0.5f * Params.FinalDriveRatio;
+
+	/* Clutch engagement */
+	float TargetEngagement = (GearNum != 0 && GearNum == TargetGearNum) ? 1.f : 0.f;
+	if (Params.bAutomaticGears && Params.LaunchAngularVelocity > Params.IdleAngularVelocity && Params.IdleAngularVelocity > 0)
+	{
+		// Launch from the standstill like with the centrifugal clutch
+		TargetEngagement = FMath::Min(TargetEngagement, FMath::Clamp((EngineAngularVelocity - Params.IdleAngularVelocity) / (Params.LaunchAngularVelocity - Params.IdleAngularVelocity), 0.f, 1.f));
+	}
+	if (TargetEngagement > ClutchEngagement)
+	{
+		ClutchEngagement = FMath::Min(TargetEngagement, ClutchEngagement + Dt / FMath::Max(Params.ClutchEngageTime, Dt));
+	}
+	else
+	{
+		ClutchEngagement = FMath::Max(TargetEngagement, ClutchEngagement - 2.f * Dt / FMath::Max(Params.GearChangeTime, Dt));
+	}
+	const float ClutchCapacity = Params.ClutchMaxTorque * ClutchEngagement;
+
+	/* Engine torque */
+	const float MaxTorque = GetMaxTorque(EngineAngularVelocity);
+	float DemandTorque = Input.bByTorque ? FMath::Clamp(Input.RequestedTorque, -MaxTorque, MaxTorque) : FMath::Clamp(Input.Throttle, -1.f, 1.f) * MaxTorque;
+	if (Params.IdleAngularVelocity > 0)
+	{
+		DemandTorque = FMath::Max(DemandTorque, 0.f);
+		if (EngineAngularVelocity < Params.IdleAngularVelocity)
+		{
+			DemandTorque = FMath::Max(DemandTorque, FMath::Min(Params.IdleGain * (Params.IdleAngularVelocity - EngineAngularVelocity), MaxTorque));
+		}
+	}
+	const float EngineTorque = DemandTorque - Params.EngineFrictionTorque * FMath::Tanh(EngineAngularVelocity) - Params.EngineDamping * EngineAngularVelocity;
+
+	/*
+	 * Gearbox side, implicit Euler of:
+	 *   J * dW/dt = F - ShaftTorque / GearRatio
+	 *   ShaftTorque = K * Twist + C * (W / GearRatio - PinionAngularVelocity)
+	 *   dTwist/dt = W / GearRatio - PinionAngularVelocity
+	 */
+	const float K = Params.ShaftStiffness;
+	const float KC = K * Dt + Params.ShaftDamping;
+	auto SolveGearboxSide = [&](float Inertia, float AngularVelocity, float Torque)
+	{
+		if (GearRatio == 0)
+		{
+			return AngularVelocity + Dt * Torque / Inertia;
+		}
+		return (Inertia / Dt * AngularVelocity + Torque - (K * ShaftTwist - KC * PinionAngularVelocity) / GearRatio) / (Inertia / Dt + KC / (GearRatio * GearRatio));
+	};
+
+	const float Je = Params.EngineInertia;
+	const float Jg = Params.GearboxInertia;
+	float ClutchTorque = 0;
+
+	if (bClutchLocked && ClutchCapacity > 0)
+	{
+		const float W = SolveGearboxSide(Je + Jg, EngineAngularVelocity, EngineTorque);
+		ClutchTorque = EngineTorque - Je * (W - EngineAngularVelocity) / Dt;
+		EngineAngularVelocity = GearboxAngularVelocity = W;
+		if (FMath::Abs(ClutchTorque) > ClutchCapacity)
+		{
+			bClutchLocked = false;
+		}
+	}
+	else
+	{
+		bClutchLocked = false;
+		const float Slip = EngineAngularVelocity - GearboxAngularVelocity;
+		ClutchTorque = FMath::Sign(Slip) * ClutchCapacity;
+		float NewEngineAngularVelocity = EngineAngularVelocity + Dt * (EngineTorque - ClutchTorque) / Je;
+		float NewGearboxAngularVelocity = SolveGearboxSide(Jg, GearboxAngularVelocity, ClutchTorque);
+		if (ClutchCapacity > 0 && Slip * (NewEngineAngularVelocity - NewGearboxAngularVelocity) <= 0)
+		{
+			// The slip has crossed zero, lock the clutch conserving the momentum
+			NewEngineAngularVelocity = NewGearboxAngularVelocity = (Je * NewEngineAngularVelocity + Jg * NewGearboxAngularVelocity) / (Je + Jg);
+			bClutchLocked = true;
+		}
+		EngineAngularVelocity = NewEngineAngularVelocity;
+		GearboxAngularVelocity = NewGearboxAngularVelocity;
+	}
+
+	if (Params.IdleAngularVelocity > 0 && EngineAngularVelocity < 0)
+	{
+		EngineAngularVelocity = 0;
+	}
+
+	/* Shaft and open differential */
+	float ShaftTorque = 0;
+	if (GearRatio != 0)
+	{
+		const float ShaftRate = GearboxAngularVelocity / GearRatio - PinionAngularVelocity;
+		ShaftTwist += Dt * ShaftRate;
+		ShaftTorque = K * ShaftTwist + Params.ShaftDamping * ShaftRate;
+	}
+	else
+	{
+		ShaftTwist = 0;
+	}
+	const float WheelTorque = ShaftTorque * Params.FinalDriveRatio * Params.Efficiency * 0.5f;
+
+	Output.Time += DeltaTime;
+	Output.WheelImpulse[0] += WheelTorque * DeltaTime;
+	Output.WheelImpulse[1] += WheelTorque * DeltaTime;
+	Output.EngineAngularVelocity = EngineAngularVelocity;
+	Output.EngineTorque = DemandTorque;
+	Output.MaxTorque = MaxTorque;
+	Output.ClutchTorque = ClutchTorque;
+	Output.ClutchEngagement = ClutchEngagement;
+	Output.ShaftTorque = ShaftTorque;
+	Output.GearNum = GearNum;
+	Output.bClutchLocked = bClutchLocked;
+}
+
+void FPowertrainSolver::Serialize(FArchive& Ar)
+{
+	Ar << EngineAngularVelocity << GearboxAngularVelocity << ShaftTwist << ClutchEngagement << bClutchLocked;
+	Ar << GearNum << TargetGearNum << GearChangeTimer << LastGearRequestId;
+	Ar << Output.Time << Output.WheelImpulse[0] << Output.WheelImpulse[1];
+	Ar << Output.EngineAngularVelocity << Output.EngineTorque << Output.MaxTorque << Output.ClutchTorque;
+	Ar << Output.ClutchEngagement << Output.ShaftTorque << Output.GearNum << Output.bClutchLocked;
+}
+
+/********************************************************************************************************/
+
+UVehiclePowertrainComponent::UVehiclePowertrainComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	GUI.ComponentNameOverride = TEXT("Powertrain");
+	GUI.bIsPresentInAddMenu = true;
+
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+
+	TickData.bAllowVehiclePrePhysTick = true;
+	TickData.bAllowVehiclePostPhysTick = true;
+	TickData.PostPhysTickGroup = EVehicleComponentPostPhysTickGroup::TickGroup5;
+
+	LinkToTorqueTransmission = FSubobjectReference{ TEXT("WheelFL") };
+
+	ForwardGearRatios = { 3.5f, 2.1f, 1.4f, 1.0f, 0.8f };
+	ReverseGearRatios = { 3.2f };
+
+	static ConstructorHelpers::FObjectFinder<UCurveFloat> EngineCurevePtr(TEXT("/SodaSim/Assets/CPP/Curves/ElectricEngine/Engine_100Hm.Engine_100Hm"));
+	TorqueCurve.ExternalCurve = EngineCurevePtr.Object;
+}
+
+bool UVehiclePowertrainComponent::OnActivateVehicleComponent()
+{
+	if (!Super::OnActivateVehicleComponent())
+	{
+		return false;
+	}
+
+	UObject* TorqueTransmissionObject2 = LinkToTorqueTransmission2.GetObject<UObject>(GetOwner());
+	ITorqueTransmission* TorqueTransmissionInterface2 = Cast<ITorqueTransmission>(TorqueTransmissionObject2);
+	if (TorqueTransmissionObject2 && TorqueTransmissionInterface2)
+	{
+		OutputTorqueTransmission2.SetInterface(TorqueTransmissionInterface2);
+		OutputTorqueTransmission2.SetObject(TorqueTransmissionObject2);
+	}
+	else
+	{
+		SetHealth(EVehicleComponentHealth::Error, TEXT("Transmission2 isn't connected"));
+		return false;
+	}
+
+	const FRichCurve* RichCurve = TorqueCurve.GetRichCurveConst();
+	if (!RichCurve || RichCurve->GetNumKeys() == 0)
+	{
+		SetHealth(EVehicleComponentHealth::Error, TEXT("TorqueCurve isn't set"));
+		return false;
+	}
+
+	if (ForwardGearRatios.Num() == 0)
+	{
+		SetHealth(EVehicleComponentHealth::Error, TEXT("ForwardGearRatios is empty"));
+		return false;
+	}
+
+	FPowertrainParams Params;
+	float MinRPM, MaxRPM;
+	RichCurve->GetTimeRange(MinRPM, MaxRPM);
+	const int32 LUTSize = FMath::Clamp(FMath::CeilToInt(MaxRPM / ANG2RPM / Params.TorqueLUTStep) + 1, 2, 10000);
+	Params.TorqueLUT.SetNum(LUTSize);
+	for (int32 i = 0; i < LUTSize; ++i)
+	{
+		Params.TorqueLUT[i] = RichCurve->Eval(i * Params.TorqueLUTStep * ANG2RPM) * TorqueCurveMultiplier;
+	}
+	Params.EngineInertia = FMath::Max(EngineInertia, KINDA_SMALL_NUMBER);
+	Params.EngineFrictionTorque = EngineFrictionTorque;
+	Params.EngineDamping = EngineDamping;
+	Params.IdleAngularVelocity = IdleRPM / ANG2RPM;
+	Params.LaunchAngularVelocity = LaunchRPM / ANG2RPM;
+	Params.GearboxInertia = FMath::Max(GearboxInertia, KINDA_SMALL_NUMBER);
+	Params.ClutchMaxTorque = ClutchMaxTorque;
+	Params.ClutchEngageTime = ClutchEngageTime;
+	Params.ShaftStiffness = ShaftStiffness;
+	Params.ShaftDamping = ShaftDamping;
+	Params.FinalDriveRatio = FinalDriveRatio;
+	Params.Efficiency = Efficiency;
+	Params.ForwardGearRatios = ForwardGearRatios;
+	Params.ReverseGearRatios = ReverseGearRatios;
+	Params.bAutomaticGears = bUseAutomaticGears;
+	Params.ChangeUpRPM = ChangeUpRPM;
+	Params.ChangeDownRPM = ChangeDownRPM;
+	Params.GearChangeTime = GearChangeTime;
+	Solver.Reset(Params);
+
+	Input = FPowertrainInput();
+	Output = Solver.GetOutput();
+	WheelTorque[0] = WheelTorque[1] = 0;
+	LastInputGearState = EGearState::Neutral;
+	InputBuffer.WriteAndSwap(Input);
+	OutputBuffer.WriteAndSwap(Output);
+
+	bSynchronousSolver = SodaApp.IsSynchronousMode();
+	if (!bSynchronousSolver)
+	{
+		SolverTimer.TimerDelegate.BindUObject(this, &UVehiclePowertrainComponent::SolverTick);
+		SolverTimer.TimerStart(std::chrono::duration<double>(double(SolverTimeStep) / 1000.0), std::chrono::duration<float>(0));
+	}
+
+	return true;
+}
+
+void UVehiclePowertrainComponent::OnDeactivateVehicleComponent()
+{
+	SolverTimer.TimerStop();
+	SolverTimer.TimerDelegate.Unbind();
+
+	Super::OnDeactivateVehicleComponent();
+}
+
+void UVehiclePowertrainComponent::SolverTick(const std::chrono::nanoseconds& InDeltatime, const std::chrono::nanoseconds& Elapsed)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PowertrainSolver);
+
+	const double DeltaTime = std::chrono::duration_cast<std::chrono::duration<double>>(InDeltatime).count();
+	Solver.Step(DeltaTime, InputBuffer.SwapAndRead());
+	OutputBuffer.WriteAndSwap(Solver.GetOutput());
+}
+
+void UVehiclePowertrainComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	if (!IsTickOnCurrentFrame() || !HealthIsWorkable()) return;
+
+	UVehicleInputComponent* VehicleInput = GetWheeledVehicle()->GetActiveVehicleInput();
+
+	if (bAcceptPedalFromVehicleInput)
+	{
+		Input.Throttle = VehicleInput ? VehicleInput->GetInputState().Throttle : 0;
+		Input.bByTorque = false;
+	}
+
+	if (bAcceptGearFromVehicleInput && VehicleInput)
+	{
+		FWheeledVehicleInputState& InputState = VehicleInput->GetInputState();
+		if (InputState.GearInputMode == EGearInputMode::ByState && InputState.GearState != LastInputGearState)
+		{
+			LastInputGearState = InputState.GearState;
+			SetGearByState(InputState.GearState);
+		}
+		else if (InputState.GearInputMode == EGearInputMode::ByNum && InputState.GearNum != Input.RequestedGearNum)
+		{
+			SetGearByNum(InputState.GearNum);
+		}
+		if (InputState.bWasGearUpPressed)
+		{
+			SetGearByNum(GetGearNum() + 1);
+			InputState.bWasGearUpPressed = false;
+		}
+		if (InputState.bWasGearDownPressed)
+		{
+			SetGearByNum(GetGearNum() - 1);
+			InputState.bWasGearDownPressed = false;
+		}
+	}
+}
+
+void UVehiclePowertrainComponent::SetGearByNum(int InGearNum)
+{
+	if (InGearNum > ForwardGearRatios.Num() || -InGearNum > ReverseGearRatios.Num())
+	{
+		return;
+	}
+	Input.RequestedGearNum = InGearNum;
+	++Input.GearRequestId;
+}
+
+void UVehiclePowertrainComponent::SetGearByState(EGearState GearState)
+{
+	switch (GearState)
+	{
+	case EGearState::Drive:
+		if (GetGearNum() <= 0) SetGearByNum(1);
+		break;
+	case EGearState::Reverse:
+		if (GetGearNum() >= 0) SetGearByNum(-1);
+		break;
+	default:
+		SetGearByNum(0);
+		break;
+	}
+}
+
+void UVehiclePowertrainComponent::RequestByTorque(float InTorque)
+{
+	Input.RequestedTorque = InTorque;
+	Input.bByTorque = true;
+}
+
+void UVehiclePowertrainComponent::RequestByRatio(float InRatio)
+{
+	Input.Throttle = InRatio;
+	Input.bByTorque = false;
+}
+
+bool UVehiclePowertrainComponent::FindToWheelRatio(float& OutRatio) const
+{
+	const int32 Gear = Output.GearNum != 0 ? Output.GearNum : Input.RequestedGearNum;
+	if (Gear > 0 && Gear <= ForwardGearRatios.Num())
+	{
+		OutRatio = ForwardGearRatios[Gear - 1] * FinalDriveRatio;
+		return true;
+	}
+	else if (Gear < 0 && -Gear <= ReverseGearRatios.Num())
+	{
+		OutRatio = -ReverseGearRatios[-Gear - 1] * FinalDriveRatio;
+		return true;
+	}
+	return false;
+}
+
+void UVehiclePowertrainComponent::PrePhysicSimulation(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& Timestamp)
+{
+	Super::PrePhysicSimulation(DeltaTime, VehicleKinematic, Timestamp);
+
+	if (GetHealth() != EVehicleComponentHealth::Ok)
+	{
+		return;
+	}
+
+	FPowertrainOutput NewOutput;
+	if (bSynchronousSolver)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_PowertrainSolver);
+		const int32 Substeps = FMath::Max(1, FMath::RoundToInt(DeltaTime * 1000.f / SolverTimeStep));
+		for (int32 i = 0; i < Substeps; ++i)
+		{
+			Solver.Step(double(DeltaTime) / Substeps, Input);
+		}
+		NewOutput = Solver.GetOutput();
+	}
+	else
+	{
+		InputBuffer.WriteAndSwap(Input);
+		NewOutput = OutputBuffer.SwapAndRead();
+	}
+
+	// Mean torque over the solver steps done since the previous vehicle step
+	const double SolverDeltaTime = NewOutput.Time - Output.Time;
+	if (SolverDeltaTime > 0)
+	{
+		WheelTorque[0] = (NewOutput.WheelImpulse[0] - Output.WheelImpulse[0]) / SolverDeltaTime;
+		WheelTorque[1] = (NewOutput.WheelImpulse[1] - Output.WheelImpulse[1]) / SolverDeltaTime;
+	}
+	Output = NewOutput;
+
+	OutputTorqueTransmission->PassTorque(WheelTorque[0]);
+	OutputTorqueTransmission2->PassTorque(WheelTorque[1]);
+}
+
+void UVehiclePowertrainComponent::PostPhysicSimulation(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& Timestamp)
+{
+	Super::PostPhysicSimulation(DeltaTime, VehicleKinematic, Timestamp);
+
+	if (GetHealth() == EVehicleComponentHealth::Ok)
+	{
+		Input.WheelAngularVelocity[0] = OutputTorqueTransmission->ResolveAngularVelocity();
+		Input.WheelAngularVelocity[1] = OutputTorqueTransmission2->ResolveAngularVelocity();
+	}
+
+	SyncDataset();
+}
+
+void UVehiclePowertrainComponent::DrawDebug(UCanvas* Canvas, float& YL, float& YPos)
+{
+	Super::DrawDebug(Canvas, YL, YPos);
+
+	if (Common.bDrawDebugCanvas)
+	{
+		UFont* RenderFont = GEngine->GetSmallFont();
+		Canvas->SetDrawColor(FColor::White);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Solver: %s, %.2f ms, t=%.2f s"), bSynchronousSolver ? TEXT("sync") : TEXT("thread"), SolverTimeStep, Output.Time), 16, YPos);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Gear: %i"), Output.GearNum), 16, YPos);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Engine: %.0f rpm, %.2f / %.2f H/m"), Output.EngineAngularVelocity * ANG2RPM, Output.EngineTorque, Output.MaxTorque), 16, YPos);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Clutch: %s, %.2f, %.2f H/m"), Output.bClutchLocked ? TEXT("locked") : TEXT("slip"), Output.ClutchEngagement, Output.ClutchTorque), 16, YPos);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Shaft: %.2f H/m"), Output.ShaftTorque), 16, YPos);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Wheels: %.2f / %.2f H/m"), WheelTorque[0], WheelTorque[1]), 16, YPos);
+	}
+}
+
+void UVehiclePowertrainComponent::SerializeSnapshot(FArchive& Ar)
+{
+	Super::SerializeSnapshot(Ar);
+
+	// The state of the solver thread can't be captured consistently, so it is saved only in the synchronous mode
+	bool bHasSolverState = bSynchronousSolver;
+	Ar << bHasSolverState;
+	if (bHasSolverState)
+	{
+		if (bSynchronousSolver)
+		{
+			Solver.Serialize(Ar);
+			if (Ar.IsLoading())
+			{
+				Output = Solver.GetOutput();
+			}
+		}
+		else
+		{
+			FPowertrainSolver Skipped;
+			Skipped.Serialize(Ar);
+		}
+		Ar << WheelTorque[0] << WheelTorque[1];
+	}
+	Ar << Input.Throttle << Input.RequestedTorque << Input.bByTorque << Input.GearRequestId << Input.RequestedGearNum;
+}
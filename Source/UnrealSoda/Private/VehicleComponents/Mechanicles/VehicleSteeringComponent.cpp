@@ -135,3 +135,10 @@ void UVehicleSteeringRackSimpleComponent::TickComponent(float DeltaTime, enum EL
 		}
 	}
 }
+
+void UVehicleSteeringRackSimpleComponent::SerializeSnapshot(FArchive& Ar)
+{
+	Super::SerializeSnapshot(Ar);
+
+	Ar << CurrentSteerAng << TargetSteerAng << SteerInputRatio;
+}
@@ -2,10 +2,107 @@
 
 #include "Soda/VehicleComponents/Others/CsvLogger.h"
 #include "Soda/UnrealSoda.h"
-#include "Soda/VehicleComponents/VehicleDriverComponent.h"
-#include "Soda/VehicleComponents/VehicleInputComponent.h"
+#include "Soda/VehicleComponents/SodaVehicleWheel.h"
 #include "Soda/Vehicles/SodaWheeledVehicle.h"
-#include "DrawDebugHelpers.h"
+#include "Misc/Paths.h"
+#include "Engine/Canvas.h"
+#include "Engine/Engine.h"
+
+DECLARE_STATS_GROUP(TEXT("VehicleLogger"), STATGROUP_VehicleLogger, STATGROUP_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Sample row"), STAT_VehicleLoggerSample, STATGROUP_VehicleLogger);
+
+using FPropertyColumn = UCSVLoggerComponent::FPropertyColumn;
+
+/** Address of the Step value in the Container. The object property is followed, so the object is returned. Null if the path is broken */
+static void* ResolveStep(void* Container, const FPropertyColumn::FStep& Step, const FProperty*& OutValueProperty)
+{
+	const FProperty* Property = Step.Property;
+	void* Value = nullptr;
+
+	const FArrayProperty* ArrayProperty = CastField<FArrayProperty>(Property);
+	if (ArrayProperty && Step.Index != INDEX_NONE)
+	{
+		FScriptArrayHelper Helper(ArrayProperty, ArrayProperty->ContainerPtrToValuePtr<void>(Container));
+		if (!Helper.IsValidIndex(Step.Index))
+		{
+			return nullptr;
+		}
+		Value = Helper.GetRawPtr(Step.Index);
+		Property = ArrayProperty->Inner;
+	}
+	else
+	{
+		if (Step.Index >= Property->ArrayDim)
+		{
+			return nullptr;
+		}
+		Value = Property->ContainerPtrToValuePtr<void>(Container, FMath::Max(Step.Index, 0));
+	}
+
+	OutValueProperty = Property;
+	if (const FObjectPropertyBase* ObjectProperty = CastField<FObjectPropertyBase>(Property))
+	{
+		return ObjectProperty->GetObjectPropertyValue(Value);
+	}
+	return Value;
+}
+
+static bool IsNumericProperty(const FProperty* Property)
+{
+	return CastField<FNumericProperty>(Property) || CastField<FBoolProperty>(Property) || CastField<FEnumProperty>(Property);
+}
+
+static double ReadNumericProperty(const FProperty* Property, const void* Value)
+{
+	if (const FNumericProperty* NumericProperty = CastField<FNumericProperty>(Property))
+	{
+		return NumericProperty->IsFloatingPoint() ? NumericProperty->GetFloatingPointPropertyValue(Value) : double(NumericProperty->GetSignedIntPropertyValue(Value));
+	}
+	if (const FBoolProperty* BoolProperty = CastField<FBoolProperty>(Property))
+	{
+		return BoolProperty->GetPropertyValue(Value) ? 1.0 : 0.0;
+	}
+	if (const FEnumProperty* EnumProperty = CastField<FEnumProperty>(Property))
+	{
+		return double(EnumProperty->GetUnderlyingProperty()->GetSignedIntPropertyValue(Value));
+	}
+	return std::numeric_limits<double>::quiet_NaN();
+}
+
+double UCSVLoggerComponent::FPropertyColumn::Read() const
+{
+	void* Container = Root.Get();
+	const FProperty* ValueProperty = nullptr;
+	for (const FStep& Step : Steps)
+	{
+		if (!Container)
+		{
+			return std::numeric_limits<double>::quiet_NaN();
+		}
+		Container = ResolveStep(Container, Step, ValueProperty);
+	}
+	return Container ? ReadNumericProperty(ValueProperty, Container) : std::numeric_limits<double>::quiet_NaN();
+}
+
+/** Add the column for the numeric value or the columns for every numeric field of the struct */
+static void ExpandPropertyColumns(const FPropertyColumn& Column, const FProperty* ValueProperty, const FString& Name, const FString& Source,
+	TArray<FPropertyColumn>& OutPropertyColumns, TArray<soda::FChannelLogWriter::FColumn>& OutColumns)
+{
+	if (const FStructProperty* StructProperty = CastField<FStructProperty>(ValueProperty))
+	{
+		for (TFieldIterator<FProperty> It(StructProperty->Struct); It; ++It)
+		{
+			FPropertyColumn Field = Column;
+			Field.Steps.Add({ *It, INDEX_NONE });
+			ExpandPropertyColumns(Field, *It, Name + TEXT(".") + It->GetName(), Source + TEXT(".") + It->GetName(), OutPropertyColumns, OutColumns);
+		}
+	}
+	else if (IsNumericProperty(ValueProperty) && ValueProperty->ArrayDim == 1)
+	{
+		OutPropertyColumns.Add(Column);
+		OutColumns.Add({ Name, Source });
+	}
+}
 
 UCSVLoggerComponent::UCSVLoggerComponent(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -14,162 +111,230 @@ UCSVLoggerComponent::UCSVLoggerComponent(const FObjectInitializer& ObjectInitial
 	GUI.ComponentNameOverride = TEXT("CSV Logger");
 	GUI.bIsPresentInAddMenu = true;
 
-	TickData.bAllowVehiclePostDeferredPhysTick = true;
+	TickData.bAllowVehiclePostPhysTick = true;
 }
 
-
-void UCSVLoggerComponent::PostPhysicSimulationDeferred(float DeltaTimeIn, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& TimestampIn)
+bool UCSVLoggerComponent::AddPropertyColumns(UObject* Root, const FString& Name, const FString& PropertyPath, TArray<soda::FChannelLogWriter::FColumn>& OutColumns)
 {
-	Super::PostPhysicSimulationDeferred(DeltaTimeIn, VehicleKinematic, TimestampIn);
-
-	/*
-	if (Health != EVehicleComponentHealth::Ok) return;
->>>>>>> release_0.12.0:Source/UnrealSoda/Private/VehicleComponents/Others/CsvLogger.cpp
-
-	FTransform WorldPose;
-	FVector WorldVel;
-	FVector LocalAcc;
-	FVector Gyro;
-	VehicleKinematic.CalcIMU(GetRelativeTransform(), WorldPose, WorldVel, LocalAcc, Gyro);
-
-	auto DeltaTime = TimestampIn - PrevTimestamp;
-	PrevTimestamp = TimestampIn;
+	TArray<FString> Tokens;
+	PropertyPath.ParseIntoArray(Tokens, TEXT("."));
 
-	auto LogDeltaTime = TimestampIn - PrevLoggedTimeMark;
-	const std::chrono::nanoseconds Period2((int64)(Period * 1000));
+	FPropertyColumn Column;
+	Column.Root = Root;
+	void* Container = Root;
+	const UStruct* Struct = Root->GetClass();
+	const FProperty* ValueProperty = nullptr;
 
-	if (LogDeltaTime < Period2)
-		return;
+	for (const FString& Token : Tokens)
+	{
+		if (!Container || !Struct)
+		{
+			return false;
+		}
 
-	if (LogDeltaTime < Period2)
-		PrevLoggedTimeMark += Period2;
-	else
-		PrevLoggedTimeMark = TimestampIn;
+		FString PropertyName = Token;
+		FPropertyColumn::FStep Step;
+		int32 Bracket;
+		if (PropertyName.FindChar(TEXT('['), Bracket))
+		{
+			Step.Index = FCString::Atoi(*PropertyName.Mid(Bracket + 1));
+			PropertyName.LeftInline(Bracket);
+		}
 
-	FVector WorldLoc = GetComponentLocation();
-	FRotator WorldRot = GetComponentRotation();
-	FVector LocalVel = WorldPose.Rotator().UnrotateVector(WorldVel);
+		Step.Property = FindFProperty<FProperty>(Struct, *PropertyName);
+		if (!Step.Property)
+		{
+			return false;
+		}
+		Column.Steps.Add(Step);
 
-	float DeltaTravel = (WorldLoc - PrevLocaion).Size() / 100;
-	PrevLocaion = WorldLoc;
+		Container = ResolveStep(Container, Step, ValueProperty);
+		if (const FStructProperty* StructProperty = CastField<FStructProperty>(ValueProperty))
+		{
+			Struct = StructProperty->Struct;
+		}
+		else if (CastField<FObjectPropertyBase>(ValueProperty))
+		{
+			Struct = Container ? static_cast<UObject*>(Container)->GetClass() : nullptr;
+		}
+		else
+		{
+			Struct = nullptr;
+		}
+	}
 
-	UVehicleInputComponent* VehicleInput = WheeledVehicle->GetActiveVehicleInput();
-	
-	if (VehicleInput)
+	if (!Container || !ValueProperty)
 	{
-		DistanceTravelled += DeltaTravel;
-
-		float VelMPH = (fabs(LocalVel.X) / 100) * 2.23694f; // convert to mph 
+		return false;
+	}
 
-		TimeTravelled += DeltaTime;
+	const int32 ColumnsNum = OutColumns.Num();
+	ExpandPropertyColumns(Column, ValueProperty, Name, Root->GetName() + TEXT(".") + PropertyPath, PropertyColumns, OutColumns);
+	return OutColumns.Num() > ColumnsNum;
+}
 
-		FVector Travel = WorldLoc - StartLocation;
+bool UCSVLoggerComponent::OnActivateVehicleComponent()
+{
+	if (!Super::OnActivateVehicleComponent())
+	{
+		return false;
+	}
 
-		FString Output;
-		Output += FString::FromInt(TimeTravelled) + ", ";
-		Output += FString::SanitizeFloat(DistanceTravelled) + ", ";
-		Output += FString(LocalVel.X > 0.f ? "Forward" : "Backward") + ", ";
-		Output += FString::SanitizeFloat(VelMPH) + ", ";
-		Output += FString::SanitizeFloat(LocalAcc.X / 100) + ", ";
-		Output += FString::SanitizeFloat(Travel.X / 100) + ", " + FString::SanitizeFloat(Travel.Y / 100) + ", ";
-		Output += FString::SanitizeFloat(LocalAcc.Y / 100) + ", ";
-		Output += FString::SanitizeFloat(VehicleInput->GetThrottleInput() * 100) + ", ";
-		Output += FString::SanitizeFloat(VehicleInput->GetBrakeInput() * 100) + ", ";
-		Output += FString::SanitizeFloat(VehicleInput->GetSteeringInput() * 100) + ", ";
+	PropertyColumns.Reset();
+	TArray<soda::FChannelLogWriter::FColumn> Columns;
 
-		switch (VehicleInput->GetGearStateInput())
+	if (bLogKinematic)
+	{
+		for (const TCHAR* Name : {
+			TEXT("Kinematic.Location.X"), TEXT("Kinematic.Location.Y"), TEXT("Kinematic.Location.Z"),
+			TEXT("Kinematic.Rotation.Roll"), TEXT("Kinematic.Rotation.Pitch"), TEXT("Kinematic.Rotation.Yaw"),
+			TEXT("Kinematic.LocalVelocity.X"), TEXT("Kinematic.LocalVelocity.Y"), TEXT("Kinematic.LocalVelocity.Z"),
+			TEXT("Kinematic.LocalAcceleration.X"), TEXT("Kinematic.LocalAcceleration.Y"), TEXT("Kinematic.LocalAcceleration.Z"),
+			TEXT("Kinematic.AngularVelocity.X"), TEXT("Kinematic.AngularVelocity.Y"), TEXT("Kinematic.AngularVelocity.Z") })
 		{
-		case EGearState::Park:
-			Output += "Park";
-			break;
+			Columns.Add({ Name, TEXT("FPhysBodyKinematic") });
+		}
+	}
 
-		case EGearState::Reverse:
-			Output += "Reverse";
-			break;
+	if (bLogWheels && WheeledVehicle)
+	{
+		for (USodaVehicleWheelComponent* Wheel : WheeledVehicle->GetWheelsSorted())
+		{
+			for (const TCHAR* Property : { TEXT("AngularVelocity"), TEXT("Steer"), TEXT("ReqTorq"), TEXT("ReqBrakeTorque") })
+			{
+				AddPropertyColumns(Wheel, Wheel->GetName() + TEXT(".") + Property, Property, Columns);
+			}
+		}
+	}
 
-		case EGearState::Neutral:
-			Output += "Neutral";
-			break;
+	for (const FVehicleLogChannel& Channel : Channels)
+	{
+		FString RootName, PropertyPath;
+		if (!Channel.Path.Split(TEXT("."), &RootName, &PropertyPath))
+		{
+			AddDebugMessage(EVehicleComponentHealth::Warning, FString::Printf(TEXT("Wrong channel path \"%s\""), *Channel.Path));
+			continue;
+		}
 
-		case EGearState::Drive:
-			Output += "Drive";
-			break;
+		UObject* Root = nullptr;
+		if (RootName == TEXT("Vehicle"))
+		{
+			Root = GetOwner();
+		}
+		else
+		{
+			for (UActorComponent* Component : GetOwner()->GetComponents())
+			{
+				if (Component->GetName() == RootName)
+				{
+					Root = Component;
+					break;
+				}
+			}
 		}
 
-		if (bAddTimeMarkToNextTick)
+		if (!Root || !AddPropertyColumns(Root, Channel.Name.IsEmpty() ? Channel.Path : Channel.Name, PropertyPath, Columns))
 		{
-			Output += FString::Printf(TEXT(", %lld"), TimestampIn);
-			bAddTimeMarkToNextTick = false;
+			AddDebugMessage(EVehicleComponentHealth::Warning, FString::Printf(TEXT("Can't resolve the channel \"%s\""), *Channel.Path));
 		}
+	}
+
+	FString FileName = FileNameBase + TEXT("_") + FDateTime::Now().ToString(TEXT("%Y%m%d_%H%M%S")) + (Format == EVehicleLogFormat::CSVGzip ? TEXT(".csv.gz") : TEXT(".csv"));
+	if (FPaths::IsRelative(FileName))
+	{
+		FileName = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("VehicleLogs"), FileName);
+	}
 
-		CsvOutFile << TCHAR_TO_UTF8(*Output) << "\n";
-		if (bDrawDebugCanvas)
-			UE_LOG(LogSoda, Log, TEXT("UCSVLoggerComponent: %s"), *Output);
+	LogWriter = MakeUnique<soda::FChannelLogWriter>(BufferSize);
+	if (!LogWriter->Open(FileName, Format == EVehicleLogFormat::CSVGzip ? soda::EChannelLogFormat::CSVGzip : soda::EChannelLogFormat::CSV, Columns))
+	{
+		LogWriter.Reset();
+		SetHealth(EVehicleComponentHealth::Error, TEXT("Can't open the log file"));
+		return false;
 	}
-	*/
+
+	TimeFromLastRow = 0;
+
+	return true;
+}
+
+void UCSVLoggerComponent::OnDeactivateVehicleComponent()
+{
+	Super::OnDeactivateVehicleComponent();
+
+	LogWriter.Reset();
+	PropertyColumns.Reset();
 }
 
-void UCSVLoggerComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+void UCSVLoggerComponent::PostPhysicSimulation(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& Timestamp)
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-	if (!IsTickOnCurrentFrame() || !HealthIsWorkable()) return;
+	Super::PostPhysicSimulation(DeltaTime, VehicleKinematic, Timestamp);
 
-	/*
-	if (!IsTickOnCurrentFrame()) return;
+	SCOPE_CYCLE_COUNTER(STAT_VehicleLoggerSample);
 
-	if (GetHealth() == EVehicleComponentHealth::Ok)
-		GEngine->AddOnScreenDebugMessage(INDEX_NONE, 0.f, FColor::Red, FString("DATALOG REC"));
+	if (!LogWriter)
+	{
+		return;
+	}
 
-	UWorld* World = GetWorld();
-	APlayerController* PlayerController = World->GetFirstPlayerController();
-	if ((PlayerController != nullptr) && (WheeledVehicle != nullptr) && (WheeledVehicle->IsPlayerControlled()))
+	if (Period > 0)
 	{
-		if (PlayerController->WasInputKeyJustPressed(ToggleKeyInput))
+		TimeFromLastRow += DeltaTime;
+		if (TimeFromLastRow + KINDA_SMALL_NUMBER < Period)
 		{
-			Toggle();
+			return;
 		}
-
-		bAddTimeMarkToNextTick = PlayerController->WasInputKeyJustPressed(PutTimeMarkKeyInput);
+		TimeFromLastRow = FMath::Min(TimeFromLastRow - Period, Period);
 	}
-	*/
 
-}
-
-bool UCSVLoggerComponent::OnActivateVehicleComponent()
-{
-	if (!Super::OnActivateVehicleComponent())
+	double* Row = LogWriter->BeginRow(Timestamp);
+	if (!Row)
 	{
-		return false;
+		return;
 	}
 
-	/*
-
-	CsvOutFile.close();
-
-	FString Filename = CvsFileNameBase;
-	Filename.Appendf(TEXT("_%d.csv"), CvsFileNameIndex);
-	CsvOutFile.open(TCHAR_TO_UTF8(*Filename), std::ofstream::out);
-
-	if (CsvOutFile.is_open())
+	if (bLogKinematic)
 	{
-		CsvOutFile << "Time travelled (ms), Distance travelled (m), Movement direction, Speed(mph), Longitudinal acceleration (m/s2), Movement of the vehicle relative to the starting position (X Y) (m), Lateral acceleration(m/s2), Throttle input(%), Brake input(%), Steering wheel input(%), Gear, TimeMark\n";
-		CvsFileNameIndex++;
+		const FPhysBodyKinematic::FState& State = VehicleKinematic.Curr;
+		const FVector Location = State.GlobalPose.GetLocation();
+		const FRotator Rotation = State.GlobalPose.Rotator();
+		const FVector LocalVelocity = State.GetLocalVelocity();
+		const FVector LocalAcceleration = State.GetLocalAcceleration();
+		for (double Value : {
+			Location.X, Location.Y, Location.Z,
+			Rotation.Roll, Rotation.Pitch, Rotation.Yaw,
+			LocalVelocity.X, LocalVelocity.Y, LocalVelocity.Z,
+			LocalAcceleration.X, LocalAcceleration.Y, LocalAcceleration.Z,
+			State.AngularVelocity.X, State.AngularVelocity.Y, State.AngularVelocity.Z })
+		{
+			*Row++ = Value;
+		}
 	}
-	else
+
+	for (const FPropertyColumn& Column : PropertyColumns)
 	{
-		SetHealth(EVehicleComponentHealth::Error);
-		return false;
+		*Row++ = Column.Read();
 	}
-	*/
 
-	return true;
+	LogWriter->CommitRow();
 }
 
-void UCSVLoggerComponent::OnDeactivateVehicleComponent()
+void UCSVLoggerComponent::DrawDebug(UCanvas* Canvas, float& YL, float& YPos)
 {
-	Super::OnDeactivateVehicleComponent();
+	Super::DrawDebug(Canvas, YL, YPos);
+
+	if (Common.bDrawDebugCanvas && LogWriter)
+	{
+		UFont* RenderFont = GEngine->GetSmallFont();
+		Canvas->SetDrawColor(FColor::White);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("File: %s"), *FPaths::GetCleanFilename(LogWriter->GetFileName())), 16, YPos);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Columns: %d"), LogWriter->GetColumnsNum()), 16, YPos);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Rows: %lld; dropped: %lld"), LogWriter->GetWrittenRows(), LogWriter->GetDroppedRows()), 16, YPos);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Written: %.2f MB"), LogWriter->GetWrittenBytes() / (1024.0 * 1024.0)), 16, YPos);
+	}
+}
 
-	/*
-	CsvOutFile.close();
-	*/
-}
\ No newline at end of file
+FString UCSVLoggerComponent::GetRemark() const
+{
+	return LogWriter ? FPaths::GetCleanFilename(LogWriter->GetFileName()) : TEXT("");
+}
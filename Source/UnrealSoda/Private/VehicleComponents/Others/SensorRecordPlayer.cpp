@@ -0,0 +1,293 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/VehicleComponents/Others/SensorRecordPlayer.h"
+#include "Soda/UnrealSoda.h"
+#include "Soda/GenericPublishers/RecordingPublishers.h"
+#include "Soda/VehicleComponents/Sensors/Base/CameraSensor.h"
+#include "Soda/VehicleComponents/Sensors/Base/NavSensor.h"
+#include "Soda/VehicleComponents/Sensors/Base/RacingSensor.h"
+#include "Soda/VehicleComponents/Sensors/Base/RadarSensor.h"
+#include "Soda/VehicleComponents/Sensors/Base/UltrasonicSensor.h"
+#include "Serialization/MemoryReader.h"
+#include "Misc/Paths.h"
+#include "Engine/Canvas.h"
+#include "Engine/Engine.h"
+
+static UClass* GetPublisherClass(soda::ESensorRecordPayload Payload)
+{
+	switch (Payload)
+	{
+	case soda::ESensorRecordPayload::Camera: return UGenericCameraPublisher::StaticClass();
+	case soda::ESensorRecordPayload::Lidar: return UGenericLidarPublisher::StaticClass();
+	case soda::ESensorRecordPayload::Nav: return UGenericNavPublisher::StaticClass();
+	case soda::ESensorRecordPayload::Racing: return UGenericRacingPublisher::StaticClass();
+	case soda::ESensorRecordPayload::Radar: return UGenericRadarPublisher::StaticClass();
+	case soda::ESensorRecordPayload::Ultrasonic: return UGenericUltrasoncHubPublisher::StaticClass();
+	default: return nullptr;
+	}
+}
+
+USensorRecordPlayerComponent::USensorRecordPlayerComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	GUI.Category = TEXT("Other");
+	GUI.ComponentNameOverride = TEXT("Sensor Record Player");
+	GUI.bIsPresentInAddMenu = true;
+
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+}
+
+bool USensorRecordPlayerComponent::OnActivateVehicleComponent()
+{
+	if (!Super::OnActivateVehicleComponent())
+	{
+		return false;
+	}
+
+	FString FullFileName = FileName;
+	if (FPaths::IsRelative(FullFileName))
+	{
+		FullFileName = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("SensorRecords"), FullFileName);
+	}
+
+	if (!Reader.Open(FullFileName))
+	{
+		SetHealth(EVehicleComponentHealth::Error, TEXT("Can't open the record"));
+		return false;
+	}
+
+	StreamPublishers.Init(nullptr, Reader.GetStreams().Num());
+	for (int32 StreamId = 0; StreamId < Reader.GetStreams().Num(); ++StreamId)
+	{
+		const soda::FSensorRecordReader::FStream& Stream = Reader.GetStreams()[StreamId];
+		const FSensorRecordReplayTarget* Target = Targets.FindByPredicate([&Stream](const FSensorRecordReplayTarget& It) { return It.StreamName == Stream.Name; });
+		if (!Target || !IsValid(Target->Publisher))
+		{
+			continue;
+		}
+
+		UClass* PublisherClass = GetPublisherClass(Stream.Payload);
+		if (!PublisherClass)
+		{
+			AddDebugMessage(EVehicleComponentHealth::Warning, FString::Printf(TEXT("\"%s\": %s stream can't be replayed"), *Stream.Name, soda::ToString(Stream.Payload)));
+			continue;
+		}
+
+		if (!Target->Publisher->IsA(PublisherClass))
+		{
+			AddDebugMessage(EVehicleComponentHealth::Warning, FString::Printf(TEXT("\"%s\": %s publisher is expected"), *Stream.Name, *PublisherClass->GetName()));
+			continue;
+		}
+
+		StreamPublishers[StreamId] = Target->Publisher;
+	}
+
+	for (auto& Target : Targets)
+	{
+		if (IsValid(Target.Publisher) && StreamPublishers.Contains(Target.Publisher))
+		{
+			Target.Publisher->AdvertiseAndSetHealth(this);
+		}
+	}
+
+	SeekReplay(StartTime);
+
+	return true;
+}
+
+void USensorRecordPlayerComponent::OnDeactivateVehicleComponent()
+{
+	Super::OnDeactivateVehicleComponent();
+
+	for (auto& Target : Targets)
+	{
+		if (IsValid(Target.Publisher))
+		{
+			Target.Publisher->Shutdown();
+		}
+	}
+
+	StreamPublishers.Empty();
+	Reader.Close();
+}
+
+bool USensorRecordPlayerComponent::IsVehicleComponentInitializing() const
+{
+	for (const auto& Target : Targets)
+	{
+		if (IsValid(Target.Publisher) && Target.Publisher->IsInitializing())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void USensorRecordPlayerComponent::RestartReplay()
+{
+	SeekReplay(0);
+}
+
+void USensorRecordPlayerComponent::SeekReplay(float Time)
+{
+	PlaybackTime = FMath::Max(Time, 0.f);
+	NextFrame = Reader.FindFrame(PlaybackTime);
+}
+
+void USensorRecordPlayerComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (!HealthIsWorkable() || !Reader.IsOpen())
+	{
+		return;
+	}
+
+	for (auto& Target : Targets)
+	{
+		if (IsValid(Target.Publisher) && StreamPublishers.Contains(Target.Publisher))
+		{
+			Target.Publisher->CheckStatus(this);
+		}
+	}
+
+	const TArray<soda::FSensorRecordReader::FFrame>& Frames = Reader.GetFrames();
+	if (!Frames.Num())
+	{
+		return;
+	}
+
+	if (NextFrame >= Frames.Num() && bLoop)
+	{
+		RestartReplay();
+	}
+
+	if (Pacing == ESensorRecordPacing::OriginalTiming)
+	{
+		PlaybackTime += DeltaTime * FMath::Max(PlaybackRate, 0.f);
+		const TTimestamp PlaybackTimestamp = soda::AddSeconds(Frames[0].Timestamp, PlaybackTime);
+		while (NextFrame < Frames.Num() && Frames[NextFrame].Timestamp <= PlaybackTimestamp)
+		{
+			ReplayFrame(Frames[NextFrame++]);
+		}
+	}
+	else
+	{
+		const int32 LastFrame = FMath::Min(NextFrame + FMath::Max(MaxFramesPerTick, 1), Frames.Num());
+		while (NextFrame < LastFrame)
+		{
+			ReplayFrame(Frames[NextFrame++]);
+		}
+		PlaybackTime = std::chrono::duration<double>(Frames[NextFrame - 1].Timestamp - Frames[0].Timestamp).count();
+	}
+}
+
+bool USensorRecordPlayerComponent::ReplayFrame(const soda::FSensorRecordReader::FFrame& Frame)
+{
+	UGenericPublisher* Publisher = StreamPublishers[Frame.StreamId];
+	if (!Publisher || !Publisher->IsOk())
+	{
+		return false;
+	}
+
+	FMemoryReaderView Ar(TArrayView<const uint8>(Frame.Data, Frame.Size));
+	const FSensorDataHeader Header{ Frame.Timestamp, Frame.FrameIndex };
+	bool bPublished = false;
+
+	switch (Reader.GetStreams()[Frame.StreamId].Payload)
+	{
+	case soda::ESensorRecordPayload::Camera:
+	{
+		FCameraFrame CameraFrame;
+		uint32 ImageStride = 0;
+		soda::SerializeRecord(Ar, CameraFrame, CameraPixels, ImageStride);
+		bPublished = !Ar.IsError() && CastChecked<UGenericCameraPublisher>(Publisher)->Publish(Frame.DeltaTime, Header, CameraFrame, CameraPixels, ImageStride);
+		break;
+	}
+
+	case soda::ESensorRecordPayload::Lidar:
+	{
+		soda::SerializeRecord(Ar, LidarScan);
+		bPublished = !Ar.IsError() && CastChecked<UGenericLidarPublisher>(Publisher)->Publish(Frame.DeltaTime, Header, LidarScan);
+		break;
+	}
+
+	case soda::ESensorRecordPayload::Nav:
+	{
+		FTransform RelativeTransform;
+		FPhysBodyKinematic VehicleKinematic;
+		FImuNoiseParams Covariance;
+		soda::SerializeRecord(Ar, RelativeTransform, VehicleKinematic, Covariance);
+		bPublished = !Ar.IsError() && CastChecked<UGenericNavPublisher>(Publisher)->Publish(Frame.DeltaTime, Header, RelativeTransform, VehicleKinematic, Covariance);
+		break;
+	}
+
+	case soda::ESensorRecordPayload::Racing:
+	{
+		soda::FRacingSensorData SensorData{};
+		soda::SerializeRecord(Ar, SensorData);
+		bPublished = !Ar.IsError() && CastChecked<UGenericRacingPublisher>(Publisher)->Publish(Frame.DeltaTime, Header, SensorData);
+		break;
+	}
+
+	case soda::ESensorRecordPayload::Radar:
+	{
+		TArray<FRadarParams> Params;
+		FRadarClusters Clusters;
+		FRadarObjects Objects;
+		soda::SerializeRecord(Ar, Params, Clusters, Objects);
+		bPublished = !Ar.IsError() && CastChecked<UGenericRadarPublisher>(Publisher)->Publish(Frame.DeltaTime, Header, Params, Clusters, Objects);
+		break;
+	}
+
+	case soda::ESensorRecordPayload::Ultrasonic:
+	{
+		TArray<FUltrasonicEchos> EchoCollections;
+		soda::SerializeRecord(Ar, EchoCollections);
+		bPublished = !Ar.IsError() && CastChecked<UGenericUltrasoncHubPublisher>(Publisher)->Publish(Frame.DeltaTime, Header, EchoCollections);
+		break;
+	}
+
+	default:
+		break;
+	}
+
+	if (bPublished)
+	{
+		++ReplayedFrames;
+	}
+	return bPublished;
+}
+
+void USensorRecordPlayerComponent::DrawDebug(UCanvas* Canvas, float& YL, float& YPos)
+{
+	Super::DrawDebug(Canvas, YL, YPos);
+
+	if (Common.bDrawDebugCanvas)
+	{
+		UFont* RenderFont = GEngine->GetSmallFont();
+		Canvas->SetDrawColor(FColor::White);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Time: %.2f / %.2f s"), PlaybackTime, Reader.GetDuration()), 16, YPos);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Frames: %d / %d; published: %lld"), NextFrame, Reader.GetFrames().Num(), ReplayedFrames), 16, YPos);
+		for (int32 StreamId = 0; StreamId < Reader.GetStreams().Num(); ++StreamId)
+		{
+			const auto& Stream = Reader.GetStreams()[StreamId];
+			YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("  \"%s\" %s: %s"), *Stream.Name, soda::ToString(Stream.Payload),
+				StreamPublishers[StreamId] ? (StreamPublishers[StreamId]->IsOk() ? TEXT("ok") : TEXT("publisher isn't ok")) : TEXT("skipped")), 16, YPos);
+		}
+	}
+
+	for (auto& Target : Targets)
+	{
+		if (IsValid(Target.Publisher))
+		{
+			Target.Publisher->DrawDebug(Canvas, YL, YPos);
+		}
+	}
+}
+
+FString USensorRecordPlayerComponent::GetRemark() const
+{
+	return FPaths::GetCleanFilename(FileName);
+}
@@ -0,0 +1,204 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/VehicleComponents/Others/XCPSlaveComponent.h"
+#include "Soda/Vehicles/SodaVehicle.h"
+#include "Soda/UnrealSoda.h"
+#include "Soda/SodaApp.h"
+#include "Engine/Canvas.h"
+#include "Engine/Engine.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectGlobals.h"
+
+UXCPSlaveComponent::UXCPSlaveComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	GUI.Category = TEXT("Other");
+	GUI.IcanName = TEXT("SodaIcons.Soda");
+	GUI.ComponentNameOverride = TEXT("XCP Slave");
+	GUI.bIsPresentInAddMenu = true;
+
+	PrimaryComponentTick.bCanEverTick = true;
+
+	TickData.bAllowVehiclePrePhysTick = true;
+	TickData.bAllowVehiclePostPhysTick = true;
+}
+
+bool UXCPSlaveComponent::OnActivateVehicleComponent()
+{
+	if (!Super::OnActivateVehicleComponent())
+	{
+		return false;
+	}
+
+	Slave = MakeShared<xcp::FSlave>();
+	Slave->SetId(GetVehicle()->GetName());
+	PrePhysicEvent = Slave->AddEvent(TEXT("PrePhysic"));
+	PostPhysicEvent = Slave->AddEvent(TEXT("PostPhysic"));
+
+	FillSymbolTable(Slave->GetSymbolTable());
+
+	if (bExportA2L)
+	{
+		ExportA2L();
+	}
+
+	if (!Slave->Start(Port, SodaApp.EthTaskManager))
+	{
+		Slave.Reset();
+		SetHealth(EVehicleComponentHealth::Error, TEXT("Can't start XCP slave"));
+		return false;
+	}
+
+	PreGarbageCollectHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &UXCPSlaveComponent::OnPreGarbageCollect);
+
+	return true;
+}
+
+void UXCPSlaveComponent::OnDeactivateVehicleComponent()
+{
+	Super::OnDeactivateVehicleComponent();
+
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGarbageCollectHandle);
+	PreGarbageCollectHandle.Reset();
+
+	if (Slave)
+	{
+		Slave->Stop();
+		Slave.Reset();
+	}
+}
+
+void UXCPSlaveComponent::FillSymbolTable(xcp::FSymbolTable& SymbolTable)
+{
+	SymbolOwners.Reset();
+
+	SymbolTable.AddObjectProperties(GetVehicle(), TEXT("Vehicle"));
+	SymbolOwners.Add(GetVehicle());
+
+	for (ISodaVehicleComponent* Component : GetVehicle()->GetVehicleComponents())
+	{
+		if (UActorComponent* ActorComponent = Component->AsActorComponent())
+		{
+			SymbolTable.AddObjectProperties(ActorComponent, ActorComponent->GetName());
+			SymbolOwners.Add(ActorComponent);
+		}
+	}
+}
+
+bool UXCPSlaveComponent::IsSymbolTableOutdated(bool bCheckNewComponents) const
+{
+	for (const TWeakObjectPtr<UObject>& Owner : SymbolOwners)
+	{
+		if (!IsValid(Owner.Get()))
+		{
+			return true;
+		}
+	}
+
+	if (bCheckNewComponents)
+	{
+		const TArray<ISodaVehicleComponent*> Components = GetVehicle()->GetVehicleComponents();
+		if (Components.Num() + 1 != SymbolOwners.Num())
+		{
+			return true;
+		}
+		for (ISodaVehicleComponent* Component : Components)
+		{
+			if (!SymbolOwners.Contains(TWeakObjectPtr<UObject>(Component->AsActorComponent())))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void UXCPSlaveComponent::RebuildSymbolTable()
+{
+	{
+		// The slave is sampled and written on the physics substeps
+		FScopeLock ScopeLock(&GetVehicle()->PhysicMutex);
+		Slave->ResetSymbolTable([this](xcp::FSymbolTable& SymbolTable) { FillSymbolTable(SymbolTable); });
+	}
+
+	UE_LOG(LogSoda, Log, TEXT("UXCPSlaveComponent::RebuildSymbolTable(); Vehicle components are changed, %i symbols"), Slave->GetSymbolTable().GetSymbols().Num());
+
+	if (bExportA2L)
+	{
+		ExportA2L();
+	}
+}
+
+void UXCPSlaveComponent::OnPreGarbageCollect()
+{
+	// The removed components are still in memory here, but the symbols must not point to them after the GC
+	if (Slave && IsSymbolTableOutdated(false))
+	{
+		RebuildSymbolTable();
+	}
+}
+
+void UXCPSlaveComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (Slave && IsSymbolTableOutdated(true))
+	{
+		RebuildSymbolTable();
+	}
+}
+
+void UXCPSlaveComponent::ExportA2L()
+{
+	if (!Slave)
+	{
+		return;
+	}
+
+	const FString FileName = FPaths::ProjectSavedDir() / TEXT("XCP") / GetVehicle()->GetName() + TEXT(".a2l");
+	if (!Slave->GetSymbolTable().ExportA2L(FileName, GetVehicle()->GetName()))
+	{
+		UE_LOG(LogSoda, Error, TEXT("UXCPSlaveComponent::ExportA2L(). Can't write %s"), *FileName);
+	}
+}
+
+FString UXCPSlaveComponent::GetRemark() const
+{
+	return "udp://*:" + FString::FromInt(Port);
+}
+
+void UXCPSlaveComponent::PrePhysicSimulation(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& Timestamp)
+{
+	Super::PrePhysicSimulation(DeltaTime, VehicleKinematic, Timestamp);
+
+	if (Slave && HealthIsWorkable())
+	{
+		Slave->ApplyPendingWrites();
+		Slave->Event(PrePhysicEvent, Timestamp);
+	}
+}
+
+void UXCPSlaveComponent::PostPhysicSimulation(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& Timestamp)
+{
+	Super::PostPhysicSimulation(DeltaTime, VehicleKinematic, Timestamp);
+
+	if (Slave && HealthIsWorkable())
+	{
+		Slave->Event(PostPhysicEvent, Timestamp);
+	}
+}
+
+void UXCPSlaveComponent::DrawDebug(UCanvas* Canvas, float& YL, float& YPos)
+{
+	Super::DrawDebug(Canvas, YL, YPos);
+
+	if (Common.bDrawDebugCanvas && Slave)
+	{
+		UFont* RenderFont = GEngine->GetSmallFont();
+		Canvas->SetDrawColor(FColor::White);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Connected: %s, DAQ running: %s"), Slave->IsConnected() ? TEXT("true") : TEXT("false"), Slave->IsDaqRunning() ? TEXT("true") : TEXT("false")), 16, YPos);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Symbols: %i"), Slave->GetSymbolTable().GetSymbols().Num()), 16, YPos);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("DTO: %llu, overruns: %llu"), Slave->GetDtoNum(), Slave->GetOverrunNum()), 16, YPos);
+	}
+}
@@ -106,8 +106,8 @@ bool UCameraPinholeSensor::OnActivateVehicleComponent()
 	CaptureComponent = NewObject< USceneCaptureComponent2D >(this);
 	CaptureComponent->TextureTarget = NewObject< UTextureRenderTarget2D >(this);
 	CaptureComponent->TextureTarget->InitCustomFormat(Width, Height, EPixelFormat::PF_B8G8R8A8, !IsColorFormat(Format) || bForceLinearGamma);
-	CaptureComponent->bCaptureEveryFrame = true;
-	CaptureComponent->bCaptureOnMovement = true;
+	CaptureComponent->bCaptureEveryFrame = !Schedule.bEnabled;
+	CaptureComponent->bCaptureOnMovement = !Schedule.bEnabled;
 	CaptureComponent->PrimitiveRenderMode = PrimitiveRenderMode;
 	CaptureComponent->HiddenActors = HiddenActors;
 	CaptureComponent->ShowOnlyActors = ShowOnlyActors;
@@ -2,6 +2,7 @@
 
 #include "Soda/VehicleComponents/Sensors/Base/CameraSensor.h"
 #include "Soda/UnrealSoda.h"
+#include "Soda/SodaSensorEnvironment.h"
 #include "Soda/SodaApp.h"
 #include "Engine/TextureRenderTarget2D.h"
 #include "Runtime/Engine/Public/SceneView.h"
@@ -75,6 +76,10 @@ public:
 	{
 		check(!bIsDone);
 		check(ImageBuffer.Num() > 0 && uint32(ImageBuffer.Num()) >= ImageStride * CameraFrame.Height);
+		if (WeatherTransmission < 1)
+		{
+			soda::DegradeCameraImage(WeatherTransmission, WeatherAirlight, ImageBuffer);
+		}
 		Sensor->PublishSensorData(DeltaTime, Header, CameraFrame, ImageBuffer, ImageStride);
 		bIsDone = true;
 	}
@@ -85,6 +90,8 @@ public:
 	FCameraFrame CameraFrame;
 	TArray<FColor> ImageBuffer;
 	uint32 ImageStride = 0; // Original texture width in pixels
+	float WeatherTransmission = 1;
+	FColor WeatherAirlight;
 	TWeakObjectPtr<UCameraSensor> Sensor;
 
 protected:
@@ -238,6 +245,9 @@ UCameraSensor::UCameraSensor(const FObjectInitializer& ObjectInitializer)
 	GUI.IcanName = TEXT("SodaIcons.Camera");
 	GUI.bIsPresentInAddMenu = false;
 
+	Schedule.Rate = 30;
+	Schedule.Cost = 4;
+
 	PrimaryComponentTick.bCanEverTick = true;
 	bTickInEditor = false;
 
@@ -442,7 +452,23 @@ void UCameraSensor::TickComponent(float DeltaTime, ELevelTick TickType, FActorCo
 	}
 	*/
 
-	ENQUEUE_RENDER_COMMAND(SceneDrawCompletion)([Sensor=this, CameraFrame, DeltaTime, Header=GetHeaderGameThread()](FRHICommandListImmediate& RHICmdList)
+	// The scheduled camera renders the scene only on the frames it captures
+	if (Schedule.bEnabled && !GetSceneCaptureComponent2D()->bCaptureEveryFrame)
+	{
+		GetSceneCaptureComponent2D()->CaptureScene();
+	}
+
+	float WeatherTransmission = 1;
+	if (bWeatherDegradation && (Format == ECameraSensorShader::ColorBGR8 || Format == ECameraSensorShader::HdrRGB8))
+	{
+		const soda::FSensorWeather Weather = USodaSensorEnvironment::GetWeather(this);
+		if (!Weather.IsClear())
+		{
+			WeatherTransmission = FMath::Exp(-Weather.GetOpticalExtinction(550) * WeatherSceneDistance);
+		}
+	}
+
+	ENQUEUE_RENDER_COMMAND(SceneDrawCompletion)([Sensor=this, CameraFrame, DeltaTime, Header=GetHeaderGameThread(), WeatherTransmission, WeatherAirlight=WeatherAirlight](FRHICommandListImmediate& RHICmdList)
 	{
 		if(!IsValid(Sensor) || !IsValid(Sensor->GetSceneCaptureComponent2D())) return;
 
@@ -483,12 +509,15 @@ void UCameraSensor::TickComponent(float DeltaTime, ELevelTick TickType, FActorCo
 			if (!Task->IsDone())
 			{
 				UE_LOG(LogSoda, Warning, TEXT("UCameraSensor::TickComponent(). Skipped one frame"));
+				Sensor->NotifyFrameDropped();
 				return;
 			}
 			Task->Initialize();
 			Task->DeltaTime = DeltaTime;
 			Task->Header = Header;
 			Task->CameraFrame = CameraFrame;
+			Task->WeatherTransmission = WeatherTransmission;
+			Task->WeatherAirlight = WeatherAirlight;
 			FCameraPixelReader::ReadPixels(*Sensor->GetSceneCaptureComponent2D()->TextureTarget, RHICmdList, Task->ImageBuffer, Task->ImageStride);
 			Sensor->AsyncTask->UnlockFrontTask();
 			SodaApp.CamTaskManager.Trigger();
@@ -129,6 +129,8 @@ public:
 			}
 		}
 
+		soda::DegradeLidarScan(Weather, Header.FrameIndex, LidarRays, Scan);
+
 		Sensor->PublishSensorData(DeltaTime, Header, Scan);
 		Sensor->DrawLidarPoints(Scan, true);
 		bIsDone = true;
@@ -149,6 +151,7 @@ public:
 	FCameraFrame CameraFrame;
 	TArray<FColor> OutPixels;
 	uint32 ImageStride = 0; // Original texture width in pixels
+	soda::FLidarWeatherDegradation Weather;
 
 
 protected:
@@ -226,9 +229,14 @@ void ULidarDepth2DSensor::TickComponent(float DeltaTime, ELevelTick TickType, FA
 
 	//CameraFrame.Timestamp = SodaApp.GetSimulationTimestamp();
 	//CameraFrame.Index = SodaApp.GetFrameIndex();
-	
 
-	ENQUEUE_RENDER_COMMAND(SceneDrawCompletion)([Sensor=this, CameraFrame=CameraFrame, DeltaTime, Header=GetHeaderGameThread()](FRHICommandListImmediate& RHICmdList)
+	// The scheduled lidar renders the depth only on the frames it captures
+	if (!SceneCaptureComponent2D->bCaptureEveryFrame)
+	{
+		SceneCaptureComponent2D->CaptureScene();
+	}
+
+	ENQUEUE_RENDER_COMMAND(SceneDrawCompletion)([Sensor=this, CameraFrame=CameraFrame, DeltaTime, Header=GetHeaderGameThread(), Weather=MakeWeatherDegradation()](FRHICommandListImmediate& RHICmdList)
 	{
 		if (!IsValid(Sensor) || !IsValid(Sensor->SceneCaptureComponent2D)) return;
 
@@ -236,12 +244,14 @@ void ULidarDepth2DSensor::TickComponent(float DeltaTime, ELevelTick TickType, FA
 		if (!Task->IsDone())
 		{
 			UE_LOG(LogSoda, Warning, TEXT("ULidarDepth2DSensor::TickComponent(). Skipped one frame"));
+			Sensor->NotifyFrameDropped();
 			return;
 		}
 		Task->Initialize();
 		Task->DeltaTime = DeltaTime;
 		Task->Header = Header;
 		Task->CameraFrame = CameraFrame;
+		Task->Weather = Weather;
 		FCameraPixelReader::ReadPixels(*Sensor->SceneCaptureComponent2D->TextureTarget, RHICmdList, Task->OutPixels, Task->ImageStride);
 		Sensor->AsyncTask->UnlockFrontTask();
 		SodaApp.CamTaskManager.Trigger();
@@ -277,8 +287,8 @@ bool ULidarDepth2DSensor::OnActivateVehicleComponent()
 	SceneCaptureComponent2D->FOVAngle = CameraFOV;
 	SceneCaptureComponent2D->SetRelativeRotation(FRotator(0, 0, 0));
 	SceneCaptureComponent2D->RegisterComponent();
-	SceneCaptureComponent2D->bCaptureOnMovement = true;
-	SceneCaptureComponent2D->bCaptureEveryFrame = true;
+	SceneCaptureComponent2D->bCaptureOnMovement = !Schedule.bEnabled;
+	SceneCaptureComponent2D->bCaptureEveryFrame = !Schedule.bEnabled;
 	SceneCaptureComponent2D->PostProcessSettings = LidarPostProcessSettings;
 	SceneCaptureComponent2D->HideComponent(this);
 	SceneCaptureComponent2D->HideComponent(GetWorld()->LineBatcher.Get());
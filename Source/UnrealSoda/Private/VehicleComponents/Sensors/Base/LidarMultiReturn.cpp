@@ -0,0 +1,217 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/VehicleComponents/Sensors/Base/LidarMultiReturn.h"
+#include "Soda/Misc/SodaPhysicsInterface.h"
+#include "Engine/World.h"
+
+namespace soda
+{
+
+void FLidarMultiReturnTracer::Reset()
+{
+	BatchStart.Empty();
+	BatchEnd.Empty();
+	CenterHits.Empty();
+	CenterHitsNum.Empty();
+	EdgeHits.Empty();
+	EdgeHitsNum.Empty();
+	EdgeBeams.Empty();
+	Candidates.Empty();
+	BeamEchoes.Empty();
+	Echoes.Empty();
+}
+
+/** Hits of the sub-ray in the order of the distance; the overlapping hits reflect a part of the energy, the blocking hit reflects the rest */
+void FLidarMultiReturnTracer::AddSubRayEchoes(const TArray<FHitResult>& Hits, const TArray<int32>& HitsNum, int SubRay, float RayEnergy, float PartialHitReflectance)
+{
+	float Energy = RayEnergy;
+	for (int k = 0; k < HitsNum[SubRay]; ++k)
+	{
+		const FHitResult& Hit = Hits[SubRay * MaxSubRayHits + k];
+		const float Reflected = Hit.bBlockingHit ? Energy : Energy * PartialHitReflectance;
+		Candidates.Add({ Hit.Distance, Reflected, Hit.Location });
+		Energy -= Reflected;
+		if (Hit.bBlockingHit || Energy <= KINDA_SMALL_NUMBER)
+		{
+			break;
+		}
+	}
+}
+
+bool FLidarMultiReturnTracer::HasPartialHits(int Beam) const
+{
+	for (int k = 0; k < CenterHitsNum[Beam]; ++k)
+	{
+		if (!CenterHits[Beam * MaxSubRayHits + k].bBlockingHit)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FLidarMultiReturnTracer::HasBlockingHit(int Beam) const
+{
+	const int Num = CenterHitsNum[Beam];
+	return Num > 0 && CenterHits[Beam * MaxSubRayHits + Num - 1].bBlockingHit;
+}
+
+/** The neighbour beams cover the different surfaces, so the beams between them may be partially hit */
+bool FLidarMultiReturnTracer::IsSurfaceEdge(int BeamA, int BeamB) const
+{
+	const bool bBlockingA = HasBlockingHit(BeamA);
+	if (bBlockingA != HasBlockingHit(BeamB))
+	{
+		return true;
+	}
+	return bBlockingA &&
+		CenterHits[BeamA * MaxSubRayHits + CenterHitsNum[BeamA] - 1].GetComponent() != CenterHits[BeamB * MaxSubRayHits + CenterHitsNum[BeamB] - 1].GetComponent();
+}
+
+void FLidarMultiReturnTracer::Trace(const UWorld* World, const FCollisionQueryParams& QueryParams, const FTransform& Pose, const TArray<FVector>& Rays, int Columns, const FSetup& Setup)
+{
+	const int BeamsNum = Rays.Num();
+	const int EdgeRaysNum = FMath::Clamp(Setup.BeamEdgeRays, 3, MaxEdgeRays);
+	const FQuat Rotation = Pose.GetRotation();
+	const FVector Location = Pose.GetTranslation();
+	const FCollisionResponseParams& ResponseParams = FCollisionResponseParams::DefaultResponseParam;
+	ReturnsNum = FMath::Clamp(Setup.ReturnsNum, 1, MaxReturns);
+
+	auto MakeSegment = [&](const FVector& Ray, FVector& OutStart, FVector& OutEnd)
+	{
+		const FVector WorldRay = Rotation.RotateVector(Ray);
+		OutStart = Location + WorldRay * Setup.MinDistance;
+		OutEnd = Location + WorldRay * Setup.MaxDistance;
+	};
+
+	// The center rays of all beams; the multi-hit trace stops at the first blocking hit
+	BatchStart.SetNum(BeamsNum, false);
+	BatchEnd.SetNum(BeamsNum, false);
+	for (int Beam = 0; Beam < BeamsNum; ++Beam)
+	{
+		MakeSegment(Rays[Beam], BatchStart[Beam], BatchEnd[Beam]);
+	}
+	FSodaPhysicsInterface::RaycastMultiScope(World, CenterHits, CenterHitsNum, MaxSubRayHits, BatchStart, BatchEnd,
+		ECollisionChannel::ECC_Visibility, QueryParams, ResponseParams);
+	check(CenterHitsNum.Num() == BeamsNum);
+
+	// Only the beams on the surface edges or with the partial hits are refined by the edge sub-rays. The center rays of
+	// the neighbour beams are shared as the edge detector, so the flat surfaces cost one ray per beam.
+	EdgeBeams.Reset();
+	EdgeBeams.Reserve(BeamsNum);
+	for (int Beam = 0; Beam < BeamsNum; ++Beam)
+	{
+		bool bRefine = HasPartialHits(Beam);
+		if (!bRefine && Columns > 0)
+		{
+			const int Column = Beam % Columns;
+			bRefine =
+				(Column > 0 && IsSurfaceEdge(Beam, Beam - 1)) ||
+				(Column + 1 < Columns && IsSurfaceEdge(Beam, Beam + 1)) ||
+				(Beam >= Columns && IsSurfaceEdge(Beam, Beam - Columns)) ||
+				(Beam + Columns < BeamsNum && IsSurfaceEdge(Beam, Beam + Columns));
+		}
+		if (bRefine)
+		{
+			EdgeBeams.Add(Beam);
+		}
+	}
+
+	// The edge sub-rays lie on the cone of the beam divergence around the center ray. Their buffers grow to the
+	// high-water mark of the refined beams and are reused after that
+	if (EdgeBeams.Num() > 0)
+	{
+		const double TanHalfDivergence = FMath::Tan(FMath::DegreesToRadians(Setup.BeamDivergence) * 0.5);
+		double EdgeCos[MaxEdgeRays], EdgeSin[MaxEdgeRays];
+		for (int j = 0; j < EdgeRaysNum; ++j)
+		{
+			FMath::SinCos(&EdgeSin[j], &EdgeCos[j], 2.0 * PI * j / EdgeRaysNum);
+		}
+
+		BatchStart.SetNum(EdgeBeams.Num() * EdgeRaysNum, false);
+		BatchEnd.SetNum(EdgeBeams.Num() * EdgeRaysNum, false);
+		int k = 0;
+		for (int Beam : EdgeBeams)
+		{
+			const FVector Ray = Rays[Beam];
+			FVector U = Ray ^ FVector::UpVector;
+			if (!U.Normalize())
+			{
+				U = (Ray ^ FVector::ForwardVector).GetSafeNormal();
+			}
+			const FVector V = Ray ^ U;
+			for (int j = 0; j < EdgeRaysNum; ++j, ++k)
+			{
+				const FVector SubRay = (Ray + (U * EdgeCos[j] + V * EdgeSin[j]) * TanHalfDivergence).GetSafeNormal();
+				MakeSegment(SubRay, BatchStart[k], BatchEnd[k]);
+			}
+		}
+
+		FSodaPhysicsInterface::RaycastMultiScope(World, EdgeHits, EdgeHitsNum, MaxSubRayHits, BatchStart, BatchEnd,
+			ECollisionChannel::ECC_Visibility, QueryParams, ResponseParams);
+		check(EdgeHitsNum.Num() == EdgeBeams.Num() * EdgeRaysNum);
+	}
+
+	Echoes.SetNum(BeamsNum * ReturnsNum, false);
+	Candidates.Reserve((MaxEdgeRays + 1) * MaxSubRayHits);
+	BeamEchoes.Reserve((MaxEdgeRays + 1) * MaxSubRayHits);
+	int EdgeBeamIndex = 0;
+
+	for (int Beam = 0; Beam < BeamsNum; ++Beam)
+	{
+		// The energy of the refined beam is split equally between the center and the edge sub-rays
+		Candidates.Reset();
+		const bool bRefined = EdgeBeamIndex < EdgeBeams.Num() && EdgeBeams[EdgeBeamIndex] == Beam;
+		const float SubRayEnergy = bRefined ? 1.f / (EdgeRaysNum + 1) : 1.f;
+		AddSubRayEchoes(CenterHits, CenterHitsNum, Beam, SubRayEnergy, Setup.PartialHitReflectance);
+		if (bRefined)
+		{
+			for (int j = 0; j < EdgeRaysNum; ++j)
+			{
+				AddSubRayEchoes(EdgeHits, EdgeHitsNum, EdgeBeamIndex * EdgeRaysNum + j, SubRayEnergy, Setup.PartialHitReflectance);
+			}
+			++EdgeBeamIndex;
+		}
+
+		// Merge the hits closer than EchoSeparation into the echoes, the location is weighted by the energy
+		Candidates.Sort([](const FCandidate& A, const FCandidate& B) { return A.Distance < B.Distance; });
+		BeamEchoes.Reset();
+		float LastDistance = 0;
+		for (const FCandidate& Candidate : Candidates)
+		{
+			if (BeamEchoes.Num() == 0 || Candidate.Distance - LastDistance > Setup.EchoSeparation)
+			{
+				BeamEchoes.Add({ Candidate.Distance, 0.f, FVector::ZeroVector });
+			}
+			FCandidate& Echo = BeamEchoes.Last();
+			Echo.Energy += Candidate.Energy;
+			Echo.Location += Candidate.Location * Candidate.Energy;
+			LastDistance = Candidate.Distance;
+		}
+		BeamEchoes.RemoveAll([&Setup](const FCandidate& Echo) { return Echo.Energy < Setup.MinEchoIntensity || Echo.Energy <= 0; });
+
+		// Keep the ReturnsNum strongest echoes in the order of the distance
+		if (BeamEchoes.Num() > ReturnsNum)
+		{
+			BeamEchoes.Sort([](const FCandidate& A, const FCandidate& B) { return A.Energy > B.Energy; });
+			BeamEchoes.SetNum(ReturnsNum, false);
+			BeamEchoes.Sort([](const FCandidate& A, const FCandidate& B) { return A.Distance < B.Distance; });
+		}
+
+		for (int Echo = 0; Echo < ReturnsNum; ++Echo)
+		{
+			FEcho& Out = Echoes[Echo * BeamsNum + Beam];
+			if (Echo < BeamEchoes.Num())
+			{
+				Out.Location = BeamEchoes[Echo].Location / BeamEchoes[Echo].Energy;
+				Out.Energy = BeamEchoes[Echo].Energy;
+			}
+			else
+			{
+				Out = FEcho();
+			}
+		}
+	}
+}
+
+} // namespace soda
@@ -16,12 +16,81 @@ DECLARE_CYCLE_STAT(TEXT("batch execute"), STAT_BatchExecute, STATGROUP_LidarRayT
 DECLARE_CYCLE_STAT(TEXT("Add to batch execute"), STAT_AddToBatch, STATGROUP_LidarRayTraceSensor);
 DECLARE_CYCLE_STAT(TEXT("Process query results"), STAT_ProcessQueryResults, STATGROUP_LidarRayTraceSensor);
 DECLARE_CYCLE_STAT(TEXT("Publish results"), STAT_PublishResults, STATGROUP_LidarRayTraceSensor);
+DECLARE_CYCLE_STAT(TEXT("Tick sweep"), STAT_TickSweep, STATGROUP_LidarRayTraceSensor);
+DECLARE_CYCLE_STAT(TEXT("Range noise"), STAT_RangeNoise, STATGROUP_LidarRayTraceSensor);
+DECLARE_CYCLE_STAT(TEXT("Multi-return"), STAT_MultiReturn, STATGROUP_LidarRayTraceSensor);
+DECLARE_CYCLE_STAT(TEXT("Weather degradation"), STAT_WeatherDegradation, STATGROUP_LidarRayTraceSensor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Refined beams"), STAT_RefinedBeams, STATGROUP_LidarRayTraceSensor);
+
+static const int SweepPoseHistorySize = 64;
+
+/** Sensor pose loaded to the vector registers for the per ray transforms */
+struct FLidarRayFrame
+{
+	FLidarRayFrame(const FTransform& Pose, float MinDistance, float MaxDistance)
+	{
+		const FQuat Rotation = Pose.GetRotation();
+		const FVector Location = Pose.GetTranslation();
+		QuatReg = VectorLoad(&Rotation.X);
+		LocationReg = VectorLoadFloat3_W0(&Location.X);
+		MinDistanceReg = VectorSetFloat1(double(MinDistance));
+		MaxDistanceReg = VectorSetFloat1(double(MaxDistance));
+		LocationZ = Location.Z;
+	}
+
+	FORCEINLINE void MakeSegment(const FVector& Ray, FVector& OutStart, FVector& OutEnd) const
+	{
+		const VectorRegister4Double WorldRay = VectorQuaternionRotateVector(QuatReg, VectorLoadFloat3_W0(&Ray.X));
+		VectorStoreFloat3(VectorMultiplyAdd(WorldRay, MinDistanceReg, LocationReg), &OutStart.X);
+		VectorStoreFloat3(VectorMultiplyAdd(WorldRay, MaxDistanceReg, LocationReg), &OutEnd.X);
+	}
+
+	FORCEINLINE void ToLocal(const FVector& WorldPoint, FVector& OutLocalPoint) const
+	{
+		const VectorRegister4Double Offset = VectorSubtract(VectorLoadFloat3_W0(&WorldPoint.X), LocationReg);
+		VectorStoreFloat3(VectorQuaternionInverseRotateVector(QuatReg, Offset), &OutLocalPoint.X);
+	}
+
+	VectorRegister4Double QuatReg;
+	VectorRegister4Double LocationReg;
+	VectorRegister4Double MinDistanceReg;
+	VectorRegister4Double MaxDistanceReg;
+	double LocationZ;
+};
+
+/** Hit -> point -> ground filter -> range noise in one pass */
+static FORCEINLINE void MakeScanPoint(const FLidarRayFrame& Frame, const FVector& WorldPoint, bool bHit, bool bGroundFilter, float DistanceToGround, float RangeNoise, soda::FLidarScanPoint& Point)
+{
+	Frame.ToLocal(WorldPoint, Point.Location);
+	Point.Depth = Point.Location.Size();
+
+	if (!bHit)
+	{
+		Point.Status = soda::ELidarPointStatus::Invalid;
+	}
+	else if (bGroundFilter && (Frame.LocationZ - WorldPoint.Z) > DistanceToGround)
+	{
+		Point.Status = soda::ELidarPointStatus::Filtered;
+	}
+	else
+	{
+		Point.Status = soda::ELidarPointStatus::Valid;
+		if (RangeNoise != 0 && Point.Depth > KINDA_SMALL_NUMBER)
+		{
+			const float Depth = FMath::Max(Point.Depth + RangeNoise, 0.f);
+			Point.Location *= Depth / Point.Depth;
+			Point.Depth = Depth;
+		}
+	}
+}
 
 ULidarRayTraceSensor::ULidarRayTraceSensor(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
 	PrimaryComponentTick.bCanEverTick = true;
 	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+
+	TickData.bAllowVehiclePostPhysTick = true;
 }
 
 bool ULidarRayTraceSensor::OnActivateVehicleComponent()
@@ -31,6 +100,26 @@ bool ULidarRayTraceSensor::OnActivateVehicleComponent()
 		return false;
 	}
 
+	{
+		FScopeLock ScopeLock(&SweepPoseLock);
+		SweepPoseHistory.SetNum(bSweepScan ? SweepPoseHistorySize : 0);
+		SweepPoseHead = 0;
+		SweepPoseNum = 0;
+		SweepPhysicTime = 0;
+	}
+	SweepScanBeginTime = 0;
+	SweepTime = 0;
+	SweepNextColumn = 0;
+
+	NoiseStream = soda::FNoiseStream(soda::FNoiseStream::MakeKey(this));
+
+	Workspace.QueryParams = FCollisionQueryParams(NAME_None, false, GetOwner());
+
+	if (ReturnsNum > 1 && bSweepScan)
+	{
+		AddDebugMessage(EVehicleComponentHealth::Warning, TEXT("Multi-return isn't supported with the sweep scan, the single return is used"));
+	}
+
 	return true;
 }
 
@@ -39,50 +128,318 @@ void ULidarRayTraceSensor::OnDeactivateVehicleComponent()
 	Super::OnDeactivateVehicleComponent();
 
 	Scan.Points.Reset();
-	BatchStart.Reset();
-	BatchEnd.Reset();
+	Workspace.BatchStart.Reset();
+	Workspace.BatchEnd.Reset();
+	Workspace.Hits.Reset();
+	Workspace.RangeNoise.Reset();
+	MultiReturnTracer.Reset();
+	SweepSlices.Reset();
+
+	FScopeLock ScopeLock(&SweepPoseLock);
+	SweepPoseHistory.Reset();
+	SweepPoseNum = 0;
 }
 
+void ULidarRayTraceSensor::PostPhysicSimulation(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& Timestamp)
+{
+	Super::PostPhysicSimulation(DeltaTime, VehicleKinematic, Timestamp);
 
-void ULidarRayTraceSensor::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+	if (!bSweepScan)
+	{
+		return;
+	}
+
+	const FTransform Pose = GetRelativeTransform() * VehicleKinematic.Curr.GlobalPose;
+
+	FScopeLock ScopeLock(&SweepPoseLock);
+	if (SweepPoseHistory.Num() == 0)
+	{
+		return;
+	}
+	SweepPhysicTime += DeltaTime;
+	SweepPoseHistory[SweepPoseHead] = FSweepPoseSample{ SweepPhysicTime, Pose };
+	SweepPoseHead = (SweepPoseHead + 1) % SweepPoseHistory.Num();
+	SweepPoseNum = FMath::Min(SweepPoseNum + 1, SweepPoseHistory.Num());
+}
+
+FTransform ULidarRayTraceSensor::GetSweepPose(double PhysicTime) const
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-	if (!IsTickOnCurrentFrame() || !HealthIsWorkable()) return;
+	FScopeLock ScopeLock(&SweepPoseLock);
 
-	SCOPE_CYCLE_COUNTER(STAT_TickComponent);
+	if (SweepPoseNum == 0)
+	{
+		return GetComponentTransform();
+	}
+
+	const int HistorySize = SweepPoseHistory.Num();
+	const int Oldest = (SweepPoseHead - SweepPoseNum + HistorySize) % HistorySize;
+	const FSweepPoseSample* Prev = &SweepPoseHistory[Oldest];
+	if (PhysicTime <= Prev->Time)
+	{
+		return Prev->Pose;
+	}
+
+	for (int i = 1; i < SweepPoseNum; ++i)
+	{
+		const FSweepPoseSample* Next = &SweepPoseHistory[(Oldest + i) % HistorySize];
+		if (PhysicTime <= Next->Time)
+		{
+			const float Alpha = (PhysicTime - Prev->Time) / FMath::Max(Next->Time - Prev->Time, 1e-9);
+			return FTransform(
+				FQuat::Slerp(Prev->Pose.GetRotation(), Next->Pose.GetRotation(), Alpha),
+				FMath::Lerp(Prev->Pose.GetTranslation(), Next->Pose.GetTranslation(), Alpha),
+				FVector(1.0));
+		}
+		Prev = Next;
+	}
+
+	return Prev->Pose;
+}
+
+TSharedPtr<const soda::FLidarScanPatternTable> ULidarRayTraceSensor::GetScanPatternTable() const
+{
+	return (ScanTable && &ScanTable->Directions == &GetLidarRays()) ? ScanTable : nullptr;
+}
+
+void ULidarRayTraceSensor::TickSweep(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TickSweep);
+
+	const TArray<FVector>& Rays = GetLidarRays();
+	const TOptional<FUintVector2> Size = GetLidarSize();
+	if (!Size.IsSet() || Size->X == 0 || int(Size->X * Size->Y) != Rays.Num())
+	{
+		SetHealth(EVehicleComponentHealth::Error, TEXT("Sweep scan requires the 2D lidar size"));
+		return;
+	}
+
+	const int Columns = Size->X;
+	const int Rows = Size->Y;
+	const double ScanDuration = 1.0 / FMath::Max(SweepFrequency, 0.1f);
+
+	// The sweep is driven by the physics time, so every fired column lies between two stored physics substeps.
+	// If the parent doesn't simulate physics, the sweep is driven by the frame time.
+	double TargetTime;
+	{
+		FScopeLock ScopeLock(&SweepPoseLock);
+		TargetTime = SweepPoseNum > 0 ? SweepPhysicTime : SweepTime + DeltaTime;
+	}
+
+	while (true)
+	{
+		if (SweepNextColumn == 0)
+		{
+			SweepHeader = GetHeaderGameThread();
+			Scan.PatternTable = GetScanPatternTable();
+			Scan.Points.SetNum(Rays.Num(), false);
+			PrepareRangeNoise(SweepHeader.FrameIndex, Rays.Num());
+		}
+
+		const int EndColumn = FMath::Clamp(int(FMath::FloorToDouble((TargetTime - SweepScanBeginTime) / ScanDuration * Columns)) + 1, SweepNextColumn, Columns);
+		if (EndColumn > SweepNextColumn)
+		{
+			TraceSweepColumns(SweepNextColumn, EndColumn, Columns, Rows, ScanDuration);
+			SweepNextColumn = EndColumn;
+		}
+
+		if (SweepNextColumn < Columns)
+		{
+			break;
+		}
+
+		Scan.HorizontalAngleMax = GetFOVHorizontMax();
+		Scan.HorizontalAngleMin = GetFOVHorizontMin();
+		Scan.VerticalAngleMin = GetFOVVerticalMin();
+		Scan.VerticalAngleMax = GetFOVVerticalMax();
+		Scan.RangeMin = GetLidarMinDistance();
+		Scan.RangeMax = GetLidarMaxDistance();
+		Scan.Size = Size;
+		Scan.bTimeOffsetIsValid = true;
+		Scan.bIntensitieIsValid = false;
+		Scan.ScanDuration = ScanDuration;
+		Scan.ReturnsNum = 1;
 
-	const FVector Loc = GetComponentLocation();
-	const FRotator Rot = GetComponentRotation();
+		{
+			SCOPE_CYCLE_COUNTER(STAT_WeatherDegradation);
+			soda::DegradeLidarScan(MakeWeatherDegradation(), SweepHeader.FrameIndex, Rays, Scan);
+		}
+
+		{
+			SCOPE_CYCLE_COUNTER(STAT_PublishResults);
+			PublishSensorData(ScanDuration, SweepHeader, Scan);
+		}
+		DrawLidarPoints(Scan, false);
+
+		SweepNextColumn = 0;
+		SweepScanBeginTime += ScanDuration;
+
+		// At most one scan is published per frame. After a hitch the scans which would be completed on this frame
+		// too are dropped, their time is skipped and reported as the dropped frames
+		const double LastColumnTime = double(Columns - 1) / Columns * ScanDuration;
+		while (TargetTime >= SweepScanBeginTime + LastColumnTime)
+		{
+			SweepScanBeginTime += ScanDuration;
+			NotifyFrameDropped();
+		}
+	}
+
+	SweepTime = TargetTime;
+}
+
+void ULidarRayTraceSensor::TraceSweepColumns(int ColumnBegin, int ColumnEnd, int Columns, int Rows, double ScanDuration)
+{
 	const TArray<FVector>& Rays = GetLidarRays();
+	const int SliceNum = FMath::Min(SweepSlicesPerFrame, ColumnEnd - ColumnBegin);
+
+	SweepSlices.SetNum(SliceNum, false);
+	for (int i = 0; i < SliceNum; ++i)
+	{
+		FSweepSlice& Slice = SweepSlices[i];
+		Slice.ColumnBegin = ColumnBegin + (ColumnEnd - ColumnBegin) * i / SliceNum;
+		Slice.ColumnEnd = ColumnBegin + (ColumnEnd - ColumnBegin) * (i + 1) / SliceNum;
+		const double SliceMiddle = (Slice.ColumnBegin + Slice.ColumnEnd - 1) * 0.5;
+		Slice.Pose = GetSweepPose(SweepScanBeginTime + SliceMiddle / Columns * ScanDuration);
+	}
 
-	BatchStart.SetNum(Rays.Num(), false);
-	BatchEnd.SetNum(Rays.Num(), false);
+	const int RaysNum = (ColumnEnd - ColumnBegin) * Rows;
+	Workspace.BatchStart.SetNum(RaysNum, false);
+	Workspace.BatchEnd.SetNum(RaysNum, false);
 
 	{
 		SCOPE_CYCLE_COUNTER(STAT_AddToBatch);
-		for (int i = 0; i < Rays.Num(); i++)
+		int k = 0;
+		for (const FSweepSlice& Slice : SweepSlices)
 		{
-			const FVector WorldRay = Rot.RotateVector(Rays[i]);
-			BatchStart[i] = Loc + WorldRay * GetLidarMinDistance();
-			BatchEnd[i] = Loc + WorldRay * GetLidarMaxDistance();
+			const FLidarRayFrame Frame(Slice.Pose, GetLidarMinDistance(), GetLidarMaxDistance());
+			for (int Column = Slice.ColumnBegin; Column < Slice.ColumnEnd; ++Column)
+			{
+				for (int Row = 0; Row < Rows; ++Row, ++k)
+				{
+					Frame.MakeSegment(Rays[Row * Columns + Column], Workspace.BatchStart[k], Workspace.BatchEnd[k]);
+				}
+			}
 		}
 	}
 
-	TArray<FHitResult> OutHits;
+	TraceBatch();
+
+	SCOPE_CYCLE_COUNTER(STAT_ProcessQueryResults);
+	const bool bRangeNoise = Workspace.RangeNoise.Num() == Scan.Points.Num();
+	const TArray<float>* TimeFractions = Scan.PatternTable ? &Scan.PatternTable->TimeFractions : nullptr;
+	int k = 0;
+	for (const FSweepSlice& Slice : SweepSlices)
 	{
-		SCOPE_CYCLE_COUNTER(STAT_BatchExecute);
+		const FLidarRayFrame Frame(Slice.Pose, GetLidarMinDistance(), GetLidarMaxDistance());
+		for (int Column = Slice.ColumnBegin; Column < Slice.ColumnEnd; ++Column)
+		{
+			const float ColumnTimeOffset = double(Column) / Columns * ScanDuration;
+			for (int Row = 0; Row < Rows; ++Row, ++k)
+			{
+				const int PointIndex = Row * Columns + Column;
+				soda::FLidarScanPoint& Point = Scan.Points[PointIndex];
+				MakeScanPoint(Frame, Workspace.Hits[k].Location, Workspace.Hits[k].bBlockingHit, bEnabledGroundFilter, DistanceToGround, bRangeNoise ? Workspace.RangeNoise[PointIndex] : 0.f, Point);
+				Point.TimeOffset = TimeFractions ? (*TimeFractions)[PointIndex] * ScanDuration : ColumnTimeOffset;
+			}
+		}
+	}
+}
 
-		FSodaPhysicsInterface::RaycastSingleScope(
-			GetWorld(), OutHits, BatchStart, BatchEnd,
-			ECollisionChannel::ECC_Visibility,
-			FCollisionQueryParams(NAME_None, false, GetOwner()),
-			FCollisionResponseParams::DefaultResponseParam,
-			FCollisionObjectQueryParams::DefaultObjectQueryParam);
+void ULidarRayTraceSensor::TraceBatch()
+{
+	SCOPE_CYCLE_COUNTER(STAT_BatchExecute);
 
-	};
-	check(OutHits.Num() == Rays.Num());
+	FSodaPhysicsInterface::RaycastSingleScope(
+		GetWorld(), Workspace.Hits, Workspace.BatchStart, Workspace.BatchEnd,
+		ECollisionChannel::ECC_Visibility,
+		Workspace.QueryParams,
+		FCollisionResponseParams::DefaultResponseParam,
+		FCollisionObjectQueryParams::DefaultObjectQueryParam);
+
+	check(Workspace.Hits.Num() == Workspace.BatchStart.Num());
+}
+
+void ULidarRayTraceSensor::TraceMultiReturn(const FTransform& Pose)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MultiReturn);
+
+	const TArray<FVector>& Rays = GetLidarRays();
+	const int BeamsNum = Rays.Num();
+	const TOptional<FUintVector2> Size = GetLidarSize();
+	const int Columns = (Size.IsSet() && int(Size->X * Size->Y) == BeamsNum) ? int(Size->X) : 0;
+
+	soda::FLidarMultiReturnTracer::FSetup Setup;
+	Setup.ReturnsNum = ReturnsNum;
+	Setup.BeamDivergence = BeamDivergence;
+	Setup.BeamEdgeRays = BeamEdgeRays;
+	Setup.EchoSeparation = EchoSeparation;
+	Setup.MinEchoIntensity = MinEchoIntensity;
+	Setup.PartialHitReflectance = PartialHitReflectance;
+	Setup.MinDistance = GetLidarMinDistance();
+	Setup.MaxDistance = GetLidarMaxDistance();
+
+	MultiReturnTracer.Trace(GetWorld(), Workspace.QueryParams, Pose, Rays, Columns, Setup);
+	SET_DWORD_STAT(STAT_RefinedBeams, MultiReturnTracer.GetRefinedBeamsNum());
+
+	SCOPE_CYCLE_COUNTER(STAT_ProcessQueryResults);
+
+	const int Returns = MultiReturnTracer.GetReturnsNum();
+	const TArray<soda::FLidarMultiReturnTracer::FEcho>& Echoes = MultiReturnTracer.GetEchoes();
+	const FLidarRayFrame Frame(Pose, GetLidarMinDistance(), GetLidarMaxDistance());
+
+	Scan.Points.SetNum(BeamsNum * Returns, false);
+	Scan.ReturnsNum = Returns;
+	Scan.bIntensitieIsValid = true;
+
+	const bool bRangeNoise = Workspace.RangeNoise.Num() == Scan.Points.Num();
+	for (int PointIndex = 0; PointIndex < Scan.Points.Num(); ++PointIndex)
+	{
+		const soda::FLidarMultiReturnTracer::FEcho& Echo = Echoes[PointIndex];
+		soda::FLidarScanPoint& Point = Scan.Points[PointIndex];
+		if (Echo.Energy > 0)
+		{
+			MakeScanPoint(Frame, Echo.Location, true, bEnabledGroundFilter, DistanceToGround, bRangeNoise ? Workspace.RangeNoise[PointIndex] : 0.f, Point);
+			Point.Intensitie = Echo.Energy;
+		}
+		else
+		{
+			Point = soda::FLidarScanPoint();
+		}
+	}
+}
+
+void ULidarRayTraceSensor::PrepareRangeNoise(int64 Frame, int Num)
+{
+	if (RangeNoiseStdDev <= 0)
+	{
+		Workspace.RangeNoise.SetNum(0, false);
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_RangeNoise);
+
+	Workspace.RangeNoise.SetNum(Num, false);
+	NoiseStream.Gaussian(Frame, 0, 0, Workspace.RangeNoise.GetData(), Num, RangeNoiseStdDev);
+}
+
+void ULidarRayTraceSensor::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (bSweepScan)
+	{
+		if (HealthIsWorkable()) TickSweep(DeltaTime);
+		return;
+	}
+
+	if (!IsTickOnCurrentFrame() || !HealthIsWorkable()) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_TickComponent);
+
+	const TArray<FVector>& Rays = GetLidarRays();
+	const int RaysNum = Rays.Num();
+	const FTransform Pose = GetComponentTransform();
+	const FSensorDataHeader Header = GetHeaderGameThread();
 
-	Scan.Points.SetNum(Rays.Num(), false);
 	Scan.HorizontalAngleMax = GetFOVHorizontMax();
 	Scan.HorizontalAngleMin = GetFOVHorizontMin();
 	Scan.VerticalAngleMin = GetFOVVerticalMin();
@@ -90,32 +447,53 @@ void ULidarRayTraceSensor::TickComponent(float DeltaTime, ELevelTick TickType, F
 	Scan.RangeMin = GetLidarMinDistance();
 	Scan.RangeMax = GetLidarMaxDistance();
 	Scan.Size = GetLidarSize();
+	Scan.PatternTable = GetScanPatternTable();
+	Scan.bTimeOffsetIsValid = false;
+	Scan.ScanDuration = 0;
 
-	for (int k = 0; k < Rays.Num(); ++k)
+	if (ReturnsNum > 1)
 	{
-		Scan.Points[k].Location = Rot.UnrotateVector(OutHits[k].Location - Loc);
-		Scan.Points[k].Depth = Scan.Points[k].Location.Size();
-		if (OutHits[k].bBlockingHit)
-		{
-			Scan.Points[k].Status = soda::ELidarPointStatus::Valid;
+		PrepareRangeNoise(Header.FrameIndex, RaysNum * FMath::Min(ReturnsNum, soda::FLidarMultiReturnTracer::MaxReturns));
+		TraceMultiReturn(Pose);
+	}
+	else
+	{
+		const FLidarRayFrame Frame(Pose, GetLidarMinDistance(), GetLidarMaxDistance());
+
+		Workspace.BatchStart.SetNum(RaysNum, false);
+		Workspace.BatchEnd.SetNum(RaysNum, false);
 
-			if (bEnabledGroundFilter)
+		{
+			SCOPE_CYCLE_COUNTER(STAT_AddToBatch);
+			for (int i = 0; i < RaysNum; i++)
 			{
-				if ((Loc.Z - OutHits[k].Location.Z) > DistanceToGround)
-				{
-					Scan.Points[k].Status = soda::ELidarPointStatus::Filtered;
-				}
+				Frame.MakeSegment(Rays[i], Workspace.BatchStart[i], Workspace.BatchEnd[i]);
 			}
 		}
-		else
+
+		TraceBatch();
+		PrepareRangeNoise(Header.FrameIndex, RaysNum);
+
+		Scan.Points.SetNum(RaysNum, false);
+		Scan.ReturnsNum = 1;
+		Scan.bIntensitieIsValid = false;
+
+		SCOPE_CYCLE_COUNTER(STAT_ProcessQueryResults);
+		const bool bRangeNoise = Workspace.RangeNoise.Num() == RaysNum;
+		for (int k = 0; k < RaysNum; ++k)
 		{
-			Scan.Points[k].Status = soda::ELidarPointStatus::Invalid;
+			MakeScanPoint(Frame, Workspace.Hits[k].Location, Workspace.Hits[k].bBlockingHit, bEnabledGroundFilter, DistanceToGround, bRangeNoise ? Workspace.RangeNoise[k] : 0.f, Scan.Points[k]);
 		}
 	}
 
+	{
+		SCOPE_CYCLE_COUNTER(STAT_WeatherDegradation);
+		soda::DegradeLidarScan(MakeWeatherDegradation(), Header.FrameIndex, Rays, Scan);
+	}
+
 	{
 		SCOPE_CYCLE_COUNTER(STAT_PublishResults);
-		PublishSensorData(DeltaTime, GetHeaderGameThread(), Scan);
+		PublishSensorData(DeltaTime, Header, Scan);
 	}
 	DrawLidarPoints(Scan, false);
 
@@ -0,0 +1,226 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/VehicleComponents/Sensors/Base/LidarScanPattern.h"
+#include "Soda/UnrealSoda.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/FileManager.h"
+
+namespace soda
+{
+
+FCriticalSection FLidarScanPatternCompiler::CacheLock;
+TMap<FString, TWeakPtr<const FLidarScanPatternTable>> FLidarScanPatternCompiler::Cache;
+
+static FVector AnglesToDirection(float Elevation, float Azimuth)
+{
+	return FRotator(Elevation, Azimuth, 0.0f).RotateVector(FVector(1.0, 0.0, 0.0));
+}
+
+static float ColumnToAzimuth(const FLidarScanPatternLayer& Layer, int Column)
+{
+	// Don't duplicate the first column for a full revolution
+	const float Span = Layer.HorizontMax - Layer.HorizontMin;
+	const int Div = (FMath::Abs(Span) >= 360.f || Layer.Step < 2) ? Layer.Step : Layer.Step - 1;
+	return Layer.HorizontMin + Span / (float)Div * (float)Column;
+}
+
+static void AddRay(FLidarScanPatternTable& Table, float Elevation, float Azimuth, int Ring, int Column, float TimeFraction)
+{
+	Table.Directions.Add(AnglesToDirection(Elevation, Azimuth));
+	Table.Rings.Add(uint16(Ring));
+	Table.Columns.Add(uint32(Column));
+	Table.TimeFractions.Add(TimeFraction);
+	Table.HorizontMin = FMath::Min(Table.HorizontMin, Azimuth);
+	Table.HorizontMax = FMath::Max(Table.HorizontMax, Azimuth);
+	Table.VerticalMin = FMath::Min(Table.VerticalMin, Elevation);
+	Table.VerticalMax = FMath::Max(Table.VerticalMax, Elevation);
+}
+
+static FString GetBeamTablePath(const FString& FileName)
+{
+	return FPaths::IsRelative(FileName) ? FPaths::Combine(FPaths::ProjectDir(), FileName) : FileName;
+}
+
+static bool LoadBeamTable(const FString& FileName, TArray<FVector2D>& OutBeams, FString& OutError)
+{
+	const FString FilePath = GetBeamTablePath(FileName);
+
+	TArray<FString> FileLines;
+	if (!FFileHelper::LoadFileToStringArray(FileLines, *FilePath))
+	{
+		OutError = FString::Printf(TEXT("Can't load beam table: %s"), *FilePath);
+		return false;
+	}
+
+	for (const FString& Line : FileLines)
+	{
+		TArray<FString> ParsedValues;
+		Line.TrimStartAndEnd().ParseIntoArray(ParsedValues, TEXT(","), true);
+
+		// Skip header, comments and empty lines
+		if (ParsedValues.Num() == 0 || !ParsedValues[0].TrimStartAndEnd().IsNumeric())
+		{
+			continue;
+		}
+
+		OutBeams.Add(FVector2D(
+			FCString::Atof(*ParsedValues[0]),
+			ParsedValues.Num() > 1 ? FCString::Atof(*ParsedValues[1]) : 0.0));
+	}
+
+	if (OutBeams.Num() == 0)
+	{
+		OutError = FString::Printf(TEXT("Beam table is empty: %s"), *FilePath);
+		return false;
+	}
+
+	return true;
+}
+
+bool FLidarScanPatternCompiler::CompileLayer(const FLidarScanPatternLayer& Layer, int RingOffset, FLidarScanPatternTable& Table, int& OutRings, FString& OutError)
+{
+	switch (Layer.Source)
+	{
+	case ELidarScanPatternSource::Uniform:
+	{
+		if (Layer.Step <= 0 || Layer.Channels <= 0)
+		{
+			OutError = TEXT("Uniform layer requires positive Step and Channels");
+			return false;
+		}
+		for (int Ring = 0; Ring < Layer.Channels; ++Ring)
+		{
+			const float Elevation = Layer.Channels > 1
+				? Layer.VerticalMin + (Layer.VerticalMax - Layer.VerticalMin) / (float)(Layer.Channels - 1) * (float)Ring
+				: (Layer.VerticalMin + Layer.VerticalMax) / 2;
+			for (int Column = 0; Column < Layer.Step; ++Column)
+			{
+				AddRay(Table, Elevation, ColumnToAzimuth(Layer, Column), RingOffset + Ring, Column, (float)Column / Layer.Step);
+			}
+		}
+		OutRings = Layer.Channels;
+		return true;
+	}
+
+	case ELidarScanPatternSource::BeamTable:
+	{
+		if (Layer.Step <= 0)
+		{
+			OutError = TEXT("BeamTable layer requires positive Step");
+			return false;
+		}
+		TArray<FVector2D> Beams;
+		if (!LoadBeamTable(Layer.BeamTableFile, Beams, OutError))
+		{
+			return false;
+		}
+		for (int Ring = 0; Ring < Beams.Num(); ++Ring)
+		{
+			for (int Column = 0; Column < Layer.Step; ++Column)
+			{
+				AddRay(Table, Beams[Ring].X, ColumnToAzimuth(Layer, Column) + Beams[Ring].Y, RingOffset + Ring, Column, (float)Column / Layer.Step);
+			}
+		}
+		OutRings = Beams.Num();
+		return true;
+	}
+
+	case ELidarScanPatternSource::Rosette:
+	{
+		if (Layer.RosettePoints <= 0)
+		{
+			OutError = TEXT("Rosette layer requires positive RosettePoints");
+			return false;
+		}
+		const float Radius = Layer.RosetteFOV / 2;
+		for (int i = 0; i < Layer.RosettePoints; ++i)
+		{
+			const float TimeFraction = (float)i / Layer.RosettePoints;
+			const float T = 2.f * PI * Layer.RosetteTurns * TimeFraction;
+			const float R = Radius * FMath::Cos(Layer.RosettePetals * T);
+			AddRay(Table, R * FMath::Sin(T), R * FMath::Cos(T), RingOffset, i, TimeFraction);
+		}
+		OutRings = 1;
+		return true;
+	}
+
+	default:
+		OutError = TEXT("Unknown scan pattern source");
+		return false;
+	}
+}
+
+TSharedPtr<const FLidarScanPatternTable> FLidarScanPatternCompiler::Compile(const FLidarScanPattern& Pattern, FString& OutError)
+{
+	if (Pattern.Layers.Num() == 0)
+	{
+		OutError = TEXT("Scan pattern has no layers");
+		return nullptr;
+	}
+
+	const FString Key = Pattern.GetKey();
+
+	FScopeLock ScopeLock(&CacheLock);
+
+	if (TWeakPtr<const FLidarScanPatternTable>* Found = Cache.Find(Key))
+	{
+		if (TSharedPtr<const FLidarScanPatternTable> Table = Found->Pin())
+		{
+			return Table;
+		}
+	}
+
+	TSharedPtr<FLidarScanPatternTable> Table = MakeShared<FLidarScanPatternTable>();
+	Table->HorizontMin = Table->VerticalMin = TNumericLimits<float>::Max();
+	Table->HorizontMax = Table->VerticalMax = TNumericLimits<float>::Lowest();
+
+	// The table is a grid only if all layers are grids with the same number of columns
+	bool bIsGrid = true;
+	int RingsNum = 0;
+	for (const FLidarScanPatternLayer& Layer : Pattern.Layers)
+	{
+		int LayerRings = 0;
+		if (!CompileLayer(Layer, RingsNum, *Table, LayerRings, OutError))
+		{
+			return nullptr;
+		}
+		bIsGrid &= Layer.Source != ELidarScanPatternSource::Rosette && Layer.Step == Pattern.Layers[0].Step;
+		RingsNum += LayerRings;
+	}
+
+	if (bIsGrid)
+	{
+		Table->Size = FUintVector2(Pattern.Layers[0].Step, RingsNum);
+	}
+
+	Cache.Add(Key, Table);
+
+	UE_LOG(LogSoda, Log, TEXT("FLidarScanPatternCompiler::Compile(). Compiled %i rays"), Table->Directions.Num());
+
+	return Table;
+}
+
+} // namespace soda
+
+FString FLidarScanPattern::GetKey() const
+{
+	FString Key;
+	for (const FLidarScanPatternLayer& Layer : Layers)
+	{
+		Key += FString::Printf(TEXT("%i;%i;%f;%f;%i;%f;%f;%s;%i;%f;%f;%f"),
+			int(Layer.Source), Layer.Step, Layer.HorizontMin, Layer.HorizontMax,
+			Layer.Channels, Layer.VerticalMin, Layer.VerticalMax, *Layer.BeamTableFile,
+			Layer.RosettePoints, Layer.RosetteFOV, Layer.RosettePetals, Layer.RosetteTurns);
+
+		// The edited beam table file must not hit the table compiled from its previous version
+		if (Layer.Source == ELidarScanPatternSource::BeamTable)
+		{
+			const FFileStatData Stat = IFileManager::Get().GetStatData(*soda::GetBeamTablePath(Layer.BeamTableFile));
+			Key += FString::Printf(TEXT(";%s;%lld"), *Stat.ModificationTime.ToString(), Stat.FileSize);
+		}
+		Key += TEXT("|");
+	}
+	return Key;
+}
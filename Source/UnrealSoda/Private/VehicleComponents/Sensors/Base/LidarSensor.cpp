@@ -2,6 +2,7 @@
 
 #include "Soda/VehicleComponents/Sensors/Base/LidarSensor.h"
 #include "Soda/UnrealSoda.h"
+#include "Soda/SodaSensorEnvironment.h"
 #include "Soda/SodaApp.h"
 #include "Physics/PhysicsFiltering.h"
 #include "DrawDebugHelpers.h"
@@ -21,6 +22,9 @@ ULidarSensor::ULidarSensor(const FObjectInitializer& ObjectInitializer)
 
 	FOVSetup.Color = FLinearColor(1.0, 0.1, 0.3, 1.0);
 	FOVSetup.MaxViewDistance = 700;
+
+	Schedule.Rate = 10;
+	Schedule.Cost = 3;
 }
 
 void ULidarSensor::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
@@ -32,6 +36,54 @@ void ULidarSensor::TickComponent(float DeltaTime, ELevelTick TickType, FActorCom
 
 }
 
+void ULidarSensor::OnDeactivateVehicleComponent()
+{
+	Super::OnDeactivateVehicleComponent();
+	ScanTable.Reset();
+}
+
+bool ULidarSensor::CompileScanPattern()
+{
+	ScanTable.Reset();
+
+	if (!ScanPattern.bEnabled)
+	{
+		return true;
+	}
+
+	FString Error;
+	ScanTable = soda::FLidarScanPatternCompiler::Compile(ScanPattern, Error);
+	if (!ScanTable)
+	{
+		SetHealth(EVehicleComponentHealth::Error, Error);
+		return false;
+	}
+
+	return true;
+}
+
+soda::FLidarWeatherDegradation ULidarSensor::MakeWeatherDegradation() const
+{
+	soda::FLidarWeatherDegradation Degradation;
+	if (!bWeatherDegradation)
+	{
+		return Degradation;
+	}
+
+	const soda::FSensorWeather Weather = USodaSensorEnvironment::GetWeather(this);
+	if (Weather.IsClear())
+	{
+		return Degradation;
+	}
+
+	Degradation.Extinction = Weather.GetOpticalExtinction(LaserWavelength);
+	Degradation.BackscatterProbability = 1.f - FMath::Exp(-BackscatterGain * Weather.GetPrecipitationExtinction(LaserWavelength));
+	Degradation.BackscatterRange = BackscatterRange;
+	Degradation.DetectionThreshold = DetectionThreshold;
+	Degradation.Noise = soda::FNoiseStream(soda::FNoiseStream::MakeKey(this));
+	return Degradation;
+}
+
 bool ULidarSensor::GenerateFOVMesh(TArray<FSensorFOVMesh>& Meshes)
 {
 	FSensorFOVMesh MeshData;
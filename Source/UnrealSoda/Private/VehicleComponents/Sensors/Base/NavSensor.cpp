@@ -2,6 +2,10 @@
 
 #include "Soda/VehicleComponents/Sensors/Base/NavSensor.h"
 #include "Soda/UnrealSoda.h"
+#include "Soda/Vehicles/SodaVehicle.h"
+
+DECLARE_STATS_GROUP(TEXT("NavSensor"), STATGROUP_NavSensor, STATGROUP_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Tick synthesis"), STAT_TickSynthesis, STATGROUP_NavSensor);
 
 UNavSensor::UNavSensor(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -23,7 +27,21 @@ bool UNavSensor::OnActivateVehicleComponent()
 		return false;
 	}
 
-	NoiseParams.UpdateParameters();
+	NoiseParams.UpdateParameters(soda::FNoiseStream::MakeKey(this));
+
+	if (bHighRateSynthesis)
+	{
+		Synthesizer.Reset();
+		ImuSampleIndex = 0;
+		GnssSampleIndex = 0;
+		SynthesisTimer.TimerDelegate.BindLambda([this](const std::chrono::nanoseconds& InDeltatime, const std::chrono::nanoseconds& Elapsed)
+		{
+			TickSynthesis();
+		});
+		const float TimerRate = FMath::Max(ImuRate, GnssRate);
+		SynthesisTimer.RealtimeSmoothFactor = 0.5;
+		SynthesisTimer.TimerStart(std::chrono::microseconds(int64(1e6 / TimerRate)), std::chrono::milliseconds(0));
+	}
 
 	return true;
 }
@@ -31,25 +49,125 @@ bool UNavSensor::OnActivateVehicleComponent()
 void UNavSensor::OnDeactivateVehicleComponent()
 {
 	Super::OnDeactivateVehicleComponent();
+
+	SynthesisTimer.TimerStop();
+	SynthesisTimer.TimerDelegate.Unbind();
+}
+
+void UNavSensor::SerializeSnapshot(FArchive& Ar)
+{
+	Super::SerializeSnapshot(Ar);
+
+	// ASodaVehicle::SerializeSnapshot() holds the PhysicMutex, so the synthesis timer doesn't step the noise meanwhile
+	NoiseParams.SerializeSnapshot(Ar);
+
+	if (Ar.IsLoading())
+	{
+		// The history of the kinematic is not valid after the rewind, the time of the new history starts from zero
+		Synthesizer.Reset();
+		ImuSampleIndex = 0;
+		GnssSampleIndex = 0;
+	}
+}
+
+void UNavSensor::TickSynthesis()
+{
+	SCOPE_CYCLE_COUNTER(STAT_TickSynthesis);
+
+	// The publishers and the noise are shared with the physics substeps and with SerializeSnapshot(), which are run
+	// under the vehicle PhysicMutex. TryLock, because the deactivation stops this timer under the same mutex
+	FCriticalSection& PhysicMutex = GetVehicle()->PhysicMutex;
+	while (!PhysicMutex.TryLock())
+	{
+		if (!SynthesisTimer.IsTimerWorking())
+		{
+			return;
+		}
+		FPlatformProcess::Yield();
+	}
+
+	if (HealthIsWorkable())
+	{
+		EmitSynthesizedSamples();
+	}
+
+	PhysicMutex.Unlock();
+}
+
+void UNavSensor::EmitSynthesizedSamples()
+{
+	double Begin, End;
+	if (!Synthesizer.GetTimeRange(Begin, End))
+	{
+		return;
+	}
+
+	const FTransform RelativeTransform = GetRelativeTransform();
+
+	// Sample times lie on the grids k / Rate, the first sample of every stream has the previous one inside the history
+	auto Emit = [this, Begin, End, &RelativeTransform](float Rate, int64& SampleIndex, bool bGnss)
+	{
+		const double Dt = 1.0 / Rate;
+		SampleIndex = FMath::Max(SampleIndex, int64(FMath::CeilToDouble(Begin * Rate)) + 1);
+		for (; double(SampleIndex) * Dt <= End; ++SampleIndex)
+		{
+			FPhysBodyKinematic Kinematic;
+			soda::FNavSynthState State;
+			if (!Synthesizer.MakeKinematic(double(SampleIndex - 1) * Dt, double(SampleIndex) * Dt, Kinematic, State))
+			{
+				continue;
+			}
+			const FSensorDataHeader Header{ State.Timestamp, State.FrameIndex };
+			if (bGnss)
+			{
+				PublishGnssData(Dt, Header, RelativeTransform, Kinematic);
+			}
+			else
+			{
+				PublishSensorData(Dt, Header, RelativeTransform, Kinematic);
+			}
+		}
+	};
+
+	Emit(ImuRate, ImuSampleIndex, false);
+	Emit(GnssRate, GnssSampleIndex, true);
 }
 
 void UNavSensor::SetImuNoiseParams(const FImuNoiseParams & NewImuNoiseParams)
 {
+	ASodaVehicle* Vehicle = GetVehicle();
+	if (!Vehicle)
+	{
+		UE_LOG(LogSoda, Warning, TEXT("UNavSensor::SetImuNoiseParams(); The sensor isn't attached to a vehicle"));
+		return;
+	}
+
+	FScopeLock ScopeLock(&Vehicle->PhysicMutex);
+
 	if (!bIsStoredParams)
 	{
 		StoredParams = NoiseParams;
 		bIsStoredParams = true;
 	}
 	NoiseParams = NewImuNoiseParams;
-	NoiseParams.UpdateParameters();
+	NoiseParams.UpdateParameters(soda::FNoiseStream::MakeKey(this));
 }
 
 void UNavSensor::RestoreBaseImuNoiseParams()
 {
+	ASodaVehicle* Vehicle = GetVehicle();
+	if (!Vehicle)
+	{
+		UE_LOG(LogSoda, Warning, TEXT("UNavSensor::RestoreBaseImuNoiseParams(); The sensor isn't attached to a vehicle"));
+		return;
+	}
+
+	FScopeLock ScopeLock(&Vehicle->PhysicMutex);
+
 	if (bIsStoredParams)
 	{
 		NoiseParams = StoredParams;
-		NoiseParams.UpdateParameters();
+		NoiseParams.UpdateParameters(soda::FNoiseStream::MakeKey(this));
 		bIsStoredParams = false;
 	}
 }
@@ -60,7 +178,11 @@ void UNavSensor::PostPhysicSimulationDeferred(float DeltaTime, const FPhysBodyKi
 
 	StoredBodyKinematic = VehicleKinematic;
 
-	if (HealthIsWorkable())
+	if (bHighRateSynthesis)
+	{
+		Synthesizer.Push(Timestamp, GetHeaderVehicleThread().FrameIndex, VehicleKinematic);
+	}
+	else if (HealthIsWorkable())
 	{
 		PublishSensorData(DeltaTime, GetHeaderVehicleThread(), GetRelativeTransform(), VehicleKinematic);
 	}
@@ -40,7 +40,7 @@ bool URacingSensor::OnActivateVehicleComponent()
 	SensorData.CoveredDistanceCurrentLap = 0;
 	SensorData.CoveredDistanceFull = 0;
 	SensorData.LapCaunter = -1;
-	SensorData.StartTimestemp = soda::Now();
+	SensorData.StartTimestemp = SodaApp.GetSimulationTimestamp();
 
 	return true;
 }
@@ -67,7 +67,7 @@ void URacingSensor::OnLapCounterTriggerBeginOverlap(ALapCounter* LapCounter, con
 {
 	++SensorData.LapCaunter;
 	SensorData.CoveredDistanceCurrentLap = 0;
-	SensorData.LapTimestemp = soda::Now();
+	SensorData.LapTimestemp = SodaApp.GetSimulationTimestamp();
 }
 
 void URacingSensor::DrawDebug(UCanvas* Canvas, float& YL, float& YPos)
@@ -14,6 +14,7 @@
 #include "Soda/Vehicles/SodaVehicle.h"
 #include "Soda/Misc/MeshGenerationUtils.h"
 #include "Soda/SodaCommonSettings.h"
+#include "Soda/SodaSensorEnvironment.h"
 #include "DynamicMeshBuilder.h"
 
 #define _DEG2RAD(a) ((a) / (180.0 / M_PI))
@@ -80,7 +81,7 @@ bool URadarSensor::OnActivateVehicleComponent()
 	}
 
 	PrevTickTime = SodaApp.GetSimulationTimestamp();
-
+	NoiseStream = soda::FNoiseStream(soda::FNoiseStream::MakeKey(this));
 
 	MarkRenderStateDirty();
 
@@ -116,11 +117,20 @@ void URadarSensor::TickComponent(float DeltaTime, ELevelTick TickType, FActorCom
 	Clusters.Clear();
 	Objects.ResetScan();
 
-	for (auto& It : GetRadarParams())
+	const FSensorDataHeader Header = GetHeaderGameThread();
+	Weather = bWeatherDegradation ? USodaSensorEnvironment::GetWeather(this) : soda::FSensorWeather{};
+	WeatherAttenuation = Weather.GetRadarAttenuation() * 4.6052e-6f; // 10^(-2 * A[dB/km] * D[km] / 10) = exp(-A * 0.2 * ln(10) * 1e-5 * D[cm])
+
+	const TArray<FRadarParams>& RadarParams = GetRadarParams();
+	for (int i = 0; i < RadarParams.Num(); ++i)
 	{
-		if (It.bEnabled)
+		if (RadarParams[i].bEnabled)
 		{
-			ProcessRadarBeams(It);
+			ProcessRadarBeams(RadarParams[i]);
+			if (GetRadarMode() == ERadarMode::ClusterMode && Weather.RainRate > 0)
+			{
+				AddRainClutter(RadarParams[i], i, Header.FrameIndex);
+			}
 		}
 	}
 
@@ -134,7 +144,7 @@ void URadarSensor::TickComponent(float DeltaTime, ELevelTick TickType, FActorCom
 		break;
 	}
 
-	PublishSensorData(DeltaTime, GetHeaderGameThread(), Clusters, Objects);
+	PublishSensorData(DeltaTime, Header, Clusters, Objects);
 
 	if (bDrawDebugPrimitives)
 	{
@@ -228,6 +238,10 @@ void URadarSensor::ProcessHit(const FHitResult* Hit, const FRadarParams* Params)
 	}
 
 	RadarHit.RCS = ObjectCategories[RadarHit.ObjectCategory].RCS;
+	if (WeatherAttenuation > 0)
+	{
+		RadarHit.RCS *= FMath::Exp(-WeatherAttenuation * RadarHit.Distance);
+	}
 	if (RadarHit.RCS < Params->MinSignalCoef)
 	{
 		//	UE_LOG(SodaRadar, Log, TEXT("Radar: Yaw = %f, RCS = %f"), HitRot.Yaw, RCS);
@@ -251,6 +265,40 @@ void URadarSensor::ProcessHit(const FHitResult* Hit, const FRadarParams* Params)
 	}
 }
 
+void URadarSensor::AddRainClutter(const FRadarParams& Params, int ParamsIndex, uint64 Frame)
+{
+	static constexpr int MaxClutterNum = 32;
+
+	float Samples[1 + MaxClutterNum * 2];
+	NoiseStream.Uniform(Frame, ParamsIndex, 0, Samples, UE_ARRAY_COUNT(Samples));
+
+	const float DistanceMin = Params.DistanceMin;
+	const float DistanceMax = FMath::Min(RainClutterDistance, Params.DistanceMax);
+	if (DistanceMax <= DistanceMin || RainClutterRCS < Params.MinSignalCoef)
+	{
+		return;
+	}
+
+	const int ClutterNum = FMath::Min(int(RainClutterDensity * Weather.RainRate + Samples[0]), MaxClutterNum);
+	const FTransform& Transform = GetComponentTransform();
+	const FVector Velocity = Transform.InverseTransformVectorNoScale(-GetVehicle()->GetVelocity()) * 0.01f;
+
+	for (int i = 0; i < ClutterNum; ++i)
+	{
+		const float Azimuth = FMath::Lerp(-Params.FOV_HorizontMax, Params.FOV_HorizontMax, Samples[1 + i * 2]);
+		const float Distance = FMath::Lerp(DistanceMin, DistanceMax, Samples[2 + i * 2]);
+
+		FRadarCluster& Cluster = Clusters.Clusters.Add_GetRef(FRadarCluster());
+		Cluster.Azimuth = Azimuth;
+		Cluster.Distance = Distance;
+		Cluster.LocalHitPosition = FRotator(0.f, Azimuth, 0.f).RotateVector(FVector(Distance * 100, 0, 0));
+		Cluster.HitPosition = Transform.TransformPosition(Cluster.LocalHitPosition);
+		Cluster.RCS = RainClutterRCS;
+		Cluster.Lat = Velocity.Y;
+		Cluster.Lon = Velocity.X;
+	}
+}
+
 void URadarSensor::ShowDebudPoints()
 {
 	
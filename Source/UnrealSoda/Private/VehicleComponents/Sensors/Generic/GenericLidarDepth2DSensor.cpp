@@ -33,21 +33,34 @@ bool UGenericLidarDepth2DSensor::OnActivateVehicleComponent()
 		return false;
 	}
 
-	LidarRays.SetNum(Channels * Step);
-
-	for (int v = 0; v < Channels; ++v)
+	if (!CompileScanPattern())
 	{
-		const float AngleY = FOV_VerticalMin + (FOV_VerticalMax - FOV_VerticalMin) / (float)(Channels - 1) * (float)v;
-		for (int u = 0; u < Step; ++u)
-		{
-			auto& Ray = LidarRays[Step * v + u] = FVector::ForwardVector;
+		return false;
+	}
 
-			const float AngleX = FOV_HorizontMin + (FOV_HorizontMax - FOV_HorizontMin) / (float)(Step - 1) * (float)u;
-			//const float LenCoef = cos(FMath::DegreesToRadians(AngleX)) * cos(FMath::DegreesToRadians(AngleY));
+	if (ScanTable)
+	{
+		// GenerateUVs() rescales the rays, so the sensor keeps its own copy of the shared table
+		LidarRays = ScanTable->Directions;
+	}
+	else
+	{
+		LidarRays.SetNum(Channels * Step);
 
-			Ray = Ray.RotateAngleAxis(AngleY, FVector(0.f, 1.f, 0.f));
-			Ray = Ray.RotateAngleAxis(AngleX, FVector(0.f, 0.f, 1.f));
-			//Ray = Ray / LenCoef;
+		for (int v = 0; v < Channels; ++v)
+		{
+			const float AngleY = FOV_VerticalMin + (FOV_VerticalMax - FOV_VerticalMin) / (float)(Channels - 1) * (float)v;
+			for (int u = 0; u < Step; ++u)
+			{
+				auto& Ray = LidarRays[Step * v + u] = FVector::ForwardVector;
+
+				const float AngleX = FOV_HorizontMin + (FOV_HorizontMax - FOV_HorizontMin) / (float)(Step - 1) * (float)u;
+				//const float LenCoef = cos(FMath::DegreesToRadians(AngleX)) * cos(FMath::DegreesToRadians(AngleY));
+
+				Ray = Ray.RotateAngleAxis(AngleY, FVector(0.f, 1.f, 0.f));
+				Ray = Ray.RotateAngleAxis(AngleX, FVector(0.f, 0.f, 1.f));
+				//Ray = Ray / LenCoef;
+			}
 		}
 	}
 
@@ -16,21 +16,39 @@ bool UGenericLidarDepthCubeSensor::OnActivateVehicleComponent()
 		return false;
 	}
 
-	LidarRays.SetNum(Channels * Step);
+	if (!CompileScanPattern())
+	{
+		return false;
+	}
 
-	for (int v = 0; v < Channels; ++v)
+	if (ScanTable)
+	{
+		// Rays are scaled to the unit depth plane, so the sensor keeps its own copy of the shared table
+		LidarRays = ScanTable->Directions;
+		for (auto& Ray : LidarRays)
+		{
+			// cos(Azimuth) * cos(Elevation) of the unit ray
+			Ray = Ray / Ray.X;
+		}
+	}
+	else
 	{
-		const float AngleY = FOV_VerticalMin + (FOV_VerticalMax - FOV_VerticalMin) / (float)(Channels - 1) * (float)v;
-		for (int u = 0; u < Step; ++u)
+		LidarRays.SetNum(Channels * Step);
+
+		for (int v = 0; v < Channels; ++v)
 		{
-			auto& Ray = LidarRays[Step * v + u];
+			const float AngleY = FOV_VerticalMin + (FOV_VerticalMax - FOV_VerticalMin) / (float)(Channels - 1) * (float)v;
+			for (int u = 0; u < Step; ++u)
+			{
+				auto& Ray = LidarRays[Step * v + u];
 
-			const float AngleX = FOV_HorizontMin + (FOV_HorizontMax - FOV_HorizontMin) / (float)(Step - 1) * (float)u;
-			const float LenCoef = cos(FMath::DegreesToRadians(AngleX)) * cos(FMath::DegreesToRadians(AngleY));
+				const float AngleX = FOV_HorizontMin + (FOV_HorizontMax - FOV_HorizontMin) / (float)(Step - 1) * (float)u;
+				const float LenCoef = cos(FMath::DegreesToRadians(AngleX)) * cos(FMath::DegreesToRadians(AngleY));
 
-			Ray = Ray.RotateAngleAxis(AngleY, FVector(0.f, 1.f, 0.f));
-			Ray = Ray.RotateAngleAxis(AngleX, FVector(0.f, 0.f, 1.f));
-			Ray = Ray / LenCoef;
+				Ray = Ray.RotateAngleAxis(AngleY, FVector(0.f, 1.f, 0.f));
+				Ray = Ray.RotateAngleAxis(AngleX, FVector(0.f, 0.f, 1.f));
+				Ray = Ray / LenCoef;
+			}
 		}
 	}
 
@@ -16,13 +16,22 @@ bool UGenericLidarRayTraceSensor::OnActivateVehicleComponent()
 		return false;
 	}
 
-	for (int i = 0; i < Channels; i++)
+	if (!CompileScanPattern())
 	{
-		const float VerticalAng = FOV_VerticalMin + (FOV_VerticalMax - FOV_VerticalMin) / (float)Channels * (float)i;
-		for (int j = 0; j < Step; j++)
+		return false;
+	}
+
+	// The rays are taken from ScanTable if the scan pattern is enabled
+	if (!ScanTable)
+	{
+		for (int i = 0; i < Channels; i++)
 		{
-			const float HorizontAng = FOV_HorizontMin + (FOV_HorizontMax - FOV_HorizontMin) / (float)Step * (float)j;
-			LidarRays.Add(FRotator(VerticalAng, HorizontAng, 0.0f).RotateVector(FVector(1.0, 0.0, 0.0)));
+			const float VerticalAng = FOV_VerticalMin + (FOV_VerticalMax - FOV_VerticalMin) / (float)Channels * (float)i;
+			for (int j = 0; j < Step; j++)
+			{
+				const float HorizontAng = FOV_HorizontMin + (FOV_HorizontMax - FOV_HorizontMin) / (float)Step * (float)j;
+				LidarRays.Add(FRotator(VerticalAng, HorizontAng, 0.0f).RotateVector(FVector(1.0, 0.0, 0.0)));
+			}
 		}
 	}
 
@@ -30,8 +30,6 @@ bool UCSVLoggerSensorComponent::OnActivateVehicleComponent()
 	}
 
 	OutFile << "LocX,LocY,LocZ,Heading,Pitch,Roll,VelEast,VelNorth,VelDown,AccX,AccY,AccZ,GyroX,GyroY,GyroZ,Lon,Lat,Alt,Timestemp\n";
-		
-	NoiseParams.UpdateParameters();
 
 	return true;
 }
@@ -1,10 +1,9 @@
 // Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
 
 #include "Soda/VehicleComponents/Sensors/Implementation/GPSDSensor.h"
-#include "Soda/VehicleComponents/Sensors/Implementation/OXTS/NComRxC.h"
-#include "Soda/VehicleComponents/Sensors/Implementation/OXTS/NComRxDefines.h"
 #include "Soda/UnrealSoda.h"
 #include "Soda/LevelState.h"
+#include "Soda/SodaApp.h"
 #include "Dom/JsonValue.h"
 #include "Dom/JsonObject.h"
 #include "HAL/PlatformProcess.h"
@@ -12,8 +11,6 @@
 #include "Serialization/JsonSerializer.h"
 #include "HAL/UnrealMemory.h"
 #include "Policies/CondensedJsonPrintPolicy.h"
-#include "Serialization/JsonWriter.h"
-#include <ctime>
 
 UGpsDSensorComponent::UGpsDSensorComponent(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -64,6 +61,11 @@ bool UGpsDSensorComponent::OnActivateVehicleComponent()
 		return false;
 	}
 
+	Encoder.SetDevice(DeviceName);
+	FanOutTask = MakeShared<soda::FNavFanOutAsyncTask>([this](const TArray<uint8>& Frame) { FanOut(Frame); });
+	FanOutTask->Start();
+	SodaApp.EthTaskManager.AddTask(FanOutTask);
+
 	return true;
 }
 
@@ -75,6 +77,13 @@ void UGpsDSensorComponent::OnDeactivateVehicleComponent()
 
 void UGpsDSensorComponent::Shutdown()
 {
+	if (FanOutTask)
+	{
+		FanOutTask->Finish();
+		SodaApp.EthTaskManager.RemoteTask(FanOutTask);
+		FanOutTask.Reset();
+	}
+
 	Mutex.lock();
 	for (FGpsDConnection& Connection : Connections)
 	{
@@ -109,29 +118,41 @@ void UGpsDSensorComponent::DrawDebug(UCanvas* Canvas, float& YL, float& YPos)
 
 bool UGpsDSensorComponent::PublishSensorData(float DeltaTime, const FSensorDataHeader& Header, const FTransform& RelativeTransform, const FPhysBodyKinematic& VehicleKinematic)
 {
-	if (!TcpListener || !TcpListener->IsActive() || !GetLevelState())
+	return PublishReports(Header, VehicleKinematic, false);
+}
+
+bool UGpsDSensorComponent::PublishGnssData(float DeltaTime, const FSensorDataHeader& Header, const FTransform& RelativeTransform, const FPhysBodyKinematic& VehicleKinematic)
+{
+	return PublishReports(Header, VehicleKinematic, true);
+}
+
+bool UGpsDSensorComponent::PublishReports(const FSensorDataHeader& Header, const FPhysBodyKinematic& VehicleKinematic, bool bGnssReports)
+{
+	if (!TcpListener || !TcpListener->IsActive() || !FanOutTask || !GetLevelState())
 	{
 		return false;
 	}
 
-	VehicleKinematic.CalcIMU(GetRelativeTransform(), WorldPose, WorldVel, LocalAcc, Gyro);
-	WorldRot = WorldPose.Rotator();
-	WorldLoc = WorldPose.GetTranslation();
-	Timestamp = Header.Timestamp;
+	soda::FNavSolution Nav;
+	Nav.TimestampMs = soda::RawTimestamp<std::chrono::milliseconds>(Header.Timestamp);
+
+	FTransform WorldPose;
+	VehicleKinematic.CalcIMU(GetRelativeTransform(), WorldPose, Nav.WorldVel, Nav.LocalAcc, Nav.Gyro);
+	Nav.WorldRot = WorldPose.Rotator();
+	FVector WorldLoc = WorldPose.GetTranslation();
 
 	if (bImuNoiseEnabled)
 	{
 		FVector RotNoize = NoiseParams.Rotation.Step();
-		WorldRot += FRotator(RotNoize.Y, RotNoize.Z, RotNoize.X);
+		Nav.WorldRot += FRotator(RotNoize.Y, RotNoize.Z, RotNoize.X);
 		WorldLoc += NoiseParams.Location.Step() * 100;
-		LocalAcc += NoiseParams.Acceleration.Step() * 100;
-		WorldVel += NoiseParams.Velocity.Step() * 100;
-		Gyro += NoiseParams.Gyro.Step();
+		Nav.LocalAcc += NoiseParams.Acceleration.Step() * 100;
+		Nav.WorldVel += NoiseParams.Velocity.Step() * 100;
+		Nav.Gyro += NoiseParams.Gyro.Step();
 	}
-	WorldRot = GetLevelState()->GetLLConverter().ConvertRotationForward(WorldRot);
-	WorldVel = GetLevelState()->GetLLConverter().ConvertDirForward(WorldVel);
-	CurVehicleKinematic = VehicleKinematic;
-	GetLevelState()->GetLLConverter().UE2LLA(WorldLoc, Lon, Lat, Alt);
+	Nav.WorldRot = GetLevelState()->GetLLConverter().ConvertRotationForward(Nav.WorldRot);
+	Nav.WorldVel = GetLevelState()->GetLLConverter().ConvertDirForward(Nav.WorldVel);
+	GetLevelState()->GetLLConverter().UE2LLA(WorldLoc, Nav.Lon, Nav.Lat, Nav.Alt);
 
 	Mutex.lock();
 	for (size_t i = 0; i < Connections.Num();/*Nothing here*/)
@@ -153,37 +174,47 @@ bool UGpsDSensorComponent::PublishSensorData(float DeltaTime, const FSensorDataH
 
 	std::chrono::milliseconds WatcherModePeriod_(int64(WatcherModePeriod * 1000 + 0.5));
 
-	auto SendDeltaTime = Header.Timestamp - PrevSendTimeMark;
-	if (SendDeltaTime >= WatcherModePeriod_)
-	{
-		if (SendDeltaTime < WatcherModePeriod_)
-			PrevSendTimeMark += WatcherModePeriod_;
-		else
-			PrevSendTimeMark = Header.Timestamp;
+	Encoder.BeginFrame();
 
-		for (size_t i = 0; i < Connections.Num(); ++i)
+	if (bGnssReports)
+	{
+		// Called at GnssRate, which replaces the WatcherModePeriod for the GNSS reports
+		if(bWatcherModeSKY) Encoder.AppendSKY();
+		if(bWatcherModeTPV) Encoder.AppendTPV(Nav);
+	}
+	else
+	{
+		auto SendDeltaTime = Header.Timestamp - PrevSendTimeMark;
+		if (SendDeltaTime >= WatcherModePeriod_)
 		{
-			if (Connections[i].WatcherMode && Connections[i].WatcherJson)
-			{
-				if (bLogTcpDebugOutput)
-					UE_LOG(LogSoda, Log, TEXT("UGpsDSensorComponent::UpdateImu(): Send data to connection[%d] by Watcher mode"), i);
+			if (SendDeltaTime < WatcherModePeriod_)
+				PrevSendTimeMark += WatcherModePeriod_;
+			else
+				PrevSendTimeMark = Header.Timestamp;
 
-				if(bWatcherModeSKY) SendSKY(Connections[i]);
-				if(bWatcherModeTPV) SendTPV(Connections[i]);
-				if(bWatcherModeATT) SendATT_IMU(Connections[i], true);
+			// With bHighRateSynthesis the GNSS reports are sent by PublishGnssData()
+			if (!bHighRateSynthesis)
+			{
+				if(bWatcherModeSKY) Encoder.AppendSKY();
+				if(bWatcherModeTPV) Encoder.AppendTPV(Nav);
 			}
+			if(bWatcherModeATT) Encoder.AppendATT_IMU(Nav, true);
+		}
+
+		if (bWatcherModeIMU)
+		{
+			Encoder.AppendATT_IMU(Nav, false);
 		}
 	}
 
-	if (bWatcherModeIMU)
+	const bool bHasWatchers = Connections.ContainsByPredicate([](const FGpsDConnection& Connection) { return Connection.WatcherMode && Connection.WatcherJson; });
+	if (bHasWatchers && Encoder.GetFrame().Num() > 0)
 	{
-		for (size_t i = 0; i < Connections.Num(); ++i)
+		if (!FanOutTask->Publish(Encoder.GetFrame()))
 		{
-			if (Connections[i].WatcherMode && Connections[i].WatcherJson)
-			{
-				SendATT_IMU(Connections[i], false);
-			}
+			UE_LOG(LogSoda, Warning, TEXT("UGpsDSensorComponent::PublishSensorData(). Skipped one frame"));
 		}
+		SodaApp.EthTaskManager.Trigger();
 	}
 
 	for (int i = 0; i < Connections.Num(); ++i)
@@ -302,176 +333,21 @@ bool UGpsDSensorComponent::OnConnected(FSocket* ClientSocket, const FIPv4Endpoin
 	return true;
 }
 
-void UGpsDSensorComponent::SendTPV(FGpsDConnection& Connection)
+void UGpsDSensorComponent::FanOut(const TArray<uint8>& Frame)
 {
-	TSharedPtr<FJsonObject> TPVObject = MakeShareable(new FJsonObject);
-	
-	TPVObject->SetStringField("class", "TPV");
-	TPVObject->SetStringField("device", DeviceName);
-	TPVObject->SetNumberField("status", 2);
-	char time[100];
-	SPrintfFormatedTime(soda::RawTimestamp<std::chrono::milliseconds>(Timestamp), time);
-	TPVObject->SetStringField("time", time);
-	TPVObject->SetNumberField("leapseconds", 18);
-	TPVObject->SetNumberField("mode", 3);
-	TPVObject->SetNumberField("lat", Lat);
-	TPVObject->SetNumberField("lon", Lon);
-	TPVObject->SetNumberField("alt", Alt);
-	float Track = WorldVel.Rotation().Yaw - 90.f;
-	Track = Track < 0.f ? Track + 360.f : Track > 360.f ? Track - 360.f : Track;
-	TPVObject->SetNumberField("track", Track);
-	TPVObject->SetNumberField("speed", FVector2D(WorldVel).Size() / 100.f);
-	TPVObject->SetNumberField("climb", WorldVel.Z / 100.f);
-	
-	TPVObject->SetNumberField(TEXT("ept"), 0.005);
-	TPVObject->SetNumberField(TEXT("epx") , 13.725);
-	TPVObject->SetNumberField(TEXT("epy") , 13.949);
-	TPVObject->SetNumberField(TEXT("epv") , 5.808);
-	TPVObject->SetNumberField(TEXT("epd") , 71.0492);
-	TPVObject->SetNumberField(TEXT("eps") , 0.03);
-	TPVObject->SetNumberField(TEXT("epc") , 298.04);
-	TPVObject->SetNumberField(TEXT("ecefx") , 3926933.52);
-	TPVObject->SetNumberField(TEXT("ecefy") , -91416.57);
-	TPVObject->SetNumberField(TEXT("ecefz") , 5008412.79);
-	TPVObject->SetNumberField(TEXT("ecefvx") , -0.07);
-	TPVObject->SetNumberField(TEXT("ecefvy") , -0.01);
-	TPVObject->SetNumberField(TEXT("ecefvz") , -0.04);
-	TPVObject->SetNumberField(TEXT("ecefpAcc") , 7.76);
-	TPVObject->SetNumberField(TEXT("ecefvAcc") , 0.21);
-	TPVObject->SetNumberField(TEXT("eph") , 5.150);
-//	TPVObject->SetNumberField(TEXT("sep") , 1899.810);
-	
-	
-	FString JsonString;
-	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&JsonString);
-	if (FJsonSerializer::Serialize(TPVObject.ToSharedRef(), Writer))
+	std::lock_guard<std::mutex> Lock(Mutex);
+	for (int i = 0; i < Connections.Num(); ++i)
 	{
-		Send(Connection, JsonString + TEXT("\r\n"));
-	}
-}
-
-void UGpsDSensorComponent::SendATT_IMU(FGpsDConnection& Connection, bool bIsATT)
-{
-	int64 TimestampMs = soda::RawTimestamp<std::chrono::milliseconds>(Timestamp);
-
-	TSharedPtr<FJsonObject> TPVObject = MakeShareable(new FJsonObject);
-	TPVObject->SetStringField("class", bIsATT ? "ATT" : "IMU");
-	TPVObject->SetStringField("device", DeviceName);
-	time_t CurTime = TimestampMs / 1000;
-	tm* ptm = std::gmtime(&CurTime);
-	char time[100];
-	SPrintfFormatedTime(TimestampMs, time);
-	TPVObject->SetStringField("time", time);
-	float Heading = WorldRot.Yaw - 90.f;
-	Heading = Heading < 0.f ? Heading + 360.f : Heading > 360.f ? Heading - 360.f : Heading;
-	TPVObject->SetNumberField("heading", Heading);
-	TPVObject->SetNumberField("pitch", WorldRot.Pitch);
-	TPVObject->SetStringField("pitch_st", "N");
-	TPVObject->SetNumberField("roll", WorldRot.Roll);
-	TPVObject->SetStringField("roll_st", "N");
-	TPVObject->SetNumberField("yaw", WorldRot.Yaw);
-	TPVObject->SetStringField("yaw_st", "N");
-	TPVObject->SetNumberField("acc_len", LocalAcc.Size() / 100.0);
-	TPVObject->SetNumberField("acc_x", -LocalAcc.X / 100.0);
-	TPVObject->SetNumberField("acc_y", -LocalAcc.Y / 100.0);
-	TPVObject->SetNumberField("acc_z", LocalAcc.Z / 100.0);
-	TPVObject->SetNumberField("gyro_x", -Gyro.X);
-	TPVObject->SetNumberField("gyro_y", -Gyro.Y);
+		if (Connections[i].WatcherMode && Connections[i].WatcherJson && !Connections[i].SocketDead)
+		{
+			if (bLogTcpDebugOutput)
+				UE_LOG(LogSoda, Log, TEXT("UGpsDSensorComponent::FanOut(): Send data to connection[%d] by Watcher mode"), i);
 
-	FString JsonString;
-	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&JsonString);
-	if (FJsonSerializer::Serialize(TPVObject.ToSharedRef(), Writer))
-	{
-		Send(Connection, JsonString + TEXT("\r\n"));
+			Send(Connections[i], Frame.GetData(), Frame.Num());
+		}
 	}
 }
 
-void UGpsDSensorComponent::SendSKY(FGpsDConnection& Connection)
-{
-	TSharedPtr<FJsonObject> SKYObject = MakeShareable(new FJsonObject);
-	SKYObject->SetStringField("class", "SKY");
-	SKYObject->SetStringField("device", DeviceName);
-	//time_t CurTime = Timestamp / 1000;
-	//tm* ptm = std::gmtime(&CurTime);
-	//char time[100];
-	//SPrintfFormatedTime(Timestamp, time);
-	//SKYObject->SetStringField("time", time);
-	SKYObject->SetNumberField("xdop", 0.76);
-	SKYObject->SetNumberField("ydop", 0.61);
-	SKYObject->SetNumberField("vdop", 1.03);
-	SKYObject->SetNumberField("tdop", 0.74);
-	SKYObject->SetNumberField("hdop", 0.89);
-	SKYObject->SetNumberField("gdop", 1.55);
-	SKYObject->SetNumberField("pdop", 1.37);
-
-	TArray<TSharedPtr<FJsonValue> > SatellitesArray;
-
-	TSharedPtr<FJsonObject> SatelliteObject1 = MakeShareable(new FJsonObject);
-	SatelliteObject1->SetNumberField("PRN", 1);
-	SatelliteObject1->SetNumberField("el", 85);
-	SatelliteObject1->SetNumberField("az", 349);
-	SatelliteObject1->SetNumberField("ss", 38);
-	SatelliteObject1->SetBoolField("used", true);
-	SatelliteObject1->SetNumberField("gnssid", 0);
-	SatelliteObject1->SetNumberField("svid", 1);
-	TSharedRef< FJsonValueObject > JsonDeviceValue1 = MakeShareable(new FJsonValueObject(SatelliteObject1));
-	SatellitesArray.Add(JsonDeviceValue1);
-
-	TSharedPtr<FJsonObject> SatelliteObject2 = MakeShareable(new FJsonObject);
-	SatelliteObject2->SetNumberField("PRN", 3);
-	SatelliteObject2->SetNumberField("el", 57);
-	SatelliteObject2->SetNumberField("az", 224);
-	SatelliteObject2->SetNumberField("ss", 36);
-	SatelliteObject2->SetBoolField("used", true);
-	SatelliteObject2->SetNumberField("gnssid", 0);
-	SatelliteObject2->SetNumberField("svid", 3);
-	TSharedRef< FJsonValueObject > JsonDeviceValue2 = MakeShareable(new FJsonValueObject(SatelliteObject2));
-	SatellitesArray.Add(JsonDeviceValue2);
-
-	TSharedPtr<FJsonObject> SatelliteObject3 = MakeShareable(new FJsonObject);
-	SatelliteObject3->SetNumberField("PRN", 4);
-	SatelliteObject3->SetNumberField("el", 2);
-	SatelliteObject3->SetNumberField("az", 180);
-	SatelliteObject3->SetNumberField("ss", 42);
-	SatelliteObject3->SetBoolField("used", true);
-	SatelliteObject3->SetNumberField("gnssid", 0);
-	SatelliteObject3->SetNumberField("svid", 4);
-	TSharedRef< FJsonValueObject > JsonDeviceValue3 = MakeShareable(new FJsonValueObject(SatelliteObject3));
-	SatellitesArray.Add(JsonDeviceValue3);
-
-	TSharedPtr<FJsonObject> SatelliteObject4 = MakeShareable(new FJsonObject);
-	SatelliteObject4->SetNumberField("PRN", 6);
-	SatelliteObject4->SetNumberField("el", 25);
-	SatelliteObject4->SetNumberField("az", 132);
-	SatelliteObject4->SetNumberField("ss", 42);
-	SatelliteObject4->SetBoolField("used", true);
-	SatelliteObject4->SetNumberField("gnssid", 0);
-	SatelliteObject4->SetNumberField("svid", 8);
-	TSharedRef< FJsonValueObject > JsonDeviceValue4 = MakeShareable(new FJsonValueObject(SatelliteObject4));
-	SatellitesArray.Add(JsonDeviceValue4);
-
-	TSharedPtr<FJsonObject> SatelliteObject5 = MakeShareable(new FJsonObject);
-	SatelliteObject5->SetNumberField("PRN", 9);
-	SatelliteObject5->SetNumberField("el", 7);
-	SatelliteObject5->SetNumberField("az", 94);
-	SatelliteObject5->SetNumberField("ss",42);
-	SatelliteObject5->SetBoolField("used", true);
-	SatelliteObject5->SetNumberField("gnssid", 0);
-	SatelliteObject5->SetNumberField("svid", 12);
-	TSharedRef< FJsonValueObject > JsonDeviceValue5 = MakeShareable(new FJsonValueObject(SatelliteObject5));
-	SatellitesArray.Add(JsonDeviceValue5);
-
-	SKYObject->SetArrayField("satellites", SatellitesArray);
-
-	FString JsonString;
-	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&JsonString);
-	if (FJsonSerializer::Serialize(SKYObject.ToSharedRef(), Writer))
-	{
-		Send(Connection, JsonString + TEXT("\r\n"));
-	}
-
-} 
-
 void UGpsDSensorComponent::SendVersion(FGpsDConnection& Connection)
 {
 	TSharedPtr<FJsonObject> VerObject = MakeShareable(new FJsonObject);
@@ -537,16 +413,24 @@ void UGpsDSensorComponent::SendDevices(FGpsDConnection& Connection)
 
 bool UGpsDSensorComponent::Send(FGpsDConnection &Connection, const FString& Data)
 {
-	if (Connection.ConnectionSocket)
+	const FTCHARToUTF8 Utf8(*Data);
+	const bool res = Send(Connection, (const uint8*)Utf8.Get(), Utf8.Length());
+	if (bLogTcpDebugOutput)
 	{
-		TArray<char> ByteArray;
+		UE_LOG(LogSoda, Log, TEXT("UGpsDSensorComponent::Send: String = %s"), *Data);
+	}
+	return res;
+}
 
-		ByteArray.Append(TCHAR_TO_ANSI(*Data), Data.Len());
+bool UGpsDSensorComponent::Send(FGpsDConnection& Connection, const uint8* Data, int Size)
+{
+	if (Connection.ConnectionSocket)
+	{
 		int32 BytesSent;
-		bool res = Connection.ConnectionSocket->SendTo((uint8*)ByteArray.GetData(), ByteArray.Num(), BytesSent, *Connection.ConnectionAddress);
+		bool res = Connection.ConnectionSocket->SendTo(Data, Size, BytesSent, *Connection.ConnectionAddress);
 		if (bLogTcpDebugOutput || (!res && bBaseDebugOutput))
 		{
-			UE_LOG(LogSoda, Log, TEXT("UGpsDSensorComponent::Send: returned %d, Size = %d, bytes sent = %d, String = %s"), (int)res, ByteArray.Num(), BytesSent, *Data);
+			UE_LOG(LogSoda, Log, TEXT("UGpsDSensorComponent::Send: returned %d, Size = %d, bytes sent = %d"), (int)res, Size, BytesSent);
 		}
 		if (!res)
 			Connection.SocketDead = true;
@@ -554,18 +438,3 @@ bool UGpsDSensorComponent::Send(FGpsDConnection &Connection, const FString& Data
 	}
 	return false;
 }
-
-void UGpsDSensorComponent::SPrintfFormatedTime(int64_t TimestampIn, char* Buffer)
-{
-#if PLATFORM_LINUX
-	time_t CurTime = TimestampIn / 1000;
-	tm* ptm = std::gmtime(&CurTime);
-	sprintf(Buffer, "%04d-%02d-%02dT%02d:%02d:%02d.%03ld", 1900 + ptm->tm_year, 1 + ptm->tm_mon, ptm->tm_mday, ptm->tm_hour, ptm->tm_min, ptm->tm_sec, TimestampIn % 1000);
-#else
-	time_t CurTime = TimestampIn / 1000;
-	tm ptm;
-	FMemory::Memzero(&ptm, sizeof(ptm));
-	gmtime_s(&ptm, &CurTime);
-	sprintf(Buffer, "%04d-%02d-%02dT%02d:%02d:%02d.%03lld", 1900 + ptm.tm_year, 1 + ptm.tm_mon, ptm.tm_mday, ptm.tm_hour, ptm.tm_min, ptm.tm_sec, TimestampIn % 1000);
-#endif
-}
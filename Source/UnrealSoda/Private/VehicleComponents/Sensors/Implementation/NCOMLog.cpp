@@ -0,0 +1,576 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/VehicleComponents/Sensors/Implementation/NCOMLog.h"
+#include "Soda/VehicleComponents/Sensors/Implementation/OXTS/NComRxDefines.h"
+#include "Soda/UnrealSoda.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/FileManager.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Algo/BinarySearch.h"
+
+DECLARE_STATS_GROUP(TEXT("NCOMLog"), STATGROUP_NCOMLog, STATGROUP_Advanced);
+DECLARE_CYCLE_STAT(TEXT("BuildIndex"), STAT_NCOMBuildIndex, STATGROUP_NCOMLog);
+DECLARE_CYCLE_STAT(TEXT("Decode"), STAT_NCOMDecode, STATGROUP_NCOMLog);
+DECLARE_CYCLE_STAT(TEXT("Sample"), STAT_NCOMSample, STATGROUP_NCOMLog);
+
+namespace soda
+{
+
+/***********************************************************************************************
+	NCOM packet
+***********************************************************************************************/
+
+namespace
+{
+	/** Reader of the little-endian NCOM fields, the counterpart of the FNCOMWriter of the FNCOMEncoder */
+	struct FNCOMReader
+	{
+		const uint8* Data;
+		int Offset = 0;
+
+		uint8 Get8() { return Data[Offset++]; }
+
+		uint16 Get16()
+		{
+			const uint16 Value = uint16(Data[Offset]) | (uint16(Data[Offset + 1]) << 8);
+			Offset += 2;
+			return Value;
+		}
+
+		int32 Get24()
+		{
+			const uint32 Value = uint32(Data[Offset]) | (uint32(Data[Offset + 1]) << 8) | (uint32(Data[Offset + 2]) << 16);
+			Offset += 3;
+			return int32(Value << 8) >> 8;
+		}
+
+		uint32 Get32()
+		{
+			const uint32 Low = Get16();
+			return Low | (uint32(Get16()) << 16);
+		}
+
+		float GetFloat()
+		{
+			const uint32 Bits = Get32();
+			float Value;
+			FMemory::Memcpy(&Value, &Bits, sizeof(Value));
+			return Value;
+		}
+
+		double GetDouble()
+		{
+			const uint64 Low = Get32();
+			const uint64 Bits = Low | (uint64(Get32()) << 32);
+			double Value;
+			FMemory::Memcpy(&Value, &Bits, sizeof(Value));
+			return Value;
+		}
+	};
+
+	/** Offsets of the checksums in the packet */
+	static constexpr int NCOMChecksum1 = 22;
+	static constexpr int NCOMChecksum2 = 61;
+	static constexpr int NCOMChecksum3 = 71;
+}
+
+bool DecodeNCOMPacket(const uint8* Data, FNCOMSample& OutSample)
+{
+	FNCOMReader Reader{ Data };
+
+	if (Reader.Get8() != NCOM_SYNC)
+	{
+		return false;
+	}
+
+	// Batch 1
+	OutSample.MinuteMs = Reader.Get16();
+	OutSample.LocalAcc.X = -Reader.Get24() * 100.0 * ACC2MPS2;
+	OutSample.LocalAcc.Y = -Reader.Get24() * 100.0 * ACC2MPS2;
+	OutSample.LocalAcc.Z = Reader.Get24() * 100.0 * ACC2MPS2;
+	OutSample.AngularVelocity.X = -Reader.Get24() * RATE2RPS;
+	OutSample.AngularVelocity.Y = -Reader.Get24() * RATE2RPS;
+	OutSample.AngularVelocity.Z = Reader.Get24() * RATE2RPS;
+	Reader.Offset = NCOMChecksum1 + 1;
+
+	// Batch 2
+	OutSample.Lat = Reader.GetDouble() / M_PI * 180;
+	OutSample.Lon = Reader.GetDouble() / M_PI * 180;
+	OutSample.Alt = Reader.GetFloat();
+	const int32 VelNorth = Reader.Get24();
+	const int32 VelEast = Reader.Get24();
+	const int32 VelDown = Reader.Get24();
+	OutSample.Vel.X = -VelEast * 100.0 * VEL2MPS;
+	OutSample.Vel.Y = VelNorth * 100.0 * VEL2MPS;
+	OutSample.Vel.Z = -VelDown * 100.0 * VEL2MPS;
+	OutSample.Rot.Yaw = Reader.Get24() * ANG2RAD / M_PI * 180.0 + 90;
+	OutSample.Rot.Pitch = Reader.Get24() * ANG2RAD / M_PI * 180.0;
+	OutSample.Rot.Roll = Reader.Get24() * ANG2RAD / M_PI * 180.0;
+	Reader.Offset = NCOMChecksum2 + 1;
+
+	// Batch 3, status channel
+	OutSample.Channel = Reader.Get8();
+	if (OutSample.Channel == 0)
+	{
+		OutSample.Status.GPSMinutes = int(Reader.Get32());
+		OutSample.Status.SatellitesNumber = Reader.Get8();
+		OutSample.Status.PositionMode = Reader.Get8();
+		OutSample.Status.VelocityMode = Reader.Get8();
+		OutSample.Status.OrientationMode = Reader.Get8();
+	}
+
+	return true;
+}
+
+bool IsValidNCOMPacket(const uint8* Data)
+{
+	if (Data[0] != NCOM_SYNC)
+	{
+		return false;
+	}
+
+	// Every checksum is the sum of all the bytes after the sync byte, including the previous checksums
+	uint8 Sum = 0;
+	for (int i = 1; i < FNCOMLogIndex::PacketSize; ++i)
+	{
+		if ((i == NCOMChecksum1 || i == NCOMChecksum2 || i == NCOMChecksum3) && Data[i] != Sum)
+		{
+			return false;
+		}
+		Sum += Data[i];
+	}
+	return true;
+}
+
+FNCOMSample LerpNCOMSample(const FNCOMSample& A, const FNCOMSample& B, float Alpha)
+{
+	FNCOMSample Sample = Alpha < 0.5f ? A : B;
+	Sample.Lat = FMath::Lerp(A.Lat, B.Lat, double(Alpha));
+	Sample.Lon = FMath::Lerp(A.Lon, B.Lon, double(Alpha));
+	Sample.Alt = FMath::Lerp(A.Alt, B.Alt, double(Alpha));
+	Sample.Rot = FQuat::Slerp(A.Rot.Quaternion(), B.Rot.Quaternion(), Alpha).Rotator();
+	Sample.Vel = FMath::Lerp(A.Vel, B.Vel, Alpha);
+	Sample.LocalAcc = FMath::Lerp(A.LocalAcc, B.LocalAcc, Alpha);
+	Sample.AngularVelocity = FMath::Lerp(A.AngularVelocity, B.AngularVelocity, Alpha);
+	return Sample;
+}
+
+/***********************************************************************************************
+	FNCOMLogIndex
+***********************************************************************************************/
+
+static constexpr uint32 NCOMIndexMagic = 0x58494E4E; // "NNIX"
+static constexpr int32 NCOMIndexVersion = 1;
+
+bool FNCOMLogIndex::Open(const FString& LogFileName)
+{
+	Reset();
+
+	const int64 LogSize = IFileManager::Get().FileSize(*LogFileName);
+	if (LogSize < 0)
+	{
+		UE_LOG(LogSoda, Error, TEXT("FNCOMLogIndex::Open(); Can't find \"%s\""), *LogFileName);
+		return false;
+	}
+	const FDateTime LogTimeStamp = IFileManager::Get().GetTimeStamp(*LogFileName);
+	const FString IndexFileName = LogFileName + TEXT(".idx");
+
+	if (Load(IndexFileName, LogSize, LogTimeStamp))
+	{
+		return true;
+	}
+
+	if (!Build(LogFileName))
+	{
+		return false;
+	}
+
+	if (!Save(IndexFileName, LogSize, LogTimeStamp))
+	{
+		UE_LOG(LogSoda, Warning, TEXT("FNCOMLogIndex::Open(); Can't save the index \"%s\""), *IndexFileName);
+	}
+	return true;
+}
+
+void FNCOMLogIndex::Reset()
+{
+	Entries.Reset();
+	Keyframes.Reset();
+	StartGPSTimeMs = 0;
+}
+
+bool FNCOMLogIndex::Build(const FString& LogFileName)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NCOMBuildIndex);
+
+	Reset();
+
+	TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*LogFileName));
+	if (!File)
+	{
+		UE_LOG(LogSoda, Error, TEXT("FNCOMLogIndex::Build(); Can't open \"%s\""), *LogFileName);
+		return false;
+	}
+
+	const int64 FileSize = File->Size();
+	Entries.Reserve(FileSize / PacketSize);
+
+	static constexpr int32 ChunkSize = 1024 * 1024;
+	TArray<uint8> Buffer;
+	Buffer.SetNumUninitialized(ChunkSize + PacketSize);
+	int64 BufferOffset = 0; // Offset of the Buffer[0] in the file
+	int32 BufferNum = 0;
+	int32 Pos = 0;
+
+	// GPS time [ms] is unwrapped from the ms of the minute; the minutes are corrected by every status channel 0
+	int64 Minutes = 0;
+	int64 MinutesShift = 0;
+	bool bHasMinutes = false;
+	int32 PrevMinuteMs = -1;
+	TArray<int64> GPSTimes;
+	GPSTimes.Reserve(FileSize / PacketSize);
+
+	FNCOMSample Sample;
+	while (true)
+	{
+		if (BufferNum - Pos < PacketSize)
+		{
+			const int32 Tail = BufferNum - Pos;
+			FMemory::Memmove(Buffer.GetData(), Buffer.GetData() + Pos, Tail);
+			BufferOffset += Pos;
+			Pos = 0;
+			const int64 ToRead = FMath::Min<int64>(ChunkSize, FileSize - BufferOffset - Tail);
+			if (ToRead <= 0 || !File->Read(Buffer.GetData() + Tail, ToRead))
+			{
+				break;
+			}
+			BufferNum = Tail + int32(ToRead);
+			continue;
+		}
+
+		const uint8* Packet = Buffer.GetData() + Pos;
+		if (!IsValidNCOMPacket(Packet))
+		{
+			++Pos;
+			continue;
+		}
+
+		DecodeNCOMPacket(Packet, Sample);
+
+		if (PrevMinuteMs >= 0 && Sample.MinuteMs < PrevMinuteMs)
+		{
+			++Minutes;
+		}
+		PrevMinuteMs = Sample.MinuteMs;
+
+		if (Sample.Channel == 0)
+		{
+			if (!bHasMinutes)
+			{
+				// The packets before the first status are counted from the zero minute
+				MinutesShift = Sample.Status.GPSMinutes - Minutes;
+				bHasMinutes = true;
+			}
+			Minutes = Sample.Status.GPSMinutes - MinutesShift;
+		}
+
+		const int64 GPSTime = Minutes * 60000 + Sample.MinuteMs;
+		if (GPSTimes.Num() == 0 || GPSTime > GPSTimes.Last())
+		{
+			GPSTimes.Add(GPSTime);
+			Entries.Add({ BufferOffset + Pos, 0 });
+			if (Sample.Channel == 0)
+			{
+				Keyframes.Add({ Entries.Num() - 1, Sample.Status });
+			}
+		}
+
+		Pos += PacketSize;
+	}
+
+	if (Entries.Num() == 0)
+	{
+		UE_LOG(LogSoda, Error, TEXT("FNCOMLogIndex::Build(); There are no valid NCOM packets in \"%s\""), *LogFileName);
+		return false;
+	}
+
+	for (int32 i = 0; i < Entries.Num(); ++i)
+	{
+		Entries[i].Time = (GPSTimes[i] - GPSTimes[0]) * 0.001;
+	}
+	StartGPSTimeMs = bHasMinutes ? GPSTimes[0] + MinutesShift * 60000 : 0;
+
+	UE_LOG(LogSoda, Log, TEXT("FNCOMLogIndex::Build(); \"%s\": %i packets, %i keyframes, %.1fs"), *LogFileName, Entries.Num(), Keyframes.Num(), GetDuration());
+	return true;
+}
+
+bool FNCOMLogIndex::Load(const FString& IndexFileName, int64 LogSize, const FDateTime& LogTimeStamp)
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *IndexFileName, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader Ar(Data);
+	uint32 Magic = 0;
+	int32 Version = 0;
+	int64 IndexedLogSize = 0;
+	FDateTime IndexedLogTimeStamp;
+	Ar << Magic << Version << IndexedLogSize << IndexedLogTimeStamp;
+	if (Ar.IsError() || Magic != NCOMIndexMagic || Version != NCOMIndexVersion || IndexedLogSize != LogSize || IndexedLogTimeStamp != LogTimeStamp)
+	{
+		return false;
+	}
+
+	Ar << StartGPSTimeMs << Entries << Keyframes;
+	if (Ar.IsError() || Entries.Num() == 0)
+	{
+		Reset();
+		return false;
+	}
+	return true;
+}
+
+bool FNCOMLogIndex::Save(const FString& IndexFileName, int64 LogSize, const FDateTime& LogTimeStamp)
+{
+	TArray<uint8> Data;
+	FMemoryWriter Ar(Data);
+	uint32 Magic = NCOMIndexMagic;
+	int32 Version = NCOMIndexVersion;
+	FDateTime IndexedLogTimeStamp = LogTimeStamp;
+	Ar << Magic << Version << LogSize << IndexedLogTimeStamp << StartGPSTimeMs << Entries << Keyframes;
+	return FFileHelper::SaveArrayToFile(Data, *IndexFileName);
+}
+
+int32 FNCOMLogIndex::FindEntry(double Time) const
+{
+	const int32 Upper = Algo::UpperBoundBy(Entries, Time, &FEntry::Time);
+	return FMath::Clamp(Upper - 1, 0, FMath::Max(Entries.Num() - 1, 0));
+}
+
+const FNCOMLogIndex::FKeyframe* FNCOMLogIndex::FindKeyframe(int32 Entry) const
+{
+	const int32 Upper = Algo::UpperBoundBy(Keyframes, Entry, &FKeyframe::Entry);
+	return Upper > 0 ? &Keyframes[Upper - 1] : nullptr;
+}
+
+/***********************************************************************************************
+	FNCOMLogPlayer
+***********************************************************************************************/
+
+/** Number of the packets decoded by one read */
+static constexpr int32 NCOMDecodeBatch = 128;
+
+FNCOMLogPlayer::~FNCOMLogPlayer()
+{
+	Close();
+}
+
+bool FNCOMLogPlayer::Open(const FString& LogFileName)
+{
+	Close();
+
+	if (!Index.Open(LogFileName))
+	{
+		return false;
+	}
+
+	if (Index.IsEmpty())
+	{
+		UE_LOG(LogSoda, Error, TEXT("FNCOMLogPlayer::Open(); \"%s\" has less than two packets"), *LogFileName);
+		return false;
+	}
+
+	FileName = LogFileName;
+	Decoded.Reset();
+	DecodedFirst = 0;
+	Playhead = 0;
+	bStopping = false;
+	WakeUpEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Thread = FRunnableThread::Create(this, TEXT("NCOMLogPlayer"));
+	return Thread != nullptr;
+}
+
+void FNCOMLogPlayer::Close()
+{
+	if (Thread)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (WakeUpEvent)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeUpEvent);
+		WakeUpEvent = nullptr;
+	}
+
+	Decoded.Reset();
+	Index.Reset();
+}
+
+void FNCOMLogPlayer::Stop()
+{
+	bStopping = true;
+	if (WakeUpEvent)
+	{
+		WakeUpEvent->Trigger();
+	}
+}
+
+bool FNCOMLogPlayer::Sample(double Time, FNCOMSample& OutSample, FNCOMChannel0& OutStatus)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NCOMSample);
+
+	const TArray<FNCOMLogIndex::FEntry>& Entries = Index.GetEntries();
+	const int32 Entry = Index.FindEntry(Time);
+	const int32 Next = FMath::Min(Entry + 1, Entries.Num() - 1);
+
+	if (const FNCOMLogIndex::FKeyframe* Keyframe = Index.FindKeyframe(Entry))
+	{
+		OutStatus = Keyframe->Status;
+	}
+
+	bool bSampled = false;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		if (Entry < DecodedFirst || Entry > DecodedFirst + Decoded.Num())
+		{
+			// Seek, the worker restarts from the new playhead. Behind the decoded window the playback goes backward,
+			// so the new window is started LookAhead packets behind the playhead
+			++SeekGeneration;
+			Decoded.Reset();
+			DecodedFirst = Entry < DecodedFirst ? FMath::Max(Entry - LookAhead, 0) : Entry;
+		}
+		Playhead = Entry;
+
+		if (Next < DecodedFirst + Decoded.Num())
+		{
+			const double Span = Entries[Next].Time - Entries[Entry].Time;
+			const float Alpha = Span > 0 ? float(FMath::Clamp((Time - Entries[Entry].Time) / Span, 0.0, 1.0)) : 0.f;
+			OutSample = LerpNCOMSample(Decoded[Entry - DecodedFirst], Decoded[Next - DecodedFirst], Alpha);
+			bSampled = true;
+		}
+	}
+
+	WakeUpEvent->Trigger();
+	return bSampled;
+}
+
+uint32 FNCOMLogPlayer::Run()
+{
+	TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*FileName));
+	if (!File)
+	{
+		UE_LOG(LogSoda, Error, TEXT("FNCOMLogPlayer::Run(); Can't open \"%s\""), *FileName);
+		return 1;
+	}
+
+	TArray<FNCOMSample> Batch;
+	while (!bStopping)
+	{
+		int32 First;
+		int32 Num;
+		uint32 Generation;
+		bool bBackward;
+		{
+			FScopeLock ScopeLock(&Lock);
+
+			// The samples far behind the playhead are dropped in batches, so the array isn't shifted on every frame;
+			// a quarter of the LookAhead is kept behind for the backward playback
+			const int32 Behind = Playhead - DecodedFirst;
+			if (Behind > LookAhead / 2)
+			{
+				const int32 Drop = FMath::Min(Behind - LookAhead / 4, Decoded.Num());
+				Decoded.RemoveAt(0, Drop, false);
+				DecodedFirst += Drop;
+			}
+
+			// The samples left far ahead by the backward playback
+			const int32 Ahead = DecodedFirst + Decoded.Num() - Playhead;
+			if (Ahead > LookAhead * 2)
+			{
+				Decoded.SetNum(Playhead - DecodedFirst + LookAhead, false);
+			}
+
+			Generation = SeekGeneration;
+
+			// Decode behind the window once the pair around the playhead is ready
+			bBackward = Playhead - DecodedFirst < LookAhead / 8 && DecodedFirst > 0 && DecodedFirst + Decoded.Num() > Playhead + 1;
+			if (bBackward)
+			{
+				First = FMath::Max(DecodedFirst - NCOMDecodeBatch, 0);
+				Num = DecodedFirst - First;
+			}
+			else
+			{
+				First = DecodedFirst + Decoded.Num();
+				Num = FMath::Min3(Playhead + LookAhead, Index.GetEntries().Num(), First + NCOMDecodeBatch) - First;
+			}
+		}
+
+		if (Num <= 0)
+		{
+			WakeUpEvent->Wait(10);
+			continue;
+		}
+
+		if (!Decode(*File, First, Num, Batch))
+		{
+			UE_LOG(LogSoda, Error, TEXT("FNCOMLogPlayer::Run(); Can't read \"%s\""), *FileName);
+			return 1;
+		}
+
+		{
+			FScopeLock ScopeLock(&Lock);
+			if (Generation != SeekGeneration)
+			{
+				continue;
+			}
+			if (bBackward && First + Num == DecodedFirst)
+			{
+				Decoded.Insert(Batch, 0);
+				DecodedFirst = First;
+			}
+			else if (!bBackward && First == DecodedFirst + Decoded.Num())
+			{
+				Decoded.Append(Batch);
+			}
+		}
+	}
+
+	return 0;
+}
+
+bool FNCOMLogPlayer::Decode(IFileHandle& File, int32 First, int32 Num, TArray<FNCOMSample>& OutSamples)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NCOMDecode);
+
+	const TArray<FNCOMLogIndex::FEntry>& Entries = Index.GetEntries();
+	const int64 Start = Entries[First].Offset;
+	const int64 Size = Entries[First + Num - 1].Offset + FNCOMLogIndex::PacketSize - Start;
+
+	ReadBuffer.SetNumUninitialized(int32(Size), false);
+	if (!File.Seek(Start) || !File.Read(ReadBuffer.GetData(), Size))
+	{
+		return false;
+	}
+
+	OutSamples.SetNum(Num, false);
+	for (int32 i = 0; i < Num; ++i)
+	{
+		DecodeNCOMPacket(ReadBuffer.GetData() + (Entries[First + i].Offset - Start), OutSamples[i]);
+	}
+	return true;
+}
+
+} // namespace soda
@@ -0,0 +1,405 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#include "Soda/VehicleComponents/Sensors/Implementation/NavMessageEncoder.h"
+#include "Soda/VehicleComponents/Sensors/Implementation/OXTS/NComRxC.h"
+#include "Soda/VehicleComponents/Sensors/Implementation/OXTS/NComRxDefines.h"
+#include "Soda/Misc/Utils.h"
+#include "Misc/ScopeLock.h"
+
+DECLARE_STATS_GROUP(TEXT("NavMessageEncoder"), STATGROUP_NavMessageEncoder, STATGROUP_Advanced);
+DECLARE_CYCLE_STAT(TEXT("EncodeNCOM"), STAT_EncodeNCOM, STATGROUP_NavMessageEncoder);
+DECLARE_CYCLE_STAT(TEXT("EncodeGPSD"), STAT_EncodeGPSD, STATGROUP_NavMessageEncoder);
+DECLARE_CYCLE_STAT(TEXT("FanOut"), STAT_NavFanOut, STATGROUP_NavMessageEncoder);
+
+namespace soda
+{
+
+/***********************************************************************************************
+	FNavTextWriter
+***********************************************************************************************/
+
+void FNavTextWriter::Append(const char* Str, int Len)
+{
+	if (Size + Len > Capacity)
+	{
+		Len = Capacity - Size;
+		bOverflow = true;
+	}
+	FMemory::Memcpy(Data + Size, Str, Len);
+	Size += Len;
+}
+
+void FNavTextWriter::UInt(uint64 Value, int MinDigits)
+{
+	char Tmp[24];
+	int Len = 0;
+	do
+	{
+		Tmp[sizeof(Tmp) - 1 - Len++] = char('0' + Value % 10);
+		Value /= 10;
+	} while (Value || Len < MinDigits);
+	Append(Tmp + sizeof(Tmp) - Len, Len);
+}
+
+void FNavTextWriter::Int(int64 Value)
+{
+	if (Value < 0)
+	{
+		Char('-');
+		UInt(uint64(0) - uint64(Value));
+	}
+	else
+	{
+		UInt(uint64(Value));
+	}
+}
+
+void FNavTextWriter::Fixed(double Value, int Decimals)
+{
+	static const uint64 Pow10[] = { 1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull };
+
+	if (!FMath::IsFinite(Value))
+	{
+		Char('0');
+		return;
+	}
+
+	Decimals = FMath::Clamp(Decimals, 0, 9);
+	const double Scaled = FMath::Min(FMath::Abs(Value) * double(Pow10[Decimals]) + 0.5, 9.0e18);
+	const uint64 Units = uint64(Scaled);
+	if (Value < 0 && Units != 0)
+	{
+		Char('-');
+	}
+	UInt(Units / Pow10[Decimals]);
+	if (Decimals > 0)
+	{
+		Char('.');
+		UInt(Units % Pow10[Decimals], Decimals);
+	}
+}
+
+void FNavTextWriter::IsoTime(int64 UnixTimeMs)
+{
+	// Civil date from days since the Unix epoch (proleptic Gregorian calendar), no gmtime() and no locks
+	static constexpr int64 MsPerDay = 86400000;
+	int64 Days = UnixTimeMs / MsPerDay;
+	int64 MsOfDay = UnixTimeMs % MsPerDay;
+	if (MsOfDay < 0)
+	{
+		MsOfDay += MsPerDay;
+		--Days;
+	}
+
+	const int64 Z = Days + 719468;
+	const int64 Era = (Z >= 0 ? Z : Z - 146096) / 146097;
+	const int64 Doe = Z - Era * 146097;
+	const int64 Yoe = (Doe - Doe / 1460 + Doe / 36524 - Doe / 146096) / 365;
+	const int64 Doy = Doe - (365 * Yoe + Yoe / 4 - Yoe / 100);
+	const int64 Mp = (5 * Doy + 2) / 153;
+	const int64 Day = Doy - (153 * Mp + 2) / 5 + 1;
+	const int64 Month = Mp < 10 ? Mp + 3 : Mp - 9;
+	const int64 Year = Yoe + Era * 400 + (Month <= 2 ? 1 : 0);
+
+	UInt(uint64(FMath::Max<int64>(Year, 0)), 4);
+	Char('-');
+	UInt(uint64(Month), 2);
+	Char('-');
+	UInt(uint64(Day), 2);
+	Char('T');
+	UInt(uint64(MsOfDay / 3600000), 2);
+	Char(':');
+	UInt(uint64(MsOfDay / 60000 % 60), 2);
+	Char(':');
+	UInt(uint64(MsOfDay / 1000 % 60), 2);
+	Char('.');
+	UInt(uint64(MsOfDay % 1000), 3);
+}
+
+/***********************************************************************************************
+	FNCOMEncoder
+***********************************************************************************************/
+
+namespace
+{
+	struct FNCOMWriter
+	{
+		uint8* Data;
+		int Offset = 0;
+		uint8 Sum = 0;
+
+		void Put8(uint8 Value)
+		{
+			Data[Offset++] = Value;
+			Sum += Value;
+		}
+
+		void Put16(uint16 Value)
+		{
+			Put8(uint8(Value));
+			Put8(uint8(Value >> 8));
+		}
+
+		void Put24(int32 Value)
+		{
+			Put8(uint8(Value));
+			Put8(uint8(Value >> 8));
+			Put8(uint8(Value >> 16));
+		}
+
+		void Put32(uint32 Value)
+		{
+			Put16(uint16(Value));
+			Put16(uint16(Value >> 16));
+		}
+
+		void PutFloat(float Value)
+		{
+			uint32 Bits;
+			FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+			Put32(Bits);
+		}
+
+		void PutDouble(double Value)
+		{
+			uint64 Bits;
+			FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+			Put32(uint32(Bits));
+			Put32(uint32(Bits >> 32));
+		}
+
+		/** Checksum is the sum of all the bytes after the sync byte, including the previous checksums */
+		void PutChecksum()
+		{
+			const uint8 Checksum = Sum;
+			Put8(Checksum);
+		}
+	};
+
+	/** Status channels batch. The channel 0 carries the GPS minutes and is interleaved with every other channel */
+	static const uint8 NCOMChannelsBatch[] = { 0, 3, 0, 4, 0, 5, 0, 20, 0, 27 };
+
+	static uint16 ToUInt16(double Value)
+	{
+		return uint16(FMath::Clamp(Value, 0.0, 65535.0));
+	}
+}
+
+void FNCOMEncoder::Encode(const FNavSolution& Nav, const FNCOMStatus& Status, uint8(&OutPacket)[PacketSize])
+{
+	SCOPE_CYCLE_COUNTER(STAT_EncodeNCOM);
+
+	FNCOMWriter Writer{ OutPacket };
+
+	// Batch 1
+	OutPacket[Writer.Offset++] = NCOM_SYNC;
+	Writer.Put16(uint16(Nav.GPSTimestampMs % 60000));
+	Writer.Put24(int32(-Nav.LocalAcc.X / 100.0 / ACC2MPS2));
+	Writer.Put24(int32(-Nav.LocalAcc.Y / 100.0 / ACC2MPS2));
+	Writer.Put24(int32(Nav.LocalAcc.Z / 100.0 / ACC2MPS2));
+	Writer.Put24(-int32(Nav.Gyro.X / RATE2RPS));
+	Writer.Put24(-int32(Nav.Gyro.Y / RATE2RPS));
+	Writer.Put24(int32(Nav.Gyro.Z / RATE2RPS));
+	Writer.Put8(NAVIGATION_STATUS_LOCKED);
+	Writer.PutChecksum();
+
+	// Batch 2
+	Writer.PutDouble(Nav.Lat / 180.0 * M_PI);
+	Writer.PutDouble(Nav.Lon / 180.0 * M_PI);
+	Writer.PutFloat(float(Nav.Alt));
+	Writer.Put24(int32(Nav.WorldVel.Y / 100.0 / VEL2MPS));
+	Writer.Put24(-int32(Nav.WorldVel.X / 100.0 / VEL2MPS));
+	Writer.Put24(-int32(Nav.WorldVel.Z / 100.0 / VEL2MPS));
+	Writer.Put24(int32(NormAngRad(Nav.WorldRot.Yaw / 180.0 * M_PI - M_PI / 2) / ANG2RAD));
+	Writer.Put24(int32(NormAngRad(Nav.WorldRot.Pitch / 180.0 * M_PI) / ANG2RAD));
+	Writer.Put24(int32(NormAngRad(Nav.WorldRot.Roll / 180.0 * M_PI) / ANG2RAD));
+	Writer.PutChecksum();
+
+	// Batch 3, status channel
+	const uint8 Channel = NCOMChannelsBatch[BatchIndex];
+	BatchIndex = (BatchIndex + 1) % UE_ARRAY_COUNT(NCOMChannelsBatch);
+
+	Writer.Put8(Channel);
+	const int ChannelStart = Writer.Offset;
+	switch (Channel)
+	{
+	case 3:
+		// North, east, down [1e-3 m]
+		Writer.Put16(ToUInt16(Status.PositionAccuracy.Y / 1e-3));
+		Writer.Put16(ToUInt16(Status.PositionAccuracy.X / 1e-3));
+		Writer.Put16(ToUInt16(Status.PositionAccuracy.Z / 1e-3));
+		break;
+	case 4:
+		// North, east, down [1e-3 m/s]
+		Writer.Put16(ToUInt16(Status.VelocityAccuracy.Y / 1e-3));
+		Writer.Put16(ToUInt16(Status.VelocityAccuracy.X / 1e-3));
+		Writer.Put16(ToUInt16(Status.VelocityAccuracy.Z / 1e-3));
+		break;
+	case 5:
+		// Heading, pitch, roll [1e-5 rad]
+		Writer.Put16(ToUInt16(FMath::DegreesToRadians(Status.OrientationAccuracy.Z) / 1e-5));
+		Writer.Put16(ToUInt16(FMath::DegreesToRadians(Status.OrientationAccuracy.Y) / 1e-5));
+		Writer.Put16(ToUInt16(FMath::DegreesToRadians(Status.OrientationAccuracy.X) / 1e-5));
+		break;
+	case 20:
+		Writer.Put16(uint16(int16(Status.DifferentialCorrectionsAge)));
+		break;
+	case 27:
+		Writer.Put8(uint8(Status.HeadingQuality));
+		break;
+	case 0:
+	default:
+		Writer.Put32(uint32(Nav.GPSTimestampMs / 60000));
+		Writer.Put8(uint8(Status.SatellitesNumber));
+		Writer.Put8(uint8(Status.PositionMode));
+		Writer.Put8(uint8(Status.VelocityMode));
+		Writer.Put8(uint8(Status.OrientationMode));
+		break;
+	}
+	while (Writer.Offset < ChannelStart + 8)
+	{
+		Writer.Put8(0);
+	}
+	Writer.PutChecksum();
+
+	check(Writer.Offset == PacketSize);
+}
+
+/***********************************************************************************************
+	FGpsdEncoder
+***********************************************************************************************/
+
+static TArray<char> MakeGpsdTemplate(const FString& Str)
+{
+	const FTCHARToUTF8 Utf8(*Str);
+	TArray<char> Ret;
+	Ret.Append(Utf8.Get(), Utf8.Length());
+	return Ret;
+}
+
+void FGpsdEncoder::SetDevice(const FString& DeviceName)
+{
+	const FString Device = DeviceName.ReplaceCharWithEscapedChar();
+
+	TPVHeader = MakeGpsdTemplate(FString::Printf(TEXT("{\"class\":\"TPV\",\"device\":\"%s\",\"status\":2,\"time\":\""), *Device));
+	ATTHeader = MakeGpsdTemplate(FString::Printf(TEXT("{\"class\":\"ATT\",\"device\":\"%s\",\"time\":\""), *Device));
+	IMUHeader = MakeGpsdTemplate(FString::Printf(TEXT("{\"class\":\"IMU\",\"device\":\"%s\",\"time\":\""), *Device));
+	SKYMessage = MakeGpsdTemplate(FString::Printf(TEXT(
+		"{\"class\":\"SKY\",\"device\":\"%s\",\"xdop\":0.76,\"ydop\":0.61,\"vdop\":1.03,\"tdop\":0.74,\"hdop\":0.89,\"gdop\":1.55,\"pdop\":1.37,\"satellites\":["
+		"{\"PRN\":1,\"el\":85,\"az\":349,\"ss\":38,\"used\":true,\"gnssid\":0,\"svid\":1},"
+		"{\"PRN\":3,\"el\":57,\"az\":224,\"ss\":36,\"used\":true,\"gnssid\":0,\"svid\":3},"
+		"{\"PRN\":4,\"el\":2,\"az\":180,\"ss\":42,\"used\":true,\"gnssid\":0,\"svid\":4},"
+		"{\"PRN\":6,\"el\":25,\"az\":132,\"ss\":42,\"used\":true,\"gnssid\":0,\"svid\":8},"
+		"{\"PRN\":9,\"el\":7,\"az\":94,\"ss\":42,\"used\":true,\"gnssid\":0,\"svid\":12}]}\r\n"), *Device));
+
+	Frame.Reserve(4096);
+}
+
+void FGpsdEncoder::AppendMessage(const FNavTextWriter& Writer, const char* Data)
+{
+	if (!Writer.IsOverflow())
+	{
+		Frame.Append((const uint8*)Data, Writer.Num());
+	}
+}
+
+void FGpsdEncoder::AppendTPV(const FNavSolution& Nav)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EncodeGPSD);
+
+	char Buf[1024];
+	FNavTextWriter Writer(Buf, sizeof(Buf));
+
+	float Track = Nav.WorldVel.Rotation().Yaw - 90.f;
+	Track = Track < 0.f ? Track + 360.f : Track > 360.f ? Track - 360.f : Track;
+
+	Writer.Append(TPVHeader);
+	Writer.IsoTime(Nav.TimestampMs);
+	Writer.Literal("\",\"leapseconds\":18,\"mode\":3,\"lat\":");
+	Writer.Fixed(Nav.Lat, 9);
+	Writer.Literal(",\"lon\":");
+	Writer.Fixed(Nav.Lon, 9);
+	Writer.Literal(",\"alt\":");
+	Writer.Fixed(Nav.Alt, 3);
+	Writer.Literal(",\"track\":");
+	Writer.Fixed(Track, 4);
+	Writer.Literal(",\"speed\":");
+	Writer.Fixed(FVector2D(Nav.WorldVel).Size() / 100.0, 3);
+	Writer.Literal(",\"climb\":");
+	Writer.Fixed(Nav.WorldVel.Z / 100.0, 3);
+	Writer.Literal(",\"ept\":0.005,\"epx\":13.725,\"epy\":13.949,\"epv\":5.808,\"epd\":71.0492,\"eps\":0.03,\"epc\":298.04"
+		",\"ecefx\":3926933.52,\"ecefy\":-91416.57,\"ecefz\":5008412.79,\"ecefvx\":-0.07,\"ecefvy\":-0.01,\"ecefvz\":-0.04"
+		",\"ecefpAcc\":7.76,\"ecefvAcc\":0.21,\"eph\":5.150}\r\n");
+
+	AppendMessage(Writer, Buf);
+}
+
+void FGpsdEncoder::AppendATT_IMU(const FNavSolution& Nav, bool bIsATT)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EncodeGPSD);
+
+	char Buf[1024];
+	FNavTextWriter Writer(Buf, sizeof(Buf));
+
+	float Heading = Nav.WorldRot.Yaw - 90.f;
+	Heading = Heading < 0.f ? Heading + 360.f : Heading > 360.f ? Heading - 360.f : Heading;
+
+	Writer.Append(bIsATT ? ATTHeader : IMUHeader);
+	Writer.IsoTime(Nav.TimestampMs);
+	Writer.Literal("\",\"heading\":");
+	Writer.Fixed(Heading, 4);
+	Writer.Literal(",\"pitch\":");
+	Writer.Fixed(Nav.WorldRot.Pitch, 4);
+	Writer.Literal(",\"pitch_st\":\"N\",\"roll\":");
+	Writer.Fixed(Nav.WorldRot.Roll, 4);
+	Writer.Literal(",\"roll_st\":\"N\",\"yaw\":");
+	Writer.Fixed(Nav.WorldRot.Yaw, 4);
+	Writer.Literal(",\"yaw_st\":\"N\",\"acc_len\":");
+	Writer.Fixed(Nav.LocalAcc.Size() / 100.0, 4);
+	Writer.Literal(",\"acc_x\":");
+	Writer.Fixed(-Nav.LocalAcc.X / 100.0, 4);
+	Writer.Literal(",\"acc_y\":");
+	Writer.Fixed(-Nav.LocalAcc.Y / 100.0, 4);
+	Writer.Literal(",\"acc_z\":");
+	Writer.Fixed(Nav.LocalAcc.Z / 100.0, 4);
+	Writer.Literal(",\"gyro_x\":");
+	Writer.Fixed(-Nav.Gyro.X, 6);
+	Writer.Literal(",\"gyro_y\":");
+	Writer.Fixed(-Nav.Gyro.Y, 6);
+	Writer.Literal("}\r\n");
+
+	AppendMessage(Writer, Buf);
+}
+
+/***********************************************************************************************
+	FNavFanOutAsyncTask
+***********************************************************************************************/
+
+bool FNavFanOutAsyncTask::Publish(const TArray<uint8>& Buf)
+{
+	FScopeLock ScopeLock(&Lock);
+	if (Front.Num() + Buf.Num() > MaxPendingSize)
+	{
+		return false;
+	}
+	Front.Append(Buf);
+	return true;
+}
+
+void FNavFanOutAsyncTask::Tick()
+{
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (Front.Num() == 0)
+		{
+			return;
+		}
+		Swap(Front, Back);
+		Front.SetNum(0, false);
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_NavFanOut);
+	SendFunction(Back);
+}
+
+} // namespace soda
@@ -87,3 +87,10 @@ float USodaVehicleWheelComponent::ResolveAngularVelocity() const
 }
 
 
+
+void USodaVehicleWheelComponent::SerializeSnapshot(FArchive& Ar)
+{
+	Super::SerializeSnapshot(Ar);
+
+	Ar << ReqTorq << ReqBrakeTorque << ReqSteer << Steer << Pitch << AngularVelocity << Slip << SuspensionOffset2;
+}
@@ -9,6 +9,8 @@
 #include "UObject/ConstructorHelpers.h"
 #include "Materials/Material.h"
 #include "RuntimeMetaData.h"
+#include "Engine/Canvas.h"
+#include "Engine/Engine.h"
 
 USensorComponent::USensorComponent(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -56,12 +58,54 @@ bool USensorComponent::OnActivateVehicleComponent()
 
 	MarkRenderStateDirty();
 
+	if (bRet && Schedule.bEnabled)
+	{
+		if (USodaSensorScheduler* Scheduler = GetWorld()->GetSubsystem<USodaSensorScheduler>())
+		{
+			Scheduler->Register(this);
+		}
+	}
+
 	return bRet;
 }
 
 void USensorComponent::OnDeactivateVehicleComponent()
 {
 	Super::OnDeactivateVehicleComponent();
+
+	if (USodaSensorScheduler* Scheduler = GetWorld() ? GetWorld()->GetSubsystem<USodaSensorScheduler>() : nullptr)
+	{
+		Scheduler->Unregister(this);
+	}
+}
+
+bool USensorComponent::IsTickOnCurrentFrame() const
+{
+	if (Schedule.bEnabled)
+	{
+		if (USodaSensorScheduler* Scheduler = GetWorld()->GetSubsystem<USodaSensorScheduler>())
+		{
+			return Scheduler->IsDue(this);
+		}
+	}
+	return Super::IsTickOnCurrentFrame();
+}
+
+void USensorComponent::DrawDebug(UCanvas* Canvas, float& YL, float& YPos)
+{
+	Super::DrawDebug(Canvas, YL, YPos);
+
+	if (Common.bDrawDebugCanvas && Schedule.bEnabled)
+	{
+		const USodaSensorScheduler* Scheduler = GetWorld()->GetSubsystem<USodaSensorScheduler>();
+		if (const FSensorScheduleStats* Stats = Scheduler ? Scheduler->GetStats(this) : nullptr)
+		{
+			UFont* RenderFont = GEngine->GetSmallFont();
+			Canvas->SetDrawColor(Stats->MissedTriggers || Stats->DroppedFrames ? FColor::Yellow : FColor::White);
+			YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Schedule: %.1f Hz, phase %.3f s, drift %.2f/%.2f ms, missed %lld, dropped %lld"),
+				Schedule.Rate, Stats->Phase, Stats->DriftMean, Stats->DriftMax, Stats->MissedTriggers, Stats->DroppedFrames), 16, YPos);
+		}
+	}
 }
 
 FPrimitiveSceneProxy* USensorComponent::CreateSceneProxy()
@@ -5,6 +5,7 @@
 #include "Soda/VehicleComponents/Sensors/Implementation/OXTS/NComRxDefines.h"
 #include "Soda/UnrealSoda.h"
 #include "Soda/SodaApp.h"
+#include "Soda/SodaCommonSettings.h"
 #include "Engine/Engine.h"
 #include "Engine/Canvas.h"
 #include "Engine/CollisionProfile.h"
@@ -99,6 +100,19 @@ bool UNCOMWheeledVehicleMovement::OnActivateVehicleComponent()
 
 	VehicleSimData.VehicleKinematic.Curr.GlobalPose = UpdatedPrimitive->GetComponentTransform();
 
+	if (!LogPath.IsEmpty())
+	{
+		LogPlayer = MakeUnique<soda::FNCOMLogPlayer>();
+		if (!LogPlayer->Open(LogPath))
+		{
+			LogPlayer.Reset();
+			SetHealth(EVehicleComponentHealth::Error, TEXT("Can't open the NCOM log"));
+			return false;
+		}
+		LogTime = FMath::Clamp(double(LogStartTime), 0.0, LogPlayer->GetIndex().GetDuration());
+		bLogSeeked = true;
+		return true;
+	}
 
 	FIPv4Endpoint Endpoint(FIPv4Address(0, 0, 0, 0), NCOMPort);
 	ListenSocket = FUdpSocketBuilder(TEXT("NCOMWheeledVehicleMovement"))
@@ -134,6 +148,7 @@ void UNCOMWheeledVehicleMovement::OnDeactivateVehicleComponent()
 {
 	Super::OnDeactivateVehicleComponent();
 
+	LogPlayer.Reset();
 }
 
 void UNCOMWheeledVehicleMovement::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
@@ -148,6 +163,11 @@ void UNCOMWheeledVehicleMovement::TickComponent(float DeltaTime, enum ELevelTick
 	}
 	*/
 
+	if (LogPlayer)
+	{
+		TickLog(DeltaTime);
+	}
+
 	static const std::chrono::nanoseconds Timeout(100000000ll);
 
 	bIsConnected = (soda::Now() - LastPacketTimestamp) < Timeout;
@@ -178,6 +198,12 @@ void UNCOMWheeledVehicleMovement::DrawDebug(UCanvas* Canvas, float& YL, float& Y
 	{
 		UFont* RenderFont = GEngine->GetSmallFont();
 
+		if (LogPlayer)
+		{
+			Canvas->SetDrawColor(FColor::White);
+			YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Log: %.2fs / %.2fs; Rate: %.2f"), LogTime, LogPlayer->GetIndex().GetDuration(), PlaybackRate), 16, YPos);
+		}
+
 		if (bIsConnected)
 		{
 			if (!bIsOXTSDataValid)
@@ -214,119 +240,124 @@ bool UNCOMWheeledVehicleMovement::SetVehiclePosition(const FVector& NewLocation,
 
 void UNCOMWheeledVehicleMovement::Recv(const FArrayReaderPtr& ArrayReaderPtr, const FIPv4Endpoint& EndPt)
 {
-	bool bIsOXTSDataValidTmp = true;
-	if (ArrayReaderPtr->Num() != 72)
+	if (ArrayReaderPtr->Num() != soda::FNCOMLogIndex::PacketSize)
 	{
 		UE_LOG(LogSoda, Error, TEXT("UNCOMWheeledVehicleMovement::Recv(); Protocol error, recve %d bytes, was expected 72 bytes"), ArrayReaderPtr->Num());
-		bIsOXTSDataValidTmp = false;
 		return;
 	}
 
-	BitStream.Buf.SetNum(72);
-	::memcpy(BitStream.Buf.GetData(), ArrayReaderPtr->GetData(), 72);
-
-	BitStream.SetOffset(0);
-	OXTSPacket.sync       = BitStream.GetBytes<uint8_t>(1);
-	OXTSPacket.time       = BitStream.GetBytes<uint16_t>(2);
-	OXTSPacket.accel_x    = BitStream.GetBytes<int32_t>(3);
-	OXTSPacket.accel_y    = BitStream.GetBytes<int32_t>(3);
-	OXTSPacket.accel_z    = BitStream.GetBytes<int32_t>(3);
-	OXTSPacket.gyro_x     = BitStream.GetBytes<int32_t>(3);
-	OXTSPacket.gyro_y     = BitStream.GetBytes<int32_t>(3);
-	OXTSPacket.gyro_z     = BitStream.GetBytes<int32_t>(3);
-	OXTSPacket.nav_status = BitStream.GetBytes<uint8_t>(1);
-	OXTSPacket.chksum1    = BitStream.GetBytes<uint8_t>(1);
-	BitStream.GetBytes(&OXTSPacket._lat.c, 8);
-	BitStream.GetBytes(&OXTSPacket._lon.c, 8);
-	BitStream.GetBytes(&OXTSPacket._alt.c, 4);
-	OXTSPacket.vel_north  = BitStream.GetBytes<int32_t>(3);
-	OXTSPacket.vel_east   = BitStream.GetBytes<int32_t>(3);
-	OXTSPacket.vel_down   = BitStream.GetBytes<int32_t>(3);
-	OXTSPacket.heading    = BitStream.GetBytes<int32_t>(3);
-	OXTSPacket.pitch      = BitStream.GetBytes<int32_t>(3);
-	OXTSPacket.roll       = BitStream.GetBytes<int32_t>(3);
-	OXTSPacket.chksum2    = BitStream.GetBytes<uint8_t>(1);
-	OXTSPacket.channel    = BitStream.GetBytes<uint8_t>(1);
-	BitStream.GetBytes(&OXTSPacket.chan.bytes, 8);
-	OXTSPacket.chksum3    = BitStream.GetBytes<uint8_t>(1);
-	check(BitStream.GetOffset() == 72 * 8);
+	soda::FNCOMSample Sample;
+	if (!soda::DecodeNCOMPacket(ArrayReaderPtr->GetData(), Sample))
+	{
+		UE_LOG(LogSoda, Error, TEXT("UNCOMWheeledVehicleMovement::Recv(); Wrong sync byte"));
+		return;
+	}
+
+	if (Sample.Channel == 0)
+	{
+		OXTS_SatellitesNumber = Sample.Status.SatellitesNumber;
+		OXTS_PositionMode = Sample.Status.PositionMode;
+		OXTS_VelocityMode = Sample.Status.VelocityMode;
+		OXTS_OrientationMode = Sample.Status.OrientationMode;
+		OXTS_GPSMinutes = Sample.Status.GPSMinutes;
+	}
 
 	auto Timestemp = soda::Now();
 	double DeltaTime = std::chrono::duration_cast<std::chrono::duration<double>>(Timestemp - LastPacketTimestamp).count();
 	LastPacketTimestamp = Timestemp;
-	
-	FVector WorldPos;
-	FRotator WorldRot;
-	FVector LocalAcc;
-	FVector AngularVelocity;
-	FVector WorldVel;
-
-
-	OXTS_Miliseconds = OXTSPacket.time;
-	//OXTSPacket.sync == NCOM_SYNC;
-	//OXTSPacket.nav_status == NAVIGATION_STATUS_LOCKED;
-	//OXTSPacket.chksum1 == FOXTSPublisher::Checksum(OXTSPacket, sizeof(OXTSPacket.sync), offsetof(soda::OxtsPacket, chksum1));
-	//OXTSPacket.chksum2 == FOXTSPublisher::Checksum(OXTSPacket, sizeof(OXTSPacket.sync), offsetof(soda::OxtsPacket, chksum2));
-	//OXTSPacket.chksum3 == FOXTSPublisher::Checksum(OXTSPacket, sizeof(OXTSPacket.sync), offsetof(soda::OxtsPacket, chksum3));
-
-	LocalAcc.X = -float(OXTSPacket.accel_x) * 100.0 * ACC2MPS2;
-	LocalAcc.Y = -float(OXTSPacket.accel_y) * 100.0 * ACC2MPS2;
-	LocalAcc.Z =  float(OXTSPacket.accel_z) * 100.0 * ACC2MPS2;
-	AngularVelocity.X = -float(OXTSPacket.gyro_x) * RATE2RPS;
-	AngularVelocity.Y = -float(OXTSPacket.gyro_y) * RATE2RPS;
-	AngularVelocity.Z =  float(OXTSPacket.gyro_z) * RATE2RPS;
-	double Lon = OXTSPacket._lon.longitude / M_PI * 180;
-	double Lat = OXTSPacket._lat.latitude / M_PI * 180;
-	double Alt = OXTSPacket._alt.altitude;
-	WorldVel.X = -float(OXTSPacket.vel_east) * 100.0 * VEL2MPS;
-	WorldVel.Y =  float(OXTSPacket.vel_north) * 100.0 * VEL2MPS;
-	WorldVel.Z = -float(OXTSPacket.vel_down) * 100.0 * VEL2MPS;
-	WorldRot.Yaw   = float(OXTSPacket.heading) * ANG2RAD / M_PI * 180.0  + 90;
-	WorldRot.Pitch = float(OXTSPacket.pitch) * ANG2RAD / M_PI * 180.0;
-	WorldRot.Roll  = float(OXTSPacket.roll) * ANG2RAD / M_PI * 180.0;
-	LevelState->GetLLConverter().LLA2UE(WorldPos, Lon, Lat, Alt);
-	WorldRot = LevelState->GetLLConverter().ConvertRotationBackward(WorldRot);
-	WorldVel = LevelState->GetLLConverter().ConvertDirBackward(WorldVel);
 
-	if (WorldPos.ContainsNaN() || (WorldPos.GetAbsMax() > 2000000)) // 20km 
+	ApplySample(Sample, DeltaTime, Timestemp);
+}
+
+void UNCOMWheeledVehicleMovement::TickLog(float DeltaTime)
+{
+	const double Duration = LogPlayer->GetIndex().GetDuration();
+	const double PrevLogTime = LogTime;
+	LogTime += double(DeltaTime) * PlaybackRate;
+	bool bWrapped = false;
+	if (LogTime > Duration || LogTime < 0)
 	{
-		UE_LOG(LogSoda, Error, TEXT("UNCOMWheeledVehicleMovement::Recv(), Got invalid package; Lon: %f; Lat: %f; Alt: %f; WorldPos: %s"), Lon, Lat, Alt, *WorldPos.ToString());
-		WorldPos = FVector(0, 0, 0);
-		bIsOXTSDataValidTmp = false;
+		bWrapped = bLoopLog;
+		LogTime = bLoopLog ? LogTime - FMath::FloorToDouble(LogTime / Duration) * Duration : FMath::Clamp(LogTime, 0.0, Duration);
 	}
 
-	if (WorldRot.ContainsNaN()) 
+	// After the seek or the loop wrap the log time jumps, the frame time is used instead
+	const bool bJump = bLogSeeked || bWrapped;
+	const double LogDeltaTime = bJump ? double(DeltaTime) : FMath::Abs(LogTime - PrevLogTime);
+	if (LogDeltaTime <= 0 && !bJump)
 	{
-		UE_LOG(LogSoda, Error, TEXT("UNCOMWheeledVehicleMovement::Recv(), Got invalid package; Rot: %s"), *WorldRot.ToString());
-		WorldRot = FRotator(0, 0, 0);
-		bIsOXTSDataValidTmp = false;
+		// Paused, keep the last pose
+		LastPacketTimestamp = soda::Now();
+		return;
 	}
 
+	soda::FNCOMSample Sample;
+	soda::FNCOMChannel0 Status;
+	if (!LogPlayer->Sample(LogTime, Sample, Status))
+	{
+		// Right after the seek the packets aren't decoded yet
+		return;
+	}
+
+	OXTS_SatellitesNumber = Status.SatellitesNumber;
+	OXTS_PositionMode = Status.PositionMode;
+	OXTS_VelocityMode = Status.VelocityMode;
+	OXTS_OrientationMode = Status.OrientationMode;
+	OXTS_GPSMinutes = Status.GPSMinutes;
+
+	// The samples are stamped by the log time, so the reprocessed sensor data matches the original drive
+	const int64 StartGPSTimeMs = LogPlayer->GetIndex().GetStartGPSTimeMs();
+	const TTimestamp Timestamp = StartGPSTimeMs > 0
+		? soda::ChronoTimestamp<std::chrono::system_clock, std::chrono::milliseconds>(StartGPSTimeMs + int64(LogTime * 1000) - int64(GetDefault<USodaCommonSettings>()->GetGPSTimestempOffset()) * 1000LL)
+		: SodaApp.GetSimulationTimestamp();
+
+	LastPacketTimestamp = soda::Now();
+	bLogSeeked = false;
+	ApplySample(Sample, FMath::Max(LogDeltaTime, double(SMALL_NUMBER)), Timestamp, bJump);
+}
+
+void UNCOMWheeledVehicleMovement::SeekLog(float Time)
+{
+	if (LogPlayer)
+	{
+		LogTime = FMath::Clamp(double(Time), 0.0, LogPlayer->GetIndex().GetDuration());
+		bLogSeeked = true;
+	}
+}
+
+float UNCOMWheeledVehicleMovement::GetLogDuration() const
+{
+	return LogPlayer ? float(LogPlayer->GetIndex().GetDuration()) : 0.f;
+}
+
+void UNCOMWheeledVehicleMovement::ApplySample(const soda::FNCOMSample& Sample, double DeltaTime, const TTimestamp& Timestamp, bool bDiscontinuity)
+{
+	bool bIsOXTSDataValidTmp = true;
+
+	FVector WorldPos;
+	FRotator WorldRot = Sample.Rot;
+	FVector WorldVel = Sample.Vel;
+
+	OXTS_Miliseconds = Sample.MinuteMs;
+
+	LevelState->GetLLConverter().LLA2UE(WorldPos, Sample.Lon, Sample.Lat, Sample.Alt);
+	WorldRot = LevelState->GetLLConverter().ConvertRotationBackward(WorldRot);
+	WorldVel = LevelState->GetLLConverter().ConvertDirBackward(WorldVel);
+
 	if (WorldPos.ContainsNaN() || (WorldPos.GetAbsMax() > 2000000)) // 20km 
 	{
-		UE_LOG(LogSoda, Error, TEXT("UNCOMWheeledVehicleMovement::Recv(), Got invalid package; Lon: %f; Lat: %f; Alt: %f; WorldPos: %s"), Lon, Lat, Alt, *WorldPos.ToString());
+		UE_LOG(LogSoda, Error, TEXT("UNCOMWheeledVehicleMovement::ApplySample(), Got invalid package; Lon: %f; Lat: %f; Alt: %f; WorldPos: %s"), Sample.Lon, Sample.Lat, Sample.Alt, *WorldPos.ToString());
 		WorldPos = FVector(0, 0, 0);
 		bIsOXTSDataValidTmp = false;
 	}
 
 	if (WorldRot.ContainsNaN()) 
 	{
-		UE_LOG(LogSoda, Error, TEXT("UNCOMWheeledVehicleMovement::Recv(), Got invalid package; Rot: %s"), *WorldRot.ToString());
+		UE_LOG(LogSoda, Error, TEXT("UNCOMWheeledVehicleMovement::ApplySample(), Got invalid package; Rot: %s"), *WorldRot.ToString());
 		WorldRot = FRotator(0, 0, 0);
 		bIsOXTSDataValidTmp = false;
 	}
 
-	switch (OXTSPacket.channel)
-	{
-	case 0:
-		OXTS_SatellitesNumber = OXTSPacket.chan.chan0.num_sats;
-		OXTS_PositionMode = OXTSPacket.chan.chan0.position_mode;
-		OXTS_VelocityMode = OXTSPacket.chan.chan0.velocity_mode;
-		OXTS_OrientationMode = OXTSPacket.chan.chan0.orientation_mode;
-		OXTS_GPSMinutes = OXTSPacket.chan.chan0.gps_minutes;
-		break;
-	}
-
 	PrePhysicSimulation(LastDeltatime, VehicleSimData.VehicleKinematic, VehicleSimData.SimulatedTimestamp);
 
 	Mutex.lock();
@@ -336,27 +367,22 @@ void UNCOMWheeledVehicleMovement::Recv(const FArrayReaderPtr& ArrayReaderPtr, co
 	for (auto& Wheel : GetWheeledVehicle()->GetWheelsSorted())
 	{
 		Wheel->AngularVelocity = 0;
-		Wheel->AngularVelocity = 0;
-		Wheel->AngularVelocity = 0;
-		Wheel->AngularVelocity = 0;
-
-		Wheel->Steer = 0;
 		Wheel->Steer = 0;
-
-		Wheel->Slip = FVector2D::ZeroVector;
-		Wheel->Slip = FVector2D::ZeroVector;
-		Wheel->Slip = FVector2D::ZeroVector;
 		Wheel->Slip = FVector2D::ZeroVector;
 	}
 
 	VehicleSimData.VehicleKinematic.Push(DeltaTime);
 	VehicleSimData.VehicleKinematic.Curr.GlobalPose = FTransform(NCOMRotation, NCOMOffest).Inverse() *  FTransform(WorldRot, WorldPos);
-	VehicleSimData.VehicleKinematic.Curr.GlobalVelocityOfCenterMass = WorldVel + (AngularVelocity ^ (CenterOfMass - NCOMOffest)); //TODO: Need to check it
-	VehicleSimData.VehicleKinematic.Curr.AngularVelocity = AngularVelocity;
+	VehicleSimData.VehicleKinematic.Curr.GlobalVelocityOfCenterMass = WorldVel + (Sample.AngularVelocity ^ (CenterOfMass - NCOMOffest)); //TODO: Need to check it
+	VehicleSimData.VehicleKinematic.Curr.AngularVelocity = Sample.AngularVelocity;
 	VehicleSimData.VehicleKinematic.Curr.CenterOfMassLocal = CenterOfMass;
+	if (bDiscontinuity)
+	{
+		VehicleSimData.VehicleKinematic.Prev = VehicleSimData.VehicleKinematic.Curr;
+	}
 
 	++VehicleSimData.SimulatedStep;
-	VehicleSimData.SimulatedTimestamp = soda::Now();
+	VehicleSimData.SimulatedTimestamp = Timestamp;
 
 	Mutex.unlock();
 
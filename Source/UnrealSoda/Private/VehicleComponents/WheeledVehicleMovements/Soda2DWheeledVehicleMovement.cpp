@@ -313,7 +313,7 @@ void USoda2DWheeledVehicleMovementComponent::UpdateSimulation(const std::chrono:
 	//VehicleKinematic.ComputeGlobalVelocityOfCenterMass(); 
 	VehicleSimData.VehicleKinematic.ComputeGlobalAcceleration();
 	++VehicleSimData.SimulatedStep;
-	VehicleSimData.SimulatedTimestamp = bSynchronousMode ? SodaApp.GetSimulationTimestamp() : soda::Now();
+	VehicleSimData.SimulatedTimestamp = SodaApp.GetSimulationTimestamp();
 	if(bLogPhysStemp)
 	{
 		UE_LOG(LogSoda, Warning, TEXT("2WDVehicle, SimulatedStep: %i, SimulatedTimestamp: %s, Pos: %s"), 
@@ -351,6 +351,26 @@ void USoda2DWheeledVehicleMovementComponent::DrawDebug(UCanvas* Canvas, float& Y
 	}
 }
 
+void USoda2DWheeledVehicleMovementComponent::SerializeSnapshot(FArchive& Ar)
+{
+	Super::SerializeSnapshot(Ar);
+
+	Ar << VehicleSimData << ZOffset;
+
+	bool bHasDynCar = DynCar.IsValid();
+	Ar << bHasDynCar;
+	if (!bHasDynCar || !DynCar.IsValid())
+	{
+		return;
+	}
+
+	// car_state_t is a plain C struct, the snapshot is valid only for the same build
+	Ar.Serialize(&DynCar->car_state, sizeof(car_state_t));
+	Ar.Serialize(&DynCar->car_state_0, sizeof(car_state_t));
+	Ar << DynCar->fl_first_call << DynCar->fl_first_it << DynCar->in_time << DynCar->d_time;
+	Ar << DynCar->fl_reverse << DynCar->fl_AccBrkMode << DynCar->fl_AccBrk_fact;
+}
+
 bool USoda2DWheeledVehicleMovementComponent::SetVehiclePosition(const FVector& NewLocation, const FRotator& NewRotation)
 {
 	if (DynCar != nullptr)
@@ -3,6 +3,7 @@
 #include "Soda/VehicleComponents/WheeledVehicleMovements/SodaChaosWheeledVehicleMovement.h"
 #include "Soda/UnrealSoda.h"
 #include "Soda/SodaApp.h"
+#include "Soda/SodaSimulationClock.h"
 #include "DisplayDebugHelpers.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "Engine/Engine.h"
@@ -36,15 +37,38 @@ void USodaChaosWheeledVehicleSimulation::Init(TUniquePtr<Chaos::FSimpleWheeledVe
 	VehicleSimData.VehicleKinematic.Curr.GlobalVelocityOfCenterMass = VehicleState.VehicleWorldVelocity;
 	VehicleSimData.VehicleKinematic.Curr.AngularVelocity = VehicleState.VehicleWorldAngularVelocity;
 	VehicleSimData.VehicleKinematic.Curr.CenterOfMassLocal = VehicleState.VehicleWorldCOM - VehicleState.VehicleWorldTransform.GetTranslation();
+
+	if (const USodaSimulationClock* Clock = WheeledVehicleComponent->GetWorld()->GetSubsystem<USodaSimulationClock>())
+	{
+		Epoch = Clock->GetEpoch();
+		SimulatedSeconds = Clock->GetSimulatedSeconds();
+	}
+	else
+	{
+		Epoch = soda::Now();
+		SimulatedSeconds = 0;
+	}
+	VehicleSimData.SimulatedTimestamp = soda::AddSeconds(Epoch, SimulatedSeconds);
+
+	MeasuredRealTimeFactor = 1;
+	WindowWallSeconds = FPlatformTime::Seconds();
+	WindowSimulatedSeconds = 0;
 }
 
 void USodaChaosWheeledVehicleSimulation::UpdateSimulation(float DeltaTime, const FChaosVehicleAsyncInput& InputData, Chaos::FRigidBodyHandle_Internal* Handle)
 {
 	UChaosWheeledVehicleSimulation::UpdateSimulation(DeltaTime, InputData, Handle);
 
-	//TODO: Add realtime indicator
-	//auto Diff = soda::Now() - VehicleSimData.SimulatedTimestamp;
-	//UE_LOG(LogSoda, Warning, TEXT("*** %ims %ims"), std::chrono::duration_cast<std::chrono::milliseconds>(Diff).count(), int(DeltaTime * 1000));
+	SimulatedSeconds += DeltaTime;
+
+	WindowSimulatedSeconds += DeltaTime;
+	const double WallSeconds = FPlatformTime::Seconds();
+	if (WallSeconds - WindowWallSeconds >= RealTimeFactorWindow)
+	{
+		MeasuredRealTimeFactor = float(WindowSimulatedSeconds / (WallSeconds - WindowWallSeconds));
+		WindowWallSeconds = WallSeconds;
+		WindowSimulatedSeconds = 0;
+	}
 
 	FScopeLock ScopeLock(&WheeledVehicle->PhysicMutex);
 
@@ -66,7 +90,7 @@ void USodaChaosWheeledVehicleSimulation::UpdateSimulation(float DeltaTime, const
 	//VehicleSimData.VehicleKinematic.ComputeGlobalVelocityOfCenterMass(); 
 	VehicleSimData.VehicleKinematic.ComputeGlobalAcceleration();
 	++VehicleSimData.SimulatedStep;
-	VehicleSimData.SimulatedTimestamp = /*bSynchronousMode ? SodaApp.GetSimulationTimestamp() :*/ soda::Now();
+	VehicleSimData.SimulatedTimestamp = soda::AddSeconds(Epoch, SimulatedSeconds);
 
 	
 	for (int i = 0; i < ChaosWheels.Num(); ++i)
@@ -156,6 +180,18 @@ void USodaChaosWheeledVehicleMovementComponent::DrawDebug(UCanvas *Canvas, float
 {
 	ISodaVehicleComponent::DrawDebug(Canvas, YL, YPos);
 
+	if (Common.bDrawDebugCanvas && VehicleSimulationPT)
+	{
+		const USodaChaosWheeledVehicleSimulation* Simulation = static_cast<USodaChaosWheeledVehicleSimulation*>(VehicleSimulationPT.Get());
+		const USodaSimulationClock* Clock = GetWorld()->GetSubsystem<USodaSimulationClock>();
+		UFont* RenderFont = GEngine->GetSmallFont();
+		Canvas->SetDrawColor(FColor::White);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Physics RTF: %.2f; Frame RTF: %.2f; Target RTF: %.2f"),
+			Simulation->MeasuredRealTimeFactor, Clock ? Clock->GetMeasuredRealTimeFactor() : 0.f, Clock ? Clock->GetRealTimeFactor() : 0.f), 16, YPos);
+		YPos += Canvas->DrawText(RenderFont, FString::Printf(TEXT("Physics step: %.2fms; Simulated time: %.3fs"),
+			Clock ? Clock->GetPhysicsStep() * 1000.f : 0.f, Simulation->SimulatedSeconds), 16, YPos);
+	}
+
 	/*
 	if (PVehicle == NULL) return;
 
@@ -39,6 +39,7 @@
 #include "GlobalRenderResources.h"
 #include "GameFramework/PlayerController.h"
 #include "RuntimeEditorUtils.h"
+#include "Async/Async.h"
 
 #define PARCE_VEC(V, Mul) V.X * Mul, V.Y * Mul, V.Z * Mul
 
@@ -137,6 +138,46 @@ void ASodaVehicle::PreInitializeComponents()
 		}
 	}
 
+	/* Deserialize components from binary archive */
+	if (BinaryAr)
+	{
+		for (auto* Component : ActorComponents)
+		{
+			if (!BinaryAr->DeserializeComponent(Component))
+			{
+				if (ISodaVehicleComponent* SodaComponent = Cast<ISodaVehicleComponent>(Component))
+				{
+					SodaComponent->GetVehicleComponentGUI().bIsDeleted = true;
+				}
+			}
+		}
+
+		for (const FBinaryObjectData& ComponentData : BinaryAr->GetComponents())
+		{
+			if (FindVehicleComponentByName(ComponentData.Name))
+			{
+				continue;
+			}
+
+			UClass* Class = BinaryAr->GetObjectClass(ComponentData);
+			if (Class)
+			{
+				if (Class->ImplementsInterface(USodaVehicleComponent::StaticClass()))
+				{
+					UActorComponent* Component = AddVehicleComponent(Class, FName(*ComponentData.Name));
+					check(Component);
+					BinaryAr->DeserializeComponent(Component);
+				}
+			}
+			else
+			{
+				UE_LOG(LogSoda, Error, TEXT("ASodaVehicle::PreInitializeComponents(); Can't find component class \"%s\""), *ComponentData.ClassPath);
+			}
+		}
+
+		BinaryAr.Reset();
+	}
+
 	for (auto* Component : ActorComponents)
 	{
 		if (ISodaVehicleComponent* SodaComponent = Cast<ISodaVehicleComponent>(Component))
@@ -464,9 +505,10 @@ ASodaVehicle * ASodaVehicle::RespawnVehcile(FVector Location, FRotator Rotation,
 		return nullptr;
 	}
 
-	FActorRecord SavedActorRecord;
-	SavedActorRecord.SerializeActor(this, false);
-	SavedActorRecord.DeserializeActor(NewVehicle, false);
+	TSharedPtr<FBinaryActorArchive> Ar = MakeShared<FBinaryActorArchive>();
+	Ar->SerializeActor(this, true);
+	Ar->DeserializeActor(NewVehicle, false);
+	NewVehicle->BinaryAr = Ar;
 	NewVehicle->MarkAsDirty(); //NewVehicle->bIsDirty = IsDirty();
 	
 	USodaSubsystem* SodaSubsystem = USodaSubsystem::GetChecked();
@@ -747,34 +789,22 @@ bool ASodaVehicle::SaveToJsonFile(const FString& FileName)
 
 bool ASodaVehicle::SaveToBinFile(const FString& FileName)
 {
-	USaveGameActor* SaveGameData = NewObject< USaveGameActor >();
-	if (!SaveGameData->SerializeActor(const_cast<ASodaVehicle*>(this), false))
+	FBinaryActorArchive Ar;
+	if (!Ar.SerializeActor(this, true))
 	{
-		UE_LOG(LogSoda, Error, TEXT("ASodaVehicle::SaveToBin(). Serialize vehicle failed"));
+		UE_LOG(LogSoda, Error, TEXT("ASodaVehicle::SaveToBinFile(). Serialize vehicle failed"));
 		return false;
 	}
 
-	TArray<uint8> BytesData;
-	if (UGameplayStatics::SaveGameToMemory(SaveGameData, BytesData))
-	{
-		if (FFileHelper::SaveArrayToFile(BytesData, *FileName))
-		{
-			ClearDirty();
-			UE_LOG(LogSoda, Log, TEXT("ASodaVehicle::SaveToBinFile(). Save vehicle to: %s"), *FileName);
-			return true;
-		}
-		else
-		{
-			UE_LOG(LogSoda, Error, TEXT("ASodaVehicle::SaveToBinFile(). Can't save vehicle to: %s"), *FileName);
-			return false;
-		}
-	}
-	else
+	if (!Ar.SaveToFile(FileName))
 	{
-		UE_LOG(LogSoda, Error, TEXT("ASodaVehicle::SaveToBinFile(). Faild to save vehicle to memory"), *FileName);
+		UE_LOG(LogSoda, Error, TEXT("ASodaVehicle::SaveToBinFile(). Can't save vehicle to: %s"), *FileName);
 		return false;
 	}
-	
+
+	ClearDirty();
+	UE_LOG(LogSoda, Log, TEXT("ASodaVehicle::SaveToBinFile(). Save vehicle to: %s"), *FileName);
+	return true;
 }
 
 bool ASodaVehicle::SaveToSlot(const FString& Label, const FString& Description, const FGuid& CustomGuid, bool bRebase)
@@ -907,6 +937,56 @@ ASodaVehicle* ASodaVehicle::SpawnVehicleFromJsonArchive(UWorld* World, const TSh
 	return NewVehicle;
 }
 
+ASodaVehicle* ASodaVehicle::SpawnVehicleFromBinaryArchive(UWorld* World, const TSharedPtr<FBinaryActorArchive>& Ar, const FVector& Location, const FRotator& Rotation, bool Posses, FName DesireName, bool bApplyOffset)
+{
+	UClass* VahicleClass = Ar->GetActorClass();
+
+	if (!VahicleClass || !VahicleClass->IsChildOf<ASodaVehicle>())
+	{
+		UE_LOG(LogSoda, Error, TEXT("ASodaVehicle::SpawnVehicleFromBinaryArchive(); Vehicle class faild"));
+		return nullptr;
+	}
+
+	FVector Offset = FVector::ZeroVector;
+	if (bApplyOffset)
+	{
+		const FSodaActorDescriptor& Desc = USodaSubsystem::Get()->GetSodaActorDescriptor(VahicleClass);
+		Offset = Desc.SpawnOffset;
+	}
+
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	SpawnInfo.bDeferConstruction = true;
+	SpawnInfo.Name = DesireName.IsNone() ? NAME_None : FEditorUtils::MakeUniqueObjectName(World->GetCurrentLevel(), VahicleClass, DesireName);
+	FTransform SpawnTransform(Rotation, Location + Offset, FVector(1.0f, 1.0f, 1.0f));
+	ASodaVehicle* NewVehicle = Cast<ASodaVehicle>(World->SpawnActor(VahicleClass, &SpawnTransform, SpawnInfo));
+
+	if (NewVehicle == nullptr)
+	{
+		UE_LOG(LogSoda, Error, TEXT("ASodaVehicle::SpawnVehicleFromBinaryArchive(); Can't spawn new vehicle"));
+		return nullptr;
+	}
+
+	NewVehicle->BinaryAr = Ar;
+
+	if (!Ar->DeserializeActor(NewVehicle, false))
+	{
+		NewVehicle->Destroy();
+		UE_LOG(LogSoda, Error, TEXT("ASodaVehicle::SpawnVehicleFromBinaryArchive(); Can't deserialize vehicle"));
+		return nullptr;
+	}
+
+	NewVehicle->FinishSpawning(SpawnTransform);
+
+	APlayerController* PlayerController = World->GetFirstPlayerController();
+	if (PlayerController != nullptr && Posses)
+	{
+		PlayerController->Possess(NewVehicle);
+	}
+
+	return NewVehicle;
+}
+
 ASodaVehicle* ASodaVehicle::SpawnVehicleFromJsonFile(const UObject* WorldContextObject, const FString& FileName, const FVector& Location, const FRotator& Rotation, bool Posses, FName DesireName, bool bApplyOffset)
 {
 	UWorld* World = USodaStatics::GetGameWorld(WorldContextObject);
@@ -938,6 +1018,18 @@ ASodaVehicle* ASodaVehicle::SpawnVehicleFromBinFile(const UObject* WorldContextO
 	TArray<uint8> ObjectBytes;
 	if (FFileHelper::LoadFileToArray(ObjectBytes, *FileName))
 	{
+		if (FBinaryActorArchive::IsBinaryArchive(ObjectBytes))
+		{
+			TSharedPtr<FBinaryActorArchive> Ar = MakeShared<FBinaryActorArchive>();
+			ASodaVehicle* NewVehicle = Ar->LoadFromMemory(ObjectBytes) ? SpawnVehicleFromBinaryArchive(World, Ar, Location, Rotation, Posses, DesireName, bApplyOffset) : nullptr;
+			if (NewVehicle)
+			{
+				UE_LOG(LogSoda, Log, TEXT("ASodaVehicle::SpawnVehicleFromBinFile(); Spawned vehicle from bin: %s"), *FileName);
+			}
+			return NewVehicle;
+		}
+
+		// Legacy USaveGameActor format
 		SaveGameData = Cast<USaveGameActor>(UGameplayStatics::LoadGameFromMemory(ObjectBytes));
 	}
 	
@@ -1001,6 +1093,90 @@ ASodaVehicle* ASodaVehicle::SpawnVehicleFromBinFile(const UObject* WorldContextO
 	return NewVehicle;
 }
 
+void ASodaVehicle::SpawnVehicleFromBinFileAsync(const UObject* WorldContextObject, const FString& FileName, const FVector& Location, const FRotator& Rotation, TFunction<void(ASodaVehicle*)> OnSpawned, bool Posses, FName DesireName, bool bApplyOffset)
+{
+	TWeakObjectPtr<UWorld> World = USodaStatics::GetGameWorld(WorldContextObject);
+	check(World.IsValid());
+
+	FBinaryActorArchive::LoadFromFileAsync(FileName).Then([World, FileName, Location, Rotation, OnSpawned = MoveTemp(OnSpawned), Posses, DesireName, bApplyOffset](TFuture<TSharedPtr<FBinaryActorArchive>> Future)
+	{
+		::AsyncTask(ENamedThreads::GameThread, [World, FileName, Location, Rotation, OnSpawned, Posses, DesireName, bApplyOffset, Ar = Future.Get()]()
+		{
+			ASodaVehicle* NewVehicle = nullptr;
+			if (!Ar)
+			{
+				UE_LOG(LogSoda, Error, TEXT("ASodaVehicle::SpawnVehicleFromBinFileAsync(): Can't open %s"), *FileName);
+			}
+			else if (World.IsValid())
+			{
+				NewVehicle = SpawnVehicleFromBinaryArchive(World.Get(), Ar, Location, Rotation, Posses, DesireName, bApplyOffset);
+			}
+			if (OnSpawned)
+			{
+				OnSpawned(NewVehicle);
+			}
+		});
+	});
+}
+
+void ASodaVehicle::K2_SpawnVehicleFromBinFileAsync(const UObject* WorldContextObject, const FString& FileName, const FVector& Location, const FRotator& Rotation, FSodaVehicleSpawned OnSpawned, bool Posses, FName DesireName, bool bApplyOffset)
+{
+	SpawnVehicleFromBinFileAsync(WorldContextObject, FileName, Location, Rotation, [OnSpawned](ASodaVehicle* Vehicle)
+	{
+		OnSpawned.ExecuteIfBound(Vehicle);
+	}, Posses, DesireName, bApplyOffset);
+}
+
+bool ASodaVehicle::ConvertJsonFileToBinFile(const FString& JsonFileName, const FString& BinFileName)
+{
+	FJsonActorArchive JsonAr;
+	if (!JsonAr.LoadFromFile(JsonFileName))
+	{
+		UE_LOG(LogSoda, Error, TEXT("ASodaVehicle::ConvertJsonFileToBinFile(); Can't read %s"), *JsonFileName);
+		return false;
+	}
+
+	FBinaryActorArchive BinAr;
+	if (!BinAr.ImportJson(JsonAr))
+	{
+		UE_LOG(LogSoda, Error, TEXT("ASodaVehicle::ConvertJsonFileToBinFile(); Can't convert %s"), *JsonFileName);
+		return false;
+	}
+
+	if (!BinAr.SaveToFile(BinFileName))
+	{
+		UE_LOG(LogSoda, Error, TEXT("ASodaVehicle::ConvertJsonFileToBinFile(); Can't save %s"), *BinFileName);
+		return false;
+	}
+
+	return true;
+}
+
+bool ASodaVehicle::ConvertBinFileToJsonFile(const FString& BinFileName, const FString& JsonFileName)
+{
+	FBinaryActorArchive BinAr;
+	if (!BinAr.LoadFromFile(BinFileName))
+	{
+		UE_LOG(LogSoda, Error, TEXT("ASodaVehicle::ConvertBinFileToJsonFile(); Can't read %s"), *BinFileName);
+		return false;
+	}
+
+	FJsonActorArchive JsonAr;
+	if (!BinAr.ExportJson(JsonAr))
+	{
+		UE_LOG(LogSoda, Error, TEXT("ASodaVehicle::ConvertBinFileToJsonFile(); Can't convert %s"), *BinFileName);
+		return false;
+	}
+
+	if (!JsonAr.SaveToFile(JsonFileName))
+	{
+		UE_LOG(LogSoda, Error, TEXT("ASodaVehicle::ConvertBinFileToJsonFile(); Can't save %s"), *JsonFileName);
+		return false;
+	}
+
+	return true;
+}
+
 TArray<ISodaVehicleComponent*> ASodaVehicle::GetVehicleComponents() const
 {
 	TArray<ISodaVehicleComponent*> Components;
@@ -1132,6 +1308,25 @@ void ASodaVehicle::ScenarioEnd()
 	ReActivateVehicleComponents(false);
 }
 
+void ASodaVehicle::SerializeSnapshot(FArchive& Ar)
+{
+	ISodaActor::SerializeSnapshot(Ar);
+
+	FScopeLock ScopeLock(&PhysicMutex);
+
+	const TArray<ISodaVehicleComponent*> Components = GetVehicleComponents();
+	TArray<FString> Names;
+	for (auto& Component : Components)
+	{
+		Names.Add(Component->AsActorComponent()->GetName());
+	}
+
+	soda::SerializeSnapshotBlocks(Ar, Names, [&Components](int32 Index, FArchive& BlockAr)
+	{
+		Components[Index]->SerializeSnapshot(BlockAr);
+	});
+}
+
 #if WITH_EDITOR
 void ASodaVehicle::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
 {
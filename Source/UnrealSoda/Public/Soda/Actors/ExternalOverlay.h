@@ -0,0 +1,157 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "Common/UdpSocketReceiver.h"
+#include "Containers/TripleBuffer.h"
+#include "Soda/ISodaActor.h"
+#include "ExternalOverlay.generated.h"
+
+class ULineBatchComponent;
+class UTextRenderComponent;
+class FSocket;
+struct FLLConverter;
+
+namespace soda
+{
+namespace overlay
+{
+
+/**
+ * Overlay protocol, little-endian, packed.
+ *
+ * Datagram: FHeader + fragment of the message payload. The message is split into FragmentCount datagrams with the same
+ * Sequence, the payload is the concatenation of the fragments in the FragmentIndex order.
+ *
+ * Payload: uint32 PrimitiveNum, then PrimitiveNum times:
+ *   uint8 Type (EPrimitiveType), uint8 Flags (EPrimitiveFlags), uint16 Reserved, uint8[4] Color (RGBA), float Size, uint32 Count,
+ *   Polyline, Points - Count x double[3] vertices
+ *   Boxes            - Count x double[7] boxes: center[3], half extent[3], yaw [deg]
+ *   Text             - double[3] location, Count bytes of UTF-8 text
+ * Coordinates are UE world [cm], or Lon [deg], Lat [deg], Alt [m] if EPrimitiveFlags::LonLat is set.
+ *
+ * Every message replaces the whole content of its Layer. The message without primitives clears the layer.
+ */
+static constexpr uint32 Magic = 0x4C564F53; // "SOVL"
+static constexpr uint8 Version = 1;
+
+#pragma pack(push, 1)
+struct FHeader
+{
+	uint32 Magic;
+	uint8 Version;
+	uint8 Reserved;
+	uint16 Layer;
+	uint32 Sequence;
+	uint16 FragmentIndex;
+	uint16 FragmentCount;
+};
+#pragma pack(pop)
+
+enum class EPrimitiveType : uint8
+{
+	Polyline,
+	Points,
+	Boxes,
+	Text,
+};
+
+enum EPrimitiveFlags : uint8
+{
+	LonLat = 1 << 0,
+};
+
+struct FPrimitive
+{
+	EPrimitiveType Type = EPrimitiveType::Polyline;
+	uint8 Flags = 0;
+	FColor Color = FColor::Green;
+	float Size = 0;
+	TArray<FVector> Vertices;
+	TArray<FVector> Extents;
+	TArray<float> Yaws;
+	FString Text;
+};
+
+struct FMessage
+{
+	uint32 Sequence = 0;
+	TArray<FPrimitive> Primitives;
+
+	/** Returns false if the payload is malformed */
+	bool Parse(const uint8* Data, int Size);
+};
+
+} // namespace overlay
+} // namespace soda
+
+/**
+ * AExternalOverlay
+ * Draws overlays (trajectories, predictions, occupancy, labels) streamed by the external algorithms over UDP, see soda::overlay.
+ * Messages are parsed on the receiver thread and passed to the game thread through the triple buffer of the layer.
+ * Every layer is converted once per received message to the persistent line batch, so a drawn layer costs nothing per frame.
+ */
+UCLASS(ClassGroup = Soda, meta = (BlueprintSpawnableComponent))
+class UNREALSODA_API AExternalOverlay
+	: public AActor
+	, public ISodaActor
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = ExternalOverlay, SaveGame, meta = (EditInRuntime, ReactivateActor))
+	int Port = 20010;
+
+	/** Max error [cm] of the linearized Lon/Lat conversion, 0 - always use the exact conversion */
+	UPROPERTY(EditAnywhere, Category = ExternalOverlay, SaveGame, meta = (EditInRuntime))
+	float MaxLinearError = 1.0;
+
+	/** Draw the overlay over the scene */
+	UPROPERTY(EditAnywhere, Category = ExternalOverlay, SaveGame, meta = (EditInRuntime))
+	bool bForeground = true;
+
+public:
+	UFUNCTION(BlueprintCallable, Category = ExternalOverlay, meta = (CallInRuntime))
+	void ClearAllLayers();
+
+	/** Override from ISodaActor */
+	virtual const FSodaActorDescriptor* GenerateActorDescriptor() const override;
+
+public:
+	AExternalOverlay();
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaTime) override;
+
+	/** Replace the Layer by the Message from the game thread */
+	void SetLayer(uint16 Layer, const soda::overlay::FMessage& Message);
+
+protected:
+	struct FLayerBuffer
+	{
+		TTripleBuffer<soda::overlay::FMessage> Messages;
+
+		/* Reassembly of the fragmented message, receiver thread only */
+		uint32 Sequence = 0;
+		int ReceivedFragments = 0;
+		TArray<TArray<uint8>> Fragments;
+	};
+
+	struct FLayerView
+	{
+		ULineBatchComponent* LineBatch = nullptr;
+		TArray<UTextRenderComponent*> Texts;
+	};
+
+	void Recv(const FArrayReaderPtr& ArrayReaderPtr, const FIPv4Endpoint& EndPt);
+	FLayerBuffer& FindOrAddLayerBuffer(uint16 Layer);
+	void BuildLayerView(FLayerView& View, const soda::overlay::FMessage& Message);
+
+	FSocket* ListenSocket = nullptr;
+	FUdpSocketReceiver* UDPReceiver = nullptr;
+
+	FCriticalSection LayersLock;
+	TMap<uint16, TUniquePtr<FLayerBuffer>> LayerBuffers;
+	TMap<uint16, FLayerView> LayerViews;
+	TArray<FVector> ConvertBuffer;
+};
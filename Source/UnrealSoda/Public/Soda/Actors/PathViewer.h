@@ -11,6 +11,7 @@
 #include "Interfaces/IPv4/IPv4Endpoint.h"
 #include "DrawDebugHelpers.h"
 #include "Soda/ISodaActor.h"
+#include "Soda/Misc/LLConverter.h"
 #include <vector>
 #include <mutex>
 #include "PathViewer.generated.h"
@@ -39,6 +40,10 @@ class UNREALSODA_API APathViewer
 	UPROPERTY(EditAnywhere, Category = PathViewer, SaveGame, meta = (EditInRuntime))
 	bool bIsLanLong = false;
 
+	/** Max error [cm] of the linearized Lat/Long conversion, 0 - always use the exact conversion */
+	UPROPERTY(EditAnywhere, Category = PathViewer, meta=(EditCondition="bIsLanLong"), SaveGame, meta = (EditInRuntime))
+	float MaxLinearError = 1.0;
+
     /** X = inX * ScaleX + DX*/
 	UPROPERTY(EditAnywhere, Category = PathViewer, meta=(EditCondition="!bIsLanLong"), SaveGame, meta = (EditInRuntime))
 	float ScaleX = 100.0;
@@ -75,6 +80,15 @@ private:
 	std::vector< double > Buf;
 	std::vector< double > DrawBuf;
 	std::mutex mutex;
+	uint64 BufVersion = 0;
+
+	/** Converted path, updated only if the received path or the conversion parameters are changed */
+	TArray<FVector> LonLatAlt;
+	TArray<FVector> Points;
+	uint64 PointsVersion = uint64(-1);
+	bool bPointsIsLanLong = false;
+	float PointsMaxLinearError = 0;
+	FLLConverter PointsConverter;
 
 	bool bIsPinnedActor = true;
 
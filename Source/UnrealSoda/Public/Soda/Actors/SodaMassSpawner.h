@@ -4,9 +4,19 @@
 
 #include "CoreMinimal.h"
 #include "MassSpawner.h"
+#include "MassEntityTypes.h"
 #include "Soda/ISodaActor.h"
+#include "Soda/Mass/SodaTrafficTypes.h"
 #include "SodaMassSpawner.generated.h"
 
+class UInstancedStaticMeshComponent;
+
+/**
+ * ASodaMassSpawner
+ * Spawns the EntityTypes by the AMassSpawner, or the native Mass traffic if bNativeTraffic is set.
+ * The native traffic agents drive along the ANavigationRoute graph (see USodaTrafficDriveProcessor), are rendered by the
+ * InstancedMesh and are promoted to the full vehicles near the ego vehicle (see USodaTrafficRepresentationProcessor).
+ */
 UCLASS()
 class UNREALSODA_API ASodaMassSpawner : public AMassSpawner, public ISodaActor
 {
@@ -28,6 +38,16 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Traffic, SaveGame, meta = (EditInRuntime))
 	int32 OverridenCount = 20;
 
+	/** Spawn OverridenCount agents of the native Mass traffic instead of the EntityTypes */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Traffic, SaveGame, meta = (EditInRuntime))
+	bool bNativeTraffic = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Traffic, SaveGame, meta = (EditInRuntime))
+	FSodaTrafficConfig NativeTraffic;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Traffic)
+	TObjectPtr<UInstancedStaticMeshComponent> InstancedMesh;
+
 	UFUNCTION(BlueprintCallable, Category = "Traffic", CallInEditor)
 	void ToggleSpawnTraffic();
 
@@ -42,6 +62,11 @@ public:
 	virtual void ScenarioBegin() override;
 	virtual void ScenarioEnd() override;
 
+protected:
+	void SpawnNativeTraffic();
+	void DespawnNativeTraffic();
+
 private:
 	bool bHiddenInScenario = false;
+	TArray<FMassEntityHandle> NativeEntities;
 };
@@ -26,6 +26,7 @@ class UNREALSODA_API AWeatherSystem
 public:
 	AWeatherSystem();
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void PreInitializeComponents() override;
 	virtual void Serialize(FArchive& Ar) override;
 	
@@ -80,6 +81,18 @@ public:
 	UPROPERTY(EditAnywhere, Category = Weather, SaveGame, meta = (EditInRuntime))
 	float VolumetricCloudsLayout = 3.f;
 
+	// Rain intensity seen by the sensors, mm/h
+	UPROPERTY(EditAnywhere, Category = Weather, SaveGame, meta = (EditInRuntime))
+	float RainRate = 0.f;
+
+	// Snow intensity seen by the sensors, mm/h of the melted water
+	UPROPERTY(EditAnywhere, Category = Weather, SaveGame, meta = (EditInRuntime))
+	float SnowRate = 0.f;
+
+	// Fog visibility seen by the sensors, m; 0 - no fog
+	UPROPERTY(EditAnywhere, Category = Weather, SaveGame, meta = (EditInRuntime))
+	float FogVisibility = 0.f;
+
 public:
 	/* Override from ISodaActor */
 	//virtual void OnSelect_Implementation() override;
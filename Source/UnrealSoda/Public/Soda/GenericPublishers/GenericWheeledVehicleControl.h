@@ -4,15 +4,67 @@
 
 #include "Soda/VehicleComponents/GenericVehicleComponentHelpers.h"
 #include "Soda/Vehicles/VehicleBaseTypes.h"
+#include "Soda/Misc/ControlMailbox.h"
 #include "GenericWheeledVehicleControl.generated.h"
 
 namespace soda
 {
-	struct FGenericWheeledVehiclControl;
-}
+	struct FGenericWheeledVehiclControl
+	{
+		union
+		{
+			float ByAngle; // [rad]
+			float ByRatio; // [-1..1]
+		} SteerReq;
+
+		/** Zero value means change speed as quickly as possible to TargetSpeed */
+		union
+		{
+			float ByAcc; // [cm/s^2]
+			float ByRatio; // [-1..1]
+		} DriveEffortReq;
+
+		/** [rad/s] Zero value means change speed as quickly as possible to SteerReq.ByAngle */
+		float SteeringAngleVelocity;
+
+		/** [cm/s] */
+		float TargetSpeedReq;
+
+		EGearState GearStateReq;
+		/**
+		 * Desire gear number for the DRIVE and REVERSE gear only;
+		 * Values:
+		 *   - 0        - automatic/undefined;
+		 *   - others
+		 */
+		int8 GearNumReq;
+
+		enum class ESteerReqMode: uint8
+		{
+			ByRatio,
+			ByAngle
+		};
+
+		enum class EDriveEffortReqMode : uint8
+		{
+			ByRatio,
+			ByAcc
+		};
+		bool bTargetSpeedIsSet;
+		bool bGearIsSet;
+		bool bSteeringAngleVelocitySet;
+		ESteerReqMode SteerReqMode;
+		EDriveEffortReqMode DriveEffortReqMode;
+
+		TTimestamp Timestamp;
+	};
+
+} // namespace soda
 
 /**
- * UGenericWheeledVehiclePublisher
+ * UGenericWheeledVehicleControlListener
+ * Receivers push the controls to the lock-free mailbox from their own threads by PushControl(),
+ * the vehicle driver reads the latest control by GetControl() from the physics thread.
  */
 UCLASS(abstract, ClassGroup = Soda, EditInlineNew)
 class UNREALSODA_API UGenericWheeledVehicleControlListener: public UGenericListener
@@ -20,7 +72,45 @@ class UNREALSODA_API UGenericWheeledVehicleControlListener: public UGenericListe
 	GENERATED_BODY()
 
 public:
-	virtual bool GetControl(soda::FGenericWheeledVehiclControl& Control) const { return false; }
+	/** The control is considered lost if no new control was received during this time [s] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Watchdog, SaveGame, meta = (EditInRuntime))
+	float WatchdogTimeout = 0.5;
+
+	/** Switch the vehicle to the safe stop if the control is lost. Otherwise the last control is held */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Watchdog, SaveGame, meta = (EditInRuntime))
+	bool bSafeStopOnTimeout = true;
+
+public:
+	/** Get the latest received control. Returns false if nothing was received yet */
+	virtual bool GetControl(soda::FGenericWheeledVehiclControl& Control) const;
+
+	/** Whether the latest control is older than WatchdogTimeout */
+	virtual bool IsControlTimeout() const;
+
+	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+
+protected:
+	/** Put the new control to the mailbox. Must be called from one receiver thread */
+	void PushControl(const soda::FGenericWheeledVehiclControl& Control, const TTimestamp& SenderTimestamp);
+
+	/** Same for the protocols without the sender timestamp, the transport latency isn't measured */
+	void PushControl(const soda::FGenericWheeledVehiclControl& Control);
+
+	/** Reset the mailbox and the statistics, call it from StartListen() */
+	void ResetMailbox();
+
+protected:
+	soda::TControlMailbox<soda::FGenericWheeledVehiclControl> Mailbox;
+
+	/** Sender -> receiver latency */
+	soda::FLatencyHistogram TransportLatency;
+
+	/** Receiver -> consumer latency, the age of each control at its first read */
+	mutable soda::FLatencyHistogram DeliveryLatency;
+
+	mutable std::atomic<uint64> LastReadVersion{ 0 };
+	mutable std::atomic<uint64> TimeoutsNum{ 0 };
+	mutable std::atomic<bool> bTimeoutReported{ false };
 };
 
 
@@ -0,0 +1,322 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "Soda/GenericPublishers/GenericCameraPublisher.h"
+#include "Soda/GenericPublishers/GenericLidarPublisher.h"
+#include "Soda/GenericPublishers/GenericNavPublisher.h"
+#include "Soda/GenericPublishers/GenericRacingPublisher.h"
+#include "Soda/GenericPublishers/GenericRadarPublisher.h"
+#include "Soda/GenericPublishers/GenericUltrasoncPublisher.h"
+#include "Soda/GenericPublishers/GenericV2XPublisher.h"
+#include "Soda/GenericPublishers/GenericWheeledVehiclePublisher.h"
+#include "Soda/Misc/SensorRecord.h"
+#include "RecordingPublishers.generated.h"
+
+struct FCameraFrame;
+struct FPhysBodyKinematic;
+struct FImuNoiseParams;
+struct FRadarParams;
+struct FRadarClusters;
+struct FRadarObjects;
+struct FUltrasonicEchos;
+
+/**
+ * FSensorRecordSettings
+ */
+USTRUCT(BlueprintType)
+struct UNREALSODA_API FSensorRecordSettings
+{
+	GENERATED_BODY()
+
+	/** The relative path is relative to the "<ProjectSaved>/SensorRecords". All publishers with the same file name are recorded to one file */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Recording, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FString FileName = TEXT("Record.srec");
+
+	/** "<Vehicle>.<Component>" if empty. The replay finds the stream by this name */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Recording, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FString StreamName;
+
+	/** Size of the in-memory chunk written to the file at once [MB]; used by the first publisher opening the file */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Recording, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	int ChunkSizeMB = 16;
+};
+
+namespace soda
+{
+
+/**
+ * One stream of the FSensorRecordWriter used by the recording publisher
+ */
+class UNREALSODA_API FSensorRecordStream
+{
+public:
+	bool Open(const FSensorRecordSettings& Settings, const UVehicleBaseComponent* Parent, ESensorRecordPayload InPayload);
+	void Close();
+	bool IsOpen() const { return Writer.IsValid(); }
+	bool Write(const FSensorDataHeader& Header, float DeltaTime, TFunctionRef<void(FArchive&)> Serializer);
+	FString GetRemark() const;
+	void DrawDebug(UCanvas* Canvas, float& YL, float& YPos);
+
+protected:
+	TSharedPtr<FSensorRecordWriter> Writer;
+	FString Name;
+	int32 StreamId = 0;
+	ESensorRecordPayload Payload = ESensorRecordPayload::Camera;
+	TAtomic<int64> Frames{ 0 };
+};
+
+/*
+ * The frame payloads of the sensor record. Saving doesn't change the data, so the const data can be passed by const_cast.
+ * Only the plain data is recorded, the pointers (FRadarCluster::Hits, FRadarObject::ObjectActor etc.) are empty after loading.
+ */
+UNREALSODA_API void SerializeRecord(FArchive& Ar, FCameraFrame& CameraFrame, TArray<FColor>& BGRA8, uint32& ImageStride);
+UNREALSODA_API void SerializeRecord(FArchive& Ar, FLidarSensorData& Scan);
+UNREALSODA_API void SerializeRecord(FArchive& Ar, FTransform& RelativeTransform, FPhysBodyKinematic& VehicleKinematic, FImuNoiseParams& Covariance);
+UNREALSODA_API void SerializeRecord(FArchive& Ar, FRacingSensorData& SensorData);
+UNREALSODA_API void SerializeRecord(FArchive& Ar, TArray<FRadarParams>& Params, FRadarClusters& Clusters, FRadarObjects& Objects);
+UNREALSODA_API void SerializeRecord(FArchive& Ar, TArray<FUltrasonicEchos>& EchoCollections);
+
+} // namespace soda
+
+/**
+ * URecordingCameraPublisher
+ * Records the frames to the sensor record file and passes them through to the Forward publisher.
+ */
+UCLASS(ClassGroup = Soda, BlueprintType)
+class UNREALSODA_API URecordingCameraPublisher : public UGenericCameraPublisher
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Publisher, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FSensorRecordSettings Recording;
+
+	/** Optional live publisher */
+	UPROPERTY(EditAnywhere, Instanced, Category = Publisher, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	TObjectPtr<UGenericCameraPublisher> Forward;
+
+public:
+	virtual bool Advertise(UVehicleBaseComponent* Parent) override;
+	virtual void Shutdown() override;
+	virtual bool IsInitializing() const override;
+	virtual bool IsOk() const override;
+	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual FString GetRemark() const override;
+	virtual bool Publish(float DeltaTime, const FSensorDataHeader& Header, const FCameraFrame& CameraFrame, const TArray<FColor>& BGRA8, uint32 ImageStride) override;
+
+protected:
+	soda::FSensorRecordStream Stream;
+};
+
+/**
+ * URecordingLidarPublisher
+ * Records the scans to the sensor record file and passes them through to the Forward publisher.
+ */
+UCLASS(ClassGroup = Soda, BlueprintType)
+class UNREALSODA_API URecordingLidarPublisher : public UGenericLidarPublisher
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Publisher, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FSensorRecordSettings Recording;
+
+	/** Optional live publisher */
+	UPROPERTY(EditAnywhere, Instanced, Category = Publisher, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	TObjectPtr<UGenericLidarPublisher> Forward;
+
+public:
+	virtual bool Advertise(UVehicleBaseComponent* Parent) override;
+	virtual void Shutdown() override;
+	virtual bool IsInitializing() const override;
+	virtual bool IsOk() const override;
+	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual FString GetRemark() const override;
+	virtual bool Publish(float DeltaTime, const FSensorDataHeader& Header, const soda::FLidarSensorData& Scan) override;
+
+protected:
+	soda::FSensorRecordStream Stream;
+};
+
+/**
+ * URecordingNavPublisher
+ * Records the kinematic to the sensor record file and passes it through to the Forward publisher.
+ */
+UCLASS(ClassGroup = Soda, BlueprintType)
+class UNREALSODA_API URecordingNavPublisher : public UGenericNavPublisher
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Publisher, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FSensorRecordSettings Recording;
+
+	/** Optional live publisher */
+	UPROPERTY(EditAnywhere, Instanced, Category = Publisher, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	TObjectPtr<UGenericNavPublisher> Forward;
+
+public:
+	virtual bool Advertise(UVehicleBaseComponent* Parent) override;
+	virtual void Shutdown() override;
+	virtual bool IsInitializing() const override;
+	virtual bool IsOk() const override;
+	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual FString GetRemark() const override;
+	virtual bool Publish(float DeltaTime, const FSensorDataHeader& Header, const FTransform& RelativeTransform, const FPhysBodyKinematic& VehicleKinematic, const FImuNoiseParams& Covariance) override;
+
+protected:
+	soda::FSensorRecordStream Stream;
+};
+
+/**
+ * URecordingRacingPublisher
+ * Records the sensor data to the sensor record file and passes it through to the Forward publisher.
+ */
+UCLASS(ClassGroup = Soda, BlueprintType)
+class UNREALSODA_API URecordingRacingPublisher : public UGenericRacingPublisher
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Publisher, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FSensorRecordSettings Recording;
+
+	/** Optional live publisher */
+	UPROPERTY(EditAnywhere, Instanced, Category = Publisher, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	TObjectPtr<UGenericRacingPublisher> Forward;
+
+public:
+	virtual bool Advertise(UVehicleBaseComponent* Parent) override;
+	virtual void Shutdown() override;
+	virtual bool IsInitializing() const override;
+	virtual bool IsOk() const override;
+	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual FString GetRemark() const override;
+	virtual bool Publish(float DeltaTime, const FSensorDataHeader& Header, const soda::FRacingSensorData& SensorData) override;
+
+protected:
+	soda::FSensorRecordStream Stream;
+};
+
+/**
+ * URecordingRadarPublisher
+ * Records the clusters and the objects to the sensor record file and passes them through to the Forward publisher.
+ */
+UCLASS(ClassGroup = Soda, BlueprintType)
+class UNREALSODA_API URecordingRadarPublisher : public UGenericRadarPublisher
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Publisher, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FSensorRecordSettings Recording;
+
+	/** Optional live publisher */
+	UPROPERTY(EditAnywhere, Instanced, Category = Publisher, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	TObjectPtr<UGenericRadarPublisher> Forward;
+
+public:
+	virtual bool Advertise(UVehicleBaseComponent* Parent) override;
+	virtual void Shutdown() override;
+	virtual bool IsInitializing() const override;
+	virtual bool IsOk() const override;
+	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual FString GetRemark() const override;
+	virtual bool Publish(float DeltaTime, const FSensorDataHeader& Header, const TArray<FRadarParams>& Params, const FRadarClusters& Clusters, const FRadarObjects& Objects) override;
+
+protected:
+	soda::FSensorRecordStream Stream;
+};
+
+/**
+ * URecordingUltrasoncHubPublisher
+ * Records the echos to the sensor record file and passes them through to the Forward publisher.
+ */
+UCLASS(ClassGroup = Soda, BlueprintType)
+class UNREALSODA_API URecordingUltrasoncHubPublisher : public UGenericUltrasoncHubPublisher
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Publisher, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FSensorRecordSettings Recording;
+
+	/** Optional live publisher */
+	UPROPERTY(EditAnywhere, Instanced, Category = Publisher, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	TObjectPtr<UGenericUltrasoncHubPublisher> Forward;
+
+public:
+	virtual bool Advertise(UVehicleBaseComponent* Parent) override;
+	virtual void Shutdown() override;
+	virtual bool IsInitializing() const override;
+	virtual bool IsOk() const override;
+	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual FString GetRemark() const override;
+	virtual bool Publish(float DeltaTime, const FSensorDataHeader& Header, const TArray<FUltrasonicEchos>& InEchoCollections) override;
+
+protected:
+	soda::FSensorRecordStream Stream;
+};
+
+/**
+ * URecordingV2XPublisher
+ * Records the snapshot of the transmitters (ID, transform, velocities, bound) to the sensor record file and passes
+ * the frames through to the Forward publisher. The stream can't be replayed, the transmitters are the live components.
+ */
+UCLASS(ClassGroup = Soda, BlueprintType)
+class UNREALSODA_API URecordingV2XPublisher : public UGenericV2XPublisher
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Publisher, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FSensorRecordSettings Recording;
+
+	/** Optional live publisher */
+	UPROPERTY(EditAnywhere, Instanced, Category = Publisher, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	TObjectPtr<UGenericV2XPublisher> Forward;
+
+public:
+	virtual bool Advertise(UVehicleBaseComponent* Parent) override;
+	virtual void Shutdown() override;
+	virtual bool IsInitializing() const override;
+	virtual bool IsOk() const override;
+	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual FString GetRemark() const override;
+	virtual bool Publish(float DeltaTime, const FSensorDataHeader& Header, const TArray<UV2XMarkerSensor*>& Transmitters) override;
+
+protected:
+	soda::FSensorRecordStream Stream;
+};
+
+/**
+ * URecordingWheeledVehiclePublisher
+ * Records the snapshot of the vehicle state (kinematic, gear, drive mode, steer, wheels) to the sensor record file and
+ * passes the frames through to the Forward publisher. The stream can't be replayed, the state refers to the live vehicle.
+ */
+UCLASS(ClassGroup = Soda, BlueprintType)
+class UNREALSODA_API URecordingWheeledVehiclePublisher : public UGenericWheeledVehiclePublisher
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Publisher, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FSensorRecordSettings Recording;
+
+	/** Optional live publisher */
+	UPROPERTY(EditAnywhere, Instanced, Category = Publisher, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	TObjectPtr<UGenericWheeledVehiclePublisher> Forward;
+
+public:
+	virtual bool Advertise(UVehicleBaseComponent* Parent) override;
+	virtual void Shutdown() override;
+	virtual bool IsInitializing() const override;
+	virtual bool IsOk() const override;
+	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual FString GetRemark() const override;
+	virtual bool Publish(float DeltaTime, const FSensorDataHeader& Header, const FWheeledVehicleSensorData& VehicleState) override;
+
+protected:
+	soda::FSensorRecordStream Stream;
+};
@@ -123,6 +123,9 @@ public:
 	/** Called when the scenario ended */
 	virtual void ScenarioEnd();
 
+	/** Save or load the runtime state which isn't covered by the SaveGame properties. See ALevelState::TakeSnapshot() */
+	virtual void SerializeSnapshot(FArchive& Ar) {}
+
 	virtual AActor* AsActor();
 	virtual const AActor* AsActor() const;
 
@@ -250,6 +250,9 @@ public:
 
 	virtual void ScenarioEnd() {}
 
+	/** Save or load the runtime state which isn't covered by the SaveGame properties. See ALevelState::TakeSnapshot() */
+	virtual void SerializeSnapshot(FArchive& Ar) {}
+
 	virtual void DrawSelection(const FSceneView* View, FPrimitiveDrawInterface* PDI);
 
 	virtual void DrawVisualization(USodaGameViewportClient* ViewportClient, const FSceneView* View, FPrimitiveDrawInterface* PDI) {}
@@ -36,6 +36,32 @@ public:
 	virtual void Serialize(FArchive& Ar) override;
 };
 
+/*
+ * FLevelSnapshot
+ * Binary in-memory snapshot of the runtime state of the level, see ALevelState::TakeSnapshot()
+ */
+USTRUCT(BlueprintType)
+struct UNREALSODA_API FLevelSnapshot
+{
+	GENERATED_BODY()
+
+	/** Increment if the layout of the snapshot is changed */
+	static constexpr int32 CurrentVersion = 2;
+
+	int32 Version = 0;
+	TWeakObjectPtr<UWorld> World;
+
+	/** UWorld::GetTimeSeconds() [s] */
+	double WorldTime = 0;
+
+	/** USodaSimulationClock::GetSimulatedSeconds() [s] */
+	double SimulatedSeconds = 0;
+
+	TArray<uint8> Data;
+
+	bool IsValid() const { return Version == CurrentVersion && World.IsValid(); }
+};
+
 /*
  * ALevelState
  */
@@ -64,6 +90,10 @@ public:
 	UPROPERTY(BlueprintReadOnly, Category = LevelState)
 	ASodaActorFactory * ActorFactory = nullptr;
 
+	/** Seed of the sensors noise. With the same seed the sensors reproduce the same noise in the synchronous mode */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, SaveGame, Category = LevelState, meta = (EditInRuntime))
+	int32 NoiseSeed = 0;
+
 protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, SaveGame, Category = LevelState, meta = (EditInRuntime))
 	FLLConverter LLConverter;
@@ -91,6 +121,23 @@ public:
 	UFUNCTION(BlueprintCallable, Category = LevelState)
 	virtual void ClearLevel();
 
+	/**
+	 * Take the binary snapshot of the runtime state of all ISodaActors: transforms, physics velocities and the state of
+	 * ISodaActor::SerializeSnapshot() (vehicle dynamics, powertrain, noise generators).
+	 * Unlike SaveToToMemory() it doesn't go through the SaveGame properties and RestoreSnapshot() doesn't respawn
+	 * the actors, so it can be used for the rewind and forking of the runs from a common prefix.
+	 * The snapshot is valid only for the world it was taken from.
+	 */
+	UFUNCTION(BlueprintCallable, Category = LevelState)
+	bool TakeSnapshot(FLevelSnapshot& OutSnapshot) const;
+
+	/**
+	 * Restore the snapshot in place, including the world time and the simulated time of the USodaSimulationClock.
+	 * The actors spawned after the snapshot are kept, the removed actors are skipped
+	 */
+	UFUNCTION(BlueprintCallable, Category = LevelState)
+	bool RestoreSnapshot(const FLevelSnapshot& Snapshot);
+
 	const FLLConverter& GetLLConverter() const { return LLConverter; }
 	void SetGeoReference(double Lat, double Lon, double Alt, const FVector& OrignShift = FVector{ 0, 0, 0 }, float OrignDYaw = 0);
 
@@ -0,0 +1,48 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "MassProcessor.h"
+#include "MassEntityQuery.h"
+#include "SodaTrafficProcessors.generated.h"
+
+/**
+ * USodaTrafficDriveProcessor
+ * Rebuilds the lane occupancy, then moves every agent along the lane graph in parallel:
+ * IDM for the longitudinal control and MOBIL for the lane change decision.
+ */
+UCLASS()
+class UNREALSODA_API USodaTrafficDriveProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	USodaTrafficDriveProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+	FMassEntityQuery EntityQuery;
+};
+
+/**
+ * USodaTrafficRepresentationProcessor
+ * Game thread part of the traffic: writes the agents to the instanced mesh, promotes the agents near the ego vehicle
+ * to the full vehicles and demotes them back, and adds the ego vehicle to the lane occupancy.
+ */
+UCLASS()
+class UNREALSODA_API USodaTrafficRepresentationProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	USodaTrafficRepresentationProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+	FMassEntityQuery EntityQuery;
+	TArray<FTransform> Transforms;
+};
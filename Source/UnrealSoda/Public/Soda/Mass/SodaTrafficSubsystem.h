@@ -0,0 +1,55 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Soda/Mass/SodaTrafficTypes.h"
+#include "SodaTrafficSubsystem.generated.h"
+
+class UInstancedStaticMeshComponent;
+
+/**
+ * USodaTrafficSubsystem
+ * Shared state of the native Mass traffic: the lane graph built from the ANavigationRoute actors, the per-lane occupancy
+ * rebuilt by USodaTrafficDriveProcessor every frame, and the instanced mesh the agents are rendered with.
+ */
+UCLASS()
+class UNREALSODA_API USodaTrafficSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void SetConfig(const FSodaTrafficConfig& InConfig) { Config = InConfig; }
+	const FSodaTrafficConfig& GetConfig() const { return Config; }
+
+	/** Resample all routes allowed for vehicles. Returns false if there are no such routes */
+	bool RebuildLaneGraph();
+	const TArray<soda::FTrafficLane>& GetLanes() const { return Lanes; }
+	TArray<soda::FTrafficLane>& GetLanes() { return Lanes; }
+
+	/** Find the lane and the distance along it closest to the Location, the lane must be codirected with the Direction */
+	bool FindNearestLane(const FVector& Location, const FVector& Direction, float MaxDistance, int32& OutLane, float& OutDistance) const;
+
+	/** Pick the random lane weighted by the length and the route probability; Random is in [0, 1) */
+	int32 PickLane(float Random) const;
+
+	/** Obstacles not driven by Mass (ego vehicle), added to the occupancy every frame */
+	TArray<TPair<int32, soda::FTrafficSlot>>& GetExternalObstacles() { return ExternalObstacles; }
+
+	/** IDM acceleration [m/s2]; Gap [m] between the bumpers, MAX_FLT if there is no leader */
+	float CalcAcceleration(float Speed, float DesiredSpeed, float Gap, float LeaderSpeed) const;
+
+	void SetInstancedMesh(UInstancedStaticMeshComponent* InInstancedMesh) { InstancedMesh = InInstancedMesh; }
+	void UpdateInstances(const TArray<FTransform>& Transforms);
+
+	bool IsPromotedVehicle(const AActor* Actor) const { return PromotedVehicles.Contains(Actor); }
+	TSet<TObjectKey<AActor>>& GetPromotedVehicles() { return PromotedVehicles; }
+
+protected:
+	FSodaTrafficConfig Config;
+	TArray<soda::FTrafficLane> Lanes;
+	TArray<float> LaneWeights;
+	TArray<TPair<int32, soda::FTrafficSlot>> ExternalObstacles;
+	TWeakObjectPtr<UInstancedStaticMeshComponent> InstancedMesh;
+	TSet<TObjectKey<AActor>> PromotedVehicles;
+};
@@ -0,0 +1,193 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "MassEntityTypes.h"
+#include "SodaTrafficTypes.generated.h"
+
+class ASodaVehicle;
+class ANavigationRoute;
+class UStaticMesh;
+
+/**
+ * Parameters of the native Mass traffic. IDM (car-following) and MOBIL (lane change) parameters are in SI units.
+ */
+USTRUCT(BlueprintType)
+struct UNREALSODA_API FSodaTrafficConfig
+{
+	GENERATED_BODY()
+
+	/** Mesh of the traffic agents. Its simple collision is used as the proxy shape, so agents are visible for the lidar and radar traces */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Traffic, SaveGame, meta = (EditInRuntime))
+	TObjectPtr<UStaticMesh> Mesh;
+
+	/** [cm] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Traffic, SaveGame, meta = (EditInRuntime))
+	float VehicleLength = 450;
+
+	/** [km/h] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Traffic, SaveGame, meta = (EditInRuntime))
+	float DesiredSpeed = 50;
+
+	/** Relative spread of the desired speed between agents */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Traffic, SaveGame, meta = (EditInRuntime, ClampMin = 0, ClampMax = 1))
+	float DesiredSpeedSpread = 0.1;
+
+	/** [cm] Distance between the lane samples, the lanes are evaluated by the samples instead of the splines */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Traffic, SaveGame, meta = (EditInRuntime, ClampMin = 10))
+	float LaneSampleStep = 100;
+
+	/** [m/s2] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = IDM, SaveGame, meta = (EditInRuntime))
+	float MaxAcceleration = 1.5;
+
+	/** [m/s2] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = IDM, SaveGame, meta = (EditInRuntime))
+	float ComfortDeceleration = 2.0;
+
+	/** [s] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = IDM, SaveGame, meta = (EditInRuntime))
+	float TimeHeadway = 1.5;
+
+	/** [m] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = IDM, SaveGame, meta = (EditInRuntime))
+	float MinGap = 2.0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MOBIL, SaveGame, meta = (EditInRuntime, ClampMin = 0, ClampMax = 1))
+	float Politeness = 0.3;
+
+	/** [m/s2] Min advantage of the lane change */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MOBIL, SaveGame, meta = (EditInRuntime))
+	float LaneChangeThreshold = 0.2;
+
+	/** [m/s2] Max deceleration imposed on the new follower */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MOBIL, SaveGame, meta = (EditInRuntime))
+	float SafeDeceleration = 4.0;
+
+	/** [s] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MOBIL, SaveGame, meta = (EditInRuntime))
+	float LaneChangeDuration = 3.0;
+
+	/** [s] Every agent evaluates the lane change with this period */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MOBIL, SaveGame, meta = (EditInRuntime))
+	float LaneChangeCheckPeriod = 1.0;
+
+	/** Vehicle spawned instead of the agent near the ego vehicle. Should have a driver following the navigation routes. None - don't promote */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Promotion, SaveGame, meta = (EditInRuntime))
+	TSubclassOf<ASodaVehicle> PromotedVehicleClass;
+
+	/** [cm] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Promotion, SaveGame, meta = (EditInRuntime))
+	float PromotionDistance = 5000;
+
+	/** [cm] Should be greater than PromotionDistance */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Promotion, SaveGame, meta = (EditInRuntime))
+	float DemotionDistance = 7000;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Promotion, SaveGame, meta = (EditInRuntime))
+	int32 MaxPromoted = 8;
+};
+
+/**
+ * State of the traffic agent on the lane graph, see USodaTrafficSubsystem
+ */
+USTRUCT()
+struct UNREALSODA_API FSodaTrafficAgentFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	int32 Lane = INDEX_NONE;
+	float Distance = 0; // [cm] along the lane, center of the agent
+	float Speed = 0; // [m/s]
+	float DesiredSpeed = 0; // [m/s]
+	float Acceleration = 0; // [m/s2]
+
+	/** Lane change, the agent is blended from PrevLane to Lane while LaneChangeAlpha < 1 */
+	int32 PrevLane = INDEX_NONE;
+	float LaneChangeAlpha = 1;
+	float LaneChangeTimer = 0;
+
+	/** Key of the agent random numbers */
+	uint32 Seed = 0;
+	uint32 RecycleCount = 0;
+};
+
+/**
+ * Full vehicle replacing the agent near the ego vehicle
+ */
+USTRUCT()
+struct UNREALSODA_API FSodaTrafficPromotionFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	TWeakObjectPtr<ASodaVehicle> Vehicle;
+};
+
+namespace soda
+{
+
+/** Agent (or external obstacle) on the lane, snapshot of the current frame */
+struct FTrafficSlot
+{
+	float Distance; // [cm]
+	float Speed; // [m/s]
+	float DesiredSpeed; // [m/s], 0 for external obstacles
+	float Length; // [cm]
+	int32 AgentId; // INDEX_NONE for external obstacles
+};
+
+/** Point where the lane crosses another lane, see BuildTrafficCrossings() */
+struct FTrafficCrossing
+{
+	float Distance; // [cm] along this lane
+	int32 OtherLane;
+	float OtherDistance; // [cm] along the other lane
+};
+
+/**
+ * Navigation route resampled for the traffic. Left, Right and Successor are indices of the lanes in the lane graph.
+ */
+struct UNREALSODA_API FTrafficLane
+{
+	TWeakObjectPtr<ANavigationRoute> Route;
+	float Length = 0; // [cm]
+	float SampleStep = 100; // [cm]
+	float Probability = 1;
+	TArray<FVector> Locations;
+	TArray<FVector> Directions;
+	FBox Bounds{ ForceInit };
+	int32 Left = INDEX_NONE;
+	int32 Right = INDEX_NONE;
+	int32 Successor = INDEX_NONE;
+
+	/** Sorted by Distance */
+	TArray<FTrafficSlot> Slots;
+
+	/** Sorted by Distance, empty unless BuildTrafficCrossings() is called */
+	TArray<FTrafficCrossing> Crossings;
+
+	void GetLocation(float Distance, FVector& OutLocation, FVector& OutDirection) const;
+
+	/** Find the distance along the lane of the closest point to the Location in the window [Guess - Window, Guess + Window] */
+	float Project(const FVector& Location, float Guess, float Window, float* OutSqDist = nullptr) const;
+
+	/** Map the distance to the parallel lane */
+	float MapDistance(float Distance, const FTrafficLane& Other) const { return Length > 0 ? Distance * Other.Length / Length : 0; }
+
+	/** Find the nearest slots ahead and behind the Distance, the slot of the SelfId agent is skipped */
+	void FindNeighbours(float Distance, int32 SelfId, const FTrafficSlot*& OutLeader, const FTrafficSlot*& OutFollower) const;
+};
+
+/** Resample all routes allowed for vehicles (except the backward ones) into the lanes and link the lanes by the route connections */
+UNREALSODA_API void BuildTrafficLanes(const UWorld* World, float SampleStep, TArray<FTrafficLane>& OutLanes);
+
+/**
+ * Find the crossings between the lanes in the horizontal plane. The lanes whose heights at the crossing differ by more
+ * than MaxHeightDelta [cm] (bridges) and the lanes connected by their ends (junction merges and splits) are skipped.
+ */
+UNREALSODA_API void BuildTrafficCrossings(TArray<FTrafficLane>& Lanes, float MaxHeightDelta);
+
+/** Find the lane and the distance along it closest to the Location, the lane must be codirected with the Direction (any lane if it is zero) */
+UNREALSODA_API bool FindNearestTrafficLane(const TArray<FTrafficLane>& Lanes, const FVector& Location, const FVector& Direction, float MaxDistance, int32& OutLane, float& OutDistance);
+
+} // namespace soda
@@ -0,0 +1,139 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+
+class AActor;
+class UActorComponent;
+struct FJsonActorArchive;
+
+namespace soda
+{
+
+/**
+ * FPropertyLayout
+ * List of the SaveGame properties of the UStruct, compiled once per class and cached.
+ * The object is stored as the layout hash and the list of the values, every value is prefixed by the name hash and size.
+ * If the layout hash of the stored object matches the current one the values are read in order without any lookup,
+ * otherwise the values are matched by the name hash and unknown values are skipped, so old files can be still loaded.
+ * Numeric and enum values and the structs of only such values are copied as is, other values (the object references,
+ * the names, the strings, the containers) are serialized by FSaveExtensionArchive.
+ */
+class UNREALSODA_API FPropertyLayout
+{
+public:
+	struct FEntry
+	{
+		FProperty* Property = nullptr;
+		FString Name;
+		uint32 NameHash = 0;
+		bool bPlainOldData = false;
+	};
+
+	/** Thread safe, but the UStruct must be alive */
+	static TSharedRef<const FPropertyLayout> Get(const UStruct* Struct);
+
+	void SaveObject(const void* Container, TArray<uint8>& OutData) const;
+
+	/** Save only the values for which Func returns true */
+	void SaveValues(TFunctionRef<bool(const FEntry& Entry, TArray<uint8>& OutValue)> Func, TArray<uint8>& OutData) const;
+
+	bool LoadObject(void* Container, const TArray<uint8>& Data) const;
+
+	/** Iterate over the stored values; the Entry is null if the value is unknown for this layout */
+	bool ForEachValue(const TArray<uint8>& Data, TFunctionRef<void(const FEntry* Entry, const TArray<uint8>& Value)> Func) const;
+
+	static void SaveValue(const FEntry& Entry, const void* ValuePtr, TArray<uint8>& OutValue);
+	static bool LoadValue(const FEntry& Entry, void* ValuePtr, const TArray<uint8>& Value);
+
+	/** The numeric and enum values and the POD structs of only such values, they are copied as is */
+	static bool IsPlainValue(const FProperty* Property);
+
+	const TArray<FEntry>& GetEntries() const { return Entries; }
+	const FEntry* FindEntry(uint32 NameHash) const;
+	uint32 GetLayoutHash() const { return LayoutHash; }
+
+	explicit FPropertyLayout(const UStruct* Struct);
+
+private:
+	TArray<FEntry> Entries;
+	TMap<uint32, int32> EntryByHash;
+	uint32 LayoutHash = 0;
+};
+
+} // namespace soda
+
+/**
+ * Binary data of the one object (actor or component) of the FBinaryActorArchive
+ */
+struct UNREALSODA_API FBinaryObjectData
+{
+	FString ClassPath;
+	FString Name;
+	bool bHasTransform = false;
+	FVector Location = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+	FVector Scale3D = FVector::OneVector;
+	TArray<uint8> Data;
+
+	friend FArchive& operator<<(FArchive& Ar, FBinaryObjectData& ObjectData);
+};
+
+/**
+ * FBinaryActorArchive
+ * Binary alternative to the FJsonActorArchive. The SaveGame properties of the actor and its components are written by
+ * the soda::FPropertyLayout, without building of the JSON DOM and without the tagged property names.
+ * Loading from the file/memory doesn't touch any UObject and can be done on a worker thread (see LoadFromFileAsync()),
+ * the classes are resolved later on the game thread.
+ */
+class UNREALSODA_API FBinaryActorArchive
+{
+public:
+	static constexpr uint32 Magic = 0x42444F53; // "SODB"
+	static constexpr int32 CurrentVersion = 2;
+
+	/** Version 1 stored the object pointers and the names as the raw memory, such files can't be loaded */
+	static constexpr int32 MinVersion = 2;
+
+	bool SerializeActor(const AActor* Actor, bool bWithComponents);
+	bool DeserializeActor(AActor* Actor, bool bWithComponents) const;
+
+	bool SerializeActorComponent(const UActorComponent* ActorComponent);
+	bool DeserializeComponent(UActorComponent* ActorComponent) const;
+
+	/** Game thread only */
+	UClass* GetActorClass() const { return GetObjectClass(ActorData); }
+	const FString& GetActorName() const { return ActorData.Name; }
+
+	/** Game thread only */
+	static UClass* GetObjectClass(const FBinaryObjectData& ObjectData);
+
+	const TArray<FBinaryObjectData>& GetComponents() const { return Components; }
+	const FBinaryObjectData* FindComponent(const FString& Name) const;
+
+	bool SaveToMemory(TArray<uint8>& OutData) const;
+	bool LoadFromMemory(const TArray<uint8>& Data);
+
+	bool SaveToFile(const FString& FileName) const;
+	bool LoadFromFile(const FString& FileName);
+
+	/** Check the magic of the data, to distinguish it from the USaveGameActor data */
+	static bool IsBinaryArchive(const TArray<uint8>& Data);
+
+	/** Read and decode the file on the thread pool; the result is null if the loading is failed */
+	static TFuture<TSharedPtr<FBinaryActorArchive>> LoadFromFileAsync(const FString& FileName);
+
+	/** JSON bridge; game thread only */
+	bool ImportJson(FJsonActorArchive& JsonAr);
+	bool ExportJson(FJsonActorArchive& JsonAr) const;
+
+protected:
+	static bool SerializeObject(const UObject* Object, FBinaryObjectData& OutObjectData);
+	static bool DeserializeObject(const FBinaryObjectData& ObjectData, UObject* Object, bool bTransform);
+
+	FBinaryObjectData ActorData;
+	TArray<FBinaryObjectData> Components;
+	TMap<FString, int32> ComponentIndices;
+};
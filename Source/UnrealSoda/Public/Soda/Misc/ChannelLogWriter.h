@@ -0,0 +1,100 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Soda/Misc/Time.h"
+
+class FRunnableThread;
+class FEvent;
+class IFileHandle;
+
+namespace soda
+{
+
+enum class EChannelLogFormat : uint8
+{
+	CSV,
+
+	/** CSV compressed by blocks; the blocks are the gzip members, so the file is the valid .csv.gz */
+	CSVGzip,
+};
+
+/**
+ * Background writer of the numeric channels log.
+ * The producer (e.g. the physics step) copies one row of the channel values to the lock-free single-producer
+ * single-consumer ring; the worker thread formats the rows, compresses them and writes them to the file.
+ * If the ring is full the row is dropped and counted, the producer never waits.
+ * The column schema is written next to the log as "<FileName>.schema.json".
+ */
+class UNREALSODA_API FChannelLogWriter : public FRunnable
+{
+public:
+	struct FColumn
+	{
+		FString Name;
+
+		/** Where the value comes from, only for the schema */
+		FString Source;
+	};
+
+	/** Capacity - the ring size [rows] */
+	FChannelLogWriter(int32 InCapacity = 8192) : Capacity(FMath::Max(InCapacity, 16)) {}
+	virtual ~FChannelLogWriter();
+
+	bool Open(const FString& FileName, EChannelLogFormat Format, const TArray<FColumn>& Columns);
+	void Close();
+	bool IsOpen() const { return Thread != nullptr; }
+	const FString& GetFileName() const { return FileName; }
+	int32 GetColumnsNum() const { return ColumnsNum; }
+
+	/** Producer only. Returns the row of GetColumnsNum() values to fill, or null if the ring is full */
+	double* BeginRow(const TTimestamp& Timestamp);
+
+	/** Producer only. Publishes the row returned by BeginRow() */
+	void CommitRow();
+
+	int64 GetWrittenRows() const { return WrittenRows; }
+	int64 GetDroppedRows() const { return DroppedRows; }
+	int64 GetWrittenBytes() const { return WrittenBytes; }
+
+	// FRunnable implementation Begin
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	// FRunnable implementation End
+
+protected:
+	bool WriteSchema(const TArray<FColumn>& Columns) const;
+	void FormatRow(uint64 Row);
+	void FlushText();
+
+	const int32 Capacity;
+	int32 ColumnsNum = 0;
+	EChannelLogFormat Format = EChannelLogFormat::CSV;
+	FString FileName;
+
+	TArray<double> Values;
+	TArray<int64> Timestamps;
+
+	/** Number of the rows committed by the producer */
+	TAtomic<uint64> Head{ 0 };
+
+	/** Number of the rows formatted by the worker */
+	TAtomic<uint64> Tail{ 0 };
+
+	/** Used by the worker only */
+	IFileHandle* File = nullptr;
+	TArray<ANSICHAR> Text;
+	TArray<uint8> Compressed;
+
+	TAtomic<int64> WrittenRows{ 0 };
+	TAtomic<int64> DroppedRows{ 0 };
+	TAtomic<int64> WrittenBytes{ 0 };
+
+	FRunnableThread* Thread = nullptr;
+	FEvent* WakeUpEvent = nullptr;
+	TAtomic<bool> bStopping{ false };
+};
+
+} // namespace soda
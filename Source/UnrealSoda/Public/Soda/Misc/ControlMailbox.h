@@ -0,0 +1,151 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Soda/Misc/Time.h"
+#include <atomic>
+#include <type_traits>
+
+namespace soda
+{
+
+/**
+ * Lock-free, versioned single-writer / multi-reader mailbox (seqlock).
+ * The writer (usually a network receiver thread) never blocks, readers (game or physics thread) never observe a torn value.
+ * T must be trivially copyable.
+ */
+template <typename T>
+class TControlMailbox
+{
+	static_assert(std::is_trivially_copyable<T>::value, "TControlMailbox requires a trivially copyable type");
+
+public:
+	struct FLetter
+	{
+		T Value;
+
+		/** Timestamp set by the sender. Equal to RecvTimestamp if the protocol doesn't provide it */
+		TTimestamp SenderTimestamp;
+
+		/** Timestamp of the receiving */
+		TTimestamp RecvTimestamp;
+
+		/** Version of the value, incremented by every Write(). Zero means nothing was received yet */
+		uint64 Version;
+	};
+
+	/** Must be called from the one writer thread only */
+	void Write(const T& Value, const TTimestamp& SenderTimestamp, const TTimestamp& RecvTimestamp)
+	{
+		const uint64 Seq = Sequence.load(std::memory_order_relaxed);
+		Sequence.store(Seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		Letter.Value = Value;
+		Letter.SenderTimestamp = SenderTimestamp;
+		Letter.RecvTimestamp = RecvTimestamp;
+		Letter.Version = Seq / 2 + 1;
+
+		Sequence.store(Seq + 2, std::memory_order_release);
+	}
+
+	/** Read the latest value. Returns false if nothing was written yet */
+	bool Read(FLetter& Out) const
+	{
+		while (true)
+		{
+			const uint64 Seq = Sequence.load(std::memory_order_acquire);
+			if (Seq & 1)
+			{
+				FPlatformProcess::YieldThread();
+				continue;
+			}
+
+			Out = Letter;
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if (Sequence.load(std::memory_order_relaxed) == Seq)
+			{
+				return Seq != 0;
+			}
+		}
+	}
+
+	uint64 GetVersion() const
+	{
+		return Sequence.load(std::memory_order_acquire) / 2;
+	}
+
+	void Reset()
+	{
+		Sequence.store(0, std::memory_order_release);
+	}
+
+private:
+	std::atomic<uint64> Sequence{ 0 };
+	FLetter Letter{};
+};
+
+/**
+ * Lock-free latency histogram with power-of-two buckets in microseconds:
+ * bucket 0: < 1us, bucket k: [2^(k-1), 2^k) us, the last bucket collects the rest.
+ */
+class FLatencyHistogram
+{
+public:
+	static constexpr int BucketsNum = 24;
+
+	void Add(std::chrono::nanoseconds Latency)
+	{
+		const int64 Us = FMath::Max<int64>(std::chrono::duration_cast<std::chrono::microseconds>(Latency).count(), 0);
+		const int Bucket = Us == 0 ? 0 : FMath::Min<int>(FMath::FloorLog2_64(uint64(Us)) + 1, BucketsNum - 1);
+		Buckets[Bucket].fetch_add(1, std::memory_order_relaxed);
+		Count.fetch_add(1, std::memory_order_relaxed);
+		SumUs.fetch_add(Us, std::memory_order_relaxed);
+
+		int64 PrevMax = MaxUs.load(std::memory_order_relaxed);
+		while (Us > PrevMax && !MaxUs.compare_exchange_weak(PrevMax, Us, std::memory_order_relaxed)) {}
+	}
+
+	void Reset()
+	{
+		for (auto& It : Buckets) It.store(0, std::memory_order_relaxed);
+		Count.store(0, std::memory_order_relaxed);
+		SumUs.store(0, std::memory_order_relaxed);
+		MaxUs.store(0, std::memory_order_relaxed);
+	}
+
+	uint64 GetCount() const { return Count.load(std::memory_order_relaxed); }
+	int64 GetMaxUs() const { return MaxUs.load(std::memory_order_relaxed); }
+	double GetMeanUs() const { const uint64 N = GetCount(); return N ? double(SumUs.load(std::memory_order_relaxed)) / N : 0.0; }
+
+	/** Upper bound of the bucket which contains the Percentile [0..1] of the samples [us] */
+	int64 GetPercentileUs(double Percentile) const
+	{
+		const uint64 N = GetCount();
+		if (N == 0)
+		{
+			return 0;
+		}
+		const uint64 Target = uint64(FMath::CeilToDouble(Percentile * N));
+		uint64 Acc = 0;
+		for (int i = 0; i < BucketsNum; ++i)
+		{
+			Acc += Buckets[i].load(std::memory_order_relaxed);
+			if (Acc >= Target)
+			{
+				return int64(1) << i;
+			}
+		}
+		return GetMaxUs();
+	}
+
+private:
+	std::atomic<uint64> Buckets[BucketsNum] = {};
+	std::atomic<uint64> Count{ 0 };
+	std::atomic<int64> SumUs{ 0 };
+	std::atomic<int64> MaxUs{ 0 };
+};
+
+} // namespace soda
@@ -4,9 +4,12 @@
 
 #include "Math/Vector.h"
 #include "Math/Rotator.h"
+#include "Containers/ArrayView.h"
 #include "LLConverter.generated.h"
 
 
+struct PJconsts;
+
 #define DEFAULT_LAT 59.995
 #define DEFAULT_LON 30.13
 #define DEFAULT_ALT 10.0
@@ -45,6 +48,19 @@ public:
 	FVector ConvertDirForward(const FVector& InVec) const;
 	FVector ConvertDirBackward(const FVector& InVec) const;
 
+	/**
+	 * Batch version of LLA2UE(). InLonLatAlt: X - Lon [deg], Y - Lat [deg], Z - Alt [m].
+	 * If MaxLinearError [cm] > 0 and the estimated error of the local tangent-plane linearization around the
+	 * centre of the points is less than MaxLinearError, the points are converted by the linearized transform without trigonometry.
+	 */
+	void LLA2UE(TArrayView<const FVector> InLonLatAlt, TArrayView<FVector> OutPositions, double MaxLinearError = 0) const;
+
+	/** Batch version of UE2LLA(). OutLonLatAlt: X - Lon [deg], Y - Lat [deg], Z - Alt [m]. Uses closed-form Vermeille inversion */
+	void UE2LLA(TArrayView<const FVector> InPositions, TArrayView<FVector> OutLonLatAlt) const;
+
+	/** Check if the Other converter has the same origin parameters */
+	bool IsSameOrign(const FLLConverter& Other) const;
+
 protected:
 	double orig_lambda;
 	double orig_phi;
@@ -82,5 +98,43 @@ protected:
 	to the Earth-Centered Earth-Fixed (ECEF) coordinates (x, y, z).
 	*/
 	void EnuToEcef(double xEast, double yNorth, double zUp, double & x, double & y, double & z) const;
+
+	/*
+	Closed-form (H. Vermeille, 2011) conversion of the Earth-Centered Earth-Fixed (ECEF) coordinates (x, y, z) to (WGS-84) Geodetic point (lat, lon, h).
+	*/
+	static void EcefToGeodeticVermeille(double x, double y, double z, double & lat, double & lon, double & h);
+
+	/* Converts ENU offset [m] to UE direction [cm] */
+	FVector EnuToUEDir(double xEast, double yNorth, double zUp) const;
 };
 
+/**
+ * WGS-84 <-> UTM batch conversion backed by PROJ.
+ * Uses the PROJ default context, so the converters must not be used from several threads at the same time.
+ */
+class UNREALSODA_API FUTMConverter
+{
+public:
+	FUTMConverter() = default;
+	FUTMConverter(const FUTMConverter&) = delete;
+	FUTMConverter& operator=(const FUTMConverter&) = delete;
+	~FUTMConverter();
+
+	/** Zone is 1..60. Returns false if PROJ can't create the transformation */
+	bool Init(int Zone, bool bNorth);
+
+	/** Zone of the point, standard 6-degree zones without the Norway/Svalbard exceptions */
+	static int GetZone(double Lon);
+
+	bool IsValid() const { return Proj != nullptr; }
+
+	/** InLonLatAlt: X - Lon [deg], Y - Lat [deg], Z - Alt [m]. OutUTM: X - Easting [m], Y - Northing [m], Z - Alt [m] */
+	bool LLA2UTM(TArrayView<const FVector> InLonLatAlt, TArrayView<FVector> OutUTM) const;
+	bool UTM2LLA(TArrayView<const FVector> InUTM, TArrayView<FVector> OutLonLatAlt) const;
+
+private:
+	void Reset();
+	bool Transform(TArrayView<const FVector> In, TArrayView<FVector> Out, bool bForward) const;
+
+	PJconsts* Proj = nullptr;
+};
@@ -0,0 +1,69 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "Soda/Misc/PhysBodyKinematic.h"
+#include "Soda/Misc/Time.h"
+#include "HAL/CriticalSection.h"
+
+namespace soda
+{
+
+/**
+ * Vehicle reference point state resampled at an arbitrary time
+ */
+struct FNavSynthState
+{
+	double Time = 0; // [s] since the first pushed substep
+	TTimestamp Timestamp{};
+	int64 FrameIndex = 0;
+	FVector Location = FVector::ZeroVector; // [cm]
+	FVector Velocity = FVector::ZeroVector; // [cm/s]
+	FQuat Rotation = FQuat::Identity;
+};
+
+/**
+ * Buffers the vehicle kinematic of the physics substeps and resamples it with continuous-time splines:
+ * cubic Hermite spline for the location (through the substep locations and velocities) and slerp for the rotation.
+ * Push() is called from the physics thread, sampling is thread safe.
+ */
+class UNREALSODA_API FNavSignalSynthesizer
+{
+public:
+	void Reset(int InCapacity = 64);
+
+	void Push(const TTimestamp& Timestamp, int64 FrameIndex, const FPhysBodyKinematic& VehicleKinematic);
+
+	/** Get the resampled interval [Begin, End], returns false if less than two substeps are buffered */
+	bool GetTimeRange(double& OutBegin, double& OutEnd) const;
+
+	bool Sample(double Time, FNavSynthState& Out) const;
+
+	/**
+	 * Build the kinematic for the interval [T0, T1] compatible with FPhysBodyKinematic::CalcIMU(),
+	 * so the existing nav publishers can be fed with the resampled data
+	 */
+	bool MakeKinematic(double T0, double T1, FPhysBodyKinematic& Out, FNavSynthState& OutState) const;
+
+private:
+	struct FKnot
+	{
+		double Time = 0;
+		int64 FrameIndex = 0;
+		FVector Location;
+		FVector Velocity;
+		FQuat Rotation;
+	};
+
+	bool SampleLocked(double Time, FNavSynthState& Out) const;
+	const FKnot& GetKnot(int Index) const { return Knots[(Head - Num + Index + Knots.Num()) % Knots.Num()]; }
+
+	mutable FCriticalSection Lock;
+	TArray<FKnot> Knots;
+	int Head = 0;
+	int Num = 0;
+	TTimestamp Origin{};
+	FVector CenterOfMassLocal = FVector::ZeroVector;
+};
+
+} // namespace soda
@@ -0,0 +1,101 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UActorComponent;
+
+namespace soda
+{
+
+/**
+ * Philox4x32-10 counter-based RNG (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+ * Every 128-bit counter gives 4 independent uint32 for the 64-bit key, so any sample can be computed directly without
+ * a generator state.
+ */
+struct FPhilox4x32
+{
+	static FORCEINLINE void Generate(uint64 Key, const uint32 (&Counter)[4], uint32 (&Out)[4])
+	{
+		uint32 K0 = uint32(Key);
+		uint32 K1 = uint32(Key >> 32);
+		uint32 C0 = Counter[0], C1 = Counter[1], C2 = Counter[2], C3 = Counter[3];
+		for (int Round = 0; Round < 10; ++Round)
+		{
+			const uint64 P0 = uint64(0xD2511F53) * C0;
+			const uint64 P1 = uint64(0xCD9E8D57) * C2;
+			const uint32 N0 = uint32(P1 >> 32) ^ C1 ^ K0;
+			const uint32 N2 = uint32(P0 >> 32) ^ C3 ^ K1;
+			C1 = uint32(P1);
+			C3 = uint32(P0);
+			C0 = N0;
+			C2 = N2;
+			K0 += 0x9E3779B9;
+			K1 += 0xBB67AE85;
+		}
+		Out[0] = C0; Out[1] = C1; Out[2] = C2; Out[3] = C3;
+	}
+};
+
+/**
+ * Reproducible noise source of one sensor. The sample is fully defined by (key, frame, channel, index), where the key
+ * is derived from the scenario seed (ALevelState::NoiseSeed) and the sensor ID. Therefore the noise doesn't depend on
+ * the order in which sensors are ticked and runs are bit-reproducible in the synchronous mode.
+ */
+class UNREALSODA_API FNoiseStream
+{
+public:
+	FNoiseStream(uint64 InKey = 0) : Key(InKey) {}
+
+	/** Key for the Sensor: scenario seed + vehicle name + component name */
+	static uint64 MakeKey(const UActorComponent* Sensor);
+	static uint64 MakeKey(uint32 Seed, uint32 SensorId);
+
+	/** Fill Out[0..Num) with N(0, StdDev) samples [Index, Index + Num) of the Frame and Channel */
+	void Gaussian(uint64 Frame, uint32 Channel, uint32 Index, float* Out, int Num, float StdDev = 1.f) const;
+
+	/** Fill Out[0..Num) with U(0, 1) samples [Index, Index + Num) of the Frame and Channel */
+	void Uniform(uint64 Frame, uint32 Channel, uint32 Index, float* Out, int Num) const;
+
+	uint64 GetKey() const { return Key; }
+
+private:
+	uint64 Key;
+};
+
+/**
+ * First-order Gauss-Markov process z[k+1] = F * z[k] + Scale * w[k]
+ */
+struct FGaussMarkov
+{
+	float F = 0;
+	float Scale = 0;
+	float Z = 0;
+
+	/** TimeConstant and DeltaTime [s] */
+	void Init(float TimeConstant, float DeltaTime, float StdDev)
+	{
+		F = FMath::Exp(-DeltaTime / TimeConstant);
+		Scale = StdDev * FMath::Sqrt(DeltaTime);
+		Z = 0;
+	}
+
+	float Step(float White)
+	{
+		Z = F * Z + Scale * White;
+		return Z;
+	}
+
+	/** Advance the process Num times. InOut holds N(0, 1) white noise on input and the process on output */
+	void Step(float* InOut, int Num)
+	{
+		for (int i = 0; i < Num; ++i)
+		{
+			Z = F * Z + Scale * InOut[i];
+			InOut[i] = Z;
+		}
+	}
+};
+
+} // namespace soda
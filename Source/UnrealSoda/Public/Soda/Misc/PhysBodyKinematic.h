@@ -15,6 +15,11 @@ struct UNREALSODA_API FPhysBodyKinematic
 		FTransform GlobalPose;								// Center of rear axis [cm]
 		FVector CenterOfMassLocal = FVector(0.f);			// Offset from rear axis [cm]
 
+		friend FArchive& operator<<(FArchive& Ar, FState& State)
+		{
+			return Ar << State.GlobalVelocityOfCenterMass << State.GlobalAcceleration << State.AngularVelocity << State.GlobalPose << State.CenterOfMassLocal;
+		}
+
 		inline FVector GetGlobalVelocityAtLocalPoint(const FVector& Point) const
 		{
 			return GlobalVelocityOfCenterMass + GlobalPose.Rotator().RotateVector((AngularVelocity ^ (Point - CenterOfMassLocal)));
@@ -139,6 +144,11 @@ public:
 
 	FState Curr, Prev;
 	float Deltatime = 1.f;
+
+	friend FArchive& operator<<(FArchive& Ar, FPhysBodyKinematic& Kinematic)
+	{
+		return Ar << Kinematic.Curr << Kinematic.Prev << Kinematic.Deltatime;
+	}
 };
 
 struct UNREALSODA_API FPhysBodyKinematicLerpEstm : public FPhysBodyKinematic
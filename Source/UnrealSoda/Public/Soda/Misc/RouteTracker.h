@@ -0,0 +1,73 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/RingBuffer.h"
+
+class USplineComponent;
+
+/**
+ * FRouteTracker
+ * Route resampled by the arc length with the fixed Step, so the point at any distance along the route is found in O(1).
+ * The samples are kept in the ring buffer: the passed samples are popped from the front, new routes are appended to the back.
+ * The closest point to the vehicle is tracked incrementally from the previous one by Track().
+ * All "Ahead" distances [cm] are counted along the route from the tracked point.
+ */
+class UNREALSODA_API FRouteTracker
+{
+public:
+	explicit FRouteTracker(float InStep = 50.f);
+
+	void Reset();
+
+	/** Append the point, the straight segment from the previous point is resampled */
+	void AddPoint(const FVector& Point);
+
+	/** Append the spline from the StartDistance [cm] to its end */
+	void AddSpline(const USplineComponent* Spline, float StartDistance = 0);
+
+	/** Find the closest point to the Location starting from the previously tracked one and pop the passed samples */
+	void Track(const FVector& Location);
+
+	/** The route has less than two samples, there is nothing to follow */
+	bool IsEmpty() const { return Samples.Num() < 2; }
+
+	float GetStep() const { return Step; }
+
+	/** [cm] from the tracked point to the last sample */
+	float GetDistanceToEnd() const { return IsEmpty() ? 0.f : FMath::Max((Samples.Num() - 1) * Step - TrackedOffset, 0.f); }
+
+	FVector GetLocationAhead(float Ahead) const;
+
+	/** Unit direction of the route */
+	FVector GetDirectionAhead(float Ahead) const;
+
+	/** Turn angle [rad] of the route at the sample nearest to the Ahead distance, in the horizontal plane */
+	float GetTurnAngleAhead(float Ahead) const;
+
+	/** Sample access for the iteration; index 0 is the first sample ahead of the tracked point */
+	int32 GetNumAhead() const { return IsEmpty() ? 0 : Samples.Num() - 1 - GetTrackedIndex(); }
+	const FVector& GetSampleAhead(int32 Index) const { return Samples[GetTrackedIndex() + 1 + Index]; }
+
+	const FVector& GetLastPoint() const { return Samples.Last(); }
+
+private:
+	int32 GetTrackedIndex() const { return FMath::Clamp(int32(TrackedOffset / Step), 0, FMath::Max(Samples.Num() - 2, 0)); }
+
+	/** Returns the index of the segment and the alpha on it */
+	int32 Locate(float Ahead, float& OutAlpha) const;
+
+	/** Samples behind the tracked point kept for the direction and the turn angle lookups */
+	static constexpr int32 KeepBehind = 2;
+
+	TRingBuffer<FVector> Samples;
+	float Step;
+
+	/** [cm] of the tracked point from the first sample */
+	float TrackedOffset = 0;
+
+	/** Resampling state: the last added point and the distance from it to the next sample */
+	FVector LastPoint = FVector::ZeroVector;
+	float Carry = 0;
+};
@@ -0,0 +1,193 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Templates/Function.h"
+#include "Soda/Misc/Time.h"
+
+class FRunnableThread;
+class FEvent;
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+struct FSensorDataHeader;
+
+namespace soda
+{
+
+/** Payload type of the sensor record stream, matches the UGeneric*Publisher the stream was recorded from */
+enum class ESensorRecordPayload : uint8
+{
+	Camera,
+	Lidar,
+	Nav,
+	Racing,
+	Radar,
+	Ultrasonic,
+	V2X,
+	WheeledVehicle,
+};
+
+UNREALSODA_API const TCHAR* ToString(ESensorRecordPayload Payload);
+
+/**
+ * Sensor record file layout:
+ *   FSensorRecordFileHeader
+ *   { FSensorRecordHeader, Payload[FSensorRecordHeader::Size] } ...
+ * The stream is declared by the ESensorRecordKind::Stream record (the payload is the UTF-8 stream name) before its
+ * first frame. All numbers are little-endian; the frame payloads are serialized by FArchive.
+ */
+struct FSensorRecordFileHeader
+{
+	static constexpr uint32 MagicValue = 0x43455253; // "SREC"
+	static constexpr uint32 VersionValue = 2;
+
+	uint32 Magic = MagicValue;
+	uint32 Version = VersionValue;
+};
+
+enum class ESensorRecordKind : uint8
+{
+	Stream,
+	Frame,
+};
+
+struct FSensorRecordHeader
+{
+	/** Payload size [bytes] */
+	uint32 Size = 0;
+	uint16 StreamId = 0;
+	ESensorRecordKind Kind = ESensorRecordKind::Frame;
+	ESensorRecordPayload Payload = ESensorRecordPayload::Camera;
+
+	/** FSensorDataHeader::Timestamp [ns] */
+	int64 Timestamp = 0;
+
+	/** FSensorDataHeader::FrameIndex */
+	int64 FrameIndex = 0;
+
+	/** DeltaTime of the Publish() call [s] */
+	float DeltaTime = 0;
+	uint32 Reserved = 0;
+};
+static_assert(sizeof(FSensorRecordHeader) == 32, "FSensorRecordHeader must be packed");
+
+/**
+ * Async chunked writer of the sensor record file.
+ * Write() serializes the frame straight into the current in-memory chunk, so the publisher pays only for the memcpy.
+ * The filled chunks are handed over to the worker thread that appends them to the file by large sequential writes,
+ * the written chunks are returned to the pool and reused. If the disk can't keep up and MaxPendingChunks are queued,
+ * the frames are dropped and counted instead of stalling the simulation.
+ * One writer is shared by all recording publishers with the same file name, see GetShared().
+ */
+class UNREALSODA_API FSensorRecordWriter : public FRunnable
+{
+public:
+	FSensorRecordWriter(int32 InChunkSize = 16 * 1024 * 1024, int32 InMaxPendingChunks = 8);
+	virtual ~FSensorRecordWriter();
+
+	/** Writer for the FileName shared by all callers; the file is closed when the last reference is released */
+	static TSharedPtr<FSensorRecordWriter> GetShared(const FString& FileName, int32 ChunkSizeMB = 16);
+
+	bool Open(const FString& FileName);
+	void Close();
+	bool IsOpen() const { return Thread != nullptr; }
+	const FString& GetFileName() const { return FileName; }
+
+	/** Declare the stream; the same name and payload always get the same id, so the reactivated publishers continue their streams */
+	int32 AddStream(const FString& Name, ESensorRecordPayload Payload);
+
+	/** Thread safe. The Serializer writes the frame payload to the archive */
+	bool Write(int32 StreamId, ESensorRecordPayload Payload, const FSensorDataHeader& Header, float DeltaTime, TFunctionRef<void(FArchive&)> Serializer);
+
+	int64 GetWrittenBytes() const { return WrittenBytes; }
+	int64 GetRecordedFrames() const { return RecordedFrames; }
+	int64 GetDroppedFrames() const { return DroppedFrames; }
+
+	// FRunnable implementation Begin
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	// FRunnable implementation End
+
+protected:
+	/** Lock must be held */
+	void AppendRecord(const FSensorRecordHeader& RecordHeader, TFunctionRef<void(FArchive&)> Serializer);
+
+	/** Lock must be held; returns false if the queue is full */
+	bool RotateChunk();
+
+	/** Lock must be held; the next current chunk is taken from the pool */
+	void TakeFreeChunk();
+
+	const int32 ChunkSize;
+	const int32 MaxPendingChunks;
+	FString FileName;
+
+	/** Used by the worker only */
+	IFileHandle* File = nullptr;
+
+	FCriticalSection Lock;
+	TArray<uint8> Chunk;
+	TArray<TArray<uint8>> PendingChunks;
+	TArray<TArray<uint8>> FreeChunks;
+	TMap<FString, int32> Streams;
+
+	TAtomic<int64> WrittenBytes{ 0 };
+	TAtomic<int64> RecordedFrames{ 0 };
+	TAtomic<int64> DroppedFrames{ 0 };
+
+	FRunnableThread* Thread = nullptr;
+	FEvent* WakeUpEvent = nullptr;
+	TAtomic<bool> bStopping{ false };
+};
+
+/**
+ * Reader of the sensor record file. The file is memory mapped, the frames point straight to the mapped payloads.
+ * The record truncated by the crash of the simulator is read up to the last complete record.
+ */
+class UNREALSODA_API FSensorRecordReader
+{
+public:
+	struct FStream
+	{
+		FString Name;
+		ESensorRecordPayload Payload = ESensorRecordPayload::Camera;
+	};
+
+	struct FFrame
+	{
+		int32 StreamId = 0;
+		TTimestamp Timestamp{};
+		int64 FrameIndex = 0;
+		float DeltaTime = 0;
+		const uint8* Data = nullptr;
+		uint32 Size = 0;
+	};
+
+	~FSensorRecordReader() { Close(); }
+
+	bool Open(const FString& FileName);
+	void Close();
+	bool IsOpen() const { return !!MappedRegion; }
+
+	const TArray<FStream>& GetStreams() const { return Streams; }
+
+	/** All frames sorted by the timestamp */
+	const TArray<FFrame>& GetFrames() const { return Frames; }
+
+	/** [s] */
+	double GetDuration() const;
+
+	/** Index of the first frame with the timestamp >= StartTimestamp + Seconds */
+	int32 FindFrame(double Seconds) const;
+
+protected:
+	IMappedFileHandle* MappedFile = nullptr;
+	IMappedFileRegion* MappedRegion = nullptr;
+	TArray<FStream> Streams;
+	TArray<FFrame> Frames;
+};
+
+} // namespace soda
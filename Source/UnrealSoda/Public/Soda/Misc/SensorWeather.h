@@ -0,0 +1,60 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Soda/Misc/NoiseEngine.h"
+
+namespace soda
+{
+
+struct FLidarSensorData;
+
+/**
+ * Weather parameters seen by the sensors. The extinction models are empirical fits from the free-space optics and
+ * the automotive radar literature; they give the right order of magnitude, not the exact value for a particular device.
+ */
+struct UNREALSODA_API FSensorWeather
+{
+	float RainRate = 0; // [mm/h]
+	float SnowRate = 0; // [mm/h] of the melted water
+	float FogVisibility = 0; // Meteorological visibility [m], 0 - no fog
+
+	bool IsClear() const { return RainRate <= 0 && SnowRate <= 0 && FogVisibility <= 0; }
+
+	/** Total extinction coefficient of the fog, rain and snow for the WavelengthNm [1/m] */
+	float GetOpticalExtinction(float WavelengthNm) const;
+
+	/** Extinction coefficient of the rain and snow only [1/m]; the precipitation particles make the backscatter false points */
+	float GetPrecipitationExtinction(float WavelengthNm) const;
+
+	/** One-way specific attenuation of the 77 GHz radar by the rain and snow [dB/km] */
+	float GetRadarAttenuation() const;
+};
+
+/** Lidar degradation of the one scan, built on the game thread from the sensor settings and the weather snapshot */
+struct FLidarWeatherDegradation
+{
+	float Extinction = 0; // [1/m]
+	float BackscatterProbability = 0; // Per beam
+	float BackscatterRange = 0; // Mean range of the backscatter false points [cm]
+	float DetectionThreshold = 0; // Returned energy fraction [0..1]
+	FNoiseStream Noise;
+
+	bool IsEnabled() const { return Extinction > 0; }
+};
+
+/**
+ * Apply the weather to the existing scan: two-way extinction of the intensity (or of the unit reflectance if the scan
+ * has no intensity), drop of the echoes below the detection threshold and the backscatter false points in front of
+ * the first echo. Rays are the sensor rays of the beams in the sensor frame.
+ */
+UNREALSODA_API void DegradeLidarScan(const FLidarWeatherDegradation& Degradation, uint64 Frame, const TArray<FVector>& Rays, FLidarSensorData& Scan);
+
+/**
+ * Koschmieder contrast loss: Pixel = Pixel * Transmission + Airlight * (1 - Transmission).
+ * Pixels are BGRA8, alpha isn't changed.
+ */
+UNREALSODA_API void DegradeCameraImage(float Transmission, const FColor& Airlight, TArrayView<FColor> Pixels);
+
+} // namespace soda
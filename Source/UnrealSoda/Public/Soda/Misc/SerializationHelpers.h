@@ -10,8 +10,91 @@
 #include "Soda/UnrealSoda.h"
 #include "Engine/World.h"
 #include "Engine/Level.h"
+#include "Misc/PackageName.h"
 #include "SerializationHelpers.generated.h"
 
+//TODO: See to FConcertSyncObjectWriter and FConcertSyncObjectReader
+
+/**
+ * Proxy archive of the SaveGame properties, used by the records and by the soda::FPropertyLayout
+ */
+struct UNREALSODA_API FSaveExtensionArchive : public FObjectAndNameAsStringProxyArchive 
+{
+	FSaveExtensionArchive(FArchive &InInnerArchive, bool bInLoadIfFindFails) : FObjectAndNameAsStringProxyArchive(InInnerArchive, bInLoadIfFindFails) 
+	{
+		ArIsSaveGame = true;
+    	ArNoDelta = true;
+	}
+
+	virtual FArchive &operator<<(struct FSoftObjectPtr &Value) override
+	{
+		*this << Value.GetUniqueID();
+		return *this;
+	}
+
+	virtual FArchive &operator<<(struct FSoftObjectPath &Value) override
+	{
+		FString Path = Value.ToString();
+		*this << Path;
+		if (IsLoading())
+		{
+			Value.SetPath(MoveTemp(Path));
+		}
+		return *this;
+	}
+	
+	virtual FArchive& operator<<(UObject*& Obj) override
+	{
+		FProperty* SerializingProperty = GetSerializedProperty();
+		const bool bHasInstancedValue = SerializingProperty && SerializingProperty->HasAnyPropertyFlags(CPF_PersistentInstance);
+
+		if (IsSaveGame() && bHasInstancedValue)
+		{
+			if (IsLoading())
+			{
+				UObject* Outer = SerializingProperty->GetOwnerUObject();
+				if (!Outer)
+				{
+					Outer = GetTransientPackage();
+				}
+
+				//FObjectProperty* ObjectProperty = CastField<FObjectProperty>(SerializingProperty);
+				//UClass* PropertyClass = ObjectProperty->PropertyClass;
+
+				// load the path name to the object
+				FString ClassString;
+				InnerArchive << ClassString;
+
+				if (!ClassString.IsEmpty())
+				{
+					UClass* FoundClass = FPackageName::IsShortPackageName(ClassString) ? FindFirstObject<UClass>(*ClassString) : UClass::TryFindTypeSlow<UClass>(ClassString);
+					if (FoundClass)
+					{
+						Obj = StaticAllocateObject(FoundClass, Outer, NAME_None, EObjectFlags::RF_NoFlags, EInternalObjectFlags::None, false);
+						(*FoundClass->ClassConstructor)(FObjectInitializer(Obj, FoundClass, EObjectInitializerOptions::None));
+						Obj->Serialize(*this);
+					}
+				}
+			}
+			else if (Obj)
+			{
+				// save out the fully qualified object name
+				FString ClassString(Obj->GetClass()->GetPathName());
+				InnerArchive << ClassString;
+				Obj->Serialize(*this);
+			}
+			else
+			{
+				// for null pointer, output empty string
+				FString ClassString;
+				InnerArchive << ClassString;
+			}
+		}
+		return *this;
+	}
+	
+};
+
 USTRUCT()
 struct UNREALSODA_API FBaseRecord
 {
@@ -170,3 +253,13 @@ public:
 
 	FActorRecord ActorRecord;
 };
+
+namespace soda
+{
+	/**
+	 * Save or load the named blocks of the binary snapshot (see ALevelState::TakeSnapshot()).
+	 * Every block is prefixed by its name and size, so on loading the blocks are matched by the name and
+	 * the blocks without a match are skipped without breaking the rest of the snapshot.
+	 */
+	UNREALSODA_API void SerializeSnapshotBlocks(FArchive& Ar, TArrayView<const FString> Names, TFunctionRef<void(int32 Index, FArchive& BlockAr)> Serializer);
+}
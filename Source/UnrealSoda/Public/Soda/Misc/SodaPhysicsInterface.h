@@ -11,6 +11,13 @@ struct FSodaPhysicsInterface
 	static UNREALSODA_API bool RaycastSingleScope(const UWorld* World, TArray<struct FHitResult>& OutHit, const TArray<FVector>& Start, const TArray<FVector>& End, ECollisionChannel TraceChannel, const struct FCollisionQueryParams& Params, const struct FCollisionResponseParams& ResponseParams, const struct FCollisionObjectQueryParams& ObjectParams = FCollisionObjectQueryParams::DefaultObjectQueryParam);
 	static UNREALSODA_API bool RaycastMultiScope(const UWorld* World, TArray<TArray<struct FHitResult>>& OutHits, const TArray<FVector>& Start, const TArray<FVector>& End, ECollisionChannel TraceChannel, const struct FCollisionQueryParams& Params, const struct FCollisionResponseParams& ResponseParams, const struct FCollisionObjectQueryParams& ObjectParams = FCollisionObjectQueryParams::DefaultObjectQueryParam);
 
+	/**
+	 * Multi-hit raycast to the flat buffers: the hits of the ray i are OutHits[i * MaxHitsPerRay + k], k < OutHitsNum[i],
+	 * in the order of the distance. Only the MaxHitsPerRay nearest hits are kept. The buffers are reused, so the repeated
+	 * queries of the same size don't allocate.
+	 */
+	static UNREALSODA_API bool RaycastMultiScope(const UWorld* World, TArray<struct FHitResult>& OutHits, TArray<int32>& OutHitsNum, int32 MaxHitsPerRay, const TArray<FVector>& Start, const TArray<FVector>& End, ECollisionChannel TraceChannel, const struct FCollisionQueryParams& Params, const struct FCollisionResponseParams& ResponseParams, const struct FCollisionObjectQueryParams& ObjectParams = FCollisionObjectQueryParams::DefaultObjectQueryParam);
+
 	static UNREALSODA_API bool GeomSweepSingleScope(const UWorld* World, const struct FCollisionShape& CollisionShape, const FQuat& Rot, TArray<struct FHitResult>& OutHits, const TArray<FVector>& Start, const TArray<FVector>& End, ECollisionChannel TraceChannel, const struct FCollisionQueryParams& Params, const struct FCollisionResponseParams& ResponseParams, const struct FCollisionObjectQueryParams& ObjectParams = FCollisionObjectQueryParams::DefaultObjectQueryParam);
 	static UNREALSODA_API bool GeomSweepMultiScope(const UWorld* World, const FPhysicsGeometryCollection& InGeom, const FQuat& InGeomRot, TArray<TArray<struct FHitResult>>& OutHits, const TArray<FVector>& Start, const TArray<FVector>& End, ECollisionChannel TraceChannel, const FCollisionQueryParams& Params, const FCollisionResponseParams& ResponseParams, const FCollisionObjectQueryParams& ObjectParams = FCollisionObjectQueryParams::DefaultObjectQueryParam);
 	static UNREALSODA_API bool GeomSweepMultiScope(const UWorld* World, const FCollisionShape& InGeom, const FQuat& InGeomRot, TArray<TArray<struct FHitResult>>& OutHits, const TArray<FVector>& Start, const TArray<FVector>& End, ECollisionChannel TraceChannel, const FCollisionQueryParams& Params, const FCollisionResponseParams& ResponseParams, const FCollisionObjectQueryParams& ObjectParams = FCollisionObjectQueryParams::DefaultObjectQueryParam);
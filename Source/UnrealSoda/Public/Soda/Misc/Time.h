@@ -40,6 +40,11 @@ namespace soda
 		return Clock::now();
 	}
 
+	inline TTimestamp AddSeconds(const TTimestamp& Timestamp, double Seconds)
+	{
+		return Timestamp + std::chrono::duration_cast<TTimestamp::duration>(std::chrono::duration<double>(Seconds));
+	}
+
 	inline FString ToString(int64 Value)
 	{
 		return std::to_string(Value).c_str();
@@ -52,6 +57,17 @@ namespace soda
 	}
 }
 
+inline FArchive& operator<<(FArchive& Ar, TTimestamp& Timestamp)
+{
+	int64 Raw = soda::RawTimestamp<std::chrono::nanoseconds>(Timestamp);
+	Ar << Raw;
+	if (Ar.IsLoading())
+	{
+		Timestamp = soda::ChronoTimestamp(Raw);
+	}
+	return Ar;
+}
+
 USTRUCT(BlueprintType)
 struct UNREALSODA_API FTimestamp
 {
@@ -8,6 +8,94 @@
 namespace xcp
 {
 
+enum SlaveToMasterPID: uint8
+{
+	SERV = 0xFC,
+	EV = 0xFD,
+	ERR = 0xFE,
+    RES = 0xFF,
+};
+
+enum MasterToSlavePID : uint8
+{
+    //Standard Commands:
+    CONNECT = 0xFF,
+    DISCONNECT = 0xFE,
+    GET_STATUS = 0xFD,
+    SYNCH = 0xFC,
+    GET_COMM_MODE_INFO = 0xFB,
+    GET_ID = 0xFA,
+    SET_REQUEST = 0xF9,
+    GET_SEED = 0xF8,
+    UNLOCK = 0xF7,
+    SET_MTA = 0xF6,
+    UPLOAD = 0xF5,
+    SHORT_UPLOAD = 0xF4,
+    BUILD_CHECKSUM = 0xF3,
+    TRANSPORT_LAYER_CMD = 0xF2,
+    USER_CMD = 0xF1,
+
+    //Calibration commands:
+	DOWNLOAD = 0xF0,
+	DOWNLOAD_NEXT = 0xEF,
+	DOWNLOAD_MAX = 0xEE,
+	SHORT_DOWNLOAD = 0xED,
+	MODIFY_BITS = 0xEC,
+
+    //Page switching commands:
+
+    //Basic data acquisition and stimulation commands:
+    SET_DAQ_PTR = 0xE2,
+    WRITE_DAQ = 0xE1,
+    SET_DAQ_LIST_MODE = 0xE0,
+    START_STOP_DAQ_LIST = 0xDE,
+    START_STOP_SYNCH = 0xDD,
+    WRITE_DAQ_MULTIPLE = 0xC7,
+    READ_DAQ = 0xDB,
+    GET_DAQ_CLOCK = 0xDC,
+    GET_DAQ_PROCESSOR_INFO = 0xDA,
+    GET_DAQ_RESOLUTION_INFO = 0xD9,
+    GET_DAQ_LIST_MODE = 0xDF,
+    GET_DAQ_EVENT_INFO = 0xD7,
+    DTO_CTR_PROPERTIES = 0xC5,
+
+    //Static data acquisition and stim commands:
+    CLEAR_DAQ_LIST = 0xE3,
+    GET_DAQ_LIST_INFO = 0xD8,
+
+    //Dynamic data acquisition and stim commands:
+    FREE_DAQ = 0xD6,
+    ALLOC_DAQ = 0xD5,
+    ALLOC_ODT = 0xD4,
+    ALLOC_ODT_ENTRY = 0xD3,
+
+    //Non-volatile memory programming commands:
+
+    //Time sync commands:
+};
+
+enum ErrorCode : uint8
+{
+	ERR_CMD_SYNCH = 0x00,
+	ERR_CMD_BUSY = 0x10,
+	ERR_DAQ_ACTIVE = 0x11,
+	ERR_PGM_ACTIVE = 0x12,
+	ERR_CMD_UNKNOWN = 0x20,
+	ERR_CMD_SYNTAX = 0x21,
+	ERR_OUT_OF_RANGE = 0x22,
+	ERR_WRITE_PROTECTED = 0x23,
+	ERR_ACCESS_DENIED = 0x24,
+	ERR_ACCESS_LOCKED = 0x25,
+	ERR_PAGE_NOT_VALID = 0x26,
+	ERR_MODE_NOT_VALID = 0x27,
+	ERR_SEGMENT_NOT_VALID = 0x28,
+	ERR_SEQUENCE = 0x29,
+	ERR_DAQ_CONFIG = 0x2A,
+	ERR_MEMORY_OVERFLOW = 0x30,
+	ERR_GENERIC = 0x31,
+	ERR_VERIFY = 0x32,
+};
+
 /**
  * Common XCP packet. 
  * Support only 8 byte data length.
@@ -0,0 +1,350 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "Soda/Misc/XCP.h"
+#include "Soda/Misc/AsyncTaskManager.h"
+#include "Soda/Misc/Time.h"
+#include "Common/UdpSocketReceiver.h"
+#include <atomic>
+
+class FSocket;
+class FInternetAddr;
+
+namespace xcp
+{
+
+/**
+ * Bounded lock-free MPMC queue (D. Vyukov). Elements are filled and consumed in place, so no copies and no allocations
+ * after Init().
+ */
+template <typename T>
+class TBoundedQueue
+{
+public:
+	/** Capacity must be power of two */
+	void Init(int Capacity)
+	{
+		check(FMath::IsPowerOfTwo(Capacity));
+		Cells = MakeUnique<FCell[]>(Capacity);
+		Mask = Capacity - 1;
+		for (int i = 0; i < Capacity; ++i)
+		{
+			Cells[i].Sequence.store(i, std::memory_order_relaxed);
+		}
+		Head.store(0, std::memory_order_relaxed);
+		Tail.store(0, std::memory_order_relaxed);
+	}
+
+	/** Returns false if the queue is full */
+	template <typename FFill>
+	bool Enqueue(FFill&& Fill)
+	{
+		FCell* Cell;
+		uint64 Pos = Tail.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell = &Cells[Pos & Mask];
+			const int64 Diff = int64(Cell->Sequence.load(std::memory_order_acquire)) - int64(Pos);
+			if (Diff == 0)
+			{
+				if (Tail.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed)) break;
+			}
+			else if (Diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				Pos = Tail.load(std::memory_order_relaxed);
+			}
+		}
+		Fill(Cell->Value);
+		Cell->Sequence.store(Pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** Returns false if the queue is empty */
+	template <typename FConsume>
+	bool Dequeue(FConsume&& Consume)
+	{
+		FCell* Cell;
+		uint64 Pos = Head.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell = &Cells[Pos & Mask];
+			const int64 Diff = int64(Cell->Sequence.load(std::memory_order_acquire)) - int64(Pos + 1);
+			if (Diff == 0)
+			{
+				if (Head.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed)) break;
+			}
+			else if (Diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				Pos = Head.load(std::memory_order_relaxed);
+			}
+		}
+		Consume(Cell->Value);
+		Cell->Sequence.store(Pos + Mask + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	struct FCell
+	{
+		std::atomic<uint64> Sequence;
+		T Value;
+	};
+
+	TUniquePtr<FCell[]> Cells;
+	uint64 Mask = 0;
+	std::atomic<uint64> Head{ 0 };
+	std::atomic<uint64> Tail{ 0 };
+};
+
+/**
+ * A2L data types of the symbols
+ */
+enum class EDataType : uint8
+{
+	UByte,
+	SByte,
+	UWord,
+	SWord,
+	ULong,
+	SLong,
+	UInt64,
+	Int64,
+	Float32,
+	Float64,
+};
+
+struct FSymbol
+{
+	FString Name;
+	uint32 Address = 0;
+	EDataType Type = EDataType::UByte;
+	uint8 Size = 1;
+	uint8* Ptr = nullptr;
+	bool bWritable = false;
+};
+
+/**
+ * Maps raw memory of the simulator (UPROPERTYs) to the flat XCP address space.
+ * The table must be changed only by FSlave::ResetSymbolTable() while the slave is started.
+ */
+class UNREALSODA_API FSymbolTable
+{
+public:
+	static constexpr uint32 BaseAddress = 0x10000;
+
+	bool AddSymbol(const FString& Name, void* Ptr, EDataType Type, bool bWritable);
+
+	/** Add all scalar numeric UPROPERTYs of the Object and of its struct members. Returns number of added symbols */
+	int AddObjectProperties(UObject* Object, const FString& Prefix);
+
+	/** Returns pointer if [Address, Address + Size) lies in one symbol */
+	uint8* Resolve(uint32 Address, uint8 Size, bool bForWrite = false) const;
+
+	/** Read memory, bytes outside of symbols are zero */
+	void Read(uint32 Address, uint8* Out, int Size) const;
+
+	/** Write minimal ASAM MCD-2 MC description with MEASUREMENT for every symbol */
+	bool ExportA2L(const FString& FileName, const FString& ModuleName) const;
+
+	const TArray<FSymbol>& GetSymbols() const { return Symbols; }
+	void Reset();
+
+private:
+	void AddStructProperties(const UStruct* Struct, void* Container, const FString& Prefix, int Depth, int& Added);
+	const FSymbol* Find(uint32 Address) const;
+
+	TArray<FSymbol> Symbols;
+	uint32 NextAddress = BaseAddress;
+};
+
+/**
+ * XCP-on-Ethernet (UDP) slave with dynamic DAQ lists.
+ *
+ * Commands are processed on the UDP receiver thread. DAQ configuration is compiled to an immutable snapshot on every
+ * start/stop, Event() samples the snapshot without locks or allocations and pushes DTO packets to a bounded queue,
+ * which is drained by the EthTaskManager worker.
+ */
+class UNREALSODA_API FSlave
+{
+public:
+	static constexpr int MaxCto = 8;
+	static constexpr int MaxDto = 1400;
+	static constexpr int DtoQueueSize = 1024;
+
+	FSlave();
+	~FSlave();
+
+	/** Add event channel. Must be called before Start(). TimeUnit is XCP unit: 3 - 1us, 6 - 1ms; TimeCycle 0 - not cyclic */
+	uint16 AddEvent(const FString& Name, uint8 TimeCycle = 0, uint8 TimeUnit = 6);
+
+	/** The table can be filled directly only before Start(), see ResetSymbolTable() */
+	FSymbolTable& GetSymbolTable() { return SymbolTable; }
+	const FSymbolTable& GetSymbolTable() const { return SymbolTable; }
+
+	/**
+	 * Refill the symbol table of the started slave. All DAQ lists are freed and the pending DOWNLOAD writes are dropped,
+	 * because they point to the old memory; the master has to configure DAQ again.
+	 * Must not be called concurrently with Event() and ApplyPendingWrites().
+	 */
+	void ResetSymbolTable(TFunctionRef<void(FSymbolTable& SymbolTable)> Fill);
+
+	void SetId(const FString& InId) { Id = InId; }
+
+	/** Start UDP transport. Port < 0 starts the slave without transport, for the local master only */
+	bool Start(int Port, soda::FAsyncTaskManager& TaskManager);
+	void Stop();
+
+	/**
+	 * Sample all running DAQ lists of the EventChannel. Lock- and allocation-free.
+	 * The same channel must not be triggered from different threads at the same time.
+	 */
+	void Event(uint16 EventChannel, const TTimestamp& Timestamp);
+
+	/** Apply calibration values received by DOWNLOAD. Should be called from the thread which owns the calibrated data */
+	void ApplyPendingWrites();
+
+	/** Process one command packet (CTO). Returns response length, 0 if there is no response */
+	int ProcessCommand(const uint8* Cmd, int CmdLen, uint8(&Res)[MaxCto]);
+
+	/** Pop all sampled DTO packets. Used by the transport worker and the local master */
+	int DrainDto(TFunctionRef<void(const uint8* Data, int Len)> Consume);
+
+	bool IsConnected() const { return bConnected; }
+	bool IsDaqRunning() const { return bDaqRunning; }
+	uint64 GetDtoNum() const { return DtoNum.load(std::memory_order_relaxed); }
+	uint64 GetOverrunNum() const { return OverrunNum.load(std::memory_order_relaxed); }
+
+private:
+	struct FOdtEntry
+	{
+		uint32 Address = 0;
+		uint8 Size = 0;
+		uint8* Ptr = nullptr;
+	};
+
+	struct FOdt
+	{
+		TArray<FOdtEntry> Entries;
+	};
+
+	struct FDaqList
+	{
+		TArray<FOdt> Odts;
+		uint8 Mode = 0;
+		uint16 EventChannel = 0;
+		uint8 Prescaler = 1;
+		uint8 Priority = 0;
+		uint8 FirstPid = 0;
+		bool bSelected = false;
+		bool bRunning = false;
+	};
+
+	struct FEventChannel
+	{
+		FString Name;
+		uint8 TimeCycle = 0;
+		uint8 TimeUnit = 6;
+	};
+
+	struct FDaqSnapshot
+	{
+		struct FOdt
+		{
+			uint8 Pid = 0;
+			bool bTimestamp = false;
+			TArray<FOdtEntry> Entries;
+		};
+
+		struct FList
+		{
+			uint8 Prescaler = 1;
+			uint32 PrescalerCounter = 0;
+			TArray<FOdt> Odts;
+		};
+
+		TArray<FList> Lists;
+		TArray<TArray<int>> ListsByEvent;
+	};
+
+	struct FDto
+	{
+		uint16 Len = 0;
+		uint8 Data[MaxDto];
+	};
+
+	struct FWrite
+	{
+		uint8* Ptr = nullptr;
+		uint8 Size = 0;
+		uint8 Data[MaxCto];
+	};
+
+	int Error(uint8 Code, uint8(&Res)[MaxCto]);
+	void ReadMta(uint8 AddressExt, uint32 Address, uint8* Out, int Size) const;
+	void StopAllDaq();
+	void RebuildSnapshot();
+	int GetOdtSize(const FOdt& Odt) const;
+
+	void OnRecv(const FArrayReaderPtr& ArrayReaderPtr, const FIPv4Endpoint& EndPt);
+	void SendFrames(const uint8* Data, int Len);
+
+	friend class FDtoSendAsyncTask;
+
+	FSymbolTable SymbolTable;
+	TArray<FEventChannel> Events;
+	FString Id = TEXT("SodaSim");
+
+	/* Command processing state, guarded by CommandLock */
+	FCriticalSection CommandLock;
+	TArray<FDaqList> DaqLists;
+	uint8 MtaExt = 0;
+	uint32 Mta = 0;
+	TArray<uint8> MtaString;
+	int DaqPtrList = -1;
+	int DaqPtrOdt = -1;
+	int DaqPtrEntry = -1;
+
+	std::atomic<bool> bConnected{ false };
+	std::atomic<bool> bDaqRunning{ false };
+
+	/* Sampling */
+	std::atomic<FDaqSnapshot*> ActiveSnapshot{ nullptr };
+	std::atomic<int> ActiveSamplers{ 0 };
+	TBoundedQueue<FDto> DtoQueue;
+	TBoundedQueue<FWrite> WriteQueue;
+	std::atomic<uint64> DtoNum{ 0 };
+	std::atomic<uint64> OverrunNum{ 0 };
+
+	/* Transport */
+	soda::FAsyncTaskManager* TaskManager = nullptr;
+	FSocket* Socket = nullptr;
+	FUdpSocketReceiver* UDPReceiver = nullptr;
+	TSharedPtr<soda::FAsyncTask> SendTask;
+	FCriticalSection MasterAddrLock;
+	TSharedPtr<FInternetAddr> MasterAddr;
+	std::atomic<uint16> SendCounter{ 0 };
+};
+
+/**
+ * Local master stub transport. Routes FMaster requests directly to the FSlave without network.
+ */
+class UNREALSODA_API FLoopbackTransport : public FBaseTransport
+{
+public:
+	FLoopbackTransport(const TSharedPtr<FSlave>& InSlave) : Slave(InSlave) {}
+	virtual bool Send(const FPacket& Packet) override;
+	virtual bool IsValid() const override { return Slave.IsValid(); }
+
+	TWeakPtr<FSlave> Slave;
+};
+
+} // xcp
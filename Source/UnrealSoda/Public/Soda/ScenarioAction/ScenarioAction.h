@@ -4,6 +4,7 @@
 
 #include "GameFramework/Actor.h"
 #include "Soda/ISodaActor.h"
+#include "Soda/ScenarioAction/ScenarioActionGraph.h"
 #include "ScenarioAction.generated.h"
 
 class USodaSubsystem;
@@ -56,4 +57,5 @@ public:
 
 protected:
 	TSharedPtr<SScenarioActionEditor> ScenarioActionEditor;
+	FScenarioActionGraph Graph;
 };
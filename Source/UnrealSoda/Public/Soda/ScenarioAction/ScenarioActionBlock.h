@@ -66,6 +66,7 @@ public:
 	bool ExecuteBlock();
 	void ExecuteActions();
 	bool ExecuteConditionMatrix();
+	void CompileConditions();
 
 	void SetDisplayName(FName InDisplayName) { DisplayName = InDisplayName; }
 	FName GetDisplayName() const { return DisplayName; }
@@ -22,10 +22,65 @@
 #include "UObject/UnrealType.h"
 #include "Widgets/Views/ITableRow.h"
 #include "Widgets/SNullWidget.h"
+#include <utility>
 #include "ScenarioActionCondition.generated.h"
 
 class FStructOnScope;
 
+/**
+ * FScenarioConditionThunks
+ * Registry of the native thunks of the condition functions. The thunk calls the C++ function directly with the arguments
+ * taken from the parameters struct of the UFunction, so UScenarioActionConditionFunction doesn't need ProcessEvent().
+ * The result of the pure function depends only on its parameters and is computed once per scenario.
+ */
+class UNREALSODA_API FScenarioConditionThunks
+{
+public:
+	struct FThunk
+	{
+		TFunction<bool(uint8* Params)> Call;
+		bool bPure = false;
+	};
+
+	static FScenarioConditionThunks& Get();
+
+	const FThunk* Find(const UFunction* Function) const { return Thunks.Find(Function); }
+
+	template<typename... TArgs>
+	void Register(UClass* Class, FName FunctionName, bool (*Func)(TArgs...), bool bPure)
+	{
+		const UFunction* Function = Class->FindFunctionByName(FunctionName);
+		if (!ensure(Function))
+		{
+			return;
+		}
+
+		TArray<int32> Offsets;
+		for (TFieldIterator<FProperty> It(Function); It && It->HasAnyPropertyFlags(CPF_Parm); ++It)
+		{
+			if (!It->HasAnyPropertyFlags(CPF_ReturnParm))
+			{
+				Offsets.Add(It->GetOffset_ForUFunction());
+			}
+		}
+		if (!ensure(Offsets.Num() == sizeof...(TArgs)))
+		{
+			return;
+		}
+
+		Thunks.Add(Function, FThunk{ [Func, Offsets](uint8* Params) { return Invoke(Func, Params, Offsets, std::index_sequence_for<TArgs...>{}); }, bPure });
+	}
+
+private:
+	template<typename... TArgs, size_t... Indices>
+	static bool Invoke(bool (*Func)(TArgs...), uint8* Params, const TArray<int32>& Offsets, std::index_sequence<Indices...>)
+	{
+		return Func(*reinterpret_cast<std::decay_t<TArgs>*>(Params + Offsets[Indices])...);
+	}
+
+	TMap<const UFunction*, FThunk> Thunks;
+};
+
 /**
  * UScenarioActionCondition
  */
@@ -42,6 +97,9 @@ public:
 	virtual bool Execute() { return false; }
 	virtual TSharedRef< SWidget > MakeWidget() { return SNullWidget::NullWidget; }
 	virtual FText GetDisplayName() const { return DisplayName; }
+
+	/** Prepare the condition for the scenario run, see FScenarioActionGraph */
+	virtual void Compile() {}
 	
 protected:
 	FText DisplayName;
@@ -65,6 +123,7 @@ public:
 public:
 	virtual bool Execute();
 	virtual TSharedRef< SWidget > MakeWidget() override;
+	virtual void Compile() override;
 
 public:
 	void SetFunction(UFunction* Function, UClass * OwnerClass);
@@ -79,4 +138,11 @@ protected:
 
 	UPROPERTY(SaveGame)
 	TSoftClassPtr<UClass> FunctionOwner;
+
+	/** Resolved by Compile() */
+	bool bCompiled = false;
+	UFunction* CompiledFunction = nullptr;
+	UObject* CompiledOwner = nullptr;
+	const FScenarioConditionThunks::FThunk* CompiledThunk = nullptr;
+	TOptional<bool> CachedResult;
 };
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "ScenarioActionConditionFunctionLibrary.generated.h"
 
 class ASodaVehicle;
+class FScenarioConditionThunks;
 
 UCLASS()
 class UNREALSODA_API UScenarioActionConditionFunctionLibraryBase : public UBlueprintFunctionLibrary
@@ -32,6 +33,8 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Test)
 	static bool TestFunction4(const FVector & Param1, const FRotator & Param2);
 
+	/** Register the native thunks of the functions above, see FScenarioConditionThunks */
+	static void RegisterConditionThunks(FScenarioConditionThunks& Thunks);
 
 
 	static bool AtScenarioTime(float Time);
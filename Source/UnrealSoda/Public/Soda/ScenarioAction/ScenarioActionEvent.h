@@ -7,6 +7,7 @@
 #include "ScenarioActionEvent.generated.h"
 
 class SWidget;
+class FScenarioActorSnapshot;
 
 /**
  * UScenarioActionEvent
@@ -28,6 +29,16 @@ public:
 	virtual void ScenarioBegin() {}
 	virtual void ScenarioEnd() {}
 
+	/**
+	 * Compile the event into FScenarioActionGraph: register the actors the event depends on in the Snapshot.
+	 * The compiled event is evaluated by Evaluate() only if the state of one of the dependencies has changed.
+	 * Returns false if the event can't be compiled, such event is ticked every frame.
+	 */
+	virtual bool Compile(FScenarioActorSnapshot& Snapshot, TArray<int32>& OutDependencies) { return false; }
+
+	/** Returns true if the event is triggered */
+	virtual bool Evaluate(const FScenarioActorSnapshot& Snapshot) { return false; }
+
 	FSimpleDelegate EventDelegate;
 	
 protected:
@@ -100,6 +100,8 @@ class UNREALSODA_API UEventOverlapTrigger : public UScenarioActionEvent
 public:
 	UEventOverlapTrigger(const FObjectInitializer& InInitializer);
 	virtual void Tick(float DeltaTime) override;
+	virtual bool Compile(FScenarioActorSnapshot& Snapshot, TArray<int32>& OutDependencies) override;
+	virtual bool Evaluate(const FScenarioActorSnapshot& Snapshot) override;
 
 public:
 	UPROPERTY(EditAnywhere, Category = Event, SaveGame, meta=(ScenarioAction))
@@ -113,6 +115,9 @@ public:
 
 
 	//float Delay;
+
+protected:
+	int32 ActorSlot = INDEX_NONE;
 };
 
 /**
@@ -127,6 +132,8 @@ public:
 	UEventRelativeDistance(const FObjectInitializer& InInitializer);
 	virtual void ScenarioBegin() override;
 	virtual void Tick(float DeltaTime) override;
+	virtual bool Compile(FScenarioActorSnapshot& Snapshot, TArray<int32>& OutDependencies) override;
+	virtual bool Evaluate(const FScenarioActorSnapshot& Snapshot) override;
 
 public:
 	UPROPERTY(EditAnywhere, Category = Event, SaveGame, meta = (ScenarioAction))
@@ -150,8 +157,13 @@ public:
 	//float Delay;
 
 protected:
+	float CalcDistance(const FTransform& FromTransform, const FTransform& ToTransform) const;
+	bool Check(float CurDistance) const;
+
 	FBox FromActorExtent;
 	FBox ToActorExtent;
+	int32 FromSlot = INDEX_NONE;
+	int32 ToSlot = INDEX_NONE;
 };
 
 /**
@@ -165,6 +177,8 @@ class UNREALSODA_API UEventRelativeSpeed : public UScenarioActionEvent
 public:
 	UEventRelativeSpeed(const FObjectInitializer& InInitializer);
 	virtual void Tick(float DeltaTime) override;
+	virtual bool Compile(FScenarioActorSnapshot& Snapshot, TArray<int32>& OutDependencies) override;
+	virtual bool Evaluate(const FScenarioActorSnapshot& Snapshot) override;
 
 public:
 	UPROPERTY(EditAnywhere, Category = Event, SaveGame, meta = (ScenarioAction))
@@ -180,6 +194,12 @@ public:
 	EScenarioEventConditional Conditional;
 
 	//float Delay; 
+
+protected:
+	bool Check(const FTransform& FromTransform, const FVector& FromVelocity, const FVector& ToVelocity) const;
+
+	int32 FromSlot = INDEX_NONE;
+	int32 ToSlot = INDEX_NONE;
 };
 
 /**
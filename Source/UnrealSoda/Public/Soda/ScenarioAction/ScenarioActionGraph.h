@@ -0,0 +1,73 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class UScenarioActionBlock;
+class UScenarioActionEvent;
+
+/**
+ * State of the actor taken once per frame and shared by all compiled events
+ */
+struct FScenarioActorState
+{
+	TWeakObjectPtr<AActor> Actor;
+	FTransform Transform;
+	FVector Velocity = FVector::ZeroVector;
+	FBox Extent{ ForceInit };
+	bool bValid = false;
+
+	/** The state has changed since the previous frame */
+	bool bDirty = true;
+};
+
+/**
+ * FScenarioActorSnapshot
+ */
+class UNREALSODA_API FScenarioActorSnapshot
+{
+public:
+	/** Returns the slot of the Actor, INDEX_NONE if the Actor is null. Every actor has only one slot */
+	int32 AddActor(AActor* Actor, bool bNeedExtent = false);
+
+	void Update();
+	void Reset();
+
+	const FScenarioActorState& operator[](int32 Slot) const { return States[Slot]; }
+	bool IsDirty(int32 Slot) const { return States[Slot].bDirty; }
+
+private:
+	TArray<FScenarioActorState> States;
+	TMap<const AActor*, int32> ActorSlots;
+};
+
+/**
+ * FScenarioActionGraph
+ * Flat evaluation graph of the scenario compiled at the scenario begin. The compiled events are evaluated from the shared
+ * actor snapshot and only if their dependencies have changed, otherwise the previous result is used. The events which
+ * can't be compiled are ticked as before.
+ */
+class UNREALSODA_API FScenarioActionGraph
+{
+public:
+	void Compile(const TArray<UScenarioActionBlock*>& Blocks);
+	void Reset();
+	void Tick(float DeltaTime);
+
+	const FScenarioActorSnapshot& GetSnapshot() const { return Snapshot; }
+
+private:
+	struct FEventNode
+	{
+		UScenarioActionEvent* Event = nullptr;
+		TArray<int32, TInlineAllocator<4>> Dependencies;
+		bool bCompiled = false;
+		bool bEvaluated = false;
+		bool bResult = false;
+	};
+
+	FScenarioActorSnapshot Snapshot;
+	TArray<FEventNode> EventNodes;
+};
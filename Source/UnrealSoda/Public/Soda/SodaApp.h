@@ -41,6 +41,7 @@ public:
 
 public:
 	inline zmq::context_t* GetZmqContext() { return ZmqCtx; }
+	/** Timestamp of the current frame on the USodaSimulationClock timeline */
 	inline TTimestamp GetSimulationTimestamp() const { return SimulationTimestamp; }
 	inline TTimestamp GetRealtimeTimestamp() const { return RealtimeTimestamp; }
 
@@ -110,7 +111,6 @@ protected:
 	int FrameIndex = 0;
 	TTimestamp RealtimeTimestamp;
 	TTimestamp SimulationTimestamp;
-	double TotalTime = 0;
 
 	bool bWaitTick = false;
 
@@ -0,0 +1,123 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Soda/SodaTypes.h"
+#include "SodaBatchRunner.generated.h"
+
+class ASodaVehicle;
+class ULevelSaveGame;
+
+/**
+ * USodaBatchRunner
+ * Headless batch runner of the scenarios, created only if the application is started with -SodaBatch=<BatchFile.json>.
+ * Compatible with -nullrhi; use -benchmark -fps=<N> for the fixed simulation step.
+ *
+ * The batch file:
+ * {
+ *   "Results": "Saved/Batch/Results.csv",   // optional
+ *   "Quit": true,                            // quit after the last run, optional
+ *   "Runs": [
+ *     {
+ *       "Slot": "<level slot GUID or label>",
+ *       "Duration": 60,                      // [s] of the simulation time, the run also ends by the scenario stop trigger
+ *       "Sweep": { "Vehicle/Lidar:RangeNoiseStdDev": ["0", "1"], "Vehicle:bDrawDebugCanvas": ["true"] }
+ *     }
+ *   ]
+ * }
+ * Every run is expanded to the cartesian product of its sweep values. The sweep key is "Actor[/Component]:PropertyPath".
+ * -SodaBatchShard=<I>/<N> runs only every N-th run starting from I, so the batch can be split between processes.
+ *
+ * The runs are executed back-to-back: between the runs of the same level the level state is restored from the slot
+ * without the level reload (like EScenarioStopMode::ResetSodaActorsOnly). KPIs of every run (collisions of the active
+ * vehicle, min TTC, lap time) are appended to the results CSV file.
+ */
+UCLASS()
+class UNREALSODA_API USodaBatchRunner : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static bool IsBatchMode();
+
+	// UTickableWorldSubsystem implementation Begin
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return bBegunPlay; }
+	virtual TStatId GetStatId() const override;
+	// UTickableWorldSubsystem implementation End
+
+protected:
+	enum class EState : uint8
+	{
+		StartNextRun,
+		WaitGarbageCollect,
+		Restore,
+		Running,
+		Finished,
+	};
+
+	struct FRun
+	{
+		/** Index of the run in the expanded batch before the sharding */
+		int32 Index = 0;
+		FGuid Slot;
+		FString SlotLabel;
+		float Duration = 60;
+		TArray<TPair<FString, FString>> Params;
+	};
+
+	struct FBatch
+	{
+		bool bLoaded = false;
+		bool bQuit = true;
+		FString ResultsFile;
+		TArray<FRun> Runs;
+		int32 CurrentRun = -1;
+
+		/** The slot of the current run is loaded by the level reload */
+		bool bSlotPreloaded = false;
+	};
+
+	/** Survives the level reload */
+	static FBatch Batch;
+
+	static bool LoadBatch(const FString& FileName);
+	static bool ResolveSlot(const FString& SlotName, FGuid& OutGuid, FString& OutLabel);
+
+	void StartNextRun();
+	void RestoreLevel();
+	bool ApplyParam(const FString& Key, const FString& Value);
+	void BeginRun();
+	void EndRun(const FString& Reason);
+	void UpdateKPI(float DeltaTime);
+	void WriteResult(const FString& Reason);
+	void OnPostGarbageCollect();
+
+	UFUNCTION()
+	void OnScenarioStop(EScenarioStopReason Reason);
+
+	UFUNCTION()
+	void OnVehicleHit(AActor* SelfActor, AActor* OtherActor, FVector NormalImpulse, const FHitResult& Hit);
+
+	EState State = EState::StartNextRun;
+	bool bBegunPlay = false;
+
+	UPROPERTY()
+	ULevelSaveGame* PendingSaveGame = nullptr;
+
+	TWeakObjectPtr<ASodaVehicle> EgoVehicle;
+	TMap<TWeakObjectPtr<AActor>, float> ActorRadiuses;
+	float EgoRadius = 0;
+
+	/** KPIs of the current run */
+	float SimTime = 0;
+	float LapTime = -1;
+	int32 Collisions = 0;
+	float MinTTC = MAX_FLT;
+	TWeakObjectPtr<AActor> LastHitActor;
+	float LastHitTime = -1;
+};
@@ -0,0 +1,37 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Soda/Misc/SensorWeather.h"
+#include "SodaSensorEnvironment.generated.h"
+
+/**
+ * USodaSensorEnvironment
+ * Environment of the sensors: the current weather set by the AWeatherSystem (or the scenario). The sensors read the
+ * snapshot from the game thread, the render thread or the async tasks; the snapshot is guarded by the sequence lock,
+ * so the readers never block the writer and each other.
+ */
+UCLASS()
+class UNREALSODA_API USodaSensorEnvironment : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Game thread only */
+	void SetWeather(const soda::FSensorWeather& Weather);
+
+	/** Any thread */
+	soda::FSensorWeather GetWeather() const;
+
+	/** Any thread. Incremented every time the weather is changed */
+	uint32 GetWeatherVersion() const { return Sequence.Load() >> 1; }
+
+	/** Weather of the world of the Object; clear if there is no world */
+	static soda::FSensorWeather GetWeather(const UObject* Object);
+
+protected:
+	/** Odd while the snapshot is being written */
+	TAtomic<uint32> Sequence{ 0 };
+	soda::FSensorWeather Snapshot;
+};
@@ -0,0 +1,125 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "SodaSensorScheduler.generated.h"
+
+class USensorComponent;
+
+/**
+ * FSensorSchedule
+ * Capture timing of the sensor driven by the USodaSensorScheduler
+ */
+USTRUCT(BlueprintType)
+struct UNREALSODA_API FSensorSchedule
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Capture on the scheduler triggers instead of every TickDivider frame */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Schedule, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	bool bEnabled = false;
+
+	/** [Hz] The triggers are locked to the whole seconds of the simulation clock (PPS), so the rate is clamped to [1..1000] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Schedule, SaveGame, meta = (EditInRuntime, ReactivateComponent, EditCondition = "bEnabled"))
+	float Rate = 10;
+
+	/** [s] Delay of the first trigger after the PPS; negative - chosen by the scheduler to flatten the frame load */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Schedule, SaveGame, meta = (EditInRuntime, ReactivateComponent, EditCondition = "bEnabled"))
+	float Phase = -1;
+
+	/** [ms] Estimated cost of one capture, used for the load balancing */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Schedule, SaveGame, meta = (EditInRuntime, ReactivateComponent, EditCondition = "bEnabled"))
+	float Cost = 1;
+
+	/** Sensors of the same group are triggered with the same phase, e.g. the camera and the lidar fused together */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Schedule, SaveGame, meta = (EditInRuntime, ReactivateComponent, EditCondition = "bEnabled"))
+	FName SyncGroup;
+};
+
+struct FSensorScheduleStats
+{
+	int64 Captures = 0;
+
+	/** More than one trigger has fallen within one frame, only one capture is done */
+	int64 MissedTriggers = 0;
+
+	/** Frames dropped by the sensor pipeline, see USensorComponent::NotifyFrameDropped() */
+	int64 DroppedFrames = 0;
+
+	/** [ms] Delay of the capture frame after the trigger */
+	float DriftMean = 0;
+	float DriftMax = 0;
+
+	/** [s] Phase used by the scheduler */
+	float Phase = 0;
+};
+
+/**
+ * USodaSensorScheduler
+ * Decides on which frames the scheduled sensors capture. The triggers of every sensor are Phase + k / Rate after each
+ * whole second of the simulation clock, like the sensors synchronized by the GPS PPS. The sensor captures on the first
+ * frame after its trigger; the delay is logged as the drift and the extra triggers within one frame as the missed ones.
+ * The sensors without the fixed phase are spread over the frames of the second by their costs, so the heavy sensors
+ * don't capture on the same frame. The plan is made lazily on the first query of the frame.
+ */
+UCLASS()
+class UNREALSODA_API USodaSensorScheduler : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** [s] Period of the drift and drops report to the log */
+	float ReportPeriod = 10;
+
+	void Register(USensorComponent* Sensor);
+	void Unregister(USensorComponent* Sensor);
+
+	/** Game thread. True if the Sensor has to capture on the current frame; also true for the unregistered sensors */
+	bool IsDue(const USensorComponent* Sensor);
+
+	/** Null if the Sensor isn't registered */
+	const FSensorScheduleStats* GetStats(const USensorComponent* Sensor) const;
+
+	// UWorldSubsystem implementation Begin
+	virtual void Deinitialize() override;
+	// UWorldSubsystem implementation End
+
+protected:
+	struct FEntry
+	{
+		TWeakObjectPtr<USensorComponent> Sensor;
+		FSensorSchedule Setup;
+		int64 Period = 0; // [ns]
+		int64 Phase = 0; // [ns] in [0..Period)
+		int64 TriggersPerSecond = 1;
+		bool bDue = false;
+		FSensorScheduleStats Stats;
+		int64 ReportedMisses = 0;
+		int64 ReportedDrops = 0;
+		int64 DroppedFramesBase = 0;
+	};
+
+	void PlanFrame();
+	void Rebalance();
+	void Report(bool bFinal);
+	FEntry* FindEntry(const USensorComponent* Sensor);
+
+	/** Number of the Entry triggers in the [0, Time] of the simulation clock [ns] */
+	static int64 CountTriggers(const FEntry& Entry, int64 Time);
+
+	/** Last trigger of the Entry in the (-inf, Time] [ns] */
+	static int64 GetLastTrigger(const FEntry& Entry, int64 Time);
+
+	TArray<FEntry> Entries;
+	bool bNeedRebalance = true;
+
+	int PlannedFrame = -1;
+	int64 PrevFrameTime = 0; // [ns]
+	float AverageFrameTime = 1.f / 30; // [s]
+
+	/** Frames per second the load is balanced for */
+	int BinsNum = 0;
+
+	int64 NextReportTime = 0; // [ns]
+};
@@ -0,0 +1,87 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Soda/Misc/Time.h"
+#include "SodaSimulationClock.generated.h"
+
+/**
+ * USodaSimulationClock
+ * Simulated time of the world. The simulated time is advanced by the dilated game frame delta, so all simulation
+ * timestamps are independent of the wall clock and of the render FPS.
+ * The real time factor (RTF) is the target ratio of the simulated time to the wall time:
+ *  - in the asynchronous mode it is applied as the world time dilation (RTF > 1 - faster than real time, RTF < 1 - slow motion);
+ *  - in the synchronous mode the frame delta is fixed, so the RTF only limits the frame rate.
+ * The RTF is 0 by default: no dilation and no pacing, the simulation runs as fast as the frames allow.
+ * If the PhysicsStep is set, the Chaos solver is switched to the async mode with the fixed step: the vehicles are always
+ * simulated with the same step and the solver runs as many steps per frame as the dilated frame delta requires.
+ * The clock is advanced by FSodaApp at the start of every tick of the game world.
+ * Command line: -SodaRTF=<factor> -SodaPhysicsHz=<rate>
+ */
+UCLASS()
+class UNREALSODA_API USodaSimulationClock : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintPure, Category = "Soda|Clock")
+	float GetRealTimeFactor() const { return RealTimeFactor; }
+
+	/** 0 - no pacing and no dilation */
+	UFUNCTION(BlueprintCallable, Category = "Soda|Clock")
+	void SetRealTimeFactor(float InRealTimeFactor);
+
+	/** [s] 0 if the physics step is defined by the project physics settings */
+	UFUNCTION(BlueprintPure, Category = "Soda|Clock")
+	float GetPhysicsStep() const { return PhysicsStep; }
+
+	UFUNCTION(BlueprintCallable, Category = "Soda|Clock")
+	void SetPhysicsStep(float InPhysicsStep);
+
+	/** Simulated seconds per wall second averaged over the last frames */
+	UFUNCTION(BlueprintPure, Category = "Soda|Clock")
+	float GetMeasuredRealTimeFactor() const { return MeasuredRealTimeFactor; }
+
+	double GetSimulatedSeconds() const { return SimulatedSeconds; }
+
+	/** Move the clock to the simulated time, e.g. on the snapshot restore; the epoch is kept */
+	void SetSimulatedSeconds(double InSimulatedSeconds);
+
+	TTimestamp GetEpoch() const { return Epoch; }
+	TTimestamp ToTimestamp(double InSimulatedSeconds) const;
+	TTimestamp GetSimulationTimestamp() const { return ToTimestamp(SimulatedSeconds); }
+
+	/** Advance the clock by the undilated frame delta and pace the frame; returns the simulation timestamp of the frame */
+	TTimestamp AdvanceFrame(float DeltaSeconds);
+
+	/** Restart the simulated time; the synchronous mode counts from the zero epoch, otherwise from the current wall time */
+	void Reset(bool bSynchronousMode);
+
+	// UWorldSubsystem implementation Begin
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	// UWorldSubsystem implementation End
+
+protected:
+	void ApplyRealTimeFactor();
+	void ApplyPhysicsStep();
+
+	float RealTimeFactor = 0;
+	float PhysicsStep = 0;
+	float MeasuredRealTimeFactor = 1;
+
+	/** Project value of the UPhysicsSettings::MaxPhysicsDeltaTime, restored on Deinitialize(); negative if it isn't changed */
+	float SavedMaxPhysicsDeltaTime = -1;
+
+	TTimestamp Epoch{};
+	double SimulatedSeconds = 0;
+
+	/** Wall time [s] of the previous frame */
+	double LastWallSeconds = 0;
+
+	/** Pacing baseline in the synchronous mode */
+	double PacingWallSeconds = 0;
+	double PacingSimulatedSeconds = 0;
+};
@@ -0,0 +1,126 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Soda/Mass/SodaTrafficTypes.h"
+#include "SodaTrafficAwareness.generated.h"
+
+/**
+ * Traffic situation of the watched agent, computed by USodaTrafficAwareness once per frame.
+ * The distances are along the lanes from the bumpers of the agent; -1 if there is nothing within the lookout distance.
+ */
+struct FTrafficAwareness
+{
+	/** The agent is placed on the lane graph; otherwise the rest of the fields aren't valid */
+	bool bOnLane = false;
+	int32 Lane = INDEX_NONE;
+	float Distance = 0; // [cm] along the lane
+
+	/** [cm] from the front bumper to the rear of the leader, the search continues through the lane successor */
+	float LeaderDistance = -1;
+	float LeaderSpeed = 0; // [m/s]
+	TWeakObjectPtr<AActor> Leader;
+
+	/** [cm] from the rear bumper to the front of the follower, only on the same lane */
+	float FollowerDistance = -1;
+	float FollowerSpeed = 0; // [m/s]
+	TWeakObjectPtr<AActor> Follower;
+
+	/** [cm] from the front bumper to the nearest crossing the agent has to yield at */
+	float ConflictDistance = -1;
+	TWeakObjectPtr<AActor> ConflictActor;
+
+	/** Min of the LeaderDistance and ConflictDistance, -1 if both aren't set */
+	float GetObstacleDistance() const
+	{
+		if (LeaderDistance < 0) return ConflictDistance;
+		if (ConflictDistance < 0) return LeaderDistance;
+		return FMath::Min(LeaderDistance, ConflictDistance);
+	}
+};
+
+/**
+ * USodaTrafficAwareness
+ * Shared traffic picture for the AI drivers. Every frame all vehicles and pedestrians are placed on the lanes built from
+ * the ANavigationRoute actors (the same soda::FTrafficLane graph the Mass traffic uses) and sorted by the distance
+ * along the lanes. Then the leader, the follower and the crossing conflicts are found for every watched agent in
+ * parallel, so the AI drivers read them in O(1) instead of doing their own traces and actor iterations.
+ * The lanes are rebuilt automatically if the routes are changed.
+ * The picture is built at the end of the frame and is used by the AI drivers on the next one.
+ */
+UCLASS()
+class UNREALSODA_API USodaTrafficAwareness : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** [cm] Max distance of the agent from the lane center to be placed on the lane */
+	float MaxLaneOffset = 250;
+
+	/** [cm] How far the leaders and the crossings are searched */
+	float LookoutDistance = 15000;
+
+	/** [s] The crossing conflicts are considered only for the agents which reach the crossing within this time */
+	float CrossingTimeHorizon = 8;
+
+	/** [cm] Half width of the crossing zone, the agent inside it always blocks the crossing */
+	float CrossingHalfWidth = 250;
+
+	/** The Actor is included to the per-agent computations while it is watched */
+	void Watch(const AActor* Actor);
+	void Unwatch(const AActor* Actor);
+
+	/** Null if the Actor isn't watched or the picture isn't built yet */
+	const FTrafficAwareness* GetAwareness(const AActor* Actor) const;
+
+	/** Find the lane closest to the Location codirected with the Direction; returns the route and the distance along its spline */
+	const ANavigationRoute* FindNearestRoute(const FVector& Location, const FVector& Direction, float MaxDistance, float& OutDistance);
+
+	const TArray<soda::FTrafficLane>& GetLanes() const { return Lanes; }
+
+	// UTickableWorldSubsystem implementation Begin
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return bBegunPlay && Watched.Num() > 0; }
+	virtual TStatId GetStatId() const override;
+	// UTickableWorldSubsystem implementation End
+
+protected:
+	struct FAgent
+	{
+		TWeakObjectPtr<AActor> Actor;
+		FVector Location;
+		FVector Direction;
+		FVector Velocity;
+		float Speed = 0; // [m/s] along the lane
+		float Length = 0; // [cm]
+		int32 Lane = INDEX_NONE;
+		float Distance = 0;
+		int32 Slot = INDEX_NONE;
+		bool bWatched = false;
+
+		/** Pedestrians are placed on the lanes regardless of their direction */
+		bool bPedestrian = false;
+		FTrafficAwareness Awareness;
+	};
+
+	/** Rebuild the lanes if the routes are changed */
+	void UpdateLanes();
+	void CollectAgents();
+	void PlaceAgent(FAgent& Agent, int32 PrevLane, float PrevDistance, float DeltaTime) const;
+	bool TryPlaceOnLane(FAgent& Agent, int32 LaneIndex, float Guess, float Window) const;
+
+	/** Writes only the awareness of the agent, so it is called for all agents in parallel */
+	void ComputeAwareness(int32 AgentIndex);
+	float GetActorLength(const AActor* Actor);
+
+	TArray<soda::FTrafficLane> Lanes;
+	uint32 RoutesHash = 0;
+
+	TArray<FAgent> Agents;
+	TMap<TObjectKey<AActor>, int32> AgentIndices;
+	TSet<TObjectKey<AActor>> Watched;
+	TMap<TObjectKey<AActor>, float> ActorLengths;
+	bool bBegunPlay = false;
+};
@@ -12,60 +12,6 @@ class UVehicleEngineBaseComponent;
 class UVehicleSteeringRackBaseComponent;
 class UVehicleGearBoxBaseComponent;
 
-namespace soda
-{
-	struct FGenericWheeledVehiclControl
-	{
-		union
-		{
-			float ByAngle; // [rad]
-			float ByRatio; // [-1..1]
-		} SteerReq;
-
-		/** Zero value means change speed as quickly as possible to TargetSpeed */
-		union
-		{
-			float ByAcc; // [cm/s^2]
-			float ByRatio; // [-1..1]
-		} DriveEffortReq;
-
-		/** [rad/s] Zero value means change speed as quickly as possible to SteerReq.ByAngle */
-		float SteeringAngleVelocity;
-
-		/** [cm/s] */
-		float TargetSpeedReq;
-
-		EGearState GearStateReq;
-		/**
-		 * Desire gear number for the DRIVE and REVERSE gear only;
-		 * Values:
-		 *   - 0        - automatic/undefined;
-		 *   - others
-		 */
-		int8 GearNumReq;
-
-		enum class ESteerReqMode: uint8
-		{
-			ByRatio,
-			ByAngle
-		};
-
-		enum class EDriveEffortReqMode : uint8
-		{
-			ByRatio,
-			ByAcc
-		};
-		bool bTargetSpeedIsSet;
-		bool bGearIsSet;
-		bool bSteeringAngleVelocitySet;
-		ESteerReqMode SteerReqMode;
-		EDriveEffortReqMode DriveEffortReqMode;
-
-		TTimestamp Timestamp;
-	};
-
-} // namespace soda
-
 /**
  * TODO: Support brake by Engine
  * TODO: Support revers by Engine, without change gear (for electric engines)
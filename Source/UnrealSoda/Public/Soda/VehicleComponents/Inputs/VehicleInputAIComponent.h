@@ -7,6 +7,7 @@
 #include "Soda/Vehicles/VehicleBaseTypes.h"
 #include "Soda/VehicleComponents/VehicleInputComponent.h"
 #include "Soda/Misc/PIDController.h"
+#include "Soda/Misc/RouteTracker.h"
 #include "VehicleInputAIComponent.generated.h"
 
 class ASodaWheeledVehicle;
@@ -121,6 +122,12 @@ public:
 	UPROPERTY(Category = "AI controller", EditAnywhere, BlueprintReadWrite, SaveGame, meta = (EditInRuntime))
 	bool bUseActorsPositionChecking = false;
 
+	/** Take the leader and the crossing conflicts from the shared USodaTrafficAwareness while the vehicle is on a navigation route,
+	 *  instead of the own obstacle detection. Only the vehicles and pedestrians are considered in this case, so the static
+	 *  obstacles found by the raycast are missed; use it for the dense traffic of the AI vehicles only */
+	UPROPERTY(Category = "AI controller", EditAnywhere, BlueprintReadWrite, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	bool bUseTrafficAwareness = false;
+
 	/** Put debug output to log*/
 	UPROPERTY(Category = "Debug", EditAnywhere, BlueprintReadWrite, SaveGame, meta = (EditInRuntime))
 	bool bDebugOutputLog = false;
@@ -197,6 +204,7 @@ private:
 	float RayCast(const FVector& Start, const FVector& End);
 	float CheckIntersectionWithOtherActors(const FVector& Start, const FVector& End, const TArray<AActor*> ActorsToCheck);
 	float GetDistanceToObstacle();
+	bool GetObstacleDistanceFromAwareness(float& OutDistance) const; // Returns false if the vehicle isn't on the shared lanes.
 	float GetSlowingDistance() const;
 	bool IsPointInsideBox(FVector point, UBoxComponent* boxComponent) const;
 	void DrawCurrentRoute();
@@ -210,11 +218,11 @@ private:
 	UPROPERTY()
 	USplineComponent* RouteSpline;
 
-	TArray< FVector > TargetLocations;
+	/** Route being followed, resampled by the arc length */
+	FRouteTracker Route;
 	float SideError = 0;
 	float CurrentObstacleDistance = 0;
 	bool bDriveBackvard = false;
-	int32 CurrentSplineSegment = -1;
 
 	float Throttle = 0.f;
 	float Steering = 0.f;
@@ -192,6 +192,7 @@ protected:
 	virtual bool OnActivateVehicleComponent() override;
 	virtual void OnDeactivateVehicleComponent() override;
 	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual void SerializeSnapshot(FArchive& Ar) override;
 
 protected:
 	UPROPERTY()
@@ -111,6 +111,7 @@ protected:
 
 public:
 	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual void SerializeSnapshot(FArchive& Ar) override;
 	virtual void PrePhysicSimulation(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp & Timestamp) override;
 	virtual void PostPhysicSimulation(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& Timestamp) override;
 
@@ -0,0 +1,270 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "Soda/VehicleComponents/Mechanicles/VehicleEngineComponent.h"
+#include "Soda/Misc/PrecisionTimer.hpp"
+#include "Containers/TripleBuffer.h"
+#include "VehiclePowertrainComponent.generated.h"
+
+/**
+ * Inputs of the FPowertrainSolver, written once per vehicle step
+ */
+struct FPowertrainInput
+{
+	/** [0..1], used if RequestedTorque is not set */
+	float Throttle = 0;
+
+	/** [N*m], used if bByTorque */
+	float RequestedTorque = 0;
+	bool bByTorque = false;
+
+	/** The gear request is applied only if GearRequestId has changed, so the automatic shifts aren't overridden */
+	int32 GearRequestId = 0;
+	int32 RequestedGearNum = 0;
+
+	/** Angular velocity of the driven wheels [rad/s], the boundary condition of the driveline */
+	float WheelAngularVelocity[2] = { 0, 0 };
+};
+
+/**
+ * Outputs of the FPowertrainSolver. The wheel impulses are cumulative, so the reader can get the mean torque over
+ * its own step regardless of how many solver steps were done between the reads.
+ */
+struct FPowertrainOutput
+{
+	/** Solver time [s] */
+	double Time = 0;
+
+	/** Cumulative impulse of the wheel torque [N*m*s] */
+	double WheelImpulse[2] = { 0, 0 };
+
+	float EngineAngularVelocity = 0;
+	float EngineTorque = 0;
+	float MaxTorque = 0;
+	float ClutchTorque = 0;
+	float ClutchEngagement = 0;
+	float ShaftTorque = 0;
+	int32 GearNum = 0;
+	bool bClutchLocked = false;
+};
+
+/**
+ * Parameters of the FPowertrainSolver, copied from the component on activation
+ */
+struct FPowertrainParams
+{
+	/** Max engine torque [N*m] sampled from the torque curve with the TorqueLUTStep [rad/s] */
+	TArray<float> TorqueLUT;
+	float TorqueLUTStep = 10;
+
+	float EngineInertia = 0.2;
+	float EngineFrictionTorque = 10;
+	float EngineDamping = 0.02;
+	float IdleAngularVelocity = 0;
+	float IdleGain = 5;
+	float LaunchAngularVelocity = 0;
+	float GearboxInertia = 0.05;
+	float ClutchMaxTorque = 600;
+	float ClutchEngageTime = 0.3;
+	float ShaftStiffness = 10000;
+	float ShaftDamping = 50;
+	float FinalDriveRatio = 4;
+	float Efficiency = 1;
+	TArray<float> ForwardGearRatios;
+	TArray<float> ReverseGearRatios;
+	bool bAutomaticGears = true;
+	float ChangeUpRPM = 4500;
+	float ChangeDownRPM = 2000;
+	float GearChangeTime = 0.2;
+};
+
+/**
+ * FPowertrainSolver
+ * Time domain model of the driveline: engine inertia, friction clutch (locked/slipping), gearbox, compliant shaft
+ * and open differential. The wheel speeds are the boundary condition, the output is the torque on the wheels.
+ * The shaft spring-damper is integrated by the implicit Euler method, so the stiff shaft is stable at any step.
+ */
+class UNREALSODA_API FPowertrainSolver
+{
+public:
+	void Reset(const FPowertrainParams& InParams);
+	void Step(double DeltaTime, const FPowertrainInput& Input);
+
+	const FPowertrainOutput& GetOutput() const { return Output; }
+
+	void Serialize(FArchive& Ar);
+
+protected:
+	float GetGearRatio(int32 Gear) const;
+	float GetMaxTorque(float AngularVelocity) const;
+	void UpdateGear(double DeltaTime, const FPowertrainInput& Input);
+
+	FPowertrainParams Params;
+	FPowertrainOutput Output;
+
+	/** State */
+	float EngineAngularVelocity = 0;
+	float GearboxAngularVelocity = 0;
+	float ShaftTwist = 0;
+	float ClutchEngagement = 0;
+	bool bClutchLocked = false;
+	int32 GearNum = 0;
+	int32 TargetGearNum = 0;
+	float GearChangeTimer = 0;
+	int32 LastGearRequestId = 0;
+};
+
+/**
+ * UVehiclePowertrainComponent
+ * Replaces the Engine - GearBox - Differential chain by the FPowertrainSolver running at the fixed SolverTimeStep.
+ * In the asynchronous mode the solver runs on its own thread and exchanges the data with the vehicle step through
+ * the lock-free triple buffers; in the synchronous mode the solver is substepped inside the vehicle step.
+ * LinkToTorqueTransmission and LinkToTorqueTransmission2 are the driven wheels.
+ */
+UCLASS(ClassGroup = Soda, BlueprintType, Blueprintable, meta = (BlueprintSpawnableComponent))
+class UNREALSODA_API UVehiclePowertrainComponent : public UVehicleEngineBaseComponent
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Link, SaveGame, meta = (EditInRuntime, ReactivateActor, AllowedClasses = "TorqueTransmission"))
+	FSubobjectReference LinkToTorqueTransmission2 { TEXT("WheelFR") };
+
+	/** Fixed step of the solver [ms] */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Solver, SaveGame, meta = (EditInRuntime, ReactivateComponent, ClampMin = "0.05", ClampMax = "5.0"))
+	float SolverTimeStep = 0.5;
+
+	/** Torque [N*m] at a given RPM */
+	UPROPERTY(EditAnywhere, Category = Engine)
+	FRuntimeFloatCurve TorqueCurve;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Engine, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float TorqueCurveMultiplier = 1.f;
+
+	/** [kg*m2] */
+	UPROPERTY(EditAnywhere, Category = Engine, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float EngineInertia = 0.2;
+
+	/** Coulomb friction of the engine [N*m] */
+	UPROPERTY(EditAnywhere, Category = Engine, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float EngineFrictionTorque = 10;
+
+	/** Viscous friction of the engine [N*m*s/rad] */
+	UPROPERTY(EditAnywhere, Category = Engine, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float EngineDamping = 0.02;
+
+	/** 0 for the electric motor */
+	UPROPERTY(EditAnywhere, Category = Engine, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float IdleRPM = 0;
+
+	/** Engine RPM at which the clutch is fully engaged from the standstill (automatic gears only) */
+	UPROPERTY(EditAnywhere, Category = Clutch, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float LaunchRPM = 1500;
+
+	/** [N*m] */
+	UPROPERTY(EditAnywhere, Category = Clutch, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float ClutchMaxTorque = 600;
+
+	/** [s] */
+	UPROPERTY(EditAnywhere, Category = Clutch, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float ClutchEngageTime = 0.3;
+
+	/** [kg*m2] */
+	UPROPERTY(EditAnywhere, Category = GearBox, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float GearboxInertia = 0.05;
+
+	UPROPERTY(EditAnywhere, Category = GearBox, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	TArray<float> ForwardGearRatios;
+
+	UPROPERTY(EditAnywhere, Category = GearBox, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	TArray<float> ReverseGearRatios;
+
+	UPROPERTY(EditAnywhere, Category = GearBox, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	bool bUseAutomaticGears = true;
+
+	UPROPERTY(EditAnywhere, Category = GearBox, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float ChangeUpRPM = 4500.0f;
+
+	UPROPERTY(EditAnywhere, Category = GearBox, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float ChangeDownRPM = 2000.0f;
+
+	/** [s] */
+	UPROPERTY(EditAnywhere, Category = GearBox, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float GearChangeTime = 0.2;
+
+	UPROPERTY(EditAnywhere, Category = GearBox, SaveGame, meta = (EditInRuntime))
+	bool bAcceptGearFromVehicleInput = true;
+
+	/** Torsional stiffness of the shaft between the gearbox and the differential [N*m/rad] */
+	UPROPERTY(EditAnywhere, Category = Driveline, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float ShaftStiffness = 10000;
+
+	/** [N*m*s/rad] */
+	UPROPERTY(EditAnywhere, Category = Driveline, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float ShaftDamping = 50;
+
+	UPROPERTY(EditAnywhere, Category = Driveline, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float FinalDriveRatio = 4;
+
+	UPROPERTY(EditAnywhere, Category = Driveline, SaveGame, meta = (EditInRuntime, ReactivateComponent, ClampMin = "0.0", ClampMax = "1.0"))
+	float Efficiency = 0.95;
+
+	/** Allow set throttle from default the UVhicleInputComponent */
+	UPROPERTY(EditAnywhere, Category = Engine, SaveGame, meta = (EditInRuntime))
+	bool bAcceptPedalFromVehicleInput = true;
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = Powertrain)
+	TScriptInterface<ITorqueTransmission> OutputTorqueTransmission2;
+
+	UFUNCTION(BlueprintCallable, Category = Powertrain)
+	void SetGearByNum(int GearNum);
+
+	UFUNCTION(BlueprintCallable, Category = Powertrain)
+	void SetGearByState(EGearState GearState);
+
+	UFUNCTION(BlueprintCallable, Category = Powertrain)
+	int GetGearNum() const { return Output.GearNum; }
+
+public:
+	virtual void RequestByTorque(float InTorque) override;
+	virtual void RequestByRatio(float InRatio) override;
+	virtual float ResolveAngularVelocity() const override { return Output.EngineAngularVelocity; }
+	virtual float GetMaxTorque() const override { return Output.MaxTorque; }
+	virtual float GetTorque() const override { return Output.EngineTorque; }
+	virtual bool FindToWheelRatio(float& OutRatio) const override;
+
+	const FPowertrainOutput& GetOutput() const { return Output; }
+
+public:
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual void SerializeSnapshot(FArchive& Ar) override;
+	virtual void PrePhysicSimulation(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& Timestamp) override;
+	virtual void PostPhysicSimulation(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& Timestamp) override;
+
+protected:
+	virtual bool OnActivateVehicleComponent() override;
+	virtual void OnDeactivateVehicleComponent() override;
+
+	void SolverTick(const std::chrono::nanoseconds& InDeltatime, const std::chrono::nanoseconds& Elapsed);
+
+	FPowertrainSolver Solver;
+	FPrecisionTimer SolverTimer;
+	bool bSynchronousSolver = false;
+
+	/** Vehicle step -> solver thread */
+	TTripleBuffer<FPowertrainInput> InputBuffer;
+
+	/** Solver thread -> vehicle step */
+	TTripleBuffer<FPowertrainOutput> OutputBuffer;
+
+	/** Written by the vehicle step only */
+	FPowertrainInput Input;
+
+	/** Last output read by the vehicle step */
+	FPowertrainOutput Output;
+	float WheelTorque[2] = { 0, 0 };
+	EGearState LastInputGearState = EGearState::Neutral;
+};
@@ -65,6 +65,7 @@ public:
 public:
 	virtual void PrePhysicSimulation(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& Timestamp) override;
 	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual void SerializeSnapshot(FArchive& Ar) override;
 
 protected:
 	virtual bool OnActivateVehicleComponent() override;
@@ -3,49 +3,102 @@
 #pragma once
 
 #include "Soda/VehicleComponents/WheeledVehicleComponent.h"
-#include "InputCoreTypes.h"
-#include <fstream>
+#include "Soda/Misc/ChannelLogWriter.h"
 #include "CsvLogger.generated.h"
 
+UENUM(BlueprintType)
+enum class EVehicleLogFormat : uint8
+{
+	CSV,
+	CSVGzip,
+};
+
+/**
+ * FVehicleLogChannel
+ */
+USTRUCT(BlueprintType)
+struct UNREALSODA_API FVehicleLogChannel
+{
+	GENERATED_BODY()
+
+	/** Column name; the Path is used if empty */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Channel, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FString Name;
+
+	/**
+	 * Path to the UPROPERTY: "<Component>.<Property>[.<Property>]...", "Vehicle.<Property>..." for the vehicle itself.
+	 * The static and dynamic arrays are indexed as "<Property>[<Index>]", the object properties are followed.
+	 * The struct (FVector, FRotator etc.) is logged as one column per numeric field, e.g. "Engine.Torque" or "FL.Slip".
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Channel, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FString Path;
+};
+
+/**
+ * UCSVLoggerComponent
+ * Logs the vehicle kinematic, the wheels and any numeric UPROPERTY of the vehicle components (powertrain, CAN devices
+ * etc.) with the physics step rate. The physics step only copies the values to the ring buffer; formatting,
+ * compressing and writing is done by the FChannelLogWriter thread.
+ */
 UCLASS(ClassGroup = Soda, BlueprintType, meta = (BlueprintSpawnableComponent))
 class UNREALSODA_API UCSVLoggerComponent : public UWheeledVehicleComponent
 {
 	GENERATED_UCLASS_BODY()
 
 public:
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	/** The relative path is relative to the "<ProjectSaved>/VehicleLogs"; the start time is appended to the name */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Logger, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FString FileNameBase = TEXT("log");
 
-protected:
-	virtual bool OnActivateVehicleComponent() override;
-	virtual void OnDeactivateVehicleComponent() override;
-	virtual void PostPhysicSimulationDeferred(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& Timestamp) override;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Logger, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	EVehicleLogFormat Format = EVehicleLogFormat::CSV;
 
-public:
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Sensor, SaveGame, meta = (EditInRuntime))
-	float Period = 0.1f; // (sec) Logging period
+	/** [s] 0 - every physics step */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Logger, SaveGame, meta = (EditInRuntime))
+	float Period = 0;
+
+	/** Location, rotation, local velocity, local acceleration and gyro of the vehicle */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Logger, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	bool bLogKinematic = true;
 
-	UPROPERTY(BlueprintReadWrite, Category = Sensor, meta = (EditInRuntime))
-	bool bAddTimeMarkToNextTick = false;
+	/** Angular velocity, steer, requested torque and brake torque of every wheel */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Logger, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	bool bLogWheels = true;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Sensor, SaveGame, meta = (EditInRuntime))
-	FString CvsFileNameBase = "log";
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Logger, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	TArray<FVehicleLogChannel> Channels;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Sensor)
-	FKey ToggleKeyInput = FKey("EIGHT");
+	/** Ring buffer size [rows]; the rows are dropped if the writer is behind by more than this */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Logger, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	int BufferSize = 8192;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Sensor)
-	FKey PutTimeMarkKeyInput = FKey("NINE");
+	/** The UPROPERTY path resolved to the property chain; the struct leaf is expanded to the column per numeric field */
+	struct FPropertyColumn
+	{
+		struct FStep
+		{
+			const FProperty* Property = nullptr;
+			int32 Index = INDEX_NONE;
+		};
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Sensor, SaveGame)
-	int CvsFileNameIndex = 0;
+		TWeakObjectPtr<UObject> Root;
+		TArray<FStep> Steps;
 
-	std::int64_t TimeTravelled = 0; // (ms)
-	float DistanceTravelled; // (m)
+		/** NaN if the path can't be followed now (null object, index out of range) */
+		double Read() const;
+	};
+
+protected:
+	virtual bool OnActivateVehicleComponent() override;
+	virtual void OnDeactivateVehicleComponent() override;
+	virtual void PostPhysicSimulation(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& Timestamp) override;
+	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual FString GetRemark() const override;
 
-	FVector PrevLocaion;
-	FVector StartLocation;
-	std::int64_t PrevTimestamp = 0;
-	std::int64_t PrevLoggedTimeMark= 0;
+	/** PropertyPath is relative to the Root: "<Property>[.<Property>]..." */
+	bool AddPropertyColumns(UObject* Root, const FString& Name, const FString& PropertyPath, TArray<soda::FChannelLogWriter::FColumn>& OutColumns);
 
-	std::ofstream CsvOutFile;
+	TArray<FPropertyColumn> PropertyColumns;
+	TUniquePtr<soda::FChannelLogWriter> LogWriter;
+	float TimeFromLastRow = 0;
 };
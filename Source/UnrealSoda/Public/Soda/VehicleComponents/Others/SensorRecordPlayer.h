@@ -0,0 +1,116 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "Soda/VehicleComponents/VehicleBaseComponent.h"
+#include "Soda/VehicleComponents/GenericVehicleComponentHelpers.h"
+#include "Soda/VehicleComponents/Sensors/Base/LidarSensor.h"
+#include "Soda/Misc/SensorRecord.h"
+#include "SensorRecordPlayer.generated.h"
+
+UENUM(BlueprintType)
+enum class ESensorRecordPacing : uint8
+{
+	/** The frames are published with the recorded intervals scaled by the PlaybackRate */
+	OriginalTiming,
+
+	/** Up to MaxFramesPerTick frames are published every tick */
+	AsFastAsPossible,
+};
+
+/**
+ * FSensorRecordReplayTarget
+ */
+USTRUCT(BlueprintType)
+struct UNREALSODA_API FSensorRecordReplayTarget
+{
+	GENERATED_BODY()
+
+	/** The name of the recorded stream, see FSensorRecordSettings::StreamName */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replay, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FString StreamName;
+
+	/** Must be the publisher of the recorded stream type, e.g. the UGenericLidarPublisher for the lidar stream */
+	UPROPERTY(EditAnywhere, Instanced, Category = Replay, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	TObjectPtr<UGenericPublisher> Publisher;
+};
+
+/**
+ * USensorRecordPlayerComponent
+ * Replays the sensor record file written by the recording publishers (URecordingLidarPublisher etc.): every recorded
+ * frame is published to the target publisher of its stream with the recorded header, so the downstream stack receives
+ * the same data without the sensors being simulated.
+ * The V2X and the wheeled vehicle streams can't be replayed, their publishers take the live components.
+ */
+UCLASS(ClassGroup = Soda, BlueprintType, meta = (BlueprintSpawnableComponent))
+class UNREALSODA_API USensorRecordPlayerComponent : public UVehicleBaseComponent
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	/** The relative path is relative to the "<ProjectSaved>/SensorRecords" */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replay, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FString FileName = TEXT("Record.srec");
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replay, SaveGame, meta = (EditInRuntime))
+	ESensorRecordPacing Pacing = ESensorRecordPacing::OriginalTiming;
+
+	/** Used by the ESensorRecordPacing::OriginalTiming */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replay, SaveGame, meta = (EditInRuntime))
+	float PlaybackRate = 1;
+
+	/** Used by the ESensorRecordPacing::AsFastAsPossible */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replay, SaveGame, meta = (EditInRuntime))
+	int MaxFramesPerTick = 64;
+
+	/** [s] from the first frame of the record */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replay, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float StartTime = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replay, SaveGame, meta = (EditInRuntime))
+	bool bLoop = false;
+
+	UPROPERTY(EditAnywhere, Category = Replay, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	TArray<FSensorRecordReplayTarget> Targets;
+
+public:
+	UFUNCTION(BlueprintCallable, Category = Replay, meta = (CallInRuntime))
+	void RestartReplay();
+
+	/** [s] from the first frame of the record */
+	UFUNCTION(BlueprintCallable, Category = Replay, meta = (CallInRuntime))
+	void SeekReplay(float Time);
+
+	/** [s] */
+	UFUNCTION(BlueprintCallable, Category = Replay)
+	float GetRecordDuration() const { return Reader.GetDuration(); }
+
+	UFUNCTION(BlueprintCallable, Category = Replay)
+	bool IsReplayFinished() const { return NextFrame >= Reader.GetFrames().Num(); }
+
+protected:
+	virtual bool OnActivateVehicleComponent() override;
+	virtual void OnDeactivateVehicleComponent() override;
+	virtual bool IsVehicleComponentInitializing() const override;
+	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual FString GetRemark() const override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	bool ReplayFrame(const soda::FSensorRecordReader::FFrame& Frame);
+
+	soda::FSensorRecordReader Reader;
+
+	/** Target publisher of every stream of the record, null if the stream isn't replayed */
+	TArray<UGenericPublisher*> StreamPublishers;
+
+	int32 NextFrame = 0;
+
+	/** [s] from the first frame of the record */
+	double PlaybackTime = 0;
+
+	int64 ReplayedFrames = 0;
+
+	/** The buffers reused by the frames */
+	TArray<FColor> CameraPixels;
+	soda::FLidarSensorData LidarScan;
+};
@@ -0,0 +1,61 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "Soda/VehicleComponents/VehicleBaseComponent.h"
+#include "Soda/Misc/XCPSlave.h"
+#include "XCPSlaveComponent.generated.h"
+
+/**
+ * XCP-on-Ethernet slave of the vehicle. All scalar UPROPERTYs of the vehicle and its components are available
+ * as measurements, DAQ lists are sampled on the physics substeps. The symbol table is rebuilt when the vehicle
+ * components are added or removed, which frees the DAQ lists configured by the master.
+ * Event channels: 0 - before the physics substep, 1 - after the physics substep.
+ */
+UCLASS(ClassGroup = Soda, BlueprintType, meta = (BlueprintSpawnableComponent))
+class UNREALSODA_API UXCPSlaveComponent : public UVehicleBaseComponent
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	/** UDP port of the XCP slave */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = XCP, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	int Port = 5555;
+
+	/** Write A2L file of the symbol table to Saved/XCP/ on activation */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = XCP, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	bool bExportA2L = true;
+
+public:
+	UFUNCTION(BlueprintCallable, Category = XCP, meta = (CallInRuntime))
+	void ExportA2L();
+
+	TSharedPtr<xcp::FSlave> GetSlave() const { return Slave; }
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	virtual bool OnActivateVehicleComponent() override;
+	virtual void OnDeactivateVehicleComponent() override;
+	virtual FString GetRemark() const override;
+	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual void PrePhysicSimulation(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& Timestamp) override;
+	virtual void PostPhysicSimulation(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& Timestamp) override;
+
+	void FillSymbolTable(xcp::FSymbolTable& SymbolTable);
+
+	/** Some symbols point to the destroyed objects, or (bCheckNewComponents) the vehicle components don't match the table */
+	bool IsSymbolTableOutdated(bool bCheckNewComponents) const;
+
+	void RebuildSymbolTable();
+	void OnPreGarbageCollect();
+
+protected:
+	TSharedPtr<xcp::FSlave> Slave;
+	uint16 PrePhysicEvent = 0;
+	uint16 PostPhysicEvent = 0;
+
+	/** Vehicle and components the symbols point to */
+	TArray<TWeakObjectPtr<UObject>> SymbolOwners;
+	FDelegateHandle PreGarbageCollectHandle;
+};
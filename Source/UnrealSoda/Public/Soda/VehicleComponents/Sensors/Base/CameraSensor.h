@@ -197,6 +197,18 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = CameraSensor, SaveGame, meta = (EditInRuntime, ReactivateComponent))
 	bool bForceLinearGamma = false;
 
+	/** Apply the contrast loss of the USodaSensorEnvironment weather to the ColorBGR8 and HdrRGB8 images sent from CPU */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weather, SaveGame, meta = (EditInRuntime))
+	bool bWeatherDegradation = true;
+
+	/** [m] Typical distance to the scene, the contrast loss is computed for it */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weather, SaveGame, meta = (EditInRuntime, EditCondition = "bWeatherDegradation"))
+	float WeatherSceneDistance = 50;
+
+	/** Color of the light scattered by the fog and the precipitation */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weather, SaveGame, meta = (EditInRuntime, EditCondition = "bWeatherDegradation"))
+	FColor WeatherAirlight = FColor(190, 190, 190);
+
 	//UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Debug, SaveGame, meta = (EditInRuntime))
 	//bool bDrawDebugText = false;
 
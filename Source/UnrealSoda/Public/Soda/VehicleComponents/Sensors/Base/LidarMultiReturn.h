@@ -0,0 +1,97 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/HitResult.h"
+#include "CollisionQueryParams.h"
+
+class UWorld;
+
+namespace soda
+{
+
+/**
+ * FLidarMultiReturnTracer
+ * Multi-return scan of the lidar beams. The center ray of every beam is traced by the multi-hit raycast; the beams on
+ * the surface edges or with the partial hits are refined by the sub-rays on the cone of the beam divergence. The hits
+ * of the beam closer than EchoSeparation are merged into the echoes and the ReturnsNum strongest echoes are kept.
+ * All buffers are flat and reused: the hits are limited to MaxSubRayHits per sub-ray, so after the first scans of the
+ * same scene the tracing doesn't allocate.
+ */
+class UNREALSODA_API FLidarMultiReturnTracer
+{
+public:
+	/** The nearest hits kept per sub-ray; the energy left after them is negligible */
+	static constexpr int MaxSubRayHits = 8;
+	static constexpr int MaxReturns = 8;
+	static constexpr int MaxEdgeRays = 16;
+
+	struct FSetup
+	{
+		int ReturnsNum = 1;
+
+		/** Full angle [deg] */
+		float BeamDivergence = 0.2;
+		int BeamEdgeRays = 6;
+
+		/** [cm] */
+		float EchoSeparation = 50;
+		float MinEchoIntensity = 0.05;
+		float PartialHitReflectance = 0.3;
+
+		/** [cm] */
+		float MinDistance = 0;
+		float MaxDistance = 0;
+	};
+
+	struct FEcho
+	{
+		/** World location, weighted by the energy of the merged hits */
+		FVector Location = FVector::ZeroVector;
+
+		/** Fraction of the beam energy; 0 if there is no echo */
+		float Energy = 0;
+	};
+
+	/** Columns - number of columns if the rays are the 2D grid, 0 otherwise; the grid neighbours are used as the edge detector */
+	void Trace(const UWorld* World, const FCollisionQueryParams& QueryParams, const FTransform& Pose, const TArray<FVector>& Rays, int Columns, const FSetup& Setup);
+
+	/** Echoes of the last Trace(), [Echo * BeamsNum + Beam] in the order of the distance */
+	const TArray<FEcho>& GetEchoes() const { return Echoes; }
+	int GetReturnsNum() const { return ReturnsNum; }
+	int GetRefinedBeamsNum() const { return EdgeBeams.Num(); }
+
+	/** Free the buffers */
+	void Reset();
+
+private:
+	struct FCandidate
+	{
+		float Distance; // [cm]
+		float Energy;
+		FVector Location;
+	};
+
+	void AddSubRayEchoes(const TArray<FHitResult>& Hits, const TArray<int32>& HitsNum, int SubRay, float RayEnergy, float PartialHitReflectance);
+	bool HasPartialHits(int Beam) const;
+	bool HasBlockingHit(int Beam) const;
+	bool IsSurfaceEdge(int BeamA, int BeamB) const;
+
+	TArray<FVector> BatchStart;
+	TArray<FVector> BatchEnd;
+
+	/** [SubRay * MaxSubRayHits + k], k < HitsNum[SubRay] */
+	TArray<FHitResult> CenterHits;
+	TArray<int32> CenterHitsNum;
+	TArray<FHitResult> EdgeHits;
+	TArray<int32> EdgeHitsNum;
+
+	TArray<int> EdgeBeams;
+	TArray<FCandidate> Candidates;
+	TArray<FCandidate> BeamEchoes;
+	TArray<FEcho> Echoes;
+	int ReturnsNum = 1;
+};
+
+} // namespace soda
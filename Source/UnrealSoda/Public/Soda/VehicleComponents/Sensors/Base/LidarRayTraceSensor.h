@@ -3,6 +3,10 @@
 #pragma once
 
 #include "Soda/VehicleComponents/Sensors/Base/LidarSensor.h"
+#include "Soda/Misc/NoiseEngine.h"
+#include "Soda/VehicleComponents/Sensors/Base/LidarMultiReturn.h"
+#include "Engine/HitResult.h"
+#include "CollisionQueryParams.h"
 #include "LidarRayTraceSensor.generated.h"
 
 UCLASS(abstract, ClassGroup = Soda, BlueprintType, meta = (BlueprintSpawnableComponent))
@@ -33,9 +37,78 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Sensor, SaveGame, meta = (EditInRuntime))
 	float DistanceToGround = 0;
 
+	/** Standard deviation of the range noise of the valid points [cm] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Noise, SaveGame, meta = (EditInRuntime, ClampMin = 0))
+	float RangeNoiseStdDev = 0;
+
+	/** 
+	 * Simulate the sweep of a spinning lidar. The columns of the scan are fired across several frames at the moments 
+	 * they would be fired by the real device, each column slice is traced from the sensor pose interpolated from the vehicle 
+	 * physics substeps. Points get TimeOffset and are expressed in the sensor frame at the moment of their firing (motion distortion).
+	 * At most one scan is published per frame, the scans missed by a long frame are dropped. Requires GetLidarSize() to be set.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Sweep, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	bool bSweepScan = false;
+
+	/** Rotation frequency of the lidar for bSweepScan [Hz] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Sweep, SaveGame, meta = (EditInRuntime, ReactivateComponent, ClampMin = 0.1))
+	float SweepFrequency = 10;
+
+	/** Number of column slices the columns fired on one frame are split into. The sensor pose is interpolated once per slice */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Sweep, SaveGame, meta = (EditInRuntime, ReactivateComponent, ClampMin = 1))
+	int SweepSlicesPerFrame = 4;
+
+	/**
+	 * Number of the echoes per beam. 1 - one infinitely thin ray per beam, the first hit is reported.
+	 * >1 - the beam is traced by the multi-hit rays and its echoes are aggregated with the range and the intensity.
+	 * The beams which may have several echoes (the edges of the objects, the overlapping hits like vegetation or rain)
+	 * are refined by the bundle of the sub-rays on the edge of the diverging beam. Not supported with bSweepScan.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MultiReturn, SaveGame, meta = (EditInRuntime, ReactivateComponent, ClampMin = 1, ClampMax = 8))
+	int ReturnsNum = 1;
+
+	/** Full angle of the beam divergence [deg] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MultiReturn, SaveGame, meta = (EditInRuntime, ClampMin = 0))
+	float BeamDivergence = 0.2;
+
+	/** Number of the sub-rays on the edge of the beam traced for the refined beams */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MultiReturn, SaveGame, meta = (EditInRuntime, ClampMin = 3, ClampMax = 16))
+	int BeamEdgeRays = 6;
+
+	/** The hits of the beam closer than this are merged into one echo [cm] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MultiReturn, SaveGame, meta = (EditInRuntime, ClampMin = 0))
+	float EchoSeparation = 50;
+
+	/** The echoes weaker than this fraction of the beam energy aren't reported */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MultiReturn, SaveGame, meta = (EditInRuntime, ClampMin = 0, ClampMax = 1))
+	float MinEchoIntensity = 0.05;
+
+	/** Fraction of the ray energy reflected by the overlapping (not blocking) hit; the rest passes through */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MultiReturn, SaveGame, meta = (EditInRuntime, ClampMin = 0, ClampMax = 1))
+	float PartialHitReflectance = 0.3;
+
 protected:
 	virtual bool OnActivateVehicleComponent() override;
 	virtual void OnDeactivateVehicleComponent() override;
+	virtual void PostPhysicSimulation(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& Timestamp) override;
+
+	virtual void TickSweep(float DeltaTime);
+	void TraceSweepColumns(int ColumnBegin, int ColumnEnd, int Columns, int Rows, double ScanDuration);
+
+	/** Generate the range noise of Num points to the Workspace. The noise of the point is defined by the Frame and the point index */
+	void PrepareRangeNoise(int64 Frame, int Num);
+
+	/** Trace the Workspace batch to the Workspace hits */
+	void TraceBatch();
+
+	/** Trace the multi-return scan from the Pose to the Scan points */
+	void TraceMultiReturn(const FTransform& Pose);
+
+	/** ScanTable if the rays are taken from it, null otherwise */
+	TSharedPtr<const soda::FLidarScanPatternTable> GetScanPatternTable() const;
+
+	/** Sensor world pose at the time PhysicTime [s] interpolated from the stored physics substeps */
+	FTransform GetSweepPose(double PhysicTime) const;
 
 
 public:
@@ -44,6 +117,45 @@ public:
 
 protected:
 	soda::FLidarSensorData Scan;
-	TArray<FVector> BatchStart;
-	TArray<FVector> BatchEnd;
+
+	/** Buffers reused by every scan; after the first scan of the same size the tick doesn't allocate */
+	struct FScanWorkspace
+	{
+		TArray<FVector> BatchStart;
+		TArray<FVector> BatchEnd;
+		TArray<FHitResult> Hits;
+		TArray<float> RangeNoise;
+
+		/** Built once on activation, adding the owner to the ignored actors allocates for the big vehicles */
+		FCollisionQueryParams QueryParams;
+	};
+	FScanWorkspace Workspace;
+	soda::FLidarMultiReturnTracer MultiReturnTracer;
+	soda::FNoiseStream NoiseStream;
+
+	struct FSweepPoseSample
+	{
+		double Time; // [s]
+		FTransform Pose;
+	};
+
+	struct FSweepSlice
+	{
+		int ColumnBegin;
+		int ColumnEnd;
+		FTransform Pose;
+	};
+
+	/** Ring buffer of the sensor poses at the physics substeps, protected by SweepPoseLock */
+	TArray<FSweepPoseSample> SweepPoseHistory;
+	int SweepPoseHead = 0;
+	int SweepPoseNum = 0;
+	double SweepPhysicTime = 0; // [s]
+	mutable FCriticalSection SweepPoseLock;
+
+	TArray<FSweepSlice> SweepSlices;
+	FSensorDataHeader SweepHeader{};
+	double SweepScanBeginTime = 0; // [s]
+	double SweepTime = 0; // [s]
+	int SweepNextColumn = 0;
 };
@@ -0,0 +1,142 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LidarScanPattern.generated.h"
+
+UENUM(BlueprintType)
+enum class ELidarScanPatternSource : uint8
+{
+	/** Regular grid of Channels x Step rays */
+	Uniform,
+
+	/** Beam table loaded from a CSV file. One beam (ring) per line: "elevation [deg], azimuth offset [deg]"; the azimuth offset is optional */
+	BeamTable,
+
+	/** Non-repetitive rose curve pattern (Livox like) */
+	Rosette,
+};
+
+/**
+ * One layer of the lidar scan pattern. Layers are concatenated by the compiler.
+ */
+USTRUCT(BlueprintType)
+struct UNREALSODA_API FLidarScanPatternLayer
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ScanPattern, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	ELidarScanPatternSource Source = ELidarScanPatternSource::Uniform;
+
+	/** Number of columns for Uniform and BeamTable */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ScanPattern, SaveGame, meta = (EditInRuntime, ReactivateComponent, EditCondition = "Source != ELidarScanPatternSource::Rosette"))
+	int Step = 1024;
+
+	/** [deg] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ScanPattern, SaveGame, meta = (EditInRuntime, ReactivateComponent, EditCondition = "Source != ELidarScanPatternSource::Rosette"))
+	float HorizontMin = 0;
+
+	/** [deg] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ScanPattern, SaveGame, meta = (EditInRuntime, ReactivateComponent, EditCondition = "Source != ELidarScanPatternSource::Rosette"))
+	float HorizontMax = 360;
+
+	/** Number of rings for Uniform */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ScanPattern, SaveGame, meta = (EditInRuntime, ReactivateComponent, EditCondition = "Source == ELidarScanPatternSource::Uniform"))
+	int Channels = 32;
+
+	/** [deg] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ScanPattern, SaveGame, meta = (EditInRuntime, ReactivateComponent, EditCondition = "Source == ELidarScanPatternSource::Uniform"))
+	float VerticalMin = -15;
+
+	/** [deg] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ScanPattern, SaveGame, meta = (EditInRuntime, ReactivateComponent, EditCondition = "Source == ELidarScanPatternSource::Uniform"))
+	float VerticalMax = 15;
+
+	/** Absolute path or path relative to the project directory */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ScanPattern, SaveGame, meta = (EditInRuntime, ReactivateComponent, EditCondition = "Source == ELidarScanPatternSource::BeamTable"))
+	FString BeamTableFile;
+
+	/** Number of rays in one rosette scan */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ScanPattern, SaveGame, meta = (EditInRuntime, ReactivateComponent, EditCondition = "Source == ELidarScanPatternSource::Rosette"))
+	int RosettePoints = 24000;
+
+	/** Circular FOV of the rosette [deg] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ScanPattern, SaveGame, meta = (EditInRuntime, ReactivateComponent, EditCondition = "Source == ELidarScanPatternSource::Rosette"))
+	float RosetteFOV = 70;
+
+	/** Petal coefficient K of the rose curve r = R * cos(K * t) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ScanPattern, SaveGame, meta = (EditInRuntime, ReactivateComponent, EditCondition = "Source == ELidarScanPatternSource::Rosette"))
+	float RosettePetals = 7.3;
+
+	/** Number of turns of the curve parameter t during one scan */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ScanPattern, SaveGame, meta = (EditInRuntime, ReactivateComponent, EditCondition = "Source == ELidarScanPatternSource::Rosette"))
+	float RosetteTurns = 10;
+};
+
+/**
+ * Description of an arbitrary lidar scan pattern. If enabled, it replaces the rays generated from the sensor FOV.
+ */
+USTRUCT(BlueprintType)
+struct UNREALSODA_API FLidarScanPattern
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ScanPattern, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	bool bEnabled = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ScanPattern, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	TArray<FLidarScanPatternLayer> Layers;
+
+	/** Unique text key of the pattern description, including the modification time and the size of the beam table files */
+	FString GetKey() const;
+};
+
+namespace soda
+{
+
+/**
+ * Compiled, immutable scan pattern. All arrays have the same length, one element per ray.
+ */
+struct UNREALSODA_API FLidarScanPatternTable
+{
+	/** Unit ray directions in the sensor frame */
+	TArray<FVector> Directions;
+
+	/** Ring (beam) index of each ray */
+	TArray<uint16> Rings;
+
+	/** Column index of each ray */
+	TArray<uint32> Columns;
+
+	/** Firing time of each ray as fraction of the scan duration [0..1) */
+	TArray<float> TimeFractions;
+
+	/** Set if the table is a row-major grid of Size.Y rings by Size.X columns */
+	TOptional<FUintVector2> Size;
+
+	/** Bounds of the pattern [deg] */
+	float HorizontMin = 0;
+	float HorizontMax = 0;
+	float VerticalMin = 0;
+	float VerticalMax = 0;
+};
+
+/**
+ * Compiles FLidarScanPattern to FLidarScanPatternTable. Compiled tables are cached and shared between all sensors
+ * with the same pattern description, so the rays are built once per pattern and never per tick.
+ */
+class UNREALSODA_API FLidarScanPatternCompiler
+{
+public:
+	static TSharedPtr<const FLidarScanPatternTable> Compile(const FLidarScanPattern& Pattern, FString& OutError);
+
+private:
+	/** RingOffset - ring index of the first ring of the layer; OutRings - number of the rings (rows) added by the layer */
+	static bool CompileLayer(const FLidarScanPatternLayer& Layer, int RingOffset, FLidarScanPatternTable& Table, int& OutRings, FString& OutError);
+
+	static FCriticalSection CacheLock;
+	static TMap<FString, TWeakPtr<const FLidarScanPatternTable>> Cache;
+};
+
+} // namespace soda
@@ -3,8 +3,27 @@
 #pragma once
 
 #include "Soda/VehicleComponents/VehicleSensorComponent.h"
+#include "Soda/VehicleComponents/Sensors/Base/LidarScanPattern.h"
+#include "Soda/Misc/SensorWeather.h"
 #include "LidarSensor.generated.h"
 
+/** Which echoes of the multi-return scan are sent */
+UENUM(BlueprintType)
+enum class ELidarReturnMode : uint8
+{
+	/** Every echo of every beam */
+	All,
+
+	/** The echo with the maximum intensity */
+	Strongest,
+
+	/** The farthest echo */
+	Last,
+
+	/** The strongest and the last echo; if the last is the strongest, the second strongest is sent instead */
+	Dual,
+};
+
 namespace soda
 {
 
@@ -19,7 +38,8 @@ struct FLidarScanPoint
 {
 	FVector Location {}; // [cm]
 	float Depth{}; // [cm]
-	float Intensitie{}; // TODO
+	float Intensitie{}; // Fraction of the beam energy returned by the echo [0..1], valid if bIntensitieIsValid
+	float TimeOffset{}; // Time since the beginning of the scan [s]
 	ELidarPointStatus Status = ELidarPointStatus::Invalid;
 };
 
@@ -49,7 +69,108 @@ struct FLidarSensorData
 
 	bool bIntensitieIsValid = false;
 
+	/** FLidarScanPoint::TimeOffset is filled (the scan was swept over ScanDuration) */
+	bool bTimeOffsetIsValid = false;
+
+	/** Duration of the whole scan [s] */
+	float ScanDuration{};
+
+	/**
+	 * Number of the echoes per beam. Points are stored by echoes: Points[Echo * GetBeamsNum() + Beam], the echoes
+	 * of the beam are sorted by the range; the missing echoes are Invalid.
+	 */
+	int ReturnsNum = 1;
+
 	TArray<FLidarScanPoint> Points{};
+
+	/** Scan pattern the beams were fired by, the beam index is the ray index of the table. Null if the rays aren't taken from a scan pattern */
+	TSharedPtr<const FLidarScanPatternTable> PatternTable;
+
+	int GetBeamsNum() const { return ReturnsNum > 1 ? Points.Num() / ReturnsNum : Points.Num(); }
+
+	/** Ring (layer) of the beam from the scan pattern or from the 2D size; -1 if unknown */
+	int GetRing(int Beam) const
+	{
+		if (PatternTable)
+		{
+			return PatternTable->Rings.IsValidIndex(Beam) ? PatternTable->Rings[Beam] : -1;
+		}
+		return (Size.IsSet() && Size->X > 0 && Size->Y > 0) ? int(Beam / Size->X) : -1;
+	}
+
+	/** Call Func(const FLidarScanPoint& Point, int Beam, int Echo) for the echoes selected by the Mode, beam by beam */
+	template <typename TFunc>
+	void ForEachReturn(ELidarReturnMode Mode, TFunc&& Func) const
+	{
+		const int BeamsNum = GetBeamsNum();
+		if (ReturnsNum <= 1 || Mode == ELidarReturnMode::All)
+		{
+			for (int Echo = 0; Echo < FMath::Max(ReturnsNum, 1); ++Echo)
+			{
+				for (int Beam = 0; Beam < BeamsNum; ++Beam)
+				{
+					Func(Points[Echo * BeamsNum + Beam], Beam, Echo);
+				}
+			}
+			return;
+		}
+
+		for (int Beam = 0; Beam < BeamsNum; ++Beam)
+		{
+			int Strongest = INDEX_NONE;
+			int SecondStrongest = INDEX_NONE;
+			int Last = INDEX_NONE;
+			for (int Echo = 0; Echo < ReturnsNum; ++Echo)
+			{
+				const FLidarScanPoint& Point = Points[Echo * BeamsNum + Beam];
+				if (Point.Status == ELidarPointStatus::Invalid)
+				{
+					continue;
+				}
+				Last = Echo;
+				if (Strongest == INDEX_NONE || Point.Intensitie > Points[Strongest * BeamsNum + Beam].Intensitie)
+				{
+					SecondStrongest = Strongest;
+					Strongest = Echo;
+				}
+				else if (SecondStrongest == INDEX_NONE || Point.Intensitie > Points[SecondStrongest * BeamsNum + Beam].Intensitie)
+				{
+					SecondStrongest = Echo;
+				}
+			}
+
+			if (Strongest == INDEX_NONE)
+			{
+				// Keep the beam in the cloud as the invalid point
+				Func(Points[Beam], Beam, 0);
+				continue;
+			}
+
+			switch (Mode)
+			{
+			case ELidarReturnMode::Strongest:
+				Func(Points[Strongest * BeamsNum + Beam], Beam, Strongest);
+				break;
+			case ELidarReturnMode::Last:
+				Func(Points[Last * BeamsNum + Beam], Beam, Last);
+				break;
+			default:
+			{
+				const int Other = (Last != Strongest) ? Last : SecondStrongest;
+				if (Other != INDEX_NONE)
+				{
+					Func(Points[FMath::Min(Strongest, Other) * BeamsNum + Beam], Beam, FMath::Min(Strongest, Other));
+					Func(Points[FMath::Max(Strongest, Other) * BeamsNum + Beam], Beam, FMath::Max(Strongest, Other));
+				}
+				else
+				{
+					Func(Points[Strongest * BeamsNum + Beam], Beam, Strongest);
+				}
+				break;
+			}
+			}
+		}
+	}
 };
 
 } // namespace soda
@@ -75,6 +196,30 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = FOVRenderer, SaveGame, meta = (EditInRuntime, UpdateFOVRendering))
 	FSensorFOVRenderer FOVSetup;
 
+	/** Arbitrary scan pattern. If enabled, it replaces the regular rays grid of the sensor */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ScanPattern, SaveGame, meta = (EditInRuntime, ReactivateComponent, UpdateFOVRendering))
+	FLidarScanPattern ScanPattern;
+
+	/** Apply the rain, snow and fog of the USodaSensorEnvironment to the scan */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weather, SaveGame, meta = (EditInRuntime))
+	bool bWeatherDegradation = true;
+
+	/** [nm] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weather, SaveGame, meta = (EditInRuntime, EditCondition = "bWeatherDegradation"))
+	float LaserWavelength = 905;
+
+	/** Fraction of the beam energy [0..1] below which the echo is detected with the proportionally lower probability */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weather, SaveGame, meta = (EditInRuntime, EditCondition = "bWeatherDegradation"))
+	float DetectionThreshold = 0.05;
+
+	/** [m] Probability of the backscatter false point per beam is 1 - exp(-BackscatterGain * PrecipitationExtinction) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weather, SaveGame, meta = (EditInRuntime, EditCondition = "bWeatherDegradation"))
+	float BackscatterGain = 100;
+
+	/** [cm] Mean range of the backscatter false points */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weather, SaveGame, meta = (EditInRuntime, EditCondition = "bWeatherDegradation"))
+	float BackscatterRange = 500;
+
 public:
 	virtual float GetFOVHorizontMax() const { return 0; } // [deg]
 	virtual float GetFOVHorizontMin() const { return 0; } // [deg]
@@ -90,6 +235,12 @@ public:
 	virtual void DrawLidarPoints(const soda::FLidarSensorData& Scan, bool bDrawInGameThread);
 
 protected:
+	/** Compile ScanPattern to ScanTable if ScanPattern is enabled. Sets the component health and returns false if the compilation failed. */
+	bool CompileScanPattern();
+
+	/** Game thread. Disabled degradation if bWeatherDegradation is false or the weather is clear */
+	soda::FLidarWeatherDegradation MakeWeatherDegradation() const;
+
 	virtual bool GenerateFOVMesh(TArray<FSensorFOVMesh>& Meshes) override;
 	virtual bool NeedRenderSensorFOV() const;
 	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
@@ -97,4 +248,10 @@ protected:
 public:
 	//ULidarRayTraceSensorComponent();
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	virtual void OnDeactivateVehicleComponent() override;
+
+	/** Compiled ScanPattern, shared between all sensors with the same pattern. Null if ScanPattern is disabled. */
+	TSharedPtr<const soda::FLidarScanPatternTable> ScanTable;
 };
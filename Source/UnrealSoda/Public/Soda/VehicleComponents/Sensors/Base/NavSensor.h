@@ -4,7 +4,9 @@
 #include "ComponentReregisterContext.h"
 #include "Soda/VehicleComponents/VehicleSensorComponent.h"
 #include "Soda/Misc/PhysBodyKinematic.h"
-#include <random>
+#include "Soda/Misc/NoiseEngine.h"
+#include "Soda/Misc/NavSignalSynthesizer.h"
+#include "Soda/Misc/PrecisionTimer.hpp"
 #include "NavSensor.generated.h"
 
 
@@ -37,24 +39,23 @@ struct UNREALSODA_API FNoiser
 	float TimeConstant = 400;
 
 	FNoiser()
-		: Generator(std::random_device{}()),
-		Dist(0.f, 1.f) 
 	{};
 
-	/** Initialize inner constants */
-	void Init()
+	/** Initialize inner constants. Key and Channel select the reproducible noise stream, see soda::FNoiseStream */
+	void Init(uint64 Key = 0, uint32 InChannel = 0)
 	{
-		float Mu = 1.f / TimeConstant;
-		F = std::exp(-Mu * DeltaTime);
-		SqrtDeltaTime = std::sqrt(DeltaTime);
-		Z = 0;
+		GM.Init(TimeConstant, DeltaTime, GMBiasStdDev);
+		Stream = soda::FNoiseStream(Key);
+		Channel = InChannel;
+		StepIndex = 0;
 	}
 
 	/** Setep and get accumulative noize */
 	float Step()
 	{
-		Z = F * Z + Dist(Generator) * GMBiasStdDev * SqrtDeltaTime;
-		return ConstBias + StdDev * Dist(Generator) + Z;
+		float N[2];
+		Stream.Gaussian(StepIndex++, Channel, 0, N, 2);
+		return ConstBias + StdDev * N[0] + GM.Step(N[1]);
 	}
 
 	float GetAccuracy() const
@@ -62,12 +63,17 @@ struct UNREALSODA_API FNoiser
 		return ConstBias + StdDev + GMBiasStdDev;
 	}
 
+	/** Save or load the state of the noise process */
+	void SerializeSnapshot(FArchive& Ar)
+	{
+		Ar << GM.Z << StepIndex;
+	}
+
 protected:
-	float Z = 0;
-	float F = 0;
-	float SqrtDeltaTime = 0;
-	std::default_random_engine Generator;
-	std::normal_distribution< float > Dist;
+	soda::FGaussMarkov GM;
+	soda::FNoiseStream Stream;
+	uint32 Channel = 0;
+	uint64 StepIndex = 0;
 };
 
 /**
@@ -99,24 +105,26 @@ struct UNREALSODA_API FNoiserVector
 	float TimeConstant = 400;
 
 	FNoiserVector()
-		: Generator(std::random_device{}()),
-		Dist(0.f, 1.f)
 	{};
 
-	/** Update inner constants */
-	void UpdateParameters()
+	/** Update inner constants. Key and Channel select the reproducible noise stream, see soda::FNoiseStream */
+	void UpdateParameters(uint64 Key = 0, uint32 InChannel = 0)
 	{
-		float Mu = 1.f / TimeConstant;
-		F = std::exp(-Mu * DeltaTime);
-		SqrtDeltaTime = std::sqrt(DeltaTime);
-		Z = FVector(0);
+		for (int i = 0; i < 3; ++i)
+		{
+			GM[i].Init(TimeConstant, DeltaTime, GMBiasStdDev[i]);
+		}
+		Stream = soda::FNoiseStream(Key);
+		Channel = InChannel;
+		StepIndex = 0;
 	}
 
 	/** Setep and get accumulative noize */
 	FVector Step()
 	{
-		Z = F * Z + FVector(Dist(Generator), Dist(Generator), Dist(Generator)) * GMBiasStdDev * SqrtDeltaTime;
-		return ConstBias + StdDev * FVector(Dist(Generator), Dist(Generator), Dist(Generator)) + Z;
+		float N[6];
+		Stream.Gaussian(StepIndex++, Channel, 0, N, 6);
+		return ConstBias + StdDev * FVector(N[0], N[1], N[2]) + FVector(GM[0].Step(N[3]), GM[1].Step(N[4]), GM[2].Step(N[5]));
 	}
 
 	FVector GetAccuracy() const
@@ -124,12 +132,17 @@ struct UNREALSODA_API FNoiserVector
 		return ConstBias + StdDev + GMBiasStdDev;
 	}
 
+	/** Save or load the state of the noise process */
+	void SerializeSnapshot(FArchive& Ar)
+	{
+		Ar << GM[0].Z << GM[1].Z << GM[2].Z << StepIndex;
+	}
+
 protected:
-	FVector Z;
-	float F;
-	float SqrtDeltaTime = 0;
-	std::default_random_engine Generator;
-	std::normal_distribution< float > Dist;
+	soda::FGaussMarkov GM[3];
+	soda::FNoiseStream Stream;
+	uint32 Channel = 0;
+	uint64 StepIndex = 0;
 };
 
 /**
@@ -163,13 +176,22 @@ struct UNREALSODA_API FImuNoiseParams
 	FImuNoiseParams()
 	{}
 
-	void UpdateParameters()
+	void UpdateParameters(uint64 Key = 0)
+	{
+		Location.UpdateParameters(Key, 0);
+		Rotation.UpdateParameters(Key, 1);
+		Acceleration.UpdateParameters(Key, 2);
+		Gyro.UpdateParameters(Key, 3);
+		Velocity.UpdateParameters(Key, 4);
+	}
+
+	void SerializeSnapshot(FArchive& Ar)
 	{
-		Location.UpdateParameters();
-		Rotation.UpdateParameters();
-		Acceleration.UpdateParameters();
-		Gyro.UpdateParameters();
-		Velocity.UpdateParameters();
+		Location.SerializeSnapshot(Ar);
+		Rotation.SerializeSnapshot(Ar);
+		Acceleration.SerializeSnapshot(Ar);
+		Gyro.SerializeSnapshot(Ar);
+		Velocity.SerializeSnapshot(Ar);
 	}
 };
 
@@ -190,6 +212,22 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Noise, SaveGame, meta = (EditInRuntime))
 	FImuNoiseParams NoiseParams;
 
+	/**
+	 * Publish the data on a dedicated timer thread at ImuRate and GnssRate instead of once per the vehicle physics step.
+	 * The vehicle kinematic of the physics substeps is resampled with splines, so the sample times are jitter-free
+	 * and lag behind the physics by one substep.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = HighRate, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	bool bHighRateSynthesis = false;
+
+	/** Rate of PublishSensorData() for bHighRateSynthesis [Hz] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = HighRate, SaveGame, meta = (EditInRuntime, ReactivateComponent, ClampMin = 1, ClampMax = 10000))
+	float ImuRate = 400;
+
+	/** Rate of PublishGnssData() for bHighRateSynthesis [Hz] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = HighRate, SaveGame, meta = (EditInRuntime, ReactivateComponent, ClampMin = 1, ClampMax = 10000))
+	float GnssRate = 10;
+
 public:
 	UFUNCTION(BlueprintCallable, Category = Sensor)
 	void SetImuNoiseParams(const FImuNoiseParams & NewImuNoiseParams);
@@ -202,13 +240,30 @@ public:
 protected:
 	virtual bool PublishSensorData(float DeltaTime, const FSensorDataHeader& Header, const FTransform & RelativeTransform, const FPhysBodyKinematic& VehicleKinematic) { SyncDataset(); return false; }
 
+	/** Called at GnssRate if bHighRateSynthesis is enabled, for the publishers which send GNSS separately from IMU */
+	virtual bool PublishGnssData(float DeltaTime, const FSensorDataHeader& Header, const FTransform& RelativeTransform, const FPhysBodyKinematic& VehicleKinematic) { return false; }
+
+	/** Called from the synthesis timer thread, takes the vehicle PhysicMutex */
+	virtual void TickSynthesis();
+
+	/** Emit all resampled IMU and GNSS samples which are available; the vehicle PhysicMutex is held */
+	virtual void EmitSynthesizedSamples();
+
 protected:
 	virtual bool OnActivateVehicleComponent() override;
 	virtual void OnDeactivateVehicleComponent() override;
 	virtual void PostPhysicSimulationDeferred(float DeltaTime, const FPhysBodyKinematic& VehicleKinematic, const TTimestamp& Timestamp) override;
 
+public:
+	virtual void SerializeSnapshot(FArchive& Ar) override;
+
 protected:
 	FImuNoiseParams StoredParams;
 	bool bIsStoredParams = false;
 	FPhysBodyKinematic StoredBodyKinematic;
+
+	soda::FNavSignalSynthesizer Synthesizer;
+	FPrecisionTimer SynthesisTimer;
+	int64 ImuSampleIndex = 0;
+	int64 GnssSampleIndex = 0;
 };
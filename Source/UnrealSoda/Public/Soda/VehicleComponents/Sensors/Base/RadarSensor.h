@@ -4,6 +4,7 @@
 
 #include "Soda/VehicleComponents/VehicleSensorComponent.h"
 #include "Soda/SodaTypes.h"
+#include "Soda/Misc/SensorWeather.h"
 #include "RadarSensor.generated.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(SodaRadar, Log, All);
@@ -287,6 +288,21 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ObjectRCS, SaveGame, meta = (EditInRuntime, ReactivateComponent))
 	float WallsRCS = 0.05;
 
+	/** Apply the rain, snow and fog of the USodaSensorEnvironment: two-way attenuation of the RCS and the rain clutter */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weather, SaveGame, meta = (EditInRuntime))
+	bool bWeatherDegradation = true;
+
+	/** Mean number of the rain clutter clusters per scan per 1 mm/h of the rain, only in the ClusterMode */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weather, SaveGame, meta = (EditInRuntime, EditCondition = "bWeatherDegradation"))
+	float RainClutterDensity = 0.2;
+
+	/** [m] The rain clutter appears up to this distance */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weather, SaveGame, meta = (EditInRuntime, EditCondition = "bWeatherDegradation"))
+	float RainClutterDistance = 15;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weather, SaveGame, meta = (EditInRuntime, EditCondition = "bWeatherDegradation"))
+	float RainClutterRCS = 0.01;
+
 	/** Master switch on drawing debug primitives */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Debug, SaveGame, meta = (EditInRuntime))
 	bool bDrawDebugPrimitives = false;
@@ -333,10 +349,18 @@ protected:
 	virtual bool PublishSensorData(float DeltaTime, const FSensorDataHeader& Header, const FRadarClusters& InClusters, const FRadarObjects& InObjects) { SyncDataset(); return false; }
 	virtual void ShowDebudPoints();
 
+	/** Add the random near clusters of the rain drops moving with the opposite vehicle velocity */
+	void AddRainClutter(const FRadarParams& Params, int ParamsIndex, uint64 Frame);
+
 private:
 	FRadarClusters Clusters;
 	FRadarObjects Objects;
 
+	/** Captured from the USodaSensorEnvironment every scan */
+	soda::FSensorWeather Weather;
+	float WeatherAttenuation = 0; // Two-way [1/cm] of the RCS
+	soda::FNoiseStream NoiseStream;
+
 	TTimestamp PrevTickTime;
 	TArray<FVector> BatchStart;
 	TArray<FVector> BatchEnd;
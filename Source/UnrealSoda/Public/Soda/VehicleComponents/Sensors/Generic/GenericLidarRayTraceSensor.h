@@ -48,14 +48,14 @@ protected:
 	virtual FString GetRemark() const override;
 
 protected:
-	virtual float GetFOVHorizontMax() const override { return FOV_HorizontMax; }
-	virtual float GetFOVHorizontMin() const override { return FOV_HorizontMin; }
-	virtual float GetFOVVerticalMax() const override { return FOV_VerticalMax; }
-	virtual float GetFOVVerticalMin() const override { return FOV_VerticalMin; }
+	virtual float GetFOVHorizontMax() const override { return ScanTable ? ScanTable->HorizontMax : FOV_HorizontMax; }
+	virtual float GetFOVHorizontMin() const override { return ScanTable ? ScanTable->HorizontMin : FOV_HorizontMin; }
+	virtual float GetFOVVerticalMax() const override { return ScanTable ? ScanTable->VerticalMax : FOV_VerticalMax; }
+	virtual float GetFOVVerticalMin() const override { return ScanTable ? ScanTable->VerticalMin : FOV_VerticalMin; }
 	virtual float GetLidarMinDistance() const override { return DistanceMin; }
 	virtual float GetLidarMaxDistance() const override { return DistanceMax; }
-	virtual TOptional<FUintVector2> GetLidarSize() const { return TOptional<FUintVector2>({ uint32(Step), uint32(Channels) }); }
-	virtual const TArray<FVector>& GetLidarRays() const override { return LidarRays; }
+	virtual TOptional<FUintVector2> GetLidarSize() const { return ScanTable ? ScanTable->Size : TOptional<FUintVector2>({ uint32(Step), uint32(Channels) }); }
+	virtual const TArray<FVector>& GetLidarRays() const override { return ScanTable ? ScanTable->Directions : LidarRays; }
 	virtual bool PublishSensorData(float DeltaTime, const FSensorDataHeader& Header, const soda::FLidarSensorData& Scan) override;
 
 protected:
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Soda/VehicleComponents/Sensors/Base/NavSensor.h"
+#include "Soda/VehicleComponents/Sensors/Implementation/NavMessageEncoder.h"
 #include "Runtime/Sockets/Public/IPAddress.h"
 #include "SocketSubsystem.h"
 #include "Sockets.h"
@@ -59,7 +60,7 @@ public:
 	UPROPERTY(EditAnywhere, Category = Publisher, SaveGame, meta = (EditInRuntime))
 	bool bLogTcpDebugOutput = false;
 
-	/** Watcher mode send period [sec] */
+	/** Watcher mode send period [sec]. With bHighRateSynthesis the SKY and TPV reports are sent at GnssRate instead */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Sensor, SaveGame, meta = (EditInRuntime))
 	float WatcherModePeriod = 0.1f;
 
@@ -79,11 +80,15 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Sensor, SaveGame, meta = (EditInRuntime))
 	bool bWatcherModeIMU = false; 
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Sensor, SaveGame, meta = (EditInRuntime))
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Sensor, SaveGame, meta = (EditInRuntime, ReactivateComponent))
 	FString DeviceName = "Simulator_GPSD";
 
 protected:
 	virtual bool PublishSensorData(float DeltaTime, const FSensorDataHeader& Header, const FTransform& RelativeTransform, const FPhysBodyKinematic& VehicleKinematic) override;
+	virtual bool PublishGnssData(float DeltaTime, const FSensorDataHeader& Header, const FTransform& RelativeTransform, const FPhysBodyKinematic& VehicleKinematic) override;
+
+	/** bGnssReports - send the SKY and TPV reports only, otherwise the ATT and IMU reports (and SKY and TPV without bHighRateSynthesis) */
+	bool PublishReports(const FSensorDataHeader& Header, const FPhysBodyKinematic& VehicleKinematic, bool bGnssReports);
 
 protected:
 	virtual bool OnActivateVehicleComponent() override;
@@ -94,29 +99,20 @@ protected:
 	void Shutdown();
 	bool OnConnected(FSocket* ClientSocket, const FIPv4Endpoint& ClientEndpoint);
 
-	void SendTPV(FGpsDConnection& Connection);
-	void SendATT_IMU(FGpsDConnection& Connection, bool bIsATT);
-	void SendSKY(FGpsDConnection& Connection);
 	void SendVersion(FGpsDConnection& Connection);
 	void SendWatch(FGpsDConnection& Connection);
 	void SendDevices(FGpsDConnection& Connection);
 	bool Send(FGpsDConnection& Connection, const FString& Data);
-	void SPrintfFormatedTime(int64_t Timestamp, char* Buffer);
+	bool Send(FGpsDConnection& Connection, const uint8* Data, int Size);
+
+	/** Called from the EthTaskManager worker, sends one encoded frame to all the watching connections */
+	void FanOut(const TArray<uint8>& Frame);
 
 	FSocket* TcpServerSocket = 0;
 	FTcpListener * TcpListener;
 	TArray<FGpsDConnection> Connections;
-	TTimestamp Timestamp;
-	double Lon = 0;
-	double Lat = 0;
-	double Alt = 0;
-	FTransform WorldPose;
-	FVector WorldVel;
-	FVector LocalAcc;
-	FRotator WorldRot;
-	FVector WorldLoc;
-	FVector Gyro;
-	FPhysBodyKinematic CurVehicleKinematic;
+	soda::FGpsdEncoder Encoder;
+	TSharedPtr<soda::FNavFanOutAsyncTask> FanOutTask;
 	TTimestamp PrevSendTimeMark;
 	std::mutex Mutex;
 };
@@ -0,0 +1,189 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+
+class FRunnableThread;
+class FEvent;
+class IFileHandle;
+
+namespace soda
+{
+
+/**
+ * Status channel 0 of the NCOM packet
+ */
+struct FNCOMChannel0
+{
+	int GPSMinutes = 0;
+	int SatellitesNumber = 0;
+	int PositionMode = 0;
+	int VelocityMode = 0;
+	int OrientationMode = 0;
+
+	friend FArchive& operator<<(FArchive& Ar, FNCOMChannel0& Status)
+	{
+		return Ar << Status.GPSMinutes << Status.SatellitesNumber << Status.PositionMode << Status.VelocityMode << Status.OrientationMode;
+	}
+};
+
+/**
+ * Decoded NCOM packet in the UE axes. Rotation and velocity aren't converted by the LLConverter yet.
+ */
+struct FNCOMSample
+{
+	/** GPS time [ms] of the current GPS minute */
+	int MinuteMs = 0;
+
+	/** [deg] */
+	double Lat = 0;
+
+	/** [deg] */
+	double Lon = 0;
+
+	/** [m] */
+	double Alt = 0;
+
+	/** [deg] */
+	FRotator Rot = FRotator::ZeroRotator;
+
+	/** [cm/s] */
+	FVector Vel = FVector::ZeroVector;
+
+	/** [cm/s^2] */
+	FVector LocalAcc = FVector::ZeroVector;
+
+	/** [rad/s] */
+	FVector AngularVelocity = FVector::ZeroVector;
+
+	int Channel = -1;
+
+	/** Valid if Channel == 0 */
+	FNCOMChannel0 Status;
+};
+
+/** Decode the NCOM packet of the FNCOMLogIndex::PacketSize bytes; returns false if the sync byte is wrong */
+UNREALSODA_API bool DecodeNCOMPacket(const uint8* Data, FNCOMSample& OutSample);
+
+/** Check the sync byte and all three checksums of the packet */
+UNREALSODA_API bool IsValidNCOMPacket(const uint8* Data);
+
+/** Linear interpolation of the sample fields, the rotation is interpolated by SLERP */
+UNREALSODA_API FNCOMSample LerpNCOMSample(const FNCOMSample& A, const FNCOMSample& B, float Alpha);
+
+/**
+ * Time index of the NCOM log file (the raw stream of NCOM packets as it is sent by UDP).
+ * The index is built by one scan of the file: every valid packet gets its offset and the time, unwrapped from the
+ * milliseconds of the GPS minute, so any time is found by the binary search. The packets with the status channel 0
+ * are the keyframes, they restore the GPS minutes and the modes after the seek.
+ * The index is cached next to the log as "<LogFile>.idx" and is rebuilt if the log is changed.
+ */
+class UNREALSODA_API FNCOMLogIndex
+{
+public:
+	static constexpr int PacketSize = 72;
+
+	struct FEntry
+	{
+		int64 Offset = 0;
+
+		/** [s] from the first packet */
+		double Time = 0;
+
+		friend FArchive& operator<<(FArchive& Ar, FEntry& Entry) { return Ar << Entry.Offset << Entry.Time; }
+	};
+
+	struct FKeyframe
+	{
+		int32 Entry = 0;
+		FNCOMChannel0 Status;
+
+		friend FArchive& operator<<(FArchive& Ar, FKeyframe& Keyframe) { return Ar << Keyframe.Entry << Keyframe.Status; }
+	};
+
+	/** Load the cached index or build it and save it to the cache */
+	bool Open(const FString& LogFileName);
+
+	/** Scan the log file, the bytes between the valid packets are skipped */
+	bool Build(const FString& LogFileName);
+
+	void Reset();
+
+	bool IsEmpty() const { return Entries.Num() < 2; }
+	double GetDuration() const { return Entries.Num() ? Entries.Last().Time : 0; }
+	const TArray<FEntry>& GetEntries() const { return Entries; }
+
+	/** Index of the last entry with the time <= Time, clamped to the valid range */
+	int32 FindEntry(double Time) const;
+
+	/** The last keyframe at or before the Entry; null if there is no keyframe before it */
+	const FKeyframe* FindKeyframe(int32 Entry) const;
+
+	/** GPS time [ms] of the first packet; the GPS minutes of the first keyframe are used */
+	int64 GetStartGPSTimeMs() const { return StartGPSTimeMs; }
+
+protected:
+	bool Load(const FString& IndexFileName, int64 LogSize, const FDateTime& LogTimeStamp);
+	bool Save(const FString& IndexFileName, int64 LogSize, const FDateTime& LogTimeStamp);
+
+	TArray<FEntry> Entries;
+	TArray<FKeyframe> Keyframes;
+	int64 StartGPSTimeMs = 0;
+};
+
+/**
+ * Seekable NCOM log player. The packets around the playhead are decoded by the worker thread, ahead of the playhead
+ * and a part of the LookAhead behind it for the backward playback, so Sample() only interpolates between two decoded
+ * packets. Seek to any time is the binary search in the FNCOMLogIndex and the restart of the worker from the new position.
+ */
+class UNREALSODA_API FNCOMLogPlayer : public FRunnable
+{
+public:
+	/** Number of the packets decoded ahead of the playhead (behind it for the backward seek) */
+	FNCOMLogPlayer(int32 InLookAhead = 1024) : LookAhead(FMath::Max(InLookAhead, 16)) {}
+	virtual ~FNCOMLogPlayer();
+
+	bool Open(const FString& LogFileName);
+	void Close();
+	bool IsOpen() const { return Thread != nullptr; }
+
+	const FNCOMLogIndex& GetIndex() const { return Index; }
+
+	/**
+	 * Interpolated sample at the Time [s] from the log start and the status from the preceding keyframe.
+	 * Moves the playhead; returns false if the packets around the Time aren't decoded yet (only right after the seek).
+	 */
+	bool Sample(double Time, FNCOMSample& OutSample, FNCOMChannel0& OutStatus);
+
+	// FRunnable implementation Begin
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	// FRunnable implementation End
+
+protected:
+	/** Decode the entries [First, First + Num) of the log */
+	bool Decode(IFileHandle& File, int32 First, int32 Num, TArray<FNCOMSample>& OutSamples);
+
+	FNCOMLogIndex Index;
+	FString FileName;
+	const int32 LookAhead;
+
+	/** Used by the worker only */
+	TArray<uint8> ReadBuffer;
+
+	FCriticalSection Lock;
+	TArray<FNCOMSample> Decoded;
+	int32 DecodedFirst = 0;
+	int32 Playhead = 0;
+
+	/** Incremented by the seek outside of the decoded window, the worker drops the batch decoded for the old position */
+	uint32 SeekGeneration = 0;
+
+	FRunnableThread* Thread = nullptr;
+	FEvent* WakeUpEvent = nullptr;
+	TAtomic<bool> bStopping{ false };
+};
+
+} // namespace soda
@@ -0,0 +1,178 @@
+// Copyright 2023 SODA.AUTO UK LTD. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Soda/Misc/AsyncTaskManager.h"
+
+namespace soda
+{
+
+/**
+ * Navigation solution shared by all navigation message encoders.
+ * Rotation and velocity are already converted by the LLConverter.
+ */
+struct FNavSolution
+{
+	/** Unix time [ms] */
+	int64 TimestampMs = 0;
+
+	/** GPS time [ms] */
+	int64 GPSTimestampMs = 0;
+
+	/** [deg] */
+	double Lat = 0;
+
+	/** [deg] */
+	double Lon = 0;
+
+	/** [m] */
+	double Alt = 0;
+
+	/** [deg] */
+	FRotator WorldRot = FRotator::ZeroRotator;
+
+	/** [cm/s] */
+	FVector WorldVel = FVector::ZeroVector;
+
+	/** [cm/s^2] */
+	FVector LocalAcc = FVector::ZeroVector;
+
+	/** [rad/s] */
+	FVector Gyro = FVector::ZeroVector;
+};
+
+/**
+ * Allocation-free text writer to a fixed size buffer with fast fixed-point number formatting.
+ * The output is truncated if the buffer is too small, see IsOverflow().
+ */
+class UNREALSODA_API FNavTextWriter
+{
+public:
+	FNavTextWriter(char* InData, int InCapacity) : Data(InData), Capacity(InCapacity) {}
+
+	template <int N>
+	void Literal(const char(&Str)[N]) { Append(Str, N - 1); }
+
+	void Append(const char* Str, int Len);
+	void Append(const TArray<char>& Str) { Append(Str.GetData(), Str.Num()); }
+	void Char(char C) { Append(&C, 1); }
+	void Int(int64 Value);
+
+	/** Write Value with exactly Decimals [0..9] digits after the point */
+	void Fixed(double Value, int Decimals);
+
+	/** Write ISO 8601 UTC time "YYYY-MM-DDThh:mm:ss.sss" */
+	void IsoTime(int64 UnixTimeMs);
+
+	int Num() const { return Size; }
+	bool IsOverflow() const { return bOverflow; }
+
+private:
+	void UInt(uint64 Value, int MinDigits = 1);
+
+	char* Data;
+	int Capacity;
+	int Size = 0;
+	bool bOverflow = false;
+};
+
+/**
+ * Status fields of the NCOM packet which are sent in the rotating status channel
+ */
+struct FNCOMStatus
+{
+	int SatellitesNumber = 10;
+	int PositionMode = 6;
+	int VelocityMode = 6;
+	int OrientationMode = 6;
+	int HeadingQuality = 3;
+	int DifferentialCorrectionsAge = 50;
+
+	/** In the world frame of the FImuNoiseParams: X - east, Y - north, Z - up [m] */
+	FVector PositionAccuracy = FVector::ZeroVector;
+
+	/** In the world frame of the FImuNoiseParams: X - east, Y - north, Z - up [m/s] */
+	FVector VelocityAccuracy = FVector::ZeroVector;
+
+	/** X - Roll, Y - Pitch, Z - Yaw [deg] */
+	FVector OrientationAccuracy = FVector::ZeroVector;
+};
+
+/**
+ * OXTS NCOM packet encoder. Writes the wire format directly with running checksums.
+ * Status channels are rotated through a fixed batch where the channel 0 (GPS time and modes) is interleaved
+ * with every other populated channel.
+ */
+class UNREALSODA_API FNCOMEncoder
+{
+public:
+	static constexpr int PacketSize = 72;
+
+	void Encode(const FNavSolution& Nav, const FNCOMStatus& Status, uint8(&OutPacket)[PacketSize]);
+	void Reset() { BatchIndex = 0; }
+
+private:
+	int BatchIndex = 0;
+};
+
+/**
+ * GPSD JSON encoder. Messages are built from templates preformatted by SetDevice(), all encoded messages
+ * of one frame are collected in one buffer, which is sent as is to every client.
+ */
+class UNREALSODA_API FGpsdEncoder
+{
+public:
+	void SetDevice(const FString& DeviceName);
+
+	void BeginFrame() { Frame.SetNum(0, false); }
+	void AppendTPV(const FNavSolution& Nav);
+	void AppendATT_IMU(const FNavSolution& Nav, bool bIsATT);
+	void AppendSKY() { Frame.Append((const uint8*)SKYMessage.GetData(), SKYMessage.Num()); }
+
+	const TArray<uint8>& GetFrame() const { return Frame; }
+
+private:
+	void AppendMessage(const FNavTextWriter& Writer, const char* Data);
+
+	TArray<char> TPVHeader;
+	TArray<char> ATTHeader;
+	TArray<char> IMUHeader;
+	TArray<char> SKYMessage;
+	TArray<uint8> Frame;
+};
+
+/**
+ * Sends one encoded buffer to all clients from the EthTaskManager worker.
+ * If the previous buffer isn't sent yet, the new one is appended to it, so stream clients never lose messages.
+ */
+class UNREALSODA_API FNavFanOutAsyncTask : public FAsyncTask
+{
+public:
+	/** SendFunction is called from the worker thread for each published buffer */
+	FNavFanOutAsyncTask(TFunction<void(const TArray<uint8>&)> InSendFunction, int InMaxPendingSize = 64 * 1024)
+		: SendFunction(MoveTemp(InSendFunction))
+		, MaxPendingSize(InMaxPendingSize)
+	{}
+
+	virtual FString ToString() const override { return "FNavFanOutAsyncTask"; }
+	virtual bool IsDone() const override { return bIsDone; }
+	virtual bool WasSuccessful() const override { return true; }
+	virtual void Tick() override;
+
+	void Start() { bIsDone = false; }
+	void Finish() { bIsDone = true; }
+
+	/** Returns false if the buffer was dropped because the worker falls behind */
+	bool Publish(const TArray<uint8>& Buf);
+
+private:
+	TFunction<void(const TArray<uint8>&)> SendFunction;
+	int MaxPendingSize;
+	FCriticalSection Lock;
+	TArray<uint8> Front;
+	TArray<uint8> Back;
+	bool bIsDone = true;
+};
+
+} // namespace soda
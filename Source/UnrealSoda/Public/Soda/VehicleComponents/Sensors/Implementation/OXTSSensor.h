@@ -3,8 +3,7 @@
 #pragma once
 
 #include "Soda/VehicleComponents/Sensors/Base/NavSensor.h"
-#include "Soda/VehicleComponents/Sensors/Implementation/OXTS/OXTS.hpp"
-#include "Soda/Misc/BitStream.hpp"
+#include "Soda/VehicleComponents/Sensors/Implementation/NavMessageEncoder.h"
 #include "Soda/Misc/UDPAsyncTask.h"
 #include "Runtime/Sockets/Public/IPAddress.h"
 #include "SocketSubsystem.h"
@@ -47,6 +46,10 @@ public:
 
 protected:
 	virtual bool PublishSensorData(float DeltaTime, const FSensorDataHeader& Header, const FTransform& RelativeTransform, const FPhysBodyKinematic& VehicleKinematic) override;
+	virtual bool PublishGnssData(float DeltaTime, const FSensorDataHeader& Header, const FTransform& RelativeTransform, const FPhysBodyKinematic& VehicleKinematic) override;
+
+	/** bWithFix - fill the position and the velocity too, otherwise only the IMU and the orientation */
+	void MakeNavSolution(const FSensorDataHeader& Header, const FPhysBodyKinematic& VehicleKinematic, bool bWithFix, soda::FNavSolution& Nav);
 
 protected:
 	virtual bool OnActivateVehicleComponent() override;
@@ -57,7 +60,7 @@ protected:
 protected:
 	bool Advertise();
 	void Shutdown();
-	void Publish(const soda::OxtsPacket & Msg, bool bAsync = true);
+	void Publish(const uint8* Packet, int Size, bool bAsync = true);
 	bool IsAdvertised() { return !!Socket; }
 	
 public:
@@ -66,7 +69,17 @@ public:
 private:
 	TSharedPtr< FSocket > Socket;
 	TSharedPtr< FInternetAddr > Addr;
-	int ChanIndex = 0;
 	TSharedPtr <soda::FUDPFrontBackAsyncTask> AsyncTask;
-	FBitStream BitStream;
+	soda::FNCOMEncoder Encoder;
+
+	/** Last GNSS fix of PublishGnssData(), sent by PublishSensorData() with bHighRateSynthesis */
+	struct FGnssFix
+	{
+		double Lon = 0;
+		double Lat = 0;
+		double Alt = 0;
+		FVector WorldVel = FVector::ZeroVector;
+		bool bValid = false;
+	};
+	FGnssFix GnssFix;
 };
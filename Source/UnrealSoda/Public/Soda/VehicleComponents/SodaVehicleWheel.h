@@ -180,4 +180,5 @@ public:
 public:
 	//virtual void OnRegistreVehicleComponent() override;
 	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual void SerializeSnapshot(FArchive& Ar) override;
 };
@@ -4,6 +4,7 @@
 
 #include "Soda/VehicleComponents/VehicleBaseComponent.h"
 #include "Soda/Misc/SerializationHelpers.h"
+#include "Soda/SodaSensorScheduler.h"
 #include "VehicleSensorComponent.generated.h"
 
 struct FDynamicMeshVertex;
@@ -47,6 +48,11 @@ class UNREALSODA_API USensorComponent : public UVehicleBaseComponent
 {
 	GENERATED_UCLASS_BODY()
 
+public:
+	/** Capture timing; if enabled, IsTickOnCurrentFrame() is decided by the USodaSensorScheduler */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Schedule, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FSensorSchedule Schedule;
+
 public:
 	UFUNCTION(BlueprintCallable, Category = Sensor)
 	virtual void HideActorComponentsFromSensorView(AActor* Actor);
@@ -66,6 +72,13 @@ public:
 	virtual UMaterialInterface* GetSensorFOVMaterial() const { return SensorFOVMaterial; }
 	virtual bool NeedRenderSensorFOV() const { return false; }
 
+	virtual bool IsTickOnCurrentFrame() const override;
+	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+
+	/** Any thread. Called by the sensor pipeline if the captured frame is dropped, e.g. the async task is still busy */
+	void NotifyFrameDropped() { ++DroppedFrames; }
+	int64 GetDroppedFrames() const { return DroppedFrames; }
+
 public:
 	virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
 	virtual void GetUsedMaterials(TArray<UMaterialInterface*>& OutMaterials, bool bGetDebugMaterials = false) const override;
@@ -79,4 +92,6 @@ protected:
 protected:
 	UPROPERTY()
 	UMaterialInterface* SensorFOVMaterial;
+
+	TAtomic<int64> DroppedFrames{ 0 };
 };
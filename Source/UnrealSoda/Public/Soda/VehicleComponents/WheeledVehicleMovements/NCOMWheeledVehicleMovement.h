@@ -6,6 +6,7 @@
 #include "Soda/VehicleComponents/WheeledVehicleMovementBaseComponent.h"
 #include "Soda/VehicleComponents/Sensors/Implementation/OXTS/OXTS.hpp"
 #include "Soda/Misc/BitStream.hpp"
+#include "Soda/VehicleComponents/Sensors/Implementation/NCOMLog.h"
 #include "Curves/CurveFloat.h"
 #include "Sockets.h"
 #include "SocketSubsystem.h"
@@ -38,6 +39,21 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NCOM, SaveGame, meta = (EditInRuntime, ReactivateComponent))
 	FRotator NCOMRotation;
 
+	/** NCOM log file to replay instead of the UDP stream. The time index of the log is cached as "<LogPath>.idx" */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NCOMLog, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	FString LogPath;
+
+	/** [s] from the log start */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NCOMLog, SaveGame, meta = (EditInRuntime, ReactivateComponent))
+	float LogStartTime = 0;
+
+	/** Log seconds per simulated second, negative values play the log backward */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NCOMLog, SaveGame, meta = (EditInRuntime))
+	float PlaybackRate = 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = NCOMLog, SaveGame, meta = (EditInRuntime))
+	bool bLoopLog = false;
+
 	/** Vehicle mass in kg */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ModelSetup, SaveGame, meta = (EditInRuntime, ReactivateComponent))
 	float Mass = 1196.0;
@@ -81,13 +97,21 @@ public:
 	UFUNCTION(Category = NCOM, meta = (CallInRuntime))
 	void ResetPosition();
 
+	/** Jump to the Time [s] from the log start */
+	UFUNCTION(BlueprintCallable, Category = NCOMLog)
+	void SeekLog(float Time);
+
+	UFUNCTION(Category = NCOMLog, meta = (CallInRuntime))
+	void RestartLog() { SeekLog(LogStartTime); }
+
+	UFUNCTION(BlueprintCallable, Category = NCOMLog)
+	float GetLogDuration() const;
+
 protected:
 	FVehicleSimData VehicleSimData;
 	FTransform InitTransform;
 	std::mutex Mutex;
 
-	soda::OxtsPacket OXTSPacket;
-	FBitStream BitStream;
 	FSocket* ListenSocket = nullptr;
 	FUdpSocketReceiver* UDPReceiver = nullptr;
 	TTimestamp LastPacketTimestamp;
@@ -96,6 +120,17 @@ protected:
 	bool bIsOXTSDataValid = false;
 	void Recv(const FArrayReaderPtr& ArrayReaderPtr, const FIPv4Endpoint& EndPt);
 
+	/**
+	 * Convert the sample to the world and run the vehicle components; called from the UDP thread or from the log replay.
+	 * bDiscontinuity - the sample doesn't follow the previous one (log seek or loop), nothing is derived between them
+	 */
+	void ApplySample(const soda::FNCOMSample& Sample, double DeltaTime, const TTimestamp& Timestamp, bool bDiscontinuity = false);
+	void TickLog(float DeltaTime);
+
+	TUniquePtr<soda::FNCOMLogPlayer> LogPlayer;
+	double LogTime = 0;
+	bool bLogSeeked = false;
+
 	int OXTS_SatellitesNumber = 0;
 	int OXTS_PositionMode = 0;
 	int OXTS_VelocityMode = 0;
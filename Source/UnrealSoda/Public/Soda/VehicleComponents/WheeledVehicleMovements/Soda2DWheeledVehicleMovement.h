@@ -174,6 +174,7 @@ public:
 public:
 	virtual void UpdateSimulation(const std::chrono::nanoseconds& Deltatime, const std::chrono::nanoseconds& Elapsed);
 	virtual void DrawDebug(UCanvas* Canvas, float& YL, float& YPos) override;
+	virtual void SerializeSnapshot(FArchive& Ar) override;
 
 protected:
 	/* Overrides from  ISodaVehicleComponent  */
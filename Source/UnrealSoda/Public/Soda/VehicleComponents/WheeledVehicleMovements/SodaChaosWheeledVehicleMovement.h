@@ -64,6 +64,16 @@ protected:
 	USodaChaosWheeledVehicleMovementComponent* WheeledVehicleComponent = nullptr;
 
 	FVehicleSimData VehicleSimData;
+
+	/** The timestamps are counted by the physics steps from the USodaSimulationClock time at the Init() */
+	TTimestamp Epoch{};
+	double SimulatedSeconds = 0;
+
+	/** Simulated seconds per wall second of the physics steps, updated every RealTimeFactorWindow [s] */
+	static constexpr double RealTimeFactorWindow = 0.5;
+	float MeasuredRealTimeFactor = 1;
+	double WindowWallSeconds = 0;
+	double WindowSimulatedSeconds = 0;
 };
 
 /**
@@ -6,6 +6,7 @@
 #include "Blueprint/UserWidget.h"
 #include "UObject/WeakInterfacePtr.h"
 #include "Soda/Misc/JsonArchive.h"
+#include "Soda/Misc/BinaryActorArchive.h"
 #include "Soda/Misc/PhysBodyKinematic.h"
 #include "Soda/Misc/SerializationHelpers.h"
 #include "Soda/Misc/Extent.h"
@@ -18,7 +19,11 @@
 
 DECLARE_STATS_GROUP(TEXT("SodaVehicle"), STATGROUP_SodaVehicle, STATGROUP_Advanced);
 
+/** Vehicle is null if the spawn is failed */
+DECLARE_DYNAMIC_DELEGATE_OneParam(FSodaVehicleSpawned, ASodaVehicle*, Vehicle);
+
 class UCANBusComponent;
+class ASodaVehicle;
 
 /**
  * UVehicleWidget is the abstract user widget for ASodaVehicle.
@@ -134,9 +139,26 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Save & Load")
 	static ASodaVehicle * SpawnVehicleFromJsonFile(const UObject* WorldContextObject, const FString& FileName, const FVector& Location, const FRotator & Rotation, bool Posses = true, FName DesireName = NAME_None, bool bApplyOffset = false);
 
+	static ASodaVehicle* SpawnVehicleFromBinaryArchive(UWorld* World, const TSharedPtr<FBinaryActorArchive>& Ar, const FVector& Location, const FRotator& Rotation, bool Posses = true, FName DesireName = NAME_None, bool bApplyOffset = false);
+
+	/** Supports both the FBinaryActorArchive and the legacy USaveGameActor files */
 	UFUNCTION(BlueprintCallable, Category = "Save & Load")
 	static ASodaVehicle * SpawnVehicleFromBinFile(const UObject* WorldContextObject, const FString& FileName, const FVector& Location, const FRotator & Rotation, bool Posses = true, FName DesireName = NAME_None, bool bApplyOffset = false);
 
+	/** The file is read and decoded on the thread pool, the vehicle is spawned on the game thread; OnSpawned gets null if failed */
+	static void SpawnVehicleFromBinFileAsync(const UObject* WorldContextObject, const FString& FileName, const FVector& Location, const FRotator& Rotation, TFunction<void(ASodaVehicle*)> OnSpawned, bool Posses = true, FName DesireName = NAME_None, bool bApplyOffset = false);
+
+	UFUNCTION(BlueprintCallable, Category = "Save & Load", meta = (DisplayName = "Spawn Vehicle From Bin File Async"))
+	static void K2_SpawnVehicleFromBinFileAsync(const UObject* WorldContextObject, const FString& FileName, const FVector& Location, const FRotator& Rotation, FSodaVehicleSpawned OnSpawned, bool Posses = true, FName DesireName = NAME_None, bool bApplyOffset = false);
+
+	/** Convert the vehicle JSON file to the FBinaryActorArchive file; game thread only */
+	UFUNCTION(BlueprintCallable, Category = "Save & Load")
+	static bool ConvertJsonFileToBinFile(const FString& JsonFileName, const FString& BinFileName);
+
+	/** Convert the FBinaryActorArchive file to the vehicle JSON file; game thread only */
+	UFUNCTION(BlueprintCallable, Category = "Save & Load")
+	static bool ConvertBinFileToJsonFile(const FString& BinFileName, const FString& JsonFileName);
+
 	UFUNCTION(BlueprintCallable, Category = "Save & Load")
 	static ASodaVehicle * SpawnVehicleFormSlot(const UObject* WorldContextObject, const FGuid& Slot, const FVector& Location, const FRotator & Rotation, bool Posses = true, FName DesireName = NAME_None, bool bApplyOffset = false);
 
@@ -242,6 +264,7 @@ public:
 
 	virtual void ScenarioBegin() override;
 	virtual void ScenarioEnd() override;
+	virtual void SerializeSnapshot(FArchive& Ar) override;
 
 public:
 	virtual void PreInitializeComponents() override;
@@ -285,6 +308,7 @@ protected:
 	TArray<UCANBusComponent*> CANDevs;
 	TArray<FComponentRecord> ComponentRecords;
 	TSharedPtr<FJsonActorArchive> JsonAr;
+	TSharedPtr<FBinaryActorArchive> BinaryAr;
 	FExtent VehicelExtent;
 
 	FPhysBodyKinematic PhysBodyKinematicCashed;
@@ -239,6 +239,11 @@ struct FVehicleSimData
 	TTimestamp RenderTimestamp{};
 
 	static FVehicleSimData Zero;
+
+	friend FArchive& operator<<(FArchive& Ar, FVehicleSimData& SimData)
+	{
+		return Ar << SimData.VehicleKinematic << SimData.SimulatedStep << SimData.RenderStep << SimData.SimulatedTimestamp << SimData.RenderTimestamp;
+	}
 };
 
 